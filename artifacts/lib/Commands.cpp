@@ -14,10 +14,13 @@
 
 #include "polarphp/global/CompilerFeature.h"
 #include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/parser/SourceTransformer.h"
 #include "polarphp/runtime/ExecEnv.h"
 #include "polarphp/runtime/LifeCycle.h"
 #include "polarphp/runtime/RtDefs.h"
+#include "polarphp/utils/RawOutStream.h"
 
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <map>
@@ -34,6 +37,7 @@ extern bool sg_showModulesInfo;
 extern bool sg_hideExternArgs;
 extern bool sg_showIniCfg;
 extern bool sg_stripCode;
+extern size_t sg_workerRequests;
 extern std::string sg_configPath;
 extern std::string sg_scriptFile;
 extern std::string sg_codeWithoutPhpTags;
@@ -182,6 +186,16 @@ void strip_code_opt_setter(int)
    sg_stripCode = true;
 }
 
+void highlight_code_opt_setter(int)
+{
+   if (sg_behavior == ExecMode::CliDirect || sg_behavior == ExecMode::ProcessStdin) {
+      sg_exitStatus = 1;
+      sg_errorMsg = PARAM_MODE_CONFLICT;
+      throw CLI::ParseError(sg_errorMsg, sg_exitStatus);
+   }
+   sg_behavior = ExecMode::HighLight;
+}
+
 bool reflection_func_opt_setter(CLI::results_t res)
 {
    sg_behavior = ExecMode::ReflectionFunction;
@@ -247,6 +261,7 @@ void setup_init_entries_commands(const std::vector<std::string> defines, std::st
 
 namespace {
 void standard_exec_command(ExecEnv &execEnv, StringRef fileHandle);
+void transform_source_command(ExecMode mode, const std::vector<std::string> &extraFiles);
 } // anonymous namespace
 
 int dispatch_cli_command()
@@ -290,6 +305,10 @@ int dispatch_cli_command()
    case ExecMode::Standard:
       standard_exec_command(execEnv, sg_scriptFile);
       break;
+   case ExecMode::Strip:
+   case ExecMode::HighLight:
+      transform_source_command(sg_behavior, scriptArgv);
+      break;
    default:
       polar_unreachable("can't execute here");
    }
@@ -304,10 +323,58 @@ void standard_exec_command(ExecEnv &execEnv, StringRef filename)
    }
    if (sg_interactive && sg_cliShellCallbacks.cliShellRun) {
       sg_exitStatus = sg_cliShellCallbacks.cliShellRun();
+   } else if (sg_workerRequests > 1 && !filename.empty() && filename != PHP_STDIN_FILENAME_MARK) {
+      /// every run after the first starts from a reset request, the way a
+      /// worker process serves one request after another
+      for (size_t i = 0; i < sg_workerRequests; ++i) {
+         if (i != 0 && !execEnv.restartRequest()) {
+            sg_exitStatus = 1;
+            break;
+         }
+         execEnv.execScript(filename, sg_exitStatus);
+      }
    } else {
       execEnv.execScript(filename, sg_exitStatus);
    }
 }
+
+void set_highlight_color(std::string &color, const char *iniName)
+{
+   char *value = zend_ini_string_ex(const_cast<char *>(iniName), std::strlen(iniName), 0, nullptr);
+   if (value && *value) {
+      color = value;
+   }
+}
+
+/// -w and -s take any number of files, they are lexed in parallel and
+/// written out in the order given, with no file the source is read from stdin
+void transform_source_command(ExecMode mode, const std::vector<std::string> &extraFiles)
+{
+   std::vector<std::string> files;
+   if (!sg_scriptFile.empty()) {
+      files.push_back(sg_scriptFile);
+   }
+   files.insert(files.end(), extraFiles.begin(), extraFiles.end());
+   if (files.empty()) {
+      files.push_back("-");
+   }
+   polar::parser::SourceTransformOptions options;
+   if (mode == ExecMode::Strip) {
+      options.kind = polar::parser::SourceTransformKind::Strip;
+   } else {
+      options.kind = polar::parser::SourceTransformKind::Highlight;
+      set_highlight_color(options.colors.comment, "highlight.comment");
+      set_highlight_color(options.colors.defaultColor, "highlight.default");
+      set_highlight_color(options.colors.html, "highlight.html");
+      set_highlight_color(options.colors.keyword, "highlight.keyword");
+      set_highlight_color(options.colors.string, "highlight.string");
+   }
+   polar::utils::RawOutStream &out = polar::utils::out_stream();
+   if (!polar::parser::transform_source_files(files, out, polar::utils::error_stream(), options)) {
+      sg_exitStatus = 1;
+   }
+   out.flush();
+}
 } // anonymous namespace
 
 std::string PhpOptFormatter::make_usage(const CLI::App *, std::string name) const
@@ -361,8 +428,10 @@ std::vector<std::string> PhpOptFormatter::sm_opsNames{
    "-E",
    "-H",
    "--version",
+   "-s",
    "-w",
    "-z",
+   "--worker",
    "--ini",
    "--rf",
    "--rc",
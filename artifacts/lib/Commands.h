@@ -50,6 +50,7 @@ bool everyline_code_opt_setter(CLI::results_t res);
 bool begin_code_opt_setter(CLI::results_t res);
 bool end_code_opt_setter(CLI::results_t res);
 void strip_code_opt_setter(int count);
+void highlight_code_opt_setter(int count);
 bool reflection_func_opt_setter(CLI::results_t res);
 bool reflection_class_opt_setter(CLI::results_t res);
 bool reflection_extension_opt_setter(CLI::results_t res);
@@ -41,6 +41,7 @@ bool sg_showModulesInfo;
 bool sg_hideExternArgs;
 bool sg_showIniCfg;
 bool sg_stripCode;
+size_t sg_workerRequests = 0;
 std::string sg_configPath{};
 std::string sg_scriptFile{};
 std::string sg_codeWithoutPhpTags{};
@@ -140,6 +141,10 @@ int main(int argc, char *argv[])
       copts |= ZEND_COMPILE_EXTENDED_INFO;
       execEnv.setCompileOptions(copts);
    }
+   /* --worker option */
+   if (sg_workerRequests > 0) {
+      execEnv.setWorkerMode(true);
+   }
    polar::runtime::sg_vmExtensionInitHook = php::stdlib_init_entry;
    if (!execEnv.bootup()) {
       sg_exitStatus = 1;
@@ -183,9 +188,11 @@ void setup_command_opts(CLI::App &parser)
    parser.add_option("-R", CLI::callback_t(polar::everyline_code_opt_setter), "Run PHP <code> for every input line.")->type_name("<code>");
    parser.add_option("-B", CLI::callback_t(polar::begin_code_opt_setter), "Run PHP <begin_code> before processing input lines.")->type_name("<begin_code>");
    parser.add_option("-E", CLI::callback_t(polar::end_code_opt_setter), "Run PHP <end_code> after processing all input lines.")->type_name("<end_code>");
+   parser.add_flag("-s",  polar::highlight_code_opt_setter, "Output HTML syntax highlighted source.");
    parser.add_flag("-w",  polar::strip_code_opt_setter, "Output source with stripped comments and whitespace.");
    parser.add_option("-z", sg_zendExtensionFilenames, "Load Zend extension <file>.")->type_name("<file>");
    parser.add_flag("-H", sg_hideExternArgs, "Hide any passed arguments from external tools.");
+   parser.add_option("--worker", sg_workerRequests, "Run <file> <n> times as separate requests of one worker.")->type_name("<n>");
 
    parser.add_option("--rf", CLI::callback_t(polar::reflection_func_opt_setter), "Show information about function <name>.")->type_name("<name>");
    parser.add_option("--rc", CLI::callback_t(polar::reflection_class_opt_setter), "Show information about class <name>.")->type_name("<name>");
@@ -193,6 +193,7 @@ polar_check_headers(
    stdint.h
    dirent.h
    link.h
+   linux/io_uring.h
    ApplicationServices/ApplicationServices.h
    netinet/in.h
    alloca.h
@@ -434,5 +434,10 @@ macro(polar_check_libzend_other_requires)
    if (NOT HAVE_SIGACTION)
       set(ZEND_SIGNALS OFF)
    endif()
+   if (NOT POLAR_DISABLE_STATIC_TLS_GLOBALS)
+      set(ZEND_STATIC_TLS_GLOBALS ON)
+   else()
+      set(ZEND_STATIC_TLS_GLOBALS OFF)
+   endif()
 endmacro()
 
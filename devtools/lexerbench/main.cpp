@@ -0,0 +1,132 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+//===----------------------------------------------------------------------===//
+// Usage:
+//   lexerbench [--iterations N] [--retain-comments] <file or directory>...
+//     Lex every .php/.phpt/.inc file found and report tokens and bytes per
+//     second, the files are memory mapped once up front so only the lexer
+//     is measured.
+
+#include "CLI/CLI.hpp"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/parser/Lexer.h"
+#include "polarphp/parser/SourceMgr.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/Format.h"
+#include "polarphp/utils/InitPolar.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <chrono>
+
+using polar::basic::StringRef;
+using polar::parser::CommentRetentionMode;
+using polar::parser::Lexer;
+using polar::parser::SourceManager;
+using polar::syntax::Token;
+using polar::syntax::TokenKindType;
+using namespace polar::utils;
+
+namespace {
+
+bool is_php_source(StringRef path)
+{
+   return path.endsWith(".php") || path.endsWith(".phpt") || path.endsWith(".inc");
+}
+
+bool add_source_file(SourceManager &sourceMgr, StringRef path, std::vector<unsigned> &bufferIds)
+{
+   OptionalError<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+   if (std::error_code errorCode = buffer.getError()) {
+      error_stream() << "lexerbench: can not open '" << path << "': "
+                     << errorCode.message() << '\n';
+      return false;
+   }
+   bufferIds.push_back(sourceMgr.addNewSourceBuffer(std::move(buffer.get())));
+   return true;
+}
+
+bool collect_sources(SourceManager &sourceMgr, StringRef path, std::vector<unsigned> &bufferIds)
+{
+   bool isDirectory = false;
+   if (polar::fs::is_directory(path, isDirectory) || !isDirectory) {
+      return add_source_file(sourceMgr, path, bufferIds);
+   }
+   std::error_code errorCode;
+   for (polar::fs::RecursiveDirectoryIterator iter(path, errorCode), end;
+        iter != end && !errorCode; iter.increment(errorCode)) {
+      const std::string &entryPath = iter->getPath();
+      if (is_php_source(entryPath)) {
+         add_source_file(sourceMgr, entryPath, bufferIds);
+      }
+   }
+   return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+   polar::InitPolar polarInitializer(argc, argv);
+   CLI::App cmdParser;
+   polarInitializer.initNgOpts(cmdParser);
+   std::vector<std::string> inputs;
+   unsigned iterations = 5;
+   bool retainComments = false;
+   cmdParser.add_option("inputs", inputs, "<file or directory>")->required(true);
+   cmdParser.add_option("--iterations", iterations, "Number of times every file is lexed")->default_val("5");
+   cmdParser.add_flag("--retain-comments", retainComments, "Return comments as tokens instead of trivia");
+   CLI11_PARSE(cmdParser, argc, argv);
+
+   SourceManager sourceMgr;
+   std::vector<unsigned> bufferIds;
+   for (const std::string &input : inputs) {
+      collect_sources(sourceMgr, input, bufferIds);
+   }
+   if (bufferIds.empty()) {
+      error_stream() << "lexerbench: no php sources found\n";
+      return 1;
+   }
+   CommentRetentionMode commentMode = retainComments ? CommentRetentionMode::ReturnAsTokens
+                                                     : CommentRetentionMode::None;
+   std::uint64_t totalBytes = 0;
+   for (unsigned bufferId : bufferIds) {
+      totalBytes += sourceMgr.getEntireTextForBuffer(bufferId).size();
+   }
+   std::uint64_t tokenCount = 0;
+   std::uint64_t unknownCount = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (unsigned i = 0; i < iterations; ++i) {
+      for (unsigned bufferId : bufferIds) {
+         Lexer lexer(sourceMgr, bufferId, commentMode);
+         Token token;
+         do {
+            lexer.lex(token);
+            ++tokenCount;
+            unknownCount += token.is(TokenKindType::unknown);
+         } while (token.isNot(TokenKindType::eof));
+      }
+   }
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   if (seconds <= 0) {
+      seconds = 1e-9;
+   }
+   out_stream() << "files:       " << bufferIds.size() << '\n'
+                << "bytes:       " << totalBytes << '\n'
+                << "tokens:      " << tokenCount / iterations << '\n'
+                << "unknown:     " << unknownCount / iterations << '\n'
+                << format("time:        %.3f s for %u iterations\n", seconds, iterations)
+                << format("throughput:  %.2f Mtokens/s, %.1f MB/s\n",
+                          tokenCount / seconds / 1e6,
+                          totalBytes * static_cast<double>(iterations) / seconds / 1e6);
+   return 0;
+}
@@ -0,0 +1,115 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+//===----------------------------------------------------------------------===//
+// Usage:
+//   parsebench [-j N] [--short-open-tag] [--print-diagnostics]
+//              [--summary <file>] <file or directory>...
+//     Parse every .php/.phpt/.inc file found with ProjectParser, bind the top
+//     level declarations and report files, declarations and files per second.
+//     With --summary unchanged files are loaded from the module summary of
+//     the previous run, which is rewritten afterwards.
+
+#include "CLI/CLI.hpp"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/parser/ProjectParser.h"
+#include "polarphp/serialization/ModuleSummary.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/Format.h"
+#include "polarphp/utils/InitPolar.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <chrono>
+#include <memory>
+
+using polar::basic::StringRef;
+using polar::parser::ProjectParser;
+using polar::parser::ProjectParserOptions;
+using polar::serialization::ModuleSummaryCache;
+using namespace polar::utils;
+
+namespace {
+
+bool is_php_source(StringRef path)
+{
+   return path.endsWith(".php") || path.endsWith(".phpt") || path.endsWith(".inc");
+}
+
+void collect_sources(ProjectParser &parser, StringRef path)
+{
+   bool isDirectory = false;
+   if (polar::fs::is_directory(path, isDirectory) || !isDirectory) {
+      parser.addFile(path);
+      return;
+   }
+   std::error_code errorCode;
+   for (polar::fs::RecursiveDirectoryIterator iter(path, errorCode), end;
+        iter != end && !errorCode; iter.increment(errorCode)) {
+      const std::string &entryPath = iter->getPath();
+      if (is_php_source(entryPath)) {
+         parser.addFile(entryPath);
+      }
+   }
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+   polar::InitPolar polarInitializer(argc, argv);
+   CLI::App cmdParser;
+   polarInitializer.initNgOpts(cmdParser);
+   std::vector<std::string> inputs;
+   ProjectParserOptions options;
+   bool printDiagnostics = false;
+   std::string summaryPath;
+   cmdParser.add_option("inputs", inputs, "<file or directory>")->required(true);
+   cmdParser.add_option("-j,--threads", options.threadCount, "Number of parser threads, 0 for one per core")->default_val("0");
+   cmdParser.add_flag("--short-open-tag", options.shortOpenTag, "Accept <? as an open tag");
+   cmdParser.add_flag("--print-diagnostics", printDiagnostics, "Print the parse and redeclaration diagnostics");
+   cmdParser.add_option("--summary", summaryPath, "Module summary to load unchanged files from and to update");
+   CLI11_PARSE(cmdParser, argc, argv);
+
+   std::unique_ptr<ModuleSummaryCache> summary;
+   if (!summaryPath.empty()) {
+      summary.reset(new ModuleSummaryCache(summaryPath));
+      options.cache = summary.get();
+   }
+   ProjectParser parser(options);
+   for (const std::string &input : inputs) {
+      collect_sources(parser, input);
+   }
+   if (parser.getNumFiles() == 0) {
+      error_stream() << "parsebench: no php sources found\n";
+      return 1;
+   }
+   auto start = std::chrono::steady_clock::now();
+   bool allRead = parser.parseAll();
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   if (seconds <= 0) {
+      seconds = 1e-9;
+   }
+   if (summary) {
+      if (Error error = summary->save()) {
+         log_all_unhandled_errors(std::move(error), error_stream(), "parsebench: can not write summary: ");
+      }
+   }
+   if (printDiagnostics) {
+      parser.printDiagnostics(error_stream());
+   }
+   out_stream() << "files:        " << parser.getNumFiles() << '\n'
+                << "declarations: " << parser.getIndex().getDecls().size() << '\n'
+                << "errors:       " << parser.getNumErrors() << '\n'
+                << "from summary: " << parser.getNumCachedFiles() << '\n'
+                << format("time:         %.3f s\n", seconds)
+                << format("throughput:   %.1f files/s\n", parser.getNumFiles() / seconds);
+   return allRead ? 0 : 1;
+}
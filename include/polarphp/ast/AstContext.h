@@ -30,6 +30,7 @@
 
 #include "polarphp/global/DataTypes.h"
 #include "polarphp/ast/Identifier.h"
+#include "polarphp/ast/IdentifierTable.h"
 #include "polarphp/ast/Type.h"
 #include "polarphp/ast/TypeAlignments.h"
 #include "polarphp/basic/SearchPathOptions.h"
@@ -177,7 +178,33 @@ private:
    BumpPtrAllocator &
    getAllocator(AllocationArena arena = AllocationArena::Permanent) const;
 
+   /// The uniqued identifiers, kept apart from the permanent arena so the
+   /// strings of a context stay packed together.
+   mutable IdentifierTable m_identifierTable;
+
 public:
+   /// Return the uniqued and AstContext-owned version of the specified string.
+   Identifier getIdentifier(StringRef str) const
+   {
+      // Make sure null pointers stay null.
+      if (str.data() == nullptr) {
+         return Identifier();
+      }
+      return m_identifierTable.get(str);
+   }
+
+   /// Return the lowercased identifier any spelling of \p str was uniqued
+   /// as, PHP function, class and namespace names are case-insensitive.
+   Identifier lookupIdentifierCaseInsensitive(StringRef str) const
+   {
+      return m_identifierTable.lookupCaseInsensitive(str);
+   }
+
+   IdentifierTable &getIdentifierTable() const
+   {
+      return m_identifierTable;
+   }
+
    /// allocate - allocate memory from the AstContext bump pointer.
    void *allocate(unsigned long bytes, unsigned alignment,
                   AllocationArena arena = AllocationArena::Permanent) const
@@ -100,6 +100,10 @@ struct DiagnosticInfo
    ArrayRef<CharSourceRange> ranges;
    /// Extra source ranges that are attached to the diagnostic.
    ArrayRef<FixIt> fixIts;
+   /// The message already formatted from the format string and arguments,
+   /// set for diagnostics the engine renders ahead of delivery, empty
+   /// otherwise.
+   StringRef formattedText;
 };
 
 /// Abstract interface for classes that present diagnostics to the user.
@@ -31,6 +31,7 @@
 #include "polarphp/ast/DiagnosticConsumer.h"
 #include "polarphp/utils/VersionTuple.h"
 #include "polarphp/basic/adt/DenseMap.h"
+#include "polarphp/utils/Allocator.h"
 #include "polarphp/ast/Identifier.h"
 #include "polarphp/ast/Attr.h"
 #include "polarphp/ast/Type.h"
@@ -52,6 +53,7 @@ using polar::parser::SourceManager;
 using polar::parser::SourceRange;
 using polar::utils::VersionTuple;
 using polar::utils::RawOutStream;
+using polar::utils::BumpPtrAllocator;
 
 enum class StaticSpellingKind : uint8_t;
 enum class DescriptiveDeclKind : uint8_t;
@@ -857,6 +859,36 @@ public:
       return diagnose(decl, Diagnostic(id, std::move(args)...));
    }
 
+   /// Keep diagnostics in the engine instead of handing each one to the
+   /// consumers as it is emitted. Ignored diagnostics and diagnostics
+   /// emitted while no consumer is attached are dropped on the spot, the
+   /// rest are stored compactly, deduplicated, and only rendered by
+   /// flushDiagnostics() or finishProcessing(). Turning batching off
+   /// flushes what is stored.
+   void setBatchDiagnostics(bool val = true);
+
+   bool getBatchDiagnostics() const
+   {
+      return m_batchDiagnostics;
+   }
+
+   /// Render the stored diagnostics, in parallel when there are many of
+   /// them, and send them to the consumers in the order they were emitted.
+   void flushDiagnostics();
+
+   /// The number of diagnostics waiting for flushDiagnostics().
+   unsigned getNumStoredDiagnostics() const
+   {
+      return m_storedDiagnostics.size();
+   }
+
+   /// The number of diagnostics (notes included) dropped because the same
+   /// diagnostic was already stored.
+   unsigned getNumDuplicateDiagnostics() const
+   {
+      return m_numDuplicateDiagnostics;
+   }
+
    /// \returns true if diagnostic is marked with PointsToFirstBadToken
    /// option.
    bool isDiagnosticPointsToFirstBadToken(DiagID id) const;
@@ -892,6 +924,25 @@ private:
    /// delete them.
    void emitTentativeDiagnostics();
 
+   /// Copy \c diag into the batch unless the same diagnostic is there
+   /// already.
+   void storeDiagnostic(const Diagnostic &diag, SourceLoc loc, DiagnosticKind kind);
+
+   /// A diagnostic waiting in the batch. Its arguments and ranges live in
+   /// m_batchArena, string arguments included, so nothing the emitter
+   /// passed in has to outlive the diagnostic call.
+   struct StoredDiagnostic
+   {
+      DiagID id;
+      DiagnosticKind kind;
+      SourceLoc loc;
+      ArrayRef<DiagnosticArgument> args;
+      ArrayRef<CharSourceRange> ranges;
+      /// the fix-its are m_storedFixIts[firstFixIt, firstFixIt + numFixIts)
+      unsigned firstFixIt;
+      unsigned numFixIts;
+   };
+
 private:
    /// The source manager used to interpret source locations and
    /// display diagnostics.
@@ -919,6 +970,28 @@ private:
    /// emitted once all transactions have closed.
    unsigned m_transactionCount = 0;
 
+   /// Whether diagnostics are stored until flushDiagnostics().
+   bool m_batchDiagnostics = false;
+
+   /// Whether the notes that follow are attached to a diagnostic that was
+   /// dropped as a duplicate.
+   bool m_dropAttachedNotes = false;
+
+   unsigned m_numDuplicateDiagnostics = 0;
+
+   /// Holds the arguments and ranges of the stored diagnostics, released
+   /// as a whole on every flush.
+   BumpPtrAllocator m_batchArena;
+
+   std::vector<StoredDiagnostic> m_storedDiagnostics;
+
+   /// Fix-its own their text, so they are kept out of the arena.
+   std::vector<DiagnosticInfo::FixIt> m_storedFixIts;
+
+   /// Stored errors, warnings and remarks by the hash of their id,
+   /// location and arguments.
+   DenseMap<uint64_t, unsigned> m_storedDiagnosticsByHash;
+
    friend class InFlightDiagnostic;
    friend class DiagnosticTransaction;
 };
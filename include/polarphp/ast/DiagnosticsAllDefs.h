@@ -0,0 +1,49 @@
+//===--- DiagnosticsAll.def - Diagnostics Text Index ------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2017 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file imports all the other diagnostic files.
+//
+//===----------------------------------------------------------------------===//
+
+#if !(defined(DIAG) || (defined(ERROR) && defined(WARNING) && defined(NOTE) && defined(REMARK)))
+#  error Must define either DIAG or the set {ERROR,WARNING,NOTE,REMARK}
+#endif
+
+#define DIAG_NO_UNDEF
+
+#include "DiagnosticsCommonDefs.h"
+#include "DiagnosticsParseDefs.h"
+#include "DiagnosticsFrontendDefs.h"
+#include "DiagnosticsDriverDefs.h"
+
+#undef DIAG_NO_UNDEF
+
+#if defined(DIAG)
+# undef DIAG
+#endif
+#undef NOTE
+#undef WARNING
+#undef ERROR
+#undef REMARK
@@ -36,7 +36,7 @@
 namespace polar::ast::diag {
 // Declare common diagnostics objects with their appropriate types.
 #define DIAG(KIND, ID, Options, Text, Signature) \
-   extern detail::DiagWithArguments<void Signature>::type ID;
+   extern internal::DiagWithArguments<void Signature>::type ID;
 #include "DiagnosticsDriverDefs.h"
 } // polar::ast::diag
 
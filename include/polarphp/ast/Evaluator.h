@@ -0,0 +1,474 @@
+//===--- Evaluator.h - Request Evaluator ------------------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2018 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//===----------------------------------------------------------------------===//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the Evaluator class that evaluates and caches
+//  requests.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef POLAR_AST_EVALUATOR_H
+#define POLAR_AST_EVALUATOR_H
+
+#include "polarphp/ast/AnyRequest.h"
+#include "polarphp/basic/AnyValue.h"
+#include "polarphp/basic/CycleDiagnosticKind.h"
+#include "polarphp/basic/Defer.h"
+#include "polarphp/basic/LangStatistic.h"
+#include "polarphp/basic/TypeId.h"
+#include "polarphp/basic/adt/DenseMap.h"
+#include "polarphp/basic/adt/DenseSet.h"
+#include "polarphp/basic/adt/SetVector.h"
+#include "polarphp/basic/adt/SmallVector.h"
+#include "polarphp/utils/Error.h"
+#include <string>
+#include <vector>
+
+namespace polar::ast {
+
+using polar::basic::AnyValue;
+using polar::basic::ArrayRef;
+using polar::basic::CycleDiagnosticKind;
+using polar::basic::DenseMap;
+using polar::basic::DenseSet;
+using polar::basic::SetVector;
+using polar::basic::SmallVector;
+using polar::basic::SmallVectorImpl;
+using polar::basic::StringRef;
+using polar::basic::TypeId;
+using polar::basic::UnifiedStatsReporter;
+using polar::basic::FrontendStatsTracer;
+using polar::utils::Expected;
+using polar::utils::ErrorInfo;
+
+class DiagnosticEngine;
+class Evaluator;
+class SourceFile;
+
+template <typename Request>
+class CyclicalRequestError;
+
+/// Report that a request of the given kind is being evaluated, so it
+/// can be recorded by the stats reporter. Request kinds listed in a type
+/// id zone specialize this next to their definition to bump their own
+/// counter.
+template<typename Request>
+void report_evaluated_request(UnifiedStatsReporter &stats,
+                              const Request &request)
+{}
+
+/// Trace the evaluation of a request under the name of its kind, which
+/// gives every kind a timer of its own. SimpleRequest provides a better
+/// match that traces the request's inputs as well.
+template<typename Request>
+FrontendStatsTracer make_tracer(UnifiedStatsReporter *reporter,
+                                const Request &request)
+{
+   return FrontendStatsTracer(reporter, TypeId<Request>::getName());
+}
+
+/// Evaluation engine that evaluates and caches "requests", checking for cyclic
+/// dependencies along the way.
+///
+/// Each request is a function object that accepts a reference to the evaluator
+/// itself (through which it can request other values) and produces a
+/// value. That value can then be cached by the evaluator for subsequent access,
+/// using a policy dictated by the request itself.
+///
+/// The evaluator keeps track of all in-flight requests so that it can detect
+/// and diagnose cyclic dependencies.
+///
+/// Every request evaluated while another one is active is recorded as a
+/// dependency of the active request, the reverse edges are kept as well so
+/// that a change can be propagated to everything that was computed from it.
+/// Requests that read a source file directly (name lookup into the file's
+/// top level declarations, for example) say so with
+/// \c noteSourceFileDependency(), after an edit of that file
+/// \c invalidateSourceFile() drops exactly the cached results that were
+/// derived from it, whatever else is in the cache stays valid.
+///
+/// Each request should be its own function object, supporting the following
+/// API:
+///
+///   - Copy constructor
+///   - Equality operator (==)
+///   - Hashing support (hash_value)
+///   - TypeId support (see polarphp/basic/TypeId.h)
+///   - The output type (described via a nested type OutputType), which
+///     must itself by a value type that supports TypeId.
+///   - Evaluation via the static function evaluateRequest:
+///
+///       static Expected<OutputType> evaluateRequest(const Request &,
+///                                                   Evaluator &evaluator);
+///
+///   - Cycle breaking and diagnostics operations:
+///
+///       void diagnoseCycle(DiagnosticEngine &diags) const;
+///       void noteCycleStep(DiagnosticEngine &diags) const;
+///   - Caching policy:
+///
+///     static const bool isEverCached;
+///
+///       When false, the request's result will never be cached. When true,
+///       the result will be cached on completion. How it is cached depends on
+///       the following.
+///
+///     bool isCached() const;
+///
+///       Dynamically indicates whether to cache this particular instance of the
+///       request, so that (for example) requests for which a quick check
+///       usually suffices can avoid caching a trivial result.
+///
+///     static const bool hasExternalCache;
+///
+///       When false, the results will be cached within the evaluator and
+///       cannot be accessed except through the evaluator. This is the
+///       best approach, because it ensures that all accesses to the result
+///       are tracked.
+///
+///       When true, the request itself must provide an way to cache the
+///       results, e.g., in some external data structure. External caching
+///       should only be used when staging in the use of the evaluator into
+///       existing mutable data structures; new computations should not depend
+///       on it. Externally-cached requests must provide additional API:
+///
+///         Optional<OutputType> getCachedResult() const;
+///
+///           Retrieve the cached result, or \c None if there is no such
+///           result.
+///
+///         void cacheResult(OutputType value) const;
+///
+///            Cache the given result.
+///
+///       Invalidation cannot reach into an external cache, requests that
+///       depend on a source file should therefore be cached by the evaluator.
+class Evaluator
+{
+   /// The diagnostics engine through which any cyclic-dependency
+   /// diagnostics will be emitted.
+   DiagnosticEngine &m_diags;
+
+   /// Whether to diagnose cycles or ignore them completely.
+   CycleDiagnosticKind m_shouldDiagnoseCycles;
+
+   /// Used to report statistics about which requests were evaluated, if
+   /// non-null.
+   UnifiedStatsReporter *m_stats = nullptr;
+
+   /// A vector containing all of the active evaluation requests, which
+   /// is treated as a stack and is used to detect cycles.
+   SetVector<AnyRequest> m_activeRequests;
+
+   /// A cache that stores the results of requests.
+   DenseMap<AnyRequest, AnyValue> m_cache;
+
+   /// Track the dependencies of each request.
+   ///
+   /// This is an adjacency-list representation expressing, for each known
+   /// request, the requests that it directly depends on. It is populated
+   /// lazily while evaluating requests.
+   DenseMap<AnyRequest, std::vector<AnyRequest>> m_dependencies;
+
+   /// The reverse of \c m_dependencies: for each request, the requests
+   /// whose evaluation asked for it.
+   DenseMap<AnyRequest, std::vector<AnyRequest>> m_dependents;
+
+   /// For each source file, the requests that read it directly. SourceFile
+   /// is only forward declared here, so the key is the opaque pointer.
+   DenseMap<const void *, std::vector<AnyRequest>> m_fileDependents;
+
+   template<typename Request>
+   friend class CyclicalRequestError;
+
+   /// Produce the result of the request without caching.
+   template<typename Request>
+   Expected<typename Request::OutputType>
+   getResultUncached(const Request &request)
+   {
+      // Clear out the dependencies on this request; we're going to recompute
+      // them now anyway.
+      clearDependencies(AnyRequest(request));
+
+      FrontendStatsTracer statsTracer = make_tracer(m_stats, request);
+      if (m_stats) {
+         ++m_stats->getFrontendCounters().NumEvaluatorRequests;
+         report_evaluated_request(*m_stats, request);
+      }
+      return Request::evaluateRequest(request, *this);
+   }
+
+   /// Get the result of a request, consulting an external cache
+   /// provided by the request to retrieve previously-computed results
+   /// and detect recursion.
+   template<typename Request,
+            typename std::enable_if<Request::hasExternalCache>::type * = nullptr>
+   Expected<typename Request::OutputType>
+   getResult(const Request &request)
+   {
+      // If there is a cached result, return it.
+      if (auto cached = request.getCachedResult()) {
+         return *cached;
+      }
+      // Compute the result.
+      auto result = getResultUncached(request);
+      // Cache the result if applicable.
+      if (!result) {
+         return result;
+      }
+      request.cacheResult(*result);
+      // Return it.
+      return result;
+   }
+
+   /// Get the result of a request, consulting the general cache to
+   /// retrieve previously-computed results and detect recursion.
+   template<
+         typename Request,
+         typename std::enable_if<Request::isEverCached>::type * = nullptr,
+         typename std::enable_if<!Request::hasExternalCache>::type * = nullptr>
+   Expected<typename Request::OutputType>
+   getResult(const Request &request)
+   {
+      // If we shouldn't cache this request just yet, evaluate it directly.
+      if (!request.isCached()) {
+         return getResultUncached(request);
+      }
+      // If we have a cached result, return it.
+      auto known = m_cache.find(AnyRequest(request));
+      if (known != m_cache.end()) {
+         if (m_stats) {
+            ++m_stats->getFrontendCounters().NumEvaluatorCacheHits;
+         }
+         return known->second.template castTo<typename Request::OutputType>();
+      }
+      // Compute the result.
+      auto result = getResultUncached(request);
+      // Cache the result if applicable.
+      if (!result) {
+         return result;
+      }
+      m_cache.insert({AnyRequest(request), *result});
+      return result;
+   }
+
+   /// Get the result of a request, evaluating it directly.
+   template<typename Request,
+            typename std::enable_if<!Request::isEverCached>::type * = nullptr>
+   Expected<typename Request::OutputType>
+   getResult(const Request &request)
+   {
+      return getResultUncached(request);
+   }
+
+   /// Check the dependency from the current top of the stack to
+   /// the given request, including cycle detection and diagnostics.
+   ///
+   /// \returns true if a cycle was detected, in which case this function has
+   /// already diagnosed the cycle. Otherwise, returns \c false and adds this
+   /// request to the \c activeRequests stack.
+   bool checkDependency(const AnyRequest &request);
+
+   /// Diagnose a cycle detected in the evaluation of the given
+   /// request.
+   void diagnoseCycle(const AnyRequest &request);
+
+   /// Forget the requests the given request asked for, the next
+   /// evaluation records them again.
+   void clearDependencies(const AnyRequest &request);
+
+   /// Drop the cached result of every request in \p worklist and of
+   /// everything computed from them.
+   void invalidateTransitively(SmallVectorImpl<AnyRequest> &worklist);
+
+   /// Print the dependencies of the given request as a tree.
+   void printDependencies(const AnyRequest &request,
+                          RawOutStream &out,
+                          DenseSet<AnyRequest> &visitedAnywhere,
+                          SmallVectorImpl<AnyRequest> &visitedAlongPath,
+                          ArrayRef<AnyRequest> highlightPath,
+                          std::string &prefixStr,
+                          bool lastChild) const;
+
+public:
+   /// Construct a new evaluator that can emit cyclic-dependency
+   /// diagnostics through the given diagnostics engine.
+   Evaluator(DiagnosticEngine &diags, CycleDiagnosticKind shouldDiagnoseCycles);
+
+   /// Emit GraphViz output visualizing the request graph.
+   void emitRequestEvaluatorGraphViz(StringRef graphVizPath);
+
+   /// Set the unified stats reporter through which evaluated-request
+   /// statistics will be recorded.
+   void setStatsReporter(UnifiedStatsReporter *stats)
+   {
+      m_stats = stats;
+   }
+
+   /// Evaluate the given request and produce its result,
+   /// consulting/populating the cache as required.
+   template<typename Request>
+   Expected<typename Request::OutputType>
+   operator()(const Request &request)
+   {
+      // Check for a cycle.
+      if (checkDependency(AnyRequest(request))) {
+         return polar::utils::Error(
+                  std::make_unique<CyclicalRequestError<Request>>(request, *this));
+      }
+      // Make sure we remove this from the set of active requests once we're
+      // done.
+      POLAR_DEFER {
+         assert(m_activeRequests.back().castTo<Request>() == request);
+         m_activeRequests.pop_back();
+      };
+      // Get the result.
+      return getResult(request);
+   }
+
+   /// Evaluate a set of requests and return their results as a tuple.
+   ///
+   /// Use this to describe cases where there are multiple (known)
+   /// requests that all need to be satisfied.
+   template<typename ...Requests>
+   std::tuple<Expected<typename Requests::OutputType>...>
+   operator()(const Requests &...requests)
+   {
+      return std::tuple<Expected<typename Requests::OutputType>...>(
+               (*this)(requests)...);
+   }
+
+   /// Record that the request being evaluated read the contents of
+   /// \p file, it is invalidated when the file changes. Does nothing when
+   /// no request is active.
+   void noteSourceFileDependency(const SourceFile *file);
+
+   /// Drop the cached result of \p request and of every request that was
+   /// computed from it.
+   template<typename Request>
+   void invalidate(const Request &request)
+   {
+      SmallVector<AnyRequest, 8> worklist;
+      worklist.push_back(AnyRequest(request));
+      invalidateTransitively(worklist);
+   }
+
+   /// Drop the cached results derived from the contents of \p file,
+   /// everything else stays cached.
+   ///
+   /// \returns the number of cached results that were dropped.
+   unsigned invalidateSourceFile(const SourceFile *file);
+
+   /// Clear the cache stored within this evaluator.
+   ///
+   /// Note that this does not clear the caches of requests that use external
+   /// caching.
+   void clearCache()
+   {
+      m_cache.clear();
+      m_dependencies.clear();
+      m_dependents.clear();
+      m_fileDependents.clear();
+   }
+
+   /// Is the given request, or an equivalent, currently being evaluated?
+   template <typename Request>
+   bool hasActiveRequest(const Request &request) const
+   {
+      return m_activeRequests.count(AnyRequest(request));
+   }
+
+   /// Is the result of the given request in the evaluator's own cache?
+   template <typename Request>
+   bool hasCachedResult(const Request &request) const
+   {
+      return m_cache.count(AnyRequest(request));
+   }
+
+   /// Dump the dependencies of the given request to the debugging stream
+   /// as a tree.
+   void dumpDependencies(const AnyRequest &request) const;
+
+   /// Print all dependencies known to the evaluator as a single Graphviz
+   /// directed graph.
+   void printDependenciesGraphviz(RawOutStream &out) const;
+
+   void dumpDependenciesGraphviz() const;
+};
+
+/// Error type used when a request would be evaluated while it is already
+/// active, i.e. the requests depend on each other.
+template <typename Request>
+class CyclicalRequestError :
+      public ErrorInfo<CyclicalRequestError<Request>>
+{
+public:
+   static char sm_id;
+   /// a copy, the error usually outlives the request it was created for
+   const Request request;
+   const Evaluator &evaluator;
+
+   CyclicalRequestError(const Request &request, const Evaluator &evaluator)
+      : request(request),
+        evaluator(evaluator)
+   {}
+
+   virtual void log(RawOutStream &out) const override;
+
+   virtual std::error_code convertToErrorCode() const override
+   {
+      // This is essentially unused, but is a temporary requirement for
+      // ErrorInfo subclasses.
+      return std::error_code();
+   }
+};
+
+template <typename Request>
+char CyclicalRequestError<Request>::sm_id = '\0';
+
+template <typename Request>
+void CyclicalRequestError<Request>::log(RawOutStream &out) const
+{
+   out << "Cycle detected:\n";
+   simple_display(out, request);
+   out << "\n";
+}
+
+/// Evaluates a given request or returns a default value if a cycle is detected.
+template <typename Request>
+typename Request::OutputType
+evaluate_or_default(
+      Evaluator &eval, Request req, typename Request::OutputType def)
+{
+   auto result = eval(req);
+   if (auto err = result.takeError()) {
+      polar::utils::handle_all_errors(std::move(err),
+                                      [](const CyclicalRequestError<Request> &E) {
+         // cycle detected
+      });
+      return def;
+   }
+   return *result;
+}
+
+} // polar::ast
+
+#endif // POLAR_AST_EVALUATOR_H
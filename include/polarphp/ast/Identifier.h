@@ -69,43 +69,80 @@ enum class DeclRefKind
    PrefixOperator
 };
 
+/// The uniqued storage behind an Identifier, owned by an IdentifierTable.
+struct IdentifierEntry
+{
+   /// nul terminated, either in the table's arena or in storage the host
+   /// handed out through IdentifierTable::ExternalInterner
+   const char *text;
+   uint32_t length;
+   /// hash of the lowercased spelling, computed the way the engine hashes
+   /// a zend_string so it can be used as a known hash for symbol tables
+   uint64_t foldedHash;
+   /// entry of the lowercased spelling, itself for a lowercase identifier
+   const IdentifierEntry *folded;
+};
+
 /// Identifier - This is an instance of a uniqued identifier created by
-/// AstContext.  It just wraps a nul-terminated "const char*".
+/// AstContext.  It wraps the table entry holding a nul-terminated text,
+/// its length and its case-insensitive hash.
 class Identifier
 {
    friend class AstContext;
    friend class DeclBaseName;
+   friend class IdentifierTable;
 
-   const char *m_pointer;
+   const IdentifierEntry *m_entry;
 
-   /// Constructor, only accessible by AstContext, which handles the uniquing.
-   explicit Identifier(const char *ptr)
-      : m_pointer(ptr)
+   /// Constructor, only accessible by AstContext and IdentifierTable, which
+   /// handle the uniquing.
+   explicit Identifier(const IdentifierEntry *entry)
+      : m_entry(entry)
    {}
 public:
    explicit Identifier()
-      : m_pointer(nullptr)
+      : m_entry(nullptr)
    {}
 
    const char *get() const
    {
-      return m_pointer;
+      return m_entry ? m_entry->text : nullptr;
    }
 
    StringRef str() const
    {
-      return m_pointer;
+      return m_entry ? StringRef(m_entry->text, m_entry->length) : StringRef();
    }
 
    unsigned getLength() const
    {
-      assert(m_pointer != nullptr && "Tried getting length of empty identifier");
-      return ::strlen(m_pointer);
+      assert(m_entry != nullptr && "Tried getting length of empty identifier");
+      return m_entry->length;
    }
 
    bool empty() const
    {
-      return m_pointer == nullptr;
+      return m_entry == nullptr;
+   }
+
+   /// the identifier spelled in lowercase, which every spelling of a case
+   /// insensitive PHP name (functions, classes, namespaces) maps to
+   Identifier getFolded() const
+   {
+      return m_entry ? Identifier(m_entry->folded) : Identifier();
+   }
+
+   uint64_t getFoldedHash() const
+   {
+      assert(m_entry != nullptr && "Tried getting hash of empty identifier");
+      return m_entry->foldedHash;
+   }
+
+   /// compares like PHP compares function and class names, a pointer
+   /// comparison of the lowercased entries
+   bool equalsCaseInsensitive(Identifier other) const
+   {
+      return getFolded() == other.getFolded();
    }
 
    bool is(StringRef string) const
@@ -124,8 +161,8 @@ public:
       if (isEditorPlaceholder()) {
          return false;
       }
-      if ((unsigned char)m_pointer[0] < 0x80) {
-         return isOperatorStartCodePoint((unsigned char)m_pointer[0]);
+      if ((unsigned char)m_entry->text[0] < 0x80) {
+         return isOperatorStartCodePoint((unsigned char)m_entry->text[0]);
       }
 
       // Handle the high unicode case out of line.
@@ -183,12 +220,12 @@ public:
 
    const void *getAsOpaquePointer() const
    {
-      return static_cast<const void *>(m_pointer);
+      return static_cast<const void *>(m_entry);
    }
 
    static Identifier getFromOpaquePointer(void *ptr)
    {
-      return Identifier((const char*)ptr);
+      return Identifier((const IdentifierEntry *)ptr);
    }
 
    /// Compare two identifiers, producing -1 if \c *this comes before \c other,
@@ -199,7 +236,7 @@ public:
 
    bool operator==(Identifier other) const
    {
-      return m_pointer == other.m_pointer;
+      return m_entry == other.m_entry;
    }
 
    bool operator!=(Identifier other) const
@@ -209,18 +246,18 @@ public:
 
    bool operator<(Identifier other) const
    {
-      return m_pointer < other.m_pointer;
+      return m_entry < other.m_entry;
    }
 
    static Identifier getEmptyKey()
    {
-      return Identifier((const char*)
+      return Identifier((const IdentifierEntry *)
                         DenseMapInfo<const void*>::getEmptyKey());
    }
 
    static Identifier getTombstoneKey()
    {
-      return Identifier((const char*)
+      return Identifier((const IdentifierEntry *)
                         DenseMapInfo<const void*>::getTombstoneKey());
    }
 
@@ -256,7 +293,7 @@ struct DenseMapInfo<Identifier>
 
    static unsigned getHashValue(Identifier value)
    {
-      return DenseMapInfo<const void*>::getHashValue(value.get());
+      return DenseMapInfo<const void*>::getHashValue(value.getAsOpaquePointer());
    }
 
    static bool isEqual(Identifier lhs, Identifier rhs)
@@ -328,26 +365,26 @@ public:
 
    static DeclBaseName createSubscript()
    {
-      return DeclBaseName(Identifier((const char *)m_subscriptIdentifierData));
+      return DeclBaseName(Identifier::getFromOpaquePointer(m_subscriptIdentifierData));
    }
 
    static DeclBaseName createConstructor()
    {
-      return DeclBaseName(Identifier((const char *)m_constructorIdentifierData));
+      return DeclBaseName(Identifier::getFromOpaquePointer(m_constructorIdentifierData));
    }
 
    static DeclBaseName createDestructor()
    {
-      return DeclBaseName(Identifier((const char *)m_destructorIdentifierData));
+      return DeclBaseName(Identifier::getFromOpaquePointer(m_destructorIdentifierData));
    }
 
    Kind getKind() const
    {
-      if (m_identifier.get() == m_subscriptIdentifierData) {
+      if (m_identifier.getAsOpaquePointer() == m_subscriptIdentifierData) {
          return Kind::Subscript;
-      } else if (m_identifier.get() == m_constructorIdentifierData) {
+      } else if (m_identifier.getAsOpaquePointer() == m_constructorIdentifierData) {
          return Kind::Constructor;
-      } else if (m_identifier.get() == m_destructorIdentifierData) {
+      } else if (m_identifier.getAsOpaquePointer() == m_destructorIdentifierData) {
          return Kind::Destructor;
       } else {
          return Kind::Normal;
@@ -427,12 +464,12 @@ public:
 
    bool operator<(DeclBaseName other) const
    {
-      return m_identifier.get() < other.m_identifier.get();
+      return getAsOpaquePointer() < other.getAsOpaquePointer();
    }
 
    const void *getAsOpaquePointer() const
    {
-      return m_identifier.get();
+      return m_identifier.getAsOpaquePointer();
    }
 
    static DeclBaseName getFromOpaquePointer(void *ptr)
@@ -0,0 +1,98 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_AST_IDENTIFIER_TABLE_H
+#define POLARPHP_AST_IDENTIFIER_TABLE_H
+
+#include "polarphp/ast/Identifier.h"
+#include "polarphp/utils/Allocator.h"
+
+#include <functional>
+#include <vector>
+
+namespace polar::ast {
+
+using polar::utils::BumpPtrAllocator;
+
+///
+/// uniques the identifiers of one AstContext in a dedicated arena
+///
+/// every spelling is stored once together with its length and the hash of
+/// its lowercased form, and every entry links to the entry of its
+/// lowercased spelling, so a case-insensitive comparison is a pointer
+/// comparison and a case-insensitive lookup a single probe
+///
+class IdentifierTable
+{
+public:
+   /// gets the text of a new identifier and returns storage with the same
+   /// nul terminated content that outlives the table, or an empty StringRef
+   /// to have the text copied into the arena. the engine installs one that
+   /// returns permanent interned zend_strings, so front-end and VM symbols
+   /// share their bytes
+   using ExternalInterner = std::function<StringRef(StringRef text)>;
+
+   IdentifierTable();
+   ~IdentifierTable();
+   IdentifierTable(const IdentifierTable &) = delete;
+   IdentifierTable &operator=(const IdentifierTable &) = delete;
+
+   /// returns the unique identifier with exactly this spelling
+   Identifier get(StringRef text);
+
+   /// returns the identifier with exactly this spelling, or an empty one
+   /// when it was never interned
+   Identifier lookup(StringRef text) const;
+
+   /// returns the lowercased identifier of any interned spelling of
+   /// \p text, or an empty one when no spelling was interned
+   Identifier lookupCaseInsensitive(StringRef text) const;
+
+   void setExternalInterner(ExternalInterner interner)
+   {
+      m_externalInterner = std::move(interner);
+   }
+
+   /// the number of distinct spellings, lowercased forms included
+   size_t size() const
+   {
+      return m_size;
+   }
+
+   /// the hash the engine computes for a zend_string with this text
+   static uint64_t hash(StringRef text);
+
+   /// hash(text.lower()) without building the lowercased string
+   static uint64_t hashCaseInsensitive(StringRef text);
+
+private:
+   struct Bucket
+   {
+      uint64_t hash;
+      const IdentifierEntry *entry;
+   };
+
+   const IdentifierEntry *find(StringRef text, uint64_t hash) const;
+   const IdentifierEntry *insert(StringRef text, uint64_t hash, uint64_t foldedHash,
+                                 const IdentifierEntry *folded);
+   const char *copyText(StringRef text);
+   void grow();
+
+private:
+   BumpPtrAllocator m_allocator;
+   std::vector<Bucket> m_buckets;
+   size_t m_size = 0;
+   ExternalInterner m_externalInterner;
+};
+
+} // polar::ast
+
+#endif // POLARPHP_AST_IDENTIFIER_TABLE_H
@@ -35,7 +35,7 @@
 #include "polarphp/basic/adt/ArrayRef.h"
 #include "polarphp/basic/adt/PointerUnion.h"
 #include "polarphp/basic/adt/StlExtras.h"
-#include "polarphp/Basic/InlineBitfield.h"
+#include "polarphp/basic/InlineBitfield.h"
 #include "polarphp/utils/ErrorHandling.h"
 #include "polarphp/utils/TrailingObjects.h"
 
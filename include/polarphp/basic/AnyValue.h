@@ -87,12 +87,12 @@ class AnyValue
       const T m_value;
 
       Holder(T &&value)
-         : HolderBase(TypeId<T>::m_value),
+         : HolderBase(TypeId<T>::value),
            m_value(std::move(value))
       {}
 
       Holder(const T &value)
-         : HolderBase(TypeId<T>::m_value),
+         : HolderBase(TypeId<T>::value),
            m_value(value)
       {}
 
@@ -131,7 +131,7 @@ public:
    template<typename T>
    const T &castTo() const
    {
-      assert(m_stored->m_typeId == TypeId<T>::m_value);
+      assert(m_stored->m_typeId == TypeId<T>::value);
       return static_cast<const Holder<T> *>(m_stored.get())->m_value;
    }
 
@@ -140,7 +140,7 @@ public:
    template<typename T>
    const T *getAs() const
    {
-      if (m_stored->m_typeId != TypeId<T>::m_value) {
+      if (m_stored->m_typeId != TypeId<T>::value) {
          return nullptr;
       }
       return &static_cast<const Holder<T> *>(m_stored.get())->m_value;
@@ -162,7 +162,7 @@ public:
 
    friend void simple_display(RawOutStream &out, const AnyValue &value)
    {
-      m_value.m_stored->display(out);
+      value.m_stored->display(out);
    }
 
    /// Return the result of calling simple_display as a string.
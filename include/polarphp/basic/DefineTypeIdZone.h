@@ -0,0 +1,103 @@
+//===--- DefineTypeIDZone.h - Define a TypeID Zone --------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2018 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+//===----------------------------------------------------------------------===//
+//
+//  This file should be #included to define the TypeIDs for a given zone.
+//  Two macros should be #define'd before inclusion, and will be #undef'd at
+//  the end of this file:
+//
+//    POLAR_TYPEID_ZONE: The ID number of the Zone being defined, which must
+//    be unique. 0 is reserved for basic C and LLVM types; 255 is reserved
+//    for test cases.
+//
+//    POLAR_TYPEID_HEADER: A (quoted) name of the header to be
+//    #included to define the types in the zone.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef POLAR_TYPEID_ZONE
+#  error Must define the value of the TypeID zone with the given name.
+#endif
+
+#ifndef POLAR_TYPEID_HEADER
+#  error Must define the TypeID header name with POLAR_TYPEID_HEADER
+#endif
+
+// Define a TypeID where the type name and internal name are the same.
+#define POLAR_TYPEID(Type) POLAR_TYPEID_NAMED(Type, Type)
+
+// First pass: put all of the names into an enum so we get values for them.
+template<> struct TypeIdZoneTypes<POLAR_TYPEID_ZONE>
+{
+   enum Types
+   {
+#define POLAR_TYPEID_NAMED(Type, Name) Name,
+#define POLAR_TYPEID_TEMPLATE1_NAMED(Template, Name, Param1, Arg1) Name,
+#include POLAR_TYPEID_HEADER
+#undef POLAR_TYPEID_NAMED
+#undef POLAR_TYPEID_TEMPLATE1_NAMED
+   };
+};
+
+// Second pass: create specializations of TypeId for these types.
+#define POLAR_TYPEID_NAMED(Type, Name)                          \
+   template<> struct TypeId<Type>                                \
+   {                                                             \
+      static const uint64_t value =                              \
+         form_type_id(POLAR_TYPEID_ZONE,                         \
+                      TypeIdZoneTypes<POLAR_TYPEID_ZONE>::Name); \
+                                                                 \
+      static StringRef getName()                                 \
+      {                                                          \
+         return #Name;                                           \
+      }                                                          \
+   };
+
+#define POLAR_TYPEID_TEMPLATE1_NAMED(Template, Name, Param1, Arg1)         \
+   template<Param1> struct TypeId<Template<Arg1>>                          \
+   {                                                                       \
+   private:                                                                \
+      static const uint64_t templateID =                                   \
+         form_type_id(POLAR_TYPEID_ZONE,                                   \
+                      TypeIdZoneTypes<POLAR_TYPEID_ZONE>::Name);           \
+                                                                           \
+   public:                                                                 \
+      static const uint64_t value =                                        \
+         (TypeId<Arg1>::value << 16) | templateID;                         \
+                                                                           \
+      static std::string getName()                                         \
+      {                                                                    \
+         return std::string(#Name) + "<" +                                 \
+               std::string(TypeId<Arg1>::getName()) + ">";                 \
+      }                                                                    \
+   };                                                                      \
+                                                                           \
+   template<Param1> const uint64_t TypeId<Template<Arg1>>::value;
+
+#include POLAR_TYPEID_HEADER
+
+#undef POLAR_TYPEID_NAMED
+#undef POLAR_TYPEID_TEMPLATE1_NAMED
+
+#undef POLAR_TYPEID
+#undef POLAR_TYPEID_ZONE
+#undef POLAR_TYPEID_HEADER
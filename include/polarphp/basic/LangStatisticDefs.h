@@ -22,7 +22,7 @@
 //===----------------------------------------------------------------------===//
 
 /// Driver statistics are collected for driver processes
-#ifdef POLAR_DRIVER_STATISTIC
+#ifdef DRIVER_STATISTIC
 
 /// Total number of jobs (frontend, merge-modules, link, etc.) run by the
 /// driver.  This should be some number less than the total number of files in
@@ -74,7 +74,7 @@ DRIVER_STATISTIC(ChildrenMaxRSS)
 #endif
 
 /// Driver statistics are collected for frontend processes
-#ifdef POLAR_FRONTEND_STATISTIC
+#ifdef FRONTEND_STATISTIC
 
 /// Total number of frontend processes that exited with EXIT_FAILURE / not with
 /// EXIT_SUCCESS.
@@ -219,12 +219,20 @@ FRONTEND_STATISTIC(Sema, NumTypesValidated)
 /// Number of lazy iterable declaration contexts left unloaded.
 FRONTEND_STATISTIC(Sema, NumUnloadedLazyIterableDeclContexts)
 
+/// Number of requests the request evaluator actually evaluated.
+FRONTEND_STATISTIC(Sema, NumEvaluatorRequests)
+
+/// Number of requests answered from the request evaluator's cache.
+FRONTEND_STATISTIC(Sema, NumEvaluatorCacheHits)
+
+/// Number of cached request results dropped because something they were
+/// computed from changed.
+FRONTEND_STATISTIC(Sema, NumEvaluatorInvalidations)
+
 /// All type check requests go into the Sema area.
-#define SWIFT_TYPEID(NAME) FRONTEND_STATISTIC(Sema, NAME)
-#include "swift/AST/AccessTypeIDZone.def"
-#include "swift/AST/NameLookupTypeIDZone.def"
-#include "swift/AST/TypeCheckerTypeIDZone.def"
-#undef SWIFT_TYPEID
+#define POLARPHP_TYPEID(NAME) FRONTEND_STATISTIC(Sema, NAME)
+#include "polarphp/ast/NameLookupTypeIDZoneDefs.h"
+#undef POLARPHP_TYPEID
 
 /// The next 10 statistics count 5 kinds of SIL entities present
 /// after the SILGen and SILOpt phases. The entities are functions,
@@ -0,0 +1,222 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_CODEGEN_BYTECODE_EMITTER_H
+#define POLARPHP_CODEGEN_BYTECODE_EMITTER_H
+
+#include "polarphp/basic/adt/StringMap.h"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+extern "C" {
+#include "polarphp/vm/zend/zend_type_info.h"
+}
+
+#include <unordered_map>
+#include <vector>
+
+namespace polar::codegen {
+
+using polar::basic::StringMap;
+using polar::basic::StringRef;
+
+enum class OperandKind : uint8_t
+{
+   Unused,
+   Const,
+   Tmp,
+   Var,
+   Cv
+};
+
+///
+/// a value produced by the emitter, the constant number of a Const, the
+/// slot of a Tmp or Var, or the variable number of a Cv. a Tmp or Var has
+/// to be consumed exactly once, like the legacy compiler's znodes
+///
+struct Operand
+{
+   OperandKind kind = OperandKind::Unused;
+   uint32_t index = 0;
+   /// the opline that defined a Tmp or Var
+   uint32_t def = 0;
+
+   bool isTemporary() const
+   {
+      return kind == OperandKind::Tmp || kind == OperandKind::Var;
+   }
+
+   bool isConst() const
+   {
+      return kind == OperandKind::Const;
+   }
+};
+
+using Label = uint32_t;
+
+///
+/// lowers front-end constructs straight into a zend_op_array, without
+/// going through zend_ast and zend_compile.c
+///
+/// temporaries are reused: a Tmp operand is released by the instruction
+/// that consumes it, and every new result takes the lowest free slot, so
+/// op_array->T is the peak number of live values instead of the number of
+/// values ever produced. constants and function names are resolved while
+/// emitting when the engine already knows them, and for every result and
+/// every compiled variable a MAY_BE_* type mask is kept for the optimizer
+///
+/// must be used while the engine is inside a request, the op array and
+/// everything it holds are allocated with emalloc
+///
+class BytecodeEmitter
+{
+public:
+   /// \p filename becomes op_array->filename, the compiled filename of
+   /// the engine is used when it is null
+   explicit BytecodeEmitter(zend_string *filename = nullptr);
+   ~BytecodeEmitter();
+   BytecodeEmitter(const BytecodeEmitter &) = delete;
+   BytecodeEmitter &operator=(const BytecodeEmitter &) = delete;
+
+   void setLine(uint32_t line)
+   {
+      m_line = line;
+   }
+
+   Operand emitNull();
+   Operand emitBool(bool value);
+   Operand emitLong(zend_long value);
+   Operand emitDouble(double value);
+   Operand emitString(StringRef value);
+   /// takes over \p value, equal scalars share one literal
+   Operand emitLiteral(zval *value);
+
+   /// the compiled variable called \p name, `$` excluded
+   Operand getVariable(StringRef name);
+   /// the variable may be changed behind the emitter's back, by a
+   /// reference, `extract()`, `$$name` and the like
+   void markVariableEscaped(Operand variable);
+
+   /// emits a binary operator, ZEND_ADD ... ZEND_BOOL_XOR, two constant
+   /// operands are folded when the legacy compiler would fold them
+   Operand emitBinaryOp(zend_uchar opcode, Operand lhs, Operand rhs);
+   /// ZEND_BW_NOT, ZEND_BOOL_NOT or ZEND_BOOL
+   Operand emitUnaryOp(zend_uchar opcode, Operand operand);
+
+   /// \p name is resolved already, \p fullyQualified is false for an
+   /// unqualified name that falls back to the global constant at runtime
+   Operand emitFetchConstant(StringRef name, bool fullyQualified, bool inNamespace = false);
+
+   /// starts a call to a function with a resolved name, the arguments
+   /// follow with emitSendArgument() and endFunctionCall() makes the call
+   void beginFunctionCall(StringRef name, bool fullyQualified, bool inNamespace = false);
+   void emitSendArgument(Operand argument);
+   Operand endFunctionCall();
+
+   Operand emitAssign(Operand variable, Operand value);
+   void emitEcho(Operand value);
+   void emitReturn(Operand value);
+   /// drops a value nobody reads
+   void emitFree(Operand value);
+
+   Label createLabel();
+   void bindLabel(Label label);
+   void emitJump(Label target);
+   void emitJumpIfFalse(Operand condition, Label target);
+   void emitJumpIfTrue(Operand condition, Label target);
+
+   /// appends the implicit return, runs pass_two and hands the op array
+   /// over to the caller, the emitter can only be queried afterwards
+   zend_op_array *finish();
+
+   /// the MAY_BE_* mask of the result of the opline at \p opnum, only
+   /// meaningful after finish()
+   uint32_t getResultType(uint32_t opnum) const;
+   /// the MAY_BE_* mask of a compiled variable over the whole op array
+   uint32_t getVariableType(uint32_t var) const;
+   uint32_t getOperandType(Operand operand) const;
+
+   uint32_t getNumTemporaries() const
+   {
+      return m_numSlots;
+   }
+
+private:
+   struct PendingCall
+   {
+      uint32_t init;
+      zend_function *function;
+      uint32_t numArgs;
+   };
+
+   struct OplineInfo
+   {
+      /// definitions of Tmp and Var inputs, ~0 for other operands
+      uint32_t op1Def;
+      uint32_t op2Def;
+      uint32_t resultType;
+   };
+
+   struct JumpFixup
+   {
+      uint32_t opnum;
+      Label label;
+   };
+
+   zend_op *emitOp(zend_uchar opcode, Operand op1, Operand op2);
+   Operand makeResult(zend_op *opline, OperandKind kind);
+   void setOperand(zend_op *opline, znode_op &node, zend_uchar &type, Operand operand,
+                   uint32_t &def);
+   void releaseOperand(Operand operand);
+   uint32_t allocateSlot();
+   Operand addConstant(zval *value);
+   uint32_t materializeConstant(uint32_t constant);
+   uint32_t addLiteral(zval *value);
+   uint32_t addStringLiteral(zend_string *value);
+   uint32_t addFunctionNameLiterals(zend_string *name, bool inNamespace);
+   uint32_t addConstantNameLiterals(zend_string *name, bool unqualified);
+   uint32_t allocateCacheSlot();
+   void emitJumpIf(zend_uchar opcode, Operand condition, Label target);
+   void inferTypes();
+   uint32_t computeResultType(const zend_op &opline, uint32_t op1Type, uint32_t op2Type) const;
+   uint32_t getInputType(zend_uchar type, znode_op node, uint32_t def) const;
+   void releaseConstants();
+
+private:
+   zend_op_array *m_opArray;
+   uint32_t m_opcodesCapacity;
+   uint32_t m_literalsCapacity = 0;
+   uint32_t m_varsCapacity = 0;
+   uint32_t m_line = 0;
+   uint32_t m_numSlots = 0;
+   std::vector<bool> m_freeSlots;
+   std::vector<OplineInfo> m_oplineInfos;
+   std::vector<uint32_t> m_variableTypes;
+   std::vector<bool> m_escapedVariables;
+   std::vector<uint32_t> m_labels;
+   std::vector<JumpFixup> m_fixups;
+   std::vector<PendingCall> m_calls;
+   /// the values of Const operands, they only become literals once an
+   /// instruction uses them, so folded operands leave nothing behind
+   std::vector<zval> m_constants;
+   std::vector<uint32_t> m_constantLiterals;
+   std::vector<uint32_t> m_constantTypes;
+   StringMap<uint32_t> m_variables;
+   StringMap<uint32_t> m_stringConstants;
+   std::unordered_map<zend_long, uint32_t> m_longConstants;
+   std::unordered_map<uint64_t, uint32_t> m_doubleConstants;
+   uint32_t m_scalarConstants[3] = {~0u, ~0u, ~0u};
+   bool m_finished = false;
+};
+
+} // polar::codegen
+
+#endif // POLARPHP_CODEGEN_BYTECODE_EMITTER_H
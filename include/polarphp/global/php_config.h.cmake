@@ -782,6 +782,9 @@
 /* Define to 1 if you have the `link' function. */
 #cmakedefine01 HAVE_LINK
 
+/* Define to 1 if you have the <linux/io_uring.h> header file. */
+#cmakedefine01 HAVE_LINUX_IO_URING_H
+
 /* Define to 1 if you have the `localeconv' function. */
 #cmakedefine01 HAVE_LOCALECONV
 
@@ -1886,6 +1889,9 @@
 /* */
 #cmakedefine01 ZTS
 
+/* Keep the engine globals in initial-exec thread locals */
+#cmakedefine ZEND_STATIC_TLS_GLOBALS
+
 #cmakedefine HAVE_ASM_GOTO
 
 /* Define to empty if `const' does not conform to ANSI C. */
@@ -25,6 +25,7 @@
 
 #include "polarphp/markup/LineList.h"
 #include "polarphp/basic/adt/SetVector.h"
+#include "polarphp/utils/Casting.h"
 #include "polarphp/utils/ErrorHandling.h"
 #include "polarphp/utils/TrailingObjects.h"
 
@@ -45,6 +46,7 @@ using polar::basic::SmallSetVector;
 using polar::basic::ArrayRef;
 using polar::utils::TrailingObjects;
 using polar::utils::RawOutStream;
+using polar::utils::cast;
 
 /// The basic structure of a doc comment attached to a Swift
 /// declaration.
@@ -60,9 +62,9 @@ struct CommentParts
 
    bool isEmpty() const
    {
-      return !brief.hasValue() &&
-            !returnsField.hasValue() &&
-            !throwsField.hasValue() &&
+      return !brief.has_value() &&
+            !returnsField.has_value() &&
+            !throwsField.has_value() &&
             bodyNodes.empty() &&
             paramFields.empty();
    }
@@ -70,8 +72,8 @@ struct CommentParts
    bool hasFunctionDocumentation() const
    {
       return !paramFields.empty() ||
-            returnsField.hasValue() ||
-            throwsField.hasValue();
+            returnsField.has_value() ||
+            throwsField.has_value();
    }
 };
 
@@ -303,6 +305,16 @@ public:
       return m_literalContent;
    }
 
+   ArrayRef<const MarkupAstNode *> getChildren() const
+   {
+      return {};
+   }
+
+   ArrayRef<MarkupAstNode *> getChildren()
+   {
+      return {};
+   }
+
    static bool classof(const MarkupAstNode *node)
    {
       return node->getKind() == AstNodeKind::HTML;
@@ -778,7 +790,7 @@ public:
       if (!m_parts.has_value()) {
          return false;
       }
-      return m_parts.getValue().hasFunctionDocumentation();
+      return m_parts->hasFunctionDocumentation();
    }
 
    ArrayRef<MarkupAstNode *> getChildren()
@@ -805,6 +817,40 @@ private:
    ParamField(StringRef name, ArrayRef<MarkupAstNode *> children);
 };
 
+/// a phpdoc tag line like `@return int the count`, the name is stored
+/// without the leading `@` and the value is the rest of the tag text
+/// with its continuation lines joined by a single space
+class AnnotationField final : public PrivateExtension
+{
+public:
+   static AnnotationField *create(MarkupContext &mcontext, StringRef name,
+                                  StringRef value);
+
+   StringRef getName() const
+   {
+      return m_name;
+   }
+
+   StringRef getValue() const
+   {
+      return m_value;
+   }
+
+   static bool classof(const MarkupAstNode *node)
+   {
+      return node->getKind() == AstNodeKind::AnnotationField;
+   }
+
+private:
+   StringRef m_name;
+   StringRef m_value;
+   AnnotationField(StringRef name, StringRef value)
+      : PrivateExtension(AstNodeKind::AnnotationField),
+        m_name(name),
+        m_value(value)
+   {}
+};
+
 #define MARKUP_SIMPLE_FIELD(Id, Keyword, XMLKind) \
    class Id final : public PrivateExtension, \
    private TrailingObjects<Id, MarkupAstNode *> { \
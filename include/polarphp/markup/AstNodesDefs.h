@@ -73,6 +73,7 @@ MARKUP_AST_NODE_RANGE(Inline, Text, Image)
 
 MARKUP_AST_NODE(PrivateExtension, MarkupASTNode)
   MARKUP_AST_NODE(ParamField, PrivateExtension)
+  MARKUP_AST_NODE(AnnotationField, PrivateExtension)
 
   // Simple fields
   // There must be a corresponding definition in
@@ -108,7 +109,7 @@ MARKUP_AST_NODE(PrivateExtension, MarkupASTNode)
   MARKUP_AST_NODE(RecommendedField, PrivateExtension)
   MARKUP_AST_NODE(RecommendedoverField, PrivateExtension)
 
-MARKUP_AST_NODE_RANGE(Private, ParamField, WarningField)
+MARKUP_AST_NODE_RANGE(Private, ParamField, RecommendedoverField)
 #undef MARKUP_AST_NODE
 #undef ABSTRACT_MARKUP_AST_NODE
 #undef MARKUP_AST_NODE_RANGE
@@ -0,0 +1,88 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_MARKUP_DOC_COMMENT_H
+#define POLARPHP_MARKUP_DOC_COMMENT_H
+
+#include "polarphp/basic/adt/StringMap.h"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/markup/Ast.h"
+
+#include <memory>
+#include <mutex>
+
+namespace polar::markup {
+
+using polar::basic::StringMap;
+using polar::basic::StringRef;
+
+/// true when a `/** */` comment has a tag, an `@` that starts a line
+/// after the comment leader, a comment without one is plain prose and
+/// there is nothing a parse would add to it
+bool doc_comment_has_tags(StringRef comment);
+
+/// parses a `/** */` comment into a Document, the first paragraph is the
+/// summary, the following ones the description and every tag becomes an
+/// AnnotationField child, all text is copied into \p mcontext
+Document *parse_doc_comment(MarkupContext &mcontext, StringRef comment);
+
+///
+/// parsed doc comments keyed by their text
+///
+/// a comment is parsed the first time it is asked for and every later
+/// lookup of the same text returns the same nodes, comments without tags
+/// are never parsed. the cache keeps its own copy of every text, so the
+/// strings a comment was read from may be freed while it is cached, the
+/// nodes live in the cache's own arena until clear()
+///
+class DocCommentCache
+{
+public:
+   DocCommentCache();
+   ~DocCommentCache();
+
+   /// returns nullptr when the comment has no tags
+   const Document *get(StringRef comment);
+
+   void clear();
+
+   unsigned getNumEntries() const
+   {
+      return m_entries.getNumItems();
+   }
+
+   unsigned getNumParses() const
+   {
+      return m_numParses;
+   }
+
+   unsigned getNumHits() const
+   {
+      return m_numHits;
+   }
+
+   unsigned getNumSkipped() const
+   {
+      return m_numSkipped;
+   }
+
+private:
+   std::mutex m_mutex;
+   std::unique_ptr<MarkupContext> m_context;
+   StringMap<const Document *> m_entries;
+   unsigned m_numParses = 0;
+   unsigned m_numHits = 0;
+   unsigned m_numSkipped = 0;
+};
+
+} // polar::markup
+
+#endif // POLARPHP_MARKUP_DOC_COMMENT_H
@@ -27,7 +27,7 @@
 #include "polarphp/utils/Allocator.h"
 #include "polarphp/utils/RawOutStream.h"
 #include "polarphp/parser/SourceLoc.h"
-#include "polarphp/markup/AST.h"
+#include "polarphp/markup/Ast.h"
 #include "polarphp/markup/LineList.h"
 
 /// forward declare class with namespace
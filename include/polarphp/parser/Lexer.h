@@ -0,0 +1,197 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_PARSER_LEXER_H
+#define POLARPHP_PARSER_LEXER_H
+
+#include "polarphp/parser/SourceLoc.h"
+#include "polarphp/syntax/Token.h"
+#include "polarphp/utils/LineTable.h"
+
+namespace polar::parser {
+
+using polar::syntax::Token;
+using polar::syntax::TokenKindType;
+using polar::utils::LineTable;
+
+enum class CommentRetentionMode
+{
+   /// comments are folded into the leading trivia of the next token
+   None,
+   /// comments are returned as comment and doc_comment tokens
+   ReturnAsTokens
+};
+
+enum class LexerMode : std::uint8_t
+{
+   /// outside of <?php ... ?>, text up to the next open tag is inline_html
+   InlineHtml,
+   Scripting
+};
+
+///
+/// the lexer keeps all of its state in the object and only hands out
+/// StringRefs into the buffer, so any number of lexers can run on different
+/// threads and producing a token never allocates. the buffer is usually the
+/// memory mapped file owned by the SourceManager, it must outlive the lexer
+///
+class Lexer
+{
+public:
+   /// a position the lexer can be rewound to, used for speculative parsing
+   /// and to restart lexing in the middle of a buffer when reparsing
+   class State
+   {
+   public:
+      State() = default;
+
+      bool isValid() const
+      {
+         return m_ptr != nullptr;
+      }
+
+      LexerMode getMode() const
+      {
+         return m_mode;
+      }
+
+   private:
+      State(const char *ptr, LexerMode mode, TokenKindType lastKind)
+         : m_ptr(ptr),
+           m_mode(mode),
+           m_lastKind(lastKind)
+      {}
+
+      const char *m_ptr = nullptr;
+      LexerMode m_mode = LexerMode::InlineHtml;
+      TokenKindType m_lastKind = TokenKindType::unknown;
+      friend class Lexer;
+   };
+
+   Lexer(const SourceManager &sourceMgr, unsigned bufferID,
+         CommentRetentionMode commentRetention = CommentRetentionMode::None,
+         bool shortOpenTag = false);
+
+   /// lex the [offset, endOffset) slice of the buffer, starting in mode
+   Lexer(const SourceManager &sourceMgr, unsigned bufferID, unsigned offset,
+         unsigned endOffset, LexerMode mode,
+         CommentRetentionMode commentRetention = CommentRetentionMode::None,
+         bool shortOpenTag = false);
+
+   /// lex a standalone buffer, the text must stay alive as long as the lexer
+   explicit Lexer(StringRef buffer, LexerMode mode = LexerMode::InlineHtml,
+                  CommentRetentionMode commentRetention = CommentRetentionMode::None,
+                  bool shortOpenTag = false);
+
+   Lexer(const Lexer &) = delete;
+   Lexer &operator=(const Lexer &) = delete;
+
+   void lex(Token &result);
+
+   /// records the line starts of everything lexed from now on into table,
+   /// including what lies between the buffer start and the current position.
+   /// the bytes are in cache at that point so this costs far less than a
+   /// separate pass, hand the table to SourceManager::setLineTable after
+   void setLineTable(LineTable *table)
+   {
+      m_lineTable = table;
+   }
+
+   bool isAtEndOfBuffer() const
+   {
+      return m_curPtr == m_bufferEnd;
+   }
+
+   unsigned getBufferID() const
+   {
+      return m_bufferID;
+   }
+
+   LexerMode getMode() const
+   {
+      return m_mode;
+   }
+
+   State getState() const
+   {
+      return State(m_curPtr, m_mode, m_lastKind);
+   }
+
+   void restoreState(State state)
+   {
+      assert(state.isValid() && state.m_ptr >= m_bufferStart &&
+             state.m_ptr <= m_bufferEnd && "state does not belong to this buffer");
+      m_curPtr = state.m_ptr;
+      m_mode = state.m_mode;
+      m_lastKind = state.m_lastKind;
+   }
+
+   /// byte offset of ptr relative to the start of the whole buffer
+   unsigned getOffsetInBuffer(const char *ptr) const
+   {
+      assert(ptr >= m_bufferStart && ptr <= m_bufferEnd && "pointer out of buffer");
+      return ptr - m_bufferStart;
+   }
+
+   /// offset of the token text (not its trivia) in the buffer
+   unsigned getTokenOffset(const Token &token) const
+   {
+      return getOffsetInBuffer(token.getStart());
+   }
+
+   static SourceLoc getSourceLoc(const char *loc)
+   {
+      return SourceLoc(BasicSMLoc::getFromPointer(loc));
+   }
+
+   static SourceLoc getLocForToken(const Token &token)
+   {
+      return getSourceLoc(token.getStart());
+   }
+
+   /// the keyword kind for an identifier spelling (case insensitive), or
+   /// identifier when it is not a keyword
+   static TokenKindType getKindOfIdentifier(StringRef text);
+
+private:
+   void initialize(unsigned offset, unsigned endOffset);
+   void formToken(Token &result, TokenKindType kind, const char *tokStart);
+   bool skipTrivia(Token &result);
+   void lexInlineHtml(Token &result);
+   void lexIdentifier(Token &result, const char *tokStart);
+   void lexVariable(Token &result, const char *tokStart);
+   void lexNumber(Token &result, const char *tokStart);
+   void lexSingleQuoteString(Token &result, const char *tokStart);
+   void lexInterpolatedString(Token &result, const char *tokStart, char quote);
+   bool tryLexHeredoc(Token &result, const char *tokStart);
+   bool tryLexCast(Token &result, const char *tokStart);
+   void lexCloseTag(Token &result, const char *tokStart);
+   void lexPunctuator(Token &result, const char *tokStart);
+
+private:
+   const char *m_bufferStart = nullptr;
+   const char *m_bufferEnd = nullptr;
+   const char *m_curPtr = nullptr;
+   /// the start of the leading trivia of the token being formed
+   const char *m_triviaStart = nullptr;
+   LineTable *m_lineTable = nullptr;
+   unsigned m_bufferID = 0;
+   std::uint8_t m_tokenFlags = 0;
+   LexerMode m_mode;
+   /// keywords after -> are property names
+   TokenKindType m_lastKind = TokenKindType::unknown;
+   const CommentRetentionMode m_commentRetention;
+   const bool m_shortOpenTag;
+};
+
+} // polar::parser
+
+#endif // POLARPHP_PARSER_LEXER_H
@@ -0,0 +1,240 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_PARSER_PROJECT_PARSER_H
+#define POLARPHP_PARSER_PROJECT_PARSER_H
+
+#include "polarphp/basic/adt/ArrayRef.h"
+#include "polarphp/basic/adt/StringMap.h"
+#include "polarphp/parser/SyntaxParser.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace polar::parser {
+
+using polar::basic::ArrayRef;
+using polar::basic::StringMap;
+using polar::utils::RawOutStream;
+
+enum class IndexedDeclKind : uint8_t
+{
+   Class,
+   Interface,
+   Trait,
+   Function,
+   Constant
+};
+
+/// a top level declaration, name is fully qualified without the leading
+/// backslash, e.g. "Foo\\Bar\\Baz"
+struct IndexedDecl
+{
+   IndexedDeclKind kind;
+   unsigned fileIndex;
+   unsigned offset;
+   unsigned line;
+   unsigned column;
+   std::string name;
+   /// the declaration up to its body with the whitespace collapsed, e.g.
+   /// "final class Foo extends Bar" or "const LIMIT = 10"
+   std::string signature;
+   /// the last doc comment in front of the declaration, may be empty
+   std::string docComment;
+};
+
+enum class ProjectDiagnosticKind : uint8_t
+{
+   Error,
+   Note
+};
+
+struct ProjectDiagnostic
+{
+   ProjectDiagnosticKind kind;
+   unsigned fileIndex;
+   unsigned offset;
+   unsigned line;
+   unsigned column;
+   std::string message;
+};
+
+///
+/// the declarations of a whole project, classes, interfaces and traits
+/// share one case insensitive name space like they do in php, functions
+/// are case insensitive too, constants are case sensitive. read only once
+/// built, so lookups are safe from any number of threads
+///
+class DeclarationIndex
+{
+public:
+   ArrayRef<IndexedDecl> getDecls() const
+   {
+      return m_decls;
+   }
+
+   /// class, interface or trait named qualifiedName, null if unknown
+   const IndexedDecl *lookupClassLike(StringRef qualifiedName) const;
+   const IndexedDecl *lookupFunction(StringRef qualifiedName) const;
+   const IndexedDecl *lookupConstant(StringRef qualifiedName) const;
+
+   /// binds a function name used in namespace currentNamespace the way php
+   /// does: a fully qualified name is taken as is, otherwise the name is
+   /// looked up relative to the namespace first and, when unqualified, in
+   /// the global namespace after that
+   const IndexedDecl *resolveFunction(StringRef name, StringRef currentNamespace) const;
+   const IndexedDecl *resolveConstant(StringRef name, StringRef currentNamespace) const;
+
+private:
+   friend class ProjectParser;
+
+   /// decls must be in file order, duplicates are appended to
+   /// redeclarations as pairs of (earlier, later) decl indices
+   void build(std::vector<IndexedDecl> decls,
+              std::vector<std::pair<unsigned, unsigned>> &redeclarations);
+
+   const IndexedDecl *lookup(const StringMap<unsigned> &map, StringRef key) const;
+
+private:
+   std::vector<IndexedDecl> m_decls;
+   StringMap<unsigned> m_classLikes;
+   StringMap<unsigned> m_functions;
+   StringMap<unsigned> m_constants;
+};
+
+///
+/// results of earlier runs, keyed by path and content hash. lookup is called
+/// from the parser threads at the same time, store only from the thread
+/// running parseAll, once for every file in file order
+///
+class ParseResultCache
+{
+public:
+   virtual ~ParseResultCache();
+
+   /// fills decls and diagnostics of fileIndex and returns true if a result
+   /// for exactly this text is known
+   virtual bool lookup(StringRef path, uint64_t contentHash, unsigned fileIndex,
+                       std::vector<IndexedDecl> &decls,
+                       std::vector<ProjectDiagnostic> &diagnostics) = 0;
+
+   virtual void store(StringRef path, uint64_t contentHash, ArrayRef<IndexedDecl> decls,
+                      ArrayRef<ProjectDiagnostic> diagnostics) = 0;
+};
+
+struct ProjectParserOptions
+{
+   /// 0 uses one thread per hardware thread
+   unsigned threadCount = 0;
+   bool shortOpenTag = false;
+   /// keep the syntax tree of every file, otherwise a tree is dropped as
+   /// soon as the file is indexed
+   bool retainTrees = false;
+   /// files found here are not parsed again, a cached file has no tree
+   ParseResultCache *cache = nullptr;
+};
+
+///
+/// parses many files concurrently and binds their top level declarations
+/// into one DeclarationIndex. workers take the next unparsed file from a
+/// shared counter so a few huge files do not hold the others back, every
+/// file gets its own syntax arena and its own result slot, so nothing is
+/// shared between workers until the merge, which runs on the calling
+/// thread in file order. the diagnostics therefore come out in the same
+/// order whatever the thread count and scheduling
+///
+class ProjectParser
+{
+public:
+   explicit ProjectParser(const ProjectParserOptions &options = ProjectParserOptions());
+   ~ProjectParser();
+
+   /// \returns the index of the file, files are reported in this order
+   unsigned addFile(StringRef path);
+
+   /// a file whose text is already in memory, text has to outlive parseAll
+   unsigned addBuffer(StringRef name, StringRef text);
+
+   /// parses every file added since the last call and rebuilds the index
+   /// \returns false if a file could not be read
+   bool parseAll();
+
+   unsigned getNumFiles() const
+   {
+      return m_files.size();
+   }
+
+   StringRef getFilePath(unsigned fileIndex) const
+   {
+      return m_files[fileIndex].path;
+   }
+
+   /// empty unless retainTrees was set
+   const std::optional<Syntax> &getTree(unsigned fileIndex) const
+   {
+      return m_files[fileIndex].tree;
+   }
+
+   const DeclarationIndex &getIndex() const
+   {
+      return m_index;
+   }
+
+   /// sorted by file, then offset
+   ArrayRef<ProjectDiagnostic> getDiagnostics() const
+   {
+      return m_diagnostics;
+   }
+
+   unsigned getNumErrors() const;
+
+   /// files of the last parseAll that were taken from the cache
+   unsigned getNumCachedFiles() const
+   {
+      return m_numCachedFiles;
+   }
+
+   /// the key of a file in a ParseResultCache, covers the parser options
+   /// that change the result as well as the text
+   uint64_t getContentHash(StringRef text) const;
+
+   /// "path:line:column: error: message" lines
+   void printDiagnostics(RawOutStream &out) const;
+
+private:
+   struct FileState
+   {
+      std::string path;
+      StringRef text;
+      bool parsed = false;
+      bool readFailed = false;
+      bool cached = false;
+      uint64_t contentHash = 0;
+      std::optional<Syntax> tree;
+      std::vector<IndexedDecl> decls;
+      std::vector<ProjectDiagnostic> diagnostics;
+   };
+
+   void parseFile(unsigned fileIndex);
+   void merge();
+
+private:
+   ProjectParserOptions m_options;
+   std::vector<FileState> m_files;
+   DeclarationIndex m_index;
+   std::vector<ProjectDiagnostic> m_diagnostics;
+   unsigned m_numCachedFiles = 0;
+};
+
+} // polar::parser
+
+#endif // POLARPHP_PARSER_PROJECT_PARSER_H
@@ -44,6 +44,7 @@ using polar::basic::IntrusiveRefCountPtr;
 using polar::basic::DenseMap;
 using polar::basic::ArrayRef;
 using polar::basic::Twine;
+using polar::utils::LineTable;
 using polar::utils::MemoryBuffer;
 using polar::utils::SMDiagnostic;
 using polar::utils::SMFixIt;
@@ -230,6 +231,13 @@ public:
       return { lineOffset + l, c };
    }
 
+   /// Installs the line starts recorded by a Lexer (see Lexer::setLineTable)
+   /// so line lookups into the buffer never rescan it.
+   void setLineTable(unsigned bufferID, LineTable table)
+   {
+      m_sourceMgr.setLineTable(bufferID, std::move(table));
+   }
+
    /// Returns the real line number for a source location.
    ///
    /// If \p bufferID is provided, \p loc must come from that source buffer.
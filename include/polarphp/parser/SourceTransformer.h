@@ -0,0 +1,75 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_PARSER_SOURCE_TRANSFORMER_H
+#define POLARPHP_PARSER_SOURCE_TRANSFORMER_H
+
+#include "polarphp/basic/adt/ArrayRef.h"
+#include "polarphp/basic/adt/StringRef.h"
+
+#include <string>
+
+namespace polar::utils {
+class RawOutStream;
+} // polar::utils
+
+namespace polar::parser {
+
+using polar::basic::ArrayRef;
+using polar::basic::StringRef;
+using polar::utils::RawOutStream;
+
+/// the highlight.* ini colors, the defaults are the ones php ships with
+struct HighlightColors
+{
+   std::string comment = "#FF8000";
+   std::string defaultColor = "#0000BB";
+   std::string html = "#000000";
+   std::string keyword = "#007700";
+   std::string string = "#DD0000";
+};
+
+/// writes source with the comments dropped and every run of whitespace
+/// folded into one space, the output of php -w
+void strip_source(StringRef source, RawOutStream &out, bool shortOpenTag = false);
+
+/// writes source as a <code> block of colored spans, the output of php -s
+void highlight_source(StringRef source, RawOutStream &out, const HighlightColors &colors,
+                      bool shortOpenTag = false);
+
+enum class SourceTransformKind : uint8_t
+{
+   Strip,
+   Highlight
+};
+
+struct SourceTransformOptions
+{
+   SourceTransformKind kind = SourceTransformKind::Strip;
+   HighlightColors colors;
+   bool shortOpenTag = false;
+   /// 0 means one thread per hardware thread
+   unsigned threadCount = 0;
+};
+
+///
+/// transforms every file in paths, "-" being stdin, and writes the results
+/// to out in the order of paths. the files are lexed in parallel, a file
+/// whose turn has not come yet is kept in memory, at most a few files per
+/// thread are in flight. returns false if any file could not be read, the
+/// reason goes to errors and the other files are still written
+///
+bool transform_source_files(ArrayRef<std::string> paths, RawOutStream &out,
+                            RawOutStream &errors, const SourceTransformOptions &options);
+
+} // polar::parser
+
+#endif // POLARPHP_PARSER_SOURCE_TRANSFORMER_H
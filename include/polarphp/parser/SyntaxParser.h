@@ -0,0 +1,95 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_PARSER_SYNTAX_PARSER_H
+#define POLARPHP_PARSER_SYNTAX_PARSER_H
+
+#include "polarphp/syntax/Syntax.h"
+#include "polarphp/utils/LineTable.h"
+
+#include <vector>
+
+namespace polar::parser {
+
+using polar::basic::StringRef;
+using polar::syntax::Syntax;
+using polar::utils::LineTable;
+
+/// removedLength bytes at offset of the old text were replaced by
+/// insertedLength bytes
+struct SourceEdit
+{
+   unsigned offset;
+   unsigned removedLength;
+   unsigned insertedLength;
+};
+
+struct ReparseStats
+{
+   /// bytes of the new text that went through the lexer again
+   unsigned reparsedBytes = 0;
+   /// nothing could be reused, the file was parsed from scratch
+   bool fullParse = false;
+};
+
+enum class SyntaxIssueKind : uint8_t
+{
+   UnexpectedCharacter,
+   UnterminatedLiteral,
+   UnterminatedComment,
+   UnmatchedCloser,
+   MissingCloser
+};
+
+/// a problem the tree builder noticed, the tree is built regardless
+struct SyntaxIssue
+{
+   SyntaxIssueKind kind;
+   unsigned offset;
+};
+
+/// "unterminated string or heredoc" etc.
+StringRef get_syntax_issue_message(SyntaxIssueKind kind);
+
+///
+/// builds the lossless syntax tree of a file, statements and balanced
+/// bracket groups, and keeps it up to date under edits. reparse only
+/// relexes the statements around the edit inside the innermost code block
+/// that contains it, and stops as soon as the new tokens line up with an
+/// old statement boundary again, everything else is shared with the old
+/// tree. if the edit unbalances the block (an unterminated string or
+/// comment, an extra brace) it retries with the enclosing block, up to
+/// the whole file
+///
+class SyntaxParser
+{
+public:
+   explicit SyntaxParser(bool shortOpenTag = false)
+      : m_shortOpenTag(shortOpenTag)
+   {}
+
+   /// issues, when given, receives the problems found in source in text
+   /// order, lineTable the line starts of source, finished
+   Syntax parse(StringRef source, std::vector<SyntaxIssue> *issues = nullptr,
+                LineTable *lineTable = nullptr) const;
+
+   /// oldTree is the tree of the text before the edit, newSource the text
+   /// after it, the returned tree shares the arena of oldTree
+   Syntax reparse(const Syntax &oldTree, StringRef newSource, const SourceEdit &edit,
+                  ReparseStats *stats = nullptr) const;
+
+private:
+   const bool m_shortOpenTag;
+};
+
+} // polar::parser
+
+#endif // POLARPHP_PARSER_SYNTAX_PARSER_H
@@ -14,6 +14,7 @@
 
 #include "polarphp/basic/adt/StringRef.h"
 #include "polarphp/basic/adt/ArrayRef.h"
+#include "polarphp/basic/adt/SmallVector.h"
 
 #include <vector>
 #include <string>
@@ -21,6 +22,7 @@
 
 #include "polarphp/runtime/internal/DepsZendVmHeaders.h"
 #include "polarphp/runtime/RtDefs.h"
+#include "polarphp/runtime/Ticks.h"
 
 /* Error display modes */
 #define PHP_DISPLAY_ERRORS_STDOUT	1
@@ -38,7 +40,6 @@ namespace runtime {
 
 using polar::basic::StringRef;
 using IniConfigDefaultInitFunc = void (*)(HashTable *configuration_hash);
-struct php_tick_function_entry;
 
 /// TODO
 ///  for interactive command shell
@@ -76,6 +77,7 @@ void php_on_timeout(int seconds);
 char *bootstrap_getenv(char *name, size_t nameLen);
 zend_string *php_resolve_path(const char *filename, size_t filename_len, const char *path);
 zend_string *php_resolve_path_for_zend(const char *filename, size_t filenameLen);
+size_t php_utf8_validate_for_zend(const unsigned char *str, size_t strLength);
 bool seek_file_begin(zend_file_handle *fileHandle, const char *scriptFile, int *lineno);
 POLAR_DECL_EXPORT bool php_hash_environment();
 void cli_register_file_handles();
@@ -105,6 +107,11 @@ struct ExecEnvInfo
    bool reportZendDebug;
    bool inErrorLog;
    bool inUserInclude;
+   /// the exec env is reused for many requests, request end may
+   /// reset the vm heap wholesale instead of tearing it down
+   bool workerMode;
+   /// worker mode, read the previous request's includes ahead in one batch
+   bool includePrefetch;
 #ifdef POLAR_OS_WIN32
    bool windowsShowCrtWarning;
 #endif
@@ -119,6 +126,8 @@ struct ExecEnvInfo
    int lastErrorType;
    int lastErrorLineno;
    size_t scriptArgc;
+   /// worker mode requests that ended through the fast reset
+   size_t fastResetRequests;
 
    zend_long serializePrecision;
    zend_long memoryLimit;
@@ -164,7 +173,7 @@ struct ExecEnvInfo
 
    std::vector<std::string> scriptArgv;
    IniConfigDefaultInitFunc iniDefaultInitHandler;
-   zend_llist tickFunctions;
+   polar::basic::SmallVector<TickFunctionEntry, 4> tickFunctions;
 };
 
 class ExecEnv
@@ -183,8 +192,11 @@ public:
    ExecEnv &setContainerArgv(const std::vector<StringRef> &argv);
    ExecEnv &setContainerArgv(char *argv[]);
    ExecEnv &setEnvReady(bool flag);
+   /// serve many requests from this exec env, see restartRequest()
+   ExecEnv &setWorkerMode(bool flag);
 
    bool isEnvReady() const;
+   bool isWorkerMode() const;
    ExecEnvInfo &getRuntimeInfo();
    uint32_t getCompileOptions() const;
    const std::vector<StringRef> &getContainerArgv() const;
@@ -193,6 +205,9 @@ public:
    int getVmExitStatus() const;
 
    bool execScript(StringRef filename, int &exitStatus);
+   /// ends the current request and starts the next one, the modules stay
+   /// loaded. in worker mode a clean request ends through the fast reset
+   bool restartRequest();
 
    size_t unbufferWrite(const char *str, int len);
    void logMessage(const char *logMessage, int syslogTypeInt);
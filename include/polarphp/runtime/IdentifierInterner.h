@@ -0,0 +1,39 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_RUNTIME_IDENTIFIER_INTERNER_H
+#define POLARPHP_RUNTIME_IDENTIFIER_INTERNER_H
+
+#include "polarphp/global/CompilerDetection.h"
+
+namespace polar::ast {
+class IdentifierTable;
+} // polar::ast
+
+namespace polar {
+namespace runtime {
+
+///
+/// makes \p table store a new spelling in the permanent interned string of
+/// the engine with the same text, the names of internal functions, classes
+/// and the known strings, so the front end and the vm share those bytes
+///
+/// the permanent interned strings are read only once the engine finished
+/// its startup, a spelling the engine does not know is copied into the
+/// arena of the table as before. the table must not outlive the engine,
+/// its shutdown frees the interned strings
+///
+POLAR_DECL_EXPORT void install_identifier_interner(ast::IdentifierTable &table);
+
+} // runtime
+} // polar
+
+#endif // POLARPHP_RUNTIME_IDENTIFIER_INTERNER_H
@@ -0,0 +1,47 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_RUNTIME_INCLUDE_PREFETCH_H
+#define POLARPHP_RUNTIME_INCLUDE_PREFETCH_H
+
+#include "polarphp/global/CompilerDetection.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace polar {
+namespace runtime {
+
+///
+/// files a request is expected to include are read ahead in one batch of
+/// io_uring submissions, zend_stream_open then hands the ready buffer to
+/// the scanner instead of doing open + fstat + read + close itself
+///
+/// without io_uring nothing is prefetched and every include goes through
+/// the usual synchronous fopen path
+///
+bool startup_include_prefetch();
+void shutdown_include_prefetch();
+/// worker mode, remember what this request included for the next one
+void record_include_graph();
+void prefetch_recorded_includes();
+/// wait for reads still in flight and drop buffers nobody consumed
+void discard_include_prefetch();
+
+POLAR_DECL_EXPORT bool is_include_prefetch_available();
+/// returns the number of files submitted
+POLAR_DECL_EXPORT std::size_t prefetch_include_files(const std::vector<std::string> &paths);
+
+} // runtime
+} // polar
+
+#endif // POLARPHP_RUNTIME_INCLUDE_PREFETCH_H
@@ -148,10 +148,10 @@ int output_start_lineno;
 int flags;
 ZEND_END_MODULE_GLOBALS(output)
 
-POLAR_DECL_EXPORT ZEND_EXTERN_MODULE_GLOBALS(output)
+POLAR_DECL_EXPORT ZEND_EXTERN_STATIC_MODULE_GLOBALS(output)
 
 /* there should not be a need to use OG() from outside of output.c */
-# define OG(v) ZEND_TSRMG(output_globals_id, zend_output_globals *, v)
+# define OG(v) ZEND_STATIC_MODULE_GLOBALS_ACCESSOR(output, v)
 
 /* convenience macros */
 #define PHPWRITE(str, str_len)		php_output_write((str), (str_len))
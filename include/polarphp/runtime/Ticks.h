@@ -14,16 +14,33 @@
 
 #include "polarphp/global/CompilerDetection.h"
 
+#include <cstdint>
+
 namespace polar {
 namespace runtime {
 
+using TickFunction = void (*)(int, void *);
+
+///
+/// registered tick handler, handlers with an interval greater than 1
+/// only run on every N-th tick, which lets cheap sampling hooks live
+/// together with declare(ticks=1) scripts
+///
+struct TickFunctionEntry
+{
+   TickFunction func;
+   void *arg;
+   std::uint32_t interval;
+   std::uint32_t countdown;
+};
+
 bool startup_ticks(void);
 void deactivate_ticks(void);
 void shutdown_ticks(void);
 void run_ticks(int count);
 
-POLAR_DECL_EXPORT void add_tick_function(void (*func)(int, void *), void *arg);
-POLAR_DECL_EXPORT void remove_tick_function(void (*func)(int, void *), void * arg);
+POLAR_DECL_EXPORT void add_tick_function(TickFunction func, void *arg, std::uint32_t interval = 1);
+POLAR_DECL_EXPORT void remove_tick_function(TickFunction func, void *arg);
 
 } // runtime
 } // polar
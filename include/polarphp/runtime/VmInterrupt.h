@@ -0,0 +1,62 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/06.
+
+#ifndef POLARPHP_RUNTIME_VM_INTERRUPT_H
+#define POLARPHP_RUNTIME_VM_INTERRUPT_H
+
+#include "polarphp/global/CompilerDetection.h"
+#include "polarphp/global/SystemDetection.h"
+
+#include <csignal>
+
+namespace polar {
+namespace runtime {
+
+///
+/// signals never run php code inside the signal handler, the handler only
+/// marks the signal pending and raises EG(vm_interrupt), the vm notices the
+/// flag at the next loop back-edge or call and dispatches the registered
+/// handlers from zend_interrupt_function, outside of the signal context
+///
+/// signal dispositions are process wide, so signals belong to one thread:
+/// the one that started the vm up. under ZTS every other thread is refused,
+/// add_vm_signal_handler and remove_vm_signal_handler return false there
+/// and dispatch_vm_signals does nothing
+///
+using VmSignalHandler = void (*)(int signo, void *arg);
+
+bool startup_vm_interrupt();
+void deactivate_vm_interrupt();
+void shutdown_vm_interrupt();
+
+/// whether signals can be handled on the calling thread
+POLAR_DECL_EXPORT bool is_vm_signal_thread();
+POLAR_DECL_EXPORT bool add_vm_signal_handler(int signo, VmSignalHandler handler, void *arg);
+POLAR_DECL_EXPORT bool remove_vm_signal_handler(int signo);
+/// async-signal-safe, mark signo pending and interrupt the vm
+POLAR_DECL_EXPORT void raise_vm_interrupt(int signo);
+/// run handlers of pending signals, hosts call it when the vm is idle
+POLAR_DECL_EXPORT bool dispatch_vm_signals();
+
+#ifdef POLAR_OS_LINUX
+///
+/// for embedding hosts that own an event loop, signals in mask are blocked
+/// for the calling thread and delivered through the returned descriptor,
+/// when it becomes readable call drain_vm_signalfd
+///
+POLAR_DECL_EXPORT int open_vm_signalfd(const sigset_t &mask);
+POLAR_DECL_EXPORT bool drain_vm_signalfd(int fd);
+#endif
+
+} // runtime
+} // polar
+
+#endif // POLARPHP_RUNTIME_VM_INTERRUPT_H
@@ -0,0 +1,341 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_RUNTIME_INTERNAL_COMPILED_ZPP_H
+#define POLARPHP_RUNTIME_INTERNAL_COMPILED_ZPP_H
+
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace polar {
+namespace runtime {
+
+///
+/// zend_parse_parameters() with the format string compiled away
+///
+/// POLAR_PARSE_PARAMETERS("S|S", &name, &exts) turns the format into a
+/// descriptor while compiling, so every call site gets its own unrolled
+/// decoder built from the zend_parse_arg_* helpers the fast ZPP macros
+/// use, and a destination of the wrong type is a compile error. the result
+/// and the error reporting are the ones of zend_parse_parameters()
+///
+/// the specifiers are the fixed arity ones: z b l L d S s P p a A h H o r,
+/// each followed by an optional ! or /, and | before the optional ones.
+/// O C f * + still go through zend_parse_parameters()
+///
+enum class ZppKind : uint8_t
+{
+   Zval,
+   Bool,
+   Long,
+   StrictLong,
+   Double,
+   Str,
+   String,
+   PathStr,
+   Path,
+   Array,
+   ArrayOrObject,
+   ArrayHt,
+   ArrayOrObjectHt,
+   Object,
+   Resource
+};
+
+struct ZppSlot
+{
+   ZppKind kind = ZppKind::Zval;
+   bool checkNull = false;
+   bool separate = false;
+   /// the first destination pointer the argument is stored through
+   uint32_t dest = 0;
+};
+
+template <size_t NumSlots>
+struct ZppDescriptor
+{
+   ZppSlot slots[NumSlots > 0 ? NumSlots : 1] = {};
+   uint32_t minArgs = 0;
+   uint32_t numDests = 0;
+};
+
+namespace internal {
+
+/// not constexpr, reaching it while compiling a format is the diagnostic
+void unsupported_zpp_format();
+
+constexpr bool is_zpp_modifier(char c)
+{
+   return c == '|' || c == '!' || c == '/';
+}
+
+constexpr size_t count_zpp_slots(const char *format)
+{
+   size_t count = 0;
+   for (; *format; ++format) {
+      if (!is_zpp_modifier(*format)) {
+         ++count;
+      }
+   }
+   return count;
+}
+
+constexpr ZppKind get_zpp_kind(char spec)
+{
+   switch (spec) {
+   case 'z': return ZppKind::Zval;
+   case 'b': return ZppKind::Bool;
+   case 'l': return ZppKind::Long;
+   case 'L': return ZppKind::StrictLong;
+   case 'd': return ZppKind::Double;
+   case 'S': return ZppKind::Str;
+   case 's': return ZppKind::String;
+   case 'P': return ZppKind::PathStr;
+   case 'p': return ZppKind::Path;
+   case 'a': return ZppKind::Array;
+   case 'A': return ZppKind::ArrayOrObject;
+   case 'h': return ZppKind::ArrayHt;
+   case 'H': return ZppKind::ArrayOrObjectHt;
+   case 'o': return ZppKind::Object;
+   case 'r': return ZppKind::Resource;
+   default:
+      unsupported_zpp_format();
+      return ZppKind::Zval;
+   }
+}
+
+constexpr uint32_t get_zpp_dest_count(const ZppSlot &slot)
+{
+   switch (slot.kind) {
+   case ZppKind::String:
+   case ZppKind::Path:
+      return 2;
+   case ZppKind::Bool:
+   case ZppKind::Long:
+   case ZppKind::StrictLong:
+   case ZppKind::Double:
+      // the is_null flag of b! l! L! d!
+      return slot.checkNull ? 2 : 1;
+   default:
+      return 1;
+   }
+}
+
+template <size_t NumSlots>
+constexpr ZppDescriptor<NumSlots> compile_zpp_format(const char *format)
+{
+   ZppDescriptor<NumSlots> descriptor;
+   size_t count = 0;
+   bool optional = false;
+   descriptor.minArgs = NumSlots;
+   for (; *format; ++format) {
+      char c = *format;
+      if (c == '|') {
+         if (optional) {
+            unsupported_zpp_format();
+         }
+         optional = true;
+         descriptor.minArgs = count;
+      } else if (c == '!' || c == '/') {
+         if (count == 0) {
+            unsupported_zpp_format();
+         }
+         if (c == '!') {
+            descriptor.slots[count - 1].checkNull = true;
+         } else {
+            descriptor.slots[count - 1].separate = true;
+         }
+      } else {
+         descriptor.slots[count++].kind = get_zpp_kind(c);
+      }
+   }
+   for (size_t i = 0; i < NumSlots; ++i) {
+      descriptor.slots[i].dest = descriptor.numDests;
+      descriptor.numDests += get_zpp_dest_count(descriptor.slots[i]);
+   }
+   return descriptor;
+}
+
+template <typename Format>
+struct CompiledZpp
+{
+   static constexpr size_t NumSlots = count_zpp_slots(Format::value());
+   static constexpr ZppDescriptor<NumSlots> descriptor = compile_zpp_format<NumSlots>(Format::value());
+};
+
+struct ZppError
+{
+   uint32_t num = 0;
+   zend_expected_type expected = Z_EXPECTED_LONG;
+   zval *arg = nullptr;
+};
+
+template <typename Dest, typename Expected>
+constexpr void check_zpp_dest()
+{
+   static_assert(std::is_same<Dest, Expected>::value,
+                 "the destination does not match the format specifier");
+}
+
+template <typename Tuple, size_t Index>
+using ZppDestType = typename std::tuple_element<Index, Tuple>::type;
+
+template <typename Compiled, size_t Index, typename Tuple>
+zend_always_inline bool parse_zpp_slot(zval *args, uint32_t numArgs, Tuple &dests, ZppError &error)
+{
+   constexpr ZppSlot slot = Compiled::descriptor.slots[Index];
+   constexpr uint32_t D = slot.dest;
+   if (Index >= Compiled::descriptor.minArgs && Index >= numArgs) {
+      return true;
+   }
+   zval *arg = args + Index;
+   auto &dest = std::get<D>(dests);
+   if constexpr (slot.kind == ZppKind::Zval && !slot.separate) {
+      /// z hands out the argument itself like zend_parse_parameters(), a
+      /// reference is not unwrapped
+      check_zpp_dest<ZppDestType<Tuple, D>, zval **>();
+      zend_parse_arg_zval_deref(arg, dest, slot.checkNull);
+      return true;
+   }
+   ZVAL_DEREF(arg);
+   if (slot.separate) {
+      SEPARATE_ZVAL_NOREF(arg);
+   }
+   error.num = Index + 1;
+   error.arg = arg;
+   if constexpr (slot.kind == ZppKind::Zval) {
+      check_zpp_dest<ZppDestType<Tuple, D>, zval **>();
+      zend_parse_arg_zval_deref(arg, dest, slot.checkNull);
+      return true;
+   } else if constexpr (slot.kind == ZppKind::Bool || slot.kind == ZppKind::Long ||
+                        slot.kind == ZppKind::StrictLong || slot.kind == ZppKind::Double) {
+      zend_bool dummy;
+      zend_bool *isNull = &dummy;
+      if constexpr (slot.checkNull) {
+         check_zpp_dest<ZppDestType<Tuple, D + 1>, zend_bool *>();
+         isNull = std::get<D + 1>(dests);
+      }
+      if constexpr (slot.kind == ZppKind::Bool) {
+         check_zpp_dest<ZppDestType<Tuple, D>, zend_bool *>();
+         error.expected = Z_EXPECTED_BOOL;
+         return zend_parse_arg_bool(arg, dest, isNull, slot.checkNull);
+      } else if constexpr (slot.kind == ZppKind::Double) {
+         check_zpp_dest<ZppDestType<Tuple, D>, double *>();
+         error.expected = Z_EXPECTED_DOUBLE;
+         return zend_parse_arg_double(arg, dest, isNull, slot.checkNull);
+      } else {
+         check_zpp_dest<ZppDestType<Tuple, D>, zend_long *>();
+         error.expected = Z_EXPECTED_LONG;
+         return zend_parse_arg_long(arg, dest, isNull, slot.checkNull,
+                                    slot.kind == ZppKind::StrictLong);
+      }
+   } else if constexpr (slot.kind == ZppKind::Str) {
+      check_zpp_dest<ZppDestType<Tuple, D>, zend_string **>();
+      error.expected = Z_EXPECTED_STRING;
+      return zend_parse_arg_str(arg, dest, slot.checkNull);
+   } else if constexpr (slot.kind == ZppKind::String) {
+      check_zpp_dest<ZppDestType<Tuple, D>, char **>();
+      check_zpp_dest<ZppDestType<Tuple, D + 1>, size_t *>();
+      error.expected = Z_EXPECTED_STRING;
+      return zend_parse_arg_string(arg, dest, std::get<D + 1>(dests), slot.checkNull);
+   } else if constexpr (slot.kind == ZppKind::PathStr) {
+      check_zpp_dest<ZppDestType<Tuple, D>, zend_string **>();
+      error.expected = Z_EXPECTED_PATH;
+      return zend_parse_arg_path_str(arg, dest, slot.checkNull);
+   } else if constexpr (slot.kind == ZppKind::Path) {
+      check_zpp_dest<ZppDestType<Tuple, D>, char **>();
+      check_zpp_dest<ZppDestType<Tuple, D + 1>, size_t *>();
+      error.expected = Z_EXPECTED_PATH;
+      return zend_parse_arg_path(arg, dest, std::get<D + 1>(dests), slot.checkNull);
+   } else if constexpr (slot.kind == ZppKind::Array || slot.kind == ZppKind::ArrayOrObject) {
+      check_zpp_dest<ZppDestType<Tuple, D>, zval **>();
+      error.expected = Z_EXPECTED_ARRAY;
+      return zend_parse_arg_array(arg, dest, slot.checkNull, slot.kind == ZppKind::ArrayOrObject);
+   } else if constexpr (slot.kind == ZppKind::ArrayHt || slot.kind == ZppKind::ArrayOrObjectHt) {
+      check_zpp_dest<ZppDestType<Tuple, D>, HashTable **>();
+      error.expected = Z_EXPECTED_ARRAY;
+      return zend_parse_arg_array_ht(arg, dest, slot.checkNull, slot.kind == ZppKind::ArrayOrObjectHt,
+                                     slot.separate);
+   } else if constexpr (slot.kind == ZppKind::Object) {
+      check_zpp_dest<ZppDestType<Tuple, D>, zval **>();
+      error.expected = Z_EXPECTED_OBJECT;
+      return zend_parse_arg_object(arg, dest, nullptr, slot.checkNull);
+   } else {
+      check_zpp_dest<ZppDestType<Tuple, D>, zval **>();
+      error.expected = Z_EXPECTED_RESOURCE;
+      return zend_parse_arg_resource(arg, dest, slot.checkNull);
+   }
+}
+
+template <typename Compiled, typename Tuple, size_t... Indexes>
+zend_always_inline bool parse_zpp_slots(zend_execute_data *execute_data, uint32_t numArgs, Tuple &dests,
+                                        ZppError &error, std::index_sequence<Indexes...>)
+{
+   zval *args = ZEND_CALL_ARG(execute_data, 1);
+   (void) args;
+   return (parse_zpp_slot<Compiled, Indexes>(args, numArgs, dests, error) && ...);
+}
+
+/// the reporting of ZEND_PARSE_PARAMETERS_END(), kept out of line
+POLAR_DECL_EXPORT ZEND_COLD void report_zpp_error(int flags, const ZppError &error);
+POLAR_DECL_EXPORT ZEND_COLD void report_zpp_count_error(int flags, uint32_t minArgs, uint32_t maxArgs);
+
+} // internal
+
+template <typename Format, typename ...Dests>
+zend_always_inline int parse_parameters(Format, int flags, zend_execute_data *execute_data, Dests ...dests)
+{
+   using Compiled = internal::CompiledZpp<Format>;
+   static_assert(Compiled::descriptor.numDests == sizeof...(Dests),
+                 "the number of destinations does not match the format");
+   uint32_t numArgs = ZEND_CALL_NUM_ARGS(execute_data);
+   if (UNEXPECTED(numArgs < Compiled::descriptor.minArgs || numArgs > Compiled::NumSlots)) {
+      internal::report_zpp_count_error(flags, Compiled::descriptor.minArgs, Compiled::NumSlots);
+      return FAILURE;
+   }
+   std::tuple<Dests...> destinations(dests...);
+   internal::ZppError error;
+   if (UNEXPECTED(!internal::parse_zpp_slots<Compiled>(execute_data, numArgs, destinations, error,
+                                                       std::make_index_sequence<Compiled::NumSlots>()))) {
+      internal::report_zpp_error(flags, error);
+      return FAILURE;
+   }
+   return SUCCESS;
+}
+
+} // runtime
+} // polar
+
+/// a type unique to the call site that hands out the format, the lambda
+/// keeps it local to the expression
+#define POLAR_ZPP_FORMAT(format) \
+   [] { \
+      struct ZppFormat \
+      { \
+         static constexpr const char *value() \
+         { \
+            return format; \
+         } \
+      }; \
+      return ZppFormat{}; \
+   }()
+
+#define POLAR_PARSE_PARAMETERS_EX(flags, format, ...) \
+   ::polar::runtime::parse_parameters(POLAR_ZPP_FORMAT(format), (flags), execute_data, __VA_ARGS__)
+
+#define POLAR_PARSE_PARAMETERS(format, ...) \
+   POLAR_PARSE_PARAMETERS_EX(0, format, __VA_ARGS__)
+
+#endif // POLARPHP_RUNTIME_INTERNAL_COMPILED_ZPP_H
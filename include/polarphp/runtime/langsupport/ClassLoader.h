@@ -18,7 +18,7 @@
 namespace polar {
 namespace runtime {
 
-#define CLASS_LOADER_G(v) retrieve_classloader_module_data().v
+#define CLASS_LOADER_G(v) ZEND_STATIC_MODULE_GLOBALS_ACCESSOR(classloader, v)
 
 #define RT_REGISTER_STD_CLASS(class_name, obj_ctor) \
    register_std_class(&g_ ## class_name, const_cast<char *>(# class_name), obj_ctor, NULL);
@@ -54,6 +54,10 @@ struct ClassLoaderModuleData
    HashTable    *autoloadFunctions;
 };
 
+using zend_classloader_globals = ClassLoaderModuleData;
+
+POLAR_DECL_EXPORT ZEND_EXTERN_STATIC_MODULE_GLOBALS(classloader)
+
 using CreateObjectFuncType = zend_object* (*)(zend_class_entry *classType);
 
 extern zend_module_entry g_classLoaderModuleEntry;
@@ -85,6 +89,7 @@ PHP_FUNCTION(register_class_loader);
 PHP_FUNCTION(unregister_class_loader);
 PHP_FUNCTION(object_hash);
 PHP_FUNCTION(object_id);
+PHP_FUNCTION(prefetch_include_files);
 
 ClassLoaderModuleData &retrieve_classloader_module_data();
 
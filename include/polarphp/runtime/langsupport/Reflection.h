@@ -15,6 +15,11 @@
 #include "polarphp/runtime/RtDefs.h"
 
 namespace polar {
+
+namespace markup {
+class DocCommentCache;
+} // markup
+
 namespace runtime {
 
 #define PHP_REFLECTION_VERSION POLARPHP_VERSION
@@ -36,6 +41,9 @@ extern POLAR_DECL_EXPORT zend_class_entry *g_reflectionMethodPtr;
 extern POLAR_DECL_EXPORT zend_class_entry *g_reflectionPropertyPtr;
 POLAR_DECL_EXPORT void zend_reflection_class_factory(zend_class_entry *ce, zval *object);
 POLAR_DECL_EXPORT bool register_reflection_module();
+/// the parses of this thread's request doc comments, what getDocCommentTags()
+/// asks for when the comment is not a permanent string
+POLAR_DECL_EXPORT const markup::DocCommentCache &retrieve_request_doc_comments();
 
 } // runtime
 } // polar
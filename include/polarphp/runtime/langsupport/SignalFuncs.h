@@ -0,0 +1,29 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/06.
+
+#ifndef POLARPHP_RUNTIME_LANG_SUPPORT_SIGNAL_FUNCS_H
+#define POLARPHP_RUNTIME_LANG_SUPPORT_SIGNAL_FUNCS_H
+
+#include "polarphp/runtime/RtDefs.h"
+
+namespace polar {
+namespace runtime {
+
+PHP_MINIT_FUNCTION(signal);
+PHP_RSHUTDOWN_FUNCTION(signal);
+PHP_FUNCTION(register_signal_handler);
+PHP_FUNCTION(unregister_signal_handler);
+PHP_FUNCTION(dispatch_signals);
+
+} // runtime
+} // polar
+
+#endif // POLARPHP_RUNTIME_LANG_SUPPORT_SIGNAL_FUNCS_H
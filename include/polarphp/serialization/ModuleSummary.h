@@ -0,0 +1,183 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_SERIALIZATION_MODULE_SUMMARY_H
+#define POLARPHP_SERIALIZATION_MODULE_SUMMARY_H
+
+#include "polarphp/basic/adt/ArrayRef.h"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/parser/ProjectParser.h"
+#include "polarphp/serialization/ModuleSummaryFormat.h"
+#include "polarphp/utils/Error.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace polar::utils {
+class BinaryStreamWriter;
+class MemoryBuffer;
+} // polar::utils
+
+namespace polar::serialization {
+
+using polar::basic::ArrayRef;
+using polar::basic::StringRef;
+using polar::parser::IndexedDecl;
+using polar::parser::IndexedDeclKind;
+using polar::parser::ParseResultCache;
+using polar::parser::ProjectDiagnostic;
+using polar::utils::BinaryStreamWriter;
+using polar::utils::Error;
+using polar::utils::Expected;
+using polar::utils::MemoryBuffer;
+
+///
+/// collects the parse results of files and writes them as one summary, the
+/// strings are pooled so repeated paths, messages and doc comments are
+/// stored once
+///
+class ModuleSummaryWriter
+{
+public:
+   void addFile(StringRef path, uint64_t contentHash, ArrayRef<IndexedDecl> decls,
+                ArrayRef<ProjectDiagnostic> diagnostics);
+
+   unsigned getNumFiles() const
+   {
+      return m_files.size();
+   }
+
+   Error write(BinaryStreamWriter &writer) const;
+
+   /// writes next to path first and renames, a reader of the old summary
+   /// never sees a half written file
+   Error writeToFile(StringRef path) const;
+
+private:
+   struct FileEntry
+   {
+      std::string path;
+      uint64_t contentHash;
+      std::vector<IndexedDecl> decls;
+      std::vector<ProjectDiagnostic> diagnostics;
+   };
+
+   std::vector<FileEntry> m_files;
+};
+
+///
+/// a summary used in place, opening it checks the header and the table
+/// sizes only, a file or a single declaration is decoded when it is asked
+/// for, so a project that touches a handful of files pays for those alone
+///
+class ModuleSummaryReader
+{
+public:
+   static Expected<std::unique_ptr<ModuleSummaryReader>> open(StringRef path);
+   static Expected<std::unique_ptr<ModuleSummaryReader>> create(std::unique_ptr<MemoryBuffer> buffer);
+
+   ~ModuleSummaryReader();
+
+   unsigned getNumFiles() const
+   {
+      return m_files.size();
+   }
+
+   unsigned getNumDecls() const
+   {
+      return m_decls.size();
+   }
+
+   StringRef getFilePath(unsigned summaryFile) const;
+
+   uint64_t getContentHash(unsigned summaryFile) const
+   {
+      return m_files[summaryFile].contentHash;
+   }
+
+   /// binary search over the sorted file table
+   std::optional<unsigned> findFile(StringRef path) const;
+
+   /// decodes the declarations and diagnostics of one file, fileIndex is
+   /// what the results are tagged with
+   void readFile(unsigned summaryFile, unsigned fileIndex, std::vector<IndexedDecl> &decls,
+                 std::vector<ProjectDiagnostic> &diagnostics) const;
+
+   /// decodes a single declaration, its fileIndex is the summary file
+   IndexedDecl getDecl(unsigned declIndex) const;
+
+   /// the first declaration of qualifiedName, a class like kind matches any
+   /// class, interface or trait, names compare the way php compares them
+   std::optional<IndexedDecl> lookupDecl(StringRef qualifiedName, IndexedDeclKind kind) const;
+
+private:
+   explicit ModuleSummaryReader(std::unique_ptr<MemoryBuffer> buffer);
+   Error initialize();
+   StringRef getString(const summary::StringRecord &record) const;
+   IndexedDecl decodeDecl(const summary::DeclRecord &record, unsigned fileIndex) const;
+
+private:
+   std::unique_ptr<MemoryBuffer> m_buffer;
+   ArrayRef<summary::FileRecord> m_files;
+   ArrayRef<summary::DeclRecord> m_decls;
+   ArrayRef<summary::DiagnosticRecord> m_diagnostics;
+   ArrayRef<summary::NameIndexEntry> m_nameIndex;
+   StringRef m_strings;
+};
+
+///
+/// a ParseResultCache backed by the summary of the previous run, files
+/// whose content hash still matches are read from it instead of parsed,
+/// everything the parser stores goes into the summary written by save
+///
+class ModuleSummaryCache : public ParseResultCache
+{
+public:
+   /// a missing, stale or damaged summary is not an error, every file is
+   /// simply parsed again
+   explicit ModuleSummaryCache(StringRef summaryPath);
+   ~ModuleSummaryCache() override;
+
+   bool lookup(StringRef path, uint64_t contentHash, unsigned fileIndex,
+               std::vector<IndexedDecl> &decls,
+               std::vector<ProjectDiagnostic> &diagnostics) override;
+
+   void store(StringRef path, uint64_t contentHash, ArrayRef<IndexedDecl> decls,
+              ArrayRef<ProjectDiagnostic> diagnostics) override;
+
+   /// writes the stored results, files not stored since the cache was
+   /// opened are left out
+   Error save() const;
+
+   /// the summary of the previous run, null if there was none
+   const ModuleSummaryReader *getPreviousSummary() const
+   {
+      return m_previous.get();
+   }
+
+   unsigned getNumHits() const
+   {
+      return m_numHits;
+   }
+
+private:
+   std::string m_path;
+   std::unique_ptr<ModuleSummaryReader> m_previous;
+   ModuleSummaryWriter m_writer;
+   std::atomic<unsigned> m_numHits{0};
+};
+
+} // polar::serialization
+
+#endif // POLARPHP_SERIALIZATION_MODULE_SUMMARY_H
@@ -0,0 +1,110 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_SERIALIZATION_MODULE_SUMMARY_FORMAT_H
+#define POLARPHP_SERIALIZATION_MODULE_SUMMARY_FORMAT_H
+
+#include "polarphp/utils/Endian.h"
+
+#include <cstdint>
+
+///
+/// the on disk layout of a module summary, every field is little endian and
+/// unaligned so the tables can be used in place from a mapped file:
+///
+///   SummaryHeader
+///   FileRecord[fileCount]          sorted by path
+///   DeclRecord[declCount]          grouped by file, in source order
+///   DiagnosticRecord[diagnosticCount]
+///   NameIndexEntry[declCount]      sorted by name hash
+///   string table, stringTableSize bytes
+///
+namespace polar::serialization::summary {
+
+using polar::utils::ulittle32_t;
+using polar::utils::ulittle64_t;
+
+/// "PSUM"
+constexpr char SUMMARY_MAGIC[4] = {'P', 'S', 'U', 'M'};
+/// bump on any change to the records below or to what the parser reports
+constexpr std::uint32_t SUMMARY_VERSION = 1;
+
+/// a slice of the string table
+struct StringRecord
+{
+   ulittle32_t offset;
+   ulittle32_t size;
+};
+
+struct SummaryHeader
+{
+   char magic[4];
+   ulittle32_t version;
+   ulittle32_t fileCount;
+   ulittle32_t declCount;
+   ulittle32_t diagnosticCount;
+   ulittle32_t stringTableSize;
+};
+
+struct FileRecord
+{
+   StringRecord path;
+   ulittle64_t contentHash;
+   ulittle32_t firstDecl;
+   ulittle32_t declCount;
+   ulittle32_t firstDiagnostic;
+   ulittle32_t diagnosticCount;
+};
+
+struct DeclRecord
+{
+   /// IndexedDeclKind
+   std::uint8_t kind;
+   std::uint8_t reserved[3];
+   /// index into the file table
+   ulittle32_t file;
+   ulittle32_t offset;
+   ulittle32_t line;
+   ulittle32_t column;
+   StringRecord name;
+   StringRecord signature;
+   StringRecord docComment;
+};
+
+struct DiagnosticRecord
+{
+   /// ProjectDiagnosticKind
+   std::uint8_t kind;
+   std::uint8_t reserved[3];
+   ulittle32_t offset;
+   ulittle32_t line;
+   ulittle32_t column;
+   StringRecord message;
+};
+
+/// the hash is taken over the lower cased name, so one probe finds a class
+/// or function whatever case it is spelled in
+struct NameIndexEntry
+{
+   ulittle64_t nameHash;
+   ulittle32_t decl;
+   ulittle32_t reserved;
+};
+
+static_assert(sizeof(SummaryHeader) == 24, "summary header is not packed");
+static_assert(sizeof(FileRecord) == 32, "file record is not packed");
+static_assert(sizeof(DeclRecord) == 44, "decl record is not packed");
+static_assert(sizeof(DiagnosticRecord) == 24, "diagnostic record is not packed");
+static_assert(sizeof(NameIndexEntry) == 16, "name index entry is not packed");
+
+} // polar::serialization::summary
+
+#endif // POLARPHP_SERIALIZATION_MODULE_SUMMARY_FORMAT_H
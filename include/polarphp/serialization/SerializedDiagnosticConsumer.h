@@ -0,0 +1,58 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTIC_CONSUMER_H
+#define POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTIC_CONSUMER_H
+
+#include "polarphp/ast/DiagnosticConsumer.h"
+#include "polarphp/serialization/SerializedDiagnostics.h"
+
+#include <optional>
+#include <string>
+
+namespace polar::serialization {
+
+using polar::ast::DiagnosticArgument;
+using polar::ast::DiagnosticConsumer;
+using polar::ast::DiagnosticInfo;
+using polar::ast::DiagnosticKind;
+using polar::parser::CharSourceRange;
+using polar::parser::SourceLoc;
+using polar::parser::SourceManager;
+
+///
+/// writes every diagnostic it receives, rendered and with resolved
+/// locations, to a diagnostics file that tools read back through
+/// SerializedDiagnosticsReader; the file is written by finishProcessing
+///
+class SerializedDiagnosticConsumer : public DiagnosticConsumer
+{
+public:
+   explicit SerializedDiagnosticConsumer(StringRef outputPath);
+
+   void handleDiagnostic(SourceManager &sourceMgr, SourceLoc loc,
+                         DiagnosticKind kind, StringRef formatString,
+                         ArrayRef<DiagnosticArgument> formatArgs,
+                         const DiagnosticInfo &info) override;
+
+   /// \returns true if the file could not be written.
+   bool finishProcessing() override;
+
+private:
+   std::string m_outputPath;
+   SerializedDiagnosticsWriter m_writer;
+   /// the last error, warning or remark, the parent of the notes after it
+   std::optional<unsigned> m_lastParent;
+};
+
+} // polar::serialization
+
+#endif // POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTIC_CONSUMER_H
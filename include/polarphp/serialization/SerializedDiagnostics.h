@@ -0,0 +1,133 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTICS_H
+#define POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTICS_H
+
+#include "polarphp/basic/adt/ArrayRef.h"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/serialization/SerializedDiagnosticsFormat.h"
+#include "polarphp/utils/Error.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace polar::utils {
+class BinaryStreamWriter;
+class MemoryBuffer;
+} // polar::utils
+
+namespace polar::serialization {
+
+using polar::basic::ArrayRef;
+using polar::basic::StringRef;
+using polar::serialization::diagnostics::SerializedDiagnosticKind;
+using polar::utils::BinaryStreamWriter;
+using polar::utils::Error;
+using polar::utils::Expected;
+using polar::utils::MemoryBuffer;
+
+/// 1 based lines and columns, columns count bytes
+struct SerializedSourceRange
+{
+   unsigned startLine = 0;
+   unsigned startColumn = 0;
+   unsigned endLine = 0;
+   unsigned endColumn = 0;
+};
+
+struct SerializedFixIt
+{
+   SerializedSourceRange range;
+   std::string text;
+};
+
+/// a rendered diagnostic, the file is empty and line and column are zero
+/// when it has no location
+struct SerializedDiagnostic
+{
+   SerializedDiagnosticKind kind = SerializedDiagnosticKind::Error;
+   uint32_t id = 0;
+   /// index of the diagnostic a note is attached to
+   std::optional<unsigned> parent;
+   std::string file;
+   unsigned line = 0;
+   unsigned column = 0;
+   std::string message;
+   std::vector<SerializedSourceRange> ranges;
+   std::vector<SerializedFixIt> fixIts;
+};
+
+///
+/// collects diagnostics in emission order and writes them as one file,
+/// file names and repeated messages are stored once
+///
+class SerializedDiagnosticsWriter
+{
+public:
+   /// returns the index the diagnostic is written at
+   unsigned addDiagnostic(SerializedDiagnostic diagnostic);
+
+   unsigned getNumDiagnostics() const
+   {
+      return m_diagnostics.size();
+   }
+
+   Error write(BinaryStreamWriter &writer) const;
+
+   /// writes next to path first and renames, so a tool watching path never
+   /// reads a half written file
+   Error writeToFile(StringRef path) const;
+
+private:
+   std::vector<SerializedDiagnostic> m_diagnostics;
+};
+
+///
+/// a diagnostics file used in place, a diagnostic is decoded when it is
+/// asked for
+///
+class SerializedDiagnosticsReader
+{
+public:
+   static Expected<std::unique_ptr<SerializedDiagnosticsReader>> open(StringRef path);
+   static Expected<std::unique_ptr<SerializedDiagnosticsReader>>
+   create(std::unique_ptr<MemoryBuffer> buffer);
+
+   ~SerializedDiagnosticsReader();
+
+   unsigned getNumDiagnostics() const
+   {
+      return m_diagnostics.size();
+   }
+
+   SerializedDiagnosticKind getKind(unsigned index) const;
+
+   SerializedDiagnostic getDiagnostic(unsigned index) const;
+
+private:
+   explicit SerializedDiagnosticsReader(std::unique_ptr<MemoryBuffer> buffer);
+   Error initialize();
+   StringRef getString(const diagnostics::StringRecord &record) const;
+
+private:
+   std::unique_ptr<MemoryBuffer> m_buffer;
+   ArrayRef<diagnostics::DiagnosticRecord> m_diagnostics;
+   ArrayRef<diagnostics::RangeRecord> m_ranges;
+   ArrayRef<diagnostics::FixItRecord> m_fixIts;
+   StringRef m_strings;
+};
+
+} // polar::serialization
+
+#endif // POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTICS_H
@@ -0,0 +1,110 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTICS_FORMAT_H
+#define POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTICS_FORMAT_H
+
+#include "polarphp/utils/Endian.h"
+
+#include <cstdint>
+
+///
+/// the on disk layout of a diagnostics file written for tools, every field
+/// is little endian and unaligned so the tables can be used in place:
+///
+///   DiagnosticsHeader
+///   DiagnosticRecord[diagnosticCount]   in emission order
+///   RangeRecord[rangeCount]
+///   FixItRecord[fixItCount]
+///   string table, stringTableSize bytes
+///
+namespace polar::serialization::diagnostics {
+
+using polar::utils::ulittle32_t;
+
+/// "PDIA"
+constexpr char DIAGNOSTICS_MAGIC[4] = {'P', 'D', 'I', 'A'};
+constexpr std::uint32_t DIAGNOSTICS_VERSION = 1;
+
+/// no diagnostic, the parent of an error, warning or remark
+constexpr std::uint32_t NO_PARENT = ~std::uint32_t(0);
+
+/// the kinds of polar::ast::DiagnosticKind, kept apart so readers do not
+/// need the ast library
+enum class SerializedDiagnosticKind : std::uint8_t
+{
+   Error,
+   Warning,
+   Remark,
+   Note
+};
+
+/// a slice of the string table
+struct StringRecord
+{
+   ulittle32_t offset;
+   ulittle32_t size;
+};
+
+struct DiagnosticsHeader
+{
+   char magic[4];
+   ulittle32_t version;
+   ulittle32_t diagnosticCount;
+   ulittle32_t rangeCount;
+   ulittle32_t fixItCount;
+   ulittle32_t stringTableSize;
+};
+
+/// 1 based lines and columns, columns count bytes, all zero when the
+/// diagnostic has no location
+struct RangeRecord
+{
+   ulittle32_t startLine;
+   ulittle32_t startColumn;
+   ulittle32_t endLine;
+   ulittle32_t endColumn;
+};
+
+struct DiagnosticRecord
+{
+   /// SerializedDiagnosticKind
+   std::uint8_t kind;
+   std::uint8_t reserved[3];
+   /// the polar::ast::DiagID
+   ulittle32_t id;
+   /// index of the diagnostic a note is attached to, NO_PARENT otherwise
+   ulittle32_t parent;
+   StringRecord file;
+   ulittle32_t line;
+   ulittle32_t column;
+   StringRecord message;
+   ulittle32_t firstRange;
+   ulittle32_t rangeCount;
+   ulittle32_t firstFixIt;
+   ulittle32_t fixItCount;
+};
+
+/// ranges and fix-its are in the file of their diagnostic
+struct FixItRecord
+{
+   RangeRecord range;
+   StringRecord text;
+};
+
+static_assert(sizeof(DiagnosticsHeader) == 24, "diagnostics header is not packed");
+static_assert(sizeof(RangeRecord) == 16, "range record is not packed");
+static_assert(sizeof(DiagnosticRecord) == 52, "diagnostic record is not packed");
+static_assert(sizeof(FixItRecord) == 24, "fix-it record is not packed");
+
+} // polar::serialization::diagnostics
+
+#endif // POLARPHP_SERIALIZATION_SERIALIZED_DIAGNOSTICS_FORMAT_H
@@ -0,0 +1,67 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_ATOMIC_CACHE_H
+#define POLARPHP_SYNTAX_ATOMIC_CACHE_H
+
+#include "polarphp/basic/adt/StlExtras.h"
+
+#include <atomic>
+
+namespace polar::syntax {
+
+using polar::basic::FunctionRef;
+
+///
+/// a slot that is filled at most once and owns what it holds, several
+/// threads may race to fill it, the loser deletes its value and uses the
+/// winner's, readers never take a lock
+///
+template <typename T>
+class AtomicCache
+{
+public:
+   AtomicCache() = default;
+   AtomicCache(const AtomicCache &) = delete;
+   AtomicCache &operator=(const AtomicCache &) = delete;
+
+   ~AtomicCache()
+   {
+      delete m_storage.load(std::memory_order_acquire);
+   }
+
+   T *get() const
+   {
+      return m_storage.load(std::memory_order_acquire);
+   }
+
+   T *getOrCreate(FunctionRef<T *()> create) const
+   {
+      T *existing = m_storage.load(std::memory_order_acquire);
+      if (existing) {
+         return existing;
+      }
+      T *created = create();
+      if (m_storage.compare_exchange_strong(existing, created, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+         return created;
+      }
+      delete created;
+      return existing;
+   }
+
+private:
+   mutable std::atomic<T *> m_storage{nullptr};
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_ATOMIC_CACHE_H
@@ -0,0 +1,151 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_RAW_SYNTAX_H
+#define POLARPHP_SYNTAX_RAW_SYNTAX_H
+
+#include "polarphp/basic/adt/ArrayRef.h"
+#include "polarphp/syntax/SyntaxArena.h"
+#include "polarphp/syntax/SyntaxKind.h"
+#include "polarphp/syntax/TokenKinds.h"
+#include "polarphp/syntax/Trivia.h"
+
+namespace polar::utils {
+class RawOutStream;
+} // polar::utils
+
+namespace polar::syntax {
+
+using polar::basic::ArrayRef;
+using polar::utils::RawOutStream;
+
+///
+/// the green tree, a raw node knows its kind, its children (or its text
+/// for a token) and its full width, but neither its parent nor its
+/// position, so an unchanged subtree can be shared by any number of trees.
+/// raw nodes are immutable and allocated in a SyntaxArena, "changing" one
+/// means building a new node that points to the old children
+///
+class alignas(void *) RawSyntax
+{
+public:
+   RawSyntax(const RawSyntax &) = delete;
+   RawSyntax &operator=(const RawSyntax &) = delete;
+
+   static const RawSyntax *makeToken(SyntaxArena &arena, TokenKindType tokenKind,
+                                     StringRef text, StringRef leadingTrivia);
+   static const RawSyntax *makeLayout(SyntaxArena &arena, SyntaxKind kind,
+                                      ArrayRef<const RawSyntax *> children);
+
+   SyntaxKind getKind() const
+   {
+      return m_kind;
+   }
+
+   bool isToken() const
+   {
+      return m_kind == SyntaxKind::Token;
+   }
+
+   bool is(SyntaxKind kind) const
+   {
+      return m_kind == kind;
+   }
+
+   TokenKindType getTokenKind() const
+   {
+      assert(isToken() && "not a token");
+      return m_tokenKind;
+   }
+
+   StringRef getTokenText() const
+   {
+      assert(isToken() && "not a token");
+      return m_text;
+   }
+
+   Trivia getLeadingTrivia() const
+   {
+      assert(isToken() && "not a token");
+      return Trivia(m_leadingTrivia);
+   }
+
+   unsigned getNumChildren() const
+   {
+      return m_numChildren;
+   }
+
+   ArrayRef<const RawSyntax *> getChildren() const
+   {
+      return ArrayRef<const RawSyntax *>(getChildrenStorage(), m_numChildren);
+   }
+
+   const RawSyntax *getChild(unsigned index) const
+   {
+      assert(index < m_numChildren && "child index out of range");
+      return getChildrenStorage()[index];
+   }
+
+   /// bytes covered by the node, trivia included
+   unsigned getTextLength() const
+   {
+      return m_textLength;
+   }
+
+   unsigned getTokenCount() const
+   {
+      return m_tokenCount;
+   }
+
+   /// the first and last token of the subtree, null for an empty layout
+   const RawSyntax *getFirstToken() const;
+   const RawSyntax *getLastToken() const;
+
+   /// a copy of this layout with child index replaced, the other children
+   /// are shared
+   const RawSyntax *replaceChild(SyntaxArena &arena, unsigned index,
+                                 const RawSyntax *newChild) const;
+
+   /// print the source text back, byte for byte
+   void print(RawOutStream &out) const;
+   void dump(RawOutStream &out, unsigned indent = 0) const;
+   void dump() const;
+
+private:
+   RawSyntax(SyntaxKind kind, TokenKindType tokenKind, unsigned numChildren)
+      : m_kind(kind),
+        m_tokenKind(tokenKind),
+        m_numChildren(numChildren)
+   {}
+
+   const RawSyntax *const *getChildrenStorage() const
+   {
+      return reinterpret_cast<const RawSyntax *const *>(this + 1);
+   }
+
+   const RawSyntax **getChildrenStorage()
+   {
+      return reinterpret_cast<const RawSyntax **>(this + 1);
+   }
+
+private:
+   SyntaxKind m_kind;
+   TokenKindType m_tokenKind;
+   unsigned m_numChildren;
+   unsigned m_textLength = 0;
+   unsigned m_tokenCount = 0;
+   StringRef m_leadingTrivia;
+   StringRef m_text;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_RAW_SYNTAX_H
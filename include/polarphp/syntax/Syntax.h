@@ -0,0 +1,139 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_SYNTAX_H
+#define POLARPHP_SYNTAX_SYNTAX_H
+
+#include "polarphp/syntax/SyntaxData.h"
+
+#include <optional>
+#include <string>
+
+namespace polar::syntax {
+
+///
+/// the handle tooling works with, a node of the red tree plus a reference
+/// to its root so the node stays valid as long as the handle does
+///
+class Syntax
+{
+public:
+   Syntax(IntrusiveRefCountPtr<SyntaxData> root, const SyntaxData *data)
+      : m_root(std::move(root)),
+        m_data(data)
+   {}
+
+   static Syntax makeRoot(const RawSyntax *raw, IntrusiveRefCountPtr<SyntaxArena> arena)
+   {
+      IntrusiveRefCountPtr<SyntaxData> root = SyntaxData::makeRoot(raw, std::move(arena));
+      const SyntaxData *data = root.get();
+      return Syntax(std::move(root), data);
+   }
+
+   SyntaxKind getKind() const
+   {
+      return m_data->getKind();
+   }
+
+   bool is(SyntaxKind kind) const
+   {
+      return getKind() == kind;
+   }
+
+   bool isToken() const
+   {
+      return m_data->getRaw()->isToken();
+   }
+
+   TokenKindType getTokenKind() const
+   {
+      return m_data->getRaw()->getTokenKind();
+   }
+
+   StringRef getTokenText() const
+   {
+      return m_data->getRaw()->getTokenText();
+   }
+
+   const RawSyntax *getRaw() const
+   {
+      return m_data->getRaw();
+   }
+
+   const SyntaxData *getData() const
+   {
+      return m_data;
+   }
+
+   Syntax getRoot() const
+   {
+      return Syntax(m_root, m_root.get());
+   }
+
+   bool isRoot() const
+   {
+      return m_data->isRoot();
+   }
+
+   std::optional<Syntax> getParent() const;
+
+   unsigned getNumChildren() const
+   {
+      return m_data->getNumChildren();
+   }
+
+   Syntax getChild(unsigned index) const
+   {
+      return Syntax(m_root, m_data->getChild(index));
+   }
+
+   unsigned getOffset() const
+   {
+      return m_data->getOffset();
+   }
+
+   unsigned getEndOffset() const
+   {
+      return m_data->getEndOffset();
+   }
+
+   unsigned getTextOffset() const
+   {
+      return m_data->getTextOffset();
+   }
+
+   std::optional<Syntax> findTokenAt(unsigned offset) const;
+
+   void print(RawOutStream &out) const
+   {
+      m_data->getRaw()->print(out);
+   }
+
+   std::string getSourceText() const;
+
+   void dump() const
+   {
+      m_data->getRaw()->dump();
+   }
+
+   bool isSameNode(const Syntax &other) const
+   {
+      return m_data == other.m_data;
+   }
+
+private:
+   IntrusiveRefCountPtr<SyntaxData> m_root;
+   const SyntaxData *m_data;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_SYNTAX_H
@@ -0,0 +1,73 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_SYNTAX_ARENA_H
+#define POLARPHP_SYNTAX_SYNTAX_ARENA_H
+
+#include "polarphp/basic/adt/IntrusiveRefCountPtr.h"
+#include "polarphp/basic/adt/StringRef.h"
+#include "polarphp/utils/Allocator.h"
+
+#include <cstring>
+
+namespace polar::syntax {
+
+using polar::basic::IntrusiveRefCountPtr;
+using polar::basic::StringRef;
+using polar::basic::ThreadSafeRefCountedBase;
+
+///
+/// raw syntax nodes and the text of their tokens live in an arena, they
+/// are never freed one by one, the whole arena goes away when the last tree
+/// referencing it is released. incremental reparsing allocates the new
+/// nodes into the arena of the old tree, so the unchanged subtrees can be
+/// shared, a tool that edits a file for a long time should parse it from
+/// scratch into a fresh arena now and then to drop the dead nodes
+///
+class SyntaxArena : public ThreadSafeRefCountedBase<SyntaxArena>
+{
+public:
+   SyntaxArena() = default;
+   SyntaxArena(const SyntaxArena &) = delete;
+   SyntaxArena &operator=(const SyntaxArena &) = delete;
+
+   static IntrusiveRefCountPtr<SyntaxArena> make()
+   {
+      return IntrusiveRefCountPtr<SyntaxArena>(new SyntaxArena);
+   }
+
+   void *allocate(std::size_t size, std::size_t alignment)
+   {
+      return m_allocator.allocate(size, alignment);
+   }
+
+   StringRef copyText(StringRef text)
+   {
+      if (text.empty()) {
+         return StringRef();
+      }
+      char *data = static_cast<char *>(m_allocator.allocate(text.size(), 1));
+      std::memcpy(data, text.data(), text.size());
+      return StringRef(data, text.size());
+   }
+
+   std::size_t getTotalMemory() const
+   {
+      return m_allocator.getTotalMemory();
+   }
+
+private:
+   polar::utils::BumpPtrAllocator m_allocator;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_SYNTAX_ARENA_H
@@ -0,0 +1,108 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_SYNTAX_DATA_H
+#define POLARPHP_SYNTAX_SYNTAX_DATA_H
+
+#include "polarphp/syntax/AtomicCache.h"
+#include "polarphp/syntax/RawSyntax.h"
+
+#include <memory>
+
+namespace polar::syntax {
+
+///
+/// the red tree, a SyntaxData wraps a raw node with what only makes sense
+/// in one particular tree: the parent and the absolute offset. red nodes
+/// are created on demand when a child is first asked for and cached in the
+/// parent, only the root is reference counted, it owns the whole red tree
+/// and keeps the arena of the raw tree alive
+///
+class SyntaxData : public ThreadSafeRefCountedBase<SyntaxData>
+{
+public:
+   static IntrusiveRefCountPtr<SyntaxData> makeRoot(const RawSyntax *raw,
+                                                    IntrusiveRefCountPtr<SyntaxArena> arena);
+
+   SyntaxData(const SyntaxData &) = delete;
+   SyntaxData &operator=(const SyntaxData &) = delete;
+
+   const RawSyntax *getRaw() const
+   {
+      return m_raw;
+   }
+
+   SyntaxKind getKind() const
+   {
+      return m_raw->getKind();
+   }
+
+   const SyntaxData *getParent() const
+   {
+      return m_parent;
+   }
+
+   bool isRoot() const
+   {
+      return m_parent == nullptr;
+   }
+
+   unsigned getIndexInParent() const
+   {
+      return m_indexInParent;
+   }
+
+   unsigned getNumChildren() const
+   {
+      return m_raw->getNumChildren();
+   }
+
+   /// the red node of child index, created the first time it is asked for
+   const SyntaxData *getChild(unsigned index) const;
+
+   /// offset of the node in the source, leading trivia included
+   unsigned getOffset() const
+   {
+      return m_offset;
+   }
+
+   unsigned getEndOffset() const
+   {
+      return m_offset + m_raw->getTextLength();
+   }
+
+   /// offset of the first token's text, after its leading trivia
+   unsigned getTextOffset() const;
+
+   /// the deepest token whose range (trivia included) contains offset
+   const SyntaxData *findTokenAt(unsigned offset) const;
+
+   IntrusiveRefCountPtr<SyntaxArena> getArena() const;
+
+   ~SyntaxData();
+
+private:
+   SyntaxData(const RawSyntax *raw, const SyntaxData *parent, unsigned indexInParent,
+              unsigned offset);
+
+private:
+   const RawSyntax *m_raw;
+   const SyntaxData *m_parent;
+   unsigned m_indexInParent;
+   unsigned m_offset;
+   std::unique_ptr<AtomicCache<SyntaxData>[]> m_children;
+   /// set on the root only
+   IntrusiveRefCountPtr<SyntaxArena> m_arena;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_SYNTAX_DATA_H
@@ -0,0 +1,59 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_SYNTAX_FACTORY_H
+#define POLARPHP_SYNTAX_SYNTAX_FACTORY_H
+
+#include "polarphp/syntax/Syntax.h"
+
+namespace polar::syntax {
+
+///
+/// builds raw nodes into one arena, token text and trivia are copied so
+/// the tree does not depend on the lifetime of the source buffer
+///
+class SyntaxFactory
+{
+public:
+   explicit SyntaxFactory(IntrusiveRefCountPtr<SyntaxArena> arena)
+      : m_arena(std::move(arena))
+   {}
+
+   SyntaxArena &getArena() const
+   {
+      return *m_arena;
+   }
+
+   const RawSyntax *makeToken(TokenKindType kind, StringRef text, StringRef leadingTrivia) const
+   {
+      return RawSyntax::makeToken(*m_arena, kind, m_arena->copyText(text),
+                                  m_arena->copyText(leadingTrivia));
+   }
+
+   const RawSyntax *makeSourceFile(ArrayRef<const RawSyntax *> statements,
+                                   const RawSyntax *eofToken) const;
+   const RawSyntax *makeStatement(ArrayRef<const RawSyntax *> elements) const;
+   const RawSyntax *makeCodeBlock(ArrayRef<const RawSyntax *> elements) const;
+   const RawSyntax *makeParenGroup(ArrayRef<const RawSyntax *> elements) const;
+   const RawSyntax *makeSquareGroup(ArrayRef<const RawSyntax *> elements) const;
+
+   Syntax makeRoot(const RawSyntax *raw) const
+   {
+      return Syntax::makeRoot(raw, m_arena);
+   }
+
+private:
+   IntrusiveRefCountPtr<SyntaxArena> m_arena;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_SYNTAX_FACTORY_H
@@ -0,0 +1,48 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_SYNTAX_KIND_H
+#define POLARPHP_SYNTAX_SYNTAX_KIND_H
+
+#include "polarphp/basic/adt/StringRef.h"
+
+#include <cstdint>
+
+namespace polar::syntax {
+
+using polar::basic::StringRef;
+
+///
+/// the layout kinds are structural for now, statements and balanced
+/// bracket groups, which is all that tooling needs to map edits onto
+/// subtrees, the grammar level kinds come with the parser
+///
+enum class SyntaxKind : std::uint8_t
+{
+   Token,
+   /// statements followed by the eof token
+   SourceFile,
+   /// tokens and groups up to ; or ?>, or up to a trailing code block
+   Statement,
+   /// { statements }
+   CodeBlock,
+   /// ( tokens and groups )
+   ParenGroup,
+   /// [ tokens and groups ]
+   SquareGroup,
+   Unknown
+};
+
+StringRef get_syntax_kind_name(SyntaxKind kind);
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_SYNTAX_KIND_H
@@ -0,0 +1,183 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_SYNTAX_TOKEN_H
+#define POLARPHP_SYNTAX_TOKEN_H
+
+#include "polarphp/syntax/TokenKinds.h"
+
+namespace polar::syntax {
+
+///
+/// a token never owns memory, the text points into the source buffer and
+/// the leading trivia (whitespace and comments) is the byte range right
+/// before the text, so a token can be copied around freely
+///
+class Token
+{
+public:
+   enum Flags : std::uint8_t
+   {
+      AtStartOfLine = 1 << 0,
+      /// the leading trivia contains a doc comment
+      HasDocComment = 1 << 1,
+      /// double quoted, heredoc or backquote literal containing $var or {$
+      Interpolated = 1 << 2,
+      /// string literal, heredoc or comment that reaches the end of buffer
+      Unterminated = 1 << 3
+   };
+
+   Token()
+      : m_kind(TokenKindType::NUM_TOKENS),
+        m_flags(0),
+        m_leadingTriviaLength(0)
+   {}
+
+   Token(TokenKindType kind, StringRef text, unsigned leadingTriviaLength = 0)
+      : m_kind(kind),
+        m_flags(0),
+        m_leadingTriviaLength(leadingTriviaLength),
+        m_text(text)
+   {}
+
+   TokenKindType getKind() const
+   {
+      return m_kind;
+   }
+
+   void setKind(TokenKindType kind)
+   {
+      m_kind = kind;
+   }
+
+   bool is(TokenKindType kind) const
+   {
+      return m_kind == kind;
+   }
+
+   bool isNot(TokenKindType kind) const
+   {
+      return m_kind != kind;
+   }
+
+   template <typename ...T>
+   bool isAny(TokenKindType kind, T... others) const
+   {
+      return is(kind) || isAny(others...);
+   }
+
+   bool isAny(TokenKindType kind) const
+   {
+      return is(kind);
+   }
+
+   bool isKeyword() const
+   {
+      return is_keyword_token(m_kind);
+   }
+
+   bool isPunctuator() const
+   {
+      return is_punctuator_token(m_kind);
+   }
+
+   bool isLiteral() const
+   {
+      return is_literal_token(m_kind);
+   }
+
+   bool isAtStartOfLine() const
+   {
+      return m_flags & AtStartOfLine;
+   }
+
+   bool hasDocComment() const
+   {
+      return m_flags & HasDocComment;
+   }
+
+   bool isInterpolated() const
+   {
+      return m_flags & Interpolated;
+   }
+
+   bool isUnterminated() const
+   {
+      return m_flags & Unterminated;
+   }
+
+   std::uint8_t getFlags() const
+   {
+      return m_flags;
+   }
+
+   void setFlag(Flags flag)
+   {
+      m_flags |= flag;
+   }
+
+   StringRef getText() const
+   {
+      return m_text;
+   }
+
+   unsigned getLength() const
+   {
+      return m_text.size();
+   }
+
+   const char *getStart() const
+   {
+      return m_text.data();
+   }
+
+   const char *getEnd() const
+   {
+      return m_text.data() + m_text.size();
+   }
+
+   unsigned getLeadingTriviaLength() const
+   {
+      return m_leadingTriviaLength;
+   }
+
+   /// whitespace and comments between the previous token and this one
+   StringRef getLeadingTrivia() const
+   {
+      return StringRef(m_text.data() - m_leadingTriviaLength, m_leadingTriviaLength);
+   }
+
+   /// leading trivia plus the text, consecutive ranges cover the whole buffer
+   StringRef getRangeWithTrivia() const
+   {
+      return StringRef(m_text.data() - m_leadingTriviaLength,
+                       m_leadingTriviaLength + m_text.size());
+   }
+
+   void setToken(TokenKindType kind, StringRef text, unsigned leadingTriviaLength,
+                 std::uint8_t flags)
+   {
+      m_kind = kind;
+      m_flags = flags;
+      m_leadingTriviaLength = leadingTriviaLength;
+      m_text = text;
+   }
+
+private:
+   TokenKindType m_kind;
+   std::uint8_t m_flags;
+   unsigned m_leadingTriviaLength;
+   StringRef m_text;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_TOKEN_H
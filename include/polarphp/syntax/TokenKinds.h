@@ -0,0 +1,46 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_SYNTAX_TOKEN_KINDS_H
+#define POLARPHP_SYNTAX_TOKEN_KINDS_H
+
+#include "polarphp/basic/adt/StringRef.h"
+
+#include <cstdint>
+
+namespace polar::syntax {
+
+using polar::basic::StringRef;
+
+enum class TokenKindType : std::uint16_t
+{
+#define TOKEN(name) name,
+#include "polarphp/syntax/TokenKinds.def"
+   NUM_TOKENS
+};
+
+/// the enumerator name of kind, e.g. "kw_class" or "l_paren"
+StringRef get_token_kind_name(TokenKindType kind);
+
+/// the fixed spelling of keywords, punctuators and casts, empty for tokens
+/// whose text varies
+StringRef get_token_text(TokenKindType kind);
+
+bool is_keyword_token(TokenKindType kind);
+/// __LINE__, __FILE__ and the other compile time constants
+bool is_magic_const_token(TokenKindType kind);
+bool is_punctuator_token(TokenKindType kind);
+bool is_cast_token(TokenKindType kind);
+bool is_literal_token(TokenKindType kind);
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_TOKEN_KINDS_H
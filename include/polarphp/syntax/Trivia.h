@@ -0,0 +1,99 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#ifndef POLARPHP_SYNTAX_TRIVIA_H
+#define POLARPHP_SYNTAX_TRIVIA_H
+
+#include "polarphp/basic/adt/SmallVector.h"
+#include "polarphp/basic/adt/StringRef.h"
+
+namespace polar::syntax {
+
+using polar::basic::SmallVectorImpl;
+using polar::basic::StringRef;
+
+enum class TriviaKind : std::uint8_t
+{
+   Space,
+   Tab,
+   Newline,
+   CarriageReturn,
+   CarriageReturnLineFeed,
+   /// # or // up to the end of line
+   LineComment,
+   BlockComment,
+   DocComment,
+   /// bytes the lexer skipped that are none of the above
+   Garbage
+};
+
+struct TriviaPiece
+{
+   TriviaKind kind;
+   /// for whitespace kinds a run of the same character (or \r\n pairs)
+   StringRef text;
+
+   bool isComment() const
+   {
+      return kind == TriviaKind::LineComment || kind == TriviaKind::BlockComment ||
+            kind == TriviaKind::DocComment;
+   }
+};
+
+///
+/// the whitespace and comments in front of a token, stored as the raw
+/// text so the tree reproduces the source byte for byte, the pieces are
+/// only split out when someone asks for them
+///
+class Trivia
+{
+public:
+   Trivia() = default;
+
+   explicit Trivia(StringRef text)
+      : m_text(text)
+   {}
+
+   StringRef getText() const
+   {
+      return m_text;
+   }
+
+   unsigned getLength() const
+   {
+      return m_text.size();
+   }
+
+   bool isEmpty() const
+   {
+      return m_text.empty();
+   }
+
+   void getPieces(SmallVectorImpl<TriviaPiece> &pieces) const;
+
+   bool containsNewline() const
+   {
+      return m_text.findFirstOf("\r\n") != StringRef::npos;
+   }
+
+   /// the text of the last doc comment, empty when there is none
+   StringRef getDocComment() const;
+
+   /// split the first piece off the front of text
+   static TriviaPiece lexPiece(StringRef text);
+
+private:
+   StringRef m_text;
+};
+
+} // polar::syntax
+
+#endif // POLARPHP_SYNTAX_TRIVIA_H
@@ -191,6 +191,39 @@ Boolean is_legal_utf8_string(const Utf8 **source, const Utf8 *sourceEnd);
 
 unsigned get_num_bytes_for_utf8(Utf8 firstByte);
 
+/*************************************************************************/
+/* Block validation and ASCII widening, dispatched on the host CPU. */
+
+/**
+ * Validate [source, sourceEnd) a block at a time with the fastest validator
+ * the host CPU supports.
+ *
+ * \returns sourceEnd if the whole range is legal UTF-8, otherwise the start
+ * of the first ill-formed sequence, the same position is_legal_utf8_string()
+ * stops at.
+ */
+const Utf8 *find_invalid_utf8(const Utf8 *source, const Utf8 *sourceEnd);
+
+/**
+ * Returns true if \p str is legal UTF-8.
+ */
+bool is_valid_utf8(StringRef str);
+
+/**
+ * Copy the ASCII bytes at the start of \p source, at most \p length of them,
+ * to \p target widened to code units.
+ *
+ * \returns the number of code units written, the byte after them is the
+ * first one that is not ASCII or the end of the range.
+ */
+size_t widen_ascii_prefix(const Utf8 *source, size_t length, Utf16 *target);
+size_t widen_ascii_prefix(const Utf8 *source, size_t length, Utf32 *target);
+
+/**
+ * The name of the kernels selected for the host CPU, "avx2" or "fallback".
+ */
+const char *get_utf8_kernels_name();
+
 /*************************************************************************/
 /* Below are polarphp-specific wrappers of the functions above. */
 
@@ -0,0 +1,119 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#ifndef POLARPHP_UTILS_LINE_TABLE_H
+#define POLARPHP_UTILS_LINE_TABLE_H
+
+#include "polarphp/basic/adt/StringRef.h"
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace polar {
+namespace utils {
+
+using polar::basic::StringRef;
+
+///
+/// the offsets at which the lines of a buffer start, lines are ended by
+/// '\n' (so "\r\n" ends one line). the table is filled front to back,
+/// either at once or piecewise by a lexer that passes over the bytes
+/// anyway, and answers a line number in constant time once finished: a
+/// block index holds the line of every BLOCK_SIZE byte boundary and a
+/// lookup only walks the few line starts inside one block
+///
+class LineTable
+{
+public:
+   LineTable()
+      : m_lineStarts(1, 0)
+   {}
+
+   /// scans all of text, 16 bytes at a time where SSE2 is available
+   explicit LineTable(StringRef text)
+      : LineTable()
+   {
+      finish(text);
+   }
+
+   /// records the line starts in [getScannedSize(), end) of the buffer
+   /// starting at bufferStart, nothing happens if end was scanned already
+   void scanTo(const char *bufferStart, std::size_t end);
+
+   /// scans the rest of buffer and builds the block index, the table has
+   /// to be finished before it is asked for lines
+   void finish(StringRef buffer);
+
+   bool isFinished() const
+   {
+      return m_finished;
+   }
+
+   std::size_t getScannedSize() const
+   {
+      return m_scannedSize;
+   }
+
+   unsigned getNumLines() const
+   {
+      return m_lineStarts.size();
+   }
+
+   /// the offset of 1 based line
+   std::size_t getLineStart(unsigned line) const
+   {
+      assert(line >= 1 && line <= m_lineStarts.size() && "line out of range");
+      return m_lineStarts[line - 1];
+   }
+
+   /// 1 based line of offset, offset may be the size of the buffer
+   unsigned getLineNumber(std::size_t offset) const
+   {
+      assert(m_finished && "line table is not finished");
+      assert(offset <= m_scannedSize && "offset out of buffer");
+      unsigned index = m_blockLines[offset >> BLOCK_SHIFT];
+      unsigned count = m_lineStarts.size();
+      while (index + 1 < count && m_lineStarts[index + 1] <= offset) {
+         ++index;
+      }
+      return index + 1;
+   }
+
+   /// 1 based line and column, the column counts bytes
+   std::pair<unsigned, unsigned> getLineAndColumn(std::size_t offset) const
+   {
+      unsigned line = getLineNumber(offset);
+      return std::make_pair(line, static_cast<unsigned>(offset - m_lineStarts[line - 1] + 1));
+   }
+
+   /// bytes held by the table and its index
+   std::size_t getMemorySize() const
+   {
+      return (m_lineStarts.capacity() + m_blockLines.capacity()) * sizeof(std::uint32_t);
+   }
+
+private:
+   static constexpr unsigned BLOCK_SHIFT = 8;
+   static constexpr std::size_t BLOCK_SIZE = std::size_t(1) << BLOCK_SHIFT;
+
+   std::vector<std::uint32_t> m_lineStarts;
+   /// index into m_lineStarts of the line containing each block start
+   std::vector<std::uint32_t> m_blockLines;
+   std::size_t m_scannedSize = 0;
+   bool m_finished = false;
+};
+
+} // utils
+} // polar
+
+#endif // POLARPHP_UTILS_LINE_TABLE_H
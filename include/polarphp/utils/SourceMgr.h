@@ -13,10 +13,10 @@
 #define POLARPHP_UTILS_SOURCE_MGR_H
 
 #include "polarphp/basic/adt/ArrayRef.h"
-#include "polarphp/basic/adt/PointerUnion.h"
 #include "polarphp/basic/adt/SmallVector.h"
 #include "polarphp/basic/adt/StringRef.h"
 #include "polarphp/basic/adt/Twine.h"
+#include "polarphp/utils/LineTable.h"
 #include "polarphp/utils/MemoryBuffer.h"
 #include "polarphp/utils/SourceLocation.h"
 #include <algorithm>
@@ -33,7 +33,6 @@ class RawOutStream;
 class SMDiagnostic;
 class SMFixIt;
 
-using polar::basic::PointerUnion4;
 using polar::basic::StringRef;
 using polar::basic::ArrayRef;
 using polar::basic::SmallVector;
@@ -63,29 +62,12 @@ private:
       /// The memory buffer for the file.
       std::unique_ptr<MemoryBuffer> m_buffer;
 
-      /// Helper type for OffsetCache below: since we're storing many offsets
-      /// into relatively small files (often smaller than 2^8 or 2^16 bytes),
-      /// we select the offset vector element type dynamically based on the
-      /// size of Buffer.
-      using VariableSizeOffsets = PointerUnion4<std::vector<uint8_t> *,
-      std::vector<uint16_t> *,
-      std::vector<uint32_t> *,
-      std::vector<uint64_t> *>;
-
-      /// Vector of offsets into Buffer at which there are line-endings
-      /// (lazily populated). Once populated, the '\n' that marks the end of
-      /// line number N from [1..] is at Buffer[OffsetCache[N-1]]. Since
-      /// these offsets are in sorted (ascending) order, they can be
-      /// binary-searched for the first one after any given offset (eg. an
-      /// offset corresponding to a particular SMLoc).
-      mutable VariableSizeOffsets m_offsetCache;
-
-      /// Populate \c OffsetCache and look up a given \p Ptr in it, assuming
-      /// it points somewhere into \c Buffer. The static type parameter \p T
-      /// must be an unsigned integer type from uint{8,16,32,64}_t large
-      /// enough to store offsets inside \c Buffer.
-      template<typename T>
-      unsigned getLineNumber(const char *ptr) const;
+      /// The line starts of Buffer, built on the first line query unless a
+      /// lexer handed in the table it produced while lexing the buffer.
+      mutable std::unique_ptr<LineTable> m_lineTable;
+
+      const LineTable &getLineTable() const;
+
       /// This is the location of the parent include, or null if at the top level.
       SMLocation m_includeLoc;
       SrcBuffer() = default;
@@ -193,15 +175,26 @@ public:
    /// 0 is returned if the buffer is not found.
    unsigned findBufferContainingLoc(SMLocation location) const;
 
+   /// Hand over the line starts of a buffer, e.g. the ones a lexer recorded
+   /// while lexing it, so the first line query does not scan the buffer
+   /// again. A table that covers only a prefix is completed here.
+   void setLineTable(unsigned bufferID, LineTable table);
+
+   /// The line starts of a buffer, built now if nobody provided them.
+   const LineTable &getLineTable(unsigned bufferID) const
+   {
+      return getBufferInfo(bufferID).getLineTable();
+   }
+
    /// Find the line number for the specified location in the specified file.
-   /// This is not a fast method.
+   /// Constant time once the line table of the buffer exists.
    unsigned findLineNumber(SMLocation location, unsigned bufferID = 0) const
    {
       return getLineAndColumn(location, bufferID).first;
    }
 
    /// Find the line and column number for the specified location in the
-   /// specified file. This is not a fast method.
+   /// specified file. Columns count bytes from the start of the line.
    std::pair<unsigned, unsigned> getLineAndColumn(SMLocation location,
                                                   unsigned bufferID = 0) const;
 
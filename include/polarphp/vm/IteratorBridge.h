@@ -35,6 +35,8 @@ private:
    void next();
    void rewind();
    void invalidate();
+   bool fillBatch();
+   void releaseBatch();
 private:
    static IteratorBridge *getSelfPtr(zend_object_iterator *iterator);
    static void destructor(zend_object_iterator *iterator);
@@ -44,10 +46,22 @@ private:
    static void next(zend_object_iterator *iterator);
    static void rewind(zend_object_iterator *iterator);
    static void invalidate(zend_object_iterator *iterator);
+   static int takeCurrent(zend_object_iterator *iterator, zval *value, zval *key);
 private:
    zend_object_iterator m_iterator;
    AbstractIterator *m_userspaceIterator;
    Variant m_current;
+   /// the entries of the last AbstractIterator::fetch(), BATCH_CAPACITY
+   /// keys and then as many values, allocated once the iterator accepts
+   /// a batch. foreach moves the entry of m_position out, anything left
+   /// is released when the loop moves on
+   static constexpr size_t BATCH_CAPACITY = 16;
+   zval *m_batch = nullptr;
+   size_t m_position = 0;
+   size_t m_count = 0;
+   /// cleared for good when the iterator declines to fetch
+   bool m_batched = true;
+   bool m_exhausted = false;
 };
 
 } // vmapi
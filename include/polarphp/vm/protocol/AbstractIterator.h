@@ -25,6 +25,46 @@ class AbstractIteratorPrivate;
 
 using internal::AbstractIteratorPrivate;
 
+class IteratorBridge;
+
+///
+/// the entries one AbstractIterator::fetch() hands out, each key and value
+/// is moved into the buffer foreach takes it from, nothing is copied
+///
+class VMAPI_DECL_EXPORT IteratorBatch
+{
+public:
+   size_t getCapacity() const
+   {
+      return m_capacity;
+   }
+
+   size_t getSize() const
+   {
+      return m_size;
+   }
+
+   bool isFull() const
+   {
+      return m_size == m_capacity;
+   }
+
+   /// takes over the key and the value, a reference is taken by its value
+   void append(Variant &&key, Variant &&value);
+
+private:
+   friend class IteratorBridge;
+   IteratorBatch(zval *&buffer, size_t capacity)
+      : m_buffer(buffer),
+        m_capacity(capacity)
+   {}
+
+   /// the keys and then the values, allocated by the first append
+   zval *&m_buffer;
+   size_t m_capacity;
+   size_t m_size = 0;
+};
+
 class VMAPI_DECL_EXPORT AbstractIterator
 {
 public:
@@ -37,6 +77,16 @@ public:
    virtual void next() = 0;
    virtual void rewind() = 0;
 
+   /// hands out the entries from the current position on in batches, so
+   /// foreach does not cross into the iterator for every step. appends up
+   /// to the capacity of \p batch and moves past them, an empty batch
+   /// ends the loop
+   ///
+   /// the default declines by returning false without touching the
+   /// iterator, the engine then goes through valid(), current(), key()
+   /// and next()
+   virtual bool fetch(IteratorBatch &batch);
+
 protected:
    VMAPI_DECLARE_PRIVATE(AbstractIterator);
    std::unique_ptr<AbstractIteratorPrivate> m_implPtr;
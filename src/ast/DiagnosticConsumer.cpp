@@ -254,8 +254,12 @@ void NullDiagnosticConsumer::handleDiagnostic(
 {
    POLAR_DEBUG({
                  polar::debug_stream() << "NullDiagnosticConsumer received diagnostic: ";
-                 DiagnosticEngine::formatDiagnosticText(polar::debug_stream(), formatString,
-                 formatArgs);
+                 if (!info.formattedText.empty()) {
+                    polar::debug_stream() << info.formattedText;
+                 } else {
+                    DiagnosticEngine::formatDiagnosticText(polar::debug_stream(), formatString,
+                                                           formatArgs);
+                 }
                  polar::debug_stream() << "\n";
               });
 }
@@ -271,8 +275,12 @@ void ForwardingDiagnosticConsumer::handleDiagnostic(
 {
    POLAR_DEBUG({
                  polar::debug_stream() << "ForwardingDiagnosticConsumer received diagnostic: ";
-                 DiagnosticEngine::formatDiagnosticText(polar::debug_stream(), formatString,
-                 formatArgs);
+                 if (!info.formattedText.empty()) {
+                    polar::debug_stream() << info.formattedText;
+                 } else {
+                    DiagnosticEngine::formatDiagnosticText(polar::debug_stream(), formatString,
+                                                           formatArgs);
+                 }
                  polar::debug_stream() << "\n";
               });
    for (auto *C : m_targetEngine.getConsumers()) {
@@ -39,3 +39,708 @@
 #include "polarphp/utils/CommandLine.h"
 #include "polarphp/utils/Format.h"
 #include "polarphp/utils/RawOutStream.h"
+#include "polarphp/utils/FastHash.h"
+#include "polarphp/utils/Parallel.h"
+
+#include <cstring>
+
+namespace polar::ast {
+
+using polar::utils::RawStringOutStream;
+using polar::utils::fast_hash64;
+
+namespace {
+enum class DiagnosticOptions
+{
+   /// No options.
+   none,
+
+   /// The location of this diagnostic points to the beginning of the first
+   /// token that the parser considers invalid.  If this token is located at the
+   /// beginning of the line, then the location is adjusted to point to the end
+   /// of the previous token.
+   ///
+   /// This behavior improves experience for "expected token X" diagnostics.
+   PointsToFirstBadToken,
+
+   /// After a fatal error subsequent diagnostics are suppressed.
+   Fatal,
+};
+
+struct StoredDiagnosticInfo
+{
+   DiagnosticKind kind : 2;
+   bool pointsToFirstBadToken : 1;
+   bool isFatal : 1;
+
+   constexpr StoredDiagnosticInfo(DiagnosticKind kind, bool firstBadToken,
+                                  bool fatal)
+      : kind(kind),
+        pointsToFirstBadToken(firstBadToken),
+        isFatal(fatal)
+   {}
+
+   constexpr StoredDiagnosticInfo(DiagnosticKind kind, DiagnosticOptions opts)
+      : StoredDiagnosticInfo(kind,
+                             opts == DiagnosticOptions::PointsToFirstBadToken,
+                             opts == DiagnosticOptions::Fatal)
+   {}
+};
+
+// Reproduce the DiagIDs, as we want both the size and access to the raw ids
+// themselves.
+enum LocalDiagID : uint32_t
+{
+#define DIAG(KIND, ID, Options, Text, Signature) ID,
+#include "polarphp/ast/DiagnosticsAllDefs.h"
+   NumDiags
+};
+
+// TODO: categorization
+static const constexpr StoredDiagnosticInfo sg_storedDiagnosticInfos[] = {
+#define ERROR(ID, Options, Text, Signature)                                    \
+   StoredDiagnosticInfo(DiagnosticKind::Error, DiagnosticOptions::Options),
+#define WARNING(ID, Options, Text, Signature)                                  \
+   StoredDiagnosticInfo(DiagnosticKind::Warning, DiagnosticOptions::Options),
+#define NOTE(ID, Options, Text, Signature)                                     \
+   StoredDiagnosticInfo(DiagnosticKind::Note, DiagnosticOptions::Options),
+#define REMARK(ID, Options, Text, Signature)                                   \
+   StoredDiagnosticInfo(DiagnosticKind::Remark, DiagnosticOptions::Options),
+#include "polarphp/ast/DiagnosticsAllDefs.h"
+};
+static_assert(sizeof(sg_storedDiagnosticInfos) / sizeof(StoredDiagnosticInfo) ==
+              LocalDiagID::NumDiags,
+              "array size mismatch");
+
+static constexpr const char * const sg_diagnosticStrings[] = {
+#define ERROR(ID, Options, Text, Signature) Text,
+#define WARNING(ID, Options, Text, Signature) Text,
+#define NOTE(ID, Options, Text, Signature) Text,
+#define REMARK(ID, Options, Text, Signature) Text,
+#include "polarphp/ast/DiagnosticsAllDefs.h"
+   "<not a diagnostic>",
+};
+
+/// below this many stored diagnostics rendering them on the calling thread
+/// is cheaper than handing them out to the pool
+constexpr std::size_t sg_minParallelRenderCount = 256;
+
+DiagnosticKind to_diagnostic_kind(DiagnosticState::Behavior behavior)
+{
+   switch (behavior) {
+   case DiagnosticState::Behavior::Unspecified:
+      polar_unreachable("unspecified behavior");
+   case DiagnosticState::Behavior::Ignore:
+      polar_unreachable("trying to map an ignored diagnostic");
+   case DiagnosticState::Behavior::Error:
+   case DiagnosticState::Behavior::Fatal:
+      return DiagnosticKind::Error;
+   case DiagnosticState::Behavior::Note:
+      return DiagnosticKind::Note;
+   case DiagnosticState::Behavior::Warning:
+      return DiagnosticKind::Warning;
+   case DiagnosticState::Behavior::Remark:
+      return DiagnosticKind::Remark;
+   }
+   polar_unreachable("Unhandled DiagnosticKind in switch.");
+}
+
+/// one word standing for the value of an argument, equal arguments give
+/// equal words
+uint64_t get_argument_word(const DiagnosticArgument &arg)
+{
+   switch (arg.getKind()) {
+   case DiagnosticArgumentKind::String:
+      return fast_hash64(arg.getAsString());
+   case DiagnosticArgumentKind::Integer:
+      return static_cast<uint64_t>(static_cast<int64_t>(arg.getAsInteger()));
+   case DiagnosticArgumentKind::Unsigned:
+      return arg.getAsUnsigned();
+   case DiagnosticArgumentKind::Identifier:
+      return reinterpret_cast<uintptr_t>(arg.getAsIdentifier().getOpaqueValue());
+   case DiagnosticArgumentKind::ValueDecl:
+      return reinterpret_cast<uintptr_t>(arg.getAsValueDecl());
+   case DiagnosticArgumentKind::Type:
+      return reinterpret_cast<uintptr_t>(arg.getAsType().getPointer());
+   case DiagnosticArgumentKind::TypeRepr:
+      return reinterpret_cast<uintptr_t>(arg.getAsTypeRepr());
+   case DiagnosticArgumentKind::StaticSpellingKind:
+      return static_cast<uint64_t>(arg.getAsStaticSpellingKind());
+   case DiagnosticArgumentKind::ReferenceOwnership:
+      polar_unreachable("reference ownership arguments can not be created");
+   case DiagnosticArgumentKind::DescriptiveDeclKind:
+      return static_cast<uint64_t>(arg.getAsDescriptiveDeclKind());
+   case DiagnosticArgumentKind::DeclAttribute:
+      return reinterpret_cast<uintptr_t>(arg.getAsDeclAttribute());
+   case DiagnosticArgumentKind::VersionTuple:
+      return fast_hash64(arg.getAsVersionTuple().getAsString());
+   }
+   polar_unreachable("Unhandled DiagnosticArgumentKind in switch.");
+}
+
+bool is_same_argument(const DiagnosticArgument &lhs, const DiagnosticArgument &rhs)
+{
+   if (lhs.getKind() != rhs.getKind()) {
+      return false;
+   }
+   switch (lhs.getKind()) {
+   case DiagnosticArgumentKind::String:
+      return lhs.getAsString() == rhs.getAsString();
+   case DiagnosticArgumentKind::Identifier:
+      return lhs.getAsIdentifier() == rhs.getAsIdentifier();
+   case DiagnosticArgumentKind::VersionTuple:
+      return lhs.getAsVersionTuple() == rhs.getAsVersionTuple();
+   default:
+      /// every other kind is a pointer or an integer, its word is its value
+      return get_argument_word(lhs) == get_argument_word(rhs);
+   }
+}
+
+uint64_t get_diagnostic_hash(DiagID id, SourceLoc loc, ArrayRef<DiagnosticArgument> args)
+{
+   SmallVector<uint64_t, 8> words;
+   words.push_back(static_cast<uint64_t>(id));
+   words.push_back(reinterpret_cast<uintptr_t>(loc.getOpaquePointerValue()));
+   for (const DiagnosticArgument &arg : args) {
+      words.push_back(static_cast<uint64_t>(arg.getKind()));
+      words.push_back(get_argument_word(arg));
+   }
+   return fast_hash64(StringRef(reinterpret_cast<const char *>(words.getData()),
+                                words.size() * sizeof(uint64_t)));
+}
+
+} // anonymous namespace
+
+DiagnosticState::DiagnosticState()
+{
+   // Initialize our per-diagnostic state to default
+   m_perDiagnosticBehavior.resize(LocalDiagID::NumDiags, Behavior::Unspecified);
+}
+
+DiagnosticState::Behavior DiagnosticState::determineBehavior(DiagID id)
+{
+   auto set = [this](Behavior lvl) {
+      if (lvl == Behavior::Fatal) {
+         m_fatalErrorOccurred = true;
+         m_anyErrorOccurred = true;
+      } else if (lvl == Behavior::Error) {
+         m_anyErrorOccurred = true;
+      }
+      m_previousBehavior = lvl;
+      return lvl;
+   };
+
+   // We determine how to handle a diagnostic based on the following rules
+   //   1) If current state dictates a certain behavior, follow that
+   //   2) If the user provided a behavior for this specific diagnostic, follow
+   //      that
+   //   3) If the user provided a behavior for this diagnostic's kind, follow
+   //      that
+   //   4) Otherwise remap the diagnostic kind
+
+   auto diagInfo = sg_storedDiagnosticInfos[(unsigned)id];
+   bool isNote = diagInfo.kind == DiagnosticKind::Note;
+
+   // 1) If current state dictates a certain behavior, follow that
+
+   // Notes relating to ignored diagnostics should also be ignored
+   if (m_previousBehavior == Behavior::Ignore && isNote) {
+      return set(Behavior::Ignore);
+   }
+
+   // Suppress diagnostics when in a fatal state, except for follow-on notes
+   if (m_fatalErrorOccurred) {
+      if (!m_showDiagnosticsAfterFatalError && !isNote) {
+         return set(Behavior::Ignore);
+      }
+   }
+
+   // 2) If the user provided a behavior for this specific diagnostic, follow
+   //    that
+   if (m_perDiagnosticBehavior[(unsigned)id] != Behavior::Unspecified) {
+      return set(m_perDiagnosticBehavior[(unsigned)id]);
+   }
+
+   // 3) If the user provided a behavior for this diagnostic's kind, follow
+   //    that
+   if (diagInfo.kind == DiagnosticKind::Warning) {
+      if (m_suppressWarnings) {
+         return set(Behavior::Ignore);
+      }
+      if (m_warningsAsErrors) {
+         return set(Behavior::Error);
+      }
+   }
+
+   // 4) Otherwise remap the diagnostic kind
+   switch (diagInfo.kind) {
+   case DiagnosticKind::Note:
+      return set(Behavior::Note);
+   case DiagnosticKind::Error:
+      return set(diagInfo.isFatal ? Behavior::Fatal : Behavior::Error);
+   case DiagnosticKind::Warning:
+      return set(Behavior::Warning);
+   case DiagnosticKind::Remark:
+      return set(Behavior::Remark);
+   }
+
+   polar_unreachable("Unhandled DiagnosticKind in switch.");
+}
+
+void InFlightDiagnostic::flush()
+{
+   if (!m_isActive) {
+      return;
+   }
+   m_isActive = false;
+   if (m_engine) {
+      m_engine->flushActiveDiagnostic();
+   }
+}
+
+bool DiagnosticEngine::isDiagnosticPointsToFirstBadToken(DiagID id) const
+{
+   const auto &diagInfo = sg_storedDiagnosticInfos[(unsigned)id];
+   return diagInfo.pointsToFirstBadToken;
+}
+
+bool DiagnosticEngine::finishProcessing()
+{
+   flushDiagnostics();
+   bool hadError = false;
+   for (auto &consumer : m_consumers) {
+      hadError |= consumer->finishProcessing();
+   }
+   return hadError;
+}
+
+/// Skip forward to one of the given delimiters.
+///
+/// \param text The text to search through, which will be updated to point
+/// just after the delimiter.
+///
+/// \param delim The first character delimiter to search for.
+///
+/// \param foundDelim On return, true if the delimiter was found, or false
+/// if the end of the string was reached.
+///
+/// \returns The string leading up to the delimiter, or the empty string
+/// if no delimiter is found.
+static StringRef skip_to_delimiter(StringRef &text, char delim,
+                                   bool *foundDelim = nullptr)
+{
+   unsigned depth = 0;
+   if (foundDelim) {
+      *foundDelim = false;
+   }
+   unsigned index = 0;
+   for (unsigned size = text.size(); index != size; ++index) {
+      if (text[index] == '{') {
+         ++depth;
+         continue;
+      }
+      if (depth > 0) {
+         if (text[index] == '}') {
+            --depth;
+         }
+         continue;
+      }
+      if (text[index] == delim) {
+         if (foundDelim) {
+            *foundDelim = true;
+         }
+         break;
+      }
+   }
+
+   assert(depth == 0 && "Unbalanced {} set in diagnostic text");
+   StringRef result = text.substr(0, index);
+   text = text.substr(index + 1);
+   return result;
+}
+
+/// Handle the integer 'select' modifier.  This is used like this:
+/// %select{foo|bar|baz}2.  This means that the integer argument "%2" has a
+/// value from 0-2.  If the value is 0, the diagnostic prints 'foo'.
+/// If the value is 1, it prints 'bar'.  If it has the value 2, it prints 'baz'.
+/// This is very useful for certain classes of variant diagnostics.
+static void format_selection_argument(StringRef modifierArguments,
+                                      ArrayRef<DiagnosticArgument> args,
+                                      unsigned selectedIndex,
+                                      DiagnosticFormatOptions formatOpts,
+                                      RawOutStream &out)
+{
+   bool foundPipe = false;
+   do {
+      assert((!modifierArguments.empty() || foundPipe) &&
+             "Index beyond bounds in %select modifier");
+      StringRef text = skip_to_delimiter(modifierArguments, '|', &foundPipe);
+      if (selectedIndex == 0) {
+         DiagnosticEngine::formatDiagnosticText(out, text, args, formatOpts);
+         break;
+      }
+      --selectedIndex;
+   } while (true);
+}
+
+/// Format a single diagnostic argument and write it to the given
+/// stream.
+static void format_diagnostic_argument(StringRef modifier,
+                                       StringRef modifierArguments,
+                                       ArrayRef<DiagnosticArgument> args,
+                                       unsigned argIndex,
+                                       DiagnosticFormatOptions formatOpts,
+                                       RawOutStream &out)
+{
+   using polar::basic::operator<<;
+   const DiagnosticArgument &arg = args[argIndex];
+   switch (arg.getKind()) {
+   case DiagnosticArgumentKind::Integer:
+      if (modifier == "select") {
+         assert(arg.getAsInteger() >= 0 && "Negative selection index");
+         format_selection_argument(modifierArguments, args, arg.getAsInteger(),
+                                   formatOpts, out);
+      } else if (modifier == "s") {
+         if (arg.getAsInteger() != 1) {
+            out << 's';
+         }
+      } else {
+         assert(modifier.empty() && "Improper modifier for integer argument");
+         out << arg.getAsInteger();
+      }
+      break;
+
+   case DiagnosticArgumentKind::Unsigned:
+      if (modifier == "select") {
+         format_selection_argument(modifierArguments, args, arg.getAsUnsigned(),
+                                   formatOpts, out);
+      } else if (modifier == "s") {
+         if (arg.getAsUnsigned() != 1) {
+            out << 's';
+         }
+      } else {
+         assert(modifier.empty() && "Improper modifier for unsigned argument");
+         out << arg.getAsUnsigned();
+      }
+      break;
+
+   case DiagnosticArgumentKind::String:
+      if (modifier == "select") {
+         format_selection_argument(modifierArguments, args,
+                                   arg.getAsString().empty() ? 0 : 1,
+                                   formatOpts, out);
+      } else {
+         assert(modifier.empty() && "Improper modifier for string argument");
+         out << arg.getAsString();
+      }
+      break;
+
+   case DiagnosticArgumentKind::Identifier:
+      assert(modifier.empty() && "Improper modifier for identifier argument");
+      out << formatOpts.openingQuotationMark;
+      out << arg.getAsIdentifier();
+      out << formatOpts.closingQuotationMark;
+      break;
+
+   case DiagnosticArgumentKind::ValueDecl:
+      // There is no ValueDecl to point to yet.
+      polar_unreachable("value declaration arguments are not supported yet");
+
+   case DiagnosticArgumentKind::Type: {
+      assert(modifier.empty() && "Improper modifier for Type argument");
+      out << formatOpts.openingQuotationMark;
+      arg.getAsType().print(out);
+      out << formatOpts.closingQuotationMark;
+      break;
+   }
+
+   case DiagnosticArgumentKind::TypeRepr:
+      assert(modifier.empty() && "Improper modifier for TypeRepr argument");
+      out << formatOpts.openingQuotationMark;
+      arg.getAsTypeRepr()->print(out);
+      out << formatOpts.closingQuotationMark;
+      break;
+
+   case DiagnosticArgumentKind::StaticSpellingKind:
+      if (modifier == "select") {
+         format_selection_argument(modifierArguments, args,
+                                   unsigned(arg.getAsStaticSpellingKind()),
+                                   formatOpts, out);
+      } else {
+         assert(modifier.empty() &&
+                "Improper modifier for StaticSpellingKind argument");
+         out << arg.getAsStaticSpellingKind();
+      }
+      break;
+
+   case DiagnosticArgumentKind::ReferenceOwnership:
+      polar_unreachable("reference ownership arguments can not be created");
+
+   case DiagnosticArgumentKind::DescriptiveDeclKind:
+      assert(modifier.empty() &&
+             "Improper modifier for DescriptiveDeclKind argument");
+      out << Decl::getDescriptiveKindName(arg.getAsDescriptiveDeclKind());
+      break;
+
+   case DiagnosticArgumentKind::DeclAttribute:
+      assert(modifier.empty() &&
+             "Improper modifier for DeclAttribute argument");
+      if (arg.getAsDeclAttribute()->isDeclModifier()) {
+         out << formatOpts.openingQuotationMark
+             << arg.getAsDeclAttribute()->getAttrName()
+             << formatOpts.closingQuotationMark;
+      } else {
+         out << '@' << arg.getAsDeclAttribute()->getAttrName();
+      }
+      break;
+
+   case DiagnosticArgumentKind::VersionTuple:
+      assert(modifier.empty() &&
+             "Improper modifier for VersionTuple argument");
+      out << arg.getAsVersionTuple().getAsString();
+      break;
+   }
+}
+
+/// Format the given diagnostic text and place the result in the given
+/// buffer.
+void DiagnosticEngine::formatDiagnosticText(
+      RawOutStream &out, StringRef inText, ArrayRef<DiagnosticArgument> args,
+      DiagnosticFormatOptions formatOpts)
+{
+   while (!inText.empty()) {
+      size_t percent = inText.find('%');
+      if (percent == StringRef::npos) {
+         // Write the rest of the string; we're done.
+         out.write(inText.data(), inText.size());
+         break;
+      }
+
+      // Write the string up to (but not including) the %, then drop that text
+      // (including the %).
+      out.write(inText.data(), percent);
+      inText = inText.substr(percent + 1);
+
+      // '%%' -> '%'.
+      if (inText[0] == '%') {
+         out.write('%');
+         inText = inText.substr(1);
+         continue;
+      }
+
+      // Parse an optional modifier.
+      StringRef modifier;
+      {
+         size_t length = inText.findIfNot(isalpha);
+         modifier = inText.substr(0, length);
+         inText = inText.substr(length);
+      }
+
+      if (modifier == "error") {
+         assert(false && "encountered %error in diagnostic text");
+         out << StringRef("<<ERROR>>");
+         break;
+      }
+
+      // Parse the optional argument list for a modifier, which is brace-enclosed.
+      StringRef modifierArguments;
+      if (inText[0] == '{') {
+         inText = inText.substr(1);
+         modifierArguments = skip_to_delimiter(inText, '}');
+      }
+
+      // Find the digit sequence, and parse it into an argument index.
+      size_t length = inText.findIfNot(isdigit);
+      unsigned argIndex;
+      POLAR_ATTRIBUTE_UNUSED bool result = inText.substr(0, length).getAsInteger(10, argIndex);
+      assert(!result && "Unparseable argument index value?");
+      assert(argIndex < args.size() && "Out-of-range argument index");
+      inText = inText.substr(length);
+
+      // Convert the argument to a string.
+      format_diagnostic_argument(modifier, modifierArguments, args, argIndex,
+                                 formatOpts, out);
+   }
+}
+
+void DiagnosticEngine::flushActiveDiagnostic()
+{
+   assert(m_activeDiagnostic && "No active diagnostic to flush");
+   if (m_transactionCount == 0) {
+      emitDiagnostic(*m_activeDiagnostic);
+   } else {
+      m_tentativeDiagnostics.emplace_back(std::move(*m_activeDiagnostic));
+   }
+   m_activeDiagnostic.reset();
+}
+
+void DiagnosticEngine::emitTentativeDiagnostics()
+{
+   for (auto &diag : m_tentativeDiagnostics) {
+      emitDiagnostic(diag);
+   }
+   m_tentativeDiagnostics.clear();
+}
+
+void DiagnosticEngine::emitDiagnostic(const Diagnostic &diagnostic)
+{
+   auto behavior = m_state.determineBehavior(diagnostic.getID());
+   if (behavior == DiagnosticState::Behavior::Ignore) {
+      return;
+   }
+
+   // Figure out the source location.
+   SourceLoc loc = diagnostic.getLoc();
+   if (loc.isInvalid() && diagnostic.getDecl()) {
+      loc = diagnostic.getDecl()->getLoc();
+   }
+
+   if (m_batchDiagnostics) {
+      // Nobody would see it, a DiagnosticSuppression is active.
+      if (m_consumers.empty()) {
+         return;
+      }
+      storeDiagnostic(diagnostic, loc, to_diagnostic_kind(behavior));
+      return;
+   }
+
+   DiagnosticInfo info;
+   info.id = diagnostic.getID();
+   info.ranges = diagnostic.getRanges();
+   info.fixIts = diagnostic.getFixIts();
+   for (auto &consumer : m_consumers) {
+      consumer->handleDiagnostic(m_sourceMgr, loc, to_diagnostic_kind(behavior),
+                                 diagnosticStringFor(info.id),
+                                 diagnostic.getArgs(), info);
+   }
+}
+
+void DiagnosticEngine::storeDiagnostic(const Diagnostic &diag, SourceLoc loc,
+                                       DiagnosticKind kind)
+{
+   ArrayRef<DiagnosticArgument> args = diag.getArgs();
+   if (kind == DiagnosticKind::Note) {
+      if (m_dropAttachedNotes) {
+         ++m_numDuplicateDiagnostics;
+         return;
+      }
+   } else {
+      // The hash is taken over the emitter's arguments, nothing is copied
+      // for a duplicate.
+      uint64_t hash = get_diagnostic_hash(diag.getID(), loc, args);
+      auto iter = m_storedDiagnosticsByHash.find(hash);
+      if (iter != m_storedDiagnosticsByHash.end()) {
+         const StoredDiagnostic &stored = m_storedDiagnostics[iter->second];
+         if (stored.id == diag.getID() && stored.loc == loc &&
+             stored.args.size() == args.size() &&
+             std::equal(args.begin(), args.end(), stored.args.begin(),
+                        is_same_argument)) {
+            m_dropAttachedNotes = true;
+            ++m_numDuplicateDiagnostics;
+            return;
+         }
+      } else {
+         m_storedDiagnosticsByHash[hash] = m_storedDiagnostics.size();
+      }
+      m_dropAttachedNotes = false;
+   }
+
+   DiagnosticArgument *storedArgs = m_batchArena.allocate<DiagnosticArgument>(args.size());
+   for (size_t index = 0; index < args.size(); ++index) {
+      const DiagnosticArgument &arg = args[index];
+      if (arg.getKind() == DiagnosticArgumentKind::String) {
+         StringRef text = arg.getAsString();
+         char *copy = m_batchArena.allocate<char>(text.size());
+         std::memcpy(copy, text.data(), text.size());
+         new (&storedArgs[index]) DiagnosticArgument(StringRef(copy, text.size()));
+      } else {
+         new (&storedArgs[index]) DiagnosticArgument(arg);
+      }
+   }
+   ArrayRef<CharSourceRange> ranges = diag.getRanges();
+   CharSourceRange *storedRanges = m_batchArena.allocate<CharSourceRange>(ranges.size());
+   std::uninitialized_copy(ranges.begin(), ranges.end(), storedRanges);
+
+   StoredDiagnostic stored;
+   stored.id = diag.getID();
+   stored.kind = kind;
+   stored.loc = loc;
+   stored.args = ArrayRef<DiagnosticArgument>(storedArgs, args.size());
+   stored.ranges = ArrayRef<CharSourceRange>(storedRanges, ranges.size());
+   stored.firstFixIt = m_storedFixIts.size();
+   stored.numFixIts = diag.getFixIts().size();
+   m_storedFixIts.insert(m_storedFixIts.end(), diag.getFixIts().begin(),
+                         diag.getFixIts().end());
+   m_storedDiagnostics.push_back(stored);
+}
+
+void DiagnosticEngine::setBatchDiagnostics(bool val)
+{
+   if (!val) {
+      flushDiagnostics();
+   }
+   m_batchDiagnostics = val;
+}
+
+void DiagnosticEngine::flushDiagnostics()
+{
+   if (m_storedDiagnostics.empty()) {
+      return;
+   }
+   // Rendering only reads the stored arguments and the AST they point to,
+   // so the diagnostics are independent of each other.
+   std::vector<std::string> texts(m_storedDiagnostics.size());
+   auto render = [this, &texts](std::size_t index) {
+      const StoredDiagnostic &stored = m_storedDiagnostics[index];
+      RawStringOutStream out(texts[index]);
+      formatDiagnosticText(out, diagnosticStringFor(stored.id), stored.args);
+   };
+   if (texts.size() >= sg_minParallelRenderCount) {
+      polar::utils::parallel::for_each_n(polar::utils::parallel::par,
+                                         std::size_t(0), texts.size(), render);
+   } else {
+      for (std::size_t index = 0; index < texts.size(); ++index) {
+         render(index);
+      }
+   }
+
+   ArrayRef<DiagnosticInfo::FixIt> fixIts = m_storedFixIts;
+   for (std::size_t index = 0; index < texts.size(); ++index) {
+      const StoredDiagnostic &stored = m_storedDiagnostics[index];
+      DiagnosticInfo info;
+      info.id = stored.id;
+      info.ranges = stored.ranges;
+      info.fixIts = fixIts.slice(stored.firstFixIt, stored.numFixIts);
+      info.formattedText = texts[index];
+      for (auto &consumer : m_consumers) {
+         consumer->handleDiagnostic(m_sourceMgr, stored.loc, stored.kind,
+                                    diagnosticStringFor(stored.id),
+                                    stored.args, info);
+      }
+   }
+
+   m_storedDiagnostics.clear();
+   m_storedFixIts.clear();
+   m_storedDiagnosticsByHash.clear();
+   m_batchArena.reset();
+}
+
+const char *DiagnosticEngine::diagnosticStringFor(const DiagID id)
+{
+   return sg_diagnosticStrings[(unsigned)id];
+}
+
+DiagnosticSuppression::DiagnosticSuppression(DiagnosticEngine &diags)
+   : m_diags(diags)
+{
+   m_consumers = m_diags.takeConsumers();
+}
+
+DiagnosticSuppression::~DiagnosticSuppression()
+{
+   for (auto consumer : m_consumers) {
+      m_diags.addConsumer(*consumer);
+   }
+}
+
+} // polar::ast
@@ -0,0 +1,367 @@
+//===--- Evaluator.cpp - Request Evaluator Implementation -----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2018 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//===----------------------------------------------------------------------===//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+//===----------------------------------------------------------------------===//
+//
+// This file implements the Evaluator class that evaluates and caches
+// requests.
+//
+//===----------------------------------------------------------------------===//
+
+#include "polarphp/ast/Evaluator.h"
+#include "polarphp/ast/DiagnosticEngine.h"
+#include "polarphp/basic/adt/IteratorRange.h"
+#include "polarphp/basic/adt/StringExtras.h"
+#include "polarphp/utils/Debug.h"
+#include "polarphp/utils/ErrorHandling.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <algorithm>
+
+namespace polar::ast {
+
+using polar::basic::make_range;
+using polar::basic::print_escaped_string;
+using polar::utils::RawFdOutStream;
+using polar::utils::RawStringOutStream;
+using polar::utils::error_stream;
+using polar::debug_stream;
+
+std::string AnyRequest::getAsString() const
+{
+   std::string result;
+   {
+      RawStringOutStream out(result);
+      simple_display(out, *this);
+   }
+   return result;
+}
+
+AnyRequest::HolderBase::~HolderBase()
+{}
+
+Evaluator::Evaluator(DiagnosticEngine &diags,
+                     CycleDiagnosticKind shouldDiagnoseCycles)
+   : m_diags(diags),
+     m_shouldDiagnoseCycles(shouldDiagnoseCycles)
+{}
+
+void Evaluator::emitRequestEvaluatorGraphViz(StringRef graphVizPath)
+{
+   std::error_code error;
+   RawFdOutStream out(graphVizPath, error, polar::fs::F_Text);
+   printDependenciesGraphviz(out);
+}
+
+bool Evaluator::checkDependency(const AnyRequest &request)
+{
+   // If there is an active request, record it's dependency on this request.
+   if (!m_activeRequests.empty()) {
+      const AnyRequest &dependent = m_activeRequests.back();
+      std::vector<AnyRequest> &dependsOn = m_dependencies[dependent];
+      if (std::find(dependsOn.begin(), dependsOn.end(), request) == dependsOn.end()) {
+         dependsOn.push_back(request);
+         m_dependents[request].push_back(dependent);
+      }
+   }
+
+   // Record this as an active request.
+   if (m_activeRequests.insert(request)) {
+      return false;
+   }
+
+   // Diagnose cycle.
+   switch (m_shouldDiagnoseCycles) {
+   case CycleDiagnosticKind::NoDiagnose:
+      return true;
+
+   case CycleDiagnosticKind::DebugDiagnose: {
+      error_stream() << "===CYCLE DETECTED===\n";
+      DenseSet<AnyRequest> visitedAnywhere;
+      SmallVector<AnyRequest, 4> visitedAlongPath;
+      std::string prefixStr;
+      printDependencies(m_activeRequests.front(), error_stream(), visitedAnywhere,
+                        visitedAlongPath, m_activeRequests.getArrayRef(),
+                        prefixStr, /*lastChild=*/true);
+      return true;
+   }
+
+   case CycleDiagnosticKind::FullDiagnose:
+      diagnoseCycle(request);
+      return true;
+   }
+
+   polar_unreachable("Unhandled CycleDiagnosticKind in switch.");
+}
+
+void Evaluator::diagnoseCycle(const AnyRequest &request)
+{
+   request.diagnoseCycle(m_diags);
+   ArrayRef<AnyRequest> activeRequests = m_activeRequests.getArrayRef();
+   for (const auto &step : make_range(activeRequests.rbegin(), activeRequests.rend())) {
+      if (step == request) {
+         return;
+      }
+      step.noteCycleStep(m_diags);
+   }
+   polar_unreachable("Diagnosed a cycle but it wasn't represented in the stack");
+}
+
+void Evaluator::clearDependencies(const AnyRequest &request)
+{
+   auto known = m_dependencies.find(request);
+   if (known == m_dependencies.end()) {
+      return;
+   }
+   for (const AnyRequest &dependency : known->second) {
+      auto dependents = m_dependents.find(dependency);
+      if (dependents == m_dependents.end()) {
+         continue;
+      }
+      std::vector<AnyRequest> &list = dependents->second;
+      list.erase(std::remove(list.begin(), list.end(), request), list.end());
+   }
+   m_dependencies.erase(known);
+}
+
+void Evaluator::noteSourceFileDependency(const SourceFile *file)
+{
+   if (m_activeRequests.empty()) {
+      return;
+   }
+   const AnyRequest &reader = m_activeRequests.back();
+   std::vector<AnyRequest> &readers = m_fileDependents[file];
+   if (std::find(readers.begin(), readers.end(), reader) == readers.end()) {
+      readers.push_back(reader);
+   }
+}
+
+unsigned Evaluator::invalidateSourceFile(const SourceFile *file)
+{
+   auto known = m_fileDependents.find(file);
+   if (known == m_fileDependents.end()) {
+      return 0;
+   }
+   SmallVector<AnyRequest, 8> worklist(known->second.begin(), known->second.end());
+   m_fileDependents.erase(known);
+   unsigned cacheSize = m_cache.size();
+   invalidateTransitively(worklist);
+   return cacheSize - m_cache.size();
+}
+
+void Evaluator::invalidateTransitively(SmallVectorImpl<AnyRequest> &worklist)
+{
+   assert(m_activeRequests.empty() && "invalidating while requests are evaluated");
+   DenseSet<AnyRequest> visited;
+   unsigned numInvalidated = 0;
+   while (!worklist.empty()) {
+      AnyRequest request = worklist.popBackValue();
+      if (!visited.insert(request).second) {
+         continue;
+      }
+      numInvalidated += m_cache.erase(request);
+      // everything computed from this request has to be computed again,
+      // the edges are recorded anew by that evaluation
+      auto dependents = m_dependents.find(request);
+      if (dependents != m_dependents.end()) {
+         worklist.append(dependents->second.begin(), dependents->second.end());
+         m_dependents.erase(dependents);
+      }
+      clearDependencies(request);
+   }
+   if (m_stats) {
+      m_stats->getFrontendCounters().NumEvaluatorInvalidations += numInvalidated;
+   }
+}
+
+void Evaluator::printDependencies(
+      const AnyRequest &request,
+      RawOutStream &out,
+      DenseSet<AnyRequest> &visitedAnywhere,
+      SmallVectorImpl<AnyRequest> &visitedAlongPath,
+      ArrayRef<AnyRequest> highlightPath,
+      std::string &prefixStr,
+      bool lastChild) const
+{
+   out << prefixStr << " `--";
+
+   // Determine whether this node should be highlighted.
+   bool isHighlighted = false;
+   if (std::find(highlightPath.begin(), highlightPath.end(), request)
+       != highlightPath.end()) {
+      isHighlighted = true;
+      out.changeColor(RawOutStream::Colors::GREEN);
+   }
+
+   // Print this node.
+   simple_display(out, request);
+
+   // Turn off the highlight.
+   if (isHighlighted) {
+      out.resetColor();
+   }
+
+   // Print the cached value, if known.
+   auto cachedValue = m_cache.find(request);
+   if (cachedValue != m_cache.end()) {
+      out << " -> ";
+      print_escaped_string(cachedValue->second.getAsString(), out);
+   }
+
+   if (!visitedAnywhere.insert(request).second) {
+      // We've already seed this node. Check whether it's part of a cycle.
+      if (std::find(visitedAlongPath.begin(), visitedAlongPath.end(), request)
+          != visitedAlongPath.end()) {
+         // We have a cyclic dependency.
+         out.changeColor(RawOutStream::Colors::RED);
+         out << " (cyclic dependency)\n";
+      } else {
+         // We have seen this node before, but it's not a cycle. Elide its
+         // children.
+         out << " (elided)\n";
+      }
+      out.resetColor();
+   } else if (m_dependencies.count(request) == 0) {
+      // We have not seen this node before, so we don't know its dependencies.
+      out.changeColor(RawOutStream::Colors::GREEN);
+      out << " (dependency not evaluated)\n";
+      out.resetColor();
+      // Remove from the visited set.
+      visitedAnywhere.erase(request);
+   } else {
+      // Print children.
+      out << "\n";
+      // Setup the prefix to print the children.
+      prefixStr += ' ';
+      prefixStr += (lastChild ? ' ' : '|');
+      prefixStr += "  ";
+      // Note that this request is along the path.
+      visitedAlongPath.push_back(request);
+      // Print the children.
+      auto &dependsOn = m_dependencies.find(request)->second;
+      for (unsigned i = 0, e = dependsOn.size(); i != e; ++i) {
+         printDependencies(dependsOn[i], out, visitedAnywhere, visitedAlongPath,
+                           highlightPath, prefixStr, i == dependsOn.size()-1);
+      }
+      // Drop our changes to the prefix.
+      prefixStr.erase(prefixStr.end() - 4, prefixStr.end());
+      // Remove from the visited set and path.
+      visitedAnywhere.erase(request);
+      assert(visitedAlongPath.back() == request);
+      visitedAlongPath.pop_back();
+   }
+}
+
+void Evaluator::dumpDependencies(const AnyRequest &request) const
+{
+   DenseSet<AnyRequest> visitedAnywhere;
+   SmallVector<AnyRequest, 4> visitedAlongPath;
+   std::string prefixStr;
+   printDependencies(request, debug_stream(), visitedAnywhere, visitedAlongPath,
+                     { }, prefixStr, /*lastChild=*/true);
+}
+
+void Evaluator::printDependenciesGraphviz(RawOutStream &out) const
+{
+   // Form a list of all of the requests we know about.
+   std::vector<AnyRequest> allRequests;
+   for (const auto &knownRequest : m_dependencies) {
+      allRequests.push_back(knownRequest.first);
+   }
+
+   // Sort the list of requests based on the display strings, so we get
+   // deterministic output.
+   std::sort(allRequests.begin(), allRequests.end(),
+             [&](const AnyRequest &lhs, const AnyRequest &rhs) {
+      return lhs.getAsString() < rhs.getAsString();
+   });
+
+   // Manage request IDs to use in the resulting output graph.
+   DenseMap<AnyRequest, unsigned> requestIDs;
+   unsigned nextID = 0;
+
+   // Prepopulate the known requests.
+   for (const auto &request : allRequests) {
+      requestIDs[request] = nextID++;
+   }
+
+   auto getRequestID = [&](const AnyRequest &request) {
+      auto known = requestIDs.find(request);
+      if (known != requestIDs.end()) {
+         return known->second;
+      }
+      // We discovered a new request; record it's ID and add it to the list of
+      // all requests.
+      allRequests.push_back(request);
+      requestIDs[request] = nextID;
+      return nextID++;
+   };
+
+   auto getNodeName = [&](const AnyRequest &request) {
+      std::string result;
+      {
+         RawStringOutStream out(result);
+         out << "request_" << getRequestID(request);
+      }
+      return result;
+   };
+
+   // Emit the graph header.
+   out << "digraph Dependencies {\n";
+
+   // Emit the edges, requests found only as targets have none of their own.
+   for (unsigned i = 0; i != allRequests.size(); ++i) {
+      AnyRequest source = allRequests[i];
+      auto known = m_dependencies.find(source);
+      if (known == m_dependencies.end()) {
+         continue;
+      }
+      for (const auto &target : known->second) {
+         out << "  " << getNodeName(source) << " -> " << getNodeName(target)
+             << ";\n";
+      }
+   }
+
+   out << "\n";
+
+   // Emit the nodes.
+   for (const auto &request : allRequests) {
+      out << "  " << getNodeName(request);
+      out << " [label=\"";
+      print_escaped_string(request.getAsString(), out);
+      auto cachedValue = m_cache.find(request);
+      if (cachedValue != m_cache.end()) {
+         out << " -> ";
+         print_escaped_string(cachedValue->second.getAsString(), out);
+      }
+      out << "\"];\n";
+   }
+
+   // Done!
+   out << "}\n";
+}
+
+void Evaluator::dumpDependenciesGraphviz() const
+{
+   printDependenciesGraphviz(debug_stream());
+}
+
+} // polar::ast
@@ -0,0 +1,59 @@
+//===--- Identifier.cpp - Uniqued Identifier ------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2017 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the Identifier interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "polarphp/ast/Identifier.h"
+#include "polarphp/utils/RawOutStream.h"
+
+namespace polar::basic {
+
+RawOutStream &operator<<(RawOutStream &outStream, Identifier identifier)
+{
+   if (identifier.empty()) {
+      return outStream << "_";
+   }
+   return outStream << identifier.str();
+}
+
+} // polar::basic
+
+namespace polar::ast {
+
+int Identifier::compare(Identifier other) const
+{
+   // Handle empty identifiers.
+   if (empty() || other.empty()) {
+      if (empty() != other.empty()) {
+         return other.empty() ? -1 : 1;
+      }
+      return 0;
+   }
+   return str().compare(other.str());
+}
+
+} // polar::ast
@@ -0,0 +1,185 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/ast/IdentifierTable.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/basic/adt/StringExtras.h"
+
+#include <cstring>
+
+namespace polar::ast {
+
+using polar::basic::SmallString;
+using polar::basic::to_lower;
+
+namespace {
+
+constexpr size_t sg_initialBucketCount = 1024;
+
+bool has_upper_ascii(StringRef text)
+{
+   for (char c : text) {
+      if (c >= 'A' && c <= 'Z') {
+         return true;
+      }
+   }
+   return false;
+}
+
+/// zend_inline_hash_func, DJBX33A with the high bit set so a hash is never
+/// zero, char is added with its own signedness exactly like the engine does
+template <typename Transform>
+uint64_t djb_hash(StringRef text, Transform transform)
+{
+   uint64_t hash = 5381;
+   for (char c : text) {
+      hash = ((hash << 5) + hash) + transform(c);
+   }
+   return hash | UINT64_C(0x8000000000000000);
+}
+
+} // anonymous namespace
+
+IdentifierTable::IdentifierTable()
+   : m_buckets(sg_initialBucketCount, Bucket{0, nullptr})
+{}
+
+IdentifierTable::~IdentifierTable()
+{}
+
+uint64_t IdentifierTable::hash(StringRef text)
+{
+   return djb_hash(text, [](char c) { return c; });
+}
+
+uint64_t IdentifierTable::hashCaseInsensitive(StringRef text)
+{
+   return djb_hash(text, [](char c) { return to_lower(c); });
+}
+
+Identifier IdentifierTable::get(StringRef text)
+{
+   uint64_t hashValue = hash(text);
+   if (const IdentifierEntry *entry = find(text, hashValue)) {
+      return Identifier(entry);
+   }
+   if (!has_upper_ascii(text)) {
+      return Identifier(insert(text, hashValue, hashValue, nullptr));
+   }
+   SmallString<64> lowered;
+   lowered.reserve(text.size());
+   for (char c : text) {
+      lowered.push_back(to_lower(c));
+   }
+   uint64_t foldedHash = hash(lowered);
+   const IdentifierEntry *folded = find(lowered, foldedHash);
+   if (!folded) {
+      folded = insert(lowered, foldedHash, foldedHash, nullptr);
+   }
+   return Identifier(insert(text, hashValue, foldedHash, folded));
+}
+
+Identifier IdentifierTable::lookup(StringRef text) const
+{
+   return Identifier(find(text, hash(text)));
+}
+
+Identifier IdentifierTable::lookupCaseInsensitive(StringRef text) const
+{
+   // the lowercased entry is stored under its own hash, which is the case
+   // insensitive hash of every other spelling
+   uint64_t foldedHash = hashCaseInsensitive(text);
+   size_t mask = m_buckets.size() - 1;
+   for (size_t index = foldedHash & mask; ; index = (index + 1) & mask) {
+      const Bucket &bucket = m_buckets[index];
+      if (!bucket.entry) {
+         return Identifier();
+      }
+      const IdentifierEntry *entry = bucket.entry;
+      if (bucket.hash == foldedHash && entry->folded == entry &&
+          StringRef(entry->text, entry->length).equalsLower(text)) {
+         return Identifier(entry);
+      }
+   }
+}
+
+const IdentifierEntry *IdentifierTable::find(StringRef text, uint64_t hash) const
+{
+   size_t mask = m_buckets.size() - 1;
+   for (size_t index = hash & mask; ; index = (index + 1) & mask) {
+      const Bucket &bucket = m_buckets[index];
+      if (!bucket.entry) {
+         return nullptr;
+      }
+      const IdentifierEntry *entry = bucket.entry;
+      if (bucket.hash == hash && entry->length == text.size() &&
+          std::memcmp(entry->text, text.data(), text.size()) == 0) {
+         return entry;
+      }
+   }
+}
+
+const IdentifierEntry *IdentifierTable::insert(StringRef text, uint64_t hash,
+                                               uint64_t foldedHash,
+                                               const IdentifierEntry *folded)
+{
+   if ((m_size + 1) * 4 > m_buckets.size() * 3) {
+      grow();
+   }
+   IdentifierEntry *entry = m_allocator.allocate<IdentifierEntry>();
+   entry->text = copyText(text);
+   entry->length = text.size();
+   entry->foldedHash = foldedHash;
+   entry->folded = folded ? folded : entry;
+   size_t mask = m_buckets.size() - 1;
+   size_t index = hash & mask;
+   while (m_buckets[index].entry) {
+      index = (index + 1) & mask;
+   }
+   m_buckets[index] = Bucket{hash, entry};
+   ++m_size;
+   return entry;
+}
+
+const char *IdentifierTable::copyText(StringRef text)
+{
+   if (m_externalInterner) {
+      StringRef shared = m_externalInterner(text);
+      if (shared.data()) {
+         assert(shared == text && shared.data()[shared.size()] == '\0' &&
+                "the external interner has to return the same nul terminated text");
+         return shared.data();
+      }
+   }
+   char *buffer = m_allocator.allocate<char>(text.size() + 1);
+   std::memcpy(buffer, text.data(), text.size());
+   buffer[text.size()] = '\0';
+   return buffer;
+}
+
+void IdentifierTable::grow()
+{
+   std::vector<Bucket> buckets(m_buckets.size() * 2, Bucket{0, nullptr});
+   size_t mask = buckets.size() - 1;
+   for (const Bucket &bucket : m_buckets) {
+      if (!bucket.entry) {
+         continue;
+      }
+      size_t index = bucket.hash & mask;
+      while (buckets[index].entry) {
+         index = (index + 1) & mask;
+      }
+      buckets[index] = bucket;
+   }
+   m_buckets.swap(buckets);
+}
+
+} // polar::ast
@@ -0,0 +1,43 @@
+//===--- AnyValue.cpp - Out-of-line code for AnyValue ---------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2018 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#include "polarphp/basic/AnyValue.h"
+#include "polarphp/utils/RawOutStream.h"
+
+namespace polar::basic {
+
+using polar::utils::RawStringOutStream;
+
+AnyValue::HolderBase::~HolderBase()
+{}
+
+std::string AnyValue::getAsString() const
+{
+   std::string result;
+   {
+      RawStringOutStream out(result);
+      simple_display(out, *this);
+   }
+   return result;
+}
+
+} // polar::basic
@@ -0,0 +1,400 @@
+//===--- LangStatistic.cpp - Swift unified stats reporting -----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2017 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/basic/LangStatistic.h"
+#include "polarphp/basic/adt/StringMap.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/Path.h"
+#include "polarphp/utils/Process.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace polar::basic {
+
+using polar::utils::NamedRegionTimer;
+using polar::utils::RawFdOutStream;
+using polar::utils::RawStringOutStream;
+using polar::utils::TimeRecord;
+using polar::utils::TimerGroup;
+using polar::utils::error_stream;
+
+namespace path = polar::fs::path;
+
+bool environment_variable_requested_maximum_determinism()
+{
+   if (const char *value = ::getenv("POLARPHP_DETERMINISTIC_HASHING")) {
+      return value[0] != '\0';
+   }
+   return false;
+}
+
+namespace {
+
+std::string make_file_name(StringRef prefix, StringRef programName,
+                           StringRef auxName, StringRef suffix)
+{
+   std::string tmp;
+   RawStringOutStream stream(tmp);
+   auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+   stream << prefix << "-" << usec.count() << "-" << programName << "-" << auxName
+          << "-" << polar::sys::Process::getRandomNumber() << "." << suffix;
+   return stream.getStr();
+}
+
+/// LLVM's statistics-reporting machinery is sensitive to filenames containing
+/// YAML-quote-requiring characters, which occur surprisingly often in the wild;
+/// we only need a recognizable and likely-unique name for a target here, not an
+/// exact filename, so we go with a crude approximation.
+std::string clean_name(StringRef name)
+{
+   std::string tmp;
+   for (char c : name) {
+      if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+          ('0' <= c && c <= '9') || (c == '.')) {
+         tmp += c;
+      } else {
+         tmp += '_';
+      }
+   }
+   return tmp;
+}
+
+std::string aux_name(StringRef moduleName, StringRef inputName, StringRef tripleName,
+                     StringRef outputType, StringRef optType)
+{
+   if (inputName.empty()) {
+      inputName = "all";
+   }
+   // Dispose of path prefix, which might make composite name too long.
+   inputName = path::filename(inputName);
+   if (optType.empty()) {
+      optType = "Onone";
+   }
+   if (!outputType.empty() && outputType.front() == '.') {
+      outputType = outputType.substr(1);
+   }
+   if (!optType.empty() && optType.front() == '-') {
+      optType = optType.substr(1);
+   }
+   return clean_name(moduleName) + "-" + clean_name(inputName) + "-" +
+         clean_name(tripleName) + "-" + clean_name(outputType) + "-" +
+         clean_name(optType);
+}
+
+} // anonymous namespace
+
+/// one timer per event name, an event entered again before it was left
+/// keeps running the timer of its outermost entry, so recursion is not
+/// counted twice
+class UnifiedStatsReporter::RecursionSafeTimers
+{
+   struct RecursionSafeTimer
+   {
+      std::optional<SharedTimer> timer;
+      size_t recursionDepth = 0;
+   };
+
+   StringMap<RecursionSafeTimer> m_timers;
+
+public:
+   void beginTimer(StringRef name)
+   {
+      RecursionSafeTimer &timer = m_timers[name];
+      if (timer.recursionDepth == 0) {
+         timer.timer.emplace(name);
+      }
+      ++timer.recursionDepth;
+   }
+
+   void endTimer(StringRef name)
+   {
+      auto iter = m_timers.find(name);
+      assert(iter != m_timers.end());
+      RecursionSafeTimer &timer = iter->getValue();
+      assert(timer.recursionDepth != 0);
+      --timer.recursionDepth;
+      if (timer.recursionDepth == 0) {
+         timer.timer.reset();
+      }
+   }
+};
+
+/// the flamegraph profiles of -profile-stats-events and
+/// -profile-stats-entities are not written yet, the flags are accepted
+/// and nothing is collected for them
+struct UnifiedStatsReporter::StatsProfilers
+{};
+
+UnifiedStatsReporter::UnifiedStatsReporter(StringRef programName,
+                                           StringRef moduleName,
+                                           StringRef inputName,
+                                           StringRef tripleName,
+                                           StringRef outputType,
+                                           StringRef optType,
+                                           StringRef directory,
+                                           SourceManager *sourceMgr,
+                                           bool traceEvents,
+                                           bool profileEvents,
+                                           bool profileEntities)
+   : UnifiedStatsReporter(programName,
+                          aux_name(moduleName, inputName, tripleName, outputType, optType),
+                          directory, sourceMgr, traceEvents, profileEvents, profileEntities)
+{}
+
+UnifiedStatsReporter::UnifiedStatsReporter(StringRef programName,
+                                           StringRef auxName,
+                                           StringRef directory,
+                                           SourceManager *sourceMgr,
+                                           bool traceEvents,
+                                           bool profileEvents,
+                                           bool profileEntities)
+   : m_currentProcessExitStatusSet(false),
+     m_currentProcessExitStatus(EXIT_FAILURE),
+     m_statsFilename(directory),
+     m_traceFilename(directory),
+     m_profileDirname(directory),
+     m_startedTime(TimeRecord::getCurrentTime()),
+     m_mainThreadID(std::this_thread::get_id()),
+     m_timer(std::make_unique<NamedRegionTimer>(auxName, "Building Target",
+                                                programName, "Running Program")),
+     m_sourceMgr(sourceMgr),
+     m_recursiveTimers(std::make_unique<RecursionSafeTimers>())
+{
+   path::append(m_statsFilename, make_file_name("stats", programName, auxName, "json"));
+   path::append(m_traceFilename, make_file_name("trace", programName, auxName, "csv"));
+   path::append(m_profileDirname, make_file_name("profile", programName, auxName, "dir"));
+   SharedTimer::enableCompilationTimers();
+   if (traceEvents) {
+      m_lastTracedFrontendCounters.emplace();
+      m_frontendStatsEvents.emplace();
+   }
+   (void) profileEvents;
+   (void) profileEntities;
+}
+
+UnifiedStatsReporter::AlwaysOnDriverCounters &
+UnifiedStatsReporter::getDriverCounters()
+{
+   if (!m_driverCounters) {
+      m_driverCounters.emplace();
+   }
+   return *m_driverCounters;
+}
+
+UnifiedStatsReporter::AlwaysOnFrontendCounters &
+UnifiedStatsReporter::getFrontendCounters()
+{
+   if (!m_frontendCounters) {
+      m_frontendCounters.emplace();
+   }
+   return *m_frontendCounters;
+}
+
+void UnifiedStatsReporter::noteCurrentProcessExitStatus(int status)
+{
+   assert(!m_currentProcessExitStatusSet);
+   m_currentProcessExitStatusSet = true;
+   m_currentProcessExitStatus = status;
+}
+
+void UnifiedStatsReporter::printAlwaysOnStatsAndTimers(RawOutStream &outStream)
+{
+   // Adapted from print_statistics_json
+   outStream << "{\n";
+   const char *delim = "";
+   if (m_frontendCounters) {
+      auto &counters = getFrontendCounters();
+#define FRONTEND_STATISTIC(TY, NAME)                              \
+   do {                                                           \
+      outStream << delim << "\t\"" #TY "." #NAME "\": " << counters.NAME; \
+      delim = ",\n";                                              \
+   } while (0);
+#include "polarphp/basic/LangStatisticDefs.h"
+#undef FRONTEND_STATISTIC
+   }
+   if (m_driverCounters) {
+      auto &counters = getDriverCounters();
+#define DRIVER_STATISTIC(NAME)                                    \
+   do {                                                           \
+      outStream << delim << "\t\"Driver." #NAME "\": " << counters.NAME; \
+      delim = ",\n";                                              \
+   } while (0);
+#include "polarphp/basic/LangStatisticDefs.h"
+#undef DRIVER_STATISTIC
+   }
+   // Print timers.
+   TimerGroup::printAllJSONValues(outStream, delim);
+   outStream << "\n}\n";
+   outStream.flush();
+}
+
+FrontendStatsTracer::FrontendStatsTracer(UnifiedStatsReporter *reporter,
+                                         StringRef eventName,
+                                         const void *entity,
+                                         const UnifiedStatsReporter::TraceFormatter *formatter)
+   : reporter(reporter),
+     savedTime(),
+     eventName(eventName),
+     entity(entity),
+     formatter(formatter)
+{
+   if (reporter) {
+      savedTime = TimeRecord::getCurrentTime();
+      reporter->saveAnyFrontendStatsEvents(*this, true);
+   }
+}
+
+FrontendStatsTracer::FrontendStatsTracer()
+   : reporter(nullptr),
+     entity(nullptr),
+     formatter(nullptr)
+{}
+
+FrontendStatsTracer &FrontendStatsTracer::operator=(FrontendStatsTracer &&other)
+{
+   reporter = other.reporter;
+   savedTime = other.savedTime;
+   eventName = other.eventName;
+   entity = other.entity;
+   formatter = other.formatter;
+   other.reporter = nullptr;
+   return *this;
+}
+
+FrontendStatsTracer::FrontendStatsTracer(FrontendStatsTracer &&other)
+   : reporter(other.reporter),
+     savedTime(other.savedTime),
+     eventName(other.eventName),
+     entity(other.entity),
+     formatter(other.formatter)
+{
+   other.reporter = nullptr;
+}
+
+FrontendStatsTracer::~FrontendStatsTracer()
+{
+   if (reporter) {
+      reporter->saveAnyFrontendStatsEvents(*this, false);
+   }
+}
+
+void UnifiedStatsReporter::saveAnyFrontendStatsEvents(FrontendStatsTracer const &tracer,
+                                                      bool isEntry)
+{
+   assert(m_mainThreadID == std::this_thread::get_id());
+   // First make a note in the recursion-safe timers; these
+   // are active anytime UnifiedStatsReporter is active.
+   if (isEntry) {
+      m_recursiveTimers->beginTimer(tracer.eventName);
+   } else {
+      m_recursiveTimers->endTimer(tracer.eventName);
+   }
+   // If we don't have a saved entry to form deltas against in the trace
+   // buffer, we're not tracing: return early.
+   if (!m_lastTracedFrontendCounters) {
+      return;
+   }
+   auto now = TimeRecord::getCurrentTime();
+   auto &current = getFrontendCounters();
+   auto &last = *m_lastTracedFrontendCounters;
+   auto startUS = uint64_t(1000000.0 * m_startedTime.getProcessTime());
+   auto nowUS = uint64_t(1000000.0 * now.getProcessTime());
+   auto liveUS = isEntry ? 0 : nowUS - uint64_t(1000000.0 * tracer.savedTime.getProcessTime());
+   auto timeUS = nowUS - startUS;
+#define FRONTEND_STATISTIC(TY, NAME)                                    \
+   if (current.NAME != last.NAME) {                                     \
+      m_frontendStatsEvents->emplace_back(FrontendStatsEvent{           \
+         timeUS, liveUS, isEntry, tracer.eventName, #NAME,              \
+         current.NAME - last.NAME, current.NAME,                        \
+         tracer.entity, tracer.formatter});                             \
+   }
+#include "polarphp/basic/LangStatisticDefs.h"
+#undef FRONTEND_STATISTIC
+   last = current;
+}
+
+UnifiedStatsReporter::TraceFormatter::~TraceFormatter()
+{}
+
+UnifiedStatsReporter::~UnifiedStatsReporter()
+{
+   // If nobody's marked this process as successful yet,
+   // mark it as failing.
+   if (m_currentProcessExitStatus != EXIT_SUCCESS) {
+      if (m_frontendCounters) {
+         ++getFrontendCounters().NumProcessFailures;
+      } else {
+         ++getDriverCounters().NumProcessFailures;
+      }
+   }
+   // The timer has to be stopped before the timers are printed, a scoped
+   // timer stopped by hand would be stopped twice.
+   m_timer.reset();
+   std::error_code errorCode;
+   RawFdOutStream ostream(m_statsFilename, errorCode, polar::fs::F_Append | polar::fs::F_Text);
+   if (errorCode) {
+      error_stream() << "Error opening -stats-output-dir file '"
+                     << m_statsFilename << "' for writing\n";
+      return;
+   }
+   printAlwaysOnStatsAndTimers(ostream);
+   flushTracesAndProfiles();
+}
+
+void UnifiedStatsReporter::flushTracesAndProfiles()
+{
+   if (!m_frontendStatsEvents || m_frontendStatsEvents->empty()) {
+      return;
+   }
+   std::error_code errorCode;
+   RawFdOutStream tstream(m_traceFilename, errorCode, polar::fs::F_Append | polar::fs::F_Text);
+   if (errorCode) {
+      error_stream() << "Error opening -trace-stats-events file '"
+                     << m_traceFilename << "' for writing\n";
+      return;
+   }
+   tstream << "Time,Live,IsEntry,EventName,CounterName,"
+           << "CounterDelta,CounterValue,EntityName,EntityRange\n";
+   for (const FrontendStatsEvent &event : *m_frontendStatsEvents) {
+      tstream << event.timeUSec << ','
+              << event.liveUSec << ','
+              << (event.isEntry ? "\"entry\"," : "\"exit\",")
+              << '"' << event.eventName << "\","
+              << '"' << event.counterName << "\","
+              << event.counterDelta << ','
+              << event.counterValue << ",\"";
+      if (event.formatter) {
+         event.formatter->traceName(event.entity, tstream);
+      }
+      tstream << "\",\"";
+      if (event.formatter) {
+         event.formatter->traceLoc(event.entity, m_sourceMgr, tstream);
+      }
+      tstream << "\"\n";
+   }
+   m_frontendStatsEvents->clear();
+}
+
+} // polar::basic
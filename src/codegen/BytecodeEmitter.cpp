@@ -0,0 +1,910 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/codegen/BytecodeEmitter.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/basic/adt/StringExtras.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace polar::codegen {
+
+using polar::basic::SmallString;
+using polar::basic::to_lower;
+
+namespace {
+
+constexpr uint32_t sg_noDef = ~0u;
+constexpr uint32_t sg_numericTypes = MAY_BE_LONG | MAY_BE_DOUBLE;
+
+/// the part after the last namespace separator, the whole name when
+/// there is none
+StringRef unqualified_name(StringRef name)
+{
+   size_t pos = name.rfind('\\');
+   return pos == StringRef::npos ? name : name.substr(pos + 1);
+}
+
+zend_string *lowercase_string(StringRef text)
+{
+   zend_string *result = zend_string_alloc(text.size(), 0);
+   zend_str_tolower_copy(ZSTR_VAL(result), text.data(), text.size());
+   return result;
+}
+
+/// zend_try_ct_eval_const(), persistent constants are substituted and so
+/// are true, false and null in any spelling, even unqualified ones inside
+/// a namespace
+bool try_resolve_constant(zval *result, zend_string *name, bool fullyQualified)
+{
+   zend_constant *constant = static_cast<zend_constant *>(zend_hash_find_ptr(EG(zend_constants), name));
+   if (constant && (
+          ((ZEND_CONSTANT_FLAGS(constant) & CONST_PERSISTENT)
+           && !(CG(compiler_options) & ZEND_COMPILE_NO_PERSISTENT_CONSTANT_SUBSTITUTION)
+           && (!(ZEND_CONSTANT_FLAGS(constant) & CONST_NO_FILE_CACHE) ||
+               !(CG(compiler_options) & ZEND_COMPILE_WITH_FILE_CACHE)))
+          || (Z_TYPE(constant->value) < IS_OBJECT &&
+              !(CG(compiler_options) & ZEND_COMPILE_NO_CONSTANT_SUBSTITUTION)))) {
+      ZVAL_COPY_OR_DUP(result, &constant->value);
+      return true;
+   }
+   StringRef lookupName(ZSTR_VAL(name), ZSTR_LEN(name));
+   if (!fullyQualified) {
+      lookupName = unqualified_name(lookupName);
+   }
+   SmallString<32> lowered;
+   for (char c : lookupName) {
+      lowered.push_back(to_lower(c));
+   }
+   constant = static_cast<zend_constant *>(
+            zend_hash_str_find_ptr(EG(zend_constants), lowered.getData(), lowered.getSize()));
+   if (constant && !(ZEND_CONSTANT_FLAGS(constant) & CONST_CS) &&
+       (ZEND_CONSTANT_FLAGS(constant) & CONST_CT_SUBST)) {
+      ZVAL_COPY_OR_DUP(result, &constant->value);
+      return true;
+   }
+   return false;
+}
+
+/// zend_try_ct_eval_binary_op(), what would fail or warn at runtime is
+/// left to runtime
+bool try_fold_binary_op(zval *result, zend_uchar opcode, zval *op1, zval *op2)
+{
+   binary_op_type function = get_binary_op(opcode);
+   if (!function) {
+      return false;
+   }
+   if ((opcode == ZEND_DIV || opcode == ZEND_MOD) && zval_get_long(op2) == 0) {
+      return false;
+   }
+   if ((opcode == ZEND_SL || opcode == ZEND_SR) && zval_get_long(op2) < 0) {
+      return false;
+   }
+   if (zend_binary_op_produces_numeric_string_error(opcode, op1, op2)) {
+      return false;
+   }
+   function(result, op1, op2);
+   return true;
+}
+
+bool is_bool_producer(zend_uchar opcode)
+{
+   return opcode == ZEND_BOOL || opcode == ZEND_BOOL_NOT ||
+         opcode == ZEND_JMPZ_EX || opcode == ZEND_JMPNZ_EX;
+}
+
+uint32_t type_of_value(const zval *value)
+{
+   if (Z_TYPE_P(value) == IS_ARRAY) {
+      return MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_ANY | MAY_BE_ARRAY_OF_ANY;
+   }
+   return 1u << Z_TYPE_P(value);
+}
+
+uint32_t type_of_return(zend_function *function)
+{
+   if (!function || !(function->common.fn_flags & ZEND_ACC_HAS_RETURN_TYPE)) {
+      return MAY_BE_ANY | MAY_BE_REF;
+   }
+   zend_type type = function->common.arg_info[-1].type;
+   if (!ZEND_TYPE_IS_CODE(type)) {
+      return MAY_BE_OBJECT | (ZEND_TYPE_ALLOW_NULL(type) ? MAY_BE_NULL : 0);
+   }
+   uint32_t result;
+   switch (ZEND_TYPE_CODE(type)) {
+   case _IS_BOOL:
+      result = MAY_BE_FALSE | MAY_BE_TRUE;
+      break;
+   case IS_VOID:
+      result = MAY_BE_NULL;
+      break;
+   case IS_ITERABLE:
+      result = MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_ANY | MAY_BE_ARRAY_OF_ANY | MAY_BE_OBJECT;
+      break;
+   case IS_CALLABLE:
+      result = MAY_BE_STRING | MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_ANY | MAY_BE_ARRAY_OF_ANY |
+            MAY_BE_OBJECT;
+      break;
+   case IS_ARRAY:
+      result = MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_ANY | MAY_BE_ARRAY_OF_ANY;
+      break;
+   default:
+      result = 1u << ZEND_TYPE_CODE(type);
+      break;
+   }
+   if (ZEND_TYPE_ALLOW_NULL(type)) {
+      result |= MAY_BE_NULL;
+   }
+   if (function->common.fn_flags & ZEND_ACC_RETURN_REFERENCE) {
+      result |= MAY_BE_REF;
+   }
+   return result;
+}
+
+/// the value types an input may have when it is read, an undefined
+/// variable reads as null and a reference may hold anything
+uint32_t read_type(uint32_t type)
+{
+   if (type & MAY_BE_REF) {
+      return MAY_BE_ANY;
+   }
+   uint32_t result = type & MAY_BE_ANY;
+   if (type & MAY_BE_UNDEF) {
+      result |= MAY_BE_NULL;
+   }
+   return result;
+}
+
+uint32_t arithmetic_type(zend_uchar opcode, uint32_t op1Type, uint32_t op2Type)
+{
+   uint32_t types = op1Type | op2Type;
+   if (types & MAY_BE_OBJECT) {
+      // operator overloading, gmp and the like
+      return MAY_BE_ANY;
+   }
+   uint32_t result = 0;
+   if (opcode == ZEND_ADD && (op1Type & MAY_BE_ARRAY) && (op2Type & MAY_BE_ARRAY)) {
+      result |= MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_ANY | MAY_BE_ARRAY_OF_ANY;
+   }
+   if (types & ~(sg_numericTypes | MAY_BE_ARRAY)) {
+      // strings, booleans and null turn into either
+      return result | sg_numericTypes;
+   }
+   if ((op1Type & MAY_BE_LONG) && (op2Type & MAY_BE_LONG)) {
+      // overflows and inexact divisions
+      result |= sg_numericTypes;
+   }
+   if (types & MAY_BE_DOUBLE) {
+      result |= MAY_BE_DOUBLE;
+   }
+   return result;
+}
+
+} // anonymous namespace
+
+BytecodeEmitter::BytecodeEmitter(zend_string *filename)
+   : m_opArray(static_cast<zend_op_array *>(emalloc(sizeof(zend_op_array)))),
+     m_opcodesCapacity(INITIAL_OP_ARRAY_SIZE)
+{
+   zend_string *previous = nullptr;
+   if (filename) {
+      previous = zend_get_compiled_filename();
+      zend_set_compiled_filename(filename);
+   }
+   init_op_array(m_opArray, ZEND_USER_FUNCTION, INITIAL_OP_ARRAY_SIZE);
+   if (filename) {
+      zend_restore_compiled_filename(previous);
+   }
+}
+
+BytecodeEmitter::~BytecodeEmitter()
+{
+   if (!m_finished) {
+      releaseConstants();
+      destroy_op_array(m_opArray);
+      efree(m_opArray);
+   }
+}
+
+Operand BytecodeEmitter::emitNull()
+{
+   zval value;
+   ZVAL_NULL(&value);
+   return addConstant(&value);
+}
+
+Operand BytecodeEmitter::emitBool(bool value)
+{
+   zval result;
+   ZVAL_BOOL(&result, value);
+   return addConstant(&result);
+}
+
+Operand BytecodeEmitter::emitLong(zend_long value)
+{
+   zval result;
+   ZVAL_LONG(&result, value);
+   return addConstant(&result);
+}
+
+Operand BytecodeEmitter::emitDouble(double value)
+{
+   zval result;
+   ZVAL_DOUBLE(&result, value);
+   return addConstant(&result);
+}
+
+Operand BytecodeEmitter::emitString(StringRef value)
+{
+   auto iter = m_stringConstants.find(value);
+   if (iter != m_stringConstants.end()) {
+      return Operand{OperandKind::Const, iter->getValue(), 0};
+   }
+   zval result;
+   ZVAL_STR(&result, zend_string_init(value.data(), value.size(), 0));
+   return addConstant(&result);
+}
+
+Operand BytecodeEmitter::emitLiteral(zval *value)
+{
+   return addConstant(value);
+}
+
+Operand BytecodeEmitter::addConstant(zval *value)
+{
+   uint32_t *known = nullptr;
+   switch (Z_TYPE_P(value)) {
+   case IS_NULL:
+      known = &m_scalarConstants[0];
+      break;
+   case IS_FALSE:
+      known = &m_scalarConstants[1];
+      break;
+   case IS_TRUE:
+      known = &m_scalarConstants[2];
+      break;
+   case IS_LONG:
+      known = &m_longConstants.emplace(Z_LVAL_P(value), ~0u).first->second;
+      break;
+   case IS_DOUBLE: {
+      uint64_t bits;
+      double number = Z_DVAL_P(value);
+      std::memcpy(&bits, &number, sizeof(bits));
+      known = &m_doubleConstants.emplace(bits, ~0u).first->second;
+      break;
+   }
+   case IS_STRING: {
+      Z_STR_P(value) = zend_new_interned_string(Z_STR_P(value));
+      if (ZSTR_IS_INTERNED(Z_STR_P(value))) {
+         Z_TYPE_FLAGS_P(value) = 0;
+      }
+      known = &m_stringConstants.insert(
+               std::make_pair(StringRef(Z_STRVAL_P(value), Z_STRLEN_P(value)), ~0u)).first->getValue();
+      break;
+   }
+   default:
+      break;
+   }
+   if (known && *known != ~0u) {
+      zval_ptr_dtor_nogc(value);
+      return Operand{OperandKind::Const, *known, 0};
+   }
+   uint32_t constant = m_constants.size();
+   m_constants.push_back(*value);
+   m_constantLiterals.push_back(~0u);
+   m_constantTypes.push_back(type_of_value(value));
+   if (known) {
+      *known = constant;
+   }
+   return Operand{OperandKind::Const, constant, 0};
+}
+
+uint32_t BytecodeEmitter::materializeConstant(uint32_t constant)
+{
+   uint32_t &literal = m_constantLiterals[constant];
+   if (literal == ~0u) {
+      zval value;
+      ZVAL_COPY(&value, &m_constants[constant]);
+      literal = addLiteral(&value);
+   }
+   return literal;
+}
+
+void BytecodeEmitter::releaseConstants()
+{
+   for (zval &value : m_constants) {
+      zval_ptr_dtor_nogc(&value);
+   }
+   m_constants.clear();
+}
+
+uint32_t BytecodeEmitter::addLiteral(zval *value)
+{
+   uint32_t literal = m_opArray->last_literal++;
+   if (literal >= m_literalsCapacity) {
+      m_literalsCapacity += 16;
+      m_opArray->literals = static_cast<zval *>(
+               erealloc(m_opArray->literals, m_literalsCapacity * sizeof(zval)));
+   }
+   if (Z_TYPE_P(value) == IS_STRING) {
+      Z_STR_P(value) = zend_new_interned_string(Z_STR_P(value));
+      if (ZSTR_IS_INTERNED(Z_STR_P(value))) {
+         Z_TYPE_FLAGS_P(value) = 0;
+      }
+   }
+   ZVAL_COPY_VALUE(&m_opArray->literals[literal], value);
+   return literal;
+}
+
+uint32_t BytecodeEmitter::addStringLiteral(zend_string *value)
+{
+   zval literal;
+   ZVAL_STR(&literal, value);
+   return addLiteral(&literal);
+}
+
+/// zend_add_func_name_literal() and zend_add_ns_func_name_literal(), the
+/// runtime looks at the literals after the first one
+uint32_t BytecodeEmitter::addFunctionNameLiterals(zend_string *name, bool inNamespace)
+{
+   StringRef text(ZSTR_VAL(name), ZSTR_LEN(name));
+   uint32_t first = addStringLiteral(name);
+   addStringLiteral(lowercase_string(text));
+   if (inNamespace) {
+      StringRef unqualified = unqualified_name(text);
+      if (unqualified.size() != text.size()) {
+         addStringLiteral(lowercase_string(unqualified));
+      }
+   }
+   return first;
+}
+
+/// zend_add_const_name_literal()
+uint32_t BytecodeEmitter::addConstantNameLiterals(zend_string *name, bool unqualified)
+{
+   StringRef text(ZSTR_VAL(name), ZSTR_LEN(name));
+   uint32_t first = addStringLiteral(name);
+   StringRef constantName = unqualified_name(text);
+   if (constantName.size() != text.size()) {
+      size_t namespaceLength = text.size() - constantName.size() - 1;
+      // lowercased namespace with the original constant name
+      zend_string *mixed = zend_string_init(text.data(), text.size(), 0);
+      zend_str_tolower(ZSTR_VAL(mixed), namespaceLength);
+      addStringLiteral(mixed);
+      addStringLiteral(lowercase_string(text));
+      if (!unqualified) {
+         return first;
+      }
+   }
+   addStringLiteral(zend_string_init(constantName.data(), constantName.size(), 0));
+   addStringLiteral(lowercase_string(constantName));
+   return first;
+}
+
+uint32_t BytecodeEmitter::allocateCacheSlot()
+{
+   uint32_t slot = m_opArray->cache_size;
+   m_opArray->cache_size += sizeof(void *);
+   return slot;
+}
+
+Operand BytecodeEmitter::getVariable(StringRef name)
+{
+   auto iter = m_variables.find(name);
+   if (iter != m_variables.end()) {
+      return Operand{OperandKind::Cv, iter->getValue(), 0};
+   }
+   uint32_t var = m_opArray->last_var++;
+   if (var >= m_varsCapacity) {
+      m_varsCapacity += 16;
+      m_opArray->vars = static_cast<zend_string **>(
+               erealloc(m_opArray->vars, m_varsCapacity * sizeof(zend_string *)));
+   }
+   m_opArray->vars[var] = zend_new_interned_string(zend_string_init(name.data(), name.size(), 0));
+   m_variables[name] = var;
+   m_variableTypes.push_back(MAY_BE_UNDEF);
+   m_escapedVariables.push_back(false);
+   return Operand{OperandKind::Cv, var, 0};
+}
+
+void BytecodeEmitter::markVariableEscaped(Operand variable)
+{
+   assert(variable.kind == OperandKind::Cv && "only compiled variables escape");
+   m_escapedVariables[variable.index] = true;
+}
+
+uint32_t BytecodeEmitter::allocateSlot()
+{
+   for (uint32_t slot = 0; slot < m_numSlots; ++slot) {
+      if (m_freeSlots[slot]) {
+         m_freeSlots[slot] = false;
+         return slot;
+      }
+   }
+   m_freeSlots.push_back(false);
+   return m_numSlots++;
+}
+
+void BytecodeEmitter::releaseOperand(Operand operand)
+{
+   if (operand.isTemporary()) {
+      assert(!m_freeSlots[operand.index] && "temporary consumed twice");
+      m_freeSlots[operand.index] = true;
+   }
+}
+
+zend_op *BytecodeEmitter::emitOp(zend_uchar opcode, Operand op1, Operand op2)
+{
+   if (m_opArray->last == m_opcodesCapacity) {
+      m_opcodesCapacity *= 4;
+      m_opArray->opcodes = static_cast<zend_op *>(
+               erealloc(m_opArray->opcodes, m_opcodesCapacity * sizeof(zend_op)));
+   }
+   zend_op *opline = &m_opArray->opcodes[m_opArray->last++];
+   std::memset(opline, 0, sizeof(zend_op));
+   opline->opcode = opcode;
+   opline->lineno = m_line;
+   m_oplineInfos.push_back(OplineInfo{sg_noDef, sg_noDef, 0});
+   OplineInfo &info = m_oplineInfos.back();
+   setOperand(opline, opline->op1, opline->op1_type, op1, info.op1Def);
+   setOperand(opline, opline->op2, opline->op2_type, op2, info.op2Def);
+   return opline;
+}
+
+void BytecodeEmitter::setOperand(zend_op *opline, znode_op &node, zend_uchar &type,
+                                 Operand operand, uint32_t &def)
+{
+   switch (operand.kind) {
+   case OperandKind::Unused:
+      return;
+   case OperandKind::Const:
+      type = IS_CONST;
+      node.constant = materializeConstant(operand.index);
+      return;
+   case OperandKind::Cv:
+      type = IS_CV;
+      node.var = static_cast<uint32_t>(reinterpret_cast<zend_intptr_t>(
+                                          ZEND_CALL_VAR_NUM(nullptr, operand.index)));
+      return;
+   case OperandKind::Tmp:
+   case OperandKind::Var:
+      break;
+   }
+   type = operand.kind == OperandKind::Tmp ? IS_TMP_VAR : IS_VAR;
+   node.var = operand.index;
+   def = operand.def;
+   uint32_t opnum = opline - m_opArray->opcodes;
+   if (operand.def + 1 == opnum || is_bool_producer(m_opArray->opcodes[operand.def].opcode)) {
+      return;
+   }
+   // the value is live across other instructions, which have to free it
+   // when they throw, what zend_find_live_range() does
+   uint32_t range = m_opArray->last_live_range++;
+   m_opArray->live_range = static_cast<zend_live_range *>(
+            erealloc(m_opArray->live_range, m_opArray->last_live_range * sizeof(zend_live_range)));
+   m_opArray->live_range[range].start = operand.def + 1;
+   m_opArray->live_range[range].end = opnum;
+   m_opArray->live_range[range].var = (operand.index * sizeof(zval)) | ZEND_LIVE_TMPVAR;
+}
+
+Operand BytecodeEmitter::makeResult(zend_op *opline, OperandKind kind)
+{
+   uint32_t slot = allocateSlot();
+   opline->result_type = kind == OperandKind::Tmp ? IS_TMP_VAR : IS_VAR;
+   opline->result.var = slot;
+   return Operand{kind, slot, static_cast<uint32_t>(opline - m_opArray->opcodes)};
+}
+
+Operand BytecodeEmitter::emitBinaryOp(zend_uchar opcode, Operand lhs, Operand rhs)
+{
+   if (lhs.isConst() && rhs.isConst()) {
+      zval result;
+      if (try_fold_binary_op(&result, opcode, &m_constants[lhs.index], &m_constants[rhs.index])) {
+         return addConstant(&result);
+      }
+   }
+   zend_op *opline = emitOp(opcode, lhs, rhs);
+   // the result is allocated before the inputs are released, handlers
+   // write it before they free their operands
+   Operand result = makeResult(opline, OperandKind::Tmp);
+   releaseOperand(lhs);
+   releaseOperand(rhs);
+   return result;
+}
+
+Operand BytecodeEmitter::emitUnaryOp(zend_uchar opcode, Operand operand)
+{
+   if (operand.isConst()) {
+      zval *value = &m_constants[operand.index];
+      zval result;
+      if (opcode == ZEND_BOOL || opcode == ZEND_BOOL_NOT) {
+         bool truth = zend_is_true(value);
+         ZVAL_BOOL(&result, opcode == ZEND_BOOL ? truth : !truth);
+         return addConstant(&result);
+      }
+      if (opcode == ZEND_BW_NOT && Z_TYPE_P(value) >= IS_LONG && Z_TYPE_P(value) <= IS_STRING) {
+         get_unary_op(opcode)(&result, value);
+         return addConstant(&result);
+      }
+   }
+   zend_op *opline = emitOp(opcode, operand, Operand());
+   Operand result = makeResult(opline, OperandKind::Tmp);
+   releaseOperand(operand);
+   return result;
+}
+
+Operand BytecodeEmitter::emitFetchConstant(StringRef name, bool fullyQualified, bool inNamespace)
+{
+   zend_string *resolved = zend_string_init(name.data(), name.size(), 0);
+   zval value;
+   if (try_resolve_constant(&value, resolved, fullyQualified)) {
+      zend_string_release(resolved);
+      return addConstant(&value);
+   }
+   zend_op *opline = emitOp(ZEND_FETCH_CONSTANT, Operand(), Operand());
+   opline->op2_type = IS_CONST;
+   if (fullyQualified) {
+      opline->op2.constant = addConstantNameLiterals(resolved, false);
+   } else {
+      opline->op1.num = IS_CONSTANT_UNQUALIFIED;
+      if (inNamespace) {
+         opline->op1.num |= IS_CONSTANT_IN_NAMESPACE;
+      }
+      opline->op2.constant = addConstantNameLiterals(resolved, inNamespace);
+   }
+   opline->extended_value = allocateCacheSlot();
+   m_oplineInfos.back().resultType = MAY_BE_ANY;
+   return makeResult(opline, OperandKind::Tmp);
+}
+
+void BytecodeEmitter::beginFunctionCall(StringRef name, bool fullyQualified, bool inNamespace)
+{
+   zend_string *resolved = zend_string_init(name.data(), name.size(), 0);
+   uint32_t init = m_opArray->last;
+   if (!fullyQualified && inNamespace) {
+      // the global function is the fallback, only the runtime knows
+      zend_op *opline = emitOp(ZEND_INIT_NS_FCALL_BY_NAME, Operand(), Operand());
+      opline->op2_type = IS_CONST;
+      opline->op2.constant = addFunctionNameLiterals(resolved, true);
+      opline->result.num = allocateCacheSlot();
+      m_calls.push_back(PendingCall{init, nullptr, 0});
+      return;
+   }
+   zend_string *lowercased = zend_string_tolower(resolved);
+   zend_function *function = static_cast<zend_function *>(
+            zend_hash_find_ptr(CG(function_table), lowercased));
+   if (!function ||
+       (function->type == ZEND_INTERNAL_FUNCTION &&
+        (CG(compiler_options) & ZEND_COMPILE_IGNORE_INTERNAL_FUNCTIONS)) ||
+       (function->type == ZEND_USER_FUNCTION &&
+        (CG(compiler_options) & ZEND_COMPILE_IGNORE_USER_FUNCTIONS))) {
+      zend_string_release(lowercased);
+      zend_op *opline = emitOp(ZEND_INIT_FCALL_BY_NAME, Operand(), Operand());
+      opline->op2_type = IS_CONST;
+      opline->op2.constant = addFunctionNameLiterals(resolved, false);
+      opline->result.num = allocateCacheSlot();
+      m_calls.push_back(PendingCall{init, nullptr, 0});
+      return;
+   }
+   zend_string_release(resolved);
+   zend_op *opline = emitOp(ZEND_INIT_FCALL, Operand(), Operand());
+   opline->op2_type = IS_CONST;
+   opline->op2.constant = addStringLiteral(lowercased);
+   opline->result.num = allocateCacheSlot();
+   m_calls.push_back(PendingCall{init, function, 0});
+}
+
+void BytecodeEmitter::emitSendArgument(Operand argument)
+{
+   assert(!m_calls.empty() && "argument outside of a call");
+   PendingCall &call = m_calls.back();
+   zend_function *function = call.function;
+   uint32_t argNum = ++call.numArgs;
+   zend_uchar opcode;
+   // the choice zend_compile_args() makes
+   switch (argument.kind) {
+   case OperandKind::Var:
+      if (!function) {
+         opcode = ZEND_SEND_VAR_NO_REF_EX;
+      } else if (ARG_MUST_BE_SENT_BY_REF(function, argNum)) {
+         opcode = ZEND_SEND_VAR_NO_REF;
+      } else if (ARG_MAY_BE_SENT_BY_REF(function, argNum)) {
+         opcode = ZEND_SEND_VAL;
+      } else {
+         opcode = ZEND_SEND_VAR;
+      }
+      break;
+   case OperandKind::Cv:
+      if (!function) {
+         opcode = ZEND_SEND_VAR_EX;
+         markVariableEscaped(argument);
+      } else if (ARG_SHOULD_BE_SENT_BY_REF(function, argNum)) {
+         opcode = ZEND_SEND_REF;
+         markVariableEscaped(argument);
+      } else {
+         opcode = ZEND_SEND_VAR;
+      }
+      break;
+   default:
+      if (!function) {
+         opcode = ZEND_SEND_VAL_EX;
+      } else {
+         if (ARG_MUST_BE_SENT_BY_REF(function, argNum)) {
+            zend_error_noreturn(E_COMPILE_ERROR, "Only variables can be passed by reference");
+         }
+         opcode = ZEND_SEND_VAL;
+      }
+      break;
+   }
+   zend_op *opline = emitOp(opcode, argument, Operand());
+   opline->op2.opline_num = argNum;
+   opline->result.var = static_cast<uint32_t>(reinterpret_cast<zend_intptr_t>(
+                                                 ZEND_CALL_ARG(nullptr, argNum)));
+   releaseOperand(argument);
+}
+
+Operand BytecodeEmitter::endFunctionCall()
+{
+   assert(!m_calls.empty() && "no call to end");
+   PendingCall call = m_calls.back();
+   m_calls.pop_back();
+   zend_op *init = &m_opArray->opcodes[call.init];
+   init->extended_value = call.numArgs;
+   if (init->opcode == ZEND_INIT_FCALL) {
+      init->op1.num = zend_vm_calc_used_stack(call.numArgs, call.function);
+   }
+   zend_uchar opcode = zend_get_call_op(init, call.function);
+   zend_op *opline = emitOp(opcode, Operand(), Operand());
+   m_oplineInfos.back().resultType = type_of_return(call.function);
+   return makeResult(opline, OperandKind::Var);
+}
+
+Operand BytecodeEmitter::emitAssign(Operand variable, Operand value)
+{
+   assert(variable.kind == OperandKind::Cv && "only compiled variables are assigned");
+   zend_op *opline = emitOp(ZEND_ASSIGN, variable, value);
+   Operand result = makeResult(opline, OperandKind::Var);
+   releaseOperand(value);
+   return result;
+}
+
+void BytecodeEmitter::emitEcho(Operand value)
+{
+   emitOp(ZEND_ECHO, value, Operand());
+   releaseOperand(value);
+}
+
+void BytecodeEmitter::emitReturn(Operand value)
+{
+   if (value.kind == OperandKind::Unused) {
+      value = emitNull();
+   }
+   emitOp(ZEND_RETURN, value, Operand());
+   releaseOperand(value);
+}
+
+void BytecodeEmitter::emitFree(Operand value)
+{
+   if (!value.isTemporary()) {
+      return;
+   }
+   uint32_t last = m_opArray->last - 1;
+   zend_op &defining = m_opArray->opcodes[value.def];
+   if (value.def == last && value.kind == OperandKind::Var) {
+      // nobody reads the result, zend_do_free() does the same
+      defining.result_type = IS_UNUSED;
+      m_oplineInfos[value.def].resultType = 0;
+   } else if (!(value.def == last && is_bool_producer(defining.opcode))) {
+      emitOp(ZEND_FREE, value, Operand());
+   }
+   releaseOperand(value);
+}
+
+Label BytecodeEmitter::createLabel()
+{
+   m_labels.push_back(~0u);
+   return m_labels.size() - 1;
+}
+
+void BytecodeEmitter::bindLabel(Label label)
+{
+   assert(m_labels[label] == ~0u && "label bound twice");
+   m_labels[label] = m_opArray->last;
+}
+
+void BytecodeEmitter::emitJump(Label target)
+{
+   m_fixups.push_back(JumpFixup{m_opArray->last, target});
+   emitOp(ZEND_JMP, Operand(), Operand());
+}
+
+void BytecodeEmitter::emitJumpIfFalse(Operand condition, Label target)
+{
+   emitJumpIf(ZEND_JMPZ, condition, target);
+}
+
+void BytecodeEmitter::emitJumpIfTrue(Operand condition, Label target)
+{
+   emitJumpIf(ZEND_JMPNZ, condition, target);
+}
+
+void BytecodeEmitter::emitJumpIf(zend_uchar opcode, Operand condition, Label target)
+{
+   if (condition.isConst()) {
+      // the branch is known, it is either an unconditional jump or none
+      if (zend_is_true(&m_constants[condition.index]) == (opcode == ZEND_JMPNZ)) {
+         emitJump(target);
+      }
+      return;
+   }
+   m_fixups.push_back(JumpFixup{m_opArray->last, target});
+   emitOp(opcode, condition, Operand());
+   releaseOperand(condition);
+}
+
+zend_op_array *BytecodeEmitter::finish()
+{
+   assert(!m_finished && "op array finished twice");
+   assert(m_calls.empty() && "call left open");
+   zend_op *ret = emitOp(ZEND_RETURN, emitNull(), Operand());
+   ret->extended_value = -1;
+   for (const JumpFixup &fixup : m_fixups) {
+      uint32_t target = m_labels[fixup.label];
+      assert(target != ~0u && "jump to a label that is never bound");
+      zend_op &opline = m_opArray->opcodes[fixup.opnum];
+      if (opline.opcode == ZEND_JMP) {
+         opline.op1.opline_num = target;
+      } else {
+         opline.op2.opline_num = target;
+      }
+   }
+   inferTypes();
+   releaseConstants();
+   m_opArray->T = m_numSlots;
+   m_opArray->line_start = m_opArray->last ? m_opArray->opcodes[0].lineno : m_line;
+   m_opArray->line_end = m_line;
+   // pass_two() trims the arrays to the sizes the compiler context claims
+   zend_oparray_context previous = CG(context);
+   CG(context).opcodes_size = m_opcodesCapacity;
+   CG(context).literals_size = m_literalsCapacity;
+   CG(context).vars_size = m_varsCapacity;
+   pass_two(m_opArray);
+   CG(context) = previous;
+   m_finished = true;
+   return m_opArray;
+}
+
+uint32_t BytecodeEmitter::getInputType(zend_uchar type, znode_op node, uint32_t def) const
+{
+   switch (type) {
+   case IS_CONST:
+      return type_of_value(&m_opArray->literals[node.constant]);
+   case IS_CV:
+      return m_variableTypes[EX_VAR_TO_NUM(node.var)];
+   case IS_TMP_VAR:
+   case IS_VAR:
+      return m_oplineInfos[def].resultType;
+   default:
+      return 0;
+   }
+}
+
+uint32_t BytecodeEmitter::computeResultType(const zend_op &opline, uint32_t op1Type,
+                                            uint32_t op2Type) const
+{
+   uint32_t t1 = read_type(op1Type);
+   uint32_t t2 = read_type(op2Type);
+   switch (opline.opcode) {
+   case ZEND_ADD:
+   case ZEND_SUB:
+   case ZEND_MUL:
+   case ZEND_DIV:
+   case ZEND_POW:
+      return arithmetic_type(opline.opcode, t1, t2);
+   case ZEND_MOD:
+   case ZEND_SL:
+   case ZEND_SR:
+      return ((t1 | t2) & MAY_BE_OBJECT) ? MAY_BE_ANY : MAY_BE_LONG;
+   case ZEND_BW_OR:
+   case ZEND_BW_AND:
+   case ZEND_BW_XOR:
+      if ((t1 | t2) & MAY_BE_OBJECT) {
+         return MAY_BE_ANY;
+      }
+      return (t1 & t2 & MAY_BE_STRING) ? MAY_BE_LONG | MAY_BE_STRING : MAY_BE_LONG;
+   case ZEND_BW_NOT:
+      if (t1 & MAY_BE_OBJECT) {
+         return MAY_BE_ANY;
+      }
+      return (t1 & MAY_BE_STRING) ? MAY_BE_LONG | MAY_BE_STRING : MAY_BE_LONG;
+   case ZEND_CONCAT:
+   case ZEND_FAST_CONCAT:
+      return ((t1 | t2) & MAY_BE_OBJECT) ? MAY_BE_ANY : MAY_BE_STRING;
+   case ZEND_IS_IDENTICAL:
+   case ZEND_IS_NOT_IDENTICAL:
+   case ZEND_IS_EQUAL:
+   case ZEND_IS_NOT_EQUAL:
+   case ZEND_IS_SMALLER:
+   case ZEND_IS_SMALLER_OR_EQUAL:
+   case ZEND_BOOL_XOR:
+   case ZEND_BOOL:
+   case ZEND_BOOL_NOT:
+      return MAY_BE_FALSE | MAY_BE_TRUE;
+   case ZEND_SPACESHIP:
+      return MAY_BE_LONG;
+   case ZEND_ASSIGN:
+      return opline.result_type == IS_UNUSED ? 0 : t2;
+   default:
+      return m_oplineInfos[&opline - m_opArray->opcodes].resultType;
+   }
+}
+
+void BytecodeEmitter::inferTypes()
+{
+   for (size_t var = 0; var < m_variableTypes.size(); ++var) {
+      if (m_escapedVariables[var]) {
+         m_variableTypes[var] = MAY_BE_UNDEF | MAY_BE_ANY | MAY_BE_REF;
+      }
+   }
+   // assignments inside loops feed earlier instructions, so this runs to
+   // a fixed point, every mask only grows and there are few bits
+   bool changed = true;
+   while (changed) {
+      changed = false;
+      for (uint32_t opnum = 0; opnum < m_opArray->last; ++opnum) {
+         const zend_op &opline = m_opArray->opcodes[opnum];
+         OplineInfo &info = m_oplineInfos[opnum];
+         uint32_t op1Type = getInputType(opline.op1_type, opline.op1, info.op1Def);
+         uint32_t op2Type = getInputType(opline.op2_type, opline.op2, info.op2Def);
+         uint32_t resultType = computeResultType(opline, op1Type, op2Type);
+         if (resultType != info.resultType) {
+            info.resultType = resultType;
+            changed = true;
+         }
+         if (opline.opcode == ZEND_ASSIGN) {
+            uint32_t var = EX_VAR_TO_NUM(opline.op1.var);
+            uint32_t type = m_variableTypes[var] | read_type(op2Type);
+            if (type != m_variableTypes[var]) {
+               m_variableTypes[var] = type;
+               changed = true;
+            }
+         }
+      }
+   }
+}
+
+uint32_t BytecodeEmitter::getResultType(uint32_t opnum) const
+{
+   return m_oplineInfos[opnum].resultType;
+}
+
+uint32_t BytecodeEmitter::getVariableType(uint32_t var) const
+{
+   return m_variableTypes[var];
+}
+
+uint32_t BytecodeEmitter::getOperandType(Operand operand) const
+{
+   switch (operand.kind) {
+   case OperandKind::Const:
+      return m_constantTypes[operand.index];
+   case OperandKind::Cv:
+      return m_variableTypes[operand.index];
+   case OperandKind::Tmp:
+   case OperandKind::Var:
+      return m_oplineInfos[operand.def].resultType;
+   default:
+      return 0;
+   }
+}
+
+} // polar::codegen
@@ -0,0 +1,493 @@
+//===--- AST.cpp - Markup AST nodes ---------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2017 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://swift.org/LICENSE.txt for license information
+// See https://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/markup/Ast.h"
+#include "polarphp/markup/Markup.h"
+#include "polarphp/basic/adt/StringSwitch.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <algorithm>
+
+namespace polar::markup {
+
+using polar::basic::StringSwitch;
+using polar::utils::dyn_cast;
+
+void *MarkupAstNode::operator new(size_t bytes, MarkupContext &mcontext,
+                                  unsigned alignment)
+{
+   return mcontext.allocate(bytes, alignment);
+}
+
+ArrayRef<MarkupAstNode *> MarkupAstNode::getChildren()
+{
+   switch (m_kind) {
+#define MARKUP_AST_NODE(Id, Parent) \
+   case AstNodeKind::Id: \
+      return cast<Id>(this)->getChildren();
+#define ABSTRACT_MARKUP_AST_NODE(Id, Parent)
+#define MARKUP_AST_NODE_RANGE(Id, FirstId, LastId)
+#include "polarphp/markup/AstNodesDefs.h"
+   }
+   polar_unreachable("unknown markup node kind");
+}
+
+ArrayRef<const MarkupAstNode *> MarkupAstNode::getChildren() const
+{
+   switch (m_kind) {
+#define MARKUP_AST_NODE(Id, Parent) \
+   case AstNodeKind::Id: \
+      return cast<Id>(this)->getChildren();
+#define ABSTRACT_MARKUP_AST_NODE(Id, Parent)
+#define MARKUP_AST_NODE_RANGE(Id, FirstId, LastId)
+#include "polarphp/markup/AstNodesDefs.h"
+   }
+   polar_unreachable("unknown markup node kind");
+}
+
+Document::Document(ArrayRef<MarkupAstNode *> children)
+   : MarkupAstNode(AstNodeKind::Document),
+     m_numChildren(children.size())
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Document *Document::create(MarkupContext &mcontext,
+                           ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Document));
+   return new (mem) Document(children);
+}
+
+BlockQuote::BlockQuote(ArrayRef<MarkupAstNode *> children)
+   : MarkupAstNode(AstNodeKind::BlockQuote),
+     m_numChildren(children.size())
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+BlockQuote *BlockQuote::create(MarkupContext &mcontext,
+                               ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(BlockQuote));
+   return new (mem) BlockQuote(children);
+}
+
+HTML *HTML::create(MarkupContext &mcontext, StringRef literalContent)
+{
+   void *mem = mcontext.allocate(sizeof(HTML), alignof(HTML));
+   return new (mem) HTML(literalContent);
+}
+
+InlineHTML *InlineHTML::create(MarkupContext &mcontext, StringRef literalContent)
+{
+   void *mem = mcontext.allocate(sizeof(InlineHTML), alignof(InlineHTML));
+   return new (mem) InlineHTML(literalContent);
+}
+
+List::List(ArrayRef<MarkupAstNode *> children, bool isOrdered)
+   : MarkupAstNode(AstNodeKind::List),
+     m_numChildren(children.size()),
+     m_ordered(isOrdered)
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+List *List::create(MarkupContext &mcontext, ArrayRef<MarkupAstNode *> children,
+                   bool isOrdered)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(List));
+   return new (mem) List(children, isOrdered);
+}
+
+Item::Item(ArrayRef<MarkupAstNode *> children)
+   : MarkupAstNode(AstNodeKind::Item),
+     m_numChildren(children.size())
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Item *Item::create(MarkupContext &mcontext, ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Item));
+   return new (mem) Item(children);
+}
+
+Link::Link(StringRef destination, ArrayRef<MarkupAstNode *> children)
+   : InlineContent(AstNodeKind::Link),
+     m_numChildren(children.size()),
+     m_destination(destination)
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Link *Link::create(MarkupContext &mcontext, StringRef destination,
+                   ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Link));
+   StringRef destinationCopy = mcontext.allocateCopy(destination);
+   return new (mem) Link(destinationCopy, children);
+}
+
+Image::Image(StringRef destination, std::optional<StringRef> title,
+             ArrayRef<MarkupAstNode *> children)
+   : InlineContent(AstNodeKind::Image),
+     m_numChildren(children.size()),
+     m_destination(destination),
+     m_title(title)
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Image *Image::create(MarkupContext &mcontext, StringRef destination,
+                     std::optional<StringRef> title,
+                     ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Image));
+   StringRef destinationCopy = mcontext.allocateCopy(destination);
+   std::optional<StringRef> titleCopy;
+   if (title) {
+      titleCopy = mcontext.allocateCopy(*title);
+   }
+   return new (mem) Image(destinationCopy, titleCopy, children);
+}
+
+Header::Header(unsigned level, ArrayRef<MarkupAstNode *> children)
+   : MarkupAstNode(AstNodeKind::Header),
+     m_numChildren(children.size()),
+     m_level(level)
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Header *Header::create(MarkupContext &mcontext, unsigned level,
+                       ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Header));
+   return new (mem) Header(level, children);
+}
+
+Paragraph::Paragraph(ArrayRef<MarkupAstNode *> children)
+   : MarkupAstNode(AstNodeKind::Paragraph),
+     m_numChildren(children.size())
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Paragraph *Paragraph::create(MarkupContext &mcontext,
+                             ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Paragraph));
+   return new (mem) Paragraph(children);
+}
+
+HRule *HRule::create(MarkupContext &mcontext)
+{
+   void *mem = mcontext.allocate(sizeof(HRule), alignof(HRule));
+   return new (mem) HRule();
+}
+
+Text *Text::create(MarkupContext &mcontext, StringRef literalContent)
+{
+   void *mem = mcontext.allocate(sizeof(Text), alignof(Text));
+   return new (mem) Text(literalContent);
+}
+
+SoftBreak *SoftBreak::create(MarkupContext &mcontext)
+{
+   void *mem = mcontext.allocate(sizeof(SoftBreak), alignof(SoftBreak));
+   return new (mem) SoftBreak();
+}
+
+LineBreak *LineBreak::create(MarkupContext &mcontext)
+{
+   void *mem = mcontext.allocate(sizeof(LineBreak), alignof(LineBreak));
+   return new (mem) LineBreak();
+}
+
+Code *Code::create(MarkupContext &mcontext, StringRef literalContent)
+{
+   void *mem = mcontext.allocate(sizeof(Code), alignof(Code));
+   return new (mem) Code(literalContent);
+}
+
+CodeBlock *CodeBlock::create(MarkupContext &mcontext, StringRef literalContent,
+                             StringRef language)
+{
+   void *mem = mcontext.allocate(sizeof(CodeBlock), alignof(CodeBlock));
+   return new (mem) CodeBlock(literalContent, language);
+}
+
+Emphasis::Emphasis(ArrayRef<MarkupAstNode *> children)
+   : InlineContent(AstNodeKind::Emphasis),
+     m_numChildren(children.size())
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Emphasis *Emphasis::create(MarkupContext &mcontext,
+                           ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Emphasis));
+   return new (mem) Emphasis(children);
+}
+
+Strong::Strong(ArrayRef<MarkupAstNode *> children)
+   : InlineContent(AstNodeKind::Strong),
+     m_numChildren(children.size())
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+Strong *Strong::create(MarkupContext &mcontext,
+                       ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(Strong));
+   return new (mem) Strong(children);
+}
+
+ParamField::ParamField(StringRef name, ArrayRef<MarkupAstNode *> children)
+   : PrivateExtension(AstNodeKind::ParamField),
+     m_numChildren(children.size()),
+     m_name(name),
+     m_parts(std::nullopt)
+{
+   std::uninitialized_copy(children.begin(), children.end(),
+                           getTrailingObjects<MarkupAstNode *>());
+}
+
+ParamField *ParamField::create(MarkupContext &mcontext, StringRef name,
+                               ArrayRef<MarkupAstNode *> children)
+{
+   void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()),
+                                 alignof(ParamField));
+   return new (mem) ParamField(name, children);
+}
+
+AnnotationField *AnnotationField::create(MarkupContext &mcontext, StringRef name,
+                                         StringRef value)
+{
+   void *mem = mcontext.allocate(sizeof(AnnotationField), alignof(AnnotationField));
+   return new (mem) AnnotationField(name, value);
+}
+
+#define MARKUP_SIMPLE_FIELD(Id, Keyword, XMLKind) \
+   Id::Id(ArrayRef<MarkupAstNode *> children) \
+      : PrivateExtension(AstNodeKind::Id), \
+        m_numChildren(children.size()) \
+   { \
+      std::uninitialized_copy(children.begin(), children.end(), \
+                              getTrailingObjects<MarkupAstNode *>()); \
+   } \
+   Id *Id::create(MarkupContext &mcontext, ArrayRef<MarkupAstNode *> children) \
+   { \
+      void *mem = mcontext.allocate(totalSizeToAlloc<MarkupAstNode *>(children.size()), \
+                                    alignof(Id)); \
+      return new (mem) Id(children); \
+   }
+#include "polarphp/markup/SimpleFieldsDefs.h"
+
+MarkupAstNode *create_simple_field(MarkupContext &mcontext, StringRef tag,
+                                   ArrayRef<MarkupAstNode *> children)
+{
+   std::string lowerTag = tag.toLower();
+#define MARKUP_SIMPLE_FIELD(Id, Keyword, XMLKind) \
+   if (lowerTag == #Keyword) { \
+      return Id::create(mcontext, children); \
+   }
+#include "polarphp/markup/SimpleFieldsDefs.h"
+   polar_unreachable("Given tag not for any simple markup field");
+}
+
+bool is_a_field_tag(StringRef tag)
+{
+   return StringSwitch<bool>(tag.toLower())
+#define MARKUP_SIMPLE_FIELD(Id, Keyword, XMLKind) \
+         .cond(#Keyword, true)
+#include "polarphp/markup/SimpleFieldsDefs.h"
+         .defaultCond(false);
+}
+
+namespace {
+
+void print_indent(RawOutStream &outStream, unsigned indent)
+{
+   for (unsigned i = 0; i < indent; ++i) {
+      outStream << ' ';
+   }
+}
+
+void dump_quoted(RawOutStream &outStream, StringRef text)
+{
+   outStream << '"';
+   for (char c : text) {
+      switch (c) {
+      case '\n':
+         outStream << "\\n";
+         break;
+      case '\t':
+         outStream << "\\t";
+         break;
+      case '"':
+         outStream << "\\\"";
+         break;
+      default:
+         outStream << c;
+      }
+   }
+   outStream << '"';
+}
+
+} // anonymous namespace
+
+void print_inlines_under(const MarkupAstNode *node, RawOutStream &outStream,
+                         bool printDecorators)
+{
+   auto printChildren = [&](ArrayRef<const MarkupAstNode *> children) {
+      for (const MarkupAstNode *child : children) {
+         print_inlines_under(child, outStream, printDecorators);
+      }
+   };
+
+   switch (node->getKind()) {
+   case AstNodeKind::Text:
+      outStream << cast<Text>(node)->getLiteralContent();
+      break;
+   case AstNodeKind::Code:
+      if (printDecorators) {
+         outStream << '`';
+      }
+      outStream << cast<Code>(node)->getLiteralContent();
+      if (printDecorators) {
+         outStream << '`';
+      }
+      break;
+   case AstNodeKind::InlineHTML:
+      outStream << cast<InlineHTML>(node)->getLiteralContent();
+      break;
+   case AstNodeKind::SoftBreak:
+      outStream << ' ';
+      break;
+   case AstNodeKind::LineBreak:
+      outStream << '\n';
+      break;
+   case AstNodeKind::Emphasis:
+      if (printDecorators) {
+         outStream << '*';
+      }
+      printChildren(node->getChildren());
+      if (printDecorators) {
+         outStream << '*';
+      }
+      break;
+   case AstNodeKind::Strong:
+      if (printDecorators) {
+         outStream << "**";
+      }
+      printChildren(node->getChildren());
+      if (printDecorators) {
+         outStream << "**";
+      }
+      break;
+   case AstNodeKind::AnnotationField: {
+      auto annotation = cast<AnnotationField>(node);
+      outStream << '@' << annotation->getName();
+      if (!annotation->getValue().empty()) {
+         outStream << ' ' << annotation->getValue();
+      }
+      break;
+   }
+   default:
+      printChildren(node->getChildren());
+   }
+}
+
+void dump(const MarkupAstNode *node, RawOutStream &outStream, unsigned indent)
+{
+   print_indent(outStream, indent);
+   outStream << '(';
+   switch (node->getKind()) {
+#define MARKUP_AST_NODE(Id, Parent) \
+   case AstNodeKind::Id: \
+      outStream << #Id; \
+      break;
+#define ABSTRACT_MARKUP_AST_NODE(Id, Parent)
+#define MARKUP_AST_NODE_RANGE(Id, FirstId, LastId)
+#include "polarphp/markup/AstNodesDefs.h"
+   }
+
+   if (auto text = dyn_cast<Text>(node)) {
+      outStream << ' ';
+      dump_quoted(outStream, text->getLiteralContent());
+   } else if (auto code = dyn_cast<Code>(node)) {
+      outStream << ' ';
+      dump_quoted(outStream, code->getLiteralContent());
+   } else if (auto codeBlock = dyn_cast<CodeBlock>(node)) {
+      outStream << " language=";
+      dump_quoted(outStream, codeBlock->getLanguage());
+      outStream << ' ';
+      dump_quoted(outStream, codeBlock->getLiteralContent());
+   } else if (auto header = dyn_cast<Header>(node)) {
+      outStream << " level=" << header->getLevel();
+   } else if (auto list = dyn_cast<List>(node)) {
+      outStream << (list->isOrdered() ? " ordered" : " unordered");
+   } else if (auto link = dyn_cast<Link>(node)) {
+      outStream << " destination=";
+      dump_quoted(outStream, link->getDestination());
+   } else if (auto param = dyn_cast<ParamField>(node)) {
+      outStream << " name=";
+      dump_quoted(outStream, param->getName());
+   } else if (auto annotation = dyn_cast<AnnotationField>(node)) {
+      outStream << " name=";
+      dump_quoted(outStream, annotation->getName());
+      outStream << " value=";
+      dump_quoted(outStream, annotation->getValue());
+   }
+
+   for (const MarkupAstNode *child : node->getChildren()) {
+      outStream << '\n';
+      dump(child, outStream, indent + 2);
+   }
+   outStream << ')';
+}
+
+} // polar::markup
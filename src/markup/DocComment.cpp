@@ -0,0 +1,214 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/markup/DocComment.h"
+#include "polarphp/markup/Markup.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/basic/adt/SmallVector.h"
+
+namespace polar::markup {
+
+using polar::basic::SmallString;
+using polar::basic::SmallVector;
+
+namespace {
+
+bool is_tag_name_char(char c)
+{
+   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '\\' || c == ':';
+}
+
+/// a tag name starts right after the `@` and has at least one character
+size_t measure_tag_name(StringRef text)
+{
+   size_t length = 0;
+   while (length < text.size() && is_tag_name_char(text[length])) {
+      ++length;
+   }
+   return length;
+}
+
+/// strips the comment leader, the spaces, the `*` and one space after it
+StringRef strip_comment_leader(StringRef line)
+{
+   line = line.trim(" \t\r");
+   if (line.startsWith("*")) {
+      line = line.dropFront(1);
+      if (line.startsWith(" ")) {
+         line = line.dropFront(1);
+      }
+   }
+   return line;
+}
+
+class DocCommentParser
+{
+public:
+   explicit DocCommentParser(MarkupContext &mcontext)
+      : m_context(mcontext)
+   {}
+
+   Document *parse(StringRef comment)
+   {
+      if (comment.startsWith("/**")) {
+         comment = comment.dropFront(3);
+      }
+      if (comment.endsWith("*/")) {
+         comment = comment.dropBack(2);
+      }
+      while (!comment.empty()) {
+         std::pair<StringRef, StringRef> split = comment.split('\n');
+         handleLine(strip_comment_leader(split.first));
+         comment = split.second;
+      }
+      flushParagraph();
+      flushTag();
+      return Document::create(m_context, m_children);
+   }
+
+private:
+   void handleLine(StringRef line)
+   {
+      if (line.startsWith("@")) {
+         size_t nameLength = measure_tag_name(line.dropFront(1));
+         if (nameLength != 0) {
+            flushParagraph();
+            flushTag();
+            m_inTag = true;
+            m_tagName = line.substr(1, nameLength);
+            StringRef value = line.dropFront(nameLength + 1).trim(" \t");
+            if (!value.empty()) {
+               m_lines.push_back(value);
+            }
+            return;
+         }
+      }
+      if (line.empty()) {
+         // a blank line ends the paragraph or the tag being collected
+         if (m_inTag) {
+            flushTag();
+         } else {
+            flushParagraph();
+         }
+         return;
+      }
+      m_lines.push_back(m_inTag ? line.ltrim(" \t") : line);
+   }
+
+   void flushParagraph()
+   {
+      if (m_inTag || m_lines.empty()) {
+         return;
+      }
+      SmallVector<MarkupAstNode *, 8> inlines;
+      for (StringRef line : m_lines) {
+         if (!inlines.empty()) {
+            inlines.push_back(SoftBreak::create(m_context));
+         }
+         inlines.push_back(Text::create(m_context, m_context.allocateCopy(line)));
+      }
+      m_children.push_back(Paragraph::create(m_context, inlines));
+      m_lines.clear();
+   }
+
+   void flushTag()
+   {
+      if (!m_inTag) {
+         return;
+      }
+      SmallString<128> value;
+      for (StringRef line : m_lines) {
+         if (!value.empty()) {
+            value.push_back(' ');
+         }
+         value.append(line.begin(), line.end());
+      }
+      m_children.push_back(AnnotationField::create(m_context,
+                                                   m_context.allocateCopy(m_tagName),
+                                                   m_context.allocateCopy(value.getStr())));
+      m_inTag = false;
+      m_lines.clear();
+   }
+
+private:
+   MarkupContext &m_context;
+   SmallVector<MarkupAstNode *, 8> m_children;
+   SmallVector<StringRef, 8> m_lines;
+   StringRef m_tagName;
+   bool m_inTag = false;
+};
+
+} // anonymous namespace
+
+bool doc_comment_has_tags(StringRef comment)
+{
+   size_t pos = comment.find('@');
+   while (pos != StringRef::npos) {
+      // only the comment leader may stand between the line start and the tag
+      size_t lineStart = pos;
+      while (lineStart > 0) {
+         char c = comment[lineStart - 1];
+         if (c != ' ' && c != '\t' && c != '*' && c != '/') {
+            break;
+         }
+         --lineStart;
+      }
+      bool atLineStart = lineStart == 0 || comment[lineStart - 1] == '\n' ||
+            comment[lineStart - 1] == '\r';
+      if (atLineStart && measure_tag_name(comment.dropFront(pos + 1)) != 0) {
+         return true;
+      }
+      pos = comment.find('@', pos + 1);
+   }
+   return false;
+}
+
+Document *parse_doc_comment(MarkupContext &mcontext, StringRef comment)
+{
+   return DocCommentParser(mcontext).parse(comment);
+}
+
+DocCommentCache::DocCommentCache()
+   : m_context(new MarkupContext)
+{}
+
+DocCommentCache::~DocCommentCache()
+{}
+
+const Document *DocCommentCache::get(StringRef comment)
+{
+   std::lock_guard<std::mutex> locker(m_mutex);
+   auto iter = m_entries.find(comment);
+   if (iter != m_entries.end()) {
+      ++m_numHits;
+      return iter->getValue();
+   }
+   const Document *document = nullptr;
+   if (doc_comment_has_tags(comment)) {
+      document = parse_doc_comment(*m_context, comment);
+      ++m_numParses;
+   } else {
+      // remembered as well, so the scan is not repeated either
+      ++m_numSkipped;
+   }
+   m_entries[comment] = document;
+   return document;
+}
+
+void DocCommentCache::clear()
+{
+   std::lock_guard<std::mutex> locker(m_mutex);
+   m_entries.clear();
+   m_context.reset(new MarkupContext);
+}
+
+} // polar::markup
@@ -0,0 +1,972 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "polarphp/parser/Lexer.h"
+#include "polarphp/parser/SourceMgr.h"
+#include "polarphp/utils/MathExtras.h"
+
+#include <array>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace polar::parser {
+
+using polar::utils::count_trailing_zeros;
+using polar::utils::ZB_Undefined;
+
+namespace {
+
+enum CharClassFlags : std::uint8_t
+{
+   CC_IdentStart = 1 << 0,
+   CC_IdentChar = 1 << 1,
+   CC_Whitespace = 1 << 2,
+   CC_Digit = 1 << 3,
+   CC_HexDigit = 1 << 4,
+   CC_Alpha = 1 << 5
+};
+
+constexpr std::array<std::uint8_t, 256> build_char_class_table()
+{
+   std::array<std::uint8_t, 256> table{};
+   for (unsigned c = 0; c < 256; ++c) {
+      std::uint8_t flags = 0;
+      bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+      bool digit = c >= '0' && c <= '9';
+      if (alpha || c == '_' || c >= 0x80) {
+         flags |= CC_IdentStart | CC_IdentChar;
+      }
+      if (digit) {
+         flags |= CC_IdentChar | CC_Digit | CC_HexDigit;
+      }
+      if (alpha) {
+         flags |= CC_Alpha;
+      }
+      if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')) {
+         flags |= CC_HexDigit;
+      }
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+         flags |= CC_Whitespace;
+      }
+      table[c] = flags;
+   }
+   return table;
+}
+
+constexpr std::array<std::uint8_t, 256> sg_charClasses = build_char_class_table();
+
+inline bool is_char_class(char c, std::uint8_t flags)
+{
+   return sg_charClasses[static_cast<unsigned char>(c)] & flags;
+}
+
+/// the byte at ptr, or 0 past the end, the buffer slice we lex is not
+/// necessarily null terminated
+inline char char_at(const char *ptr, const char *end)
+{
+   return ptr < end ? *ptr : '\0';
+}
+
+///
+/// SIMD scanners, the long runs of a php file are whitespace, comments,
+/// string bodies and inline html, we check 16 bytes per iteration and fall
+/// back to bytes for the tail so we never read past the end of the buffer
+///
+inline const char *find_first_of(const char *ptr, const char *end, char c1, char c2, char c3)
+{
+#if defined(__SSE2__)
+   const __m128i v1 = _mm_set1_epi8(c1);
+   const __m128i v2 = _mm_set1_epi8(c2);
+   const __m128i v3 = _mm_set1_epi8(c3);
+   while (end - ptr >= 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+      __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1), _mm_cmpeq_epi8(chunk, v2)),
+                                  _mm_cmpeq_epi8(chunk, v3));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+      if (mask) {
+         return ptr + count_trailing_zeros(mask, ZB_Undefined);
+      }
+      ptr += 16;
+   }
+#endif
+   while (ptr != end && *ptr != c1 && *ptr != c2 && *ptr != c3) {
+      ++ptr;
+   }
+   return ptr;
+}
+
+inline const char *find_first_of(const char *ptr, const char *end, char c1, char c2)
+{
+   return find_first_of(ptr, end, c1, c2, c2);
+}
+
+inline const char *find_char(const char *ptr, const char *end, char c)
+{
+   return find_first_of(ptr, end, c, c, c);
+}
+
+const char *skip_whitespace(const char *ptr, const char *end, bool &sawNewline)
+{
+   /// most runs are a single space, don't pay for the vector setup
+   if (ptr == end || !is_char_class(*ptr, CC_Whitespace)) {
+      return ptr;
+   }
+#if defined(__SSE2__)
+   const __m128i space = _mm_set1_epi8(' ');
+   const __m128i tab = _mm_set1_epi8('\t');
+   const __m128i lf = _mm_set1_epi8('\n');
+   const __m128i cr = _mm_set1_epi8('\r');
+   while (end - ptr >= 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+      __m128i newlines = _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr));
+      __m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab));
+      unsigned newlineMask = static_cast<unsigned>(_mm_movemask_epi8(newlines));
+      unsigned stopMask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(newlines, blanks))) & 0xFFFF;
+      if (stopMask) {
+         unsigned stop = count_trailing_zeros(stopMask, ZB_Undefined);
+         if (newlineMask & ((1U << stop) - 1)) {
+            sawNewline = true;
+         }
+         return ptr + stop;
+      }
+      if (newlineMask) {
+         sawNewline = true;
+      }
+      ptr += 16;
+   }
+#endif
+   while (ptr != end && is_char_class(*ptr, CC_Whitespace)) {
+      if (*ptr == '\n' || *ptr == '\r') {
+         sawNewline = true;
+      }
+      ++ptr;
+   }
+   return ptr;
+}
+
+/// # and // comments end at the newline or at ?>, the newline is left for
+/// the whitespace scanner
+const char *skip_line_comment(const char *ptr, const char *end)
+{
+   while (true) {
+      ptr = find_first_of(ptr, end, '\n', '\r', '?');
+      if (ptr == end || *ptr != '?' || char_at(ptr + 1, end) == '>') {
+         return ptr;
+      }
+      ++ptr;
+   }
+}
+
+const char *skip_blanks(const char *ptr, const char *end)
+{
+   while (ptr != end && (*ptr == ' ' || *ptr == '\t')) {
+      ++ptr;
+   }
+   return ptr;
+}
+
+const char *skip_ident_chars(const char *ptr, const char *end)
+{
+   while (ptr != end && is_char_class(*ptr, CC_IdentChar)) {
+      ++ptr;
+   }
+   return ptr;
+}
+
+/// scan an escaped string body from ptr up to the quote, \ escapes the
+/// next byte and $name, ${ or {$ mark the literal as interpolated
+const char *scan_string_body(const char *ptr, const char *end, char quote, bool &interpolated)
+{
+   while (true) {
+      ptr = find_first_of(ptr, end, quote, '\\', '$');
+      if (ptr == end || *ptr == quote) {
+         return ptr;
+      }
+      if (*ptr == '\\') {
+         ptr = ptr + 2 < end ? ptr + 2 : end;
+         continue;
+      }
+      char next = char_at(ptr + 1, end);
+      if (next == '{' || is_char_class(next, CC_IdentStart)) {
+         interpolated = true;
+      }
+      ++ptr;
+   }
+}
+
+///
+/// keywords are looked up through a perfect hash over the length and three
+/// case folded bytes, the multiplier was searched offline for the keyword
+/// set in TokenKinds.def, the table is built at compile time and a
+/// collision makes the constexpr evaluation (and so the build) fail, so
+/// adding a keyword may need a new multiplier
+///
+constexpr unsigned KEYWORD_TABLE_BITS = 8;
+constexpr unsigned KEYWORD_TABLE_SIZE = 1U << KEYWORD_TABLE_BITS;
+constexpr std::uint32_t KEYWORD_HASH_MULTIPLIER = 0x206e206fU;
+constexpr unsigned MAX_KEYWORD_LENGTH = 15;
+
+/// or-ing 0x20 folds ascii case, it also maps a few non letters onto each
+/// other but the final comparison is done the same way on both sides and
+/// keyword spellings only contain letters and '_'
+constexpr std::uint32_t fold_case(char c)
+{
+   return static_cast<unsigned char>(c) | 0x20U;
+}
+
+constexpr unsigned keyword_hash(const char *str, unsigned length)
+{
+   std::uint32_t key = fold_case(str[0]) |
+         (fold_case(str[length > 2 ? 2 : 1]) << 8) |
+         (fold_case(str[length - 1]) << 16) |
+         (static_cast<std::uint32_t>(length) << 24);
+   return (key * KEYWORD_HASH_MULTIPLIER) >> (32 - KEYWORD_TABLE_BITS);
+}
+
+struct KeywordEntry
+{
+   const char *spelling;
+   unsigned length;
+   TokenKindType kind;
+};
+
+/// not constexpr on purpose, reaching it during constant evaluation is
+/// what turns a hash collision into a compile error
+inline void keyword_hash_collision()
+{}
+
+class KeywordTable
+{
+public:
+   constexpr KeywordTable()
+      : m_entries{}
+   {
+#define KEYWORD(kw) insert(#kw, sizeof(#kw) - 1, TokenKindType::kw_##kw);
+#include "polarphp/syntax/TokenKinds.def"
+   }
+
+   TokenKindType lookup(const char *str, unsigned length) const
+   {
+      if (length < 2 || length > MAX_KEYWORD_LENGTH) {
+         return TokenKindType::identifier;
+      }
+      const KeywordEntry &entry = m_entries[keyword_hash(str, length)];
+      if (entry.length != length) {
+         return TokenKindType::identifier;
+      }
+      for (unsigned i = 0; i < length; ++i) {
+         if (fold_case(str[i]) != fold_case(entry.spelling[i])) {
+            return TokenKindType::identifier;
+         }
+      }
+      return entry.kind;
+   }
+
+private:
+   constexpr void insert(const char *spelling, unsigned length, TokenKindType kind)
+   {
+      KeywordEntry &entry = m_entries[keyword_hash(spelling, length)];
+      if (entry.length != 0 || length > MAX_KEYWORD_LENGTH) {
+         keyword_hash_collision();
+      }
+      entry.spelling = spelling;
+      entry.length = length;
+      entry.kind = kind;
+   }
+
+   KeywordEntry m_entries[KEYWORD_TABLE_SIZE];
+};
+
+constexpr KeywordTable sg_keywordTable;
+
+struct CastEntry
+{
+   StringRef typeName;
+   TokenKindType kind;
+};
+
+const CastEntry sg_castTypes[] = {
+   {"int", TokenKindType::int_cast},
+   {"integer", TokenKindType::int_cast},
+   {"bool", TokenKindType::bool_cast},
+   {"boolean", TokenKindType::bool_cast},
+   {"float", TokenKindType::double_cast},
+   {"double", TokenKindType::double_cast},
+   {"real", TokenKindType::double_cast},
+   {"string", TokenKindType::string_cast},
+   {"binary", TokenKindType::string_cast},
+   {"array", TokenKindType::array_cast},
+   {"object", TokenKindType::object_cast},
+   {"unset", TokenKindType::unset_cast}
+};
+
+} // anonymous namespace
+
+Lexer::Lexer(const SourceManager &sourceMgr, unsigned bufferID,
+             CommentRetentionMode commentRetention, bool shortOpenTag)
+   : m_bufferID(bufferID),
+     m_mode(LexerMode::InlineHtml),
+     m_commentRetention(commentRetention),
+     m_shortOpenTag(shortOpenTag)
+{
+   StringRef text = sourceMgr.getEntireTextForBuffer(bufferID);
+   m_bufferStart = text.data();
+   initialize(0, text.size());
+}
+
+Lexer::Lexer(const SourceManager &sourceMgr, unsigned bufferID, unsigned offset,
+             unsigned endOffset, LexerMode mode,
+             CommentRetentionMode commentRetention, bool shortOpenTag)
+   : m_bufferID(bufferID),
+     m_mode(mode),
+     m_commentRetention(commentRetention),
+     m_shortOpenTag(shortOpenTag)
+{
+   StringRef text = sourceMgr.getEntireTextForBuffer(bufferID);
+   assert(offset <= endOffset && endOffset <= text.size() && "invalid lexing range");
+   m_bufferStart = text.data();
+   initialize(offset, endOffset);
+}
+
+Lexer::Lexer(StringRef buffer, LexerMode mode, CommentRetentionMode commentRetention,
+             bool shortOpenTag)
+   : m_mode(mode),
+     m_commentRetention(commentRetention),
+     m_shortOpenTag(shortOpenTag)
+{
+   m_bufferStart = buffer.data();
+   initialize(0, buffer.size());
+}
+
+void Lexer::initialize(unsigned offset, unsigned endOffset)
+{
+   m_curPtr = m_bufferStart + offset;
+   m_bufferEnd = m_bufferStart + endOffset;
+   m_triviaStart = m_curPtr;
+}
+
+TokenKindType Lexer::getKindOfIdentifier(StringRef text)
+{
+   return sg_keywordTable.lookup(text.data(), text.size());
+}
+
+void Lexer::formToken(Token &result, TokenKindType kind, const char *tokStart)
+{
+   result.setToken(kind, StringRef(tokStart, m_curPtr - tokStart),
+                   tokStart - m_triviaStart, m_tokenFlags);
+   if (kind != TokenKindType::comment && kind != TokenKindType::doc_comment) {
+      m_lastKind = kind;
+   }
+   if (m_lineTable) {
+      m_lineTable->scanTo(m_bufferStart, m_curPtr - m_bufferStart);
+   }
+}
+
+void Lexer::lex(Token &result)
+{
+   m_triviaStart = m_curPtr;
+   m_tokenFlags = 0;
+   if (m_curPtr == m_bufferStart || m_curPtr[-1] == '\n' || m_curPtr[-1] == '\r') {
+      m_tokenFlags |= Token::AtStartOfLine;
+   }
+   if (m_mode == LexerMode::InlineHtml) {
+      lexInlineHtml(result);
+      return;
+   }
+   if (skipTrivia(result)) {
+      return;
+   }
+   const char *tokStart = m_curPtr;
+   if (m_curPtr == m_bufferEnd) {
+      formToken(result, TokenKindType::eof, tokStart);
+      return;
+   }
+   char c = *m_curPtr;
+   if (is_char_class(c, CC_IdentStart)) {
+      if ((c == 'b' || c == 'B')) {
+         char next = char_at(m_curPtr + 1, m_bufferEnd);
+         if (next == '\'') {
+            lexSingleQuoteString(result, tokStart);
+            return;
+         }
+         if (next == '"') {
+            lexInterpolatedString(result, tokStart, '"');
+            return;
+         }
+         if (next == '<' && tryLexHeredoc(result, tokStart)) {
+            return;
+         }
+      }
+      lexIdentifier(result, tokStart);
+      return;
+   }
+   if (is_char_class(c, CC_Digit) ||
+       (c == '.' && is_char_class(char_at(m_curPtr + 1, m_bufferEnd), CC_Digit))) {
+      lexNumber(result, tokStart);
+      return;
+   }
+   switch (c) {
+   case '$':
+      lexVariable(result, tokStart);
+      return;
+   case '\'':
+      lexSingleQuoteString(result, tokStart);
+      return;
+   case '"':
+   case '`':
+      lexInterpolatedString(result, tokStart, c);
+      return;
+   case '(':
+      if (tryLexCast(result, tokStart)) {
+         return;
+      }
+      break;
+   case '<':
+      if (tryLexHeredoc(result, tokStart)) {
+         return;
+      }
+      break;
+   case '?':
+      if (char_at(m_curPtr + 1, m_bufferEnd) == '>') {
+         lexCloseTag(result, tokStart);
+         return;
+      }
+      break;
+   default:
+      break;
+   }
+   lexPunctuator(result, tokStart);
+}
+
+bool Lexer::skipTrivia(Token &result)
+{
+   while (true) {
+      bool sawNewline = false;
+      m_curPtr = skip_whitespace(m_curPtr, m_bufferEnd, sawNewline);
+      if (sawNewline) {
+         m_tokenFlags |= Token::AtStartOfLine;
+      }
+      if (m_curPtr == m_bufferEnd) {
+         return false;
+      }
+      const char *commentStart = m_curPtr;
+      char c = *m_curPtr;
+      char next = char_at(m_curPtr + 1, m_bufferEnd);
+      TokenKindType kind = TokenKindType::comment;
+      if (c == '#' || (c == '/' && next == '/')) {
+         m_curPtr = skip_line_comment(m_curPtr + (c == '#' ? 1 : 2), m_bufferEnd);
+      } else if (c == '/' && next == '*') {
+         /// "/**" followed by whitespace, "/**/" is an ordinary comment
+         if (char_at(m_curPtr + 2, m_bufferEnd) == '*' &&
+             is_char_class(char_at(m_curPtr + 3, m_bufferEnd), CC_Whitespace)) {
+            kind = TokenKindType::doc_comment;
+         }
+         const char *ptr = m_curPtr + 2;
+         while (true) {
+            ptr = find_char(ptr, m_bufferEnd, '*');
+            if (ptr == m_bufferEnd) {
+               m_tokenFlags |= Token::Unterminated;
+               break;
+            }
+            if (char_at(ptr + 1, m_bufferEnd) == '/') {
+               ptr += 2;
+               break;
+            }
+            ++ptr;
+         }
+         m_curPtr = ptr;
+      } else {
+         return false;
+      }
+      if (m_commentRetention == CommentRetentionMode::ReturnAsTokens) {
+         formToken(result, kind, commentStart);
+         return true;
+      }
+      if (kind == TokenKindType::doc_comment) {
+         m_tokenFlags |= Token::HasDocComment;
+      }
+   }
+}
+
+void Lexer::lexInlineHtml(Token &result)
+{
+   const char *tokStart = m_curPtr;
+   if (tokStart == m_bufferEnd) {
+      formToken(result, TokenKindType::eof, tokStart);
+      return;
+   }
+   const char *ptr = tokStart;
+   while (true) {
+      ptr = find_char(ptr, m_bufferEnd, '<');
+      if (ptr == m_bufferEnd) {
+         break;
+      }
+      if (char_at(ptr + 1, m_bufferEnd) != '?') {
+         ++ptr;
+         continue;
+      }
+      TokenKindType kind = TokenKindType::open_tag;
+      const char *tagEnd = nullptr;
+      if (char_at(ptr + 2, m_bufferEnd) == '=') {
+         kind = TokenKindType::open_tag_with_echo;
+         tagEnd = ptr + 3;
+      } else if (m_bufferEnd - ptr >= 5 && StringRef(ptr + 2, 3).equalsLower("php")) {
+         /// <?php must be followed by whitespace, a newline is part of the tag
+         const char *after = ptr + 5;
+         if (after == m_bufferEnd) {
+            tagEnd = after;
+         } else if (*after == '\r' && char_at(after + 1, m_bufferEnd) == '\n') {
+            tagEnd = after + 2;
+         } else if (is_char_class(*after, CC_Whitespace)) {
+            tagEnd = after + 1;
+         }
+      }
+      if (!tagEnd && m_shortOpenTag) {
+         tagEnd = ptr + 2;
+      }
+      if (!tagEnd) {
+         ptr += 2;
+         continue;
+      }
+      if (ptr != tokStart) {
+         m_curPtr = ptr;
+         formToken(result, TokenKindType::inline_html, tokStart);
+         return;
+      }
+      m_curPtr = tagEnd;
+      m_mode = LexerMode::Scripting;
+      formToken(result, kind, tokStart);
+      return;
+   }
+   m_curPtr = m_bufferEnd;
+   formToken(result, TokenKindType::inline_html, tokStart);
+}
+
+void Lexer::lexIdentifier(Token &result, const char *tokStart)
+{
+   m_curPtr = skip_ident_chars(tokStart + 1, m_bufferEnd);
+   TokenKindType kind = TokenKindType::identifier;
+   if (m_lastKind != TokenKindType::arrow) {
+      kind = sg_keywordTable.lookup(tokStart, m_curPtr - tokStart);
+   }
+   formToken(result, kind, tokStart);
+}
+
+void Lexer::lexVariable(Token &result, const char *tokStart)
+{
+   if (!is_char_class(char_at(tokStart + 1, m_bufferEnd), CC_IdentStart)) {
+      m_curPtr = tokStart + 1;
+      formToken(result, TokenKindType::dollar, tokStart);
+      return;
+   }
+   m_curPtr = skip_ident_chars(tokStart + 2, m_bufferEnd);
+   formToken(result, TokenKindType::variable, tokStart);
+}
+
+void Lexer::lexNumber(Token &result, const char *tokStart)
+{
+   const char *ptr = tokStart;
+   if (*ptr == '0') {
+      char radix = char_at(ptr + 1, m_bufferEnd) | 0x20;
+      char first = char_at(ptr + 2, m_bufferEnd);
+      if (radix == 'x' && is_char_class(first, CC_HexDigit)) {
+         ptr += 2;
+         while (ptr != m_bufferEnd && is_char_class(*ptr, CC_HexDigit)) {
+            ++ptr;
+         }
+         m_curPtr = ptr;
+         formToken(result, TokenKindType::integer_literal, tokStart);
+         return;
+      }
+      if (radix == 'b' && (first == '0' || first == '1')) {
+         ptr += 2;
+         while (ptr != m_bufferEnd && (*ptr == '0' || *ptr == '1')) {
+            ++ptr;
+         }
+         m_curPtr = ptr;
+         formToken(result, TokenKindType::integer_literal, tokStart);
+         return;
+      }
+   }
+   TokenKindType kind = TokenKindType::integer_literal;
+   while (ptr != m_bufferEnd && is_char_class(*ptr, CC_Digit)) {
+      ++ptr;
+   }
+   if (char_at(ptr, m_bufferEnd) == '.') {
+      kind = TokenKindType::float_literal;
+      ++ptr;
+      while (ptr != m_bufferEnd && is_char_class(*ptr, CC_Digit)) {
+         ++ptr;
+      }
+   }
+   if ((char_at(ptr, m_bufferEnd) | 0x20) == 'e') {
+      const char *exponent = ptr + 1;
+      char sign = char_at(exponent, m_bufferEnd);
+      if (sign == '+' || sign == '-') {
+         ++exponent;
+      }
+      if (is_char_class(char_at(exponent, m_bufferEnd), CC_Digit)) {
+         kind = TokenKindType::float_literal;
+         ptr = exponent;
+         while (ptr != m_bufferEnd && is_char_class(*ptr, CC_Digit)) {
+            ++ptr;
+         }
+      }
+   }
+   m_curPtr = ptr;
+   formToken(result, kind, tokStart);
+}
+
+void Lexer::lexSingleQuoteString(Token &result, const char *tokStart)
+{
+   const char *ptr = tokStart + (*tokStart == '\'' ? 1 : 2);
+   while (true) {
+      ptr = find_first_of(ptr, m_bufferEnd, '\'', '\\');
+      if (ptr == m_bufferEnd) {
+         m_tokenFlags |= Token::Unterminated;
+         break;
+      }
+      if (*ptr == '\'') {
+         ++ptr;
+         break;
+      }
+      ptr = ptr + 2 < m_bufferEnd ? ptr + 2 : m_bufferEnd;
+   }
+   m_curPtr = ptr;
+   formToken(result, TokenKindType::string_literal, tokStart);
+}
+
+void Lexer::lexInterpolatedString(Token &result, const char *tokStart, char quote)
+{
+   const char *ptr = tokStart + (*tokStart == quote ? 1 : 2);
+   bool interpolated = false;
+   ptr = scan_string_body(ptr, m_bufferEnd, quote, interpolated);
+   if (ptr == m_bufferEnd) {
+      m_tokenFlags |= Token::Unterminated;
+   } else {
+      ++ptr;
+   }
+   if (interpolated) {
+      m_tokenFlags |= Token::Interpolated;
+   }
+   m_curPtr = ptr;
+   formToken(result, quote == '`' ? TokenKindType::backquote_literal
+                                  : TokenKindType::string_literal, tokStart);
+}
+
+bool Lexer::tryLexHeredoc(Token &result, const char *tokStart)
+{
+   const char *ptr = tokStart + (*tokStart == '<' ? 0 : 1);
+   if (m_bufferEnd - ptr < 4 || ptr[1] != '<' || ptr[2] != '<') {
+      return false;
+   }
+   ptr = skip_blanks(ptr + 3, m_bufferEnd);
+   char quote = char_at(ptr, m_bufferEnd);
+   if (quote == '\'' || quote == '"') {
+      ++ptr;
+   } else {
+      quote = '\0';
+   }
+   const char *labelStart = ptr;
+   if (!is_char_class(char_at(ptr, m_bufferEnd), CC_IdentStart)) {
+      return false;
+   }
+   ptr = skip_ident_chars(ptr + 1, m_bufferEnd);
+   StringRef label(labelStart, ptr - labelStart);
+   if (quote) {
+      if (char_at(ptr, m_bufferEnd) != quote) {
+         return false;
+      }
+      ++ptr;
+   }
+   if (char_at(ptr, m_bufferEnd) == '\r') {
+      ++ptr;
+   }
+   if (char_at(ptr, m_bufferEnd) != '\n') {
+      return false;
+   }
+   ++ptr;
+   /// since 7.3 the closing label may be indented and followed by anything
+   /// that can not continue the label
+   const char *bodyStart = ptr;
+   const char *bodyEnd = m_bufferEnd;
+   const char *lineStart = bodyStart;
+   while (lineStart != m_bufferEnd) {
+      const char *candidate = skip_blanks(lineStart, m_bufferEnd);
+      if (static_cast<std::size_t>(m_bufferEnd - candidate) >= label.size() &&
+          StringRef(candidate, label.size()) == label &&
+          !is_char_class(char_at(candidate + label.size(), m_bufferEnd), CC_IdentChar)) {
+         bodyEnd = lineStart;
+         m_curPtr = candidate + label.size();
+         break;
+      }
+      const char *newline = find_char(lineStart, m_bufferEnd, '\n');
+      lineStart = newline == m_bufferEnd ? m_bufferEnd : newline + 1;
+   }
+   if (bodyEnd == m_bufferEnd) {
+      m_curPtr = m_bufferEnd;
+      m_tokenFlags |= Token::Unterminated;
+   }
+   if (quote == '\'') {
+      formToken(result, TokenKindType::nowdoc_literal, tokStart);
+      return true;
+   }
+   bool interpolated = false;
+   /// the body has no closing quote, use a byte that can not be there
+   scan_string_body(bodyStart, bodyEnd, '\0', interpolated);
+   if (interpolated) {
+      m_tokenFlags |= Token::Interpolated;
+   }
+   formToken(result, TokenKindType::heredoc_literal, tokStart);
+   return true;
+}
+
+bool Lexer::tryLexCast(Token &result, const char *tokStart)
+{
+   const char *ptr = skip_blanks(tokStart + 1, m_bufferEnd);
+   const char *typeStart = ptr;
+   while (ptr != m_bufferEnd && is_char_class(*ptr, CC_Alpha)) {
+      ++ptr;
+   }
+   if (ptr == typeStart) {
+      return false;
+   }
+   StringRef typeName(typeStart, ptr - typeStart);
+   ptr = skip_blanks(ptr, m_bufferEnd);
+   if (char_at(ptr, m_bufferEnd) != ')') {
+      return false;
+   }
+   for (const CastEntry &entry : sg_castTypes) {
+      if (typeName.equalsLower(entry.typeName)) {
+         m_curPtr = ptr + 1;
+         formToken(result, entry.kind, tokStart);
+         return true;
+      }
+   }
+   return false;
+}
+
+void Lexer::lexCloseTag(Token &result, const char *tokStart)
+{
+   /// a single newline right after ?> belongs to the tag
+   const char *ptr = tokStart + 2;
+   if (char_at(ptr, m_bufferEnd) == '\r') {
+      ++ptr;
+   }
+   if (char_at(ptr, m_bufferEnd) == '\n') {
+      ++ptr;
+   }
+   m_curPtr = ptr;
+   m_mode = LexerMode::InlineHtml;
+   formToken(result, TokenKindType::close_tag, tokStart);
+}
+
+void Lexer::lexPunctuator(Token &result, const char *tokStart)
+{
+   const char *end = m_bufferEnd;
+   char c1 = char_at(tokStart + 1, end);
+   char c2 = char_at(tokStart + 2, end);
+   unsigned length = 1;
+   TokenKindType kind = TokenKindType::unknown;
+   switch (*tokStart) {
+   case '(': kind = TokenKindType::l_paren; break;
+   case ')': kind = TokenKindType::r_paren; break;
+   case '[': kind = TokenKindType::l_square; break;
+   case ']': kind = TokenKindType::r_square; break;
+   case '{': kind = TokenKindType::l_brace; break;
+   case '}': kind = TokenKindType::r_brace; break;
+   case ';': kind = TokenKindType::semi; break;
+   case ',': kind = TokenKindType::comma; break;
+   case '~': kind = TokenKindType::tilde; break;
+   case '@': kind = TokenKindType::at; break;
+   case '\\': kind = TokenKindType::backslash; break;
+   case '.':
+      if (c1 == '.' && c2 == '.') {
+         kind = TokenKindType::ellipsis;
+         length = 3;
+      } else if (c1 == '=') {
+         kind = TokenKindType::period_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::period;
+      }
+      break;
+   case '=':
+      if (c1 == '=' && c2 == '=') {
+         kind = TokenKindType::equal_equal_equal;
+         length = 3;
+      } else if (c1 == '=') {
+         kind = TokenKindType::equal_equal;
+         length = 2;
+      } else if (c1 == '>') {
+         kind = TokenKindType::double_arrow;
+         length = 2;
+      } else {
+         kind = TokenKindType::equal;
+      }
+      break;
+   case '+':
+      if (c1 == '+') {
+         kind = TokenKindType::plus_plus;
+         length = 2;
+      } else if (c1 == '=') {
+         kind = TokenKindType::plus_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::plus;
+      }
+      break;
+   case '-':
+      if (c1 == '-') {
+         kind = TokenKindType::minus_minus;
+         length = 2;
+      } else if (c1 == '=') {
+         kind = TokenKindType::minus_equal;
+         length = 2;
+      } else if (c1 == '>') {
+         kind = TokenKindType::arrow;
+         length = 2;
+      } else {
+         kind = TokenKindType::minus;
+      }
+      break;
+   case '*':
+      if (c1 == '*' && c2 == '=') {
+         kind = TokenKindType::star_star_equal;
+         length = 3;
+      } else if (c1 == '*') {
+         kind = TokenKindType::star_star;
+         length = 2;
+      } else if (c1 == '=') {
+         kind = TokenKindType::star_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::star;
+      }
+      break;
+   case '/':
+      if (c1 == '=') {
+         kind = TokenKindType::slash_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::slash;
+      }
+      break;
+   case '%':
+      if (c1 == '=') {
+         kind = TokenKindType::percent_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::percent;
+      }
+      break;
+   case '<':
+      if (c1 == '<' && c2 == '=') {
+         kind = TokenKindType::shl_equal;
+         length = 3;
+      } else if (c1 == '<') {
+         kind = TokenKindType::shl;
+         length = 2;
+      } else if (c1 == '=' && c2 == '>') {
+         kind = TokenKindType::spaceship;
+         length = 3;
+      } else if (c1 == '=') {
+         kind = TokenKindType::less_equal;
+         length = 2;
+      } else if (c1 == '>') {
+         /// <> is another spelling of !=
+         kind = TokenKindType::exclaim_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::less;
+      }
+      break;
+   case '>':
+      if (c1 == '>' && c2 == '=') {
+         kind = TokenKindType::shr_equal;
+         length = 3;
+      } else if (c1 == '>') {
+         kind = TokenKindType::shr;
+         length = 2;
+      } else if (c1 == '=') {
+         kind = TokenKindType::greater_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::greater;
+      }
+      break;
+   case '!':
+      if (c1 == '=' && c2 == '=') {
+         kind = TokenKindType::exclaim_equal_equal;
+         length = 3;
+      } else if (c1 == '=') {
+         kind = TokenKindType::exclaim_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::exclaim;
+      }
+      break;
+   case '^':
+      if (c1 == '=') {
+         kind = TokenKindType::caret_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::caret;
+      }
+      break;
+   case '&':
+      if (c1 == '&') {
+         kind = TokenKindType::amp_amp;
+         length = 2;
+      } else if (c1 == '=') {
+         kind = TokenKindType::amp_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::amp;
+      }
+      break;
+   case '|':
+      if (c1 == '|') {
+         kind = TokenKindType::pipe_pipe;
+         length = 2;
+      } else if (c1 == '=') {
+         kind = TokenKindType::pipe_equal;
+         length = 2;
+      } else {
+         kind = TokenKindType::pipe;
+      }
+      break;
+   case '?':
+      if (c1 == '?') {
+         kind = TokenKindType::question_question;
+         length = 2;
+      } else {
+         kind = TokenKindType::question;
+      }
+      break;
+   case ':':
+      if (c1 == ':') {
+         kind = TokenKindType::colon_colon;
+         length = 2;
+      } else {
+         kind = TokenKindType::colon;
+      }
+      break;
+   default:
+      break;
+   }
+   m_curPtr = tokStart + length;
+   formToken(result, kind, tokStart);
+}
+
+} // polar::parser
@@ -0,0 +1,581 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/parser/ProjectParser.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/basic/adt/SmallVector.h"
+#include "polarphp/utils/FastHash.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+#include "polarphp/utils/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace polar::parser {
+
+using polar::basic::SmallString;
+using polar::basic::SmallVector;
+using polar::syntax::RawSyntax;
+using polar::syntax::SyntaxKind;
+using polar::syntax::TokenKindType;
+using polar::utils::MemoryBuffer;
+using polar::utils::OptionalError;
+using polar::utils::RawStringOutStream;
+using polar::utils::ThreadPool;
+
+namespace {
+
+/// the text of the declared names is ascii in practice, php folds the case
+/// of class and function names byte wise as well
+std::string fold_case(StringRef name)
+{
+   std::string folded = name.getStr();
+   for (char &c : folded) {
+      if (c >= 'A' && c <= 'Z') {
+         c = c - 'A' + 'a';
+      }
+   }
+   return folded;
+}
+
+StringRef get_decl_kind_name(IndexedDeclKind kind)
+{
+   switch (kind) {
+   case IndexedDeclKind::Class:
+      return "class";
+   case IndexedDeclKind::Interface:
+      return "interface";
+   case IndexedDeclKind::Trait:
+      return "trait";
+   case IndexedDeclKind::Function:
+      return "function";
+   case IndexedDeclKind::Constant:
+      return "constant";
+   }
+   return "declaration";
+}
+
+bool is_class_like(IndexedDeclKind kind)
+{
+   return kind == IndexedDeclKind::Class || kind == IndexedDeclKind::Interface ||
+         kind == IndexedDeclKind::Trait;
+}
+
+/// a child of a layout together with its offset in the file
+struct Element
+{
+   const RawSyntax *node;
+   unsigned offset;
+
+   bool is(TokenKindType kind) const
+   {
+      return node->isToken() && node->getTokenKind() == kind;
+   }
+
+   bool isLayout(SyntaxKind kind) const
+   {
+      return node->is(kind);
+   }
+
+   /// offset of the token text, after its leading trivia
+   unsigned getTextOffset() const
+   {
+      return offset + node->getTextLength() - node->getTokenText().size();
+   }
+};
+
+bool is_space(char c)
+{
+   return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// the source text of elements without the leading trivia of the first one,
+/// every run of whitespace becomes a single space
+std::string make_signature(ArrayRef<Element> elements)
+{
+   if (elements.empty()) {
+      return std::string();
+   }
+   std::string text;
+   {
+      RawStringOutStream out(text);
+      for (const Element &element : elements) {
+         element.node->print(out);
+      }
+   }
+   std::string signature;
+   signature.reserve(text.size());
+   bool pendingSpace = false;
+   unsigned leadingTrivia = elements.front().getTextOffset() - elements.front().offset;
+   for (char c : StringRef(text).dropFront(leadingTrivia)) {
+      if (is_space(c)) {
+         pendingSpace = true;
+         continue;
+      }
+      if (pendingSpace && !signature.empty()) {
+         signature += ' ';
+      }
+      pendingSpace = false;
+      signature += c;
+   }
+   return signature;
+}
+
+/// the head of a declaration, everything in front of its body or ;
+ArrayRef<Element> take_until_body(ArrayRef<Element> elements)
+{
+   unsigned count = 0;
+   while (count < elements.size() && !elements[count].isLayout(SyntaxKind::CodeBlock) &&
+          !elements[count].is(TokenKindType::semi)) {
+      ++count;
+   }
+   return elements.takeFront(count);
+}
+
+///
+/// finds the top level declarations of a file: the statements of the file
+/// and of namespace blocks, and the blocks of if statements, which is where
+/// conditional declarations (polyfills, function_exists guards) live
+///
+class DeclCollector
+{
+public:
+   DeclCollector(unsigned fileIndex, std::vector<IndexedDecl> &decls)
+      : m_fileIndex(fileIndex),
+        m_decls(decls)
+   {}
+
+   void collectSourceFile(const RawSyntax *sourceFile)
+   {
+      collectList(sourceFile, 0, true);
+   }
+
+private:
+   void collectList(const RawSyntax *list, unsigned offset, bool isFileLevel)
+   {
+      for (const RawSyntax *child : list->getChildren()) {
+         if (child->is(SyntaxKind::Statement)) {
+            collectStatement(child, offset, isFileLevel);
+         }
+         offset += child->getTextLength();
+      }
+   }
+
+   void collectStatement(const RawSyntax *statement, unsigned offset, bool isFileLevel)
+   {
+      SmallVector<Element, 16> elements;
+      for (const RawSyntax *child : statement->getChildren()) {
+         elements.push_back({child, offset});
+         offset += child->getTextLength();
+      }
+      if (elements.empty() || !elements.front().node->isToken()) {
+         return;
+      }
+      unsigned index = 0;
+      m_docComment = elements.front().node->getLeadingTrivia().getDocComment();
+      switch (elements.front().node->getTokenKind()) {
+      case TokenKindType::kw_namespace:
+         if (isFileLevel) {
+            collectNamespace(elements);
+         }
+         return;
+      case TokenKindType::kw_if:
+         for (const Element &element : elements) {
+            if (element.isLayout(SyntaxKind::CodeBlock)) {
+               collectList(element.node, element.offset, false);
+            }
+         }
+         return;
+      case TokenKindType::kw_const:
+         collectConstants(elements);
+         return;
+      case TokenKindType::kw_function:
+         index = 1;
+         if (index < elements.size() && elements[index].is(TokenKindType::amp)) {
+            ++index;
+         }
+         /// function () {} is a closure
+         if (index < elements.size() && elements[index].is(TokenKindType::identifier)) {
+            addDecl(IndexedDeclKind::Function, elements[index], make_signature(take_until_body(elements)));
+         }
+         return;
+      default:
+         break;
+      }
+      while (index < elements.size() &&
+             (elements[index].is(TokenKindType::kw_abstract) ||
+              elements[index].is(TokenKindType::kw_final))) {
+         ++index;
+      }
+      if (index + 1 >= elements.size() || !elements[index + 1].is(TokenKindType::identifier)) {
+         return;
+      }
+      IndexedDeclKind kind;
+      if (elements[index].is(TokenKindType::kw_class)) {
+         kind = IndexedDeclKind::Class;
+      } else if (elements[index].is(TokenKindType::kw_interface)) {
+         kind = IndexedDeclKind::Interface;
+      } else if (elements[index].is(TokenKindType::kw_trait)) {
+         kind = IndexedDeclKind::Trait;
+      } else {
+         return;
+      }
+      addDecl(kind, elements[index + 1], make_signature(take_until_body(elements)));
+   }
+
+   /// namespace A\B; and namespace A\B { ... }, `namespace\foo()` is a
+   /// call relative to the current namespace
+   void collectNamespace(ArrayRef<Element> elements)
+   {
+      if (elements.size() > 1 && elements[1].is(TokenKindType::backslash)) {
+         return;
+      }
+      std::string name;
+      unsigned index = 1;
+      for (; index < elements.size(); ++index) {
+         const Element &element = elements[index];
+         if (element.is(TokenKindType::identifier) || element.is(TokenKindType::backslash)) {
+            name += element.node->getTokenText();
+         } else {
+            break;
+         }
+      }
+      if (index < elements.size() && elements[index].isLayout(SyntaxKind::CodeBlock)) {
+         std::string enclosing = std::move(m_namespace);
+         m_namespace = std::move(name);
+         collectList(elements[index].node, elements[index].offset, false);
+         m_namespace = std::move(enclosing);
+         return;
+      }
+      m_namespace = std::move(name);
+   }
+
+   /// const A = 1, B = 2;
+   void collectConstants(ArrayRef<Element> elements)
+   {
+      for (unsigned index = 1; index + 1 < elements.size(); ++index) {
+         if (elements[index].is(TokenKindType::identifier) &&
+             elements[index + 1].is(TokenKindType::equal) &&
+             (elements[index - 1].is(TokenKindType::kw_const) ||
+              elements[index - 1].is(TokenKindType::comma))) {
+            unsigned end = index + 2;
+            while (end < elements.size() && !elements[end].is(TokenKindType::comma) &&
+                   !elements[end].is(TokenKindType::semi)) {
+               ++end;
+            }
+            addDecl(IndexedDeclKind::Constant, elements[index],
+                    "const " + make_signature(elements.slice(index, end - index)));
+         }
+      }
+   }
+
+   void addDecl(IndexedDeclKind kind, const Element &nameToken, std::string signature)
+   {
+      IndexedDecl decl;
+      decl.kind = kind;
+      decl.fileIndex = m_fileIndex;
+      decl.offset = nameToken.getTextOffset();
+      decl.line = 0;
+      decl.column = 0;
+      if (!m_namespace.empty()) {
+         decl.name = m_namespace;
+         decl.name += '\\';
+      }
+      decl.name += nameToken.node->getTokenText();
+      decl.signature = std::move(signature);
+      decl.docComment = m_docComment.getStr();
+      m_decls.push_back(std::move(decl));
+   }
+
+private:
+   unsigned m_fileIndex;
+   std::vector<IndexedDecl> &m_decls;
+   std::string m_namespace;
+   /// of the statement being collected
+   StringRef m_docComment;
+};
+
+StringRef strip_leading_backslash(StringRef name)
+{
+   return name.startsWith("\\") ? name.dropFront(1) : name;
+}
+
+} // anonymous namespace
+
+void DeclarationIndex::build(std::vector<IndexedDecl> decls,
+                             std::vector<std::pair<unsigned, unsigned>> &redeclarations)
+{
+   m_decls = std::move(decls);
+   m_classLikes.clear();
+   m_functions.clear();
+   m_constants.clear();
+   for (unsigned index = 0; index < m_decls.size(); ++index) {
+      const IndexedDecl &decl = m_decls[index];
+      std::pair<StringMap<unsigned>::iterator, bool> inserted;
+      if (is_class_like(decl.kind)) {
+         inserted = m_classLikes.insert({fold_case(decl.name), index});
+      } else if (decl.kind == IndexedDeclKind::Function) {
+         inserted = m_functions.insert({fold_case(decl.name), index});
+      } else {
+         inserted = m_constants.insert({decl.name, index});
+      }
+      if (!inserted.second) {
+         redeclarations.emplace_back(inserted.first->getValue(), index);
+      }
+   }
+}
+
+const IndexedDecl *DeclarationIndex::lookup(const StringMap<unsigned> &map, StringRef key) const
+{
+   auto iter = map.find(key);
+   return iter == map.end() ? nullptr : &m_decls[iter->getValue()];
+}
+
+const IndexedDecl *DeclarationIndex::lookupClassLike(StringRef qualifiedName) const
+{
+   return lookup(m_classLikes, fold_case(strip_leading_backslash(qualifiedName)));
+}
+
+const IndexedDecl *DeclarationIndex::lookupFunction(StringRef qualifiedName) const
+{
+   return lookup(m_functions, fold_case(strip_leading_backslash(qualifiedName)));
+}
+
+const IndexedDecl *DeclarationIndex::lookupConstant(StringRef qualifiedName) const
+{
+   return lookup(m_constants, strip_leading_backslash(qualifiedName));
+}
+
+namespace {
+
+template <typename LookupFn>
+const IndexedDecl *resolve_with_fallback(StringRef name, StringRef currentNamespace,
+                                         LookupFn lookup)
+{
+   if (name.startsWith("\\")) {
+      return lookup(name);
+   }
+   if (!currentNamespace.empty()) {
+      SmallString<128> qualified(strip_leading_backslash(currentNamespace));
+      qualified += '\\';
+      qualified += name;
+      if (const IndexedDecl *decl = lookup(qualified.getStr())) {
+         return decl;
+      }
+      /// only unqualified names fall back to the global namespace
+      if (name.find('\\') != StringRef::npos) {
+         return nullptr;
+      }
+   }
+   return lookup(name);
+}
+
+} // anonymous namespace
+
+const IndexedDecl *DeclarationIndex::resolveFunction(StringRef name,
+                                                     StringRef currentNamespace) const
+{
+   return resolve_with_fallback(name, currentNamespace, [this](StringRef qualifiedName) {
+      return lookupFunction(qualifiedName);
+   });
+}
+
+const IndexedDecl *DeclarationIndex::resolveConstant(StringRef name,
+                                                     StringRef currentNamespace) const
+{
+   return resolve_with_fallback(name, currentNamespace, [this](StringRef qualifiedName) {
+      return lookupConstant(qualifiedName);
+   });
+}
+
+ParseResultCache::~ParseResultCache()
+{}
+
+ProjectParser::ProjectParser(const ProjectParserOptions &options)
+   : m_options(options)
+{}
+
+ProjectParser::~ProjectParser()
+{}
+
+unsigned ProjectParser::addFile(StringRef path)
+{
+   m_files.emplace_back();
+   m_files.back().path = path.getStr();
+   return m_files.size() - 1;
+}
+
+unsigned ProjectParser::addBuffer(StringRef name, StringRef text)
+{
+   m_files.emplace_back();
+   m_files.back().path = name.getStr();
+   m_files.back().text = text;
+   return m_files.size() - 1;
+}
+
+void ProjectParser::parseFile(unsigned fileIndex)
+{
+   FileState &file = m_files[fileIndex];
+   std::unique_ptr<MemoryBuffer> buffer;
+   StringRef text = file.text;
+   if (!text.data()) {
+      OptionalError<std::unique_ptr<MemoryBuffer>> bufferOrError = MemoryBuffer::getFile(file.path);
+      if (std::error_code errorCode = bufferOrError.getError()) {
+         file.readFailed = true;
+         file.diagnostics.push_back({ProjectDiagnosticKind::Error, fileIndex, 0, 0, 0,
+                                     "can not read file: " + errorCode.message()});
+         return;
+      }
+      buffer = std::move(bufferOrError.get());
+      text = buffer->getBuffer();
+   }
+   if (m_options.cache) {
+      file.contentHash = getContentHash(text);
+      if (m_options.cache->lookup(file.path, file.contentHash, fileIndex, file.decls,
+                                  file.diagnostics)) {
+         file.cached = true;
+         return;
+      }
+   }
+   std::vector<SyntaxIssue> issues;
+   LineTable lineTable;
+   Syntax tree = SyntaxParser(m_options.shortOpenTag).parse(text, &issues, &lineTable);
+   DeclCollector(fileIndex, file.decls).collectSourceFile(tree.getRaw());
+
+   for (const SyntaxIssue &issue : issues) {
+      std::pair<unsigned, unsigned> position = lineTable.getLineAndColumn(issue.offset);
+      file.diagnostics.push_back({ProjectDiagnosticKind::Error, fileIndex, issue.offset,
+                                  position.first, position.second,
+                                  get_syntax_issue_message(issue.kind).getStr()});
+   }
+   for (IndexedDecl &decl : file.decls) {
+      std::tie(decl.line, decl.column) = lineTable.getLineAndColumn(decl.offset);
+   }
+   if (m_options.retainTrees) {
+      file.tree = std::move(tree);
+   }
+   /// the tree owns copies of the text, the buffer can go
+}
+
+bool ProjectParser::parseAll()
+{
+   std::vector<unsigned> pending;
+   for (unsigned index = 0; index < m_files.size(); ++index) {
+      if (!m_files[index].parsed) {
+         pending.push_back(index);
+      }
+   }
+   unsigned threadCount = m_options.threadCount;
+   if (threadCount == 0) {
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+   }
+   threadCount = std::min<std::size_t>(threadCount, pending.size());
+   std::atomic<unsigned> next(0);
+   auto worker = [this, &pending, &next]() {
+      for (unsigned slot = next++; slot < pending.size(); slot = next++) {
+         parseFile(pending[slot]);
+      }
+   };
+   if (threadCount <= 1) {
+      worker();
+   } else {
+      ThreadPool pool(threadCount);
+      for (unsigned i = 0; i < threadCount; ++i) {
+         pool.async(worker);
+      }
+      pool.wait();
+   }
+   m_numCachedFiles = 0;
+   for (unsigned index : pending) {
+      FileState &file = m_files[index];
+      file.parsed = true;
+      if (file.cached) {
+         ++m_numCachedFiles;
+      }
+      if (m_options.cache && !file.readFailed) {
+         m_options.cache->store(file.path, file.contentHash, file.decls, file.diagnostics);
+      }
+   }
+   merge();
+   return std::none_of(m_files.begin(), m_files.end(), [](const FileState &file) {
+      return file.readFailed;
+   });
+}
+
+void ProjectParser::merge()
+{
+   std::vector<IndexedDecl> decls;
+   std::size_t declCount = 0;
+   std::size_t diagnosticCount = 0;
+   for (const FileState &file : m_files) {
+      declCount += file.decls.size();
+      diagnosticCount += file.diagnostics.size();
+   }
+   decls.reserve(declCount);
+   m_diagnostics.clear();
+   m_diagnostics.reserve(diagnosticCount);
+   for (const FileState &file : m_files) {
+      decls.insert(decls.end(), file.decls.begin(), file.decls.end());
+      m_diagnostics.insert(m_diagnostics.end(), file.diagnostics.begin(), file.diagnostics.end());
+   }
+   std::vector<std::pair<unsigned, unsigned>> redeclarations;
+   m_index.build(std::move(decls), redeclarations);
+   ArrayRef<IndexedDecl> indexed = m_index.getDecls();
+   for (const std::pair<unsigned, unsigned> &redeclaration : redeclarations) {
+      const IndexedDecl &previous = indexed[redeclaration.first];
+      const IndexedDecl &decl = indexed[redeclaration.second];
+      m_diagnostics.push_back({ProjectDiagnosticKind::Error, decl.fileIndex, decl.offset,
+                               decl.line, decl.column,
+                               "cannot redeclare " + get_decl_kind_name(decl.kind).getStr() +
+                               " '" + decl.name + "'"});
+      m_diagnostics.push_back({ProjectDiagnosticKind::Note, decl.fileIndex, decl.offset,
+                               decl.line, decl.column,
+                               "previously declared in " + m_files[previous.fileIndex].path +
+                               ":" + std::to_string(previous.line)});
+   }
+   /// stable, a note stays right after its error
+   std::stable_sort(m_diagnostics.begin(), m_diagnostics.end(),
+                    [](const ProjectDiagnostic &lhs, const ProjectDiagnostic &rhs) {
+      if (lhs.fileIndex != rhs.fileIndex) {
+         return lhs.fileIndex < rhs.fileIndex;
+      }
+      return lhs.offset < rhs.offset;
+   });
+}
+
+uint64_t ProjectParser::getContentHash(StringRef text) const
+{
+   uint64_t hash = polar::utils::fast_hash64(text);
+   /// <? is an open tag or inline html depending on the option
+   return m_options.shortOpenTag ? ~hash : hash;
+}
+
+unsigned ProjectParser::getNumErrors() const
+{
+   return std::count_if(m_diagnostics.begin(), m_diagnostics.end(),
+                        [](const ProjectDiagnostic &diagnostic) {
+      return diagnostic.kind == ProjectDiagnosticKind::Error;
+   });
+}
+
+void ProjectParser::printDiagnostics(RawOutStream &out) const
+{
+   for (const ProjectDiagnostic &diagnostic : m_diagnostics) {
+      out << m_files[diagnostic.fileIndex].path << ':' << diagnostic.line << ':'
+          << diagnostic.column << ": "
+          << (diagnostic.kind == ProjectDiagnosticKind::Error ? "error: " : "note: ")
+          << diagnostic.message << '\n';
+   }
+}
+
+} // polar::parser
@@ -269,31 +269,18 @@ std::optional<unsigned> SourceManager::resolveFromLineCol(unsigned bufferId,
    if (line == 0 || col == 0) {
       return std::nullopt;
    }
-   auto inputBuf = getBasicSourceMgr().getMemoryBuffer(bufferId);
-   const char *ptr = inputBuf->getBufferStart();
-   const char *end = inputBuf->getBufferEnd();
-   const char *lineStart = ptr;
-   --line;
-   for (; line && (ptr < end); ++ptr) {
-      if (*ptr == '\n') {
-         --line;
-         lineStart = ptr+1;
-      }
-   }
-   if (line != 0) {
+   const LineTable &lineTable = getBasicSourceMgr().getLineTable(bufferId);
+   if (line > lineTable.getNumLines()) {
       return std::nullopt;
    }
-   ptr = lineStart;
-
-   // The <= here is to allow for non-inclusive range end positions at EOF
-   for (; ptr <= end; ++ptr) {
-      --col;
-      if (col == 0) {
-         return ptr - inputBuf->getBufferStart();
-      }
-      if (*ptr == '\n') {
-         break;
-      }
+   std::size_t lineStart = lineTable.getLineStart(line);
+   // The last column of a line is its '\n', the end of the buffer is allowed
+   // for non-inclusive range end positions at EOF
+   std::size_t lineEnd = line < lineTable.getNumLines()
+         ? lineTable.getLineStart(line + 1) - 1
+         : getBasicSourceMgr().getMemoryBuffer(bufferId)->getBufferSize();
+   if (col - 1 <= lineEnd - lineStart) {
+      return lineStart + col - 1;
    }
    return std::nullopt;
 }
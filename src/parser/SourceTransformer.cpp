@@ -0,0 +1,298 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/parser/SourceTransformer.h"
+#include "polarphp/parser/Lexer.h"
+#include "polarphp/syntax/TokenKinds.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+#include "polarphp/utils/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polar::parser {
+
+using polar::syntax::is_magic_const_token;
+using polar::utils::MemoryBuffer;
+using polar::utils::OptionalError;
+using polar::utils::RawStringOutStream;
+using polar::utils::ThreadPool;
+
+namespace {
+
+/// the same escaping as zend_html_puts, the bytes in between are written
+/// as one run instead of one putc each
+void write_html_escaped(StringRef text, RawOutStream &out)
+{
+   const char *runStart = text.begin();
+   for (const char *ptr = text.begin(), *end = text.end(); ptr != end; ++ptr) {
+      StringRef replacement;
+      switch (*ptr) {
+      case '\n':
+         replacement = "<br />";
+         break;
+      case '<':
+         replacement = "&lt;";
+         break;
+      case '>':
+         replacement = "&gt;";
+         break;
+      case '&':
+         replacement = "&amp;";
+         break;
+      case ' ':
+         replacement = "&nbsp;";
+         break;
+      case '\t':
+         replacement = "&nbsp;&nbsp;&nbsp;&nbsp;";
+         break;
+      default:
+         continue;
+      }
+      out.write(runStart, ptr - runStart);
+      out << replacement;
+      runStart = ptr + 1;
+   }
+   out.write(runStart, text.end() - runStart);
+}
+
+/// the color zend_highlight gives a token, literals and names carry a value
+/// in the zend scanner and get the default color, bare keywords and
+/// punctuators get the keyword color
+const std::string &get_highlight_color(const Token &token, const HighlightColors &colors)
+{
+   TokenKindType kind = token.getKind();
+   switch (kind) {
+   case TokenKindType::inline_html:
+      return colors.html;
+   case TokenKindType::comment:
+   case TokenKindType::doc_comment:
+      return colors.comment;
+   case TokenKindType::open_tag:
+   case TokenKindType::open_tag_with_echo:
+   case TokenKindType::close_tag:
+   case TokenKindType::identifier:
+   case TokenKindType::variable:
+   case TokenKindType::integer_literal:
+   case TokenKindType::float_literal:
+      return colors.defaultColor;
+   case TokenKindType::string_literal:
+   case TokenKindType::heredoc_literal:
+   case TokenKindType::nowdoc_literal:
+   case TokenKindType::backquote_literal:
+      return colors.string;
+   default:
+      break;
+   }
+   if (is_magic_const_token(kind)) {
+      return colors.defaultColor;
+   }
+   return colors.keyword;
+}
+
+void transform_source(StringRef source, RawOutStream &out, const SourceTransformOptions &options)
+{
+   if (options.kind == SourceTransformKind::Strip) {
+      strip_source(source, out, options.shortOpenTag);
+   } else {
+      highlight_source(source, out, options.colors, options.shortOpenTag);
+   }
+}
+
+bool read_source(const std::string &path, std::unique_ptr<MemoryBuffer> &buffer,
+                 RawOutStream &errors)
+{
+   OptionalError<std::unique_ptr<MemoryBuffer>> bufferOrError =
+         MemoryBuffer::getFileOrStdIn(path, -1, false);
+   if (!bufferOrError) {
+      errors << "Could not open input file: " << path << "\n";
+      return false;
+   }
+   buffer = std::move(bufferOrError.get());
+   return true;
+}
+
+} // anonymous namespace
+
+void strip_source(StringRef source, RawOutStream &out, bool shortOpenTag)
+{
+   Lexer lexer(source, LexerMode::InlineHtml, CommentRetentionMode::ReturnAsTokens,
+               shortOpenTag);
+   Token token;
+   bool prevSpace = false;
+   bool lexed = false;
+   while (true) {
+      if (!lexed) {
+         lexer.lex(token);
+      }
+      lexed = false;
+      if (token.getLeadingTriviaLength() != 0 && !prevSpace) {
+         out << ' ';
+         prevSpace = true;
+      }
+      if (token.is(TokenKindType::eof)) {
+         break;
+      }
+      if (token.isAny(TokenKindType::comment, TokenKindType::doc_comment)) {
+         continue;
+      }
+      out << token.getText();
+      prevSpace = false;
+      if (token.isAny(TokenKindType::heredoc_literal, TokenKindType::nowdoc_literal)) {
+         /// the closing label must end its line, keep the ; or whatever is
+         /// glued to it and then break the line the way php -w does
+         lexer.lex(token);
+         if (token.is(TokenKindType::eof)) {
+            out << '\n';
+            break;
+         }
+         prevSpace = true;
+         if (token.getLeadingTriviaLength() == 0 &&
+             !token.isAny(TokenKindType::comment, TokenKindType::doc_comment)) {
+            out << token.getText() << '\n';
+            continue;
+         }
+         out << '\n';
+         /// one behind whitespace or a comment is written as usual
+         lexed = true;
+      }
+   }
+}
+
+void highlight_source(StringRef source, RawOutStream &out, const HighlightColors &colors,
+                      bool shortOpenTag)
+{
+   Lexer lexer(source, LexerMode::InlineHtml, CommentRetentionMode::ReturnAsTokens,
+               shortOpenTag);
+   /// colors are compared by identity like zend_highlight does, so two ini
+   /// entries with the same value still open a new span
+   const std::string *lastColor = &colors.html;
+   out << "<code><span style=\"color: " << colors.html << "\">\n";
+   Token token;
+   while (true) {
+      lexer.lex(token);
+      write_html_escaped(token.getLeadingTrivia(), out);
+      if (token.is(TokenKindType::eof)) {
+         break;
+      }
+      const std::string *nextColor = &get_highlight_color(token, colors);
+      if (lastColor != nextColor) {
+         if (lastColor != &colors.html) {
+            out << "</span>";
+         }
+         lastColor = nextColor;
+         if (lastColor != &colors.html) {
+            out << "<span style=\"color: " << *lastColor << "\">";
+         }
+      }
+      write_html_escaped(token.getText(), out);
+   }
+   if (lastColor != &colors.html) {
+      out << "</span>\n";
+   }
+   out << "</span>\n</code>";
+}
+
+bool transform_source_files(ArrayRef<std::string> paths, RawOutStream &out,
+                            RawOutStream &errors, const SourceTransformOptions &options)
+{
+   unsigned threadCount = options.threadCount;
+   if (threadCount == 0) {
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+   }
+   threadCount = std::min<std::size_t>(threadCount, paths.size());
+   if (threadCount <= 1) {
+      bool succeeded = true;
+      for (const std::string &path : paths) {
+         std::unique_ptr<MemoryBuffer> buffer;
+         if (!read_source(path, buffer, errors)) {
+            succeeded = false;
+            continue;
+         }
+         transform_source(buffer->getBuffer(), out, options);
+      }
+      return succeeded;
+   }
+
+   struct FileResult
+   {
+      std::string output;
+      std::string error;
+      bool done = false;
+   };
+   std::vector<FileResult> results(paths.size());
+   /// a worker does not start a file more than window slots ahead of the
+   /// writer, so a slow file in front does not pile up every other output
+   const std::size_t window = threadCount * 4;
+   std::mutex mutex;
+   std::condition_variable doneCondition;
+   std::condition_variable writtenCondition;
+   std::size_t written = 0;
+   std::atomic<unsigned> next(0);
+   auto worker = [&]() {
+      for (unsigned slot = next++; slot < paths.size(); slot = next++) {
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            writtenCondition.wait(lock, [&]() {
+               return slot < written + window;
+            });
+         }
+         FileResult &result = results[slot];
+         RawStringOutStream resultOut(result.output);
+         RawStringOutStream errorOut(result.error);
+         std::unique_ptr<MemoryBuffer> buffer;
+         if (read_source(paths[slot], buffer, errorOut)) {
+            transform_source(buffer->getBuffer(), resultOut, options);
+         }
+         resultOut.flush();
+         errorOut.flush();
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            result.done = true;
+         }
+         doneCondition.notify_one();
+      }
+   };
+
+   ThreadPool pool(threadCount);
+   for (unsigned i = 0; i < threadCount; ++i) {
+      pool.async(worker);
+   }
+   bool succeeded = true;
+   for (FileResult &result : results) {
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         doneCondition.wait(lock, [&result]() {
+            return result.done;
+         });
+      }
+      if (!result.error.empty()) {
+         errors << result.error;
+         succeeded = false;
+      }
+      out << result.output;
+      std::string().swap(result.output);
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         ++written;
+      }
+      writtenCondition.notify_all();
+   }
+   pool.wait();
+   return succeeded;
+}
+
+} // polar::parser
@@ -0,0 +1,502 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#include "polarphp/parser/SyntaxParser.h"
+#include "polarphp/parser/Lexer.h"
+#include "polarphp/basic/adt/SmallVector.h"
+#include "polarphp/syntax/SyntaxFactory.h"
+#include "polarphp/utils/ErrorHandling.h"
+
+#include <algorithm>
+
+namespace polar::parser {
+
+using polar::basic::SmallVector;
+using polar::syntax::RawSyntax;
+using polar::syntax::SyntaxArena;
+using polar::syntax::SyntaxFactory;
+using polar::syntax::SyntaxKind;
+using polar::basic::IntrusiveRefCountPtr;
+
+namespace {
+
+bool is_tag_or_html(TokenKindType kind)
+{
+   return kind == TokenKindType::inline_html || kind == TokenKindType::open_tag ||
+         kind == TokenKindType::open_tag_with_echo;
+}
+
+/// the lexer mode right after a token of kind
+LexerMode get_mode_after(TokenKindType kind)
+{
+   return kind == TokenKindType::close_tag || kind == TokenKindType::inline_html
+         ? LexerMode::InlineHtml
+         : LexerMode::Scripting;
+}
+
+/// a statement that reached a code block goes on only when the next token
+/// clearly continues it, `} else {`, `function () {};`, `} while (...)`
+/// after a do block
+bool continues_after_block(TokenKindType next, bool startsWithDo)
+{
+   switch (next) {
+   case TokenKindType::semi:
+   case TokenKindType::comma:
+   case TokenKindType::arrow:
+   case TokenKindType::l_paren:
+   case TokenKindType::l_square:
+   case TokenKindType::kw_else:
+   case TokenKindType::kw_elseif:
+   case TokenKindType::kw_catch:
+   case TokenKindType::kw_finally:
+      return true;
+   case TokenKindType::kw_while:
+      return startsWithDo;
+   default:
+      return false;
+   }
+}
+
+bool is_closer(TokenKindType kind)
+{
+   return kind == TokenKindType::r_brace || kind == TokenKindType::r_paren ||
+         kind == TokenKindType::r_square;
+}
+
+class TreeBuilder
+{
+public:
+   TreeBuilder(Lexer &lexer, const SyntaxFactory &factory, const char *sourceStart,
+               std::vector<SyntaxIssue> *issues = nullptr)
+      : m_lexer(lexer),
+        m_factory(factory),
+        m_sourceStart(sourceStart),
+        m_lastEnd(nullptr),
+        m_issues(issues)
+   {
+      m_lexer.lex(m_token);
+   }
+
+   const Token &peek() const
+   {
+      return m_token;
+   }
+
+   unsigned getTokenOffset() const
+   {
+      return m_token.getStart() - m_sourceStart;
+   }
+
+   /// the end of the text of the last consumed token
+   unsigned getLastEndOffset() const
+   {
+      return m_lastEnd - m_sourceStart;
+   }
+
+   /// groupCloser is set when the token closes the group being built, any
+   /// other closing bracket is unmatched
+   const RawSyntax *consumeToken(bool groupCloser = false)
+   {
+      if (m_issues) {
+         noteIssues(groupCloser);
+      }
+      const RawSyntax *token = m_factory.makeToken(m_token.getKind(), m_token.getText(),
+                                                   m_token.getLeadingTrivia());
+      m_lastEnd = m_token.getEnd();
+      if (m_token.isNot(TokenKindType::eof)) {
+         m_lexer.lex(m_token);
+      }
+      return token;
+   }
+
+   const RawSyntax *parseSourceFile()
+   {
+      SmallVector<const RawSyntax *, 64> statements;
+      while (const RawSyntax *statement = parseStatement(false)) {
+         statements.push_back(statement);
+      }
+      return m_factory.makeSourceFile(statements, consumeToken());
+   }
+
+   /// null at the end of the enclosing list, eof or the } of the block
+   const RawSyntax *parseStatement(bool inBlock)
+   {
+      TokenKindType kind = m_token.getKind();
+      if (kind == TokenKindType::eof || (inBlock && kind == TokenKindType::r_brace)) {
+         return nullptr;
+      }
+      SmallVector<const RawSyntax *, 16> elements;
+      if (is_tag_or_html(kind)) {
+         elements.push_back(consumeToken());
+         return m_factory.makeStatement(elements);
+      }
+      bool startsWithDo = kind == TokenKindType::kw_do;
+      while (true) {
+         kind = m_token.getKind();
+         if (kind == TokenKindType::eof || is_tag_or_html(kind) ||
+             (inBlock && kind == TokenKindType::r_brace)) {
+            break;
+         }
+         if (kind == TokenKindType::l_brace) {
+            elements.push_back(parseGroup(SyntaxKind::CodeBlock, TokenKindType::r_brace));
+            if (!continues_after_block(m_token.getKind(), startsWithDo)) {
+               break;
+            }
+            continue;
+         }
+         if (kind == TokenKindType::l_paren) {
+            elements.push_back(parseGroup(SyntaxKind::ParenGroup, TokenKindType::r_paren));
+            continue;
+         }
+         if (kind == TokenKindType::l_square) {
+            elements.push_back(parseGroup(SyntaxKind::SquareGroup, TokenKindType::r_square));
+            continue;
+         }
+         elements.push_back(consumeToken());
+         if (kind == TokenKindType::semi || kind == TokenKindType::close_tag) {
+            break;
+         }
+      }
+      return m_factory.makeStatement(elements);
+   }
+
+   const RawSyntax *parseGroup(SyntaxKind groupKind, TokenKindType closer)
+   {
+      SmallVector<const RawSyntax *, 16> elements;
+      unsigned openerOffset = getTokenOffset();
+      elements.push_back(consumeToken());
+      while (true) {
+         TokenKindType kind = m_token.getKind();
+         if (kind == closer) {
+            elements.push_back(consumeToken(true));
+            break;
+         }
+         if (kind == TokenKindType::eof) {
+            noteIssue(SyntaxIssueKind::MissingCloser, openerOffset);
+            break;
+         }
+         if (groupKind == SyntaxKind::CodeBlock) {
+            elements.push_back(parseStatement(true));
+            continue;
+         }
+         /// an unbalanced ( or [ ends at the } of the enclosing block
+         if (kind == TokenKindType::r_brace) {
+            noteIssue(SyntaxIssueKind::MissingCloser, openerOffset);
+            break;
+         }
+         if (kind == TokenKindType::l_brace) {
+            elements.push_back(parseGroup(SyntaxKind::CodeBlock, TokenKindType::r_brace));
+         } else if (kind == TokenKindType::l_paren) {
+            elements.push_back(parseGroup(SyntaxKind::ParenGroup, TokenKindType::r_paren));
+         } else if (kind == TokenKindType::l_square) {
+            elements.push_back(parseGroup(SyntaxKind::SquareGroup, TokenKindType::r_square));
+         } else {
+            elements.push_back(consumeToken());
+         }
+      }
+      return RawSyntax::makeLayout(m_factory.getArena(), groupKind, elements);
+   }
+
+private:
+   void noteIssue(SyntaxIssueKind kind, unsigned offset)
+   {
+      if (m_issues) {
+         m_issues->push_back({kind, offset});
+      }
+   }
+
+   void noteIssues(bool groupCloser)
+   {
+      TokenKindType kind = m_token.getKind();
+      if (kind == TokenKindType::unknown) {
+         noteIssue(SyntaxIssueKind::UnexpectedCharacter, getTokenOffset());
+      } else if (!groupCloser && is_closer(kind)) {
+         noteIssue(SyntaxIssueKind::UnmatchedCloser, getTokenOffset());
+      }
+      if (!m_token.isUnterminated()) {
+         return;
+      }
+      if (kind == TokenKindType::eof) {
+         /// only a comment in the trivia of eof can run to the end
+         StringRef trivia = m_token.getLeadingTrivia();
+         std::size_t commentStart = trivia.rfind("/*");
+         unsigned triviaOffset = getTokenOffset() - trivia.size();
+         noteIssue(SyntaxIssueKind::UnterminatedComment,
+                   triviaOffset + (commentStart == StringRef::npos ? 0 : commentStart));
+      } else {
+         noteIssue(SyntaxIssueKind::UnterminatedLiteral, getTokenOffset());
+      }
+   }
+
+private:
+   Lexer &m_lexer;
+   const SyntaxFactory &m_factory;
+   const char *m_sourceStart;
+   const char *m_lastEnd;
+   std::vector<SyntaxIssue> *m_issues;
+   Token m_token;
+};
+
+struct PathEntry
+{
+   const RawSyntax *node;
+   unsigned offset;
+   /// the child the path goes on with
+   unsigned childIndex;
+};
+
+bool is_closed_block(const RawSyntax *node)
+{
+   if (!node->is(SyntaxKind::CodeBlock) || node->getNumChildren() < 2) {
+      return false;
+   }
+   const RawSyntax *closer = node->getChild(node->getNumChildren() - 1);
+   return closer->isToken() && closer->getTokenKind() == TokenKindType::r_brace;
+}
+
+/// the edit lies between the braces and leaves both untouched
+bool block_contains_edit(const PathEntry &entry, const SourceEdit &edit)
+{
+   if (!is_closed_block(entry.node)) {
+      return false;
+   }
+   unsigned interiorStart = entry.offset + entry.node->getChild(0)->getTextLength();
+   unsigned closerStart = entry.offset + entry.node->getTextLength() - 1;
+   return interiorStart <= edit.offset && edit.offset + edit.removedLength <= closerStart;
+}
+
+TokenKindType get_last_token_kind(const RawSyntax *node)
+{
+   const RawSyntax *token = node->getLastToken();
+   return token ? token->getTokenKind() : TokenKindType::unknown;
+}
+
+class Reparser
+{
+public:
+   Reparser(StringRef newSource, const SourceEdit &edit, const SyntaxFactory &factory,
+            bool shortOpenTag)
+      : m_newSource(newSource),
+        m_edit(edit),
+        m_factory(factory),
+        m_shortOpenTag(shortOpenTag)
+   {}
+
+   /// a replacement for the list node (code block or source file) at
+   /// offset, null if the edit turned out to reach past it
+   const RawSyntax *reparseList(const RawSyntax *node, unsigned offset);
+
+   unsigned getReparsedBytes() const
+   {
+      return m_reparsedBytes;
+   }
+
+private:
+   StringRef m_newSource;
+   SourceEdit m_edit;
+   const SyntaxFactory &m_factory;
+   bool m_shortOpenTag;
+   unsigned m_reparsedBytes = 0;
+};
+
+const RawSyntax *Reparser::reparseList(const RawSyntax *node, unsigned offset)
+{
+   bool isBlock = node->is(SyntaxKind::CodeBlock);
+   unsigned first = isBlock ? 1 : 0;
+   unsigned closer = node->getNumChildren() - 1;
+   unsigned editEnd = m_edit.offset + m_edit.removedLength;
+   int delta = static_cast<int>(m_edit.insertedLength) - static_cast<int>(m_edit.removedLength);
+
+   /// find the statement the edit starts in, the one before it may end
+   /// differently (a removed ;) and the one before that looked at its
+   /// first token to decide where it ends, so restart two statements back
+   unsigned start = offset;
+   for (unsigned i = 0; i < first; ++i) {
+      start += node->getChild(i)->getTextLength();
+   }
+   unsigned index = first;
+   while (index < closer) {
+      unsigned width = node->getChild(index)->getTextLength();
+      if (m_edit.offset < start + width) {
+         break;
+      }
+      start += width;
+      ++index;
+   }
+   for (unsigned i = 0; i < 2 && index > first; ++i) {
+      --index;
+      start -= node->getChild(index)->getTextLength();
+   }
+   /// a statement ending in -> would change how the next token lexes
+   while (index > first && get_last_token_kind(node->getChild(index - 1)) == TokenKindType::arrow) {
+      --index;
+      start -= node->getChild(index)->getTextLength();
+   }
+   LexerMode mode = isBlock ? LexerMode::Scripting : LexerMode::InlineHtml;
+   if (index > first) {
+      mode = get_mode_after(get_last_token_kind(node->getChild(index - 1)));
+   }
+
+   Lexer lexer(m_newSource.substr(start), mode, CommentRetentionMode::None, m_shortOpenTag);
+   TreeBuilder builder(lexer, m_factory, m_newSource.data());
+   SmallVector<const RawSyntax *, 64> children(node->getChildren().begin(),
+                                               node->getChildren().begin() + index);
+   unsigned newEditEnd = m_edit.offset + m_edit.insertedLength;
+   unsigned oldIndex = index;
+   unsigned oldEnd = start;
+   while (const RawSyntax *statement = builder.parseStatement(isBlock)) {
+      children.push_back(statement);
+      unsigned newEnd = builder.getLastEndOffset();
+      if (newEnd < newEditEnd) {
+         continue;
+      }
+      /// line the new statement end up with an old one after the edit
+      unsigned target = newEnd - delta;
+      while (oldIndex < closer && oldEnd < target) {
+         oldEnd += node->getChild(oldIndex)->getTextLength();
+         ++oldIndex;
+      }
+      if (oldEnd == target && target >= editEnd && oldIndex > index &&
+          get_last_token_kind(node->getChild(oldIndex - 1)) == get_last_token_kind(statement)) {
+         m_reparsedBytes += newEnd - start;
+         for (unsigned i = oldIndex; i <= closer; ++i) {
+            children.push_back(node->getChild(i));
+         }
+         return RawSyntax::makeLayout(m_factory.getArena(), node->getKind(), children);
+      }
+   }
+   if (!isBlock) {
+      children.push_back(builder.consumeToken());
+      m_reparsedBytes += m_newSource.size() - start;
+      return RawSyntax::makeLayout(m_factory.getArena(), SyntaxKind::SourceFile, children);
+   }
+   /// the block has to close with the same }, otherwise the edit leaked out
+   unsigned oldCloserStart = offset + node->getTextLength() - 1;
+   if (builder.peek().isNot(TokenKindType::r_brace) ||
+       builder.getTokenOffset() != oldCloserStart + delta) {
+      return nullptr;
+   }
+   children.push_back(builder.consumeToken());
+   m_reparsedBytes += builder.getLastEndOffset() - start;
+   return RawSyntax::makeLayout(m_factory.getArena(), SyntaxKind::CodeBlock, children);
+}
+
+} // anonymous namespace
+
+StringRef get_syntax_issue_message(SyntaxIssueKind kind)
+{
+   switch (kind) {
+   case SyntaxIssueKind::UnexpectedCharacter:
+      return "unexpected character";
+   case SyntaxIssueKind::UnterminatedLiteral:
+      return "unterminated string or heredoc";
+   case SyntaxIssueKind::UnterminatedComment:
+      return "unterminated comment";
+   case SyntaxIssueKind::UnmatchedCloser:
+      return "unmatched closing bracket";
+   case SyntaxIssueKind::MissingCloser:
+      return "bracket is never closed";
+   }
+   polar_unreachable("unknown syntax issue kind");
+}
+
+Syntax SyntaxParser::parse(StringRef source, std::vector<SyntaxIssue> *issues,
+                          LineTable *lineTable) const
+{
+   SyntaxFactory factory(SyntaxArena::make());
+   Lexer lexer(source, LexerMode::InlineHtml, CommentRetentionMode::None, m_shortOpenTag);
+   lexer.setLineTable(lineTable);
+   std::size_t firstIssue = issues ? issues->size() : 0;
+   TreeBuilder builder(lexer, factory, source.data(), issues);
+   Syntax tree = factory.makeRoot(builder.parseSourceFile());
+   if (issues) {
+      /// a missing closer is only known once its group ends, after the
+      /// issues found inside the group
+      std::stable_sort(issues->begin() + firstIssue, issues->end(),
+                       [](const SyntaxIssue &left, const SyntaxIssue &right) {
+         return left.offset < right.offset;
+      });
+   }
+   if (lineTable) {
+      lineTable->finish(source);
+   }
+   return tree;
+}
+
+Syntax SyntaxParser::reparse(const Syntax &oldTree, StringRef newSource, const SourceEdit &edit,
+                             ReparseStats *stats) const
+{
+   const RawSyntax *oldRoot = oldTree.getRoot().getRaw();
+   unsigned oldLength = oldRoot->getTextLength();
+   if (!oldRoot->is(SyntaxKind::SourceFile) || edit.offset + edit.removedLength > oldLength ||
+       oldLength - edit.removedLength + edit.insertedLength != newSource.size()) {
+      if (stats) {
+         stats->fullParse = true;
+         stats->reparsedBytes = newSource.size();
+      }
+      return parse(newSource);
+   }
+   IntrusiveRefCountPtr<SyntaxArena> arena = oldTree.getData()->getArena();
+   SyntaxFactory factory(arena);
+
+   /// walk down to the innermost node that contains the whole edit
+   SmallVector<PathEntry, 16> path;
+   const RawSyntax *node = oldRoot;
+   unsigned offset = 0;
+   while (true) {
+      path.push_back({node, offset, 0});
+      const RawSyntax *next = nullptr;
+      unsigned childOffset = offset;
+      for (unsigned i = 0, count = node->getNumChildren(); i < count; ++i) {
+         const RawSyntax *child = node->getChild(i);
+         unsigned childEnd = childOffset + child->getTextLength();
+         if (edit.offset < childEnd) {
+            if (!child->isToken() && childOffset <= edit.offset &&
+                edit.offset + edit.removedLength <= childEnd) {
+               path.back().childIndex = i;
+               next = child;
+            }
+            break;
+         }
+         childOffset = childEnd;
+      }
+      if (!next) {
+         break;
+      }
+      node = next;
+      offset = childOffset;
+   }
+
+   Reparser reparser(newSource, edit, factory, m_shortOpenTag);
+   for (unsigned depth = path.size(); depth > 0; --depth) {
+      const PathEntry &entry = path[depth - 1];
+      if (depth != 1 && !block_contains_edit(entry, edit)) {
+         continue;
+      }
+      const RawSyntax *replacement = reparser.reparseList(entry.node, entry.offset);
+      if (!replacement) {
+         continue;
+      }
+      for (unsigned i = depth - 1; i > 0; --i) {
+         const PathEntry &parent = path[i - 1];
+         replacement = parent.node->replaceChild(*arena, parent.childIndex, replacement);
+      }
+      assert(replacement->getTextLength() == newSource.size() && "reparse lost some text");
+      if (stats) {
+         stats->fullParse = depth == 1 && reparser.getReparsedBytes() == newSource.size();
+         stats->reparsedBytes = reparser.getReparsedBytes();
+      }
+      return factory.makeRoot(replacement);
+   }
+   polar_unreachable("the source file always reparses");
+}
+
+} // polar::parser
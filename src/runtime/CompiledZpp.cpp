@@ -0,0 +1,44 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/runtime/internal/CompiledZpp.h"
+
+namespace polar {
+namespace runtime {
+namespace internal {
+
+void report_zpp_error(int flags, const ZppError &error)
+{
+   if (flags & ZEND_PARSE_PARAMS_QUIET) {
+      return;
+   }
+   if (flags & ZEND_PARSE_PARAMS_THROW) {
+      zend_wrong_parameter_type_exception(error.num, error.expected, error.arg);
+   } else {
+      zend_wrong_parameter_type_error(error.num, error.expected, error.arg);
+   }
+}
+
+void report_zpp_count_error(int flags, uint32_t minArgs, uint32_t maxArgs)
+{
+   if (flags & ZEND_PARSE_PARAMS_QUIET) {
+      return;
+   }
+   if (flags & ZEND_PARSE_PARAMS_THROW) {
+      zend_wrong_parameters_count_exception(minArgs, maxArgs);
+   } else {
+      zend_wrong_parameters_count_error(minArgs, maxArgs);
+   }
+}
+
+} // internal
+} // runtime
+} // polar
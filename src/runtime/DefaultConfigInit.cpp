@@ -54,6 +54,7 @@ POLAR_INI_BEGIN()
    POLAR_STD_INI_ENTRY("extension_dir",             POLARPHP_EXTENSION_DIR, POLAR_INI_SYSTEM,                  update_string_unempty_handler,    extensionDir,               ExecEnvInfo,           sg_execEnvInfo)
    POLAR_STD_INI_ENTRY("sys_temp_dir",              "",                     POLAR_INI_SYSTEM,                  update_string_unempty_handler,    sysTempDir,                 ExecEnvInfo,           sg_execEnvInfo)
    POLAR_STD_INI_ENTRY("include_path",              POLARPHP_INCLUDE_PATH,  POLAR_INI_ALL,                     update_string_unempty_handler,    includePath,                ExecEnvInfo,           sg_execEnvInfo)
+   POLAR_STD_INI_BOOLEAN("include_prefetch",        "0",                    POLAR_INI_SYSTEM,                  update_bool_handler,              includePrefetch,            ExecEnvInfo,           sg_execEnvInfo)
    POLAR_INI_ENTRY("max_execution_time",            "30",                   POLAR_INI_ALL,                     update_timeout_handler)
    POLAR_STD_INI_ENTRY("open_basedir",              "",                     POLAR_INI_ALL,                     update_base_dir_handler,          openBaseDir,                ExecEnvInfo,           sg_execEnvInfo)
 
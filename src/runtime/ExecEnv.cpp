@@ -20,6 +20,7 @@
 #include "polarphp/runtime/Output.h"
 #include "polarphp/runtime/Utils.h"
 #include "polarphp/runtime/Ini.h"
+#include "polarphp/utils/ConvertUtf.h"
 
 #include <filesystem>
 #include <cstdio>
@@ -127,6 +128,9 @@ ExecEnv::ExecEnv()
    m_runtimeInfo.docrefExt = ".html";
    m_runtimeInfo.includePath = ".:/php/includes";
    m_runtimeInfo.reportMemLeaks = true;
+   m_runtimeInfo.workerMode = false;
+   m_runtimeInfo.fastResetRequests = 0;
+   m_runtimeInfo.includePrefetch = false;
    m_runtimeInfo.serializePrecision = -1;
 }
 
@@ -173,6 +177,26 @@ bool ExecEnv::bootup()
    return true;
 }
 
+bool ExecEnv::restartRequest()
+{
+   if (!m_execEnvStarted) {
+      return false;
+   }
+   php_exec_env_shutdown();
+   m_execEnvStarted = false;
+   m_runtimeInfo.duringExecEnvStartup = true;
+   polar_try {
+      CG(in_compilation) = 0;
+      if (!php_exec_env_startup()) {
+         std::cerr << "Could not startup." << std::endl;
+         return false;
+      }
+   } polar_end_try;
+   m_execEnvStarted = true;
+   m_runtimeInfo.duringExecEnvStartup = false;
+   return true;
+}
+
 void ExecEnv::shutdown()
 {
    if (m_execEnvDestroyed) {
@@ -253,6 +277,17 @@ ExecEnv &ExecEnv::setEnvReady(bool flag)
    return *this;
 }
 
+ExecEnv &ExecEnv::setWorkerMode(bool flag)
+{
+   m_runtimeInfo.workerMode = flag;
+   return *this;
+}
+
+bool ExecEnv::isWorkerMode() const
+{
+   return m_runtimeInfo.workerMode;
+}
+
 bool ExecEnv::isEnvReady() const
 {
    return m_execEnvReady;
@@ -1236,6 +1271,11 @@ zend_string *php_resolve_path_for_zend(const char *filename, size_t filenameLen)
    return php_resolve_path(filename, filenameLen, execEnvInfo.includePath.c_str());
 }
 
+size_t php_utf8_validate_for_zend(const unsigned char *str, size_t strLength)
+{
+   return utils::find_invalid_utf8(str, str + strLength) - str;
+}
+
 bool seek_file_begin(zend_file_handle *fileHandle, const char *scriptFile, int *lineno)
 {
    int c;
@@ -0,0 +1,48 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/runtime/IdentifierInterner.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+#include "polarphp/ast/IdentifierTable.h"
+
+namespace polar {
+namespace runtime {
+
+using polar::basic::StringRef;
+
+namespace {
+
+StringRef find_permanent_interned(StringRef text)
+{
+   /// the interned strings are not set up yet or already gone
+   if (!zend_empty_string) {
+      return StringRef();
+   }
+   zend_string *key;
+   ALLOCA_FLAG(useHeap);
+   ZSTR_ALLOCA_INIT(key, text.data(), text.size(), useHeap);
+   zend_string *interned = zend_interned_string_find_permanent(key);
+   ZSTR_ALLOCA_FREE(key, useHeap);
+   if (!interned) {
+      return StringRef();
+   }
+   return StringRef(ZSTR_VAL(interned), ZSTR_LEN(interned));
+}
+
+} // anonymous namespace
+
+void install_identifier_interner(ast::IdentifierTable &table)
+{
+   table.setExternalInterner(find_permanent_interned);
+}
+
+} // runtime
+} // polar
@@ -0,0 +1,577 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/runtime/IncludePrefetch.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+#include "polarphp/global/php_config.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(POLAR_OS_LINUX) && HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define POLAR_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace polar {
+namespace runtime {
+
+namespace {
+
+constexpr std::size_t POLAR_PREFETCH_MAX_FILE_SIZE = 8 * 1024 * 1024;
+constexpr std::size_t POLAR_PREFETCH_MAX_TOTAL_SIZE = 64 * 1024 * 1024;
+constexpr std::size_t POLAR_PREFETCH_MAX_RECORDED = 4096;
+
+#ifdef POLAR_HAVE_IO_URING
+constexpr unsigned POLAR_PREFETCH_RING_ENTRIES = 64;
+
+///
+/// just enough of io_uring for batched reads, talks to the kernel through
+/// the raw syscalls so we do not need liburing at build time
+///
+class IoUring
+{
+public:
+   IoUring() = default;
+   IoUring(const IoUring &) = delete;
+   IoUring &operator=(const IoUring &) = delete;
+
+   ~IoUring()
+   {
+      close();
+   }
+
+   bool open(unsigned entries);
+   void close();
+
+   bool isOpen() const
+   {
+      return m_fd >= 0;
+   }
+
+   /// false when the submission queue is full, submit and reap first
+   bool prepareRead(int fd, struct iovec *iov, std::uint64_t offset, void *userData);
+   /// hand prepared entries to the kernel, optionally wait for completions
+   bool submit(unsigned waitCount);
+
+   template <typename Handler>
+   unsigned reap(Handler &&handler)
+   {
+      unsigned head = *m_cqHead;
+      unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+      unsigned count = 0;
+      while (head != tail) {
+         struct io_uring_cqe *cqe = &m_cqes[head & *m_cqMask];
+         handler(reinterpret_cast<void *>(static_cast<std::uintptr_t>(cqe->user_data)), cqe->res);
+         ++head;
+         ++count;
+      }
+      __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+      return count;
+   }
+
+private:
+   int m_fd = -1;
+   unsigned m_pending = 0;
+   unsigned m_sqEntries = 0;
+   void *m_sqRing = nullptr;
+   void *m_cqRing = nullptr;
+   std::size_t m_sqRingSize = 0;
+   std::size_t m_cqRingSize = 0;
+   struct io_uring_sqe *m_sqes = nullptr;
+   std::size_t m_sqesSize = 0;
+   unsigned *m_sqHead = nullptr;
+   unsigned *m_sqTail = nullptr;
+   unsigned *m_sqMask = nullptr;
+   unsigned *m_sqArray = nullptr;
+   unsigned *m_cqHead = nullptr;
+   unsigned *m_cqTail = nullptr;
+   unsigned *m_cqMask = nullptr;
+   struct io_uring_cqe *m_cqes = nullptr;
+};
+
+bool IoUring::open(unsigned entries)
+{
+   struct io_uring_params params;
+   std::memset(&params, 0, sizeof(params));
+   int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+   if (fd < 0) {
+      return false;
+   }
+   m_fd = fd;
+   m_sqEntries = params.sq_entries;
+   m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   bool singleMmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+   singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+   if (singleMmap) {
+      m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+   }
+   m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_fd, IORING_OFF_SQ_RING);
+   if (m_sqRing == MAP_FAILED) {
+      m_sqRing = nullptr;
+      close();
+      return false;
+   }
+   if (singleMmap) {
+      m_cqRing = m_sqRing;
+   } else {
+      m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_fd, IORING_OFF_CQ_RING);
+      if (m_cqRing == MAP_FAILED) {
+         m_cqRing = nullptr;
+         close();
+         return false;
+      }
+   }
+   m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+   void *sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       m_fd, IORING_OFF_SQES);
+   if (sqes == MAP_FAILED) {
+      close();
+      return false;
+   }
+   m_sqes = static_cast<struct io_uring_sqe *>(sqes);
+   char *sqRing = static_cast<char *>(m_sqRing);
+   char *cqRing = static_cast<char *>(m_cqRing);
+   m_sqHead = reinterpret_cast<unsigned *>(sqRing + params.sq_off.head);
+   m_sqTail = reinterpret_cast<unsigned *>(sqRing + params.sq_off.tail);
+   m_sqMask = reinterpret_cast<unsigned *>(sqRing + params.sq_off.ring_mask);
+   m_sqArray = reinterpret_cast<unsigned *>(sqRing + params.sq_off.array);
+   m_cqHead = reinterpret_cast<unsigned *>(cqRing + params.cq_off.head);
+   m_cqTail = reinterpret_cast<unsigned *>(cqRing + params.cq_off.tail);
+   m_cqMask = reinterpret_cast<unsigned *>(cqRing + params.cq_off.ring_mask);
+   m_cqes = reinterpret_cast<struct io_uring_cqe *>(cqRing + params.cq_off.cqes);
+   return true;
+}
+
+void IoUring::close()
+{
+   if (m_sqes) {
+      ::munmap(m_sqes, m_sqesSize);
+      m_sqes = nullptr;
+   }
+   if (m_cqRing && m_cqRing != m_sqRing) {
+      ::munmap(m_cqRing, m_cqRingSize);
+   }
+   m_cqRing = nullptr;
+   if (m_sqRing) {
+      ::munmap(m_sqRing, m_sqRingSize);
+      m_sqRing = nullptr;
+   }
+   if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+   }
+   m_pending = 0;
+}
+
+bool IoUring::prepareRead(int fd, struct iovec *iov, std::uint64_t offset, void *userData)
+{
+   unsigned tail = *m_sqTail;
+   unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+   if (tail - head >= m_sqEntries) {
+      return false;
+   }
+   unsigned index = tail & *m_sqMask;
+   struct io_uring_sqe *sqe = &m_sqes[index];
+   std::memset(sqe, 0, sizeof(*sqe));
+   /// READV instead of READ keeps us working on 5.1 kernels
+   sqe->opcode = IORING_OP_READV;
+   sqe->fd = fd;
+   sqe->addr = reinterpret_cast<std::uintptr_t>(iov);
+   sqe->len = 1;
+   sqe->off = offset;
+   sqe->user_data = reinterpret_cast<std::uintptr_t>(userData);
+   m_sqArray[index] = index;
+   __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+   ++m_pending;
+   return true;
+}
+
+bool IoUring::submit(unsigned waitCount)
+{
+   if (m_pending == 0 && waitCount == 0) {
+      return true;
+   }
+   unsigned flags = waitCount > 0 ? IORING_ENTER_GETEVENTS : 0;
+   while (true) {
+      int ret = static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, m_pending, waitCount, flags, nullptr, 0));
+      if (ret >= 0) {
+         m_pending -= std::min(m_pending, static_cast<unsigned>(ret));
+         return true;
+      }
+      if (errno != EINTR) {
+         return false;
+      }
+   }
+}
+#endif
+
+enum class PrefetchState
+{
+   Pending,
+   Ready,
+   Failed
+};
+
+struct PrefetchedFile
+{
+   int fd;
+   char *buffer;
+   std::size_t size;
+   std::size_t done;
+   PrefetchState state;
+#ifdef POLAR_HAVE_IO_URING
+   struct iovec iov;
+#endif
+};
+
+using PrefetchedFilePtr = std::unique_ptr<PrefetchedFile>;
+
+struct IncludePrefetchData
+{
+#ifdef POLAR_HAVE_IO_URING
+   IoUring ring;
+#endif
+   bool probed = false;
+   std::size_t inflight = 0;
+   std::size_t totalSize = 0;
+   std::unordered_map<std::string, PrefetchedFilePtr> files;
+   std::vector<std::string> recordedIncludes;
+};
+
+#define PREFETCH_G(v) sg_includePrefetchData.v
+thread_local IncludePrefetchData sg_includePrefetchData;
+
+int (*sg_previousStreamOpenFunction)(const char *filename, zend_file_handle *handle) = nullptr;
+
+void release_prefetched_file(PrefetchedFile &file)
+{
+   if (file.fd >= 0) {
+      ::close(file.fd);
+      file.fd = -1;
+   }
+   if (file.buffer) {
+      std::free(file.buffer);
+      file.buffer = nullptr;
+      PREFETCH_G(totalSize) -= file.size;
+   }
+}
+
+#ifdef POLAR_HAVE_IO_URING
+void finish_prefetched_file(PrefetchedFile &file, std::size_t size)
+{
+   ::close(file.fd);
+   file.fd = -1;
+   /// the scanner expects ZEND_MMAP_AHEAD zero bytes after the script
+   std::memset(file.buffer + size, 0, file.size - size + ZEND_MMAP_AHEAD);
+   file.done = size;
+   file.state = PrefetchState::Ready;
+}
+
+bool ensure_prefetch_ring()
+{
+   if (!PREFETCH_G(probed)) {
+      PREFETCH_G(probed) = true;
+      PREFETCH_G(ring).open(POLAR_PREFETCH_RING_ENTRIES);
+   }
+   return PREFETCH_G(ring).isOpen();
+}
+
+void queue_prefetch_read(PrefetchedFile &file);
+
+void reap_prefetch_completions()
+{
+   PREFETCH_G(ring).reap([](void *userData, int result) {
+      PrefetchedFile &file = *static_cast<PrefetchedFile *>(userData);
+      --PREFETCH_G(inflight);
+      if (result < 0) {
+         ::close(file.fd);
+         file.fd = -1;
+         file.state = PrefetchState::Failed;
+         return;
+      }
+      file.done += static_cast<std::size_t>(result);
+      if (result == 0 || file.done >= file.size) {
+         /// a zero read means the file shrank, keep what we got
+         finish_prefetched_file(file, std::min(file.done, file.size));
+         return;
+      }
+      queue_prefetch_read(file);
+   });
+}
+
+void queue_prefetch_read(PrefetchedFile &file)
+{
+   file.iov.iov_base = file.buffer + file.done;
+   file.iov.iov_len = file.size - file.done;
+   while (!PREFETCH_G(ring).prepareRead(file.fd, &file.iov, file.done, &file)) {
+      /// submission queue is full, push it out and make room
+      if (!PREFETCH_G(ring).submit(1)) {
+         ::close(file.fd);
+         file.fd = -1;
+         file.state = PrefetchState::Failed;
+         return;
+      }
+      reap_prefetch_completions();
+   }
+   ++PREFETCH_G(inflight);
+}
+
+void wait_prefetched_file(PrefetchedFile &file)
+{
+   while (file.state == PrefetchState::Pending) {
+      if (!PREFETCH_G(ring).submit(1)) {
+         break;
+      }
+      reap_prefetch_completions();
+   }
+}
+
+bool wait_all_prefetched_files()
+{
+   while (PREFETCH_G(inflight) > 0) {
+      if (!PREFETCH_G(ring).submit(1)) {
+         return false;
+      }
+      reap_prefetch_completions();
+   }
+   return true;
+}
+#endif
+
+void prefetched_buffer_closer(void *handle)
+{
+   std::free(handle);
+}
+
+int open_without_prefetch(const char *filename, zend_file_handle *handle)
+{
+   if (sg_previousStreamOpenFunction) {
+      return sg_previousStreamOpenFunction(filename, handle);
+   }
+   /// same as zend_stream_open without a hook
+   handle->type = ZEND_HANDLE_FP;
+   handle->opened_path = nullptr;
+   handle->handle.fp = zend_fopen(filename, &handle->opened_path);
+   handle->filename = filename;
+   handle->free_filename = 0;
+   std::memset(&handle->handle.stream.mmap, 0, sizeof(zend_mmap));
+   return handle->handle.fp ? SUCCESS : FAILURE;
+}
+
+int prefetch_stream_open(const char *filename, zend_file_handle *handle)
+{
+   auto &files = PREFETCH_G(files);
+   if (files.empty()) {
+      return open_without_prefetch(filename, handle);
+   }
+   /// entries are keyed by real path, include_once hands us the resolved
+   /// path already, a plain include of a relative name is resolved the way
+   /// the engine does it, against include_path before the CWD
+   auto iter = files.find(filename);
+   if (iter == files.end()) {
+      zend_string *resolvedPath = zend_resolve_path(filename, std::strlen(filename));
+      if (resolvedPath) {
+         iter = files.find(std::string(ZSTR_VAL(resolvedPath), ZSTR_LEN(resolvedPath)));
+         zend_string_release(resolvedPath);
+      }
+      if (iter == files.end()) {
+         return open_without_prefetch(filename, handle);
+      }
+   }
+   PrefetchedFile &entry = *iter->second;
+#ifdef POLAR_HAVE_IO_URING
+   wait_prefetched_file(entry);
+#endif
+   if (entry.state == PrefetchState::Pending) {
+      /// the ring stopped working with a read still in flight, the kernel
+      /// may write into the buffer at any time, leave the entry in the map
+      /// so discard_include_prefetch deals with it
+      return open_without_prefetch(filename, handle);
+   }
+   /// the path the file was read from, not the name it was asked for,
+   /// include_once and __FILE__ go by it
+   zend_string *openedPath = zend_string_init(iter->first.data(), iter->first.size(), 0);
+   PrefetchedFilePtr file = std::move(iter->second);
+   files.erase(iter);
+   if (file->state != PrefetchState::Ready) {
+      zend_string_release(openedPath);
+      release_prefetched_file(*file);
+      /// the synchronous path reports the error the usual way
+      return open_without_prefetch(filename, handle);
+   }
+   PREFETCH_G(totalSize) -= file->size;
+   std::memset(&handle->handle.stream, 0, sizeof(zend_stream));
+   handle->type = ZEND_HANDLE_MAPPED;
+   handle->handle.stream.handle = file->buffer;
+   handle->handle.stream.closer = prefetched_buffer_closer;
+   handle->handle.stream.mmap.buf = file->buffer;
+   handle->handle.stream.mmap.len = file->done;
+   handle->filename = filename;
+   handle->free_filename = 0;
+   handle->opened_path = openedPath;
+   file->buffer = nullptr;
+   return SUCCESS;
+}
+
+} // anonymous namespace
+
+bool startup_include_prefetch()
+{
+   sg_previousStreamOpenFunction = zend_stream_open_function;
+   zend_stream_open_function = prefetch_stream_open;
+   return true;
+}
+
+void shutdown_include_prefetch()
+{
+   discard_include_prefetch();
+   if (zend_stream_open_function == prefetch_stream_open) {
+      zend_stream_open_function = sg_previousStreamOpenFunction;
+   }
+   sg_previousStreamOpenFunction = nullptr;
+   PREFETCH_G(recordedIncludes).clear();
+#ifdef POLAR_HAVE_IO_URING
+   PREFETCH_G(ring).close();
+   PREFETCH_G(probed) = false;
+#endif
+}
+
+bool is_include_prefetch_available()
+{
+#ifdef POLAR_HAVE_IO_URING
+   return ensure_prefetch_ring();
+#else
+   return false;
+#endif
+}
+
+std::size_t prefetch_include_files(const std::vector<std::string> &paths)
+{
+#ifdef POLAR_HAVE_IO_URING
+   if (!ensure_prefetch_ring()) {
+      return 0;
+   }
+   std::size_t submitted = 0;
+   char realPath[MAXPATHLEN];
+   for (const std::string &item : paths) {
+      /// the compiler opens includes by their resolved path, key the
+      /// entries the same way so relative paths hit too
+      if (!VCWD_REALPATH(item.c_str(), realPath)) {
+         continue;
+      }
+      std::string path(realPath);
+      if (PREFETCH_G(files).find(path) != PREFETCH_G(files).end()) {
+         continue;
+      }
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+         continue;
+      }
+      struct stat info;
+      if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+          static_cast<std::size_t>(info.st_size) > POLAR_PREFETCH_MAX_FILE_SIZE ||
+          PREFETCH_G(totalSize) + static_cast<std::size_t>(info.st_size) > POLAR_PREFETCH_MAX_TOTAL_SIZE) {
+         ::close(fd);
+         continue;
+      }
+      std::size_t size = static_cast<std::size_t>(info.st_size);
+      char *buffer = static_cast<char *>(std::malloc(size + ZEND_MMAP_AHEAD));
+      if (!buffer) {
+         ::close(fd);
+         break;
+      }
+      PrefetchedFilePtr file(new PrefetchedFile);
+      file->fd = fd;
+      file->buffer = buffer;
+      file->size = size;
+      file->done = 0;
+      file->state = PrefetchState::Pending;
+      PREFETCH_G(totalSize) += size;
+      PrefetchedFile &entry = *file;
+      PREFETCH_G(files).emplace(std::move(path), std::move(file));
+      if (size == 0) {
+         finish_prefetched_file(entry, 0);
+      } else {
+         queue_prefetch_read(entry);
+      }
+      ++submitted;
+   }
+   /// kick everything still queued, completions are reaped lazily when
+   /// the compiler asks for a file
+   PREFETCH_G(ring).submit(0);
+   return submitted;
+#else
+   (void) paths;
+   return 0;
+#endif
+}
+
+void record_include_graph()
+{
+   std::vector<std::string> &recorded = PREFETCH_G(recordedIncludes);
+   recorded.clear();
+   zend_string *path;
+   ZEND_HASH_FOREACH_STR_KEY(&EG(included_files), path) {
+      if (path && recorded.size() < POLAR_PREFETCH_MAX_RECORDED) {
+         recorded.emplace_back(ZSTR_VAL(path), ZSTR_LEN(path));
+      }
+   } ZEND_HASH_FOREACH_END();
+}
+
+void prefetch_recorded_includes()
+{
+   if (!PREFETCH_G(recordedIncludes).empty()) {
+      prefetch_include_files(PREFETCH_G(recordedIncludes));
+   }
+}
+
+void discard_include_prefetch()
+{
+#ifdef POLAR_HAVE_IO_URING
+   /// the kernel may still write into the buffers, let it finish first
+   bool drained = !PREFETCH_G(ring).isOpen() || wait_all_prefetched_files();
+#else
+   bool drained = true;
+#endif
+   for (auto &item : PREFETCH_G(files)) {
+      if (!drained && item.second->state == PrefetchState::Pending) {
+         /// we can no longer learn when the read finishes, the buffer and
+         /// the entry the completion points at are leaked on purpose
+         item.second.release();
+         continue;
+      }
+      release_prefetched_file(*item.second);
+   }
+   PREFETCH_G(files).clear();
+   PREFETCH_G(totalSize) = 0;
+}
+
+} // runtime
+} // polar
@@ -19,7 +19,10 @@
 #include "polarphp/runtime/Spprintf.h"
 
 #include "polarphp/runtime/Ticks.h"
+#include "polarphp/runtime/VmInterrupt.h"
+#include "polarphp/runtime/IncludePrefetch.h"
 #include "polarphp/global/Config.h"
+#include "polarphp/vm/zend/zend_resolve_cache.h"
 
 #include <cstring>
 #include <sys/wait.h>
@@ -189,7 +192,10 @@ bool php_module_startup()
    zuf.printf_to_smart_str_function = php_printf_to_smart_str;
    zuf.getenv_function = bootstrap_getenv;
    zuf.resolve_path_function = php_resolve_path_for_zend;
+   zuf.utf8_validate_function = php_utf8_validate_for_zend;
    zend_startup(&zuf, nullptr);
+   startup_vm_interrupt();
+   startup_include_prefetch();
 
 #if HAVE_SETLOCALE
    setlocale(LC_CTYPE, "");
@@ -422,6 +428,8 @@ void php_module_shutdown()
    }
    zend_interned_strings_switch_storage(0);
    ts_free_worker_threads();
+   shutdown_vm_interrupt();
+   shutdown_include_prefetch();
 
 #if ZEND_RC_DEBUG
    zend_rc_debug = 0;
@@ -455,6 +463,29 @@ void php_module_shutdown()
 }
 
 
+namespace {
+///
+/// in worker mode a request that left nothing observable behind (no live
+/// object waiting for its destructor, no open resource, no fatal error
+/// unwinding) does not need the element by element teardown, zend_mm
+/// releases the request memory in one go and keeps warm chunks cached
+/// for the next request
+///
+bool php_exec_env_can_fast_reset(const ExecEnvInfo &execEnvInfo)
+{
+   if (!execEnvInfo.workerMode || !is_zend_mm()) {
+      return false;
+   }
+   if (CG(unclean_shutdown) || EG(full_tables_cleanup)) {
+      return false;
+   }
+   if (zend_list_count() != 0) {
+      return false;
+   }
+   return !zend_objects_store_has_pending_destructors(&EG(objects_store));
+}
+} // anonymous namespace
+
 #ifdef PHP_SIGCHILD
 namespace {
 void sigchld_handler(int)
@@ -496,6 +527,9 @@ bool php_exec_env_startup()
       execEnvInfo.inUserInclude = false;
       zend_activate();
       execEnv.activate();
+      /// max_execution_time is enforced through EG(vm_interrupt), the
+      /// timer signal only raises the flag, nothing polls the clock
+      zend_set_timeout(EG(timeout_seconds), 1);
 
 #ifdef ZEND_SIGNALS
       zend_signal_activate();
@@ -524,6 +558,13 @@ bool php_exec_env_startup()
       php_hash_environment();
       zend_activate_modules();
       execEnvInfo.modulesActivated = true;
+      /// name resolutions only pay off when the process serves more requests
+      zend_resolve_cache_enable(execEnvInfo.workerMode);
+      /// reads are only submitted here, the compiler picks the buffers
+      /// up when the script actually includes the files
+      if (execEnvInfo.workerMode && execEnvInfo.includePrefetch) {
+         prefetch_recorded_includes();
+      }
    } polar_catch {
       retval = FAILURE;
    } polar_end_try;
@@ -550,7 +591,9 @@ void php_exec_env_shutdown()
        */
    EG(current_execute_data) = nullptr;
    deactivate_ticks();
+   deactivate_vm_interrupt();
    bool modulesActivated = execEnvInfo.modulesActivated;
+   bool fastReset = php_exec_env_can_fast_reset(execEnvInfo);
    /* 1. Call all possible shutdown functions registered with register_shutdown_function() */
    if (modulesActivated) {
       polar_try {
@@ -564,9 +607,11 @@ void php_exec_env_shutdown()
    }
 
    /* 2. Call all possible __destruct() functions */
-   polar_try {
-      zend_call_destructors();
-   } polar_end_try;
+   if (!fastReset) {
+      polar_try {
+         zend_call_destructors();
+      } polar_end_try;
+   }
 
    /* 3. Flush all output buffers */
    polar_try {
@@ -622,6 +667,24 @@ void php_exec_env_shutdown()
    /* 9. free request-bound globals */
    php_free_cli_exec_globals();
 
+   if (execEnvInfo.workerMode && execEnvInfo.includePrefetch) {
+      record_include_graph();
+   }
+   discard_include_prefetch();
+
+   /// output handlers run user code, take the fast path only if they
+   /// left nothing behind either
+   if (fastReset && !php_exec_env_can_fast_reset(execEnvInfo)) {
+      fastReset = false;
+      polar_try {
+         zend_call_destructors();
+      } polar_end_try;
+   }
+   if (fastReset) {
+      EG(flags) |= EG_FLAGS_FAST_RESET;
+      ++execEnvInfo.fastResetRequests;
+   }
+
    /* 10. Shutdown scanner/executor/compiler and restore ini entries */
    zend_deactivate();
 
@@ -640,8 +703,10 @@ void php_exec_env_shutdown()
 
    /* 14. Free Willy (here be crashes) */
    zend_interned_strings_deactivate();
+   /// fast reset skips the leak report and drops the request heap as a
+   /// whole, the tables above were not torn down element by element
    polar_try {
-      shutdown_memory_manager(CG(unclean_shutdown) || !reportMemleaks, 0);
+      shutdown_memory_manager(fastReset || CG(unclean_shutdown) || !reportMemleaks, 0);
    } polar_end_try;
 
    /* 15. Reset max_execution_time */
@@ -23,7 +23,7 @@
 namespace polar {
 namespace runtime {
 
-ZEND_DECLARE_MODULE_GLOBALS(output)
+ZEND_DECLARE_STATIC_MODULE_GLOBALS(output)
 const char php_output_default_handler_name[sizeof("default output handler")] = "default output handler";
 const char php_output_devnull_handler_name[sizeof("null output handler")] = "null output handler";
 
@@ -95,7 +95,7 @@ void reverse_conflict_dtor(zval *zv)
 
 void php_output_startup()
 {
-   ZEND_INIT_MODULE_GLOBALS(output, php_output_init_globals, nullptr);
+   ZEND_INIT_STATIC_MODULE_GLOBALS(output, php_output_init_globals, nullptr);
    zend_hash_init(&php_output_handler_aliases, 8, nullptr, nullptr, 1);
    zend_hash_init(&php_output_handler_conflicts, 8, nullptr, nullptr, 1);
    zend_hash_init(&php_output_handler_reverse_conflicts, 8, nullptr, reverse_conflict_dtor, 1);
@@ -112,7 +112,7 @@ void php_output_shutdown()
 
 bool php_output_activate()
 {
-   memset((*(reinterpret_cast<void ***>(ZEND_TSRMLS_CACHE)))[TSRM_UNSHUFFLE_RSRC_ID(output_globals_id)], 0, sizeof(zend_output_globals));
+   memset(ZEND_STATIC_MODULE_GLOBALS_BULK(output), 0, sizeof(zend_output_globals));
    zend_stack_init(&OG(handlers), sizeof(PhpOutputHandler *));
    OG(flags) |= PHP_OUTPUT_ACTIVATED;
 
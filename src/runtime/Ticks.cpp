@@ -13,73 +13,101 @@
 #include "polarphp/runtime/ExecEnv.h"
 #include "polarphp/runtime/internal/DepsZendVmHeaders.h"
 
+#include <algorithm>
+
 namespace polar {
 namespace runtime {
 
-struct st_tick_function
-{
-   void (*func)(int, void *);
-   void *arg;
-};
-
 namespace {
-int compare_tick_functions(void *elem1, void *elem2)
-{
-   st_tick_function *e1 = reinterpret_cast<st_tick_function *>(elem1);
-   st_tick_function *e2 = reinterpret_cast<st_tick_function *>(elem2);
-   return e1->func == e2->func && e1->arg == e2->arg;
-}
+/// run_ticks calls on the stack, removals only mark the entry while a
+/// dispatch is running and the array is compacted once it is done
+thread_local std::uint32_t sg_tickDispatchDepth = 0;
+thread_local bool sg_tickFunctionsRemoved = false;
 
-void tick_iterator(void *d, void *arg)
+/// a handler that bails out never returns to run_ticks
+void clear_tick_functions(ExecEnvInfo &execEnvInfo)
 {
-   st_tick_function *data = (st_tick_function *)d;
-   data->func(*((int *)arg), data->arg);
+   execEnvInfo.tickFunctions.clear();
+   sg_tickDispatchDepth = 0;
+   sg_tickFunctionsRemoved = false;
 }
 } // anonymous namespace
 
 bool startup_ticks(void)
 {
-   ExecEnvInfo &execEnvInfo = retrieve_global_execenv_runtime_info();
-   zend_llist &tickFunctions = execEnvInfo.tickFunctions;
-   zend_llist_init(&tickFunctions, sizeof(st_tick_function), nullptr, 1);
+   clear_tick_functions(retrieve_global_execenv_runtime_info());
    return true;
 }
 
 void deactivate_ticks(void)
 {
-   ExecEnvInfo &execEnvInfo = retrieve_global_execenv_runtime_info();
-   zend_llist &tickFunctions =  execEnvInfo.tickFunctions;
-   zend_llist_clean(&tickFunctions);
+   clear_tick_functions(retrieve_global_execenv_runtime_info());
 }
 
 void shutdown_ticks(void)
 {
-   ExecEnvInfo &execEnvInfo = retrieve_global_execenv_runtime_info();
-   zend_llist &tickFunctions =  execEnvInfo.tickFunctions;
-   zend_llist_destroy(&tickFunctions);
+   clear_tick_functions(retrieve_global_execenv_runtime_info());
 }
 
-void add_tick_function(void (*func)(int, void*), void * arg)
+void add_tick_function(TickFunction func, void *arg, std::uint32_t interval)
 {
    ExecEnvInfo &execEnvInfo = retrieve_global_execenv_runtime_info();
-   zend_llist &tickFunctions =  execEnvInfo.tickFunctions;
-   st_tick_function tmp = {func, arg};
-   zend_llist_add_element(&tickFunctions, (void *)&tmp);
+   if (interval == 0) {
+      interval = 1;
+   }
+   execEnvInfo.tickFunctions.push_back({func, arg, interval, interval});
 }
 
-void remove_tick_function(void (*func)(int, void *), void * arg)
+void remove_tick_function(TickFunction func, void *arg)
 {
    ExecEnvInfo &execEnvInfo = retrieve_global_execenv_runtime_info();
-   zend_llist &tickFunctions =  execEnvInfo.tickFunctions;
-   st_tick_function tmp = {func, arg};
-   zend_llist_del_element(&tickFunctions, (void *)&tmp, (int(*)(void*, void*))compare_tick_functions);
+   auto &tickFunctions = execEnvInfo.tickFunctions;
+   auto iter = std::find_if(tickFunctions.begin(), tickFunctions.end(),
+                            [func, arg](const TickFunctionEntry &entry) {
+      return entry.func == func && entry.arg == arg;
+   });
+   if (iter == tickFunctions.end()) {
+      return;
+   }
+   if (sg_tickDispatchDepth != 0) {
+      iter->func = nullptr;
+      sg_tickFunctionsRemoved = true;
+   } else {
+      tickFunctions.erase(iter);
+   }
 }
 
 void run_ticks(int count)
 {
    ExecEnvInfo &execEnvInfo = retrieve_global_execenv_runtime_info();
-   zend_llist &tickFunctions =  execEnvInfo.tickFunctions;
-   zend_llist_apply_with_argument(&tickFunctions, (llist_apply_with_arg_func_t) tick_iterator, &count);
+   auto &tickFunctions = execEnvInfo.tickFunctions;
+   if (tickFunctions.empty()) {
+      return;
+   }
+   /// handlers may register tick functions, which can grow the storage,
+   /// so index it on every step and never hold a reference across the
+   /// call. removed entries keep their slot until the dispatch is over
+   ++sg_tickDispatchDepth;
+   for (size_t i = 0; i < tickFunctions.size(); ++i) {
+      TickFunctionEntry &entry = tickFunctions[i];
+      if (!entry.func) {
+         continue;
+      }
+      if (entry.interval > 1 && --entry.countdown != 0) {
+         continue;
+      }
+      entry.countdown = entry.interval;
+      TickFunction func = entry.func;
+      void *arg = entry.arg;
+      func(count, arg);
+   }
+   if (--sg_tickDispatchDepth == 0 && sg_tickFunctionsRemoved) {
+      sg_tickFunctionsRemoved = false;
+      tickFunctions.erase(std::remove_if(tickFunctions.begin(), tickFunctions.end(),
+                                         [](const TickFunctionEntry &entry) {
+         return entry.func == nullptr;
+      }), tickFunctions.end());
+   }
 }
 
 } // runtime
@@ -0,0 +1,231 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/06.
+
+#include "polarphp/runtime/VmInterrupt.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#ifdef POLAR_OS_LINUX
+#include <sys/signalfd.h>
+#include <unistd.h>
+#endif
+
+namespace polar {
+namespace runtime {
+
+namespace {
+
+#ifdef NSIG
+constexpr int POLAR_VM_SIGNAL_COUNT = NSIG;
+#else
+constexpr int POLAR_VM_SIGNAL_COUNT = 65;
+#endif
+
+struct VmSignalEntry
+{
+   VmSignalHandler handler;
+   void *arg;
+   bool installed;
+   struct sigaction previous;
+};
+
+VmSignalEntry sg_signalEntries[POLAR_VM_SIGNAL_COUNT];
+volatile std::sig_atomic_t sg_pendingSignals[POLAR_VM_SIGNAL_COUNT];
+volatile std::sig_atomic_t sg_hasPendingSignals = 0;
+/// the interrupt flag of the thread that owns the exec env, signal handlers
+/// may run on any thread so they must not go through EG()
+zend_bool *volatile sg_vmInterruptFlag = nullptr;
+/// the thread that ran startup_vm_interrupt, the only one signals reach
+std::thread::id sg_ownerThread;
+void (*sg_previousInterruptFunction)(zend_execute_data *executeData) = nullptr;
+
+inline bool is_valid_signo(int signo)
+{
+   return signo > 0 && signo < POLAR_VM_SIGNAL_COUNT;
+}
+
+void vm_signal_handler(int signo)
+{
+   int errnoSave = errno;
+   raise_vm_interrupt(signo);
+   errno = errnoSave;
+}
+
+void vm_interrupt_function(zend_execute_data *executeData)
+{
+   /// other ZTS threads get here for their own timeouts, the pending
+   /// signals belong to the owner thread and its handlers
+   if (sg_hasPendingSignals && is_vm_signal_thread()) {
+      dispatch_vm_signals();
+   }
+   if (sg_previousInterruptFunction) {
+      sg_previousInterruptFunction(executeData);
+   }
+}
+
+} // anonymous namespace
+
+bool startup_vm_interrupt()
+{
+   std::memset(sg_signalEntries, 0, sizeof(sg_signalEntries));
+   for (int i = 0; i < POLAR_VM_SIGNAL_COUNT; ++i) {
+      sg_pendingSignals[i] = 0;
+   }
+   sg_hasPendingSignals = 0;
+   sg_vmInterruptFlag = &EG(vm_interrupt);
+   sg_ownerThread = std::this_thread::get_id();
+   /// zend_startup resets the hook, so we must be called after it
+   sg_previousInterruptFunction = zend_interrupt_function;
+   zend_interrupt_function = vm_interrupt_function;
+   return true;
+}
+
+void deactivate_vm_interrupt()
+{
+   for (int i = 0; i < POLAR_VM_SIGNAL_COUNT; ++i) {
+      sg_pendingSignals[i] = 0;
+   }
+   sg_hasPendingSignals = 0;
+}
+
+void shutdown_vm_interrupt()
+{
+   for (int signo = 1; signo < POLAR_VM_SIGNAL_COUNT; ++signo) {
+      remove_vm_signal_handler(signo);
+   }
+   if (zend_interrupt_function == vm_interrupt_function) {
+      zend_interrupt_function = sg_previousInterruptFunction;
+   }
+   sg_previousInterruptFunction = nullptr;
+   sg_vmInterruptFlag = nullptr;
+   sg_ownerThread = std::thread::id();
+}
+
+bool is_vm_signal_thread()
+{
+   return std::this_thread::get_id() == sg_ownerThread;
+}
+
+bool add_vm_signal_handler(int signo, VmSignalHandler handler, void *arg)
+{
+   if (!is_valid_signo(signo) || !handler || !is_vm_signal_thread()) {
+      return false;
+   }
+   VmSignalEntry &entry = sg_signalEntries[signo];
+   if (!entry.installed) {
+      struct sigaction action;
+      std::memset(&action, 0, sizeof(action));
+      action.sa_handler = vm_signal_handler;
+      action.sa_flags = SA_RESTART;
+      sigfillset(&action.sa_mask);
+      if (sigaction(signo, &action, &entry.previous) != 0) {
+         return false;
+      }
+      entry.installed = true;
+   }
+   entry.handler = handler;
+   entry.arg = arg;
+   return true;
+}
+
+bool remove_vm_signal_handler(int signo)
+{
+   if (!is_valid_signo(signo) || !is_vm_signal_thread()) {
+      return false;
+   }
+   VmSignalEntry &entry = sg_signalEntries[signo];
+   if (!entry.installed) {
+      return false;
+   }
+   sigaction(signo, &entry.previous, nullptr);
+   entry.installed = false;
+   entry.handler = nullptr;
+   entry.arg = nullptr;
+   sg_pendingSignals[signo] = 0;
+   return true;
+}
+
+void raise_vm_interrupt(int signo)
+{
+   if (is_valid_signo(signo)) {
+      sg_pendingSignals[signo] = 1;
+      sg_hasPendingSignals = 1;
+   }
+   zend_bool *flag = sg_vmInterruptFlag;
+   if (flag) {
+      *flag = 1;
+   }
+}
+
+bool dispatch_vm_signals()
+{
+   bool dispatched = false;
+   if (!is_vm_signal_thread()) {
+      return false;
+   }
+   sg_hasPendingSignals = 0;
+   for (int signo = 1; signo < POLAR_VM_SIGNAL_COUNT; ++signo) {
+      if (!sg_pendingSignals[signo]) {
+         continue;
+      }
+      sg_pendingSignals[signo] = 0;
+      VmSignalEntry &entry = sg_signalEntries[signo];
+      if (entry.handler) {
+         entry.handler(signo, entry.arg);
+         dispatched = true;
+      }
+      /// the handler threw, leave the rest pending for the next check
+      if (EG(exception)) {
+         for (int i = signo + 1; i < POLAR_VM_SIGNAL_COUNT; ++i) {
+            if (sg_pendingSignals[i]) {
+               raise_vm_interrupt(i);
+               break;
+            }
+         }
+         break;
+      }
+   }
+   return dispatched;
+}
+
+#ifdef POLAR_OS_LINUX
+int open_vm_signalfd(const sigset_t &mask)
+{
+   if (pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) {
+      return -1;
+   }
+   return signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+}
+
+bool drain_vm_signalfd(int fd)
+{
+   bool received = false;
+   struct signalfd_siginfo info;
+   while (true) {
+      ssize_t bytes = ::read(fd, &info, sizeof(info));
+      if (bytes != static_cast<ssize_t>(sizeof(info))) {
+         if (bytes < 0 && errno == EINTR) {
+            continue;
+         }
+         break;
+      }
+      raise_vm_interrupt(static_cast<int>(info.ssi_signo));
+      received = true;
+   }
+   return received;
+}
+#endif
+
+} // runtime
+} // polar
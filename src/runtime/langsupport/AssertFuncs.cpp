@@ -27,7 +27,9 @@ struct AssertModuleData
    zend_bool exception;
 };
 
-#define ASSERTG(v) sg_assertModuleData.v
+using zend_assert_globals = AssertModuleData;
+
+#define ASSERTG(v) ZEND_STATIC_MODULE_GLOBALS_ACCESSOR(assert, v)
 
 #define SAFE_STRING(s) ((s)?(s):"")
 
@@ -40,10 +42,16 @@ enum {
    ASSERT_EXCEPTION
 };
 
-thread_local AssertModuleData sg_assertModuleData;
+ZEND_DECLARE_STATIC_MODULE_GLOBALS(assert)
 static zend_class_entry *sg_assertionErrorCe;
 
 namespace {
+void assert_init_globals(zend_assert_globals *G)
+{
+   memset(G, 0, sizeof(*G));
+   ZVAL_UNDEF(&G->callback);
+}
+
 POLAR_INI_MH(assert_cfg_change_handler) /* {{{ */
 {
    if (EG(current_execute_data)) {
@@ -70,12 +78,12 @@ POLAR_INI_MH(assert_cfg_change_handler) /* {{{ */
 }
 
 POLAR_INI_BEGIN()
-   POLAR_STD_INI_ENTRY("assert.active",     "1", POLAR_INI_ALL, update_bool_handler, active,    AssertModuleData, sg_assertModuleData)
-   POLAR_STD_INI_ENTRY("assert.bail",       "0", POLAR_INI_ALL, update_bool_handler, bail,      AssertModuleData, sg_assertModuleData)
-   POLAR_STD_INI_ENTRY("assert.warning",    "1", POLAR_INI_ALL, update_bool_handler, warning,   AssertModuleData, sg_assertModuleData)
+   POLAR_STD_INI_ENTRY("assert.active",     "1", POLAR_INI_ALL, update_bool_handler, active,    AssertModuleData, assert_globals_static)
+   POLAR_STD_INI_ENTRY("assert.bail",       "0", POLAR_INI_ALL, update_bool_handler, bail,      AssertModuleData, assert_globals_static)
+   POLAR_STD_INI_ENTRY("assert.warning",    "1", POLAR_INI_ALL, update_bool_handler, warning,   AssertModuleData, assert_globals_static)
    POLAR_INI_ENTRY("assert.callback",       "",  POLAR_INI_ALL, assert_cfg_change_handler)
-   POLAR_STD_INI_ENTRY("assert.quiet_eval", "0", POLAR_INI_ALL, update_bool_handler, quietEval,  AssertModuleData, sg_assertModuleData)
-   POLAR_STD_INI_ENTRY("assert.exception",  "0", POLAR_INI_ALL, update_bool_handler, exception,  AssertModuleData, sg_assertModuleData)
+   POLAR_STD_INI_ENTRY("assert.quiet_eval", "0", POLAR_INI_ALL, update_bool_handler, quietEval,  AssertModuleData, assert_globals_static)
+   POLAR_STD_INI_ENTRY("assert.exception",  "0", POLAR_INI_ALL, update_bool_handler, exception,  AssertModuleData, assert_globals_static)
 POLAR_INI_END()
 
 } // anonymous namespace
@@ -83,8 +91,7 @@ POLAR_INI_END()
 PHP_MINIT_FUNCTION(assert)
 {
    zend_class_entry ce;
-   ZVAL_UNDEF(&sg_assertModuleData.callback);
-   sg_assertModuleData.cb = nullptr;
+   ZEND_INIT_STATIC_MODULE_GLOBALS(assert, assert_init_globals, nullptr);
    REGISTER_INI_ENTRIES();
    REGISTER_LONG_CONSTANT("ASSERT_ACTIVE", ASSERT_ACTIVE, CONST_CS|CONST_PERSISTENT);
    REGISTER_LONG_CONSTANT("ASSERT_CALLBACK", ASSERT_CALLBACK, CONST_CS|CONST_PERSISTENT);
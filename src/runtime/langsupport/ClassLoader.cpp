@@ -13,6 +13,8 @@
 #include "polarphp/runtime/langsupport/StdExceptions.h"
 #include "polarphp/runtime/Spprintf.h"
 #include "polarphp/runtime/Utils.h"
+#include "polarphp/runtime/IncludePrefetch.h"
+#include "polarphp/runtime/internal/CompiledZpp.h"
 
 namespace polar {
 namespace runtime {
@@ -22,17 +24,18 @@ static zend_function *sg_autoloadCallFunc = nullptr;
 
 #define CLASS_LOADER_DEFAULT_FILE_EXTENSIONS const_cast<char *>(".inc,.php")
 
+ZEND_DECLARE_STATIC_MODULE_GLOBALS(classloader)
+
+namespace {
+void classloader_init_globals(zend_classloader_globals *G)
+{
+   memset(G, 0, sizeof(*G));
+}
+} // anonymous namespace
+
 ClassLoaderModuleData &retrieve_classloader_module_data()
 {
-   thread_local ClassLoaderModuleData classLoaderModuleData{
-      false,
-      false,
-      0,
-      0,
-      nullptr,
-            nullptr
-   };
-   return classLoaderModuleData;
+   return *ZEND_STATIC_MODULE_GLOBALS_BULK(classloader);
 }
 
 struct AutoloadFuncInfo
@@ -185,7 +188,7 @@ zend_string *php_object_hash(zval *obj) /* {{{*/
 PHP_FUNCTION(object_hash)
 {
    zval *obj;
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "o", &obj) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("o", &obj) == FAILURE) {
       return;
    }
    RETURN_NEW_STR(php_object_hash(obj));
@@ -200,6 +203,29 @@ PHP_FUNCTION(object_id)
    RETURN_LONG((zend_long)Z_OBJ_HANDLE_P(obj));
 }
 
+///
+/// proto int prefetch_include_files(array files)
+/// Read the given files ahead in one batch, values are paths so a class map
+/// can be passed as is, returns the number of files submitted
+///
+PHP_FUNCTION(prefetch_include_files)
+{
+   HashTable *files;
+   zval *entry;
+   if (POLAR_PARSE_PARAMETERS("h", &files) == FAILURE) {
+      return;
+   }
+   std::vector<std::string> paths;
+   paths.reserve(zend_hash_num_elements(files));
+   ZEND_HASH_FOREACH_VAL(files, entry) {
+      ZVAL_DEREF(entry);
+      if (Z_TYPE_P(entry) == IS_STRING) {
+         paths.emplace_back(Z_STRVAL_P(entry), Z_STRLEN_P(entry));
+      }
+   } ZEND_HASH_FOREACH_END();
+   RETURN_LONG(static_cast<zend_long>(prefetch_include_files(paths)));
+}
+
 ///
 /// proto array class_parents(object instance [, bool autoload = true])
 /// Return an array containing the names of all parent classes
@@ -210,7 +236,7 @@ PHP_FUNCTION(class_parents)
    zval *obj;
    zend_class_entry *parent_class, *ce;
    zend_bool autoload = 1;
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z|b", &obj, &autoload) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("z|b", &obj, &autoload) == FAILURE) {
       RETURN_FALSE;
    }
    if (Z_TYPE_P(obj) != IS_OBJECT && Z_TYPE_P(obj) != IS_STRING) {
@@ -238,7 +264,7 @@ PHP_FUNCTION(class_implements)
    zend_bool autoload = 1;
    zend_class_entry *ce;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z|b", &obj, &autoload) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("z|b", &obj, &autoload) == FAILURE) {
       RETURN_FALSE;
    }
    if (Z_TYPE_P(obj) != IS_OBJECT && Z_TYPE_P(obj) != IS_STRING) {
@@ -263,7 +289,7 @@ PHP_FUNCTION(class_uses)
    zend_bool autoload = 1;
    zend_class_entry *ce;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z|b", &obj, &autoload) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("z|b", &obj, &autoload) == FAILURE) {
       RETURN_FALSE;
    }
    if (Z_TYPE_P(obj) != IS_OBJECT && Z_TYPE_P(obj) != IS_STRING) {
@@ -286,7 +312,7 @@ PHP_FUNCTION(class_uses)
 PHP_FUNCTION(set_autoload_file_extensions)
 {
    zend_string *file_exts = nullptr;
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "|S", &file_exts) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("|S", &file_exts) == FAILURE) {
       return;
    }
    if (file_exts) {
@@ -371,7 +397,7 @@ PHP_FUNCTION(default_class_loader)
    char *pos, *pos1;
    zend_string *className, *lc_name, *file_exts = CLASS_LOADER_G(autoloadExtensions);
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|S", &className, &file_exts) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S|S", &className, &file_exts) == FAILURE) {
       RETURN_FALSE;
    }
 
@@ -411,7 +437,7 @@ PHP_FUNCTION(load_class)
    zend_string *lc_name, *func_name;
    AutoloadFuncInfo *alfi;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &className) == FAILURE || Z_TYPE_P(className) != IS_STRING) {
+   if (POLAR_PARSE_PARAMETERS("z", &className) == FAILURE || Z_TYPE_P(className) != IS_STRING) {
       return;
    }
 
@@ -523,7 +549,7 @@ PHP_FUNCTION(register_class_loader)
    zend_object *obj_ptr;
    zend_fcall_info_cache fcc;
 
-   if (zend_parse_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), "|zbb", &zcallable, &do_throw, &prepend) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS_EX(ZEND_PARSE_PARAMS_QUIET, "|zbb", &zcallable, &do_throw, &prepend) == FAILURE) {
       return;
    }
 
@@ -693,7 +719,7 @@ PHP_FUNCTION(unregister_class_loader)
    zend_object *obj_ptr;
    zend_fcall_info_cache fcc;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &zcallable) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("z", &zcallable) == FAILURE) {
       return;
    }
 
@@ -766,6 +792,7 @@ PHP_FUNCTION(unregister_class_loader)
 
 PHP_MINIT_FUNCTION(classloader)
 {
+   ZEND_INIT_STATIC_MODULE_GLOBALS(classloader, classloader_init_globals, nullptr);
    sg_autoloadFunc = reinterpret_cast<zend_function *>(zend_hash_str_find_ptr(CG(function_table), "default_class_loader", sizeof("default_class_loader") - 1));
    sg_autoloadCallFunc = reinterpret_cast<zend_function *>(zend_hash_str_find_ptr(CG(function_table), "load_class", sizeof("load_class") - 1));
    ZEND_ASSERT(sg_autoloadFunc != nullptr && sg_autoloadCallFunc != nullptr);
@@ -18,6 +18,7 @@
 #include "polarphp/runtime/langsupport/StdExceptions.h"
 #include "polarphp/runtime/langsupport/ClassLoader.h"
 #include "polarphp/runtime/langsupport/SerializeFuncs.h"
+#include "polarphp/runtime/langsupport/SignalFuncs.h"
 
 namespace polar {
 namespace runtime {
@@ -170,6 +171,12 @@ static const zend_function_entry sg_langSupportFunctions[] = {
    PHP_FE(class_uses,                                       arginfo_class_uses)
    PHP_FE(object_hash,                                      arginfo_object_hash)
    PHP_FE(object_id,                                        arginfo_object_id)
+   PHP_FE(prefetch_include_files,                           arginfo_prefetch_include_files)
+
+   /// signal
+   PHP_FE(register_signal_handler,                          arginfo_register_signal_handler)
+   PHP_FE(unregister_signal_handler,                        arginfo_unregister_signal_handler)
+   PHP_FE(dispatch_signals,                                 arginfo_dispatch_signals)
    ZEND_FE_END
 };
 
@@ -238,6 +245,7 @@ PHP_MINIT_FUNCTION(Runtime)
    RUNTIME_MINIT_SUBMODULE(assert);
    RUNTIME_MINIT_SUBMODULE(stdexceptions);
    RUNTIME_MINIT_SUBMODULE(classloader);
+   RUNTIME_MINIT_SUBMODULE(signal);
    return SUCCESS;
 }
 
@@ -270,6 +278,7 @@ PHP_RSHUTDOWN_FUNCTION(Runtime)
    }
    RUNTIME_RSHUTDOWN_SUBMODULE(classloader);
    RUNTIME_RSHUTDOWN_SUBMODULE(assert);
+   RUNTIME_RSHUTDOWN_SUBMODULE(signal);
    return SUCCESS;
 }
 
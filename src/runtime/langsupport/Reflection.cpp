@@ -10,7 +10,10 @@
 // Created by polarboy on 2019/02/11.
 
 #include "polarphp/runtime/langsupport/Reflection.h"
+#include "polarphp/runtime/ExecEnv.h"
 #include "polarphp/runtime/Spprintf.h"
+#include "polarphp/markup/DocComment.h"
+#include "polarphp/runtime/internal/CompiledZpp.h"
 
 #include <cstdarg>
 
@@ -125,6 +128,21 @@ struct reflection_object
 
 static zend_object_handlers sg_reflectionObjectHandlers;
 
+using polar::basic::StringRef;
+using polar::markup::AnnotationField;
+using polar::markup::DocCommentCache;
+using polar::markup::Document;
+using polar::markup::MarkupAstNode;
+
+/// doc comments held by permanent strings outlive every request and are
+/// shared by all threads, the others die with the request that compiled
+/// them, so their parses are dropped at request shutdown, except in a
+/// worker, which compiles the same scripts request after request and
+/// keeps them until there are more than MAX_REQUEST_DOC_COMMENTS
+static DocCommentCache sg_persistentDocComments;
+thread_local DocCommentCache sg_requestDocComments;
+constexpr unsigned MAX_REQUEST_DOC_COMMENTS = 4096;
+
 namespace {
 inline reflection_object *reflection_object_from_obj(zend_object *obj)
 {
@@ -948,18 +966,18 @@ void reflection_export(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce_ptr, i
    zval *argument_ptr, *argument2_ptr;
    zval retval, params[2];
    int result;
-   int return_output = 0;
+   zend_bool return_output = 0;
    zend_fcall_info fci;
    zend_fcall_info_cache fcc;
 
    if (ctor_argc == 1) {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "z|b", &argument_ptr, &return_output) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("z|b", &argument_ptr, &return_output) == FAILURE) {
          return;
       }
       ZVAL_COPY_VALUE(&params[0], argument_ptr);
       ZVAL_NULL(&params[1]);
    } else {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "zz|b", &argument_ptr, &argument2_ptr, &return_output) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("zz|b", &argument_ptr, &argument2_ptr, &return_output) == FAILURE) {
          return;
       }
       ZVAL_COPY_VALUE(&params[0], argument_ptr);
@@ -1133,7 +1151,7 @@ ZEND_METHOD(reflection, getModifierNames)
 {
    zend_long modifiers;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &modifiers) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("l", &modifiers) == FAILURE) {
       return;
    }
 
@@ -1388,6 +1406,39 @@ ZEND_METHOD(reflection_function, getEndLine)
    RETURN_FALSE;
 }
 
+namespace {
+/// the tags of a doc comment as a list of ['name' => ..., 'value' => ...]
+/// arrays, the comment is parsed once and the parse is shared by every
+/// reflector that asks for it
+void doc_comment_tags(zend_string *comment, zval *return_value)
+{
+   array_init(return_value);
+   if (!comment) {
+      return;
+   }
+   DocCommentCache &cache = (GC_FLAGS(comment) & IS_STR_PERMANENT)
+         ? sg_persistentDocComments
+         : sg_requestDocComments;
+   const Document *document = cache.get(StringRef(ZSTR_VAL(comment), ZSTR_LEN(comment)));
+   if (!document) {
+      return;
+   }
+   for (const MarkupAstNode *node : document->getChildren()) {
+      const AnnotationField *annotation = polar::utils::dyn_cast<AnnotationField>(node);
+      if (!annotation) {
+         continue;
+      }
+      zval tag;
+      array_init_size(&tag, 2);
+      add_assoc_stringl_ex(&tag, "name", sizeof("name") - 1,
+                           annotation->getName().data(), annotation->getName().size());
+      add_assoc_stringl_ex(&tag, "value", sizeof("value") - 1,
+                           annotation->getValue().data(), annotation->getValue().size());
+      add_next_index_zval(return_value, &tag);
+   }
+}
+} // anonymous namespace
+
 ZEND_METHOD(reflection_function, getDocComment)
 {
    reflection_object *intern;
@@ -1403,6 +1454,19 @@ ZEND_METHOD(reflection_function, getDocComment)
    RETURN_FALSE;
 }
 
+ZEND_METHOD(reflection_function, getDocCommentTags)
+{
+   reflection_object *intern;
+   zend_function *fptr;
+
+   if (zend_parse_parameters_none() == FAILURE) {
+      return;
+   }
+   GET_REFLECTION_OBJECT_PTR(fptr, zend_function *);
+   doc_comment_tags(fptr->type == ZEND_USER_FUNCTION ? fptr->op_array.doc_comment : nullptr,
+                    return_value);
+}
+
 ZEND_METHOD(reflection_function, getStaticVariables)
 {
    reflection_object *intern;
@@ -1497,7 +1561,7 @@ ZEND_METHOD(reflection_function, invokeArgs)
 
    GET_REFLECTION_OBJECT_PTR(fptr, zend_function *);
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &param_array) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("a", &param_array) == FAILURE) {
       return;
    }
 
@@ -1648,7 +1712,7 @@ ZEND_METHOD(reflection_generator, getTrace)
    zend_execute_data *ex = generator->execute_data;
    zend_execute_data *root_prev = nullptr, *cur_prev;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l", &options) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("|l", &options) == FAILURE) {
       return;
    }
 
@@ -2379,7 +2443,7 @@ ZEND_METHOD(reflection_method, __construct)
    size_t name_len, tmp_len;
    zval ztmp;
 
-   if (zend_parse_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), "zs", &classname, &name_str, &name_len) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS_EX(ZEND_PARSE_PARAMS_QUIET, "zs", &classname, &name_str, &name_len) == FAILURE) {
       if (zend_parse_parameters_throw(ZEND_NUM_ARGS(), "s", &name_str, &name_len) == FAILURE) {
          return;
       }
@@ -2484,7 +2548,7 @@ ZEND_METHOD(reflection_method, getClosure)
    if (mptr->common.fn_flags & ZEND_ACC_STATIC)  {
       zend_create_fake_closure(return_value, mptr, mptr->common.scope, mptr->common.scope, nullptr);
    } else {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "o", &obj) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("o", &obj) == FAILURE) {
          return;
       }
 
@@ -2540,7 +2604,7 @@ void reflection_method_invoke(INTERNAL_FUNCTION_PARAMETERS, int variadic)
          return;
       }
    } else {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "o!a", &object, &param_array) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("o!a", &object, &param_array) == FAILURE) {
          return;
       }
 
@@ -2839,7 +2903,7 @@ ZEND_METHOD(reflection_method, setAccessible)
 {
    reflection_object *intern;
    zend_bool visible;
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "b", &visible) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("b", &visible) == FAILURE) {
       return;
    }
    intern = Z_REFLECTION_P(getThis());
@@ -3004,6 +3068,17 @@ ZEND_METHOD(reflection_class_constant, getDocComment)
    RETURN_FALSE;
 }
 
+ZEND_METHOD(reflection_class_constant, getDocCommentTags)
+{
+   reflection_object *intern;
+   zend_class_constant *ref;
+   if (zend_parse_parameters_none() == FAILURE) {
+      return;
+   }
+   GET_REFLECTION_OBJECT_PTR(ref, zend_class_constant *);
+   doc_comment_tags(ref->doc_comment, return_value);
+}
+
 ZEND_METHOD(reflection_class, export)
 {
    reflection_export(INTERNAL_FUNCTION_PARAM_PASSTHRU, g_reflectionClassPtr, 1);
@@ -3019,11 +3094,11 @@ void reflection_class_object_ctor(INTERNAL_FUNCTION_PARAMETERS, int is_object)
    zend_class_entry *ce;
 
    if (is_object) {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "o", &argument) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("o", &argument) == FAILURE) {
          return;
       }
    } else {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &argument) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("z", &argument) == FAILURE) {
          return;
       }
    }
@@ -3131,7 +3206,7 @@ ZEND_METHOD(reflection_class, getStaticPropertyValue)
    zend_string *name;
    zval *prop, *def_value = nullptr;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|z", &name, &def_value) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S|z", &name, &def_value) == FAILURE) {
       return;
    }
 
@@ -3161,7 +3236,7 @@ ZEND_METHOD(reflection_class, setStaticPropertyValue)
    zend_string *name;
    zval *variable_ptr, *value;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "Sz", &name, &value) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("Sz", &name, &value) == FAILURE) {
       return;
    }
 
@@ -3316,6 +3391,19 @@ ZEND_METHOD(reflection_class, getDocComment)
    RETURN_FALSE;
 }
 
+ZEND_METHOD(reflection_class, getDocCommentTags)
+{
+   reflection_object *intern;
+   zend_class_entry *ce;
+
+   if (zend_parse_parameters_none() == FAILURE) {
+      return;
+   }
+   GET_REFLECTION_OBJECT_PTR(ce, zend_class_entry *);
+   doc_comment_tags(ce->type == ZEND_USER_CLASS ? ce->info.user.doc_comment : nullptr,
+                    return_value);
+}
+
 ZEND_METHOD(reflection_class, getConstructor)
 {
    reflection_object *intern;
@@ -3340,7 +3428,7 @@ ZEND_METHOD(reflection_class, hasMethod)
    char *name, *lc_name;
    size_t name_len;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &name, &name_len) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("s", &name, &name_len) == FAILURE) {
       return;
    }
 
@@ -3366,7 +3454,7 @@ ZEND_METHOD(reflection_class, getMethod)
    char *name, *lc_name;
    size_t name_len;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &name, &name_len) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("s", &name, &name_len) == FAILURE) {
       return;
    }
 
@@ -3440,7 +3528,7 @@ ZEND_METHOD(reflection_class, getMethods)
    zend_class_entry *ce;
    zend_long filter = ZEND_ACC_PPP_MASK | ZEND_ACC_ABSTRACT | ZEND_ACC_FINAL | ZEND_ACC_STATIC;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l", &filter) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("|l", &filter) == FAILURE) {
       return;
    }
 
@@ -3465,7 +3553,7 @@ ZEND_METHOD(reflection_class, hasProperty)
    zend_string *name;
    zval property;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &name) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S", &name) == FAILURE) {
       return;
    }
 
@@ -3497,7 +3585,7 @@ ZEND_METHOD(reflection_class, getProperty)
    char *tmp, *str_name;
    size_t classname_len, str_name_len;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &name) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S", &name) == FAILURE) {
       return;
    }
 
@@ -3613,7 +3701,7 @@ ZEND_METHOD(reflection_class, getProperties)
    zend_class_entry *ce;
    zend_long filter = ZEND_ACC_PPP_MASK | ZEND_ACC_STATIC;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l", &filter) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("|l", &filter) == FAILURE) {
       return;
    }
 
@@ -3634,7 +3722,7 @@ ZEND_METHOD(reflection_class, hasConstant)
    zend_class_entry *ce;
    zend_string *name;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &name) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S", &name) == FAILURE) {
       return;
    }
 
@@ -3695,7 +3783,7 @@ ZEND_METHOD(reflection_class, getConstant)
    zend_class_constant *c;
    zend_string *name;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &name) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S", &name) == FAILURE) {
       return;
    }
 
@@ -3718,7 +3806,7 @@ ZEND_METHOD(reflection_class, getReflectionConstant)
    zend_class_constant *constant;
    zend_string *name;
    GET_REFLECTION_OBJECT_PTR(ce, zend_class_entry *);
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &name) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("S", &name) == FAILURE) {
       return;
    }
    if ((constant = reinterpret_cast<zend_class_constant *>(zend_hash_find_ptr(&ce->constants_table, name))) == nullptr) {
@@ -3830,7 +3918,7 @@ ZEND_METHOD(reflection_class, isInstance)
    reflection_object *intern;
    zend_class_entry *ce;
    zval *object;
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "o", &object) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("o", &object) == FAILURE) {
       return;
    }
    GET_REFLECTION_OBJECT_PTR(ce, zend_class_entry *);
@@ -3920,7 +4008,7 @@ ZEND_METHOD(reflection_class, newInstanceArgs)
 
    GET_REFLECTION_OBJECT_PTR(ce, zend_class_entry *);
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "|h", &args) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("|h", &args) == FAILURE) {
       return;
    }
 
@@ -4133,7 +4221,7 @@ ZEND_METHOD(reflection_class, isSubclassOf)
 
    GET_REFLECTION_OBJECT_PTR(ce, zend_class_entry *);
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &class_name) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("z", &class_name) == FAILURE) {
       return;
    }
 
@@ -4174,7 +4262,7 @@ ZEND_METHOD(reflection_class, implementsInterface)
 
    GET_REFLECTION_OBJECT_PTR(ce, zend_class_entry *);
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &interface) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("z", &interface) == FAILURE) {
       return;
    }
 
@@ -4499,7 +4587,7 @@ ZEND_METHOD(reflection_property, getValue)
    } else {
       zval rv;
 
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "o", &object) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("o", &object) == FAILURE) {
          return;
       }
 
@@ -4538,15 +4626,15 @@ ZEND_METHOD(reflection_property, setValue)
    }
 
    if (ref->prop.flags & ZEND_ACC_STATIC) {
-      if (zend_parse_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), "z", &value) == FAILURE) {
-         if (zend_parse_parameters(ZEND_NUM_ARGS(), "zz", &tmp, &value) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS_EX(ZEND_PARSE_PARAMS_QUIET, "z", &value) == FAILURE) {
+         if (POLAR_PARSE_PARAMETERS("zz", &tmp, &value) == FAILURE) {
             return;
          }
       }
 
       zend_update_static_property_ex(ref->ce, ref->unmangledName, value);
    } else {
-      if (zend_parse_parameters(ZEND_NUM_ARGS(), "oz", &object, &value) == FAILURE) {
+      if (POLAR_PARSE_PARAMETERS("oz", &object, &value) == FAILURE) {
          return;
       }
 
@@ -4598,12 +4686,24 @@ ZEND_METHOD(reflection_property, getDocComment)
    RETURN_FALSE;
 }
 
+ZEND_METHOD(reflection_property, getDocCommentTags)
+{
+   reflection_object *intern;
+   property_reference *ref;
+
+   if (zend_parse_parameters_none() == FAILURE) {
+      return;
+   }
+   GET_REFLECTION_OBJECT_PTR(ref, property_reference *);
+   doc_comment_tags(ref->prop.doc_comment, return_value);
+}
+
 ZEND_METHOD(reflection_property, setAccessible)
 {
    reflection_object *intern;
    zend_bool visible;
 
-   if (zend_parse_parameters(ZEND_NUM_ARGS(), "b", &visible) == FAILURE) {
+   if (POLAR_PARSE_PARAMETERS("b", &visible) == FAILURE) {
       return;
    }
 
@@ -4671,6 +4771,7 @@ static const zend_function_entry sg_reflectionFunctionAbstractFunctions[] = {
    ZEND_ME(reflection_function, getClosureThis, arginfo_reflection__void, 0)
    ZEND_ME(reflection_function, getClosureScopeClass, arginfo_reflection__void, 0)
    ZEND_ME(reflection_function, getDocComment, arginfo_reflection__void, 0)
+   ZEND_ME(reflection_function, getDocCommentTags, arginfo_reflection__void, 0)
    ZEND_ME(reflection_function, getEndLine, arginfo_reflection__void, 0)
    ZEND_ME(reflection_function, getFileName, arginfo_reflection__void, 0)
    ZEND_ME(reflection_function, getName, arginfo_reflection__void, 0)
@@ -4857,6 +4958,7 @@ static const zend_function_entry sg_reflectionClassFunctions[] = {
    ZEND_ME(reflection_class, getStartLine, arginfo_reflection__void, 0)
    ZEND_ME(reflection_class, getEndLine, arginfo_reflection__void, 0)
    ZEND_ME(reflection_class, getDocComment, arginfo_reflection__void, 0)
+   ZEND_ME(reflection_class, getDocCommentTags, arginfo_reflection__void, 0)
    ZEND_ME(reflection_class, getConstructor, arginfo_reflection__void, 0)
    ZEND_ME(reflection_class, hasMethod, arginfo_reflection_class_hasMethod, 0)
    ZEND_ME(reflection_class, getMethod, arginfo_reflection_class_getMethod, 0)
@@ -4953,6 +5055,7 @@ static const zend_function_entry sg_reflectionPropertyFunctions[] = {
    ZEND_ME(reflection_property, getModifiers, arginfo_reflection__void, 0)
    ZEND_ME(reflection_property, getDeclaringClass, arginfo_reflection__void, 0)
    ZEND_ME(reflection_property, getDocComment, arginfo_reflection__void, 0)
+   ZEND_ME(reflection_property, getDocCommentTags, arginfo_reflection__void, 0)
    ZEND_ME(reflection_property, setAccessible, arginfo_reflection_property_setAccessible, 0)
    PHP_FE_END
 };
@@ -4981,6 +5084,7 @@ static const zend_function_entry sg_reflectionClassConstantFunctions[] = {
    ZEND_ME(reflection_class_constant, getModifiers, arginfo_reflection__void, 0)
    ZEND_ME(reflection_class_constant, getDeclaringClass, arginfo_reflection__void, 0)
    ZEND_ME(reflection_class_constant, getDocComment, arginfo_reflection__void, 0)
+   ZEND_ME(reflection_class_constant, getDocCommentTags, arginfo_reflection__void, 0)
    PHP_FE_END
 };
 
@@ -5158,6 +5262,15 @@ PHP_MINIT_FUNCTION(reflection)
    return SUCCESS;
 }
 
+PHP_RSHUTDOWN_FUNCTION(reflection)
+{
+   if (!retrieve_global_execenv().isWorkerMode() ||
+       sg_requestDocComments.getNumEntries() > MAX_REQUEST_DOC_COMMENTS) {
+      sg_requestDocComments.clear();
+   }
+   return SUCCESS;
+}
+
 zend_module_entry g_reflectionModuleEntry = {
    STANDARD_MODULE_HEADER,
    "Reflection",
@@ -5165,12 +5278,17 @@ zend_module_entry g_reflectionModuleEntry = {
    PHP_MINIT(reflection),
    nullptr,
    nullptr,
-   nullptr,
+   PHP_RSHUTDOWN(reflection),
    nullptr,
    PHP_REFLECTION_VERSION,
    STANDARD_MODULE_PROPERTIES
 };
 
+const DocCommentCache &retrieve_request_doc_comments()
+{
+   return sg_requestDocComments;
+}
+
 bool register_reflection_module()
 {
    g_reflectionModuleEntry.type = MODULE_PERSISTENT;
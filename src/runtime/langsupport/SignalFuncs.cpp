@@ -0,0 +1,157 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/06.
+
+#include "polarphp/runtime/langsupport/SignalFuncs.h"
+#include "polarphp/runtime/VmInterrupt.h"
+
+#include <csignal>
+
+namespace polar {
+namespace runtime {
+
+struct SignalModuleData
+{
+   /// signo => user callable
+   HashTable *handlers = nullptr;
+};
+
+#define SIGNAL_G(v) sg_signalModuleData.v
+
+thread_local SignalModuleData sg_signalModuleData;
+
+namespace {
+void dispatch_user_signal_handler(int signo, void *)
+{
+   if (!SIGNAL_G(handlers)) {
+      return;
+   }
+   zval *handler = zend_hash_index_find(SIGNAL_G(handlers), signo);
+   if (!handler) {
+      return;
+   }
+   zval retval;
+   zval param;
+   zval callable;
+   /// the handler may unregister itself while running
+   ZVAL_COPY(&callable, handler);
+   ZVAL_LONG(&param, signo);
+   if (call_user_function(EG(function_table), nullptr, &callable, &retval, 1, &param) == SUCCESS) {
+      zval_ptr_dtor(&retval);
+   }
+   zval_ptr_dtor(&callable);
+}
+} // anonymous namespace
+
+#define REGISTER_SIGNAL_CONSTANT(name) \
+   REGISTER_LONG_CONSTANT(#name, name, CONST_CS | CONST_PERSISTENT)
+
+PHP_MINIT_FUNCTION(signal)
+{
+#ifdef SIGHUP
+   REGISTER_SIGNAL_CONSTANT(SIGHUP);
+#endif
+   REGISTER_SIGNAL_CONSTANT(SIGINT);
+#ifdef SIGQUIT
+   REGISTER_SIGNAL_CONSTANT(SIGQUIT);
+#endif
+#ifdef SIGUSR1
+   REGISTER_SIGNAL_CONSTANT(SIGUSR1);
+#endif
+#ifdef SIGUSR2
+   REGISTER_SIGNAL_CONSTANT(SIGUSR2);
+#endif
+#ifdef SIGPIPE
+   REGISTER_SIGNAL_CONSTANT(SIGPIPE);
+#endif
+#ifdef SIGALRM
+   REGISTER_SIGNAL_CONSTANT(SIGALRM);
+#endif
+   REGISTER_SIGNAL_CONSTANT(SIGTERM);
+#ifdef SIGCHLD
+   REGISTER_SIGNAL_CONSTANT(SIGCHLD);
+#endif
+#ifdef SIGWINCH
+   REGISTER_SIGNAL_CONSTANT(SIGWINCH);
+#endif
+   return SUCCESS;
+}
+
+#undef REGISTER_SIGNAL_CONSTANT
+
+PHP_RSHUTDOWN_FUNCTION(signal)
+{
+   if (SIGNAL_G(handlers)) {
+      zend_ulong signo;
+      ZEND_HASH_FOREACH_NUM_KEY(SIGNAL_G(handlers), signo) {
+         remove_vm_signal_handler(static_cast<int>(signo));
+      } ZEND_HASH_FOREACH_END();
+      zend_hash_destroy(SIGNAL_G(handlers));
+      FREE_HASHTABLE(SIGNAL_G(handlers));
+      SIGNAL_G(handlers) = nullptr;
+   }
+   return SUCCESS;
+}
+
+PHP_FUNCTION(register_signal_handler)
+{
+   zend_long signo;
+   zval *handler;
+   ZEND_PARSE_PARAMETERS_START(2, 2)
+         Z_PARAM_LONG(signo)
+         Z_PARAM_ZVAL(handler)
+         ZEND_PARSE_PARAMETERS_END();
+   if (!zend_is_callable(handler, 0, nullptr)) {
+      php_error_docref(nullptr, E_WARNING, "Argument 2 must be a valid callback");
+      RETURN_FALSE;
+   }
+   if (signo == SIGKILL || signo == SIGSTOP) {
+      php_error_docref(nullptr, E_WARNING, "Signal " ZEND_LONG_FMT " can not be handled", signo);
+      RETURN_FALSE;
+   }
+   if (!is_vm_signal_thread()) {
+      php_error_docref(nullptr, E_WARNING, "Signal handlers can only be registered on the main thread");
+      RETURN_FALSE;
+   }
+   if (!add_vm_signal_handler(static_cast<int>(signo), dispatch_user_signal_handler, nullptr)) {
+      php_error_docref(nullptr, E_WARNING, "Invalid signal " ZEND_LONG_FMT, signo);
+      RETURN_FALSE;
+   }
+   if (!SIGNAL_G(handlers)) {
+      ALLOC_HASHTABLE(SIGNAL_G(handlers));
+      zend_hash_init(SIGNAL_G(handlers), 8, nullptr, ZVAL_PTR_DTOR, 0);
+   }
+   Z_TRY_ADDREF_P(handler);
+   zend_hash_index_update(SIGNAL_G(handlers), signo, handler);
+   RETURN_TRUE;
+}
+
+PHP_FUNCTION(unregister_signal_handler)
+{
+   zend_long signo;
+   ZEND_PARSE_PARAMETERS_START(1, 1)
+         Z_PARAM_LONG(signo)
+         ZEND_PARSE_PARAMETERS_END();
+   if (!SIGNAL_G(handlers) || !zend_hash_index_exists(SIGNAL_G(handlers), signo)) {
+      RETURN_FALSE;
+   }
+   remove_vm_signal_handler(static_cast<int>(signo));
+   zend_hash_index_del(SIGNAL_G(handlers), signo);
+   RETURN_TRUE;
+}
+
+PHP_FUNCTION(dispatch_signals)
+{
+   ZEND_PARSE_PARAMETERS_NONE();
+   RETURN_BOOL(dispatch_vm_signals());
+}
+
+} // runtime
+} // polar
@@ -0,0 +1,453 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/serialization/ModuleSummary.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/basic/adt/StringMap.h"
+#include "polarphp/utils/BinaryByteStream.h"
+#include "polarphp/utils/BinaryStreamError.h"
+#include "polarphp/utils/BinaryStreamReader.h"
+#include "polarphp/utils/BinaryStreamWriter.h"
+#include "polarphp/utils/FastHash.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace polar::serialization {
+
+using polar::basic::SmallString;
+using polar::basic::StringMap;
+using polar::parser::ProjectDiagnosticKind;
+using polar::utils::AppendingBinaryByteStream;
+using polar::utils::BinaryByteStream;
+using polar::utils::BinaryStreamError;
+using polar::utils::BinaryStreamReader;
+using polar::utils::Endianness;
+using polar::utils::OptionalError;
+using polar::utils::RawFdOutStream;
+using polar::utils::StreamErrorCode;
+using polar::utils::consume_error;
+using polar::utils::error_code_to_error;
+using polar::utils::make_error;
+using namespace summary;
+
+namespace {
+
+/// class and function names are case insensitive in php, byte wise
+void fold_case(StringRef name, SmallString<128> &folded)
+{
+   folded.clear();
+   for (char c : name) {
+      folded.push_back(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+   }
+}
+
+uint64_t get_name_hash(StringRef name)
+{
+   SmallString<128> folded;
+   fold_case(name, folded);
+   return polar::utils::fast_hash64(folded.getStr());
+}
+
+bool is_class_like(IndexedDeclKind kind)
+{
+   return kind == IndexedDeclKind::Class || kind == IndexedDeclKind::Interface ||
+         kind == IndexedDeclKind::Trait;
+}
+
+bool is_same_decl_name(StringRef lhs, StringRef rhs, IndexedDeclKind kind)
+{
+   return kind == IndexedDeclKind::Constant ? lhs == rhs : lhs.equalsLower(rhs);
+}
+
+StringRef strip_leading_backslash(StringRef name)
+{
+   return name.startsWith("\\") ? name.dropFront(1) : name;
+}
+
+///
+/// the string table of a summary being written, every distinct string is
+/// stored once
+///
+class StringPool
+{
+public:
+   StringRecord intern(StringRef text)
+   {
+      StringRecord record;
+      record.offset = 0;
+      record.size = text.size();
+      if (text.empty()) {
+         return record;
+      }
+      auto inserted = m_offsets.insert({text, static_cast<uint32_t>(m_data.size())});
+      if (inserted.second) {
+         m_data.append(text.data(), text.size());
+      }
+      record.offset = inserted.first->getValue();
+      return record;
+   }
+
+   StringRef getData() const
+   {
+      return m_data;
+   }
+
+private:
+   StringMap<uint32_t> m_offsets;
+   std::string m_data;
+};
+
+template <typename T>
+void clear_reserved(T &record)
+{
+   std::memset(record.reserved, 0, sizeof(record.reserved));
+}
+
+Error make_format_error(StringRef context)
+{
+   return make_error<BinaryStreamError>(StreamErrorCode::unspecified, context);
+}
+
+} // anonymous namespace
+
+void ModuleSummaryWriter::addFile(StringRef path, uint64_t contentHash,
+                                  ArrayRef<IndexedDecl> decls,
+                                  ArrayRef<ProjectDiagnostic> diagnostics)
+{
+   m_files.push_back({path.getStr(), contentHash,
+                      std::vector<IndexedDecl>(decls.begin(), decls.end()),
+                      std::vector<ProjectDiagnostic>(diagnostics.begin(), diagnostics.end())});
+}
+
+Error ModuleSummaryWriter::write(BinaryStreamWriter &writer) const
+{
+   std::vector<unsigned> order(m_files.size());
+   std::iota(order.begin(), order.end(), 0);
+   /// the latest entry of a path comes first and wins
+   std::sort(order.begin(), order.end(), [this](unsigned lhs, unsigned rhs) {
+      if (m_files[lhs].path != m_files[rhs].path) {
+         return m_files[lhs].path < m_files[rhs].path;
+      }
+      return lhs > rhs;
+   });
+
+   StringPool strings;
+   std::vector<FileRecord> files;
+   std::vector<DeclRecord> decls;
+   std::vector<DiagnosticRecord> diagnostics;
+   std::vector<NameIndexEntry> nameIndex;
+   files.reserve(m_files.size());
+   for (unsigned index : order) {
+      const FileEntry &entry = m_files[index];
+      if (!files.empty() && strings.getData().substr(files.back().path.offset,
+                                                     files.back().path.size) == entry.path) {
+         continue;
+      }
+      FileRecord file;
+      file.path = strings.intern(entry.path);
+      file.contentHash = entry.contentHash;
+      file.firstDecl = decls.size();
+      file.declCount = entry.decls.size();
+      file.firstDiagnostic = diagnostics.size();
+      file.diagnosticCount = entry.diagnostics.size();
+      for (const IndexedDecl &decl : entry.decls) {
+         DeclRecord record;
+         record.kind = static_cast<uint8_t>(decl.kind);
+         clear_reserved(record);
+         record.file = files.size();
+         record.offset = decl.offset;
+         record.line = decl.line;
+         record.column = decl.column;
+         record.name = strings.intern(decl.name);
+         record.signature = strings.intern(decl.signature);
+         record.docComment = strings.intern(decl.docComment);
+         NameIndexEntry nameEntry;
+         nameEntry.nameHash = get_name_hash(decl.name);
+         nameEntry.decl = decls.size();
+         nameEntry.reserved = 0;
+         nameIndex.push_back(nameEntry);
+         decls.push_back(record);
+      }
+      for (const ProjectDiagnostic &diagnostic : entry.diagnostics) {
+         DiagnosticRecord record;
+         record.kind = static_cast<uint8_t>(diagnostic.kind);
+         clear_reserved(record);
+         record.offset = diagnostic.offset;
+         record.line = diagnostic.line;
+         record.column = diagnostic.column;
+         record.message = strings.intern(diagnostic.message);
+         diagnostics.push_back(record);
+      }
+      files.push_back(file);
+   }
+   std::sort(nameIndex.begin(), nameIndex.end(),
+             [](const NameIndexEntry &lhs, const NameIndexEntry &rhs) {
+      if (lhs.nameHash != rhs.nameHash) {
+         return lhs.nameHash < rhs.nameHash;
+      }
+      return lhs.decl < rhs.decl;
+   });
+
+   SummaryHeader header;
+   std::memcpy(header.magic, SUMMARY_MAGIC, sizeof(header.magic));
+   header.version = SUMMARY_VERSION;
+   header.fileCount = files.size();
+   header.declCount = decls.size();
+   header.diagnosticCount = diagnostics.size();
+   header.stringTableSize = strings.getData().size();
+   if (Error error = writer.writeObject(header)) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<FileRecord>(files))) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<DeclRecord>(decls))) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<DiagnosticRecord>(diagnostics))) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<NameIndexEntry>(nameIndex))) {
+      return error;
+   }
+   return writer.writeFixedString(strings.getData());
+}
+
+Error ModuleSummaryWriter::writeToFile(StringRef path) const
+{
+   AppendingBinaryByteStream stream(Endianness::Little);
+   BinaryStreamWriter writer(stream);
+   if (Error error = write(writer)) {
+      return error;
+   }
+   std::string tempPath = path.getStr() + ".tmp";
+   {
+      std::error_code errorCode;
+      RawFdOutStream out(tempPath, errorCode, polar::fs::F_None);
+      if (errorCode) {
+         return error_code_to_error(errorCode);
+      }
+      ArrayRef<uint8_t> data = stream.getData();
+      out.write(reinterpret_cast<const char *>(data.getData()), data.getSize());
+      out.close();
+      if (out.hasError()) {
+         errorCode = out.getErrorCode();
+         out.clearError();
+         polar::fs::remove(tempPath);
+         return error_code_to_error(errorCode);
+      }
+   }
+   return error_code_to_error(polar::fs::rename(tempPath, path));
+}
+
+ModuleSummaryReader::ModuleSummaryReader(std::unique_ptr<MemoryBuffer> buffer)
+   : m_buffer(std::move(buffer))
+{}
+
+ModuleSummaryReader::~ModuleSummaryReader()
+{}
+
+Expected<std::unique_ptr<ModuleSummaryReader>> ModuleSummaryReader::open(StringRef path)
+{
+   /// large summaries are mapped rather than read
+   OptionalError<std::unique_ptr<MemoryBuffer>> buffer =
+         MemoryBuffer::getFile(path, -1, /*requiresNullTerminator=*/false);
+   if (std::error_code errorCode = buffer.getError()) {
+      return error_code_to_error(errorCode);
+   }
+   return create(std::move(buffer.get()));
+}
+
+Expected<std::unique_ptr<ModuleSummaryReader>>
+ModuleSummaryReader::create(std::unique_ptr<MemoryBuffer> buffer)
+{
+   std::unique_ptr<ModuleSummaryReader> reader(new ModuleSummaryReader(std::move(buffer)));
+   if (Error error = reader->initialize()) {
+      return error;
+   }
+   return reader;
+}
+
+Error ModuleSummaryReader::initialize()
+{
+   BinaryByteStream stream(m_buffer->getBuffer(), Endianness::Little);
+   BinaryStreamReader reader(stream);
+   const SummaryHeader *header = nullptr;
+   if (Error error = reader.readObject(header)) {
+      return error;
+   }
+   if (std::memcmp(header->magic, SUMMARY_MAGIC, sizeof(header->magic)) != 0) {
+      return make_format_error("not a module summary");
+   }
+   if (header->version != SUMMARY_VERSION) {
+      return make_format_error("module summary version mismatch");
+   }
+   if (Error error = reader.readArray(m_files, header->fileCount)) {
+      return error;
+   }
+   if (Error error = reader.readArray(m_decls, header->declCount)) {
+      return error;
+   }
+   if (Error error = reader.readArray(m_diagnostics, header->diagnosticCount)) {
+      return error;
+   }
+   if (Error error = reader.readArray(m_nameIndex, header->declCount)) {
+      return error;
+   }
+   if (Error error = reader.readFixedString(m_strings, header->stringTableSize)) {
+      return error;
+   }
+   /// the records themselves are checked as they are decoded
+   return Error::getSuccess();
+}
+
+StringRef ModuleSummaryReader::getString(const StringRecord &record) const
+{
+   uint32_t offset = record.offset;
+   uint32_t size = record.size;
+   if (offset > m_strings.size() || size > m_strings.size() - offset) {
+      return StringRef();
+   }
+   return m_strings.substr(offset, size);
+}
+
+StringRef ModuleSummaryReader::getFilePath(unsigned summaryFile) const
+{
+   return getString(m_files[summaryFile].path);
+}
+
+std::optional<unsigned> ModuleSummaryReader::findFile(StringRef path) const
+{
+   auto iter = std::lower_bound(m_files.begin(), m_files.end(), path,
+                                [this](const FileRecord &file, StringRef path) {
+      return getString(file.path) < path;
+   });
+   if (iter == m_files.end() || getString(iter->path) != path) {
+      return std::nullopt;
+   }
+   return iter - m_files.begin();
+}
+
+IndexedDecl ModuleSummaryReader::decodeDecl(const DeclRecord &record, unsigned fileIndex) const
+{
+   IndexedDecl decl;
+   decl.kind = record.kind <= static_cast<uint8_t>(IndexedDeclKind::Constant)
+         ? static_cast<IndexedDeclKind>(record.kind)
+         : IndexedDeclKind::Constant;
+   decl.fileIndex = fileIndex;
+   decl.offset = record.offset;
+   decl.line = record.line;
+   decl.column = record.column;
+   decl.name = getString(record.name).getStr();
+   decl.signature = getString(record.signature).getStr();
+   decl.docComment = getString(record.docComment).getStr();
+   return decl;
+}
+
+void ModuleSummaryReader::readFile(unsigned summaryFile, unsigned fileIndex,
+                                   std::vector<IndexedDecl> &decls,
+                                   std::vector<ProjectDiagnostic> &diagnostics) const
+{
+   const FileRecord &file = m_files[summaryFile];
+   uint32_t firstDecl = std::min<uint32_t>(file.firstDecl, m_decls.size());
+   uint32_t declCount = std::min<uint32_t>(file.declCount, m_decls.size() - firstDecl);
+   decls.reserve(decls.size() + declCount);
+   for (const DeclRecord &record : m_decls.slice(firstDecl, declCount)) {
+      decls.push_back(decodeDecl(record, fileIndex));
+   }
+   uint32_t firstDiagnostic = std::min<uint32_t>(file.firstDiagnostic, m_diagnostics.size());
+   uint32_t diagnosticCount = std::min<uint32_t>(file.diagnosticCount,
+                                                 m_diagnostics.size() - firstDiagnostic);
+   diagnostics.reserve(diagnostics.size() + diagnosticCount);
+   for (const DiagnosticRecord &record : m_diagnostics.slice(firstDiagnostic, diagnosticCount)) {
+      diagnostics.push_back({record.kind == static_cast<uint8_t>(ProjectDiagnosticKind::Note)
+                             ? ProjectDiagnosticKind::Note : ProjectDiagnosticKind::Error,
+                             fileIndex, record.offset, record.line, record.column,
+                             getString(record.message).getStr()});
+   }
+}
+
+IndexedDecl ModuleSummaryReader::getDecl(unsigned declIndex) const
+{
+   const DeclRecord &record = m_decls[declIndex];
+   return decodeDecl(record, record.file);
+}
+
+std::optional<IndexedDecl> ModuleSummaryReader::lookupDecl(StringRef qualifiedName,
+                                                           IndexedDeclKind kind) const
+{
+   qualifiedName = strip_leading_backslash(qualifiedName);
+   uint64_t hash = get_name_hash(qualifiedName);
+   auto iter = std::lower_bound(m_nameIndex.begin(), m_nameIndex.end(), hash,
+                                [](const NameIndexEntry &entry, uint64_t hash) {
+      return entry.nameHash < hash;
+   });
+   for (; iter != m_nameIndex.end() && iter->nameHash == hash; ++iter) {
+      if (iter->decl >= m_decls.size()) {
+         continue;
+      }
+      const DeclRecord &record = m_decls[iter->decl];
+      IndexedDeclKind recordKind = static_cast<IndexedDeclKind>(record.kind);
+      bool kindMatches = is_class_like(kind) ? is_class_like(recordKind) : recordKind == kind;
+      if (kindMatches && is_same_decl_name(getString(record.name), qualifiedName, kind)) {
+         return decodeDecl(record, record.file);
+      }
+   }
+   return std::nullopt;
+}
+
+ModuleSummaryCache::ModuleSummaryCache(StringRef summaryPath)
+   : m_path(summaryPath.getStr())
+{
+   Expected<std::unique_ptr<ModuleSummaryReader>> reader = ModuleSummaryReader::open(summaryPath);
+   if (reader) {
+      m_previous = std::move(*reader);
+   } else {
+      consume_error(reader.takeError());
+   }
+}
+
+ModuleSummaryCache::~ModuleSummaryCache()
+{}
+
+bool ModuleSummaryCache::lookup(StringRef path, uint64_t contentHash, unsigned fileIndex,
+                                std::vector<IndexedDecl> &decls,
+                                std::vector<ProjectDiagnostic> &diagnostics)
+{
+   if (!m_previous) {
+      return false;
+   }
+   std::optional<unsigned> summaryFile = m_previous->findFile(path);
+   if (!summaryFile || m_previous->getContentHash(*summaryFile) != contentHash) {
+      return false;
+   }
+   m_previous->readFile(*summaryFile, fileIndex, decls, diagnostics);
+   ++m_numHits;
+   return true;
+}
+
+void ModuleSummaryCache::store(StringRef path, uint64_t contentHash, ArrayRef<IndexedDecl> decls,
+                               ArrayRef<ProjectDiagnostic> diagnostics)
+{
+   m_writer.addFile(path, contentHash, decls, diagnostics);
+}
+
+Error ModuleSummaryCache::save() const
+{
+   return m_writer.writeToFile(m_path);
+}
+
+} // polar::serialization
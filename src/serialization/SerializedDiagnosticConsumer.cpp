@@ -0,0 +1,105 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/serialization/SerializedDiagnosticConsumer.h"
+#include "polarphp/ast/DiagnosticEngine.h"
+#include "polarphp/parser/SourceMgr.h"
+#include "polarphp/utils/RawOutStream.h"
+
+namespace polar::serialization {
+
+using polar::ast::DiagnosticEngine;
+using polar::utils::RawStringOutStream;
+
+namespace {
+
+SerializedDiagnosticKind to_serialized_kind(DiagnosticKind kind)
+{
+   switch (kind) {
+   case DiagnosticKind::Error:
+      return SerializedDiagnosticKind::Error;
+   case DiagnosticKind::Warning:
+      return SerializedDiagnosticKind::Warning;
+   case DiagnosticKind::Remark:
+      return SerializedDiagnosticKind::Remark;
+   case DiagnosticKind::Note:
+      return SerializedDiagnosticKind::Note;
+   }
+   polar_unreachable("Unhandled DiagnosticKind in switch.");
+}
+
+SerializedSourceRange resolve_range(SourceManager &sourceMgr, unsigned bufferID,
+                                    CharSourceRange range)
+{
+   SerializedSourceRange result;
+   if (range.isInvalid()) {
+      return result;
+   }
+   std::tie(result.startLine, result.startColumn) =
+         sourceMgr.getLineAndColumn(range.getStart(), bufferID);
+   std::tie(result.endLine, result.endColumn) =
+         sourceMgr.getLineAndColumn(range.getEnd(), bufferID);
+   return result;
+}
+
+} // anonymous namespace
+
+SerializedDiagnosticConsumer::SerializedDiagnosticConsumer(StringRef outputPath)
+   : m_outputPath(outputPath.getStr())
+{}
+
+void SerializedDiagnosticConsumer::handleDiagnostic(
+      SourceManager &sourceMgr, SourceLoc loc, DiagnosticKind kind,
+      StringRef formatString, ArrayRef<DiagnosticArgument> formatArgs,
+      const DiagnosticInfo &info)
+{
+   SerializedDiagnostic diagnostic;
+   diagnostic.kind = to_serialized_kind(kind);
+   diagnostic.id = static_cast<uint32_t>(info.id);
+   if (kind == DiagnosticKind::Note) {
+      diagnostic.parent = m_lastParent;
+   }
+   if (!info.formattedText.empty()) {
+      diagnostic.message = info.formattedText.getStr();
+   } else {
+      RawStringOutStream out(diagnostic.message);
+      DiagnosticEngine::formatDiagnosticText(out, formatString, formatArgs);
+   }
+   if (loc.isValid()) {
+      unsigned bufferID = sourceMgr.findBufferContainingLoc(loc);
+      diagnostic.file = sourceMgr.getDisplayNameForLoc(loc).getStr();
+      std::tie(diagnostic.line, diagnostic.column) = sourceMgr.getLineAndColumn(loc, bufferID);
+      for (CharSourceRange range : info.ranges) {
+         diagnostic.ranges.push_back(resolve_range(sourceMgr, bufferID, range));
+      }
+      for (const DiagnosticInfo::FixIt &fixIt : info.fixIts) {
+         diagnostic.fixIts.push_back({resolve_range(sourceMgr, bufferID, fixIt.getRange()),
+                                      fixIt.getText().getStr()});
+      }
+   }
+   unsigned index = m_writer.addDiagnostic(std::move(diagnostic));
+   if (kind != DiagnosticKind::Note) {
+      m_lastParent = index;
+   }
+}
+
+bool SerializedDiagnosticConsumer::finishProcessing()
+{
+   if (Error error = m_writer.writeToFile(m_outputPath)) {
+      polar::utils::log_all_unhandled_errors(std::move(error), polar::utils::error_stream(),
+                                             "error: cannot write diagnostics to '" +
+                                             m_outputPath + "': ");
+      return true;
+   }
+   return false;
+}
+
+} // polar::serialization
@@ -0,0 +1,291 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/serialization/SerializedDiagnostics.h"
+#include "polarphp/basic/adt/StringMap.h"
+#include "polarphp/utils/BinaryByteStream.h"
+#include "polarphp/utils/BinaryStreamError.h"
+#include "polarphp/utils/BinaryStreamReader.h"
+#include "polarphp/utils/BinaryStreamWriter.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace polar::serialization {
+
+using polar::basic::StringMap;
+using polar::utils::AppendingBinaryByteStream;
+using polar::utils::BinaryByteStream;
+using polar::utils::BinaryStreamError;
+using polar::utils::BinaryStreamReader;
+using polar::utils::Endianness;
+using polar::utils::OptionalError;
+using polar::utils::RawFdOutStream;
+using polar::utils::StreamErrorCode;
+using polar::utils::error_code_to_error;
+using polar::utils::make_error;
+using namespace diagnostics;
+
+namespace {
+
+///
+/// the string table of a diagnostics file being written, every distinct
+/// string is stored once
+///
+class StringPool
+{
+public:
+   StringRecord intern(StringRef text)
+   {
+      StringRecord record;
+      record.offset = 0;
+      record.size = text.size();
+      if (text.empty()) {
+         return record;
+      }
+      auto inserted = m_offsets.insert({text, static_cast<uint32_t>(m_data.size())});
+      if (inserted.second) {
+         m_data.append(text.data(), text.size());
+      }
+      record.offset = inserted.first->getValue();
+      return record;
+   }
+
+   StringRef getData() const
+   {
+      return m_data;
+   }
+
+private:
+   StringMap<uint32_t> m_offsets;
+   std::string m_data;
+};
+
+RangeRecord make_range_record(const SerializedSourceRange &range)
+{
+   RangeRecord record;
+   record.startLine = range.startLine;
+   record.startColumn = range.startColumn;
+   record.endLine = range.endLine;
+   record.endColumn = range.endColumn;
+   return record;
+}
+
+SerializedSourceRange decode_range(const RangeRecord &record)
+{
+   SerializedSourceRange range;
+   range.startLine = record.startLine;
+   range.startColumn = record.startColumn;
+   range.endLine = record.endLine;
+   range.endColumn = record.endColumn;
+   return range;
+}
+
+Error make_format_error(StringRef context)
+{
+   return make_error<BinaryStreamError>(StreamErrorCode::unspecified, context);
+}
+
+} // anonymous namespace
+
+unsigned SerializedDiagnosticsWriter::addDiagnostic(SerializedDiagnostic diagnostic)
+{
+   assert((!diagnostic.parent || *diagnostic.parent < m_diagnostics.size()) &&
+          "a note has to follow the diagnostic it is attached to");
+   m_diagnostics.push_back(std::move(diagnostic));
+   return m_diagnostics.size() - 1;
+}
+
+Error SerializedDiagnosticsWriter::write(BinaryStreamWriter &writer) const
+{
+   StringPool strings;
+   std::vector<DiagnosticRecord> diagnostics;
+   std::vector<RangeRecord> ranges;
+   std::vector<FixItRecord> fixIts;
+   diagnostics.reserve(m_diagnostics.size());
+   for (const SerializedDiagnostic &diagnostic : m_diagnostics) {
+      DiagnosticRecord record;
+      record.kind = static_cast<uint8_t>(diagnostic.kind);
+      std::memset(record.reserved, 0, sizeof(record.reserved));
+      record.id = diagnostic.id;
+      record.parent = diagnostic.parent ? *diagnostic.parent : NO_PARENT;
+      record.file = strings.intern(diagnostic.file);
+      record.line = diagnostic.line;
+      record.column = diagnostic.column;
+      record.message = strings.intern(diagnostic.message);
+      record.firstRange = ranges.size();
+      record.rangeCount = diagnostic.ranges.size();
+      for (const SerializedSourceRange &range : diagnostic.ranges) {
+         ranges.push_back(make_range_record(range));
+      }
+      record.firstFixIt = fixIts.size();
+      record.fixItCount = diagnostic.fixIts.size();
+      for (const SerializedFixIt &fixIt : diagnostic.fixIts) {
+         FixItRecord fixItRecord;
+         fixItRecord.range = make_range_record(fixIt.range);
+         fixItRecord.text = strings.intern(fixIt.text);
+         fixIts.push_back(fixItRecord);
+      }
+      diagnostics.push_back(record);
+   }
+
+   DiagnosticsHeader header;
+   std::memcpy(header.magic, DIAGNOSTICS_MAGIC, sizeof(header.magic));
+   header.version = DIAGNOSTICS_VERSION;
+   header.diagnosticCount = diagnostics.size();
+   header.rangeCount = ranges.size();
+   header.fixItCount = fixIts.size();
+   header.stringTableSize = strings.getData().size();
+   if (Error error = writer.writeObject(header)) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<DiagnosticRecord>(diagnostics))) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<RangeRecord>(ranges))) {
+      return error;
+   }
+   if (Error error = writer.writeArray(ArrayRef<FixItRecord>(fixIts))) {
+      return error;
+   }
+   return writer.writeFixedString(strings.getData());
+}
+
+Error SerializedDiagnosticsWriter::writeToFile(StringRef path) const
+{
+   AppendingBinaryByteStream stream(Endianness::Little);
+   BinaryStreamWriter writer(stream);
+   if (Error error = write(writer)) {
+      return error;
+   }
+   std::string tempPath = path.getStr() + ".tmp";
+   {
+      std::error_code errorCode;
+      RawFdOutStream out(tempPath, errorCode, polar::fs::F_None);
+      if (errorCode) {
+         return error_code_to_error(errorCode);
+      }
+      ArrayRef<uint8_t> data = stream.getData();
+      out.write(reinterpret_cast<const char *>(data.getData()), data.getSize());
+      out.close();
+      if (out.hasError()) {
+         errorCode = out.getErrorCode();
+         out.clearError();
+         polar::fs::remove(tempPath);
+         return error_code_to_error(errorCode);
+      }
+   }
+   return error_code_to_error(polar::fs::rename(tempPath, path));
+}
+
+SerializedDiagnosticsReader::SerializedDiagnosticsReader(std::unique_ptr<MemoryBuffer> buffer)
+   : m_buffer(std::move(buffer))
+{}
+
+SerializedDiagnosticsReader::~SerializedDiagnosticsReader()
+{}
+
+Expected<std::unique_ptr<SerializedDiagnosticsReader>>
+SerializedDiagnosticsReader::open(StringRef path)
+{
+   OptionalError<std::unique_ptr<MemoryBuffer>> buffer =
+         MemoryBuffer::getFile(path, -1, /*requiresNullTerminator=*/false);
+   if (std::error_code errorCode = buffer.getError()) {
+      return error_code_to_error(errorCode);
+   }
+   return create(std::move(buffer.get()));
+}
+
+Expected<std::unique_ptr<SerializedDiagnosticsReader>>
+SerializedDiagnosticsReader::create(std::unique_ptr<MemoryBuffer> buffer)
+{
+   std::unique_ptr<SerializedDiagnosticsReader> reader(
+            new SerializedDiagnosticsReader(std::move(buffer)));
+   if (Error error = reader->initialize()) {
+      return error;
+   }
+   return reader;
+}
+
+Error SerializedDiagnosticsReader::initialize()
+{
+   BinaryByteStream stream(m_buffer->getBuffer(), Endianness::Little);
+   BinaryStreamReader reader(stream);
+   const DiagnosticsHeader *header = nullptr;
+   if (Error error = reader.readObject(header)) {
+      return error;
+   }
+   if (std::memcmp(header->magic, DIAGNOSTICS_MAGIC, sizeof(header->magic)) != 0) {
+      return make_format_error("not a diagnostics file");
+   }
+   if (header->version != DIAGNOSTICS_VERSION) {
+      return make_format_error("diagnostics file version mismatch");
+   }
+   if (Error error = reader.readArray(m_diagnostics, header->diagnosticCount)) {
+      return error;
+   }
+   if (Error error = reader.readArray(m_ranges, header->rangeCount)) {
+      return error;
+   }
+   if (Error error = reader.readArray(m_fixIts, header->fixItCount)) {
+      return error;
+   }
+   return reader.readFixedString(m_strings, header->stringTableSize);
+}
+
+StringRef SerializedDiagnosticsReader::getString(const StringRecord &record) const
+{
+   uint32_t offset = record.offset;
+   uint32_t size = record.size;
+   if (offset > m_strings.size() || size > m_strings.size() - offset) {
+      return StringRef();
+   }
+   return m_strings.substr(offset, size);
+}
+
+SerializedDiagnosticKind SerializedDiagnosticsReader::getKind(unsigned index) const
+{
+   uint8_t kind = m_diagnostics[index].kind;
+   return kind <= static_cast<uint8_t>(SerializedDiagnosticKind::Note)
+         ? static_cast<SerializedDiagnosticKind>(kind)
+         : SerializedDiagnosticKind::Error;
+}
+
+SerializedDiagnostic SerializedDiagnosticsReader::getDiagnostic(unsigned index) const
+{
+   const DiagnosticRecord &record = m_diagnostics[index];
+   SerializedDiagnostic diagnostic;
+   diagnostic.kind = getKind(index);
+   diagnostic.id = record.id;
+   if (record.parent < index) {
+      diagnostic.parent = record.parent;
+   }
+   diagnostic.file = getString(record.file).getStr();
+   diagnostic.line = record.line;
+   diagnostic.column = record.column;
+   diagnostic.message = getString(record.message).getStr();
+   uint32_t firstRange = std::min<uint32_t>(record.firstRange, m_ranges.size());
+   uint32_t rangeCount = std::min<uint32_t>(record.rangeCount, m_ranges.size() - firstRange);
+   for (const RangeRecord &range : m_ranges.slice(firstRange, rangeCount)) {
+      diagnostic.ranges.push_back(decode_range(range));
+   }
+   uint32_t firstFixIt = std::min<uint32_t>(record.firstFixIt, m_fixIts.size());
+   uint32_t fixItCount = std::min<uint32_t>(record.fixItCount, m_fixIts.size() - firstFixIt);
+   for (const FixItRecord &fixIt : m_fixIts.slice(firstFixIt, fixItCount)) {
+      diagnostic.fixIts.push_back({decode_range(fixIt.range), getString(fixIt.text).getStr()});
+   }
+   return diagnostic;
+}
+
+} // polar::serialization
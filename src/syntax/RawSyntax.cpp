@@ -0,0 +1,124 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+#include "polarphp/syntax/RawSyntax.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <cstring>
+#include <new>
+
+namespace polar::syntax {
+
+const RawSyntax *RawSyntax::makeToken(SyntaxArena &arena, TokenKindType tokenKind,
+                                      StringRef text, StringRef leadingTrivia)
+{
+   void *mem = arena.allocate(sizeof(RawSyntax), alignof(RawSyntax));
+   RawSyntax *token = new (mem) RawSyntax(SyntaxKind::Token, tokenKind, 0);
+   token->m_text = text;
+   token->m_leadingTrivia = leadingTrivia;
+   token->m_textLength = leadingTrivia.size() + text.size();
+   token->m_tokenCount = 1;
+   return token;
+}
+
+const RawSyntax *RawSyntax::makeLayout(SyntaxArena &arena, SyntaxKind kind,
+                                       ArrayRef<const RawSyntax *> children)
+{
+   assert(kind != SyntaxKind::Token && "use makeToken");
+   void *mem = arena.allocate(sizeof(RawSyntax) + children.size() * sizeof(const RawSyntax *),
+                              alignof(RawSyntax));
+   RawSyntax *layout = new (mem) RawSyntax(kind, TokenKindType::unknown, children.size());
+   const RawSyntax **storage = layout->getChildrenStorage();
+   unsigned textLength = 0;
+   unsigned tokenCount = 0;
+   for (std::size_t i = 0; i < children.size(); ++i) {
+      storage[i] = children[i];
+      textLength += children[i]->m_textLength;
+      tokenCount += children[i]->m_tokenCount;
+   }
+   layout->m_textLength = textLength;
+   layout->m_tokenCount = tokenCount;
+   return layout;
+}
+
+const RawSyntax *RawSyntax::getFirstToken() const
+{
+   if (isToken()) {
+      return this;
+   }
+   for (const RawSyntax *child : getChildren()) {
+      if (const RawSyntax *token = child->getFirstToken()) {
+         return token;
+      }
+   }
+   return nullptr;
+}
+
+const RawSyntax *RawSyntax::getLastToken() const
+{
+   if (isToken()) {
+      return this;
+   }
+   for (unsigned i = m_numChildren; i > 0; --i) {
+      if (const RawSyntax *token = getChild(i - 1)->getLastToken()) {
+         return token;
+      }
+   }
+   return nullptr;
+}
+
+const RawSyntax *RawSyntax::replaceChild(SyntaxArena &arena, unsigned index,
+                                         const RawSyntax *newChild) const
+{
+   assert(!isToken() && index < m_numChildren && "invalid child to replace");
+   void *mem = arena.allocate(sizeof(RawSyntax) + m_numChildren * sizeof(const RawSyntax *),
+                              alignof(RawSyntax));
+   RawSyntax *layout = new (mem) RawSyntax(m_kind, m_tokenKind, m_numChildren);
+   std::memcpy(layout->getChildrenStorage(), getChildrenStorage(),
+               m_numChildren * sizeof(const RawSyntax *));
+   const RawSyntax *oldChild = getChild(index);
+   layout->getChildrenStorage()[index] = newChild;
+   layout->m_textLength = m_textLength - oldChild->m_textLength + newChild->m_textLength;
+   layout->m_tokenCount = m_tokenCount - oldChild->m_tokenCount + newChild->m_tokenCount;
+   return layout;
+}
+
+void RawSyntax::print(RawOutStream &out) const
+{
+   if (isToken()) {
+      out << m_leadingTrivia << m_text;
+      return;
+   }
+   for (const RawSyntax *child : getChildren()) {
+      child->print(out);
+   }
+}
+
+void RawSyntax::dump(RawOutStream &out, unsigned indent) const
+{
+   out.indent(indent);
+   if (isToken()) {
+      out << get_token_kind_name(m_tokenKind) << " '";
+      out.writeEscaped(m_text);
+      out << "'\n";
+      return;
+   }
+   out << get_syntax_kind_name(m_kind) << " (" << m_textLength << " bytes)\n";
+   for (const RawSyntax *child : getChildren()) {
+      child->dump(out, indent + 2);
+   }
+}
+
+void RawSyntax::dump() const
+{
+   dump(polar::utils::error_stream());
+}
+
+} // polar::syntax
@@ -0,0 +1,41 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+#include "polarphp/syntax/Syntax.h"
+#include "polarphp/utils/RawOutStream.h"
+
+namespace polar::syntax {
+
+std::optional<Syntax> Syntax::getParent() const
+{
+   if (const SyntaxData *parent = m_data->getParent()) {
+      return Syntax(m_root, parent);
+   }
+   return std::nullopt;
+}
+
+std::optional<Syntax> Syntax::findTokenAt(unsigned offset) const
+{
+   if (const SyntaxData *token = m_data->findTokenAt(offset)) {
+      return Syntax(m_root, token);
+   }
+   return std::nullopt;
+}
+
+std::string Syntax::getSourceText() const
+{
+   std::string text;
+   polar::utils::RawStringOutStream out(text);
+   print(out);
+   out.flush();
+   return text;
+}
+
+} // polar::syntax
@@ -0,0 +1,90 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+#include "polarphp/syntax/SyntaxData.h"
+
+namespace polar::syntax {
+
+SyntaxData::SyntaxData(const RawSyntax *raw, const SyntaxData *parent, unsigned indexInParent,
+                       unsigned offset)
+   : m_raw(raw),
+     m_parent(parent),
+     m_indexInParent(indexInParent),
+     m_offset(offset)
+{
+   if (raw->getNumChildren() != 0) {
+      m_children.reset(new AtomicCache<SyntaxData>[raw->getNumChildren()]);
+   }
+}
+
+SyntaxData::~SyntaxData()
+{}
+
+IntrusiveRefCountPtr<SyntaxData> SyntaxData::makeRoot(const RawSyntax *raw,
+                                                      IntrusiveRefCountPtr<SyntaxArena> arena)
+{
+   IntrusiveRefCountPtr<SyntaxData> root(new SyntaxData(raw, nullptr, 0, 0));
+   root->m_arena = std::move(arena);
+   return root;
+}
+
+const SyntaxData *SyntaxData::getChild(unsigned index) const
+{
+   assert(index < getNumChildren() && "child index out of range");
+   return m_children[index].getOrCreate([this, index]() {
+      unsigned offset = m_offset;
+      for (unsigned i = 0; i < index; ++i) {
+         offset += m_raw->getChild(i)->getTextLength();
+      }
+      return new SyntaxData(m_raw->getChild(index), this, index, offset);
+   });
+}
+
+unsigned SyntaxData::getTextOffset() const
+{
+   const RawSyntax *first = m_raw->getFirstToken();
+   return first ? m_offset + first->getLeadingTrivia().getLength() : m_offset;
+}
+
+const SyntaxData *SyntaxData::findTokenAt(unsigned offset) const
+{
+   if (offset < m_offset || offset >= getEndOffset()) {
+      return nullptr;
+   }
+   const SyntaxData *node = this;
+   while (!node->getRaw()->isToken()) {
+      const SyntaxData *next = nullptr;
+      unsigned childOffset = node->getOffset();
+      for (unsigned i = 0, count = node->getNumChildren(); i < count; ++i) {
+         unsigned width = node->getRaw()->getChild(i)->getTextLength();
+         if (offset < childOffset + width) {
+            next = node->getChild(i);
+            break;
+         }
+         childOffset += width;
+      }
+      if (!next) {
+         return nullptr;
+      }
+      node = next;
+   }
+   return node;
+}
+
+IntrusiveRefCountPtr<SyntaxArena> SyntaxData::getArena() const
+{
+   const SyntaxData *root = this;
+   while (root->m_parent) {
+      root = root->m_parent;
+   }
+   return root->m_arena;
+}
+
+} // polar::syntax
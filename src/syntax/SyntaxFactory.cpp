@@ -0,0 +1,46 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+#include "polarphp/syntax/SyntaxFactory.h"
+#include "polarphp/basic/adt/SmallVector.h"
+
+namespace polar::syntax {
+
+using polar::basic::SmallVector;
+
+const RawSyntax *SyntaxFactory::makeSourceFile(ArrayRef<const RawSyntax *> statements,
+                                               const RawSyntax *eofToken) const
+{
+   SmallVector<const RawSyntax *, 64> children(statements.begin(), statements.end());
+   children.push_back(eofToken);
+   return RawSyntax::makeLayout(*m_arena, SyntaxKind::SourceFile, children);
+}
+
+const RawSyntax *SyntaxFactory::makeStatement(ArrayRef<const RawSyntax *> elements) const
+{
+   return RawSyntax::makeLayout(*m_arena, SyntaxKind::Statement, elements);
+}
+
+const RawSyntax *SyntaxFactory::makeCodeBlock(ArrayRef<const RawSyntax *> elements) const
+{
+   return RawSyntax::makeLayout(*m_arena, SyntaxKind::CodeBlock, elements);
+}
+
+const RawSyntax *SyntaxFactory::makeParenGroup(ArrayRef<const RawSyntax *> elements) const
+{
+   return RawSyntax::makeLayout(*m_arena, SyntaxKind::ParenGroup, elements);
+}
+
+const RawSyntax *SyntaxFactory::makeSquareGroup(ArrayRef<const RawSyntax *> elements) const
+{
+   return RawSyntax::makeLayout(*m_arena, SyntaxKind::SquareGroup, elements);
+}
+
+} // polar::syntax
@@ -0,0 +1,38 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#include "polarphp/syntax/SyntaxKind.h"
+#include "polarphp/utils/ErrorHandling.h"
+
+namespace polar::syntax {
+
+StringRef get_syntax_kind_name(SyntaxKind kind)
+{
+   switch (kind) {
+   case SyntaxKind::Token:
+      return "Token";
+   case SyntaxKind::SourceFile:
+      return "SourceFile";
+   case SyntaxKind::Statement:
+      return "Statement";
+   case SyntaxKind::CodeBlock:
+      return "CodeBlock";
+   case SyntaxKind::ParenGroup:
+      return "ParenGroup";
+   case SyntaxKind::SquareGroup:
+      return "SquareGroup";
+   case SyntaxKind::Unknown:
+      return "Unknown";
+   }
+   polar_unreachable("invalid syntax kind");
+}
+
+} // polar::syntax
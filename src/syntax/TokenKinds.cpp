@@ -0,0 +1,99 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "polarphp/syntax/TokenKinds.h"
+#include "polarphp/utils/ErrorHandling.h"
+
+namespace polar::syntax {
+
+StringRef get_token_kind_name(TokenKindType kind)
+{
+   switch (kind) {
+#define TOKEN(name) \
+   case TokenKindType::name: return #name;
+#include "polarphp/syntax/TokenKinds.def"
+   case TokenKindType::NUM_TOKENS:
+      break;
+   }
+   polar_unreachable("invalid token kind");
+}
+
+StringRef get_token_text(TokenKindType kind)
+{
+   switch (kind) {
+#define KEYWORD(kw) \
+   case TokenKindType::kw_##kw: return #kw;
+#define PUNCTUATOR(name, str) \
+   case TokenKindType::name: return str;
+#define CAST(name, str) \
+   case TokenKindType::name: return "(" str ")";
+#include "polarphp/syntax/TokenKinds.def"
+   default:
+      return StringRef();
+   }
+}
+
+bool is_keyword_token(TokenKindType kind)
+{
+   switch (kind) {
+#define KEYWORD(kw) case TokenKindType::kw_##kw:
+#include "polarphp/syntax/TokenKinds.def"
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool is_magic_const_token(TokenKindType kind)
+{
+   switch (kind) {
+#define MAGIC_CONST(kw) case TokenKindType::kw_##kw:
+#include "polarphp/syntax/TokenKinds.def"
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool is_punctuator_token(TokenKindType kind)
+{
+   switch (kind) {
+#define PUNCTUATOR(name, str) case TokenKindType::name:
+#include "polarphp/syntax/TokenKinds.def"
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool is_cast_token(TokenKindType kind)
+{
+   switch (kind) {
+#define CAST(name, str) case TokenKindType::name:
+#include "polarphp/syntax/TokenKinds.def"
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool is_literal_token(TokenKindType kind)
+{
+   switch (kind) {
+#define LITERAL(name) case TokenKindType::name:
+#include "polarphp/syntax/TokenKinds.def"
+      return true;
+   default:
+      return false;
+   }
+}
+
+} // polar::syntax
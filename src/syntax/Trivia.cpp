@@ -0,0 +1,95 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/09.
+
+#include "polarphp/syntax/Trivia.h"
+
+namespace polar::syntax {
+
+namespace {
+
+TriviaPiece lex_whitespace_run(StringRef text, TriviaKind kind)
+{
+   char c = text[0];
+   std::size_t length = 1;
+   while (length < text.size() && text[length] == c) {
+      ++length;
+   }
+   return TriviaPiece{kind, text.substr(0, length)};
+}
+
+} // anonymous namespace
+
+TriviaPiece Trivia::lexPiece(StringRef text)
+{
+   assert(!text.empty() && "no trivia left");
+   switch (text[0]) {
+   case ' ':
+      return lex_whitespace_run(text, TriviaKind::Space);
+   case '\t':
+      return lex_whitespace_run(text, TriviaKind::Tab);
+   case '\n':
+      return lex_whitespace_run(text, TriviaKind::Newline);
+   case '\r': {
+      if (text.size() > 1 && text[1] == '\n') {
+         std::size_t length = 2;
+         while (length + 1 < text.size() && text[length] == '\r' && text[length + 1] == '\n') {
+            length += 2;
+         }
+         return TriviaPiece{TriviaKind::CarriageReturnLineFeed, text.substr(0, length)};
+      }
+      return TriviaPiece{TriviaKind::CarriageReturn, text.substr(0, 1)};
+   }
+   case '#':
+      return TriviaPiece{TriviaKind::LineComment, text.substr(0, text.findFirstOf("\r\n"))};
+   case '/':
+      if (text.startsWith("//")) {
+         return TriviaPiece{TriviaKind::LineComment, text.substr(0, text.findFirstOf("\r\n"))};
+      }
+      if (text.startsWith("/*")) {
+         std::size_t end = text.find("*/", 2);
+         end = end == StringRef::npos ? text.size() : end + 2;
+         bool isDoc = text.size() > 3 && text[2] == '*' &&
+               (text[3] == ' ' || text[3] == '\t' || text[3] == '\n' || text[3] == '\r');
+         return TriviaPiece{isDoc ? TriviaKind::DocComment : TriviaKind::BlockComment,
+                  text.substr(0, end)};
+      }
+      break;
+   default:
+      break;
+   }
+   return TriviaPiece{TriviaKind::Garbage, text.substr(0, 1)};
+}
+
+void Trivia::getPieces(SmallVectorImpl<TriviaPiece> &pieces) const
+{
+   StringRef text = m_text;
+   while (!text.empty()) {
+      TriviaPiece piece = lexPiece(text);
+      pieces.push_back(piece);
+      text = text.substr(piece.text.size());
+   }
+}
+
+StringRef Trivia::getDocComment() const
+{
+   StringRef docComment;
+   StringRef text = m_text;
+   while (!text.empty()) {
+      TriviaPiece piece = lexPiece(text);
+      if (piece.kind == TriviaKind::DocComment) {
+         docComment = piece.text;
+      }
+      text = text.substr(piece.text.size());
+   }
+   return docComment;
+}
+
+} // polar::syntax
@@ -55,6 +55,7 @@
 #include <stdio.h>
 #endif
 #include <assert.h>
+#include <algorithm>
 
 /*
  * This code extensively uses fall-through switches.
@@ -92,6 +93,9 @@ static const int sg_halfShift  = 10; /* used for shifting by 10 bits */
 static const Utf32 sg_halfBase = 0x0010000UL;
 static const Utf32 sg_halfMask = 0x3FFUL;
 
+/* shorter runs of ASCII are not worth a call to widen_ascii_prefix() */
+static const ptrdiff_t sg_asciiRunThreshold = 16;
+
 #define UNI_SUR_HIGH_START  static_cast<Utf32>(0xD800)
 #define UNI_SUR_HIGH_END    static_cast<Utf32>(0xDBFF)
 #define UNI_SUR_LOW_START   static_cast<Utf32>(0xDC00)
@@ -553,18 +557,12 @@ unsigned get_num_bytes_for_utf8(Utf8 first)
 
 /*
  * Exported function to return whether a UTF-8 string is legal or not.
- * This is not used here; it's just exported.
+ * On failure *source is left at the start of the first ill-formed sequence.
  */
 Boolean is_legal_utf8_string(const Utf8 **source, const Utf8 *sourceEnd)
 {
-   while (*source != sourceEnd) {
-      int length = sg_trailingBytesForUTF8[**source] + 1;
-      if (length > sourceEnd - *source || !is_legal_utf8(*source, length)) {
-         return false;
-      }
-      *source += length;
-   }
-   return true;
+   *source = find_invalid_utf8(*source, sourceEnd);
+   return *source == sourceEnd;
 }
 
 /* --------------------------------------------------------------------- */
@@ -577,6 +575,13 @@ ConversionResult convert_utf8_to_utf16 (
    const Utf8 *source = *sourceStart;
    Utf16 *target = *targetStart;
    while (source < sourceEnd) {
+      /* Copy runs of ASCII a block at a time. */
+      if (*source < 0x80 && sourceEnd - source >= sg_asciiRunThreshold && target < targetEnd) {
+         size_t count = widen_ascii_prefix(source, std::min<size_t>(sourceEnd - source, targetEnd - target), target);
+         source += count;
+         target += count;
+         continue;
+      }
       Utf32 ch = 0;
       unsigned short extraBytesToRead = static_cast<unsigned short>(sg_trailingBytesForUTF8[*source]);
       if (extraBytesToRead >= sourceEnd - source) {
@@ -653,6 +658,13 @@ static ConversionResult convert_utf8_to_utf32_impl(
    const Utf8 *source = *sourceStart;
    Utf32 *target = *targetStart;
    while (source < sourceEnd) {
+      /* Copy runs of ASCII a block at a time. */
+      if (*source < 0x80 && sourceEnd - source >= sg_asciiRunThreshold && target < targetEnd) {
+         size_t count = widen_ascii_prefix(source, std::min<size_t>(sourceEnd - source, targetEnd - target), target);
+         source += count;
+         target += count;
+         continue;
+      }
       Utf32 ch = 0;
       unsigned short extraBytesToRead = static_cast<unsigned short>(sg_trailingBytesForUTF8[*source]);
       if (extraBytesToRead >= sourceEnd - source) {
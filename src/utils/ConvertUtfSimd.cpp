@@ -0,0 +1,383 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+// Block validation of UTF-8 and bulk widening of ASCII runs.
+//
+// The AVX2 validator is the lookup algorithm of Keiser and Lemire
+// ("Validating UTF-8 In Less Than One Instruction Per Byte"): every byte is
+// classified together with the byte before it by three 16-entry nibble
+// tables, whose AND is non-zero exactly where a two byte pattern is
+// ill-formed, and the 3 and 4 byte sequences are checked by comparing the
+// continuation bytes the leads two and three positions back require with
+// the ones that are present. Blocks of pure ASCII only have to check that
+// the block before did not end inside a sequence.
+//
+// The validator only answers whether a block is valid. When it is not, the
+// exact position of the first ill-formed sequence is found by the scalar
+// code, starting one block before the failing one, so the result is always
+// the same as the one of is_legal_utf8_string().
+
+#include "polarphp/utils/ConvertUtf.h"
+#include "polarphp/basic/adt/StringRef.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+# define POLAR_UTF8_AVX2_DISPATCH 1
+# include <immintrin.h>
+#endif
+
+namespace polar {
+namespace utils {
+
+namespace {
+
+using Utf8FindInvalidFunc = const Utf8 *(*)(const Utf8 *source, const Utf8 *sourceEnd);
+using Utf8WidenUtf16Func = size_t (*)(const Utf8 *source, size_t length, Utf16 *target);
+using Utf8WidenUtf32Func = size_t (*)(const Utf8 *source, size_t length, Utf32 *target);
+
+struct Utf8Kernels
+{
+   Utf8FindInvalidFunc findInvalid;
+   Utf8WidenUtf16Func widenUtf16;
+   Utf8WidenUtf32Func widenUtf32;
+   const char *name;
+};
+
+const std::uint64_t sg_asciiWordMask = 0x8080808080808080ULL;
+
+inline bool is_ascii_word(const Utf8 *source)
+{
+   std::uint64_t word;
+   std::memcpy(&word, source, sizeof(word));
+   return (word & sg_asciiWordMask) == 0;
+}
+
+const Utf8 *find_invalid_utf8_fallback(const Utf8 *source, const Utf8 *sourceEnd)
+{
+   while (source != sourceEnd) {
+      while (sourceEnd - source >= 8 && is_ascii_word(source)) {
+         source += 8;
+      }
+      if (source == sourceEnd) {
+         break;
+      }
+      if (*source < 0x80) {
+         ++source;
+         continue;
+      }
+      if (!is_legal_utf8_sequence(source, sourceEnd)) {
+         return source;
+      }
+      source += get_num_bytes_for_utf8(*source);
+   }
+   return sourceEnd;
+}
+
+template <typename CharType>
+size_t widen_ascii_prefix_fallback(const Utf8 *source, size_t length, CharType *target)
+{
+   size_t count = 0;
+   while (count + 8 <= length && is_ascii_word(source + count)) {
+      for (size_t i = 0; i < 8; ++i) {
+         target[count + i] = static_cast<CharType>(source[count + i]);
+      }
+      count += 8;
+   }
+   while (count < length && source[count] < 0x80) {
+      target[count] = static_cast<CharType>(source[count]);
+      ++count;
+   }
+   return count;
+}
+
+#ifdef POLAR_UTF8_AVX2_DISPATCH
+
+#define POLAR_UTF8_TARGET_AVX2 __attribute__((target("avx2")))
+
+/// error bits of the two byte patterns, a byte pattern is ill-formed when
+/// the same bit is set in all three tables
+enum : std::uint8_t
+{
+   TOO_SHORT = 1 << 0, // lead not followed by a continuation
+   TOO_LONG = 1 << 1, // continuation not preceded by a lead
+   OVERLONG_3 = 1 << 2, // E0 80..9F
+   TOO_LARGE = 1 << 3, // F4 90..BF, F5..FF
+   SURROGATE = 1 << 4, // ED A0..BF
+   OVERLONG_2 = 1 << 5, // C0, C1
+   TOO_LARGE_1000 = 1 << 6, // F5..FF 80..8F
+   OVERLONG_4 = 1 << 6, // F0 80..8F
+   TWO_CONTS = 1 << 7, // two continuations in a row
+   CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS
+};
+
+POLAR_UTF8_TARGET_AVX2
+inline __m256i avx2_lookup16(__m256i table, __m256i index)
+{
+   return _mm256_shuffle_epi8(table, index);
+}
+
+POLAR_UTF8_TARGET_AVX2
+inline __m256i avx2_high_nibbles(__m256i input)
+{
+   return _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+}
+
+/// the input shifted right by N bytes, the gap filled with the last bytes
+/// of the previous block
+template <int N>
+POLAR_UTF8_TARGET_AVX2
+inline __m256i avx2_prev(__m256i input, __m256i prevInput)
+{
+   return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prevInput, input, 0x21), 16 - N);
+}
+
+POLAR_UTF8_TARGET_AVX2
+inline __m256i avx2_check_special_cases(__m256i input, __m256i prev1)
+{
+   const char CONTS = static_cast<char>(TWO_CONTS);
+   const __m256i byte1HighTable = _mm256_setr_epi8(
+            // 0_______ ________ <ASCII in byte 1>
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            // 10______ ________ <continuation in byte 1>
+            CONTS, CONTS, CONTS, CONTS,
+            // 1100____ ________ <two byte lead in byte 1>
+            TOO_SHORT | OVERLONG_2,
+            // 1101____ ________ <two byte lead in byte 1>
+            TOO_SHORT,
+            // 1110____ ________ <three byte lead in byte 1>
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            // 1111____ ________ <four+ byte lead in byte 1>
+            static_cast<char>(TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4),
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            CONTS, CONTS, CONTS, CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            static_cast<char>(TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+   const char CARRY_LARGE = static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000);
+   const __m256i byte1LowTable = _mm256_setr_epi8(
+            // ____0000 ________
+            static_cast<char>(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+            // ____0001 ________
+            static_cast<char>(CARRY | OVERLONG_2),
+            // ____001_ ________
+            static_cast<char>(CARRY), static_cast<char>(CARRY),
+            // ____0100 ________
+            static_cast<char>(CARRY | TOO_LARGE),
+            // ____0101 ________ .. ____1100 ________
+            CARRY_LARGE, CARRY_LARGE, CARRY_LARGE, CARRY_LARGE,
+            CARRY_LARGE, CARRY_LARGE, CARRY_LARGE, CARRY_LARGE,
+            // ____1101 ________
+            static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+            // ____111_ ________
+            CARRY_LARGE, CARRY_LARGE,
+            static_cast<char>(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+            static_cast<char>(CARRY | OVERLONG_2),
+            static_cast<char>(CARRY), static_cast<char>(CARRY),
+            static_cast<char>(CARRY | TOO_LARGE),
+            CARRY_LARGE, CARRY_LARGE, CARRY_LARGE, CARRY_LARGE,
+            CARRY_LARGE, CARRY_LARGE, CARRY_LARGE, CARRY_LARGE,
+            static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+            CARRY_LARGE, CARRY_LARGE);
+   const char CONT_LOW = static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4);
+   const char CONT_MID = static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE);
+   const char CONT_HIGH = static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE);
+   const __m256i byte2HighTable = _mm256_setr_epi8(
+            // ________ 0_______ <ASCII in byte 2>
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            // ________ 1000____
+            CONT_LOW,
+            // ________ 1001____
+            CONT_MID,
+            // ________ 101_____
+            CONT_HIGH, CONT_HIGH,
+            // ________ 11______
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            CONT_LOW, CONT_MID, CONT_HIGH, CONT_HIGH,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+   __m256i byte1High = avx2_lookup16(byte1HighTable, avx2_high_nibbles(prev1));
+   __m256i byte1Low = avx2_lookup16(byte1LowTable, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+   __m256i byte2High = avx2_lookup16(byte2HighTable, avx2_high_nibbles(input));
+   return _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+}
+
+POLAR_UTF8_TARGET_AVX2
+inline __m256i avx2_check_utf8_bytes(__m256i input, __m256i prevInput)
+{
+   __m256i prev1 = avx2_prev<1>(input, prevInput);
+   __m256i specialCases = avx2_check_special_cases(input, prev1);
+   // a byte must be a continuation when the byte two back is a 3 or 4 byte
+   // lead, or the byte three back a 4 byte lead, the saturated difference
+   // has its high bit set exactly then
+   __m256i prev2 = avx2_prev<2>(input, prevInput);
+   __m256i prev3 = avx2_prev<3>(input, prevInput);
+   __m256i isThirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+   __m256i isFourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+   __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThirdByte, isFourthByte),
+                                     _mm256_set1_epi8(static_cast<char>(0x80)));
+   return _mm256_xor_si256(must23, specialCases);
+}
+
+/// non-zero when the block ends inside a multibyte sequence
+POLAR_UTF8_TARGET_AVX2
+inline __m256i avx2_is_incomplete(__m256i input)
+{
+   const __m256i maxValue = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+   return _mm256_subs_epu8(input, maxValue);
+}
+
+POLAR_UTF8_TARGET_AVX2
+inline bool avx2_check_block(__m256i input, __m256i &prevInput, __m256i &prevIncomplete)
+{
+   __m256i error;
+   if (_mm256_movemask_epi8(input) == 0) {
+      error = prevIncomplete;
+      prevIncomplete = _mm256_setzero_si256();
+   } else {
+      error = avx2_check_utf8_bytes(input, prevInput);
+      prevIncomplete = avx2_is_incomplete(input);
+   }
+   prevInput = input;
+   return _mm256_testz_si256(error, error);
+}
+
+/// the first ill-formed sequence starts at most three bytes before the
+/// block its error was seen in, everything before the previous block is
+/// valid and scanning can restart at a lead byte there
+const Utf8 *locate_invalid_utf8(const Utf8 *begin, const Utf8 *block, const Utf8 *sourceEnd)
+{
+   const Utf8 *restart = block - begin >= 32 ? block - 32 : begin;
+   while (restart > begin && (*restart & 0xC0) == 0x80) {
+      --restart;
+   }
+   return find_invalid_utf8_fallback(restart, sourceEnd);
+}
+
+POLAR_UTF8_TARGET_AVX2
+const Utf8 *find_invalid_utf8_avx2(const Utf8 *source, const Utf8 *sourceEnd)
+{
+   const Utf8 *begin = source;
+   __m256i prevInput = _mm256_setzero_si256();
+   __m256i prevIncomplete = _mm256_setzero_si256();
+   while (sourceEnd - source >= 32) {
+      __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source));
+      if (!avx2_check_block(input, prevInput, prevIncomplete)) {
+         return locate_invalid_utf8(begin, source, sourceEnd);
+      }
+      source += 32;
+   }
+   // the tail is padded with NUL, which also flags a sequence cut off by
+   // the end of the input
+   Utf8 tail[32] = {0};
+   std::memcpy(tail, source, static_cast<size_t>(sourceEnd - source));
+   __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail));
+   if (!avx2_check_block(input, prevInput, prevIncomplete)) {
+      return locate_invalid_utf8(begin, source, sourceEnd);
+   }
+   return sourceEnd;
+}
+
+POLAR_UTF8_TARGET_AVX2
+size_t widen_ascii_prefix_avx2(const Utf8 *source, size_t length, Utf16 *target)
+{
+   size_t count = 0;
+   while (count + 16 <= length) {
+      __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + count));
+      if (_mm_movemask_epi8(input) != 0) {
+         break;
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + count), _mm256_cvtepu8_epi16(input));
+      count += 16;
+   }
+   return count + widen_ascii_prefix_fallback(source + count, length - count, target + count);
+}
+
+POLAR_UTF8_TARGET_AVX2
+size_t widen_ascii_prefix_avx2(const Utf8 *source, size_t length, Utf32 *target)
+{
+   size_t count = 0;
+   while (count + 16 <= length) {
+      __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + count));
+      if (_mm_movemask_epi8(input) != 0) {
+         break;
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + count), _mm256_cvtepu8_epi32(input));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + count + 8),
+                          _mm256_cvtepu8_epi32(_mm_srli_si128(input, 8)));
+      count += 16;
+   }
+   return count + widen_ascii_prefix_fallback(source + count, length - count, target + count);
+}
+
+#undef POLAR_UTF8_TARGET_AVX2
+
+#endif // POLAR_UTF8_AVX2_DISPATCH
+
+Utf8Kernels select_utf8_kernels()
+{
+#ifdef POLAR_UTF8_AVX2_DISPATCH
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2")) {
+      return {find_invalid_utf8_avx2,
+               static_cast<Utf8WidenUtf16Func>(widen_ascii_prefix_avx2),
+               static_cast<Utf8WidenUtf32Func>(widen_ascii_prefix_avx2),
+               "avx2"};
+   }
+#endif
+   return {find_invalid_utf8_fallback,
+            widen_ascii_prefix_fallback<Utf16>,
+            widen_ascii_prefix_fallback<Utf32>,
+            "fallback"};
+}
+
+const Utf8Kernels &get_utf8_kernels()
+{
+   static const Utf8Kernels kernels = select_utf8_kernels();
+   return kernels;
+}
+
+} // anonymous namespace
+
+const Utf8 *find_invalid_utf8(const Utf8 *source, const Utf8 *sourceEnd)
+{
+   return get_utf8_kernels().findInvalid(source, sourceEnd);
+}
+
+bool is_valid_utf8(StringRef str)
+{
+   const Utf8 *source = reinterpret_cast<const Utf8 *>(str.getData());
+   const Utf8 *sourceEnd = source + str.getSize();
+   return find_invalid_utf8(source, sourceEnd) == sourceEnd;
+}
+
+size_t widen_ascii_prefix(const Utf8 *source, size_t length, Utf16 *target)
+{
+   return get_utf8_kernels().widenUtf16(source, length, target);
+}
+
+size_t widen_ascii_prefix(const Utf8 *source, size_t length, Utf32 *target)
+{
+   return get_utf8_kernels().widenUtf32(source, length, target);
+}
+
+const char *get_utf8_kernels_name()
+{
+   return get_utf8_kernels().name;
+}
+
+} // utils
+} // polar
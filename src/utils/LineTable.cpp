@@ -0,0 +1,71 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/utils/LineTable.h"
+#include "polarphp/utils/MathExtras.h"
+
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace polar {
+namespace utils {
+
+void LineTable::scanTo(const char *bufferStart, std::size_t end)
+{
+   assert(!m_finished && "line table is finished already");
+   assert(end <= std::numeric_limits<std::uint32_t>::max() && "buffer too large for a line table");
+   std::size_t offset = m_scannedSize;
+   if (end <= offset) {
+      return;
+   }
+#if defined(__SSE2__)
+   const __m128i lf = _mm_set1_epi8('\n');
+   for (; end - offset >= 16; offset += 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bufferStart + offset));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf)));
+      while (mask) {
+         unsigned bit = count_trailing_zeros(mask, ZB_Undefined);
+         m_lineStarts.push_back(offset + bit + 1);
+         mask &= mask - 1;
+      }
+   }
+#endif
+   for (; offset < end; ++offset) {
+      if (bufferStart[offset] == '\n') {
+         m_lineStarts.push_back(offset + 1);
+      }
+   }
+   m_scannedSize = end;
+}
+
+void LineTable::finish(StringRef buffer)
+{
+   scanTo(buffer.data(), buffer.size());
+   m_finished = true;
+   /// one entry past the last block so the end of the buffer can be looked up
+   std::size_t blockCount = (m_scannedSize >> BLOCK_SHIFT) + 1;
+   m_blockLines.resize(blockCount);
+   std::uint32_t index = 0;
+   std::uint32_t count = m_lineStarts.size();
+   for (std::size_t block = 0; block < blockCount; ++block) {
+      std::size_t blockStart = block << BLOCK_SHIFT;
+      while (index + 1 < count && m_lineStarts[index + 1] <= blockStart) {
+         ++index;
+      }
+      m_blockLines[block] = index;
+   }
+}
+
+} // utils
+} // polar
@@ -80,66 +80,31 @@ unsigned SourceMgr::findBufferContainingLoc(SMLocation loc) const
    return 0;
 }
 
-template <typename T>
-unsigned SourceMgr::SrcBuffer::getLineNumber(const char *ptr) const
+const LineTable &SourceMgr::SrcBuffer::getLineTable() const
 {
-
-   // Ensure m_offsetCache is allocated and populated with offsets of all the
-   // '\n' bytes.
-   std::vector<T> *offsets = nullptr;
-   if (m_offsetCache.isNull()) {
-      offsets = new std::vector<T>();
-      m_offsetCache = offsets;
-      size_t size = m_buffer->getBufferSize();
-      assert(size <= std::numeric_limits<T>::max());
-      StringRef str = m_buffer->getBuffer();
-      for (size_t N = 0; N < size; ++N) {
-         if (str[N] == '\n') {
-            offsets->push_back(static_cast<T>(N));
-         }
-      }
-   } else {
-      offsets = m_offsetCache.get<std::vector<T> *>();
+   if (!m_lineTable) {
+      m_lineTable.reset(new LineTable(m_buffer->getBuffer()));
    }
-
-   const char *bufStart = m_buffer->getBufferStart();
-   assert(ptr >= bufStart && ptr <= m_buffer->getBufferEnd());
-   ptrdiff_t ptrDiff = ptr - bufStart;
-   assert(ptrDiff >= 0 && static_cast<size_t>(ptrDiff) <= std::numeric_limits<T>::max());
-   T ptrOffset = static_cast<T>(ptrDiff);
-
-   // std::lower_bound returns the first eol offset that's not-less-than
-   // ptrOffset, meaning the eol that _ends the line_ that ptrOffset is on
-   // (including if ptrOffset refers to the eol itself). If there's no such
-   // eol, returns end().
-   auto eol = std::lower_bound(offsets->begin(), offsets->end(), ptrOffset);
-
-   // Lines count from 1, so add 1 to the distance from the 0th line.
-   return (1 + (eol - offsets->begin()));
+   return *m_lineTable;
 }
 
 SourceMgr::SrcBuffer::SrcBuffer(SourceMgr::SrcBuffer &&other)
    : m_buffer(std::move(other.m_buffer)),
-     m_offsetCache(other.m_offsetCache),
+     m_lineTable(std::move(other.m_lineTable)),
      m_includeLoc(other.m_includeLoc)
-{
-   other.m_offsetCache = nullptr;
-}
+{}
 
 SourceMgr::SrcBuffer::~SrcBuffer()
+{}
+
+void SourceMgr::setLineTable(unsigned bufferID, LineTable table)
 {
-   if (!m_offsetCache.isNull()) {
-      if (m_offsetCache.is<std::vector<uint8_t>*>()) {
-         delete m_offsetCache.get<std::vector<uint8_t>*>();
-      } else if (m_offsetCache.is<std::vector<uint16_t>*>()) {
-         delete m_offsetCache.get<std::vector<uint16_t>*>();
-      } else if (m_offsetCache.is<std::vector<uint32_t>*>()) {
-         delete m_offsetCache.get<std::vector<uint32_t>*>();
-      } else {
-         delete m_offsetCache.get<std::vector<uint64_t>*>();
-      }
-      m_offsetCache = nullptr;
+   assert(isValidBufferID(bufferID));
+   SrcBuffer &buffer = m_buffers[bufferID - 1];
+   if (!table.isFinished()) {
+      table.finish(buffer.m_buffer->getBuffer());
    }
+   buffer.m_lineTable.reset(new LineTable(std::move(table)));
 }
 
 std::pair<unsigned, unsigned>
@@ -150,25 +115,9 @@ SourceMgr::getLineAndColumn(SMLocation loc, unsigned bufferID) const
    }
    assert(bufferID && "Invalid Location!");
    auto &sb = getBufferInfo(bufferID);
-   const char *ptr = loc.getPointer();
-
-   size_t size = sb.m_buffer->getBufferSize();
-   unsigned lineNo;
-   if (size <= std::numeric_limits<uint8_t>::max()) {
-      lineNo = sb.getLineNumber<uint8_t>(ptr);
-   } else if (size <= std::numeric_limits<uint16_t>::max()) {
-      lineNo = sb.getLineNumber<uint16_t>(ptr);
-   } else if (size <= std::numeric_limits<uint32_t>::max()) {
-      lineNo = sb.getLineNumber<uint32_t>(ptr);
-   } else {
-      lineNo = sb.getLineNumber<uint64_t>(ptr);
-   }
    const char *bufStart = sb.m_buffer->getBufferStart();
-   size_t newlineOffs = StringRef(bufStart, ptr-bufStart).findLastOf("\n\r");
-   if (newlineOffs == StringRef::npos) {
-      newlineOffs = ~(size_t)0;
-   }
-   return std::make_pair(lineNo, ptr-bufStart-newlineOffs);
+   assert(loc.getPointer() >= bufStart && loc.getPointer() <= sb.m_buffer->getBufferEnd());
+   return sb.getLineTable().getLineAndColumn(loc.getPointer() - bufStart);
 }
 
 void SourceMgr::printIncludeStack(SMLocation includeLoc, RawOutStream &outstream) const
@@ -15,6 +15,20 @@
 namespace polar {
 namespace vmapi {
 
+namespace
+{
+void move_entry(zval *slot, Variant &variant)
+{
+   zval entry = variant.detach(true);
+   if (EXPECTED(!Z_ISREF(entry))) {
+      ZVAL_COPY_VALUE(slot, &entry);
+      return;
+   }
+   ZVAL_COPY(slot, Z_REFVAL(entry));
+   zval_ptr_dtor(&entry);
+}
+} // anonymous namespace
+
 IteratorBridge::IteratorBridge(zval *object, AbstractIterator *iterator)
    : m_userspaceIterator(iterator)
 {
@@ -25,6 +39,10 @@ IteratorBridge::IteratorBridge(zval *object, AbstractIterator *iterator)
 
 IteratorBridge::~IteratorBridge()
 {
+   releaseBatch();
+   if (m_batch) {
+      efree(m_batch);
+   }
    invalidate();
    zval_ptr_dtor(&m_iterator.data);
 }
@@ -48,13 +66,17 @@ zend_object_iterator_funcs *IteratorBridge::getIteratorFuncs()
    funcs.move_forward = &IteratorBridge::next;
    funcs.rewind = &IteratorBridge::rewind;
    funcs.invalidate_current = &IteratorBridge::invalidate;
+   funcs.take_current = &IteratorBridge::takeCurrent;
    initialized = true;
    return &funcs;
 }
 
 bool IteratorBridge::valid()
 {
-   return m_userspaceIterator->valid();
+   if (!m_batched) {
+      return m_userspaceIterator->valid();
+   }
+   return m_position < m_count || fillBatch();
 }
 
 Variant &IteratorBridge::current()
@@ -69,12 +91,50 @@ Variant IteratorBridge::key()
 
 void IteratorBridge::next()
 {
-   return m_userspaceIterator->next();
+   if (!m_batched) {
+      return m_userspaceIterator->next();
+   }
+   if (m_position < m_count) {
+      zval_ptr_dtor(&m_batch[m_position]);
+      zval_ptr_dtor(&m_batch[BATCH_CAPACITY + m_position]);
+      ++m_position;
+   }
 }
 
 void IteratorBridge::rewind()
 {
-   return m_userspaceIterator->rewind();
+   releaseBatch();
+   m_exhausted = false;
+   m_userspaceIterator->rewind();
+   if (m_batched) {
+      fillBatch();
+   }
+}
+
+bool IteratorBridge::fillBatch()
+{
+   releaseBatch();
+   if (m_exhausted) {
+      return false;
+   }
+   IteratorBatch batch(m_batch, BATCH_CAPACITY);
+   if (!m_userspaceIterator->fetch(batch)) {
+      m_batched = false;
+      return false;
+   }
+   m_count = batch.getSize();
+   m_exhausted = m_count == 0;
+   return m_count > 0;
+}
+
+void IteratorBridge::releaseBatch()
+{
+   for (; m_position < m_count; ++m_position) {
+      zval_ptr_dtor(&m_batch[m_position]);
+      zval_ptr_dtor(&m_batch[BATCH_CAPACITY + m_position]);
+   }
+   m_position = 0;
+   m_count = 0;
 }
 
 void IteratorBridge::invalidate()
@@ -99,12 +159,22 @@ int IteratorBridge::valid(zend_object_iterator *iterator)
 
 zval *IteratorBridge::current(zend_object_iterator *iterator)
 {
-   return getSelfPtr(iterator)->current().getZvalPtr();
+   IteratorBridge *self = getSelfPtr(iterator);
+   if (self->m_batched) {
+      return &self->m_batch[BATCH_CAPACITY + self->m_position];
+   }
+   return self->current().getZvalPtr();
 }
 
 void IteratorBridge::key(zend_object_iterator *iterator, zval *data)
 {
-   Variant retValue(getSelfPtr(iterator)->key());
+   IteratorBridge *self = getSelfPtr(iterator);
+   if (self->m_batched) {
+      // copied rather than moved, the key may be asked for more than once
+      ZVAL_COPY(data, &self->m_batch[self->m_position]);
+      return;
+   }
+   Variant retValue(self->key());
    zval val = retValue.detach(true);
    ZVAL_ZVAL(data, &val, 1, 1);
 }
@@ -124,5 +194,46 @@ void IteratorBridge::invalidate(zend_object_iterator *iterator)
    getSelfPtr(iterator)->invalidate();
 }
 
+int IteratorBridge::takeCurrent(zend_object_iterator *iterator, zval *value, zval *key)
+{
+   IteratorBridge *self = getSelfPtr(iterator);
+   if (!self->m_batched) {
+      // the single step path has nothing to give up, copy as foreach would
+      zval *current = IteratorBridge::current(iterator);
+      if (!current || EG(exception)) {
+         return VMAPI_FAILURE;
+      }
+      ZVAL_COPY_DEREF(value, current);
+      if (key) {
+         IteratorBridge::key(iterator, key);
+      }
+      return VMAPI_SUCCESS;
+   }
+   if (self->m_position >= self->m_count) {
+      return VMAPI_FAILURE;
+   }
+   // the slots are left undefined, next() releases nothing then
+   zval *slot = &self->m_batch[BATCH_CAPACITY + self->m_position];
+   ZVAL_COPY_VALUE(value, slot);
+   ZVAL_UNDEF(slot);
+   if (key) {
+      slot = &self->m_batch[self->m_position];
+      ZVAL_COPY_VALUE(key, slot);
+      ZVAL_UNDEF(slot);
+   }
+   return VMAPI_SUCCESS;
+}
+
+void IteratorBatch::append(Variant &&key, Variant &&value)
+{
+   VMAPI_ASSERT_X(!isFull(), "IteratorBatch::append", "the batch is full");
+   if (!m_buffer) {
+      m_buffer = static_cast<zval *>(safe_emalloc(2 * m_capacity, sizeof(zval), 0));
+   }
+   move_entry(&m_buffer[m_size], key);
+   move_entry(&m_buffer[m_capacity + m_size], value);
+   ++m_size;
+}
+
 } // vmapi
 } // polar
@@ -28,6 +28,14 @@ typedef struct _tsrm_tls_entry tsrm_tls_entry;
 
 struct _tsrm_tls_entry {
 	void **storage;
+	/* 1 where the storage is the static variable of the thread */
+	char *located;
+	/* the malloc()ed storage of a resource that has a static variable,
+	 * where its data is kept while the entry is not current */
+	void **parked;
+	/* set while the static resources must not move, see
+	 * tsrm_pin_static_storage() */
+	int pinned;
 	int count;
 	THREAD_T thread_id;
 	tsrm_tls_entry *next;
@@ -38,6 +46,7 @@ typedef struct {
 	size_t size;
 	ts_allocate_ctor ctor;
 	ts_allocate_dtor dtor;
+	ts_allocate_locator locator;
 	int done;
 } tsrm_resource_type;
 
@@ -123,6 +132,122 @@ static DWORD tls_key;
 
 TSRM_TLS uint8_t in_main_thread = 0;
 
+/* the entry whose resources are in the static variables of this thread,
+ * see ts_allocate_static_id() */
+static TSRM_TLS tsrm_tls_entry *tsrm_static_owner = NULL;
+
+/* gives resource i of an entry its storage and constructs it, in_static
+ * is set for the entry that owns the static variables of the thread */
+static void tsrm_init_storage(tsrm_tls_entry *entry, int i, int in_static)
+{/*{{{*/
+	entry->parked[i] = NULL;
+	if (resource_types_table[i].locator && in_static) {
+		entry->storage[i] = resource_types_table[i].locator();
+		entry->located[i] = 1;
+	} else {
+		entry->storage[i] = (void *) malloc(resource_types_table[i].size);
+		entry->located[i] = 0;
+		if (resource_types_table[i].locator) {
+			entry->parked[i] = entry->storage[i];
+		}
+	}
+	if (resource_types_table[i].ctor) {
+		resource_types_table[i].ctor(entry->storage[i]);
+	}
+}/*}}}*/
+
+/* moves the resources of the static owner of this thread out of the static
+ * variables, the pointers TSRM hands out for them follow the data */
+static void tsrm_park_static_storage(tsrm_tls_entry *entry)
+{/*{{{*/
+	int i;
+
+	for (i=0; i<entry->count; i++) {
+		if (!entry->located[i] || !entry->storage[i]) {
+			continue;
+		}
+		if (!entry->parked[i]) {
+			entry->parked[i] = malloc(resource_types_table[i].size);
+		}
+		memcpy(entry->parked[i], entry->storage[i], resource_types_table[i].size);
+		entry->storage[i] = entry->parked[i];
+		entry->located[i] = 0;
+	}
+}/*}}}*/
+
+/* moves the parked resources of entry into the static variables of this
+ * thread, the thread must not have a static owner */
+static void tsrm_unpark_static_storage(tsrm_tls_entry *entry)
+{/*{{{*/
+	int i;
+
+	for (i=0; i<entry->count; i++) {
+		if (entry->located[i] || !entry->storage[i] || !resource_types_table[i].locator) {
+			continue;
+		}
+		entry->storage[i] = resource_types_table[i].locator();
+		memcpy(entry->storage[i], entry->parked[i], resource_types_table[i].size);
+		entry->located[i] = 1;
+	}
+}/*}}}*/
+
+/* makes entry the static owner of this thread */
+static void tsrm_switch_static_owner(tsrm_tls_entry *entry)
+{/*{{{*/
+	if (entry == tsrm_static_owner) {
+		return;
+	}
+	if (tsrm_static_owner) {
+		tsrm_park_static_storage(tsrm_static_owner);
+	}
+	if (entry) {
+		tsrm_unpark_static_storage(entry);
+	}
+	tsrm_static_owner = entry;
+}/*}}}*/
+
+/* whether entry has its resources in the static variables of some thread */
+static int tsrm_is_static_owner(tsrm_tls_entry *entry)
+{/*{{{*/
+	int i;
+
+	for (i=0; i<entry->count; i++) {
+		if (entry->located[i]) {
+			return 1;
+		}
+	}
+	return 0;
+}/*}}}*/
+
+/* the static storage of another thread is gone once that thread exited,
+ * it is neither destructed nor freed from here */
+static int tsrm_storage_reachable(tsrm_tls_entry *entry, int i)
+{/*{{{*/
+	return !entry->located[i] || entry == tsrm_static_owner;
+}/*}}}*/
+
+static void tsrm_release_storage(tsrm_tls_entry *entry, int i)
+{/*{{{*/
+	if (!entry->located[i] && entry->storage[i] != entry->parked[i]) {
+		free(entry->storage[i]);
+	}
+	free(entry->parked[i]);
+	entry->parked[i] = NULL;
+	entry->storage[i] = NULL;
+}/*}}}*/
+
+/* frees an entry that no longer has any storage */
+static void tsrm_free_entry(tsrm_tls_entry *entry)
+{/*{{{*/
+	if (entry == tsrm_static_owner) {
+		tsrm_static_owner = NULL;
+	}
+	free(entry->storage);
+	free(entry->located);
+	free(entry->parked);
+	free(entry);
+}/*}}}*/
+
 /* Startup TSRM (call once for the entire process) */
 TSRM_API int tsrm_startup(int expected_threads, int expected_resources, int debug_level, char *debug_filename)
 {/*{{{*/
@@ -187,15 +312,14 @@ TSRM_API void tsrm_shutdown(void)
 
 				next_p = p->next;
 				for (j=0; j<p->count; j++) {
-					if (p->storage[j]) {
+					if (p->storage[j] && tsrm_storage_reachable(p, j)) {
 						if (resource_types_table && !resource_types_table[j].done && resource_types_table[j].dtor) {
 							resource_types_table[j].dtor(p->storage[j]);
 						}
-						free(p->storage[j]);
+						tsrm_release_storage(p, j);
 					}
 				}
-				free(p->storage);
-				free(p);
+				tsrm_free_entry(p);
 				p = next_p;
 			}
 		}
@@ -229,8 +353,7 @@ TSRM_API void tsrm_shutdown(void)
 }/*}}}*/
 
 
-/* allocates a new thread-safe-resource id */
-TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate_ctor ctor, ts_allocate_dtor dtor)
+static ts_rsrc_id tsrm_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate_ctor ctor, ts_allocate_dtor dtor, ts_allocate_locator locator)
 {/*{{{*/
 	int i;
 
@@ -238,6 +361,23 @@ TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate
 
 	tsrm_mutex_lock(tsmm_mutex);
 
+	if (locator) {
+		/* the static variables of other threads cannot be reached from
+		 * here, their accessors would read storage nobody constructed */
+		for (i=0; i<tsrm_tls_table_size; i++) {
+			tsrm_tls_entry *p;
+
+			for (p = tsrm_tls_table[i]; p; p = p->next) {
+				if (p->thread_id != tsrm_thread_id()) {
+					tsrm_mutex_unlock(tsmm_mutex);
+					TSRM_ERROR((TSRM_ERROR_LEVEL_ERROR, "Static resources have to be allocated before other threads fetch theirs"));
+					*rsrc_id = 0;
+					return 0;
+				}
+			}
+		}
+	}
+
 	/* obtain a resource id */
 	*rsrc_id = TSRM_SHUFFLE_RSRC_ID(id_count++);
 	TSRM_ERROR((TSRM_ERROR_LEVEL_CORE, "Obtained resource id %d", *rsrc_id));
@@ -258,6 +398,7 @@ TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate
 	resource_types_table[TSRM_UNSHUFFLE_RSRC_ID(*rsrc_id)].size = size;
 	resource_types_table[TSRM_UNSHUFFLE_RSRC_ID(*rsrc_id)].ctor = ctor;
 	resource_types_table[TSRM_UNSHUFFLE_RSRC_ID(*rsrc_id)].dtor = dtor;
+	resource_types_table[TSRM_UNSHUFFLE_RSRC_ID(*rsrc_id)].locator = locator;
 	resource_types_table[TSRM_UNSHUFFLE_RSRC_ID(*rsrc_id)].done = 0;
 
 	/* enlarge the arrays for the already active threads */
@@ -269,11 +410,10 @@ TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate
 				int j;
 
 				p->storage = (void *) realloc(p->storage, sizeof(void *)*id_count);
+				p->located = (char *) realloc(p->located, id_count);
+				p->parked = (void **) realloc(p->parked, sizeof(void *)*id_count);
 				for (j=p->count; j<id_count; j++) {
-					p->storage[j] = (void *) malloc(resource_types_table[j].size);
-					if (resource_types_table[j].ctor) {
-						resource_types_table[j].ctor(p->storage[j]);
-					}
+					tsrm_init_storage(p, j, p == tsrm_static_owner);
 				}
 				p->count = id_count;
 			}
@@ -287,22 +427,51 @@ TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate
 }/*}}}*/
 
 
-static void allocate_new_resource(tsrm_tls_entry **thread_resources_ptr, THREAD_T thread_id)
+/* allocates a new thread-safe-resource id */
+TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate_ctor ctor, ts_allocate_dtor dtor)
+{/*{{{*/
+	return tsrm_allocate_id(rsrc_id, size, ctor, dtor, NULL);
+}/*}}}*/
+
+
+/* allocates a new thread-safe-resource id stored in a static thread local */
+TSRM_API ts_rsrc_id ts_allocate_static_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate_ctor ctor, ts_allocate_dtor dtor, ts_allocate_locator locator)
+{/*{{{*/
+	return tsrm_allocate_id(rsrc_id, size, ctor, dtor, locator);
+}/*}}}*/
+
+
+/* own_thread is set when the entry is created for the calling thread
+ * itself, it then takes the static variables of the thread unless another
+ * entry holds them */
+static void allocate_new_resource(tsrm_tls_entry **thread_resources_ptr, THREAD_T thread_id, int own_thread)
 {/*{{{*/
 	int i;
+	int in_static = own_thread && !tsrm_static_owner;
 
 	TSRM_ERROR((TSRM_ERROR_LEVEL_CORE, "Creating data structures for thread %x", thread_id));
 	(*thread_resources_ptr) = (tsrm_tls_entry *) malloc(sizeof(tsrm_tls_entry));
 	(*thread_resources_ptr)->storage = NULL;
+	(*thread_resources_ptr)->located = NULL;
+	(*thread_resources_ptr)->parked = NULL;
+	(*thread_resources_ptr)->pinned = 0;
 	if (id_count > 0) {
 		(*thread_resources_ptr)->storage = (void **) malloc(sizeof(void *)*id_count);
+		(*thread_resources_ptr)->located = (char *) calloc(id_count, 1);
+		(*thread_resources_ptr)->parked = (void **) calloc(id_count, sizeof(void *));
 	}
 	(*thread_resources_ptr)->count = id_count;
 	(*thread_resources_ptr)->thread_id = thread_id;
 	(*thread_resources_ptr)->next = NULL;
 
-	/* Set thread local storage to this new thread resources structure */
-	tsrm_tls_set(*thread_resources_ptr);
+	/* Set thread local storage to this new thread resources structure,
+	 * an entry made on behalf of another thread is not the caller's */
+	if (thread_id == tsrm_thread_id()) {
+		tsrm_tls_set(*thread_resources_ptr);
+	}
+	if (in_static) {
+		tsrm_static_owner = *thread_resources_ptr;
+	}
 
 	if (tsrm_new_thread_begin_handler) {
 		tsrm_new_thread_begin_handler(thread_id);
@@ -312,10 +481,7 @@ static void allocate_new_resource(tsrm_tls_entry **thread_resources_ptr, THREAD_
 			(*thread_resources_ptr)->storage[i] = NULL;
 		} else
 		{
-			(*thread_resources_ptr)->storage[i] = (void *) malloc(resource_types_table[i].size);
-			if (resource_types_table[i].ctor) {
-				resource_types_table[i].ctor((*thread_resources_ptr)->storage[i]);
-			}
+			tsrm_init_storage(*thread_resources_ptr, i, in_static);
 		}
 	}
 
@@ -362,7 +528,7 @@ TSRM_API void *ts_resource_ex(ts_rsrc_id id, THREAD_T *th_id)
 	thread_resources = tsrm_tls_table[hash_value];
 
 	if (!thread_resources) {
-		allocate_new_resource(&tsrm_tls_table[hash_value], thread_id);
+		allocate_new_resource(&tsrm_tls_table[hash_value], thread_id, thread_id == tsrm_thread_id());
 		return ts_resource_ex(id, &thread_id);
 	} else {
 		 do {
@@ -372,7 +538,7 @@ TSRM_API void *ts_resource_ex(ts_rsrc_id id, THREAD_T *th_id)
 			if (thread_resources->next) {
 				thread_resources = thread_resources->next;
 			} else {
-				allocate_new_resource(&thread_resources->next, thread_id);
+				allocate_new_resource(&thread_resources->next, thread_id, thread_id == tsrm_thread_id());
 				return ts_resource_ex(id, &thread_id);
 				/*
 				 * thread_resources = thread_resources->next;
@@ -381,6 +547,13 @@ TSRM_API void *ts_resource_ex(ts_rsrc_id id, THREAD_T *th_id)
 			}
 		 } while (thread_resources);
 	}
+	if (thread_id == tsrm_thread_id() && !tsrm_static_owner) {
+		/* an entry another thread made for this one, its resources move
+		 * into the static variables the first time the thread itself
+		 * fetches them */
+		tsrm_switch_static_owner(thread_resources);
+		tsrm_tls_set(thread_resources);
+	}
 	tsrm_mutex_unlock(tsmm_mutex);
 	/* Read a specific resource from the thread's resources.
 	 * This is called outside of a mutex, so have to be aware about external
@@ -400,15 +573,14 @@ void tsrm_free_interpreter_context(void *context)
 		next = thread_resources->next;
 
 		for (i=0; i<thread_resources->count; i++) {
-			if (resource_types_table[i].dtor) {
+			if (resource_types_table[i].dtor && tsrm_storage_reachable(thread_resources, i)) {
 				resource_types_table[i].dtor(thread_resources->storage[i]);
 			}
 		}
 		for (i=0; i<thread_resources->count; i++) {
-			free(thread_resources->storage[i]);
+			tsrm_release_storage(thread_resources, i);
 		}
-		free(thread_resources->storage);
-		free(thread_resources);
+		tsrm_free_entry(thread_resources);
 		thread_resources = next;
 	}
 }/*}}}*/
@@ -422,6 +594,27 @@ void *tsrm_set_interpreter_context(void *new_ctx)
 	/* TODO: unlink current from the global linked list, and replace it
 	 * it with the new context, protected by mutex where/if appropriate */
 
+	if (new_ctx && new_ctx != tsrm_static_owner && tsrm_is_static_owner(new_ctx)) {
+		/* its resources are in the static variables of another thread,
+		 * they cannot be in this thread's too */
+		TSRM_ERROR((TSRM_ERROR_LEVEL_ERROR, "Interpreter context is current on another thread"));
+		return NULL;
+	}
+	if (new_ctx && new_ctx != tsrm_static_owner && tsrm_static_owner && tsrm_static_owner->pinned) {
+		/* a request is running on the context in the static variables,
+		 * parking it would copy its globals away from the pointers into
+		 * them */
+		TSRM_ERROR((TSRM_ERROR_LEVEL_ERROR, "Interpreter context switched during a request"));
+		return NULL;
+	}
+
+	/* CG(), EG() and the other static accessors read the static variables
+	 * of the thread, the resources of the new context are copied there and
+	 * the ones of the old context are copied out */
+	if (new_ctx) {
+		tsrm_switch_static_owner(new_ctx);
+	}
+
 	/* Set thread local storage to this new thread resources structure */
 	tsrm_tls_set(new_ctx);
 
@@ -430,6 +623,16 @@ void *tsrm_set_interpreter_context(void *new_ctx)
 }/*}}}*/
 
 
+void tsrm_pin_static_storage(int pinned)
+{/*{{{*/
+	tsrm_tls_entry *thread_resources = tsrm_tls_get();
+
+	if (thread_resources) {
+		thread_resources->pinned = pinned;
+	}
+}/*}}}*/
+
+
 /* allocates a new interpreter context */
 void *tsrm_new_interpreter_context(void)
 {/*{{{*/
@@ -441,7 +644,9 @@ void *tsrm_new_interpreter_context(void)
 
 	current = tsrm_tls_get();
 
-	allocate_new_resource(&new_ctx, thread_id);
+	/* the static variables of the thread stay with the context that has
+	 * them, the new context gets its resources once it is switched to */
+	allocate_new_resource(&new_ctx, thread_id, 0);
 
 	/* switch back to the context that was in use prior to our creation
 	 * of the new one */
@@ -465,21 +670,20 @@ void ts_free_thread(void)
 	while (thread_resources) {
 		if (thread_resources->thread_id == thread_id) {
 			for (i=0; i<thread_resources->count; i++) {
-				if (resource_types_table[i].dtor) {
+				if (resource_types_table[i].dtor && tsrm_storage_reachable(thread_resources, i)) {
 					resource_types_table[i].dtor(thread_resources->storage[i]);
 				}
 			}
 			for (i=0; i<thread_resources->count; i++) {
-				free(thread_resources->storage[i]);
+				tsrm_release_storage(thread_resources, i);
 			}
-			free(thread_resources->storage);
 			if (last) {
 				last->next = thread_resources->next;
 			} else {
 				tsrm_tls_table[hash_value] = thread_resources->next;
 			}
 			tsrm_tls_set(0);
-			free(thread_resources);
+			tsrm_free_entry(thread_resources);
 			break;
 		}
 		if (thread_resources->next) {
@@ -507,20 +711,19 @@ void ts_free_worker_threads(void)
 	while (thread_resources) {
 		if (thread_resources->thread_id != thread_id) {
 			for (i=0; i<thread_resources->count; i++) {
-				if (resource_types_table[i].dtor) {
+				if (resource_types_table[i].dtor && tsrm_storage_reachable(thread_resources, i)) {
 					resource_types_table[i].dtor(thread_resources->storage[i]);
 				}
 			}
 			for (i=0; i<thread_resources->count; i++) {
-				free(thread_resources->storage[i]);
+				tsrm_release_storage(thread_resources, i);
 			}
-			free(thread_resources->storage);
 			if (last) {
 				last->next = thread_resources->next;
 			} else {
 				tsrm_tls_table[hash_value] = thread_resources->next;
 			}
-			free(thread_resources);
+			tsrm_free_entry(thread_resources);
 			if (last) {
 				thread_resources = last->next;
 			} else {
@@ -552,12 +755,11 @@ void ts_free_id(ts_rsrc_id id)
 			tsrm_tls_entry *p = tsrm_tls_table[i];
 
 			while (p) {
-				if (p->count > j && p->storage[j]) {
+				if (p->count > j && p->storage[j] && tsrm_storage_reachable(p, j)) {
 					if (resource_types_table && resource_types_table[j].dtor) {
 						resource_types_table[j].dtor(p->storage[j]);
 					}
-					free(p->storage[j]);
-					p->storage[j] = NULL;
+					tsrm_release_storage(p, j);
 				}
 				p = p->next;
 			}
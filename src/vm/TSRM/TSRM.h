@@ -80,6 +80,7 @@ typedef int ts_rsrc_id;
 
 typedef void (*ts_allocate_ctor)(void *);
 typedef void (*ts_allocate_dtor)(void *);
+typedef void *(*ts_allocate_locator)(void);
 
 #define THREAD_HASH_OF(thr,ts)  (unsigned long)thr%(unsigned long)ts
 
@@ -94,6 +95,19 @@ TSRM_API void tsrm_shutdown(void);
 /* allocates a new thread-safe-resource id */
 TSRM_API ts_rsrc_id ts_allocate_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate_ctor ctor, ts_allocate_dtor dtor);
 
+/* allocates a new thread-safe-resource id whose storage is a TSRM_TLS_IE
+ * variable, locator returns the address of that variable for the calling
+ * thread, so the resource can be reached without going through TSRM.
+ * the variable always holds the resource of the entry that is current on
+ * the thread: tsrm_set_interpreter_context() copies the resources of the
+ * old context out of it and the ones of the new context in, an entry made
+ * by ts_resource_ex() on behalf of another thread is copied in when that
+ * thread fetches its resources itself. the pointers ts_resource_ex() hands
+ * out follow the copies, a pointer kept across a switch is stale, which
+ * is why a context cannot be switched while it is pinned. fails once
+ * another thread has fetched its resources */
+TSRM_API ts_rsrc_id ts_allocate_static_id(ts_rsrc_id *rsrc_id, size_t size, ts_allocate_ctor ctor, ts_allocate_dtor dtor, ts_allocate_locator locator);
+
 /* fetches the requested resource for the current thread */
 TSRM_API void *ts_resource_ex(ts_rsrc_id id, THREAD_T *th_id);
 #define ts_resource(id)			ts_resource_ex(id, NULL)
@@ -138,8 +152,16 @@ TSRM_API void *tsrm_set_shutdown_handler(tsrm_shutdown_func_t shutdown_handler);
 /* these 3 APIs should only be used by people that fully understand the threading model
  * used by PHP/Zend and the selected SAPI. */
 TSRM_API void *tsrm_new_interpreter_context(void);
+/* returns NULL and leaves the current context in place when new_ctx is
+ * the current context of another thread, or when the switch would move
+ * the static resources of a pinned context */
 TSRM_API void *tsrm_set_interpreter_context(void *new_ctx);
 TSRM_API void tsrm_free_interpreter_context(void *context);
+/* pins the static resources of the current context where they are, the
+ * engine does it for the length of a request: $GLOBALS and the main frame
+ * point at EG(symbol_table) and other threads write EG(vm_interrupt)
+ * through its address, a copy to another place would leave them behind */
+TSRM_API void tsrm_pin_static_storage(int pinned);
 
 TSRM_API void *tsrm_get_ls_cache(void);
 TSRM_API uint8_t tsrm_is_main_thread(void);
@@ -155,6 +177,28 @@ TSRM_API const char *tsrm_api_name(void);
 # endif
 #endif
 
+/* initial-exec thread locals sit at a fixed offset from the thread pointer,
+ * an access is one load relative to it without a call to __tls_get_addr.
+ * __thread rather than thread_local, C++ would wrap the access in a call
+ * in case the variable needs a dynamic initialization.
+ *
+ * the offset is fixed when the program starts, a library loaded later with
+ * dlopen() only gets the small surplus glibc keeps in the static TLS block
+ * and fails with "cannot allocate memory in static TLS block" when its
+ * initial-exec variables do not fit. the engine globals are far larger
+ * than that surplus, an engine that is dlopen()ed has to be built with
+ * POLAR_DISABLE_STATIC_TLS_GLOBALS, which leaves ZEND_STATIC_TLS_GLOBALS
+ * undefined and gives these variables the default TLS model */
+#if defined(__GNUC__) && !defined(TSRM_WIN32)
+# ifdef ZEND_STATIC_TLS_GLOBALS
+#  define TSRM_TLS_IE __thread __attribute__((tls_model("initial-exec")))
+# else
+#  define TSRM_TLS_IE __thread
+# endif
+#else
+# define TSRM_TLS_IE TSRM_TLS
+#endif
+
 #define TSRM_SHUFFLE_RSRC_ID(rsrc_id)		((rsrc_id)+1)
 #define TSRM_UNSHUFFLE_RSRC_ID(rsrc_id)		((rsrc_id)-1)
 
@@ -200,6 +244,7 @@ TSRM_API const char *tsrm_api_name(void);
 #define TSRMLS_CACHE
 
 #define TSRM_TLS
+#define TSRM_TLS_IE
 
 /* BC only */
 #define TSRMLS_D	void
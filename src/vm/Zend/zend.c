@@ -32,10 +32,12 @@
 #include "zend_smart_str.h"
 #include "zend_smart_string.h"
 #include "zend_cpuinfo.h"
+#include "zend_resolve_cache.h"
 
 #ifdef ZTS
 ZEND_API int compiler_globals_id;
 ZEND_API int executor_globals_id;
+ZEND_API TSRM_TLS_IE zend_static_globals zend_static_globals_block;
 static HashTable *global_function_table = NULL;
 static HashTable *global_class_table = NULL;
 static HashTable *global_constants_table = NULL;
@@ -75,6 +77,7 @@ void (*zend_printf_to_smart_string)(smart_string *buf, const char *format, va_li
 void (*zend_printf_to_smart_str)(smart_str *buf, const char *format, va_list ap);
 ZEND_API char *(*zend_getenv)(char *name, size_t name_len);
 ZEND_API zend_string *(*zend_resolve_path)(const char *filename, size_t filename_len);
+ZEND_API size_t (*zend_utf8_validate)(const unsigned char *str, size_t str_length);
 ZEND_API int (*zend_post_startup_cb)(void) = NULL;
 
 void (*zend_on_timeout)(int seconds);
@@ -510,6 +513,42 @@ static FILE *zend_fopen_wrapper(const char *filename, zend_string **opened_path)
 }
 /* }}} */
 
+static size_t zend_utf8_validate_wrapper(const unsigned char *str, size_t str_length) /* {{{ */
+{
+   const unsigned char *p = str, *end = str + str_length;
+
+   while (p < end) {
+      unsigned char c = *p;
+      size_t len;
+
+      if (c < 0x80) {
+         p++;
+         continue;
+      } else if (c >= 0xC2 && c <= 0xDF) {
+         len = 2;
+      } else if (c >= 0xE0 && c <= 0xEF) {
+         len = 3;
+      } else if (c >= 0xF0 && c <= 0xF4) {
+         len = 4;
+      } else {
+         break;
+      }
+      if ((size_t)(end - p) < len
+         || (p[1] & 0xC0) != 0x80
+         || (c == 0xE0 && p[1] < 0xA0)
+         || (c == 0xED && p[1] > 0x9F)
+         || (c == 0xF0 && p[1] < 0x90)
+         || (c == 0xF4 && p[1] > 0x8F)
+         || (len > 2 && (p[2] & 0xC0) != 0x80)
+         || (len > 3 && (p[3] & 0xC0) != 0x80)) {
+         break;
+      }
+      p += len;
+   }
+   return p - str;
+}
+/* }}} */
+
 #ifdef ZTS
 static zend_bool short_tags_default      = 1;
 static uint32_t compiler_options_default = ZEND_COMPILE_DEFAULT;
@@ -671,6 +710,7 @@ static void executor_globals_ctor(zend_executor_globals *executor_globals) /* {{
    zend_startup_constants();
    zend_copy_constants(executor_globals->zend_constants, GLOBAL_CONSTANTS_TABLE);
    zend_init_rsrc_plist();
+   zend_resolve_cache_ctor(executor_globals);
    zend_init_exception_op();
    zend_init_call_trampoline_op();
    memset(&executor_globals->trampoline, 0, sizeof(zend_op_array));
@@ -705,6 +745,7 @@ static void executor_globals_dtor(zend_executor_globals *executor_globals) /* {{
    if (&executor_globals->persistent_list != global_persistent_list) {
       zend_destroy_rsrc_list(&executor_globals->persistent_list);
    }
+   zend_resolve_cache_dtor(executor_globals);
    if (executor_globals->zend_constants != GLOBAL_CONSTANTS_TABLE) {
       zend_hash_destroy(executor_globals->zend_constants);
       free(executor_globals->zend_constants);
@@ -738,12 +779,43 @@ static void php_scanner_globals_ctor(zend_php_scanner_globals *scanner_globals_p
 }
 /* }}} */
 
+#ifdef ZTS
+static void *compiler_globals_locator(void) /* {{{ */
+{
+   return &zend_static_globals_block.compiler;
+}
+/* }}} */
+
+static void *executor_globals_locator(void) /* {{{ */
+{
+   return &zend_static_globals_block.executor;
+}
+/* }}} */
+
+static void *language_scanner_globals_locator(void) /* {{{ */
+{
+   return &zend_static_globals_block.language_scanner;
+}
+/* }}} */
+
+static void *ini_scanner_globals_locator(void) /* {{{ */
+{
+   return &zend_static_globals_block.ini_scanner;
+}
+/* }}} */
+#endif
+
 static void module_destructor_zval(zval *zv) /* {{{ */
 {
    zend_module_entry *module = (zend_module_entry*)Z_PTR_P(zv);
 
    module_destructor(module);
-   free(module);
+}
+/* }}} */
+
+static void module_free_zval(zval *zv) /* {{{ */
+{
+   free(Z_PTR_P(zv));
 }
 /* }}} */
 
@@ -808,6 +880,10 @@ int zend_startup(zend_utility_functions *utility_functions, char **extensions) /
    zend_printf_to_smart_str = utility_functions->printf_to_smart_str_function;
    zend_getenv = utility_functions->getenv_function;
    zend_resolve_path = utility_functions->resolve_path_function;
+   zend_utf8_validate = utility_functions->utf8_validate_function;
+   if (!zend_utf8_validate) {
+      zend_utf8_validate = zend_utf8_validate_wrapper;
+   }
 
    zend_interrupt_function = NULL;
 
@@ -854,14 +930,18 @@ int zend_startup(zend_utility_functions *utility_functions, char **extensions) /
    zend_hash_init_ex(GLOBAL_AUTO_GLOBALS_TABLE, 8, NULL, auto_global_dtor, 1, 0);
    zend_hash_init_ex(GLOBAL_CONSTANTS_TABLE, 128, NULL, ZEND_CONSTANT_DTOR, 1, 0);
 
-   zend_hash_init_ex(&module_registry, 32, NULL, module_destructor_zval, 1, 0);
+   zend_rcu_startup();
+   /* a module is shut down when it leaves the registry, its entry is freed
+    * once no thread can still be reading it */
+   zend_rcu_hash_init(&module_registry, 32, NULL, module_free_zval, 1);
+   zend_rcu_hash_set_remove_handler(&module_registry, module_destructor_zval);
    zend_init_rsrc_list_dtors();
 
 #ifdef ZTS
-   ts_allocate_id(&compiler_globals_id, sizeof(zend_compiler_globals), (ts_allocate_ctor) compiler_globals_ctor, (ts_allocate_dtor) compiler_globals_dtor);
-   ts_allocate_id(&executor_globals_id, sizeof(zend_executor_globals), (ts_allocate_ctor) executor_globals_ctor, (ts_allocate_dtor) executor_globals_dtor);
-   ts_allocate_id(&language_scanner_globals_id, sizeof(zend_php_scanner_globals), (ts_allocate_ctor) php_scanner_globals_ctor, NULL);
-   ts_allocate_id(&ini_scanner_globals_id, sizeof(zend_ini_scanner_globals), (ts_allocate_ctor) ini_scanner_globals_ctor, NULL);
+   ts_allocate_static_id(&compiler_globals_id, sizeof(zend_compiler_globals), (ts_allocate_ctor) compiler_globals_ctor, (ts_allocate_dtor) compiler_globals_dtor, compiler_globals_locator);
+   ts_allocate_static_id(&executor_globals_id, sizeof(zend_executor_globals), (ts_allocate_ctor) executor_globals_ctor, (ts_allocate_dtor) executor_globals_dtor, executor_globals_locator);
+   ts_allocate_static_id(&language_scanner_globals_id, sizeof(zend_php_scanner_globals), (ts_allocate_ctor) php_scanner_globals_ctor, NULL, language_scanner_globals_locator);
+   ts_allocate_static_id(&ini_scanner_globals_id, sizeof(zend_ini_scanner_globals), (ts_allocate_ctor) ini_scanner_globals_ctor, NULL, ini_scanner_globals_locator);
    compiler_globals = ts_resource(compiler_globals_id);
    executor_globals = ts_resource(executor_globals_id);
 
@@ -893,6 +973,7 @@ int zend_startup(zend_utility_functions *utility_functions, char **extensions) /
 
 #ifndef ZTS
    zend_init_rsrc_plist();
+   zend_resolve_cache_ctor(&executor_globals);
    zend_init_exception_op();
    zend_init_call_trampoline_op();
 #endif
@@ -940,6 +1021,7 @@ int zend_post_startup(void) /* {{{ */
    compiler_options_default = CG(compiler_options);
 
    zend_destroy_rsrc_list(&EG(persistent_list));
+   zend_resolve_cache_dtor(executor_globals);
    free(compiler_globals->function_table);
    free(compiler_globals->class_table);
    if ((script_encoding_list = (zend_encoding **)compiler_globals->script_encoding_list)) {
@@ -973,6 +1055,9 @@ void zend_shutdown(void) /* {{{ */
    zend_vm_dtor();
 
    zend_destroy_rsrc_list(&EG(persistent_list));
+#ifndef ZTS
+   zend_resolve_cache_dtor(&executor_globals);
+#endif
    zend_destroy_modules();
 
    virtual_cwd_deactivate();
@@ -1074,6 +1159,7 @@ ZEND_API char *get_zend_version(void) /* {{{ */
 ZEND_API void zend_activate(void) /* {{{ */
 {
 #ifdef ZTS
+   tsrm_pin_static_storage(1);
    virtual_cwd_activate();
 #endif
    gc_reset();
@@ -1111,7 +1197,11 @@ ZEND_API void zend_deactivate(void) /* {{{ */
       shutdown_compiler();
    } zend_end_try();
 
-   zend_destroy_rsrc_list(&EG(regular_list));
+   zend_destroy_rsrc_table(&EG(regular_list));
+
+#ifdef ZTS
+   tsrm_pin_static_storage(0);
+#endif
 
 #if GC_BENCH
    fprintf(stderr, "GC Statistics\n");
@@ -188,6 +188,7 @@ typedef struct _zend_utility_functions {
    void (*printf_to_smart_str_function)(smart_str *buf, const char *format, va_list ap);
    char *(*getenv_function)(char *name, size_t name_len);
    zend_string *(*resolve_path_function)(const char *filename, size_t filename_len);
+   size_t (*utf8_validate_function)(const unsigned char *str, size_t str_length);
 } zend_utility_functions;
 
 typedef struct _zend_utility_values {
@@ -277,6 +278,8 @@ extern void (*zend_printf_to_smart_string)(smart_string *buf, const char *format
 extern void (*zend_printf_to_smart_str)(smart_str *buf, const char *format, va_list ap);
 extern ZEND_API char *(*zend_getenv)(char *name, size_t name_len);
 extern ZEND_API zend_string *(*zend_resolve_path)(const char *filename, size_t filename_len);
+/* returns the length of the legal UTF-8 prefix of str */
+extern ZEND_API size_t (*zend_utf8_validate)(const unsigned char *str, size_t str_length);
 extern ZEND_API int (*zend_post_startup_cb)(void);
 
 ZEND_API ZEND_COLD void zend_error(int type, const char *format, ...) ZEND_ATTRIBUTE_FORMAT(printf, 2, 3);
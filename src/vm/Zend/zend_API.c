@@ -29,13 +29,14 @@
 #include "zend_exceptions.h"
 #include "zend_closures.h"
 #include "zend_inheritance.h"
+#include "zend_resolve_cache.h"
 
 #ifdef HAVE_STDARG_H
 #include <stdarg.h>
 #endif
 
 /* these variables are true statics/globals, and have to be mutex'ed on every access */
-ZEND_API HashTable module_registry;
+ZEND_API RcuHashTable module_registry;
 
 static zend_module_entry **module_request_startup_handlers;
 static zend_module_entry **module_request_shutdown_handlers;
@@ -1850,7 +1851,7 @@ ZEND_API int zend_startup_module_ex(zend_module_entry *module) /* {{{ */
             lcname = zend_string_alloc(name_len, 0);
             zend_str_tolower_copy(ZSTR_VAL(lcname), dep->name, name_len);
 
-            if ((req_mod = zend_hash_find_ptr(&module_registry, lcname)) == NULL || !req_mod->module_started) {
+            if ((req_mod = zend_rcu_hash_find_ptr(&module_registry, lcname)) == NULL || !req_mod->module_started) {
                zend_string_efree(lcname);
                /* TODO: Check version relationship */
                zend_error(E_CORE_WARNING, "Cannot load module '%s' because required module '%s' is not loaded", module->name, dep->name);
@@ -1886,14 +1887,6 @@ ZEND_API int zend_startup_module_ex(zend_module_entry *module) /* {{{ */
 }
 /* }}} */
 
-static int zend_startup_module_zval(zval *zv) /* {{{ */
-{
-   zend_module_entry *module = Z_PTR_P(zv);
-
-   return (zend_startup_module_ex(module) == SUCCESS) ? ZEND_HASH_APPLY_KEEP : ZEND_HASH_APPLY_REMOVE;
-}
-/* }}} */
-
 static void zend_sort_modules(void *base, size_t count, size_t siz, compare_func_t compare, swap_func_t swp) /* {{{ */
 {
    Bucket *b1 = base;
@@ -1939,7 +1932,8 @@ ZEND_API void zend_collect_module_handlers(void) /* {{{ */
    int class_count = 0;
 
    /* Collect extensions with request startup/shutdown handlers */
-   ZEND_HASH_FOREACH_PTR(&module_registry, module) {
+   zend_rcu_read_lock();
+   ZEND_HASH_FOREACH_PTR(RCU_HASH(&module_registry), module) {
       if (module->request_startup_func) {
          startup_count++;
       }
@@ -1962,7 +1956,7 @@ ZEND_API void zend_collect_module_handlers(void) /* {{{ */
    module_post_deactivate_handlers[post_deactivate_count] = NULL;
    startup_count = 0;
 
-   ZEND_HASH_FOREACH_PTR(&module_registry, module) {
+   ZEND_HASH_FOREACH_PTR(RCU_HASH(&module_registry), module) {
       if (module->request_startup_func) {
          module_request_startup_handlers[startup_count++] = module;
       }
@@ -1973,6 +1967,7 @@ ZEND_API void zend_collect_module_handlers(void) /* {{{ */
          module_post_deactivate_handlers[--post_deactivate_count] = module;
       }
    } ZEND_HASH_FOREACH_END();
+   zend_rcu_read_unlock();
 
    /* Collect internal classes with static members */
    ZEND_HASH_FOREACH_PTR(CG(class_table), ce) {
@@ -2000,8 +1995,19 @@ ZEND_API void zend_collect_module_handlers(void) /* {{{ */
 
 ZEND_API int zend_startup_modules(void) /* {{{ */
 {
-   zend_hash_sort_ex(&module_registry, zend_sort_modules, NULL, 0);
-   zend_hash_apply(&module_registry, zend_startup_module_zval);
+   zend_string *key;
+   zend_module_entry *module;
+
+   zend_rcu_hash_sort(&module_registry, zend_sort_modules, NULL, 0);
+   /* started from a read section rather than an apply, a module startup
+    * may look modules up or register one of its own */
+   zend_rcu_read_lock();
+   ZEND_HASH_FOREACH_STR_KEY_PTR(RCU_HASH(&module_registry), key, module) {
+      if (zend_startup_module_ex(module) == FAILURE) {
+         zend_rcu_hash_del(&module_registry, key);
+      }
+   } ZEND_HASH_FOREACH_END();
+   zend_rcu_read_unlock();
    return SUCCESS;
 }
 /* }}} */
@@ -2010,7 +2016,7 @@ ZEND_API void zend_destroy_modules(void) /* {{{ */
 {
    free(class_cleanup_handlers);
    free(module_request_startup_handlers);
-   zend_hash_graceful_reverse_destroy(&module_registry);
+   zend_rcu_hash_graceful_reverse_destroy(&module_registry);
 }
 /* }}} */
 
@@ -2038,7 +2044,7 @@ ZEND_API zend_module_entry* zend_register_module_ex(zend_module_entry *module) /
             lcname = zend_string_alloc(name_len, 0);
             zend_str_tolower_copy(ZSTR_VAL(lcname), dep->name, name_len);
 
-            if (zend_hash_exists(&module_registry, lcname) || zend_get_extension(dep->name)) {
+            if (zend_rcu_hash_exists(&module_registry, lcname) || zend_get_extension(dep->name)) {
                zend_string_efree(lcname);
                /* TODO: Check version relationship */
                zend_error(E_CORE_WARNING, "Cannot load module '%s' because conflicting module '%s' is already loaded", module->name, dep->name);
@@ -2055,7 +2061,7 @@ ZEND_API zend_module_entry* zend_register_module_ex(zend_module_entry *module) /
    zend_str_tolower_copy(ZSTR_VAL(lcname), module->name, name_len);
 
    lcname = zend_new_interned_string(lcname);
-   if ((module_ptr = zend_hash_add_mem(&module_registry, lcname, module, sizeof(zend_module_entry))) == NULL) {
+   if ((module_ptr = zend_rcu_hash_add_mem(&module_registry, lcname, module, sizeof(zend_module_entry))) == NULL) {
       zend_error(E_CORE_WARNING, "Module '%s' already loaded", module->name);
       zend_string_release_ex(lcname, 1);
       return NULL;
@@ -2064,7 +2070,7 @@ ZEND_API zend_module_entry* zend_register_module_ex(zend_module_entry *module) /
    EG(current_module) = module;
 
    if (module->functions && zend_register_functions(NULL, module->functions, NULL, module->type)==FAILURE) {
-      zend_hash_del(&module_registry, lcname);
+      zend_rcu_hash_del(&module_registry, lcname);
       zend_string_release_ex(lcname, 1);
       EG(current_module) = NULL;
       zend_error(E_CORE_WARNING,"%s: Unable to register functions, unable to load", module->name);
@@ -2178,6 +2184,7 @@ ZEND_API int zend_register_functions(zend_class_entry *scope, const zend_functio
    if (!target_function_table) {
       target_function_table = CG(function_table);
    }
+   zend_resolve_cache_invalidate();
    internal_function->type = ZEND_INTERNAL_FUNCTION;
    internal_function->module = EG(current_module);
    memset(internal_function->reserved, 0, ZEND_MAX_RESERVED_RESOURCES * sizeof(void*));
@@ -2508,6 +2515,7 @@ ZEND_API void zend_unregister_functions(const zend_function_entry *functions, in
    if (!target_function_table) {
       target_function_table = CG(function_table);
    }
+   zend_resolve_cache_invalidate();
    while (ptr->fname) {
       if (count!=-1 && i>=count) {
          break;
@@ -2536,7 +2544,7 @@ ZEND_API int zend_get_module_started(const char *module_name) /* {{{ */
 {
    zend_module_entry *module;
 
-   module = zend_hash_str_find_ptr(&module_registry, module_name, strlen(module_name));
+   module = zend_rcu_hash_str_find_ptr(&module_registry, module_name, strlen(module_name));
    return (module && module->module_started) ? SUCCESS : FAILURE;
 }
 /* }}} */
@@ -2617,28 +2625,22 @@ ZEND_API void zend_activate_modules(void) /* {{{ */
 }
 /* }}} */
 
-/* call request shutdown for all modules */
-static int module_registry_cleanup(zval *zv) /* {{{ */
-{
-   zend_module_entry *module = Z_PTR_P(zv);
-
-   if (module->request_shutdown_func) {
-#if 0
-      zend_printf("%s: Request shutdown\n", module->name);
-#endif
-      module->request_shutdown_func(module->type, module->module_number);
-   }
-   return 0;
-}
-/* }}} */
-
 ZEND_API void zend_deactivate_modules(void) /* {{{ */
 {
    EG(current_execute_data) = NULL; /* we're no longer executing anything */
 
+   /* left after zend_end_try(), a bailout must not keep the section open */
+   zend_rcu_read_lock();
    zend_try {
       if (EG(full_tables_cleanup)) {
-         zend_hash_reverse_apply(&module_registry, module_registry_cleanup);
+         zend_module_entry *module;
+
+         /* call request shutdown for all modules */
+         ZEND_HASH_REVERSE_FOREACH_PTR(RCU_HASH(&module_registry), module) {
+            if (module->request_shutdown_func) {
+               module->request_shutdown_func(module->type, module->module_number);
+            }
+         } ZEND_HASH_FOREACH_END();
       } else {
          zend_module_entry **p = module_request_shutdown_handlers;
 
@@ -2650,6 +2652,7 @@ ZEND_API void zend_deactivate_modules(void) /* {{{ */
          }
       }
    } zend_end_try();
+   zend_rcu_read_unlock();
 }
 /* }}} */
 
@@ -2677,21 +2680,28 @@ static int module_registry_unload_temp_wrapper(zval *el) /* {{{ */
 }
 /* }}} */
 
-static int exec_done_cb(zval *el) /* {{{ */
-{
-   zend_module_entry *module = (zend_module_entry *)Z_PTR_P(el);
-   if (module->post_deactivate_func) {
-      module->post_deactivate_func();
-   }
-   return 0;
-}
-/* }}} */
-
 ZEND_API void zend_post_deactivate_modules(void) /* {{{ */
 {
    if (EG(full_tables_cleanup)) {
-      zend_hash_apply(&module_registry, exec_done_cb);
-      zend_hash_reverse_apply(&module_registry, module_registry_unload_temp_wrapper);
+      zend_module_entry *module;
+      zend_bool has_temporary = 0;
+
+      zend_rcu_read_lock();
+      ZEND_HASH_FOREACH_PTR(RCU_HASH(&module_registry), module) {
+         if (module->post_deactivate_func) {
+            module->post_deactivate_func();
+         }
+      } ZEND_HASH_FOREACH_END();
+      /* temporary modules are registered last, only copy the table when
+       * there is one to drop */
+      ZEND_HASH_REVERSE_FOREACH_PTR(RCU_HASH(&module_registry), module) {
+         has_temporary = module->type == MODULE_TEMPORARY;
+         break;
+      } ZEND_HASH_FOREACH_END();
+      zend_rcu_read_unlock();
+      if (has_temporary) {
+         zend_rcu_hash_reverse_apply(&module_registry, module_registry_unload_temp_wrapper);
+      }
    } else {
       zend_module_entry **p = module_post_deactivate_handlers;
 
@@ -2708,7 +2718,7 @@ ZEND_API void zend_post_deactivate_modules(void) /* {{{ */
 /* return the next free module number */
 ZEND_API int zend_next_free_module(void) /* {{{ */
 {
-   return zend_hash_num_elements(&module_registry) + 1;
+   return zend_rcu_hash_num_elements(&module_registry) + 1;
 }
 /* }}} */
 
@@ -3669,7 +3679,7 @@ ZEND_API const char *zend_get_module_version(const char *module_name) /* {{{ */
 
    lname = zend_string_alloc(name_len, 0);
    zend_str_tolower_copy(ZSTR_VAL(lname), module_name, name_len);
-   module = zend_hash_find_ptr(&module_registry, lname);
+   module = zend_rcu_hash_find_ptr(&module_registry, lname);
    zend_string_efree(lname);
    return module ? module->version : NULL;
 }
@@ -169,6 +169,24 @@ typedef struct _zend_fcall_info_cache {
 #define ZEND_MODULE_GLOBALS_BULK(module_name) TSRMG_BULK(module_name##_globals_id, zend_##module_name##_globals *)
 #endif
 
+/* globals of a module linked into the core kept in an initial-exec thread
+ * local, the accessor is a load relative to the thread pointer. the module
+ * has to be initialized in the file that declares its globals */
+#define ZEND_DECLARE_STATIC_MODULE_GLOBALS(module_name)						\
+   ts_rsrc_id module_name##_globals_id;										\
+   TSRM_TLS_IE zend_##module_name##_globals module_name##_globals_static;	\
+   static void *module_name##_globals_locator(void)						\
+   {																		\
+      return &module_name##_globals_static;									\
+   }
+#define ZEND_EXTERN_STATIC_MODULE_GLOBALS(module_name)						\
+   extern ts_rsrc_id module_name##_globals_id;								\
+   extern TSRM_TLS_IE zend_##module_name##_globals module_name##_globals_static;
+#define ZEND_INIT_STATIC_MODULE_GLOBALS(module_name, globals_ctor, globals_dtor)	\
+   ts_allocate_static_id(&module_name##_globals_id, sizeof(zend_##module_name##_globals), (ts_allocate_ctor) globals_ctor, (ts_allocate_dtor) globals_dtor, module_name##_globals_locator);
+#define ZEND_STATIC_MODULE_GLOBALS_ACCESSOR(module_name, v) (module_name##_globals_static.v)
+#define ZEND_STATIC_MODULE_GLOBALS_BULK(module_name) (&module_name##_globals_static)
+
 #else
 
 #define ZEND_DECLARE_MODULE_GLOBALS(module_name)							\
@@ -180,6 +198,12 @@ typedef struct _zend_fcall_info_cache {
 #define ZEND_MODULE_GLOBALS_ACCESSOR(module_name, v) (module_name##_globals.v)
 #define ZEND_MODULE_GLOBALS_BULK(module_name) (&module_name##_globals)
 
+#define ZEND_DECLARE_STATIC_MODULE_GLOBALS(module_name) ZEND_DECLARE_MODULE_GLOBALS(module_name)
+#define ZEND_EXTERN_STATIC_MODULE_GLOBALS(module_name) ZEND_EXTERN_MODULE_GLOBALS(module_name)
+#define ZEND_INIT_STATIC_MODULE_GLOBALS(module_name, globals_ctor, globals_dtor) ZEND_INIT_MODULE_GLOBALS(module_name, globals_ctor, globals_dtor)
+#define ZEND_STATIC_MODULE_GLOBALS_ACCESSOR(module_name, v) ZEND_MODULE_GLOBALS_ACCESSOR(module_name, v)
+#define ZEND_STATIC_MODULE_GLOBALS_BULK(module_name) ZEND_MODULE_GLOBALS_BULK(module_name)
+
 #endif
 
 #define INIT_CLASS_ENTRY(class_container, class_name, functions) \
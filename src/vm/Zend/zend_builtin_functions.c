@@ -2009,9 +2009,8 @@ ZEND_FUNCTION(get_resource_type)
 ZEND_FUNCTION(get_resources)
 {
 	zend_string *type = NULL;
-	zend_string *key;
-	zend_ulong index;
-	zval *val;
+	zend_resource *res;
+	zval tmp;
 
 	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|S", &type) == FAILURE) {
 		return;
@@ -2019,20 +2018,20 @@ ZEND_FUNCTION(get_resources)
 
 	if (!type) {
 		array_init(return_value);
-		ZEND_HASH_FOREACH_KEY_VAL(&EG(regular_list), index, key, val) {
-			if (!key) {
-				Z_ADDREF_P(val);
-				zend_hash_index_add_new(Z_ARRVAL_P(return_value), index, val);
-			}
-		} ZEND_HASH_FOREACH_END();
+		ZEND_LIST_FOREACH(res) {
+			GC_ADDREF(res);
+			ZVAL_RES(&tmp, res);
+			zend_hash_index_add_new(Z_ARRVAL_P(return_value), res->handle, &tmp);
+		} ZEND_LIST_FOREACH_END();
 	} else if (zend_string_equals_literal(type, "Unknown")) {
 		array_init(return_value);
-		ZEND_HASH_FOREACH_KEY_VAL(&EG(regular_list), index, key, val) {
-			if (!key && Z_RES_TYPE_P(val) <= 0) {
-				Z_ADDREF_P(val);
-				zend_hash_index_add_new(Z_ARRVAL_P(return_value), index, val);
+		ZEND_LIST_FOREACH(res) {
+			if (res->type <= 0) {
+				GC_ADDREF(res);
+				ZVAL_RES(&tmp, res);
+				zend_hash_index_add_new(Z_ARRVAL_P(return_value), res->handle, &tmp);
 			}
-		} ZEND_HASH_FOREACH_END();
+		} ZEND_LIST_FOREACH_END();
 	} else {
 		int id = zend_fetch_list_dtor_id(ZSTR_VAL(type));
 
@@ -2042,25 +2041,17 @@ ZEND_FUNCTION(get_resources)
 		}
 
 		array_init(return_value);
-		ZEND_HASH_FOREACH_KEY_VAL(&EG(regular_list), index, key, val) {
-			if (!key && Z_RES_TYPE_P(val) == id) {
-				Z_ADDREF_P(val);
-				zend_hash_index_add_new(Z_ARRVAL_P(return_value), index, val);
+		ZEND_LIST_FOREACH(res) {
+			if (res->type == id) {
+				GC_ADDREF(res);
+				ZVAL_RES(&tmp, res);
+				zend_hash_index_add_new(Z_ARRVAL_P(return_value), res->handle, &tmp);
 			}
-		} ZEND_HASH_FOREACH_END();
+		} ZEND_LIST_FOREACH_END();
 	}
 }
 /* }}} */
 
-static int add_extension_info(zval *item, void *arg) /* {{{ */
-{
-	zval *name_array = (zval *)arg;
-	zend_module_entry *module = (zend_module_entry*)Z_PTR_P(item);
-	add_next_index_string(name_array, module->name);
-	return 0;
-}
-/* }}} */
-
 static int add_zendext_info(zend_extension *ext, void *arg) /* {{{ */
 {
 	zval *name_array = (zval *)arg;
@@ -2101,7 +2092,13 @@ ZEND_FUNCTION(get_loaded_extensions)
 	if (zendext) {
 		zend_llist_apply_with_argument(&zend_extensions, (llist_apply_with_arg_func_t)add_zendext_info, return_value);
 	} else {
-		zend_hash_apply_with_argument(&module_registry, add_extension_info, return_value);
+		zend_module_entry *module;
+
+		zend_rcu_read_lock();
+		ZEND_HASH_FOREACH_PTR(RCU_HASH(&module_registry), module) {
+			add_next_index_string(return_value, module->name);
+		} ZEND_HASH_FOREACH_END();
+		zend_rcu_read_unlock();
 	}
 }
 /* }}} */
@@ -2124,16 +2121,21 @@ ZEND_FUNCTION(get_defined_constants)
 		zval *modules, const_val;
 		char **module_names;
 		zend_module_entry *module;
+		HashTable *registry;
 		int i = 1;
 
-		modules = ecalloc(zend_hash_num_elements(&module_registry) + 2, sizeof(zval));
-		module_names = emalloc((zend_hash_num_elements(&module_registry) + 2) * sizeof(char *));
+		/* the count and the names come from one snapshot */
+		zend_rcu_read_lock();
+		registry = RCU_HASH(&module_registry);
+		modules = ecalloc(zend_hash_num_elements(registry) + 2, sizeof(zval));
+		module_names = emalloc((zend_hash_num_elements(registry) + 2) * sizeof(char *));
 
 		module_names[0] = "internal";
-		ZEND_HASH_FOREACH_PTR(&module_registry, module) {
+		ZEND_HASH_FOREACH_PTR(registry, module) {
 			module_names[module->module_number] = (char *)module->name;
 			i++;
 		} ZEND_HASH_FOREACH_END();
+		zend_rcu_read_unlock();
 		module_names[i] = "user";
 
 		ZEND_HASH_FOREACH_PTR(EG(zend_constants), val) {
@@ -2695,7 +2697,7 @@ ZEND_FUNCTION(extension_loaded)
 	}
 
 	lcname = zend_string_tolower(extension_name);
-	if (zend_hash_exists(&module_registry, lcname)) {
+	if (zend_rcu_hash_exists(&module_registry, lcname)) {
 		RETVAL_TRUE;
 	} else {
 		RETVAL_FALSE;
@@ -2719,10 +2721,10 @@ ZEND_FUNCTION(get_extension_funcs)
 	}
 	if (strncasecmp(ZSTR_VAL(extension_name), "zend", sizeof("zend"))) {
 		lcname = zend_string_tolower(extension_name);
-		module = zend_hash_find_ptr(&module_registry, lcname);
+		module = zend_rcu_hash_find_ptr(&module_registry, lcname);
 		zend_string_release_ex(lcname, 0);
 	} else {
-		module = zend_hash_str_find_ptr(&module_registry, "core", sizeof("core") - 1);
+		module = zend_rcu_hash_str_find_ptr(&module_registry, "core", sizeof("core") - 1);
 	}
 
 	if (!module) {
@@ -44,6 +44,54 @@ typedef struct _zend_closure {
 ZEND_API zend_class_entry *zend_ce_closure;
 static zend_object_handlers closure_handlers;
 
+/* Closures of one declaration share its static variables table until one
+ * of them writes to it, writers separate it first. A shared table is not
+ * reported to the GC, which would otherwise visit it once per closure, so
+ * only tables that cannot hold a cycle are shared. */
+static zend_bool zend_closure_can_share_static_vars(HashTable *ht) /* {{{ */
+{
+	zval *val;
+
+	if (GC_FLAGS(ht) & IS_ARRAY_IMMUTABLE) {
+		return 1;
+	}
+	ZEND_HASH_FOREACH_VAL(ht, val) {
+		if (Z_REFCOUNTED_P(val)
+		 && Z_TYPE_P(val) != IS_STRING
+		 && Z_TYPE_P(val) != IS_CONSTANT_AST) {
+			return 0;
+		}
+	} ZEND_HASH_FOREACH_END();
+	return 1;
+}
+/* }}} */
+
+static HashTable *zend_closure_separate_static_vars(zend_closure *closure) /* {{{ */
+{
+	HashTable *ht = closure->func.op_array.static_variables;
+
+	if (GC_REFCOUNT(ht) > 1) {
+		if (!(GC_FLAGS(ht) & IS_ARRAY_IMMUTABLE)) {
+			GC_DELREF(ht);
+		}
+		closure->func.op_array.static_variables = ht = zend_array_dup(ht);
+	}
+	return ht;
+}
+/* }}} */
+
+/* Private runtime caches are allocated on the first call, see
+ * init_func_run_time_cache(). */
+static void zend_closure_init_run_time_cache(zend_closure *closure) /* {{{ */
+{
+	if (!closure->func.op_array.run_time_cache) {
+		ZEND_ASSERT(closure->func.op_array.fn_flags & ZEND_ACC_NO_RT_ARENA);
+		closure->func.op_array.run_time_cache = emalloc(closure->func.op_array.cache_size);
+		memset(closure->func.op_array.run_time_cache, 0, closure->func.op_array.cache_size);
+	}
+}
+/* }}} */
+
 ZEND_METHOD(Closure, __invoke) /* {{{ */
 {
 	zend_function *func = EX(func);
@@ -137,6 +185,15 @@ ZEND_METHOD(Closure, call)
 		closure = (zend_closure *) Z_OBJ(new_closure);
 		fci_cache.function_handler = &closure->func;
 	} else {
+		if (ZEND_USER_CODE(closure->func.type)) {
+			/* the copy below must not separate or allocate on its own */
+			if (closure->func.op_array.static_variables) {
+				zend_closure_separate_static_vars(closure);
+			}
+			if (closure->func.common.scope == Z_OBJCE_P(newthis)) {
+				zend_closure_init_run_time_cache(closure);
+			}
+		}
 		memcpy(&my_function, &closure->func, closure->func.type == ZEND_USER_FUNCTION ? sizeof(zend_op_array) : sizeof(zend_internal_function));
 		my_function.common.fn_flags &= ~ZEND_ACC_CLOSURE;
 		/* use scope of passed object */
@@ -431,7 +488,8 @@ static void zend_closure_free_storage(zend_object *object) /* {{{ */
 	zend_object_std_dtor(&closure->std);
 
 	if (closure->func.type == ZEND_USER_FUNCTION) {
-		if (closure->func.op_array.fn_flags & ZEND_ACC_NO_RT_ARENA) {
+		if ((closure->func.op_array.fn_flags & ZEND_ACC_NO_RT_ARENA)
+		 && closure->func.op_array.run_time_cache) {
 			efree(closure->func.op_array.run_time_cache);
 			closure->func.op_array.run_time_cache = NULL;
 		}
@@ -555,8 +613,13 @@ static HashTable *zend_closure_get_gc(zval *obj, zval **table, int *n) /* {{{ */
 
 	*table = Z_TYPE(closure->this_ptr) != IS_NULL ? &closure->this_ptr : NULL;
 	*n = Z_TYPE(closure->this_ptr) != IS_NULL ? 1 : 0;
-	return (closure->func.type == ZEND_USER_FUNCTION) ?
-		closure->func.op_array.static_variables : NULL;
+	if (closure->func.type != ZEND_USER_FUNCTION
+	 || !closure->func.op_array.static_variables
+	 || GC_REFCOUNT(closure->func.op_array.static_variables) > 1) {
+		/* shared tables hold no collectable values */
+		return NULL;
+	}
+	return closure->func.op_array.static_variables;
 }
 /* }}} */
 
@@ -652,8 +715,13 @@ ZEND_API void zend_create_closure(zval *res, zend_function *func, zend_class_ent
 		memcpy(&closure->func, func, sizeof(zend_op_array));
 		closure->func.common.fn_flags |= ZEND_ACC_CLOSURE;
 		if (closure->func.op_array.static_variables) {
-			closure->func.op_array.static_variables =
-				zend_array_dup(closure->func.op_array.static_variables);
+			HashTable *ht = closure->func.op_array.static_variables;
+
+			if (!zend_closure_can_share_static_vars(ht)) {
+				closure->func.op_array.static_variables = zend_array_dup(ht);
+			} else if (!(GC_FLAGS(ht) & IS_ARRAY_IMMUTABLE)) {
+				GC_ADDREF(ht);
+			}
 		}
 
 		/* Runtime cache is scope-dependent, so we cannot reuse it if the scope changed */
@@ -661,18 +729,19 @@ ZEND_API void zend_create_closure(zval *res, zend_function *func, zend_class_ent
 			|| func->common.scope != scope
 			|| (func->common.fn_flags & ZEND_ACC_NO_RT_ARENA)
 		) {
-			if (!func->op_array.run_time_cache && (func->common.fn_flags & ZEND_ACC_CLOSURE)) {
+			if (!func->op_array.run_time_cache
+			 && (func->common.fn_flags & (ZEND_ACC_CLOSURE|ZEND_ACC_NO_RT_ARENA)) == ZEND_ACC_CLOSURE) {
 				/* If a real closure is used for the first time, we create a shared runtime cache
 				 * and remember which scope it is for. */
 				func->common.scope = scope;
 				func->op_array.run_time_cache = zend_arena_alloc(&CG(arena), func->op_array.cache_size);
+				memset(func->op_array.run_time_cache, 0, func->op_array.cache_size);
 				closure->func.op_array.run_time_cache = func->op_array.run_time_cache;
 			} else {
-				/* Otherwise, we use a non-shared runtime cache */
-				closure->func.op_array.run_time_cache = emalloc(func->op_array.cache_size);
+				/* Otherwise, we use a non-shared runtime cache, allocated on the first call */
+				closure->func.op_array.run_time_cache = NULL;
 				closure->func.op_array.fn_flags |= ZEND_ACC_NO_RT_ARENA;
 			}
-			memset(closure->func.op_array.run_time_cache, 0, func->op_array.cache_size);
 		}
 		if (closure->func.op_array.refcount) {
 			(*closure->func.op_array.refcount)++;
@@ -725,7 +794,7 @@ ZEND_API void zend_create_fake_closure(zval *res, zend_function *func, zend_clas
 void zend_closure_bind_var(zval *closure_zv, zend_string *var_name, zval *var) /* {{{ */
 {
 	zend_closure *closure = (zend_closure *) Z_OBJ_P(closure_zv);
-	HashTable *static_variables = closure->func.op_array.static_variables;
+	HashTable *static_variables = zend_closure_separate_static_vars(closure);
 	zend_hash_update(static_variables, var_name, var);
 }
 /* }}} */
@@ -733,7 +802,7 @@ void zend_closure_bind_var(zval *closure_zv, zend_string *var_name, zval *var) /
 void zend_closure_bind_var_ex(zval *closure_zv, uint32_t offset, zval *val) /* {{{ */
 {
 	zend_closure *closure = (zend_closure *) Z_OBJ_P(closure_zv);
-	HashTable *static_variables = closure->func.op_array.static_variables;
+	HashTable *static_variables = zend_closure_separate_static_vars(closure);
 	zval *var = (zval*)((char*)static_variables->arData + offset);
 	zval_ptr_dtor(var);
 	ZVAL_COPY_VALUE(var, val);
@@ -31,6 +31,7 @@
 #include "zend_language_scanner.h"
 #include "zend_inheritance.h"
 #include "zend_vm.h"
+#include "zend_resolve_cache.h"
 
 #define SET_NODE(target, src) do { \
 		target ## _type = (src)->op_type; \
@@ -376,6 +377,11 @@ void init_compiler(void) /* {{{ */
 
 void shutdown_compiler(void) /* {{{ */
 {
+	if (EG(flags) & EG_FLAGS_FAST_RESET) {
+		/* the stacks, the arena and the file names all live in the request
+		 * heap, zend_mm drops them together with it */
+		return;
+	}
 	zend_stack_destroy(&CG(loop_var_stack));
 	zend_stack_destroy(&CG(delayed_oplines_stack));
 	zend_hash_destroy(&CG(filenames_table));
@@ -1072,6 +1078,7 @@ ZEND_API int do_bind_function(const zend_op_array *op_array, const zend_op *opli
 		if (!(function->op_array.fn_flags & ZEND_ACC_IMMUTABLE)) {
 			function->op_array.static_variables = NULL; /* NULL out the unbound function */
 		}
+		zend_resolve_cache_forget_function(Z_STR_P(lcname));
 		return SUCCESS;
 	}
 }
@@ -25,6 +25,7 @@
 #include "zend_operators.h"
 #include "zend_globals.h"
 #include "zend_API.h"
+#include "zend_resolve_cache.h"
 
 /* Protection from recursive self-referencing class constants */
 #define IS_CONSTANT_VISITED_MARK    0x80
@@ -92,6 +93,7 @@ static int clean_module_constant(zval *el, void *arg)
 
 void clean_module_constants(int module_number)
 {
+	zend_resolve_cache_invalidate();
 	zend_hash_apply_with_argument(EG(zend_constants), clean_module_constant, (void *) &module_number);
 }
 
@@ -427,25 +429,37 @@ failure:
 		lcname[prefix_len] = '\\';
 		memcpy(lcname + prefix_len + 1, constant_name, const_name_len + 1);
 
-		if ((c = zend_hash_str_find_ptr(EG(zend_constants), lcname, lcname_len)) == NULL) {
-			/* try lowercase */
-			zend_str_tolower(lcname + prefix_len + 1, const_name_len);
-			if ((c = zend_hash_str_find_ptr(EG(zend_constants), lcname, lcname_len)) != NULL) {
-				if ((ZEND_CONSTANT_FLAGS(c) & CONST_CS) != 0) {
-					c = NULL;
+		if ((flags & IS_CONSTANT_UNQUALIFIED)
+		 && (c = zend_resolve_cache_find_constant(lcname, lcname_len)) != NULL) {
+			free_alloca(lcname, use_heap);
+			name = constant_name;
+		} else {
+			if ((c = zend_hash_str_find_ptr(EG(zend_constants), lcname, lcname_len)) == NULL) {
+				/* try lowercase */
+				zend_str_tolower(lcname + prefix_len + 1, const_name_len);
+				if ((c = zend_hash_str_find_ptr(EG(zend_constants), lcname, lcname_len)) != NULL) {
+					if ((ZEND_CONSTANT_FLAGS(c) & CONST_CS) != 0) {
+						c = NULL;
+					}
 				}
 			}
-		}
-		free_alloca(lcname, use_heap);
 
-		if (!c) {
-			if (!(flags & IS_CONSTANT_UNQUALIFIED)) {
-				return NULL;
-			}
+			if (!c) {
+				if (!(flags & IS_CONSTANT_UNQUALIFIED)) {
+					free_alloca(lcname, use_heap);
+					return NULL;
+				}
 
-			/* name requires runtime resolution, need to check non-namespaced name */
-			c = zend_get_constant_str_impl(constant_name, const_name_len);
-			name = constant_name;
+				/* name requires runtime resolution, need to check non-namespaced name */
+				c = zend_get_constant_str_impl(constant_name, const_name_len);
+				name = constant_name;
+				if (c && (ZEND_CONSTANT_FLAGS(c) & (CONST_PERSISTENT|CONST_CS)) == (CONST_PERSISTENT|CONST_CS)) {
+					/* the cache is keyed by the name as first looked up */
+					memcpy(lcname + prefix_len + 1, constant_name, const_name_len);
+					zend_resolve_cache_add_constant(lcname, lcname_len, c);
+				}
+			}
+			free_alloca(lcname, use_heap);
 		}
 	} else {
 		if (cname) {
@@ -524,6 +538,10 @@ ZEND_API int zend_register_constant(zend_constant *c)
 			zval_ptr_dtor_nogc(&c->value);
 		}
 		ret = FAILURE;
+	} else if (ZEND_CONSTANT_FLAGS(c) & CONST_PERSISTENT) {
+		zend_resolve_cache_invalidate();
+	} else {
+		zend_resolve_cache_forget_constant(c, name);
 	}
 	if (lowercase_name) {
 		zend_string_release(lowercase_name);
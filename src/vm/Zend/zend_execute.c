@@ -39,6 +39,7 @@
 #include "zend_dtrace.h"
 #include "zend_inheritance.h"
 #include "zend_type_info.h"
+#include "zend_resolve_cache.h"
 
 /* Virtual current working directory support */
 #include "zend_virtual_cwd.h"
@@ -2502,7 +2503,12 @@ static zend_always_inline void i_init_func_execute_data(zend_op_array *op_array,
 static zend_never_inline void ZEND_FASTCALL init_func_run_time_cache(zend_op_array *op_array) /* {{{ */
 {
 	ZEND_ASSERT(op_array->run_time_cache == NULL);
-	op_array->run_time_cache = zend_arena_alloc(&CG(arena), op_array->cache_size);
+	if (UNEXPECTED(op_array->fn_flags & ZEND_ACC_NO_RT_ARENA)) {
+		/* a closure's private cache, freed with the closure */
+		op_array->run_time_cache = emalloc(op_array->cache_size);
+	} else {
+		op_array->run_time_cache = zend_arena_alloc(&CG(arena), op_array->cache_size);
+	}
 	memset(op_array->run_time_cache, 0, op_array->cache_size);
 }
 /* }}} */
@@ -3284,8 +3290,12 @@ static zend_always_inline int _zend_quick_get_constant(
 	const zval *orig_key = key;
 	zend_constant *c = NULL;
 
-	zv = zend_hash_find_ex(EG(zend_constants), Z_STR_P(key), 1);
-	if (zv) {
+	if ((flags & (IS_CONSTANT_IN_NAMESPACE|IS_CONSTANT_UNQUALIFIED)) == (IS_CONSTANT_IN_NAMESPACE|IS_CONSTANT_UNQUALIFIED)) {
+		c = zend_resolve_cache_find_constant(Z_STRVAL_P(key), Z_STRLEN_P(key));
+	}
+	if (c) {
+		/* a persistent case-sensitive global constant */
+	} else if ((zv = zend_hash_find_ex(EG(zend_constants), Z_STR_P(key), 1)) != NULL) {
 		c = (zend_constant*)Z_PTR_P(zv);
 	} else {
 		key++;
@@ -3298,6 +3308,9 @@ static zend_always_inline int _zend_quick_get_constant(
 				zv = zend_hash_find_ex(EG(zend_constants), Z_STR_P(key), 1);
 				if (zv) {
 					c = (zend_constant*)Z_PTR_P(zv);
+					if ((ZEND_CONSTANT_FLAGS(c) & (CONST_PERSISTENT|CONST_CS)) == (CONST_PERSISTENT|CONST_CS)) {
+						zend_resolve_cache_add_constant(Z_STRVAL_P(orig_key), Z_STRLEN_P(orig_key), c);
+					}
 				} else {
 				    key++;
 					zv = zend_hash_find_ex(EG(zend_constants), Z_STR_P(key), 1);
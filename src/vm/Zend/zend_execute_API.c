@@ -33,6 +33,7 @@
 #include "zend_generators.h"
 #include "zend_vm.h"
 #include "zend_float.h"
+#include "zend_resolve_cache.h"
 #ifdef HAVE_SYS_TIME_H
 #include <sys/time.h>
 #endif
@@ -251,19 +252,24 @@ void shutdown_executor(void) /* {{{ */
 {
 	zend_string *key;
 	zval *zv;
+	zend_bool fast_reset = (EG(flags) & EG_FLAGS_FAST_RESET) != 0;
 #if ZEND_DEBUG
-	zend_bool fast_shutdown = 0;
+	/* a fast reset does not report leaks, so debug builds may take it too */
+	zend_bool fast_shutdown = fast_reset;
 #else
-	zend_bool fast_shutdown = is_zend_mm() && !EG(full_tables_cleanup);
+	zend_bool fast_shutdown = fast_reset || (is_zend_mm() && !EG(full_tables_cleanup));
 #endif
 
 	zend_try {
 		zend_llist_destroy(&CG(open_files));
 	} zend_end_try();
 
-	zend_try {
-		zend_close_rsrc_list(&EG(regular_list));
-	} zend_end_try();
+	/* a fast reset is only taken with an empty resource list */
+	if (!fast_reset) {
+		zend_try {
+			zend_close_rsrc_list(&EG(regular_list));
+		} zend_end_try();
+	}
 
 	zend_objects_store_free_object_storage(&EG(objects_store), fast_shutdown);
 
@@ -313,6 +319,8 @@ void shutdown_executor(void) /* {{{ */
 		zend_vm_stack_destroy();
 
 		if (EG(full_tables_cleanup)) {
+			/* drops the functions and constants of dl() loaded modules */
+			zend_resolve_cache_invalidate();
 			zend_hash_reverse_apply(EG(zend_constants), clean_non_persistent_constant_full);
 			zend_hash_reverse_apply(EG(function_table), clean_non_persistent_function_full);
 			zend_hash_reverse_apply(EG(class_table), clean_non_persistent_class_full);
@@ -64,6 +64,22 @@ END_EXTERN_C()
 typedef struct _zend_vm_stack *zend_vm_stack;
 typedef struct _zend_ini_entry zend_ini_entry;
 
+typedef struct _zend_resource_slot zend_resource_slot;
+typedef struct _zend_resource_kind zend_resource_kind;
+
+/* the request's resources, see zend_list.h */
+typedef struct _zend_resource_table {
+	zend_resource_slot **chunks;
+	zend_resource_kind *kinds;
+	uint32_t num_chunks;
+	uint32_t num_kinds;
+	uint32_t num_used;
+	uint32_t num_live;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t epoch;
+	int next_handle;
+} zend_resource_table;
 
 struct _zend_compiler_globals {
 	zend_stack loop_var_stack;
@@ -181,9 +197,15 @@ struct _zend_executor_globals {
 	OSVERSIONINFOEX windows_version_info;
 #endif
 
-	HashTable regular_list;
+	zend_resource_table regular_list;
 	HashTable persistent_list;
 
+	/* cross-request name resolution, see zend_resolve_cache.h */
+	HashTable resolved_functions;
+	HashTable resolved_constants;
+	uint32_t resolve_epoch;
+	zend_bool resolve_cache;
+
 	int user_error_handler_error_reporting;
 	zval user_error_handler;
 	zval user_exception_handler;
@@ -235,6 +257,9 @@ struct _zend_executor_globals {
 
 #define EG_FLAGS_INITIAL	0x00
 #define EG_FLAGS_IN_SHUTDOWN	0x01
+/* the request left nothing behind that needs an orderly teardown, the
+ * request heap is dropped as a whole by zend_mm */
+#define EG_FLAGS_FAST_RESET	0x02
 
 struct _zend_ini_scanner_globals {
 	zend_file_handle *yy_in;
@@ -300,6 +325,18 @@ struct _zend_php_scanner_globals {
 	void *on_event_context;
 };
 
+#ifdef ZTS
+/* the globals of the engine in one initial-exec thread local block, CG(),
+ * EG(), LANG_SCNG() and INI_SCNG() are a load at a fixed offset from the
+ * thread pointer instead of a walk through the TSRM storage array */
+struct _zend_static_globals {
+	zend_compiler_globals compiler;
+	zend_executor_globals executor;
+	zend_php_scanner_globals language_scanner;
+	zend_ini_scanner_globals ini_scanner;
+};
+#endif
+
 #endif /* ZEND_GLOBALS_H */
 
 /*
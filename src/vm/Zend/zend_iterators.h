@@ -50,6 +50,13 @@ typedef struct _zend_object_iterator_funcs {
 
 	/* invalidate current value/key (optional, may be NULL) */
 	void (*invalidate_current)(zend_object_iterator *iter);
+
+	/* move the current element out of the iterator instead of copying it
+	 * (optional, may be NULL). The value, never a reference, and the key,
+	 * unless key is NULL, are handed over with their references and are
+	 * gone from the iterator until it moves forward. Returns FAILURE, with
+	 * nothing written, when there is no current element. */
+	int (*take_current)(zend_object_iterator *iter, zval *value, zval *key);
 } zend_object_iterator_funcs;
 
 struct _zend_object_iterator {
@@ -453,6 +453,12 @@ static const zend_encoding* zend_multibyte_find_script_encoding(void)
 
 	/* if multiple encodings specified, detect automagically */
 	if (CG(script_encoding_list_size) > 1) {
+		/* a script that validates as UTF-8 when UTF-8 is the first
+		 * candidate is what the detector would return anyway */
+		if (CG(script_encoding_list)[0] == zend_multibyte_encoding_utf8
+			&& zend_utf8_validate(LANG_SCNG(script_org), LANG_SCNG(script_org_size)) == LANG_SCNG(script_org_size)) {
+			return zend_multibyte_encoding_utf8;
+		}
 		return zend_multibyte_encoding_detector(LANG_SCNG(script_org), LANG_SCNG(script_org_size), CG(script_encoding_list), CG(script_encoding_list_size));
 	}
 
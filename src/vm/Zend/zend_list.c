@@ -28,36 +28,154 @@ ZEND_API int le_index_ptr;
 
 /* true global */
 static HashTable list_destructors;
+/* list_destructors indexed by resource type, for the close path */
+static zend_rsrc_list_dtors_entry **list_dtors_by_type;
+static uint32_t list_dtors_size;
 
-ZEND_API zval* ZEND_FASTCALL zend_list_insert(void *ptr, int type)
+static zend_always_inline zend_rsrc_list_dtors_entry *zend_rsrc_list_dtors(int type)
 {
-	int index;
-	zval zv;
+	if (EXPECTED((uint32_t)type < list_dtors_size)) {
+		return list_dtors_by_type[type];
+	}
+	return NULL;
+}
+
+static zend_always_inline uint32_t zend_rsrc_kind_of(int type)
+{
+	return type > 0 ? (uint32_t)type : 0;
+}
+
+static zend_never_inline void zend_rsrc_grow_kinds(zend_resource_table *table, uint32_t kind)
+{
+	uint32_t size = table->num_kinds ? table->num_kinds * 2 : 16;
+	uint32_t i;
 
-	index = zend_hash_next_free_element(&EG(regular_list));
-	if (index == 0) {
-		index = 1;
+	while (size <= kind) {
+		size *= 2;
+	}
+	table->kinds = safe_erealloc(table->kinds, size, sizeof(zend_resource_kind), 0);
+	for (i = table->num_kinds; i < size; i++) {
+		table->kinds[i].free = ZEND_RSRC_INVALID;
+		table->kinds[i].head = ZEND_RSRC_INVALID;
+		table->kinds[i].tail = ZEND_RSRC_INVALID;
 	}
-	ZVAL_NEW_RES(&zv, index, ptr, type);
-	return zend_hash_index_add_new(&EG(regular_list), index, &zv);
+	table->num_kinds = size;
 }
 
-ZEND_API int ZEND_FASTCALL zend_list_delete(zend_resource *res)
+static zend_never_inline void zend_rsrc_add_chunk(zend_resource_table *table)
 {
-	if (GC_DELREF(res) <= 0) {
-		return zend_hash_index_del(&EG(regular_list), res->handle);
+	uint32_t chunk = table->num_used >> ZEND_RSRC_CHUNK_SHIFT;
+
+	if (chunk == table->num_chunks) {
+		table->num_chunks = table->num_chunks ? table->num_chunks * 2 : 4;
+		table->chunks = safe_erealloc(table->chunks, table->num_chunks, sizeof(zend_resource_slot *), 0);
+	}
+	table->chunks[chunk] = safe_emalloc(ZEND_RSRC_CHUNK_SIZE, sizeof(zend_resource_slot), 0);
+}
+
+static zend_always_inline zend_resource_slot *zend_rsrc_slot_alloc(zend_resource_table *table, uint32_t kind)
+{
+	zend_resource_kind *k;
+	zend_resource_slot *slot;
+
+	if (UNEXPECTED(kind >= table->num_kinds)) {
+		zend_rsrc_grow_kinds(table, kind);
+	}
+	k = &table->kinds[kind];
+	if (k->free != ZEND_RSRC_INVALID) {
+		slot = ZEND_RSRC_SLOT(table, k->free);
+		k->free = slot->next;
+		return slot;
+	}
+
+	if ((table->num_used & ZEND_RSRC_CHUNK_MASK) == 0) {
+		zend_rsrc_add_chunk(table);
+	}
+	slot = ZEND_RSRC_SLOT(table, table->num_used);
+	slot->slot = table->num_used++;
+	slot->generation = 0;
+	return slot;
+}
+
+static zend_always_inline void zend_rsrc_slot_link(zend_resource_table *table, zend_resource_slot *slot)
+{
+	zend_resource_kind *k = &table->kinds[slot->kind];
+
+	slot->next = ZEND_RSRC_INVALID;
+	slot->prev = table->tail;
+	if (table->tail != ZEND_RSRC_INVALID) {
+		ZEND_RSRC_SLOT(table, table->tail)->next = slot->slot;
 	} else {
-		return SUCCESS;
+		table->head = slot->slot;
 	}
+	table->tail = slot->slot;
+
+	slot->kind_next = ZEND_RSRC_INVALID;
+	slot->kind_prev = k->tail;
+	if (k->tail != ZEND_RSRC_INVALID) {
+		ZEND_RSRC_SLOT(table, k->tail)->kind_next = slot->slot;
+	} else {
+		k->head = slot->slot;
+	}
+	k->tail = slot->slot;
+	table->num_live++;
 }
 
-ZEND_API int ZEND_FASTCALL zend_list_free(zend_resource *res)
+static zend_always_inline void zend_rsrc_slot_unlink(zend_resource_table *table, zend_resource_slot *slot)
 {
-	if (GC_REFCOUNT(res) <= 0) {
-		return zend_hash_index_del(&EG(regular_list), res->handle);
+	zend_resource_kind *k = &table->kinds[slot->kind];
+
+	if (slot->prev != ZEND_RSRC_INVALID) {
+		ZEND_RSRC_SLOT(table, slot->prev)->next = slot->next;
 	} else {
-		return SUCCESS;
+		table->head = slot->next;
+	}
+	if (slot->next != ZEND_RSRC_INVALID) {
+		ZEND_RSRC_SLOT(table, slot->next)->prev = slot->prev;
+	} else {
+		table->tail = slot->prev;
+	}
+
+	if (slot->kind_prev != ZEND_RSRC_INVALID) {
+		ZEND_RSRC_SLOT(table, slot->kind_prev)->kind_next = slot->kind_next;
+	} else {
+		k->head = slot->kind_next;
 	}
+	if (slot->kind_next != ZEND_RSRC_INVALID) {
+		ZEND_RSRC_SLOT(table, slot->kind_next)->kind_prev = slot->kind_prev;
+	} else {
+		k->tail = slot->kind_prev;
+	}
+	table->num_live--;
+}
+
+static zend_always_inline void zend_rsrc_slot_release(zend_resource_table *table, zend_resource_slot *slot)
+{
+	zend_resource_kind *k = &table->kinds[slot->kind];
+
+	GC_TYPE_INFO(&slot->res) = IS_UNDEF;
+	slot->res.type = -1;
+	slot->res.ptr = NULL;
+	slot->generation++;
+	slot->next = k->free;
+	k->free = slot->slot;
+}
+
+ZEND_API zend_resource* ZEND_FASTCALL zend_list_insert(void *ptr, int type)
+{
+	zend_resource_table *table = &EG(regular_list);
+	uint32_t kind = zend_rsrc_kind_of(type);
+	zend_resource_slot *slot = zend_rsrc_slot_alloc(table, kind);
+	zend_resource *res = &slot->res;
+
+	GC_SET_REFCOUNT(res, 1);
+	GC_TYPE_INFO(res) = IS_RESOURCE | (IS_RSRC_IN_LIST << GC_FLAGS_SHIFT);
+	res->handle = table->next_handle++;
+	res->type = type;
+	res->ptr = ptr;
+	slot->kind = kind;
+	zend_rsrc_slot_link(table, slot);
+	return res;
 }
 
 static void zend_resource_dtor(zend_resource *res)
@@ -68,7 +186,7 @@ static void zend_resource_dtor(zend_resource *res)
 	res->type = -1;
 	res->ptr = NULL;
 
-	ld = zend_hash_index_find_ptr(&list_destructors, r.type);
+	ld = zend_rsrc_list_dtors(r.type);
 	if (ld) {
 		if (ld->list_dtor_ex) {
 			ld->list_dtor_ex(&r);
@@ -78,6 +196,48 @@ static void zend_resource_dtor(zend_resource *res)
 	}
 }
 
+static void zend_rsrc_slot_free(zend_resource_table *table, zend_resource_slot *slot)
+{
+	zend_rsrc_slot_unlink(table, slot);
+	if (slot->res.type >= 0) {
+		zend_resource_dtor(&slot->res);
+	}
+	zend_rsrc_slot_release(table, slot);
+}
+
+static zend_always_inline zend_bool zend_rsrc_in_table(zend_resource *res)
+{
+	/* not for persistent resources, resources made by ZVAL_NEW_RES() and
+	 * slots that were freed, the release clears the flag */
+	return (GC_FLAGS(res) & IS_RSRC_IN_LIST) != 0;
+}
+
+ZEND_API int ZEND_FASTCALL zend_list_delete(zend_resource *res)
+{
+	if (GC_DELREF(res) <= 0) {
+		return zend_list_free(res);
+	} else {
+		return SUCCESS;
+	}
+}
+
+ZEND_API int ZEND_FASTCALL zend_list_free(zend_resource *res)
+{
+	if (GC_REFCOUNT(res) <= 0) {
+		if (EXPECTED(zend_rsrc_in_table(res))) {
+			zend_rsrc_slot_free(&EG(regular_list), ZEND_RSRC_SLOT_OF(res));
+		} else if (!(GC_FLAGS(res) & GC_PERSISTENT) && GC_TYPE(res) == IS_RESOURCE) {
+			/* a standalone resource made by ZVAL_NEW_RES() */
+			if (res->type >= 0) {
+				zend_resource_dtor(res);
+			}
+			efree_size(res, sizeof(zend_resource));
+		} else {
+			return FAILURE;
+		}
+	}
+	return SUCCESS;
+}
 
 ZEND_API int ZEND_FASTCALL zend_list_close(zend_resource *res)
 {
@@ -89,13 +249,74 @@ ZEND_API int ZEND_FASTCALL zend_list_close(zend_resource *res)
 	return SUCCESS;
 }
 
-ZEND_API zend_resource* zend_register_resource(void *rsrc_pointer, int rsrc_type)
+/* Closes the live resources of a chain from its tail, the latest created
+ * first. Each one is held while its destructor runs, so the destructor
+ * may free any other resource, and is freed afterwards if that was the
+ * last reference. */
+static void zend_rsrc_close_chain(zend_resource_table *table, uint32_t idx, zend_bool by_kind)
 {
-	zval *zv;
+	while (idx != ZEND_RSRC_INVALID) {
+		zend_resource_slot *slot = ZEND_RSRC_SLOT(table, idx);
+
+		if (slot->res.type < 0) {
+			idx = by_kind ? slot->kind_prev : slot->prev;
+			continue;
+		}
+		GC_ADDREF(&slot->res);
+		zend_resource_dtor(&slot->res);
+		idx = by_kind ? slot->kind_prev : slot->prev;
+		if (GC_DELREF(&slot->res) == 0) {
+			zend_rsrc_slot_free(table, slot);
+		}
+	}
+}
+
+ZEND_API void zend_list_close_type(int type)
+{
+	zend_resource_table *table = &EG(regular_list);
 
-	zv = zend_list_insert(rsrc_pointer, rsrc_type);
+	if (type <= 0 || (uint32_t)type >= table->num_kinds) {
+		return;
+	}
+	zend_rsrc_close_chain(table, table->kinds[type].tail, 1);
+}
 
-	return Z_RES_P(zv);
+ZEND_API zend_resource_handle zend_list_handle(zend_resource *res)
+{
+	zend_resource_handle handle;
+
+	handle.epoch = EG(regular_list).epoch;
+	handle.type = res->type;
+	if (zend_rsrc_in_table(res)) {
+		handle.slot = ZEND_RSRC_SLOT_OF(res)->slot;
+		handle.generation = ZEND_RSRC_SLOT_OF(res)->generation;
+	} else {
+		handle.slot = ZEND_RSRC_INVALID;
+		handle.generation = 0;
+	}
+	return handle;
+}
+
+ZEND_API void *zend_list_handle_fetch(zend_resource_handle handle)
+{
+	zend_resource_table *table = &EG(regular_list);
+	zend_resource_slot *slot;
+
+	if (handle.epoch != table->epoch || handle.slot >= table->num_used) {
+		return NULL;
+	}
+	slot = ZEND_RSRC_SLOT(table, handle.slot);
+	if (slot->generation != handle.generation
+	 || !zend_rsrc_in_table(&slot->res)
+	 || slot->res.type != handle.type) {
+		return NULL;
+	}
+	return slot->res.ptr;
+}
+
+ZEND_API zend_resource* zend_register_resource(void *rsrc_pointer, int rsrc_type)
+{
+	return zend_list_insert(rsrc_pointer, rsrc_type);
 }
 
 ZEND_API void *zend_fetch_resource2(zend_resource *res, const char *resource_type_name, int resource_type1, int resource_type2)
@@ -176,17 +397,6 @@ ZEND_API void *zend_fetch_resource2_ex(zval *res, const char *resource_type_name
 	return zend_fetch_resource2(Z_RES_P(res), resource_type_name, resource_type1, resource_type2);
 }
 
-void list_entry_destructor(zval *zv)
-{
-	zend_resource *res = Z_RES_P(zv);
-
-	ZVAL_UNDEF(zv);
-	if (res->type >= 0) {
-		zend_resource_dtor(res);
-	}
-	efree_size(res, sizeof(zend_resource));
-}
-
 void plist_entry_destructor(zval *zv)
 {
 	zend_resource *res = Z_RES_P(zv);
@@ -194,7 +404,7 @@ void plist_entry_destructor(zval *zv)
 	if (res->type >= 0) {
 		zend_rsrc_list_dtors_entry *ld;
 
-		ld = zend_hash_index_find_ptr(&list_destructors, res->type);
+		ld = zend_rsrc_list_dtors(res->type);
 		if (ld) {
 			if (ld->plist_dtor_ex) {
 				ld->plist_dtor_ex(res);
@@ -208,7 +418,19 @@ void plist_entry_destructor(zval *zv)
 
 int zend_init_rsrc_list(void)
 {
-	zend_hash_init(&EG(regular_list), 8, NULL, list_entry_destructor, 0);
+	zend_resource_table *table = &EG(regular_list);
+
+	/* a new epoch, so that handles from an earlier request do not resolve */
+	table->epoch++;
+	table->chunks = NULL;
+	table->kinds = NULL;
+	table->num_chunks = 0;
+	table->num_kinds = 0;
+	table->num_used = 0;
+	table->num_live = 0;
+	table->head = ZEND_RSRC_INVALID;
+	table->tail = ZEND_RSRC_INVALID;
+	table->next_handle = 1;
 	return SUCCESS;
 }
 
@@ -220,20 +442,33 @@ int zend_init_rsrc_plist(void)
 }
 
 
-static int zend_close_rsrc(zval *zv)
+void zend_close_rsrc_list(zend_resource_table *table)
 {
-	zend_resource *res = Z_PTR_P(zv);
-
-	if (res->type >= 0) {
-		zend_resource_dtor(res);
-	}
-	return ZEND_HASH_APPLY_KEEP;
+	zend_rsrc_close_chain(table, table->tail, 0);
 }
 
 
-void zend_close_rsrc_list(HashTable *ht)
+void zend_destroy_rsrc_table(zend_resource_table *table)
 {
-	zend_hash_reverse_apply(ht, zend_close_rsrc);
+	uint32_t i;
+
+	while (table->tail != ZEND_RSRC_INVALID) {
+		zend_rsrc_slot_free(table, ZEND_RSRC_SLOT(table, table->tail));
+	}
+	for (i = 0; i < table->num_chunks && i * ZEND_RSRC_CHUNK_SIZE < table->num_used; i++) {
+		efree(table->chunks[i]);
+	}
+	if (table->chunks) {
+		efree(table->chunks);
+		table->chunks = NULL;
+	}
+	if (table->kinds) {
+		efree(table->kinds);
+		table->kinds = NULL;
+	}
+	table->num_chunks = 0;
+	table->num_kinds = 0;
+	table->num_used = 0;
 }
 
 
@@ -259,6 +494,9 @@ static int zend_clean_module_rsrc_dtors_cb(zval *zv, void *arg)
 	int module_number = *(int *)arg;
 	if (ld->module_number == module_number) {
 		zend_hash_apply_with_argument(&EG(persistent_list), clean_module_resource, (void *) &(ld->resource_id));
+		if ((uint32_t)ld->resource_id < list_dtors_size) {
+			list_dtors_by_type[ld->resource_id] = NULL;
+		}
 		return 1;
 	} else {
 		return 0;
@@ -288,6 +526,17 @@ ZEND_API int zend_register_list_destructors_ex(rsrc_dtor_func_t ld, rsrc_dtor_fu
 	if (zend_hash_next_index_insert(&list_destructors, &zv) == NULL) {
 		return FAILURE;
 	}
+	if ((uint32_t)lde->resource_id >= list_dtors_size) {
+		uint32_t size = list_dtors_size ? list_dtors_size * 2 : 64;
+
+		while (size <= (uint32_t)lde->resource_id) {
+			size *= 2;
+		}
+		list_dtors_by_type = realloc(list_dtors_by_type, size * sizeof(zend_rsrc_list_dtors_entry *));
+		memset(list_dtors_by_type + list_dtors_size, 0, (size - list_dtors_size) * sizeof(zend_rsrc_list_dtors_entry *));
+		list_dtors_size = size;
+	}
+	list_dtors_by_type[lde->resource_id] = lde;
 	return list_destructors.nNextFreeElement-1;
 }
 
@@ -320,6 +569,9 @@ int zend_init_rsrc_list_dtors(void)
 void zend_destroy_rsrc_list_dtors(void)
 {
 	zend_hash_destroy(&list_destructors);
+	free(list_dtors_by_type);
+	list_dtors_by_type = NULL;
+	list_dtors_size = 0;
 }
 
 
@@ -327,7 +579,7 @@ const char *zend_rsrc_list_get_rsrc_type(zend_resource *res)
 {
 	zend_rsrc_list_dtors_entry *lde;
 
-	lde = zend_hash_index_find_ptr(&list_destructors, res->type);
+	lde = zend_rsrc_list_dtors(res->type);
 	if (lde) {
 		return lde->type_name;
 	} else {
@@ -38,24 +38,86 @@ typedef struct _zend_rsrc_list_dtors_entry {
 	int resource_id;
 } zend_rsrc_list_dtors_entry;
 
+/* Regular resources live in slots of a slab owned by EG(regular_list).
+ * Slots are allocated in chunks that never move, so a resource is a
+ * pointer to its slot, and a freed slot goes onto the free list of the
+ * resource type it held, to be handed to the next resource of that type.
+ * Live slots are linked in creation order, both in one list for the whole
+ * table and in one list per type, so closing everything or only the
+ * resources of one type does not look at anything else. */
+#define ZEND_RSRC_CHUNK_SHIFT	7
+#define ZEND_RSRC_CHUNK_SIZE	(1U << ZEND_RSRC_CHUNK_SHIFT)
+#define ZEND_RSRC_CHUNK_MASK	(ZEND_RSRC_CHUNK_SIZE - 1)
+#define ZEND_RSRC_INVALID		((uint32_t)-1)
+
+struct _zend_resource_slot {
+	zend_resource res;		/* must be first */
+	uint32_t slot;
+	uint32_t generation;	/* bumped each time the slot is freed */
+	uint32_t kind;			/* the type the resource was created with */
+	uint32_t prev;
+	uint32_t next;			/* also links the free list of its kind */
+	uint32_t kind_prev;
+	uint32_t kind_next;
+};
+
+struct _zend_resource_kind {
+	uint32_t free;
+	uint32_t head;
+	uint32_t tail;
+};
+
+#define ZEND_RSRC_SLOT(table, idx) \
+	((table)->chunks[(idx) >> ZEND_RSRC_CHUNK_SHIFT] + ((idx) & ZEND_RSRC_CHUNK_MASK))
+#define ZEND_RSRC_SLOT_OF(res) \
+	((zend_resource_slot *)(res))
+
+#define ZEND_LIST_FOREACH(_res) do { \
+		zend_resource_table *__table = &EG(regular_list); \
+		uint32_t __idx = __table->head; \
+		while (__idx != ZEND_RSRC_INVALID) { \
+			zend_resource_slot *__slot = ZEND_RSRC_SLOT(__table, __idx); \
+			__idx = __slot->next; \
+			_res = &__slot->res;
+
+#define ZEND_LIST_FOREACH_END() \
+		} \
+	} while (0)
+
+/* A handle names a resource without holding a reference to it. It is
+ * checked against the slot's generation, so it stops resolving once the
+ * resource is freed, even when the slot already holds another resource,
+ * and against the type it was taken for. Handles do not outlive the
+ * request. */
+typedef struct _zend_resource_handle {
+	uint32_t slot;
+	uint32_t generation;
+	uint32_t epoch;
+	int type;
+} zend_resource_handle;
+
 
 ZEND_API int zend_register_list_destructors_ex(rsrc_dtor_func_t ld, rsrc_dtor_func_t pld, const char *type_name, int module_number);
 
-void list_entry_destructor(zval *ptr);
 void plist_entry_destructor(zval *ptr);
 
 void zend_clean_module_rsrc_dtors(int module_number);
 int zend_init_rsrc_list(void);
 int zend_init_rsrc_plist(void);
-void zend_close_rsrc_list(HashTable *ht);
+void zend_close_rsrc_list(zend_resource_table *table);
+void zend_destroy_rsrc_table(zend_resource_table *table);
 void zend_destroy_rsrc_list(HashTable *ht);
 int zend_init_rsrc_list_dtors(void);
 void zend_destroy_rsrc_list_dtors(void);
 
-ZEND_API zval* ZEND_FASTCALL zend_list_insert(void *ptr, int type);
+ZEND_API zend_resource* ZEND_FASTCALL zend_list_insert(void *ptr, int type);
 ZEND_API int ZEND_FASTCALL zend_list_free(zend_resource *res);
 ZEND_API int ZEND_FASTCALL zend_list_delete(zend_resource *res);
 ZEND_API int ZEND_FASTCALL zend_list_close(zend_resource *res);
+ZEND_API void zend_list_close_type(int type);
+
+ZEND_API zend_resource_handle zend_list_handle(zend_resource *res);
+ZEND_API void *zend_list_handle_fetch(zend_resource_handle handle);
 
 ZEND_API zend_resource *zend_register_resource(void *rsrc_pointer, int rsrc_type);
 ZEND_API void *zend_fetch_resource(zend_resource *res, const char *resource_type_name, int resource_type);
@@ -69,6 +131,11 @@ ZEND_API int zend_fetch_list_dtor_id(const char *type_name);
 ZEND_API zend_resource* zend_register_persistent_resource(const char *key, size_t key_len, void *rsrc_pointer, int rsrc_type);
 ZEND_API zend_resource* zend_register_persistent_resource_ex(zend_string *key, void *rsrc_pointer, int rsrc_type);
 
+static zend_always_inline uint32_t zend_list_count(void)
+{
+	return EG(regular_list).num_live;
+}
+
 extern ZEND_API int le_index_ptr;  /* list entry type for index pointers */
 
 END_EXTERN_C()
@@ -23,6 +23,7 @@
 #include "zend.h"
 #include "zend_compile.h"
 #include "zend_build.h"
+#include "zend_rcu_hash.h"
 
 #define INIT_FUNC_ARGS		int type, int module_number
 #define INIT_FUNC_ARGS_PASSTHRU	type, module_number
@@ -121,7 +122,9 @@ struct _zend_module_dep {
 };
 
 BEGIN_EXTERN_C()
-extern ZEND_API HashTable module_registry;
+/* read by every request thread, written at startup, shutdown and when a
+ * temporary module goes away */
+extern ZEND_API RcuHashTable module_registry;
 
 void module_destructor(zend_module_entry *module);
 int module_registry_request_startup(zend_module_entry *module);
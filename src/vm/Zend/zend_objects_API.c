@@ -62,6 +62,28 @@ ZEND_API void ZEND_FASTCALL zend_objects_store_call_destructors(zend_objects_sto
 	}
 }
 
+ZEND_API zend_bool ZEND_FASTCALL zend_objects_store_has_pending_destructors(zend_objects_store *objects)
+{
+	if (objects->object_buckets && objects->top > 1) {
+		zend_object **obj_ptr = objects->object_buckets + 1;
+		zend_object **end = objects->object_buckets + objects->top;
+
+		do {
+			zend_object *obj = *obj_ptr;
+
+			if (IS_OBJ_VALID(obj)
+			 && !(OBJ_FLAGS(obj) & IS_OBJ_DESTRUCTOR_CALLED)
+			 && obj->handlers->dtor_obj
+			 && (obj->handlers->dtor_obj != zend_objects_destroy_object
+			  || obj->ce->destructor)) {
+				return 1;
+			}
+			obj_ptr++;
+		} while (obj_ptr != end);
+	}
+	return 0;
+}
+
 ZEND_API void ZEND_FASTCALL zend_objects_store_mark_destructed(zend_objects_store *objects)
 {
 	if (objects->object_buckets && objects->top > 1) {
@@ -1767,6 +1767,32 @@ ZEND_API int ZEND_FASTCALL shift_right_function(zval *result, zval *op1, zval *o
 }
 /* }}} */
 
+/* Extends the string an append goes to. Past the small sizes a string that
+ * is appended to keeps half again its size as spare room, so building one
+ * by many appends copies it O(log n) times instead of whenever the heap
+ * cannot grow it in place. Debug blocks carry their info at the end and
+ * custom heaps do not report block sizes, both just extend. */
+static zend_always_inline zend_string *zend_concat_extend(zend_string *str, size_t len) /* {{{ */
+{
+#if !ZEND_DEBUG
+	if (!ZSTR_IS_INTERNED(str) && GC_REFCOUNT(str) == 1
+	 && _ZSTR_STRUCT_SIZE(len) > ZEND_MM_MAX_SMALL_SIZE) {
+		size_t capacity = zend_mem_block_size(str);
+
+		if (EXPECTED(capacity != 0)) {
+			if (_ZSTR_STRUCT_SIZE(len) > capacity) {
+				str = erealloc(str, MAX(_ZSTR_STRUCT_SIZE(len), capacity + (capacity >> 1)));
+			}
+			ZSTR_LEN(str) = len;
+			zend_string_forget_hash_val(str);
+			return str;
+		}
+	}
+#endif
+	return zend_string_extend(str, len, 0);
+}
+/* }}} */
+
 ZEND_API int ZEND_FASTCALL concat_function(zval *result, zval *op1, zval *op2) /* {{{ */
 {
     zval *orig_op1 = op1;
@@ -1847,7 +1873,7 @@ ZEND_API int ZEND_FASTCALL concat_function(zval *result, zval *op1, zval *op2) /
 
 		if (result == op1 && Z_REFCOUNTED_P(result)) {
 			/* special case, perform operations on result */
-			result_str = zend_string_extend(Z_STR_P(result), result_len, 0);
+			result_str = zend_concat_extend(Z_STR_P(result), result_len);
 		} else {
 			result_str = zend_string_alloc(result_len, 0);
 			memcpy(ZSTR_VAL(result_str), Z_STRVAL_P(op1), op1_len);
@@ -0,0 +1,664 @@
+/*
+   +----------------------------------------------------------------------+
+   | Zend Engine                                                          |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1998-2018 Zend Technologies Ltd. (http://www.zend.com) |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 2.00 of the Zend license,     |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.zend.com/license/2_00.txt.                                |
+   | If you did not receive a copy of the Zend license and are unable to  |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@zend.com so we can mail you a copy immediately.              |
+   +----------------------------------------------------------------------+
+*/
+
+#include "zend.h"
+#include "zend_API.h"
+#include "zend_rcu_hash.h"
+
+/* Every thread owns a reader record holding the epoch it entered its read
+ * section in, 0 while it is outside of one. A writer publishes its copy,
+ * then advances the global epoch and tags the replaced snapshot with the
+ * epoch before the advance. A reader that announced a later epoch loaded
+ * the snapshot pointer after the publication, so once no announced epoch
+ * is at or below the tag nobody can still hold the old snapshot. */
+
+#ifdef ZTS
+# if defined(__GNUC__)
+#  define RCU_LOAD_PTR(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#  define RCU_PUBLISH_PTR(p, v)	__atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#  define RCU_LOAD_EPOCH(p)		__atomic_load_n((p), __ATOMIC_SEQ_CST)
+#  define RCU_ANNOUNCE(p, v)	do { \
+		__atomic_store_n((p), (v), __ATOMIC_SEQ_CST); \
+		__atomic_thread_fence(__ATOMIC_SEQ_CST); \
+	} while (0)
+#  define RCU_QUIESCE(p)		__atomic_store_n((p), 0, __ATOMIC_RELEASE)
+#  define RCU_ADVANCE(p)		__atomic_fetch_add((p), 1, __ATOMIC_SEQ_CST)
+# elif defined(ZEND_WIN32)
+#  define RCU_LOAD_PTR(p)		InterlockedCompareExchangePointer((PVOID volatile *)(p), NULL, NULL)
+#  define RCU_PUBLISH_PTR(p, v)	InterlockedExchangePointer((PVOID volatile *)(p), (v))
+#  define RCU_LOAD_EPOCH(p)		((uint64_t) InterlockedCompareExchange64((LONG64 volatile *)(p), 0, 0))
+#  define RCU_ANNOUNCE(p, v)	InterlockedExchange64((LONG64 volatile *)(p), (LONG64)(v))
+#  define RCU_QUIESCE(p)		InterlockedExchange64((LONG64 volatile *)(p), 0)
+#  define RCU_ADVANCE(p)		((uint64_t) InterlockedExchangeAdd64((LONG64 volatile *)(p), 1))
+# else
+#  error "zend_rcu_hash needs atomic operations for this compiler"
+# endif
+#else
+# define RCU_LOAD_PTR(p)		(*(p))
+# define RCU_PUBLISH_PTR(p, v)	(*(p) = (v))
+# define RCU_LOAD_EPOCH(p)		(*(p))
+# define RCU_ANNOUNCE(p, v)		(*(p) = (v))
+# define RCU_QUIESCE(p)			(*(p) = 0)
+# define RCU_ADVANCE(p)			((*(p))++)
+#endif
+
+#define SNAPSHOT(ht) ((HashTable *) RCU_LOAD_PTR(&(ht)->current))
+
+ZEND_BEGIN_MODULE_GLOBALS(rcu)
+	uint64_t epoch;
+	uint32_t nesting;
+	struct _zend_rcu_globals *prev;
+	struct _zend_rcu_globals *next;
+ZEND_END_MODULE_GLOBALS(rcu)
+
+/* regular TSRM storage rather than a static thread local, the dtor has to
+ * unlink the record of a thread freed from another thread */
+ZEND_DECLARE_MODULE_GLOBALS(rcu)
+
+#define RCUG_BULK() ZEND_MODULE_GLOBALS_BULK(rcu)
+
+struct _zend_rcu_hash_retired {
+	HashTable *snapshot;
+	/* the values the write that replaced the snapshot removed */
+	zval *values;
+	uint32_t num_values;
+	uint32_t size_values;
+	uint64_t epoch;
+	dtor_func_t remove;
+	zend_bool persistent;
+	zend_rcu_hash_retired *next;
+};
+
+typedef struct _rcu_hash_write {
+	HashTable *copy;
+	zend_rcu_hash_retired *retired;
+	zend_rcu_hash_retired *outer;
+} rcu_hash_write;
+
+static uint64_t rcu_epoch = 1;
+static zend_rcu_globals *rcu_readers = NULL;
+#ifdef ZTS
+static MUTEX_T rcu_readers_mx;
+#endif
+
+/* the write in progress on this thread, its copy collects the values it
+ * loses through this instead of destroying them */
+static TSRM_TLS zend_rcu_hash_retired *rcu_collecting = NULL;
+
+/* the table being destroyed on this thread, once nobody can read it */
+static TSRM_TLS RcuHashTable *rcu_freeing = NULL;
+
+/* reader registry */
+static void rcu_globals_ctor(zend_rcu_globals *rcu_globals_p)
+{
+	rcu_globals_p->epoch = 0;
+	rcu_globals_p->nesting = 0;
+	rcu_globals_p->prev = NULL;
+#ifdef ZTS
+	tsrm_mutex_lock(rcu_readers_mx);
+#endif
+	rcu_globals_p->next = rcu_readers;
+	if (rcu_readers) {
+		rcu_readers->prev = rcu_globals_p;
+	}
+	rcu_readers = rcu_globals_p;
+#ifdef ZTS
+	tsrm_mutex_unlock(rcu_readers_mx);
+#endif
+}
+
+static void rcu_globals_dtor(zend_rcu_globals *rcu_globals_p)
+{
+#ifdef ZTS
+	tsrm_mutex_lock(rcu_readers_mx);
+#endif
+	if (rcu_globals_p->prev) {
+		rcu_globals_p->prev->next = rcu_globals_p->next;
+	} else {
+		rcu_readers = rcu_globals_p->next;
+	}
+	if (rcu_globals_p->next) {
+		rcu_globals_p->next->prev = rcu_globals_p->prev;
+	}
+#ifdef ZTS
+	tsrm_mutex_unlock(rcu_readers_mx);
+#endif
+}
+
+static uint64_t rcu_oldest_reader(void)
+{
+	zend_rcu_globals *reader;
+	uint64_t oldest = UINT64_MAX;
+	uint64_t epoch;
+
+#ifdef ZTS
+	tsrm_mutex_lock(rcu_readers_mx);
+#endif
+	for (reader = rcu_readers; reader; reader = reader->next) {
+		epoch = RCU_LOAD_EPOCH(&reader->epoch);
+		if (epoch && epoch < oldest) {
+			oldest = epoch;
+		}
+	}
+#ifdef ZTS
+	tsrm_mutex_unlock(rcu_readers_mx);
+#endif
+	return oldest;
+}
+
+ZEND_API void zend_rcu_startup(void)
+{
+#ifdef ZTS
+	rcu_readers_mx = tsrm_mutex_alloc();
+#endif
+	ZEND_INIT_MODULE_GLOBALS(rcu, rcu_globals_ctor, rcu_globals_dtor);
+}
+
+ZEND_API void zend_rcu_read_lock(void)
+{
+	zend_rcu_globals *self = RCUG_BULK();
+
+	if (self->nesting++ == 0) {
+		RCU_ANNOUNCE(&self->epoch, RCU_LOAD_EPOCH(&rcu_epoch));
+	}
+}
+
+ZEND_API void zend_rcu_read_unlock(void)
+{
+	zend_rcu_globals *self = RCUG_BULK();
+
+	ZEND_ASSERT(self->nesting > 0);
+	if (--self->nesting == 0) {
+		RCU_QUIESCE(&self->epoch);
+	}
+}
+
+ZEND_API HashTable *zend_rcu_hash_snapshot(RcuHashTable *ht)
+{
+	return SNAPSHOT(ht);
+}
+
+/* snapshot management functions */
+static void rcu_hash_collect(zval *zv)
+{
+	zend_rcu_hash_retired *retired = rcu_collecting;
+
+	if (retired->remove) {
+		retired->remove(zv);
+	}
+	if (retired->num_values == retired->size_values) {
+		retired->size_values = retired->size_values ? retired->size_values * 2 : 8;
+		retired->values = perealloc(retired->values, sizeof(zval) * retired->size_values, retired->persistent);
+	}
+	ZVAL_COPY_VALUE(&retired->values[retired->num_values++], zv);
+}
+
+static void rcu_hash_free_retired(RcuHashTable *ht, zend_rcu_hash_retired *retired)
+{
+	uint32_t i;
+
+	if (ht->pDestructor) {
+		for (i = 0; i < retired->num_values; i++) {
+			ht->pDestructor(&retired->values[i]);
+		}
+	}
+	if (retired->values) {
+		pefree(retired->values, retired->persistent);
+	}
+	/* snapshots carry no destructor, the values still in one belong to
+	 * the snapshot that replaced it */
+	zend_hash_destroy(retired->snapshot);
+	pefree(retired->snapshot, retired->persistent);
+	pefree(retired, retired->persistent);
+}
+
+static void rcu_hash_reclaim(RcuHashTable *ht, int all)
+{
+	zend_rcu_hash_retired **link = &ht->retired;
+	zend_rcu_hash_retired *retired;
+	uint64_t oldest;
+
+	if (!ht->retired) {
+		return;
+	}
+	oldest = all ? UINT64_MAX : rcu_oldest_reader();
+	while ((retired = *link)) {
+		if (retired->epoch < oldest) {
+			*link = retired->next;
+			rcu_hash_free_retired(ht, retired);
+		} else {
+			link = &retired->next;
+		}
+	}
+}
+
+static HashTable *begin_write(RcuHashTable *ht, rcu_hash_write *write)
+{
+	HashTable *current;
+
+#ifdef ZTS
+	tsrm_mutex_lock(ht->mx_writer);
+#endif
+	current = ht->current;
+	write->copy = pemalloc(sizeof(HashTable), ht->persistent);
+	_zend_hash_init(write->copy, zend_hash_num_elements(current), NULL, ht->persistent);
+	zend_hash_copy(write->copy, current, NULL);
+	write->copy->nNextFreeElement = current->nNextFreeElement;
+	write->copy->pDestructor = rcu_hash_collect;
+
+	write->retired = pecalloc(1, sizeof(zend_rcu_hash_retired), ht->persistent);
+	write->retired->snapshot = current;
+	write->retired->remove = ht->pRemove;
+	write->retired->persistent = ht->persistent;
+	write->outer = rcu_collecting;
+	rcu_collecting = write->retired;
+
+	return write->copy;
+}
+
+static void end_write(RcuHashTable *ht, rcu_hash_write *write, int changed)
+{
+	rcu_collecting = write->outer;
+	write->copy->pDestructor = NULL;
+
+	if (changed) {
+		RCU_PUBLISH_PTR(&ht->current, write->copy);
+		write->retired->epoch = RCU_ADVANCE(&rcu_epoch);
+		write->retired->next = ht->retired;
+		ht->retired = write->retired;
+	} else {
+		ZEND_ASSERT(write->retired->num_values == 0);
+		zend_hash_destroy(write->copy);
+		pefree(write->copy, ht->persistent);
+		pefree(write->retired, ht->persistent);
+	}
+	rcu_hash_reclaim(ht, 0);
+
+#ifdef ZTS
+	tsrm_mutex_unlock(ht->mx_writer);
+#endif
+}
+
+static void rcu_hash_free_value(zval *zv)
+{
+	if (rcu_freeing->pRemove) {
+		rcu_freeing->pRemove(zv);
+	}
+	if (rcu_freeing->pDestructor) {
+		rcu_freeing->pDestructor(zv);
+	}
+}
+
+#define RCU_FREE_GRACEFUL	(1<<0)
+#define RCU_FREE_REVERSE	(1<<1)
+
+static void rcu_hash_free(RcuHashTable *ht, int mode)
+{
+	RcuHashTable *outer;
+
+#ifdef ZTS
+	tsrm_mutex_lock(ht->mx_writer);
+#endif
+	rcu_hash_reclaim(ht, 1);
+	outer = rcu_freeing;
+	rcu_freeing = ht;
+	ht->current->pDestructor = rcu_hash_free_value;
+	if (mode & RCU_FREE_REVERSE) {
+		zend_hash_graceful_reverse_destroy(ht->current);
+	} else if (mode & RCU_FREE_GRACEFUL) {
+		zend_hash_graceful_destroy(ht->current);
+	} else {
+		zend_hash_destroy(ht->current);
+	}
+	rcu_freeing = outer;
+	pefree(ht->current, ht->persistent);
+	ht->current = NULL;
+#ifdef ZTS
+	tsrm_mutex_unlock(ht->mx_writer);
+	tsrm_mutex_free(ht->mx_writer);
+#endif
+}
+
+/* delegates */
+ZEND_API void _zend_rcu_hash_init(RcuHashTable *ht, uint32_t nSize, dtor_func_t pDestructor, zend_bool persistent)
+{
+#ifdef ZTS
+	ht->mx_writer = tsrm_mutex_alloc();
+#endif
+	ht->pDestructor = pDestructor;
+	ht->pRemove = NULL;
+	ht->persistent = persistent;
+	ht->retired = NULL;
+	ht->current = pemalloc(sizeof(HashTable), persistent);
+	_zend_hash_init(ht->current, nSize, NULL, persistent);
+}
+
+ZEND_API void zend_rcu_hash_destroy(RcuHashTable *ht)
+{
+	rcu_hash_free(ht, 0);
+}
+
+ZEND_API void zend_rcu_hash_set_remove_handler(RcuHashTable *ht, dtor_func_t pRemove)
+{
+	ht->pRemove = pRemove;
+}
+
+ZEND_API void zend_rcu_hash_clean(RcuHashTable *ht)
+{
+	rcu_hash_write write;
+
+	zend_hash_clean(begin_write(ht, &write));
+	end_write(ht, &write, 1);
+}
+
+ZEND_API zval *zend_rcu_hash_add(RcuHashTable *ht, zend_string *key, zval *pData)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_add(begin_write(ht, &write), key, pData);
+	end_write(ht, &write, retval != NULL);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_update(RcuHashTable *ht, zend_string *key, zval *pData)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_update(begin_write(ht, &write), key, pData);
+	end_write(ht, &write, 1);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_next_index_insert(RcuHashTable *ht, zval *pData)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_next_index_insert(begin_write(ht, &write), pData);
+	end_write(ht, &write, retval != NULL);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_index_update(RcuHashTable *ht, zend_ulong h, zval *pData)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_index_update(begin_write(ht, &write), h, pData);
+	end_write(ht, &write, 1);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_add_empty_element(RcuHashTable *ht, zend_string *key)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_add_empty_element(begin_write(ht, &write), key);
+	end_write(ht, &write, retval != NULL);
+
+	return retval;
+}
+
+ZEND_API void zend_rcu_hash_graceful_destroy(RcuHashTable *ht)
+{
+	rcu_hash_free(ht, RCU_FREE_GRACEFUL);
+}
+
+ZEND_API void zend_rcu_hash_graceful_reverse_destroy(RcuHashTable *ht)
+{
+	rcu_hash_free(ht, RCU_FREE_GRACEFUL | RCU_FREE_REVERSE);
+}
+
+ZEND_API void zend_rcu_hash_apply(RcuHashTable *ht, apply_func_t apply_func)
+{
+	rcu_hash_write write;
+
+	zend_hash_apply(begin_write(ht, &write), apply_func);
+	end_write(ht, &write, 1);
+}
+
+ZEND_API void zend_rcu_hash_apply_with_argument(RcuHashTable *ht, apply_func_arg_t apply_func, void *argument)
+{
+	rcu_hash_write write;
+
+	zend_hash_apply_with_argument(begin_write(ht, &write), apply_func, argument);
+	end_write(ht, &write, 1);
+}
+
+ZEND_API void zend_rcu_hash_apply_with_arguments(RcuHashTable *ht, apply_func_args_t apply_func, int num_args, ...)
+{
+	rcu_hash_write write;
+	va_list args;
+
+	va_start(args, num_args);
+	zend_hash_apply_with_arguments(begin_write(ht, &write), apply_func, num_args, args);
+	end_write(ht, &write, 1);
+	va_end(args);
+}
+
+ZEND_API void zend_rcu_hash_reverse_apply(RcuHashTable *ht, apply_func_t apply_func)
+{
+	rcu_hash_write write;
+
+	zend_hash_reverse_apply(begin_write(ht, &write), apply_func);
+	end_write(ht, &write, 1);
+}
+
+ZEND_API int zend_rcu_hash_del(RcuHashTable *ht, zend_string *key)
+{
+	rcu_hash_write write;
+	int retval;
+
+	retval = zend_hash_del(begin_write(ht, &write), key);
+	end_write(ht, &write, retval == SUCCESS);
+
+	return retval;
+}
+
+ZEND_API int zend_rcu_hash_index_del(RcuHashTable *ht, zend_ulong h)
+{
+	rcu_hash_write write;
+	int retval;
+
+	retval = zend_hash_index_del(begin_write(ht, &write), h);
+	end_write(ht, &write, retval == SUCCESS);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_find(RcuHashTable *ht, zend_string *key)
+{
+	zval *retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_find(SNAPSHOT(ht), key);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_index_find(RcuHashTable *ht, zend_ulong h)
+{
+	zval *retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_index_find(SNAPSHOT(ht), h);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API int zend_rcu_hash_exists(RcuHashTable *ht, zend_string *key)
+{
+	int retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_exists(SNAPSHOT(ht), key);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API int zend_rcu_hash_index_exists(RcuHashTable *ht, zend_ulong h)
+{
+	int retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_index_exists(SNAPSHOT(ht), h);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API void zend_rcu_hash_copy(RcuHashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor)
+{
+	rcu_hash_write write;
+
+	zend_rcu_read_lock();
+	zend_hash_copy(begin_write(target, &write), SNAPSHOT(source), pCopyConstructor);
+	end_write(target, &write, 1);
+	zend_rcu_read_unlock();
+}
+
+ZEND_API void zend_rcu_hash_copy_to_hash(HashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor)
+{
+	zend_rcu_read_lock();
+	zend_hash_copy(target, SNAPSHOT(source), pCopyConstructor);
+	zend_rcu_read_unlock();
+}
+
+ZEND_API void zend_rcu_hash_merge(RcuHashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor, int overwrite)
+{
+	rcu_hash_write write;
+
+	zend_rcu_read_lock();
+	zend_hash_merge(begin_write(target, &write), SNAPSHOT(source), pCopyConstructor, overwrite);
+	end_write(target, &write, 1);
+	zend_rcu_read_unlock();
+}
+
+ZEND_API void zend_rcu_hash_merge_ex(RcuHashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor, merge_checker_func_t pMergeSource, void *pParam)
+{
+	rcu_hash_write write;
+
+	zend_rcu_read_lock();
+	zend_hash_merge_ex(begin_write(target, &write), SNAPSHOT(source), pCopyConstructor, pMergeSource, pParam);
+	end_write(target, &write, 1);
+	zend_rcu_read_unlock();
+}
+
+ZEND_API int zend_rcu_hash_sort(RcuHashTable *ht, sort_func_t sort_func, compare_func_t compare_func, int renumber)
+{
+	rcu_hash_write write;
+	int retval;
+
+	retval = zend_hash_sort_ex(begin_write(ht, &write), sort_func, compare_func, renumber);
+	end_write(ht, &write, 1);
+
+	return retval;
+}
+
+ZEND_API int zend_rcu_hash_compare(RcuHashTable *ht1, RcuHashTable *ht2, compare_func_t compar, zend_bool ordered)
+{
+	int retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_compare(SNAPSHOT(ht1), SNAPSHOT(ht2), compar, ordered);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_minmax(RcuHashTable *ht, compare_func_t compar, int flag)
+{
+	zval *retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_minmax(SNAPSHOT(ht), compar, flag);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API int zend_rcu_hash_num_elements(RcuHashTable *ht)
+{
+	int retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_num_elements(SNAPSHOT(ht));
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API int zend_rcu_hash_rehash(RcuHashTable *ht)
+{
+	rcu_hash_write write;
+	int retval;
+
+	retval = zend_hash_rehash(begin_write(ht, &write));
+	end_write(ht, &write, 1);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_str_find(RcuHashTable *ht, const char *key, size_t len)
+{
+	zval *retval;
+
+	zend_rcu_read_lock();
+	retval = zend_hash_str_find(SNAPSHOT(ht), key, len);
+	zend_rcu_read_unlock();
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_str_update(RcuHashTable *ht, const char *key, size_t len, zval *pData)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_str_update(begin_write(ht, &write), key, len, pData);
+	end_write(ht, &write, 1);
+
+	return retval;
+}
+
+ZEND_API zval *zend_rcu_hash_str_add(RcuHashTable *ht, const char *key, size_t len, zval *pData)
+{
+	rcu_hash_write write;
+	zval *retval;
+
+	retval = zend_hash_str_add(begin_write(ht, &write), key, len, pData);
+	end_write(ht, &write, retval != NULL);
+
+	return retval;
+}
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * End:
+ */
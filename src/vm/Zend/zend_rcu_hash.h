@@ -0,0 +1,212 @@
+/*
+   +----------------------------------------------------------------------+
+   | Zend Engine                                                          |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1998-2018 Zend Technologies Ltd. (http://www.zend.com) |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 2.00 of the Zend license,     |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.zend.com/license/2_00.txt.                                |
+   | If you did not receive a copy of the Zend license and are unable to  |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@zend.com so we can mail you a copy immediately.              |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef ZEND_RCU_HASH_H
+#define ZEND_RCU_HASH_H
+
+#include "zend.h"
+
+/* A shared hash for tables that are read far more often than written,
+ * with the API of TsHashTable.
+ *
+ * Readers never lock: the table is an immutable snapshot published
+ * through one pointer. A writer serializes with other writers, copies the
+ * snapshot, changes the copy and publishes it. The old snapshot and the
+ * values the write removed are kept until every thread that was reading
+ * when it was replaced has left its read section, they are reclaimed by
+ * a later write to the table.
+ *
+ * A zval returned by a lookup lives in a snapshot, it stays valid until
+ * the next write unless the caller holds zend_rcu_read_lock() around
+ * both the lookup and its use. The _ptr variants return the shared
+ * pointer itself, which is not affected.
+ *
+ * To walk the table take a read section and iterate the snapshot:
+ *
+ *   zend_rcu_read_lock();
+ *   ZEND_HASH_FOREACH_PTR(RCU_HASH(&table), ptr) {
+ *       ...
+ *   } ZEND_HASH_FOREACH_END();
+ *   zend_rcu_read_unlock();
+ *
+ * The apply functions are writes, they change a copy and publish it
+ * like any other write. */
+
+typedef struct _zend_rcu_hash_retired zend_rcu_hash_retired;
+
+typedef struct _zend_rcu_hashtable {
+	HashTable *current;
+	dtor_func_t pDestructor;
+	dtor_func_t pRemove;
+	zend_rcu_hash_retired *retired;
+	zend_bool persistent;
+#ifdef ZTS
+	MUTEX_T mx_writer;
+#endif
+} RcuHashTable;
+
+BEGIN_EXTERN_C()
+
+/* the reader registry, called from zend_startup() */
+ZEND_API void zend_rcu_startup(void);
+
+/* read sections nest, the snapshots seen inside one are not reclaimed
+ * before it is left */
+ZEND_API void zend_rcu_read_lock(void);
+ZEND_API void zend_rcu_read_unlock(void);
+
+/* the current snapshot, only to be read and only inside a read section */
+ZEND_API HashTable *zend_rcu_hash_snapshot(RcuHashTable *ht);
+
+#define RCU_HASH(table) zend_rcu_hash_snapshot(table)
+
+/* startup/shutdown */
+ZEND_API void _zend_rcu_hash_init(RcuHashTable *ht, uint32_t nSize, dtor_func_t pDestructor, zend_bool persistent);
+ZEND_API void zend_rcu_hash_destroy(RcuHashTable *ht);
+ZEND_API void zend_rcu_hash_clean(RcuHashTable *ht);
+
+/* pDestructor only runs once no reader can see the value anymore, a
+ * remove handler runs right away on the writer, for values that have to
+ * stop being used when they leave the table but must stay readable */
+ZEND_API void zend_rcu_hash_set_remove_handler(RcuHashTable *ht, dtor_func_t pRemove);
+
+#define zend_rcu_hash_init(ht, nSize, pHashFunction, pDestructor, persistent)	\
+	_zend_rcu_hash_init(ht, nSize, pDestructor, persistent)
+#define zend_rcu_hash_init_ex(ht, nSize, pHashFunction, pDestructor, persistent, bApplyProtection)	\
+	_zend_rcu_hash_init(ht, nSize, pDestructor, persistent)
+
+
+/* additions/updates/changes */
+ZEND_API zval *zend_rcu_hash_update(RcuHashTable *ht, zend_string *key, zval *pData);
+ZEND_API zval *zend_rcu_hash_add(RcuHashTable *ht, zend_string *key, zval *pData);
+ZEND_API zval *zend_rcu_hash_index_update(RcuHashTable *ht, zend_ulong h, zval *pData);
+ZEND_API zval *zend_rcu_hash_next_index_insert(RcuHashTable *ht, zval *pData);
+ZEND_API zval* zend_rcu_hash_add_empty_element(RcuHashTable *ht, zend_string *key);
+
+ZEND_API void zend_rcu_hash_graceful_destroy(RcuHashTable *ht);
+ZEND_API void zend_rcu_hash_graceful_reverse_destroy(RcuHashTable *ht);
+ZEND_API void zend_rcu_hash_apply(RcuHashTable *ht, apply_func_t apply_func);
+ZEND_API void zend_rcu_hash_apply_with_argument(RcuHashTable *ht, apply_func_arg_t apply_func, void *);
+ZEND_API void zend_rcu_hash_apply_with_arguments(RcuHashTable *ht, apply_func_args_t apply_func, int, ...);
+
+ZEND_API void zend_rcu_hash_reverse_apply(RcuHashTable *ht, apply_func_t apply_func);
+
+
+/* Deletes */
+ZEND_API int zend_rcu_hash_del(RcuHashTable *ht, zend_string *key);
+ZEND_API int zend_rcu_hash_index_del(RcuHashTable *ht, zend_ulong h);
+
+/* Data retreival */
+ZEND_API zval *zend_rcu_hash_find(RcuHashTable *ht, zend_string *key);
+ZEND_API zval *zend_rcu_hash_index_find(RcuHashTable *ht, zend_ulong);
+
+/* Misc */
+ZEND_API int zend_rcu_hash_exists(RcuHashTable *ht, zend_string *key);
+ZEND_API int zend_rcu_hash_index_exists(RcuHashTable *ht, zend_ulong h);
+
+/* Copying, merging and sorting */
+ZEND_API void zend_rcu_hash_copy(RcuHashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor);
+ZEND_API void zend_rcu_hash_copy_to_hash(HashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor);
+ZEND_API void zend_rcu_hash_merge(RcuHashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor, int overwrite);
+ZEND_API void zend_rcu_hash_merge_ex(RcuHashTable *target, RcuHashTable *source, copy_ctor_func_t pCopyConstructor, merge_checker_func_t pMergeSource, void *pParam);
+ZEND_API int zend_rcu_hash_sort(RcuHashTable *ht, sort_func_t sort_func, compare_func_t compare_func, int renumber);
+ZEND_API int zend_rcu_hash_compare(RcuHashTable *ht1, RcuHashTable *ht2, compare_func_t compar, zend_bool ordered);
+ZEND_API zval *zend_rcu_hash_minmax(RcuHashTable *ht, compare_func_t compar, int flag);
+
+ZEND_API int zend_rcu_hash_num_elements(RcuHashTable *ht);
+
+ZEND_API int zend_rcu_hash_rehash(RcuHashTable *ht);
+
+ZEND_API zval *zend_rcu_hash_str_find(RcuHashTable *ht, const char *key, size_t len);
+ZEND_API zval *zend_rcu_hash_str_update(RcuHashTable *ht, const char *key, size_t len, zval *pData);
+ZEND_API zval *zend_rcu_hash_str_add(RcuHashTable *ht, const char *key, size_t len, zval *pData);
+
+static zend_always_inline void *zend_rcu_hash_find_ptr(RcuHashTable *ht, zend_string *key)
+{
+	zval *zv;
+	void *ptr;
+
+	zend_rcu_read_lock();
+	zv = zend_rcu_hash_find(ht, key);
+	ptr = zv ? Z_PTR_P(zv) : NULL;
+	zend_rcu_read_unlock();
+	return ptr;
+}
+
+static zend_always_inline void *zend_rcu_hash_str_find_ptr(RcuHashTable *ht, const char *str, size_t len)
+{
+	zval *zv;
+	void *ptr;
+
+	zend_rcu_read_lock();
+	zv = zend_rcu_hash_str_find(ht, str, len);
+	ptr = zv ? Z_PTR_P(zv) : NULL;
+	zend_rcu_read_unlock();
+	return ptr;
+}
+
+static zend_always_inline void *zend_rcu_hash_str_update_ptr(RcuHashTable *ht, const char *str, size_t len, void *pData)
+{
+	zval tmp, *zv;
+
+	ZVAL_PTR(&tmp, pData);
+	zv = zend_rcu_hash_str_update(ht, str, len, &tmp);
+	return zv ? Z_PTR_P(zv) : NULL;
+}
+
+/* the copy is made before the add, a reader never sees it half filled */
+static zend_always_inline void *zend_rcu_hash_add_mem(RcuHashTable *ht, zend_string *key, void *pData, size_t size)
+{
+	zval tmp;
+	void *p = pemalloc(size, ht->persistent);
+
+	memcpy(p, pData, size);
+	ZVAL_PTR(&tmp, p);
+	if (!zend_rcu_hash_add(ht, key, &tmp)) {
+		pefree(p, ht->persistent);
+		return NULL;
+	}
+	return p;
+}
+
+static zend_always_inline void *zend_rcu_hash_str_add_ptr(RcuHashTable *ht, const char *str, size_t len, void *pData)
+{
+	zval tmp, *zv;
+
+	ZVAL_PTR(&tmp, pData);
+	zv = zend_rcu_hash_str_add(ht, str, len, &tmp);
+	return zv ? Z_PTR_P(zv) : NULL;
+}
+
+END_EXTERN_C()
+
+#define ZEND_RCU_INIT_SYMTABLE(ht)								\
+	ZEND_RCU_INIT_SYMTABLE_EX(ht, 2, 0)
+
+#define ZEND_RCU_INIT_SYMTABLE_EX(ht, n, persistent)			\
+	zend_rcu_hash_init(ht, n, NULL, ZVAL_PTR_DTOR, persistent)
+
+#endif							/* ZEND_RCU_HASH_H */
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * End:
+ * vim600: sw=4 ts=4 fdm=marker
+ * vim<600: sw=4 ts=4
+ */
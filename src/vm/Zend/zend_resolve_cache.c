@@ -0,0 +1,159 @@
+/*
+   +----------------------------------------------------------------------+
+   | Zend Engine                                                          |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1998-2018 Zend Technologies Ltd. (http://www.zend.com) |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 2.00 of the Zend license,     |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.zend.com/license/2_00.txt.                                |
+   | If you did not receive a copy of the Zend license and are unable to  |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@zend.com so we can mail you a copy immediately.              |
+   +----------------------------------------------------------------------+
+*/
+
+#include "zend.h"
+#include "zend_API.h"
+#include "zend_resolve_cache.h"
+
+/* entries per table, the cache is dropped as a whole when it is full */
+#define ZEND_RESOLVE_CACHE_LIMIT 4096
+
+ZEND_API uint32_t zend_resolve_epoch = 1;
+
+/* any thread may move the epoch while the others read it */
+#ifdef ZEND_WIN32
+# define ZEND_RESOLVE_EPOCH_INC() \
+	InterlockedIncrement((volatile LONG *) &zend_resolve_epoch)
+# define ZEND_RESOLVE_EPOCH_LOAD() \
+	((uint32_t) InterlockedCompareExchange((volatile LONG *) &zend_resolve_epoch, 0, 0))
+#else
+# define ZEND_RESOLVE_EPOCH_INC() \
+	__atomic_fetch_add(&zend_resolve_epoch, 1, __ATOMIC_RELAXED)
+# define ZEND_RESOLVE_EPOCH_LOAD() \
+	__atomic_load_n(&zend_resolve_epoch, __ATOMIC_ACQUIRE)
+#endif
+
+void zend_resolve_cache_ctor(zend_executor_globals *executor_globals)
+{
+	zend_hash_init(&executor_globals->resolved_functions, 64, NULL, NULL, 1);
+	zend_hash_init(&executor_globals->resolved_constants, 64, NULL, NULL, 1);
+	executor_globals->resolve_epoch = ZEND_RESOLVE_EPOCH_LOAD();
+	executor_globals->resolve_cache = 0;
+}
+
+void zend_resolve_cache_dtor(zend_executor_globals *executor_globals)
+{
+	zend_hash_destroy(&executor_globals->resolved_functions);
+	zend_hash_destroy(&executor_globals->resolved_constants);
+}
+
+ZEND_API void zend_resolve_cache_enable(zend_bool enable)
+{
+	if (!enable && EG(resolve_cache)) {
+		zend_resolve_cache_flush();
+	}
+	EG(resolve_cache) = enable;
+}
+
+ZEND_API void zend_resolve_cache_invalidate(void)
+{
+	ZEND_RESOLVE_EPOCH_INC();
+}
+
+ZEND_API void zend_resolve_cache_flush(void)
+{
+	zend_hash_clean(&EG(resolved_functions));
+	zend_hash_clean(&EG(resolved_constants));
+	EG(resolve_epoch) = ZEND_RESOLVE_EPOCH_LOAD();
+}
+
+static zend_always_inline zend_bool zend_resolve_cache_valid(void)
+{
+	if (!EG(resolve_cache)) {
+		return 0;
+	}
+	if (UNEXPECTED(EG(resolve_epoch) != ZEND_RESOLVE_EPOCH_LOAD())) {
+		zend_resolve_cache_flush();
+	}
+	return 1;
+}
+
+static void zend_resolve_cache_add(HashTable *ht, const char *key, size_t len, void *ptr)
+{
+	zend_string *str;
+
+	if (UNEXPECTED(zend_hash_num_elements(ht) >= ZEND_RESOLVE_CACHE_LIMIT)) {
+		zend_hash_clean(ht);
+	}
+	/* the compiler's names are gone with the request */
+	str = zend_string_init(key, len, 1);
+	zend_hash_update_ptr(ht, str, ptr);
+	zend_string_release_ex(str, 1);
+}
+
+ZEND_API zend_function *zend_resolve_cache_find_function(zend_string *key)
+{
+	if (!zend_resolve_cache_valid()) {
+		return NULL;
+	}
+	return zend_hash_find_ptr(&EG(resolved_functions), key);
+}
+
+ZEND_API void zend_resolve_cache_add_function(zend_string *key, zend_function *func)
+{
+	ZEND_ASSERT(func->type == ZEND_INTERNAL_FUNCTION);
+	if (zend_resolve_cache_valid()) {
+		zend_resolve_cache_add(&EG(resolved_functions), ZSTR_VAL(key), ZSTR_LEN(key), func);
+	}
+}
+
+ZEND_API void zend_resolve_cache_forget_function(zend_string *key)
+{
+	if (EG(resolve_cache) && zend_hash_num_elements(&EG(resolved_functions))) {
+		zend_hash_del(&EG(resolved_functions), key);
+	}
+}
+
+ZEND_API zend_constant *zend_resolve_cache_find_constant(const char *key, size_t len)
+{
+	if (!zend_resolve_cache_valid()) {
+		return NULL;
+	}
+	return zend_hash_str_find_ptr(&EG(resolved_constants), key, len);
+}
+
+ZEND_API void zend_resolve_cache_add_constant(const char *key, size_t len, zend_constant *c)
+{
+	/* case-insensitive constants take the deprecation check on every access */
+	ZEND_ASSERT((ZEND_CONSTANT_FLAGS(c) & (CONST_PERSISTENT|CONST_CS)) == (CONST_PERSISTENT|CONST_CS));
+	if (zend_resolve_cache_valid()) {
+		zend_resolve_cache_add(&EG(resolved_constants), key, len, c);
+	}
+}
+
+/* name is the key the constant was registered under */
+ZEND_API void zend_resolve_cache_forget_constant(zend_constant *c, zend_string *name)
+{
+	if (!EG(resolve_cache) || !zend_hash_num_elements(&EG(resolved_constants))) {
+		return;
+	}
+	if (ZEND_CONSTANT_FLAGS(c) & CONST_CS) {
+		zend_hash_del(&EG(resolved_constants), name);
+	} else {
+		/* matches the namespaced name in any case */
+		zend_hash_clean(&EG(resolved_constants));
+	}
+}
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * End:
+ * vim600: sw=4 ts=4 fdm=marker
+ * vim<600: sw=4 ts=4
+ */
@@ -0,0 +1,67 @@
+/*
+   +----------------------------------------------------------------------+
+   | Zend Engine                                                          |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1998-2018 Zend Technologies Ltd. (http://www.zend.com) |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 2.00 of the Zend license,     |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.zend.com/license/2_00.txt.                                |
+   | If you did not receive a copy of the Zend license and are unable to  |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@zend.com so we can mail you a copy immediately.              |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef ZEND_RESOLVE_CACHE_H
+#define ZEND_RESOLVE_CACHE_H
+
+#include "zend.h"
+#include "zend_constants.h"
+
+/* Remembers, across requests, which internal function or persistent
+ * constant an unqualified name used inside a namespace fell back to, so a
+ * warm worker skips the lookup of the namespaced name and the fallback
+ * lookup on the first execution of each call site.
+ *
+ * Entries are kept per thread and keyed by the namespaced name as the
+ * compiler emits it. Declaring a function or a constant under a cached
+ * name drops the entry. Everything is dropped when zend_resolve_epoch
+ * moves, which happens whenever internal functions or persistent
+ * constants are registered or removed. The cache is only used while it
+ * is enabled, worker mode turns it on. */
+
+BEGIN_EXTERN_C()
+
+/* only moved and read atomically, through zend_resolve_cache.c */
+extern ZEND_API uint32_t zend_resolve_epoch;
+
+void zend_resolve_cache_ctor(zend_executor_globals *executor_globals);
+void zend_resolve_cache_dtor(zend_executor_globals *executor_globals);
+
+ZEND_API void zend_resolve_cache_enable(zend_bool enable);
+ZEND_API void zend_resolve_cache_invalidate(void);
+ZEND_API void zend_resolve_cache_flush(void);
+
+ZEND_API zend_function *zend_resolve_cache_find_function(zend_string *key);
+ZEND_API void zend_resolve_cache_add_function(zend_string *key, zend_function *func);
+ZEND_API void zend_resolve_cache_forget_function(zend_string *key);
+
+ZEND_API zend_constant *zend_resolve_cache_find_constant(const char *key, size_t len);
+ZEND_API void zend_resolve_cache_add_constant(const char *key, size_t len, zend_constant *c);
+ZEND_API void zend_resolve_cache_forget_constant(zend_constant *c, zend_string *name);
+
+END_EXTERN_C()
+
+#endif							/* ZEND_RESOLVE_CACHE_H */
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * End:
+ * vim600: sw=4 ts=4 fdm=marker
+ * vim<600: sw=4 ts=4
+ */
@@ -292,7 +292,10 @@ ZEND_API void zend_interned_strings_activate(void)
 
 ZEND_API void zend_interned_strings_deactivate(void)
 {
-	zend_hash_destroy(&CG(interned_strings));
+	/* after a fast reset the table and the strings go with the request heap */
+	if (!(EG(flags) & EG_FLAGS_FAST_RESET)) {
+		zend_hash_destroy(&CG(interned_strings));
+	}
 }
 
 ZEND_API void zend_interned_strings_set_request_storage_handlers(zend_new_interned_string_func_t handler, zend_string_init_interned_func_t init_handler)
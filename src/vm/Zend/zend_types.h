@@ -559,6 +559,9 @@ static zend_always_inline uint32_t zval_gc_info(uint32_t gc_type_info) {
 
 #define OBJ_FLAGS(obj)              GC_FLAGS(obj)
 
+/* resource flags (zval.value->gc.u.flags) */
+#define IS_RSRC_IN_LIST				(1<<9) /* lives in a slot of EG(regular_list) */
+
 /* Recursion protection macros must be used only for arrays and objects */
 #define GC_IS_RECURSIVE(p) \
 	(GC_FLAGS(p) & GC_PROTECTED)
@@ -825,6 +828,8 @@ static zend_always_inline uint32_t zval_gc_info(uint32_t gc_type_info) {
 		Z_TYPE_INFO_P(__z) = IS_RESOURCE_EX;	\
 	} while (0)
 
+/* a resource outside of EG(regular_list), zend_register_resource() is the
+ * way to create a regular one */
 #define ZVAL_NEW_RES(z, h, p, t) do {							\
 		zend_resource *_res =									\
 		(zend_resource *) emalloc(sizeof(zend_resource));		\
@@ -3444,17 +3444,23 @@ ZEND_VM_HOT_HANDLER(69, ZEND_INIT_NS_FCALL_BY_NAME, ANY, CONST, NUM|CACHE_SLOT)
 	fbc = CACHED_PTR(opline->result.num);
 	if (UNEXPECTED(fbc == NULL)) {
 		func_name = RT_CONSTANT(opline, opline->op2) + 1;
-		func = zend_hash_find_ex(EG(function_table), Z_STR_P(func_name), 1);
-		if (func == NULL) {
-			func_name++;
+		fbc = zend_resolve_cache_find_function(Z_STR_P(func_name));
+		if (!fbc) {
 			func = zend_hash_find_ex(EG(function_table), Z_STR_P(func_name), 1);
-			if (UNEXPECTED(func == NULL)) {
-				ZEND_VM_DISPATCH_TO_HELPER(zend_undefined_function_helper, function_name, func_name);
+			if (func == NULL) {
+				func_name++;
+				func = zend_hash_find_ex(EG(function_table), Z_STR_P(func_name), 1);
+				if (UNEXPECTED(func == NULL)) {
+					ZEND_VM_DISPATCH_TO_HELPER(zend_undefined_function_helper, function_name, func_name);
+				}
+				if (Z_FUNC_P(func)->type == ZEND_INTERNAL_FUNCTION) {
+					zend_resolve_cache_add_function(Z_STR_P(func_name - 1), Z_FUNC_P(func));
+				}
+			}
+			fbc = Z_FUNC_P(func);
+			if (EXPECTED(fbc->type == ZEND_USER_FUNCTION) && UNEXPECTED(!fbc->op_array.run_time_cache)) {
+				fbc = init_func_run_time_cache_ex(func);
 			}
-		}
-		fbc = Z_FUNC_P(func);
-		if (EXPECTED(fbc->type == ZEND_USER_FUNCTION) && UNEXPECTED(!fbc->op_array.run_time_cache)) {
-			fbc = init_func_run_time_cache_ex(func);
 		}
 		CACHE_PTR(opline->result.num, fbc);
 	}
@@ -5933,6 +5939,25 @@ ZEND_VM_C_LABEL(fe_fetch_r_exit):
 					ZEND_VM_C_GOTO(fe_fetch_r_exit);
 				}
 			}
+			if (iter->funcs->take_current) {
+				zval entry;
+
+				/* the iterator gives the entry up, it is moved into place */
+				if (UNEXPECTED(iter->funcs->take_current(iter, &entry,
+						RETURN_VALUE_USED(opline) ? EX_VAR(opline->result.var) : NULL) == FAILURE)) {
+					if (UNEXPECTED(EG(exception) != NULL)) {
+						UNDEF_RESULT();
+						HANDLE_EXCEPTION();
+					}
+					ZEND_VM_C_GOTO(fe_fetch_r_exit);
+				}
+				if (EXPECTED(OP2_TYPE == IS_CV)) {
+					zend_assign_to_variable(EX_VAR(opline->op2.var), &entry, IS_TMP_VAR);
+				} else {
+					ZVAL_COPY_VALUE(EX_VAR(opline->op2.var), &entry);
+				}
+				ZEND_VM_NEXT_OPCODE_CHECK_EXCEPTION();
+			}
 			value = iter->funcs->get_current_data(iter);
 			if (UNEXPECTED(EG(exception) != NULL)) {
 				UNDEF_RESULT();
@@ -6083,6 +6108,24 @@ ZEND_VM_HANDLER(126, ZEND_FE_FETCH_RW, VAR, ANY, JMP_ADDR)
 					ZEND_VM_C_GOTO(fe_fetch_w_exit);
 				}
 			}
+			if (iter->funcs->take_current) {
+				zval entry;
+
+				/* the iterator gives the entry up, the new reference owns it */
+				if (UNEXPECTED(iter->funcs->take_current(iter, &entry,
+						RETURN_VALUE_USED(opline) ? EX_VAR(opline->result.var) : NULL) == FAILURE)) {
+					if (UNEXPECTED(EG(exception) != NULL)) {
+						UNDEF_RESULT();
+						HANDLE_EXCEPTION();
+					}
+					ZEND_VM_C_GOTO(fe_fetch_w_exit);
+				}
+				if (EXPECTED(OP2_TYPE == IS_CV)) {
+					zval_ptr_dtor(EX_VAR(opline->op2.var));
+				}
+				ZVAL_NEW_REF(EX_VAR(opline->op2.var), &entry);
+				ZEND_VM_NEXT_OPCODE_CHECK_EXCEPTION();
+			}
 			value = iter->funcs->get_current_data(iter);
 			if (UNEXPECTED(EG(exception) != NULL)) {
 				UNDEF_RESULT();
@@ -2154,17 +2154,23 @@ static ZEND_VM_HOT ZEND_OPCODE_HANDLER_RET ZEND_FASTCALL ZEND_INIT_NS_FCALL_BY_N
 	fbc = CACHED_PTR(opline->result.num);
 	if (UNEXPECTED(fbc == NULL)) {
 		func_name = RT_CONSTANT(opline, opline->op2) + 1;
-		func = zend_hash_find_ex(EG(function_table), Z_STR_P(func_name), 1);
-		if (func == NULL) {
-			func_name++;
+		fbc = zend_resolve_cache_find_function(Z_STR_P(func_name));
+		if (!fbc) {
 			func = zend_hash_find_ex(EG(function_table), Z_STR_P(func_name), 1);
-			if (UNEXPECTED(func == NULL)) {
-				ZEND_VM_TAIL_CALL(zend_undefined_function_helper_SPEC(func_name ZEND_OPCODE_HANDLER_ARGS_PASSTHRU_CC));
+			if (func == NULL) {
+				func_name++;
+				func = zend_hash_find_ex(EG(function_table), Z_STR_P(func_name), 1);
+				if (UNEXPECTED(func == NULL)) {
+					ZEND_VM_TAIL_CALL(zend_undefined_function_helper_SPEC(func_name ZEND_OPCODE_HANDLER_ARGS_PASSTHRU_CC));
+				}
+				if (Z_FUNC_P(func)->type == ZEND_INTERNAL_FUNCTION) {
+					zend_resolve_cache_add_function(Z_STR_P(func_name - 1), Z_FUNC_P(func));
+				}
+			}
+			fbc = Z_FUNC_P(func);
+			if (EXPECTED(fbc->type == ZEND_USER_FUNCTION) && UNEXPECTED(!fbc->op_array.run_time_cache)) {
+				fbc = init_func_run_time_cache_ex(func);
 			}
-		}
-		fbc = Z_FUNC_P(func);
-		if (EXPECTED(fbc->type == ZEND_USER_FUNCTION) && UNEXPECTED(!fbc->op_array.run_time_cache)) {
-			fbc = init_func_run_time_cache_ex(func);
 		}
 		CACHE_PTR(opline->result.num, fbc);
 	}
@@ -21496,6 +21502,25 @@ fe_fetch_r_exit:
 					goto fe_fetch_r_exit;
 				}
 			}
+			if (iter->funcs->take_current) {
+				zval entry;
+
+				/* the iterator gives the entry up, it is moved into place */
+				if (UNEXPECTED(iter->funcs->take_current(iter, &entry,
+						RETURN_VALUE_USED(opline) ? EX_VAR(opline->result.var) : NULL) == FAILURE)) {
+					if (UNEXPECTED(EG(exception) != NULL)) {
+						UNDEF_RESULT();
+						HANDLE_EXCEPTION();
+					}
+					goto fe_fetch_r_exit;
+				}
+				if (EXPECTED(opline->op2_type == IS_CV)) {
+					zend_assign_to_variable(EX_VAR(opline->op2.var), &entry, IS_TMP_VAR);
+				} else {
+					ZVAL_COPY_VALUE(EX_VAR(opline->op2.var), &entry);
+				}
+				ZEND_VM_NEXT_OPCODE_CHECK_EXCEPTION();
+			}
 			value = iter->funcs->get_current_data(iter);
 			if (UNEXPECTED(EG(exception) != NULL)) {
 				UNDEF_RESULT();
@@ -21646,6 +21671,24 @@ static ZEND_OPCODE_HANDLER_RET ZEND_FASTCALL ZEND_FE_FETCH_RW_SPEC_VAR_HANDLER(Z
 					goto fe_fetch_w_exit;
 				}
 			}
+			if (iter->funcs->take_current) {
+				zval entry;
+
+				/* the iterator gives the entry up, the new reference owns it */
+				if (UNEXPECTED(iter->funcs->take_current(iter, &entry,
+						RETURN_VALUE_USED(opline) ? EX_VAR(opline->result.var) : NULL) == FAILURE)) {
+					if (UNEXPECTED(EG(exception) != NULL)) {
+						UNDEF_RESULT();
+						HANDLE_EXCEPTION();
+					}
+					goto fe_fetch_w_exit;
+				}
+				if (EXPECTED(opline->op2_type == IS_CV)) {
+					zval_ptr_dtor(EX_VAR(opline->op2.var));
+				}
+				ZVAL_NEW_REF(EX_VAR(opline->op2.var), &entry);
+				ZEND_VM_NEXT_OPCODE_CHECK_EXCEPTION();
+			}
 			value = iter->funcs->get_current_data(iter);
 			if (UNEXPECTED(EG(exception) != NULL)) {
 				UNDEF_RESULT();
@@ -46,15 +46,18 @@ namespace
 std::map<std::string, Module *> name2extension;
 std::map<int, Module *> mid2extension;
 
-int match_module(zval *value)
-{
-   zend_module_entry *entry = static_cast<zend_module_entry *>(Z_PTR_P(value));
-   auto iter = name2extension.find(entry->name);
-   if (iter == name2extension.end()) {
-      return ZEND_HASH_APPLY_KEEP;
-   }
-   mid2extension[entry->module_number] = iter->second;
-   return ZEND_HASH_APPLY_KEEP;
+void match_modules()
+{
+   void *ptr;
+   zend_rcu_read_lock();
+   ZEND_HASH_FOREACH_PTR(RCU_HASH(&module_registry), ptr) {
+      zend_module_entry *entry = static_cast<zend_module_entry *>(ptr);
+      auto iter = name2extension.find(entry->name);
+      if (iter != name2extension.end()) {
+         mid2extension[entry->module_number] = iter->second;
+      }
+   } ZEND_HASH_FOREACH_END();
+   zend_rcu_read_unlock();
 }
 
 Module *find_module(int mid)
@@ -63,7 +66,7 @@ Module *find_module(int mid)
    if (iter != mid2extension.end()) {
       return iter->second;
    }
-   zend_hash_apply(&module_registry, match_module);
+   match_modules();
    iter = mid2extension.find(mid);
    if (iter == mid2extension.end()) {
       return nullptr;
@@ -39,5 +39,10 @@ AbstractIterator::AbstractIterator(StdClass *nativeObject)
 AbstractIterator::~AbstractIterator()
 {}
 
+bool AbstractIterator::fetch(IteratorBatch &)
+{
+   return false;
+}
+
 } // vmapi
 } // polar
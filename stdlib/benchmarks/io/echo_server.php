@@ -0,0 +1,115 @@
+<?php
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+// local echo server benchmark for php\io\EventLoop, server and clients are
+// coroutines on one loop, so the number measures the loop and the vm, not
+// the network
+//
+//   polar echo_server.php [connections] [seconds] [port]
+
+use php\io\EventLoop;
+use php\io\Stream;
+
+$connections = isset($argv[1]) ? intval($argv[1]) : 64;
+$seconds = isset($argv[2]) ? intval($argv[2]) : 5;
+$port = isset($argv[3]) ? intval($argv[3]) : 19080;
+$message = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+$roundTrips = 0;
+$running = true;
+
+function serve_client(Stream $client)
+{
+   while (true) {
+      yield 'readable' => $client;
+      $data = $client->read(65536);
+      if ($data === null) {
+         continue;
+      }
+      if ($data === false) {
+         $client->close();
+         return;
+      }
+      while (($written = $client->write($data)) === 0) {
+         yield 'writable' => $client;
+      }
+      if ($written === false) {
+         $client->close();
+         return;
+      }
+   }
+}
+
+function accept_clients(EventLoop $loop, Stream $server)
+{
+   while (true) {
+      yield 'readable' => $server;
+      while (($client = $server->accept()) instanceof Stream) {
+         $loop->spawn(serve_client($client));
+      }
+   }
+}
+
+function run_client(int $port, string $message)
+{
+   global $roundTrips, $running;
+   $stream = Stream::connect("127.0.0.1", $port);
+   if (!$stream) {
+      return;
+   }
+   yield 'writable' => $stream;
+   if ($stream->getSocketError() != 0) {
+      $stream->close();
+      return;
+   }
+   $length = strlen($message);
+   while ($running) {
+      $stream->write($message);
+      $received = 0;
+      while ($received < $length) {
+         yield 'readable' => $stream;
+         $chunk = $stream->read(65536);
+         if ($chunk === false) {
+            $stream->close();
+            return;
+         }
+         if ($chunk !== null) {
+            $received += strlen($chunk);
+         }
+      }
+      ++$roundTrips;
+   }
+   $stream->close();
+}
+
+$loop = new EventLoop();
+$server = Stream::listen("127.0.0.1", $port);
+if (!$server) {
+   echo "unable to listen on port $port\n";
+   exit(1);
+}
+$loop->spawn(accept_clients($loop, $server));
+for ($i = 0; $i < $connections; ++$i) {
+   $loop->spawn(run_client($port, $message));
+}
+$loop->addTimer($seconds * 1000, function () use ($loop) {
+   global $running;
+   $running = false;
+   $loop->stop();
+});
+$loop->run();
+$server->close();
+
+echo "connections:    $connections\n";
+echo "message bytes:  " . strlen($message) . "\n";
+echo "round trips:    $roundTrips\n";
+echo "round trips/s:  " . (int) ($roundTrips / $seconds) . "\n";
@@ -12,6 +12,7 @@
 #ifndef POLARPHP_STDLIB_KERNEL_UTILS_H
 #define POLARPHP_STDLIB_KERNEL_UTILS_H
 
+#include <cstddef>
 #include <string>
 
 namespace php {
@@ -22,6 +23,7 @@ int retrieve_major_version();
 int retrieve_minor_version();
 int retrieve_patch_version();
 int retrieve_version_id();
+bool is_valid_utf8(const char *str, std::size_t length);
 
 } // kernel
 } // php
@@ -0,0 +1,115 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_STDLIB_KERNEL_IO_EVENT_LOOP_H
+#define POLARPHP_STDLIB_KERNEL_IO_EVENT_LOOP_H
+
+#include "php/kernel/io/TimerWheel.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace polar {
+namespace utils {
+class ThreadPool;
+} // utils
+} // polar
+
+namespace php {
+namespace kernel {
+namespace io {
+
+///
+/// single threaded readiness loop, epoll on linux, other platforms have
+/// no backend yet and isValid() returns false
+///
+/// everything except post() must be called from the thread running the
+/// loop, file i/o runs on a small worker pool and its completion is posted
+/// back, so callbacks always run on the loop thread
+///
+class EventLoop
+{
+public:
+   using IoCallback = std::function<void()>;
+   using Task = std::function<void()>;
+   using FileCallback = std::function<void(bool ok, std::string &&data, int errorCode)>;
+
+   EventLoop();
+   EventLoop(const EventLoop &) = delete;
+   EventLoop &operator=(const EventLoop &) = delete;
+   ~EventLoop();
+
+   bool isValid() const;
+
+   /// hang-up and error conditions are reported to both callbacks
+   bool watchReadable(int fd, IoCallback callback);
+   bool watchWritable(int fd, IoCallback callback);
+   bool unwatchReadable(int fd);
+   bool unwatchWritable(int fd);
+   bool unwatch(int fd);
+
+   TimerWheel::TimerId addTimer(std::chrono::milliseconds delay, Task task,
+                                std::chrono::milliseconds interval = std::chrono::milliseconds(0));
+   bool cancelTimer(TimerWheel::TimerId id);
+
+   /// thread safe, task runs on the loop thread during the next iteration
+   void post(Task task);
+
+   void readFile(const std::string &path, FileCallback callback);
+   void writeFile(const std::string &path, std::string data, bool append, FileCallback callback);
+
+   /// wait at most timeoutMs (-1 forever) and dispatch what is ready
+   bool runOnce(int timeoutMs = -1);
+   /// run until stop() or until there is nothing left to wait for
+   void run();
+   void stop();
+   bool isAlive() const;
+
+private:
+   struct Watcher
+   {
+      IoCallback onReadable;
+      IoCallback onWritable;
+   };
+
+   bool updateWatcher(int fd, Watcher &watcher, bool isNew);
+   std::uint64_t addFileOp(FileCallback callback);
+   void finishFileOp(std::uint64_t id, bool ok, std::string &&data, int errorCode);
+   void runPostedTasks();
+   void wakeup();
+   polar::utils::ThreadPool &getWorkers();
+
+private:
+   int m_pollFd;
+   int m_wakeupFd;
+   bool m_stopped;
+   std::unordered_map<int, Watcher> m_watchers;
+   TimerWheel m_timers;
+   mutable std::mutex m_postedMutex;
+   std::vector<Task> m_postedTasks;
+   std::atomic<bool> m_wakeupPending;
+   /// callbacks of the file operations in flight, only touched on the loop
+   /// thread. they may hold zvals, so the workers only ever see the id
+   std::unordered_map<std::uint64_t, FileCallback> m_fileCallbacks;
+   std::uint64_t m_nextFileOpId;
+   std::unique_ptr<polar::utils::ThreadPool> m_workers;
+};
+
+} // io
+} // kernel
+} // php
+
+#endif // POLARPHP_STDLIB_KERNEL_IO_EVENT_LOOP_H
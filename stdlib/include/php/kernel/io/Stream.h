@@ -0,0 +1,83 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_STDLIB_KERNEL_IO_STREAM_H
+#define POLARPHP_STDLIB_KERNEL_IO_STREAM_H
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+namespace php {
+namespace kernel {
+namespace io {
+
+enum class IoStatus
+{
+   Ok,
+   WouldBlock,
+   Eof,
+   Error
+};
+
+///
+/// owning wrapper of a non-blocking socket or pipe descriptor, read and
+/// write never block, they report WouldBlock and the caller is expected
+/// to wait for readiness on an EventLoop
+///
+class Stream
+{
+public:
+   explicit Stream(int fd = -1);
+   Stream(Stream &&other) noexcept;
+   Stream &operator=(Stream &&other) noexcept;
+   Stream(const Stream &) = delete;
+   Stream &operator=(const Stream &) = delete;
+   ~Stream();
+
+   static Stream listenTcp(const std::string &host, int port, int backlog, std::string &error);
+   /// the connection may still be in progress, wait for writable then check getSocketError
+   static Stream connectTcp(const std::string &host, int port, std::string &error);
+   static bool openPipe(Stream &reader, Stream &writer, std::string &error);
+
+   Stream accept(IoStatus &status);
+   IoStatus read(char *buffer, std::size_t size, std::size_t &bytesRead);
+   IoStatus write(const char *data, std::size_t size, std::size_t &bytesWritten);
+   int getSocketError() const;
+   void close();
+
+   int getFd() const
+   {
+      return m_fd;
+   }
+
+   bool isOpen() const
+   {
+      return m_fd >= 0;
+   }
+
+   int getLastError() const
+   {
+      return m_lastError;
+   }
+
+private:
+   int m_fd;
+   int m_lastError;
+};
+
+bool set_fd_nonblocking(int fd);
+
+} // io
+} // kernel
+} // php
+
+#endif // POLARPHP_STDLIB_KERNEL_IO_STREAM_H
@@ -0,0 +1,93 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_STDLIB_KERNEL_IO_TIMER_WHEEL_H
+#define POLARPHP_STDLIB_KERNEL_IO_TIMER_WHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace php {
+namespace kernel {
+namespace io {
+
+///
+/// hashed timing wheel, a timer lands in slot (expire tick % slot count),
+/// scheduling and cancelling are O(1) and advancing only visits the slots
+/// the clock moved over, timers further away than one revolution simply
+/// stay in their slot until their tick comes round
+///
+class TimerWheel
+{
+public:
+   using Clock = std::chrono::steady_clock;
+   using TimerId = std::uint64_t;
+   using Callback = std::function<void(TimerId)>;
+
+   explicit TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(1),
+                       std::size_t slotCount = 512);
+   TimerWheel(const TimerWheel &) = delete;
+   TimerWheel &operator=(const TimerWheel &) = delete;
+
+   /// interval of zero means one shot
+   TimerId schedule(std::chrono::milliseconds delay, Callback callback,
+                    std::chrono::milliseconds interval = std::chrono::milliseconds(0));
+   bool cancel(TimerId id);
+   /// run every timer that expired up to now, returns the number fired
+   std::size_t advance(Clock::time_point now = Clock::now());
+   /// milliseconds until the nearest timer, -1 when there is none
+   int getNextTimeout(Clock::time_point now = Clock::now()) const;
+
+   bool isEmpty() const
+   {
+      return m_index.empty();
+   }
+
+   std::size_t getSize() const
+   {
+      return m_index.size();
+   }
+
+private:
+   struct Timer
+   {
+      TimerId id;
+      std::uint64_t expireTick;
+      std::uint64_t intervalTicks;
+      Callback callback;
+   };
+   using TimerList = std::list<Timer>;
+
+   std::uint64_t getTick(Clock::time_point now) const;
+   std::uint64_t toTicks(std::chrono::milliseconds duration) const;
+   void insert(Timer &&timer);
+
+private:
+   std::chrono::milliseconds m_resolution;
+   Clock::time_point m_origin;
+   std::uint64_t m_currentTick;
+   TimerId m_nextId;
+   std::vector<TimerList> m_slots;
+   /// timers taken off the wheel by advance and not fired yet, kept here
+   /// so a callback can still cancel a timer that expired in the same pass
+   TimerList m_expired;
+   std::unordered_map<TimerId, std::pair<TimerList *, TimerList::iterator>> m_index;
+};
+
+} // io
+} // kernel
+} // php
+
+#endif // POLARPHP_STDLIB_KERNEL_IO_TIMER_WHEEL_H
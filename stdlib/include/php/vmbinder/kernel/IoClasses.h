@@ -0,0 +1,110 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#ifndef POLARPHP_STDLIB_VMBINDER_KERNEL_IO_CLASSES_H
+#define POLARPHP_STDLIB_VMBINDER_KERNEL_IO_CLASSES_H
+
+#include "polarphp/vm/ZendApi.h"
+#include "polarphp/vm/StdClass.h"
+#include "polarphp/vm/ds/Variant.h"
+#include "polarphp/vm/ds/ObjectVariant.h"
+#include "php/kernel/io/EventLoop.h"
+#include "php/kernel/io/Stream.h"
+
+#include <memory>
+
+namespace php {
+namespace vmbinder {
+
+using polar::vmapi::StdClass;
+using polar::vmapi::Variant;
+using polar::vmapi::ObjectVariant;
+using polar::vmapi::Parameters;
+
+extern const char *sg_ioStreamClassName;
+extern const char *sg_ioEventLoopClassName;
+
+///
+/// php\io\Stream, read() returns the data read, null when nothing is
+/// available yet and false at end of stream or on error
+///
+class IoStream : public StdClass
+{
+public:
+   IoStream();
+   explicit IoStream(kernel::io::Stream &&stream);
+
+   static Variant listen(Parameters &args);
+   static Variant connect(Parameters &args);
+   static Variant pipe();
+
+   Variant accept();
+   Variant read(Parameters &args);
+   Variant write(Parameters &args);
+   int getSocketError();
+   int getLastError();
+   int getFd();
+   bool isOpen();
+   void close();
+
+   kernel::io::Stream &getStream()
+   {
+      return m_stream;
+   }
+
+   static IoStream *fromObject(const Variant &object);
+
+private:
+   kernel::io::Stream m_stream;
+};
+
+///
+/// php\io\EventLoop, callbacks and coroutines run on the thread calling
+/// run(), a coroutine is a Generator that yields what it waits for:
+///
+///   yield 'readable' => $stream;
+///   yield 'writable' => $stream;
+///   yield 'sleep' => $milliseconds;
+///   $data = yield 'readfile' => $path;
+///
+/// any other yield hands control back to the loop for one iteration
+///
+class IoEventLoop : public StdClass
+{
+public:
+   IoEventLoop();
+   ~IoEventLoop();
+
+   bool onReadable(Parameters &args);
+   bool onWritable(Parameters &args);
+   bool cancel(Parameters &args);
+   Variant addTimer(Parameters &args);
+   bool cancelTimer(Parameters &args);
+   void readFile(Parameters &args);
+   void writeFile(Parameters &args);
+   bool spawn(Parameters &args);
+   void run();
+   void stop();
+
+private:
+   void resume(ObjectVariant coroutine, const Variant &value, bool started);
+   bool suspend(ObjectVariant &coroutine);
+   bool shouldAbort() const;
+
+private:
+   std::unique_ptr<kernel::io::EventLoop> m_loop;
+   bool m_stopRequested;
+};
+
+} // vmbinder
+} // php
+
+#endif // POLARPHP_STDLIB_VMBINDER_KERNEL_IO_CLASSES_H
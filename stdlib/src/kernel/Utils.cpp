@@ -11,6 +11,7 @@
 
 #include "php/kernel/Utils.h"
 #include "polarphp/global/PolarVersion.h"
+#include "polarphp/utils/ConvertUtf.h"
 
 namespace php {
 namespace kernel {
@@ -40,5 +41,11 @@ int retrieve_version_id()
    return POLARPHP_VERSION_ID;
 }
 
+bool is_valid_utf8(const char *str, std::size_t length)
+{
+   const polar::utils::Utf8 *source = reinterpret_cast<const polar::utils::Utf8 *>(str);
+   return polar::utils::find_invalid_utf8(source, source + length) == source + length;
+}
+
 } // kernel
 } // php
@@ -0,0 +1,399 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "php/kernel/io/EventLoop.h"
+#include "polarphp/global/SystemDetection.h"
+#include "polarphp/utils/ThreadPool.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef POLAR_OS_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace php {
+namespace kernel {
+namespace io {
+
+namespace {
+
+constexpr unsigned POLAR_IO_WORKER_COUNT = 4;
+constexpr int POLAR_IO_MAX_EVENTS = 64;
+
+bool read_whole_file(const std::string &path, std::string &data, int &errorCode)
+{
+   int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0) {
+      errorCode = errno;
+      return false;
+   }
+   struct stat info;
+   if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+      data.reserve(static_cast<std::size_t>(info.st_size));
+   }
+   char buffer[16384];
+   while (true) {
+      ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+      if (bytes > 0) {
+         data.append(buffer, static_cast<std::size_t>(bytes));
+         continue;
+      }
+      if (bytes < 0 && errno == EINTR) {
+         continue;
+      }
+      if (bytes < 0) {
+         errorCode = errno;
+      }
+      break;
+   }
+   ::close(fd);
+   return errorCode == 0;
+}
+
+bool write_whole_file(const std::string &path, const std::string &data, bool append, int &errorCode)
+{
+   int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+   int fd = ::open(path.c_str(), flags, 0666);
+   if (fd < 0) {
+      errorCode = errno;
+      return false;
+   }
+   std::size_t written = 0;
+   while (written < data.size()) {
+      ssize_t bytes = ::write(fd, data.data() + written, data.size() - written);
+      if (bytes < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         errorCode = errno;
+         break;
+      }
+      written += static_cast<std::size_t>(bytes);
+   }
+   ::close(fd);
+   return errorCode == 0;
+}
+
+} // anonymous namespace
+
+EventLoop::EventLoop()
+   : m_pollFd(-1),
+     m_wakeupFd(-1),
+     m_stopped(false),
+     m_wakeupPending(false),
+     m_nextFileOpId(1)
+{
+#ifdef POLAR_OS_LINUX
+   m_pollFd = ::epoll_create1(EPOLL_CLOEXEC);
+   m_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (m_pollFd >= 0 && m_wakeupFd >= 0) {
+      struct epoll_event event;
+      event.events = EPOLLIN;
+      event.data.fd = m_wakeupFd;
+      ::epoll_ctl(m_pollFd, EPOLL_CTL_ADD, m_wakeupFd, &event);
+   }
+#endif
+}
+
+EventLoop::~EventLoop()
+{
+   /// joins the workers, their completions are posted and simply dropped
+   m_workers.reset();
+   if (m_wakeupFd >= 0) {
+      ::close(m_wakeupFd);
+   }
+   if (m_pollFd >= 0) {
+      ::close(m_pollFd);
+   }
+}
+
+bool EventLoop::isValid() const
+{
+   return m_pollFd >= 0 && m_wakeupFd >= 0;
+}
+
+bool EventLoop::updateWatcher(int fd, Watcher &watcher, bool isNew)
+{
+#ifdef POLAR_OS_LINUX
+   struct epoll_event event;
+   event.events = 0;
+   if (watcher.onReadable) {
+      event.events |= EPOLLIN | EPOLLRDHUP;
+   }
+   if (watcher.onWritable) {
+      event.events |= EPOLLOUT;
+   }
+   event.data.fd = fd;
+   if (event.events == 0) {
+      ::epoll_ctl(m_pollFd, EPOLL_CTL_DEL, fd, nullptr);
+      m_watchers.erase(fd);
+      return true;
+   }
+   if (::epoll_ctl(m_pollFd, isNew ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) == 0) {
+      return true;
+   }
+   /// the descriptor was closed while watched and its number got reused
+   if (!isNew && errno == ENOENT) {
+      return ::epoll_ctl(m_pollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+   }
+   return false;
+#else
+   (void) fd;
+   (void) watcher;
+   (void) isNew;
+   return false;
+#endif
+}
+
+bool EventLoop::watchReadable(int fd, IoCallback callback)
+{
+   auto result = m_watchers.emplace(fd, Watcher());
+   Watcher &watcher = result.first->second;
+   IoCallback previous = std::move(watcher.onReadable);
+   watcher.onReadable = std::move(callback);
+   if (!updateWatcher(fd, watcher, result.second)) {
+      if (result.second) {
+         m_watchers.erase(result.first);
+      } else {
+         watcher.onReadable = std::move(previous);
+      }
+      return false;
+   }
+   return true;
+}
+
+bool EventLoop::watchWritable(int fd, IoCallback callback)
+{
+   auto result = m_watchers.emplace(fd, Watcher());
+   Watcher &watcher = result.first->second;
+   IoCallback previous = std::move(watcher.onWritable);
+   watcher.onWritable = std::move(callback);
+   if (!updateWatcher(fd, watcher, result.second)) {
+      if (result.second) {
+         m_watchers.erase(result.first);
+      } else {
+         watcher.onWritable = std::move(previous);
+      }
+      return false;
+   }
+   return true;
+}
+
+bool EventLoop::unwatchReadable(int fd)
+{
+   auto iter = m_watchers.find(fd);
+   if (iter == m_watchers.end() || !iter->second.onReadable) {
+      return false;
+   }
+   iter->second.onReadable = nullptr;
+   return updateWatcher(fd, iter->second, false);
+}
+
+bool EventLoop::unwatchWritable(int fd)
+{
+   auto iter = m_watchers.find(fd);
+   if (iter == m_watchers.end() || !iter->second.onWritable) {
+      return false;
+   }
+   iter->second.onWritable = nullptr;
+   return updateWatcher(fd, iter->second, false);
+}
+
+bool EventLoop::unwatch(int fd)
+{
+   auto iter = m_watchers.find(fd);
+   if (iter == m_watchers.end()) {
+      return false;
+   }
+   iter->second.onReadable = nullptr;
+   iter->second.onWritable = nullptr;
+   return updateWatcher(fd, iter->second, false);
+}
+
+TimerWheel::TimerId EventLoop::addTimer(std::chrono::milliseconds delay, Task task,
+                                        std::chrono::milliseconds interval)
+{
+   return m_timers.schedule(delay, [task](TimerWheel::TimerId) {
+      task();
+   }, interval);
+}
+
+bool EventLoop::cancelTimer(TimerWheel::TimerId id)
+{
+   return m_timers.cancel(id);
+}
+
+void EventLoop::post(Task task)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_postedMutex);
+      m_postedTasks.push_back(std::move(task));
+   }
+   wakeup();
+}
+
+void EventLoop::wakeup()
+{
+   if (m_wakeupFd < 0 || m_wakeupPending.exchange(true)) {
+      return;
+   }
+   std::uint64_t value = 1;
+   ssize_t bytes;
+   do {
+      bytes = ::write(m_wakeupFd, &value, sizeof(value));
+   } while (bytes < 0 && errno == EINTR);
+}
+
+void EventLoop::runPostedTasks()
+{
+   std::vector<Task> tasks;
+   {
+      std::lock_guard<std::mutex> lock(m_postedMutex);
+      tasks.swap(m_postedTasks);
+   }
+   for (Task &task : tasks) {
+      task();
+   }
+}
+
+polar::utils::ThreadPool &EventLoop::getWorkers()
+{
+   if (!m_workers) {
+      m_workers.reset(new polar::utils::ThreadPool(POLAR_IO_WORKER_COUNT));
+   }
+   return *m_workers;
+}
+
+std::uint64_t EventLoop::addFileOp(FileCallback callback)
+{
+   std::uint64_t id = m_nextFileOpId++;
+   m_fileCallbacks.emplace(id, std::move(callback));
+   return id;
+}
+
+void EventLoop::finishFileOp(std::uint64_t id, bool ok, std::string &&data, int errorCode)
+{
+   auto iter = m_fileCallbacks.find(id);
+   if (iter == m_fileCallbacks.end()) {
+      return;
+   }
+   /// erased first, isAlive() must not count an operation whose callback
+   /// already runs
+   FileCallback callback = std::move(iter->second);
+   m_fileCallbacks.erase(iter);
+   callback(ok, std::move(data), errorCode);
+}
+
+void EventLoop::readFile(const std::string &path, FileCallback callback)
+{
+   std::uint64_t id = addFileOp(std::move(callback));
+   getWorkers().async([this, id, path]() {
+      std::string data;
+      int errorCode = 0;
+      bool ok = read_whole_file(path, data, errorCode);
+      post([this, id, ok, errorCode, data = std::move(data)]() mutable {
+         finishFileOp(id, ok, std::move(data), errorCode);
+      });
+   });
+}
+
+void EventLoop::writeFile(const std::string &path, std::string data, bool append, FileCallback callback)
+{
+   std::uint64_t id = addFileOp(std::move(callback));
+   getWorkers().async([this, id, path, data = std::move(data), append]() {
+      int errorCode = 0;
+      bool ok = write_whole_file(path, data, append, errorCode);
+      post([this, id, ok, errorCode]() {
+         finishFileOp(id, ok, std::string(), errorCode);
+      });
+   });
+}
+
+bool EventLoop::isAlive() const
+{
+   if (!m_watchers.empty() || !m_timers.isEmpty() || !m_fileCallbacks.empty()) {
+      return true;
+   }
+   std::lock_guard<std::mutex> lock(m_postedMutex);
+   return !m_postedTasks.empty();
+}
+
+bool EventLoop::runOnce(int timeoutMs)
+{
+#ifdef POLAR_OS_LINUX
+   if (!isValid()) {
+      return false;
+   }
+   int timerTimeout = m_timers.getNextTimeout();
+   if (timerTimeout >= 0 && (timeoutMs < 0 || timerTimeout < timeoutMs)) {
+      timeoutMs = timerTimeout;
+   }
+   struct epoll_event events[POLAR_IO_MAX_EVENTS];
+   int count = ::epoll_wait(m_pollFd, events, POLAR_IO_MAX_EVENTS, timeoutMs);
+   if (count < 0 && errno != EINTR) {
+      return false;
+   }
+   for (int i = 0; i < count; ++i) {
+      int fd = events[i].data.fd;
+      std::uint32_t mask = events[i].events;
+      if (fd == m_wakeupFd) {
+         std::uint64_t value;
+         while (::read(m_wakeupFd, &value, sizeof(value)) > 0) {}
+         m_wakeupPending.store(false);
+         runPostedTasks();
+         continue;
+      }
+      bool failed = (mask & (EPOLLERR | EPOLLHUP)) != 0;
+      /// callbacks may unwatch or close the fd, look the watcher up every time
+      auto iter = m_watchers.find(fd);
+      if (iter != m_watchers.end() && iter->second.onReadable &&
+          (failed || (mask & (EPOLLIN | EPOLLRDHUP)))) {
+         IoCallback callback = iter->second.onReadable;
+         callback();
+         iter = m_watchers.find(fd);
+      }
+      if (iter != m_watchers.end() && iter->second.onWritable &&
+          (failed || (mask & EPOLLOUT))) {
+         IoCallback callback = iter->second.onWritable;
+         callback();
+      }
+   }
+   m_timers.advance();
+   return true;
+#else
+   (void) timeoutMs;
+   return false;
+#endif
+}
+
+void EventLoop::run()
+{
+   m_stopped = false;
+   while (!m_stopped && isAlive()) {
+      if (!runOnce(-1)) {
+         break;
+      }
+   }
+}
+
+void EventLoop::stop()
+{
+   m_stopped = true;
+   wakeup();
+}
+
+} // io
+} // kernel
+} // php
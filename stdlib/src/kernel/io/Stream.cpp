@@ -0,0 +1,273 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "php/kernel/io/Stream.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace php {
+namespace kernel {
+namespace io {
+
+namespace {
+
+inline bool is_would_block(int errorCode)
+{
+   return errorCode == EAGAIN || errorCode == EWOULDBLOCK;
+}
+
+bool set_fd_cloexec(int fd)
+{
+   int flags = ::fcntl(fd, F_GETFD);
+   return flags >= 0 && ::fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == 0;
+}
+
+struct addrinfo *resolve_tcp_address(const std::string &host, int port, bool passive, std::string &error)
+{
+   struct addrinfo hints;
+   std::memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags = passive ? AI_PASSIVE : 0;
+   struct addrinfo *result = nullptr;
+   std::string service = std::to_string(port);
+   int code = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &result);
+   if (code != 0) {
+      error = ::gai_strerror(code);
+      return nullptr;
+   }
+   return result;
+}
+
+int open_stream_socket(const struct addrinfo *addr)
+{
+   int fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+   if (fd < 0) {
+      return -1;
+   }
+   if (!set_fd_nonblocking(fd) || !set_fd_cloexec(fd)) {
+      ::close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+} // anonymous namespace
+
+bool set_fd_nonblocking(int fd)
+{
+   int flags = ::fcntl(fd, F_GETFL);
+   return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+Stream::Stream(int fd)
+   : m_fd(fd),
+     m_lastError(0)
+{}
+
+Stream::Stream(Stream &&other) noexcept
+   : m_fd(other.m_fd),
+     m_lastError(other.m_lastError)
+{
+   other.m_fd = -1;
+}
+
+Stream &Stream::operator=(Stream &&other) noexcept
+{
+   if (this != &other) {
+      close();
+      m_fd = other.m_fd;
+      m_lastError = other.m_lastError;
+      other.m_fd = -1;
+   }
+   return *this;
+}
+
+Stream::~Stream()
+{
+   close();
+}
+
+Stream Stream::listenTcp(const std::string &host, int port, int backlog, std::string &error)
+{
+   struct addrinfo *addrs = resolve_tcp_address(host, port, true, error);
+   if (!addrs) {
+      return Stream();
+   }
+   int fd = -1;
+   for (struct addrinfo *addr = addrs; addr; addr = addr->ai_next) {
+      fd = open_stream_socket(addr);
+      if (fd < 0) {
+         continue;
+      }
+      int reuse = 1;
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      if (::bind(fd, addr->ai_addr, addr->ai_addrlen) == 0 && ::listen(fd, backlog) == 0) {
+         break;
+      }
+      ::close(fd);
+      fd = -1;
+   }
+   if (fd < 0) {
+      error = std::strerror(errno);
+   }
+   ::freeaddrinfo(addrs);
+   return Stream(fd);
+}
+
+Stream Stream::connectTcp(const std::string &host, int port, std::string &error)
+{
+   struct addrinfo *addrs = resolve_tcp_address(host, port, false, error);
+   if (!addrs) {
+      return Stream();
+   }
+   int fd = -1;
+   for (struct addrinfo *addr = addrs; addr; addr = addr->ai_next) {
+      fd = open_stream_socket(addr);
+      if (fd < 0) {
+         continue;
+      }
+      if (::connect(fd, addr->ai_addr, addr->ai_addrlen) == 0 || errno == EINPROGRESS) {
+         int noDelay = 1;
+         ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+         break;
+      }
+      ::close(fd);
+      fd = -1;
+   }
+   if (fd < 0) {
+      error = std::strerror(errno);
+   }
+   ::freeaddrinfo(addrs);
+   return Stream(fd);
+}
+
+bool Stream::openPipe(Stream &reader, Stream &writer, std::string &error)
+{
+   int fds[2];
+   if (::pipe(fds) != 0) {
+      error = std::strerror(errno);
+      return false;
+   }
+   for (int fd : fds) {
+      if (!set_fd_nonblocking(fd) || !set_fd_cloexec(fd)) {
+         error = std::strerror(errno);
+         ::close(fds[0]);
+         ::close(fds[1]);
+         return false;
+      }
+   }
+   reader = Stream(fds[0]);
+   writer = Stream(fds[1]);
+   return true;
+}
+
+Stream Stream::accept(IoStatus &status)
+{
+   while (true) {
+      int fd = ::accept(m_fd, nullptr, nullptr);
+      if (fd >= 0) {
+         if (!set_fd_nonblocking(fd) || !set_fd_cloexec(fd)) {
+            m_lastError = errno;
+            ::close(fd);
+            status = IoStatus::Error;
+            return Stream();
+         }
+         int noDelay = 1;
+         ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+         status = IoStatus::Ok;
+         return Stream(fd);
+      }
+      if (errno == EINTR) {
+         continue;
+      }
+      m_lastError = errno;
+      status = is_would_block(errno) ? IoStatus::WouldBlock : IoStatus::Error;
+      return Stream();
+   }
+}
+
+IoStatus Stream::read(char *buffer, std::size_t size, std::size_t &bytesRead)
+{
+   bytesRead = 0;
+   while (true) {
+      ssize_t bytes = ::read(m_fd, buffer, size);
+      if (bytes > 0) {
+         bytesRead = static_cast<std::size_t>(bytes);
+         return IoStatus::Ok;
+      }
+      if (bytes == 0) {
+         return size == 0 ? IoStatus::Ok : IoStatus::Eof;
+      }
+      if (errno == EINTR) {
+         continue;
+      }
+      m_lastError = errno;
+      return is_would_block(errno) ? IoStatus::WouldBlock : IoStatus::Error;
+   }
+}
+
+IoStatus Stream::write(const char *data, std::size_t size, std::size_t &bytesWritten)
+{
+   bytesWritten = 0;
+   while (bytesWritten < size) {
+#ifdef MSG_NOSIGNAL
+      ssize_t bytes = ::send(m_fd, data + bytesWritten, size - bytesWritten, MSG_NOSIGNAL);
+      if (bytes < 0 && errno == ENOTSOCK) {
+         bytes = ::write(m_fd, data + bytesWritten, size - bytesWritten);
+      }
+#else
+      ssize_t bytes = ::write(m_fd, data + bytesWritten, size - bytesWritten);
+#endif
+      if (bytes >= 0) {
+         bytesWritten += static_cast<std::size_t>(bytes);
+         continue;
+      }
+      if (errno == EINTR) {
+         continue;
+      }
+      m_lastError = errno;
+      if (is_would_block(errno)) {
+         return bytesWritten > 0 ? IoStatus::Ok : IoStatus::WouldBlock;
+      }
+      return IoStatus::Error;
+   }
+   return IoStatus::Ok;
+}
+
+int Stream::getSocketError() const
+{
+   int code = 0;
+   socklen_t length = sizeof(code);
+   if (::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &code, &length) != 0) {
+      return errno;
+   }
+   return code;
+}
+
+void Stream::close()
+{
+   if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+   }
+}
+
+} // io
+} // kernel
+} // php
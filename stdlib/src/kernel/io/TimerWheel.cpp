@@ -0,0 +1,153 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "php/kernel/io/TimerWheel.h"
+
+#include <algorithm>
+
+namespace php {
+namespace kernel {
+namespace io {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds resolution, std::size_t slotCount)
+   : m_resolution(std::max(resolution, std::chrono::milliseconds(1))),
+     m_origin(Clock::now()),
+     m_currentTick(0),
+     m_nextId(1),
+     m_slots(std::max<std::size_t>(slotCount, 1))
+{}
+
+std::uint64_t TimerWheel::getTick(Clock::time_point now) const
+{
+   if (now <= m_origin) {
+      return 0;
+   }
+   auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_origin);
+   return static_cast<std::uint64_t>(elapsed.count() / m_resolution.count());
+}
+
+std::uint64_t TimerWheel::toTicks(std::chrono::milliseconds duration) const
+{
+   if (duration.count() <= 0) {
+      return 0;
+   }
+   /// round up, a timer must never fire early
+   return static_cast<std::uint64_t>((duration.count() + m_resolution.count() - 1) / m_resolution.count());
+}
+
+void TimerWheel::insert(Timer &&timer)
+{
+   TimerList &slot = m_slots[timer.expireTick % m_slots.size()];
+   TimerId id = timer.id;
+   slot.push_back(std::move(timer));
+   m_index[id] = std::make_pair(&slot, std::prev(slot.end()));
+}
+
+TimerWheel::TimerId TimerWheel::schedule(std::chrono::milliseconds delay, Callback callback,
+                                         std::chrono::milliseconds interval)
+{
+   std::uint64_t base = std::max(m_currentTick, getTick(Clock::now()));
+   Timer timer;
+   timer.id = m_nextId++;
+   /// the current slot was already visited, the earliest we can fire is the next one
+   timer.expireTick = std::max(base + toTicks(delay), m_currentTick + 1);
+   timer.intervalTicks = interval.count() > 0 ? std::max<std::uint64_t>(toTicks(interval), 1) : 0;
+   timer.callback = std::move(callback);
+   TimerId id = timer.id;
+   insert(std::move(timer));
+   return id;
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+   auto iter = m_index.find(id);
+   if (iter == m_index.end()) {
+      return false;
+   }
+   iter->second.first->erase(iter->second.second);
+   m_index.erase(iter);
+   return true;
+}
+
+std::size_t TimerWheel::advance(Clock::time_point now)
+{
+   std::uint64_t target = getTick(now);
+   if (target <= m_currentTick) {
+      return 0;
+   }
+   /// after a full revolution every slot has been seen, no need to go round again
+   std::uint64_t steps = std::min<std::uint64_t>(target - m_currentTick, m_slots.size());
+   for (std::uint64_t i = 1; i <= steps; ++i) {
+      TimerList &slot = m_slots[(m_currentTick + i) % m_slots.size()];
+      for (auto iter = slot.begin(); iter != slot.end();) {
+         auto current = iter++;
+         if (current->expireTick <= target) {
+            m_expired.splice(m_expired.end(), slot, current);
+            m_index[current->id].first = &m_expired;
+         }
+      }
+   }
+   m_currentTick = target;
+   std::size_t fired = 0;
+   while (!m_expired.empty()) {
+      Timer timer = std::move(m_expired.front());
+      m_expired.pop_front();
+      TimerId id = timer.id;
+      ++fired;
+      if (timer.intervalTicks == 0) {
+         m_index.erase(id);
+         timer.callback(id);
+         continue;
+      }
+      /// the callback may cancel its own timer, call a copy
+      Callback callback = timer.callback;
+      timer.expireTick = m_currentTick + timer.intervalTicks;
+      insert(std::move(timer));
+      callback(id);
+   }
+   return fired;
+}
+
+int TimerWheel::getNextTimeout(Clock::time_point now) const
+{
+   if (m_index.empty()) {
+      return -1;
+   }
+   if (!m_expired.empty()) {
+      return 0;
+   }
+   std::uint64_t nextTick = m_currentTick + m_slots.size();
+   for (std::uint64_t i = 1; i <= m_slots.size(); ++i) {
+      std::uint64_t tick = m_currentTick + i;
+      const TimerList &slot = m_slots[tick % m_slots.size()];
+      bool found = std::any_of(slot.begin(), slot.end(), [tick](const Timer &timer) {
+         return timer.expireTick <= tick;
+      });
+      if (found) {
+         nextTick = tick;
+         break;
+      }
+   }
+   /// nothing within one revolution, wake up after it and look again
+   Clock::time_point deadline = m_origin + m_resolution * static_cast<std::int64_t>(nextTick);
+   if (deadline <= now) {
+      return 0;
+   }
+   auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+   if (deadline - now > remaining) {
+      remaining += std::chrono::milliseconds(1);
+   }
+   return static_cast<int>(std::min<std::int64_t>(remaining.count(), INT32_MAX));
+}
+
+} // io
+} // kernel
+} // php
@@ -21,6 +21,7 @@ using polar::vmapi::Namespace;
 void register_stdlib_namespaces(Module &module)
 {
    Namespace php("php");
+   php.registerNamespace(Namespace("io"));
    module.registerNamespace(std::move(php));
 }
 
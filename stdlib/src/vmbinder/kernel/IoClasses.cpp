@@ -0,0 +1,418 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "php/vmbinder/kernel/IoClasses.h"
+#include "polarphp/vm/ObjectBinder.h"
+#include "polarphp/vm/ds/ArrayVariant.h"
+#include "polarphp/vm/ds/CallableVariant.h"
+#include "polarphp/vm/lang/Parameter.h"
+
+#include <cstring>
+
+namespace php {
+namespace vmbinder {
+
+using polar::vmapi::ArrayVariant;
+using polar::vmapi::CallableVariant;
+using polar::vmapi::ObjectBinder;
+using kernel::io::EventLoop;
+using kernel::io::IoStatus;
+using kernel::io::Stream;
+
+const char *sg_ioStreamClassName = "php\\io\\Stream";
+const char *sg_ioEventLoopClassName = "php\\io\\EventLoop";
+
+namespace {
+
+constexpr int POLAR_IO_DEFAULT_BACKLOG = 511;
+constexpr vmapi_long POLAR_IO_DEFAULT_READ_SIZE = 8192;
+
+vmapi_long arg_to_long(Parameters &args, std::size_t pos, vmapi_long defaultValue)
+{
+   if (pos >= args.size()) {
+      return defaultValue;
+   }
+   Variant value = args.retrieveAsVariant(pos);
+   return zval_get_long(value.getZvalPtr());
+}
+
+std::string arg_to_string(Parameters &args, std::size_t pos)
+{
+   if (pos >= args.size()) {
+      return std::string();
+   }
+   return args.retrieveAsVariant(pos).toString();
+}
+
+bool arg_to_bool(Parameters &args, std::size_t pos, bool defaultValue)
+{
+   if (pos >= args.size()) {
+      return defaultValue;
+   }
+   return args.retrieveAsVariant(pos).toBoolean();
+}
+
+Variant make_stream_object(Stream &&stream)
+{
+   return ObjectVariant(sg_ioStreamClassName, std::make_shared<IoStream>(std::move(stream)));
+}
+
+IoStream *arg_to_stream(Parameters &args, std::size_t pos, const char *method)
+{
+   IoStream *stream = pos < args.size() ? IoStream::fromObject(args.retrieveAsVariant(pos)) : nullptr;
+   if (!stream || !stream->isOpen()) {
+      polar::vmapi::warning() << "EventLoop::" << method << "() expects an open "
+                              << sg_ioStreamClassName << std::flush;
+      return nullptr;
+   }
+   return stream;
+}
+
+} // anonymous namespace
+
+IoStream::IoStream()
+{}
+
+IoStream::IoStream(Stream &&stream)
+   : m_stream(std::move(stream))
+{}
+
+IoStream *IoStream::fromObject(const Variant &object)
+{
+   if (!object.isObject()) {
+      return nullptr;
+   }
+   ObjectVariant objectVariant(object);
+   if (!objectVariant.instanceOf(sg_ioStreamClassName)) {
+      return nullptr;
+   }
+   zval *zobject = const_cast<zval *>(objectVariant.getZvalPtr());
+   return dynamic_cast<IoStream *>(ObjectBinder::retrieveSelfPtr(zobject)->getNativeObject());
+}
+
+Variant IoStream::listen(Parameters &args)
+{
+   std::string error;
+   Stream stream = Stream::listenTcp(arg_to_string(args, 0), static_cast<int>(arg_to_long(args, 1, 0)),
+                                     static_cast<int>(arg_to_long(args, 2, POLAR_IO_DEFAULT_BACKLOG)), error);
+   if (!stream.isOpen()) {
+      polar::vmapi::warning() << "Stream::listen(): " << error << std::flush;
+      return false;
+   }
+   return make_stream_object(std::move(stream));
+}
+
+Variant IoStream::connect(Parameters &args)
+{
+   std::string error;
+   Stream stream = Stream::connectTcp(arg_to_string(args, 0), static_cast<int>(arg_to_long(args, 1, 0)), error);
+   if (!stream.isOpen()) {
+      polar::vmapi::warning() << "Stream::connect(): " << error << std::flush;
+      return false;
+   }
+   return make_stream_object(std::move(stream));
+}
+
+Variant IoStream::pipe()
+{
+   std::string error;
+   Stream reader;
+   Stream writer;
+   if (!Stream::openPipe(reader, writer, error)) {
+      polar::vmapi::warning() << "Stream::pipe(): " << error << std::flush;
+      return false;
+   }
+   ArrayVariant pair;
+   pair.append(make_stream_object(std::move(reader)));
+   pair.append(make_stream_object(std::move(writer)));
+   return pair;
+}
+
+Variant IoStream::accept()
+{
+   if (!m_stream.isOpen()) {
+      return false;
+   }
+   IoStatus status;
+   Stream client = m_stream.accept(status);
+   if (status == IoStatus::WouldBlock) {
+      return nullptr;
+   }
+   if (status != IoStatus::Ok) {
+      return false;
+   }
+   return make_stream_object(std::move(client));
+}
+
+Variant IoStream::read(Parameters &args)
+{
+   if (!m_stream.isOpen()) {
+      return false;
+   }
+   vmapi_long length = arg_to_long(args, 0, POLAR_IO_DEFAULT_READ_SIZE);
+   if (length <= 0) {
+      length = POLAR_IO_DEFAULT_READ_SIZE;
+   }
+   zend_string *buffer = zend_string_alloc(static_cast<std::size_t>(length), 0);
+   std::size_t bytesRead = 0;
+   IoStatus status = m_stream.read(ZSTR_VAL(buffer), static_cast<std::size_t>(length), bytesRead);
+   if (status != IoStatus::Ok) {
+      zend_string_efree(buffer);
+      if (status == IoStatus::WouldBlock) {
+         return nullptr;
+      }
+      return false;
+   }
+   Variant result(ZSTR_VAL(buffer), bytesRead);
+   zend_string_efree(buffer);
+   return result;
+}
+
+Variant IoStream::write(Parameters &args)
+{
+   if (!m_stream.isOpen() || args.empty()) {
+      return false;
+   }
+   Variant data = args.retrieveAsVariant(0);
+   zval *zdata = data.getZvalPtr();
+   if (Z_TYPE_P(zdata) != IS_STRING) {
+      convert_to_string(zdata);
+   }
+   std::size_t written = 0;
+   IoStatus status = m_stream.write(Z_STRVAL_P(zdata), Z_STRLEN_P(zdata), written);
+   if (status == IoStatus::Error) {
+      return false;
+   }
+   return static_cast<vmapi_long>(written);
+}
+
+int IoStream::getSocketError()
+{
+   return m_stream.isOpen() ? m_stream.getSocketError() : 0;
+}
+
+int IoStream::getLastError()
+{
+   return m_stream.getLastError();
+}
+
+int IoStream::getFd()
+{
+   return m_stream.getFd();
+}
+
+bool IoStream::isOpen()
+{
+   return m_stream.isOpen();
+}
+
+void IoStream::close()
+{
+   m_stream.close();
+}
+
+IoEventLoop::IoEventLoop()
+   : m_loop(new EventLoop),
+     m_stopRequested(false)
+{}
+
+IoEventLoop::~IoEventLoop()
+{}
+
+bool IoEventLoop::shouldAbort() const
+{
+   /// an uncaught exception in a callback ends run(), it surfaces from there
+   return EG(exception) != nullptr;
+}
+
+bool IoEventLoop::onReadable(Parameters &args)
+{
+   IoStream *stream = arg_to_stream(args, 0, "onReadable");
+   if (!stream || args.size() < 2) {
+      return false;
+   }
+   Variant callback = args.retrieveAsVariant(1);
+   Variant streamObject = args.retrieveAsVariant(0);
+   return m_loop->watchReadable(stream->getFd(), [this, callback, streamObject]() {
+      if (!shouldAbort()) {
+         CallableVariant handler(callback);
+         handler(streamObject);
+      }
+   });
+}
+
+bool IoEventLoop::onWritable(Parameters &args)
+{
+   IoStream *stream = arg_to_stream(args, 0, "onWritable");
+   if (!stream || args.size() < 2) {
+      return false;
+   }
+   Variant callback = args.retrieveAsVariant(1);
+   Variant streamObject = args.retrieveAsVariant(0);
+   return m_loop->watchWritable(stream->getFd(), [this, callback, streamObject]() {
+      if (!shouldAbort()) {
+         CallableVariant handler(callback);
+         handler(streamObject);
+      }
+   });
+}
+
+bool IoEventLoop::cancel(Parameters &args)
+{
+   IoStream *stream = IoStream::fromObject(args.retrieveAsVariant(0));
+   if (!stream || !stream->isOpen()) {
+      return false;
+   }
+   return m_loop->unwatch(stream->getFd());
+}
+
+Variant IoEventLoop::addTimer(Parameters &args)
+{
+   std::chrono::milliseconds delay(std::max<vmapi_long>(arg_to_long(args, 0, 0), 0));
+   Variant callback = args.retrieveAsVariant(1);
+   bool repeat = arg_to_bool(args, 2, false);
+   kernel::io::TimerWheel::TimerId id = m_loop->addTimer(delay, [this, callback]() {
+      if (!shouldAbort()) {
+         const CallableVariant handler(callback);
+         handler();
+      }
+   }, repeat ? std::max(delay, std::chrono::milliseconds(1)) : std::chrono::milliseconds(0));
+   return static_cast<vmapi_long>(id);
+}
+
+bool IoEventLoop::cancelTimer(Parameters &args)
+{
+   return m_loop->cancelTimer(static_cast<kernel::io::TimerWheel::TimerId>(arg_to_long(args, 0, 0)));
+}
+
+void IoEventLoop::readFile(Parameters &args)
+{
+   Variant callback = args.retrieveAsVariant(1);
+   m_loop->readFile(arg_to_string(args, 0), [this, callback](bool ok, std::string &&data, int) {
+      if (shouldAbort()) {
+         return;
+      }
+      CallableVariant handler(callback);
+      handler(ok ? Variant(data) : Variant(false));
+   });
+}
+
+void IoEventLoop::writeFile(Parameters &args)
+{
+   Variant callback = args.retrieveAsVariant(2);
+   m_loop->writeFile(arg_to_string(args, 0), arg_to_string(args, 1), arg_to_bool(args, 3, false),
+                     [this, callback](bool ok, std::string &&, int) {
+      if (!shouldAbort()) {
+         CallableVariant handler(callback);
+         handler(Variant(ok));
+      }
+   });
+}
+
+bool IoEventLoop::spawn(Parameters &args)
+{
+   Variant value = args.retrieveAsVariant(0);
+   if (!value.isObject() || !ObjectVariant(value).instanceOf("Generator")) {
+      polar::vmapi::warning() << "EventLoop::spawn() expects a Generator" << std::flush;
+      return false;
+   }
+   resume(ObjectVariant(value), Variant(), false);
+   return true;
+}
+
+void IoEventLoop::resume(ObjectVariant coroutine, const Variant &value, bool started)
+{
+   if (shouldAbort()) {
+      return;
+   }
+   /// a fresh generator runs up to its first yield on the first current()
+   if (started) {
+      coroutine.call("send", value);
+   }
+   if (shouldAbort()) {
+      return;
+   }
+   suspend(coroutine);
+}
+
+bool IoEventLoop::suspend(ObjectVariant &coroutine)
+{
+   if (!coroutine.call("valid").toBoolean()) {
+      return false;
+   }
+   Variant target = coroutine.call("current");
+   Variant key = coroutine.call("key");
+   if (shouldAbort()) {
+      return false;
+   }
+   std::string operation = key.isString() ? key.toString() : std::string();
+   if (operation == "readable" || operation == "writable") {
+      IoStream *stream = IoStream::fromObject(target);
+      if (!stream || !stream->isOpen()) {
+         polar::vmapi::warning() << "EventLoop: coroutine waits on a closed or invalid stream" << std::flush;
+         return false;
+      }
+      int fd = stream->getFd();
+      bool readable = operation == "readable";
+      auto wakeup = [this, coroutine, fd, readable, target]() {
+         if (readable) {
+            m_loop->unwatchReadable(fd);
+         } else {
+            m_loop->unwatchWritable(fd);
+         }
+         resume(coroutine, target, true);
+      };
+      return readable ? m_loop->watchReadable(fd, wakeup) : m_loop->watchWritable(fd, wakeup);
+   }
+   if (operation == "sleep") {
+      std::chrono::milliseconds delay(std::max<vmapi_long>(zval_get_long(target.getZvalPtr()), 0));
+      m_loop->addTimer(delay, [this, coroutine]() {
+         resume(coroutine, Variant(), true);
+      });
+      return true;
+   }
+   if (operation == "readfile") {
+      m_loop->readFile(target.toString(), [this, coroutine](bool ok, std::string &&data, int) {
+         resume(coroutine, ok ? Variant(data) : Variant(false), true);
+      });
+      return true;
+   }
+   m_loop->post([this, coroutine]() {
+      resume(coroutine, Variant(), true);
+   });
+   return true;
+}
+
+void IoEventLoop::run()
+{
+   if (!m_loop->isValid()) {
+      polar::vmapi::warning() << "EventLoop::run(): no event backend on this platform" << std::flush;
+      return;
+   }
+   while (m_loop->isAlive() && !shouldAbort()) {
+      if (!m_loop->runOnce(-1)) {
+         break;
+      }
+      if (m_stopRequested) {
+         break;
+      }
+   }
+   m_stopRequested = false;
+}
+
+void IoEventLoop::stop()
+{
+   m_stopRequested = true;
+   m_loop->stop();
+}
+
+} // vmbinder
+} // php
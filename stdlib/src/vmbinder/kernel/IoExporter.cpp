@@ -0,0 +1,113 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/08.
+
+#include "polarphp/vm/lang/Module.h"
+#include "polarphp/vm/lang/Namespace.h"
+#include "polarphp/vm/lang/Class.h"
+#include "polarphp/vm/lang/Argument.h"
+
+#include "php/vmbinder/kernel/IoClasses.h"
+#include "php/vmbinder/kernel/IoExporter.h"
+
+namespace php {
+namespace vmbinder {
+
+using polar::vmapi::Class;
+using polar::vmapi::Namespace;
+using polar::vmapi::Type;
+using polar::vmapi::ValueArgument;
+
+namespace {
+void export_io_stream_class(Namespace *io);
+void export_io_event_loop_class(Namespace *io);
+} // anonymous namespace
+
+void export_stdlib_io_classes(Module &module)
+{
+   Namespace *io = module.findNamespace("php")->findNamespace("io");
+   export_io_stream_class(io);
+   export_io_event_loop_class(io);
+}
+
+namespace {
+
+void export_io_stream_class(Namespace *io)
+{
+   Class<IoStream> stream("Stream");
+   stream.registerMethod<decltype(&IoStream::listen), &IoStream::listen>("listen", {
+                                                                            ValueArgument("host", Type::String),
+                                                                            ValueArgument("port", Type::Long),
+                                                                            ValueArgument("backlog", Type::Long, false)
+                                                                         });
+   stream.registerMethod<decltype(&IoStream::connect), &IoStream::connect>("connect", {
+                                                                              ValueArgument("host", Type::String),
+                                                                              ValueArgument("port", Type::Long)
+                                                                           });
+   stream.registerMethod<decltype(&IoStream::pipe), &IoStream::pipe>("pipe");
+   stream.registerMethod<decltype(&IoStream::accept), &IoStream::accept>("accept");
+   stream.registerMethod<decltype(&IoStream::read), &IoStream::read>("read", {
+                                                                        ValueArgument("length", Type::Long, false)
+                                                                     });
+   stream.registerMethod<decltype(&IoStream::write), &IoStream::write>("write", {
+                                                                          ValueArgument("data", Type::String)
+                                                                       });
+   stream.registerMethod<decltype(&IoStream::getSocketError), &IoStream::getSocketError>("getSocketError");
+   stream.registerMethod<decltype(&IoStream::getLastError), &IoStream::getLastError>("getLastError");
+   stream.registerMethod<decltype(&IoStream::getFd), &IoStream::getFd>("getFd");
+   stream.registerMethod<decltype(&IoStream::isOpen), &IoStream::isOpen>("isOpen");
+   stream.registerMethod<decltype(&IoStream::close), &IoStream::close>("close");
+   io->registerClass(stream);
+}
+
+void export_io_event_loop_class(Namespace *io)
+{
+   Class<IoEventLoop> loop("EventLoop");
+   loop.registerMethod<decltype(&IoEventLoop::onReadable), &IoEventLoop::onReadable>("onReadable", {
+                                                                                        ValueArgument("stream", sg_ioStreamClassName),
+                                                                                        ValueArgument("callback", Type::Callable)
+                                                                                     });
+   loop.registerMethod<decltype(&IoEventLoop::onWritable), &IoEventLoop::onWritable>("onWritable", {
+                                                                                        ValueArgument("stream", sg_ioStreamClassName),
+                                                                                        ValueArgument("callback", Type::Callable)
+                                                                                     });
+   loop.registerMethod<decltype(&IoEventLoop::cancel), &IoEventLoop::cancel>("cancel", {
+                                                                                ValueArgument("stream", sg_ioStreamClassName)
+                                                                             });
+   loop.registerMethod<decltype(&IoEventLoop::addTimer), &IoEventLoop::addTimer>("addTimer", {
+                                                                                    ValueArgument("milliseconds", Type::Long),
+                                                                                    ValueArgument("callback", Type::Callable),
+                                                                                    ValueArgument("repeat", Type::Boolean, false)
+                                                                                 });
+   loop.registerMethod<decltype(&IoEventLoop::cancelTimer), &IoEventLoop::cancelTimer>("cancelTimer", {
+                                                                                          ValueArgument("timerId", Type::Long)
+                                                                                       });
+   loop.registerMethod<decltype(&IoEventLoop::readFile), &IoEventLoop::readFile>("readFile", {
+                                                                                    ValueArgument("path", Type::String),
+                                                                                    ValueArgument("callback", Type::Callable)
+                                                                                 });
+   loop.registerMethod<decltype(&IoEventLoop::writeFile), &IoEventLoop::writeFile>("writeFile", {
+                                                                                      ValueArgument("path", Type::String),
+                                                                                      ValueArgument("data", Type::String),
+                                                                                      ValueArgument("callback", Type::Callable),
+                                                                                      ValueArgument("append", Type::Boolean, false)
+                                                                                   });
+   loop.registerMethod<decltype(&IoEventLoop::spawn), &IoEventLoop::spawn>("spawn", {
+                                                                              ValueArgument("coroutine", "Generator")
+                                                                           });
+   loop.registerMethod<decltype(&IoEventLoop::run), &IoEventLoop::run>("run");
+   loop.registerMethod<decltype(&IoEventLoop::stop), &IoEventLoop::stop>("stop");
+   io->registerClass(loop);
+}
+
+} // anonymous namespace
+
+} // vmbinder
+} // php
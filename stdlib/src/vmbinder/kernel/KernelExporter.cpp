@@ -11,24 +11,35 @@
 
 #include "polarphp/vm/lang/Module.h"
 #include "polarphp/vm/lang/Namespace.h"
+#include "polarphp/vm/lang/Argument.h"
+#include "polarphp/vm/lang/Parameter.h"
+#include "polarphp/vm/ds/StringVariant.h"
 
 #include "php/kernel/Utils.h"
 #include "php/vmbinder/kernel/KernelExporter.h"
+#include "php/vmbinder/kernel/IoExporter.h"
 #include "php/vmbinder/NamespaceDefs.h"
 
 namespace php {
 namespace vmbinder {
 
 using polar::vmapi::Namespace;
+using polar::vmapi::Parameters;
+using polar::vmapi::StringVariant;
+using polar::vmapi::Type;
+using polar::vmapi::ValueArgument;
+using polar::vmapi::Variant;
 
 namespace {
 void export_stdlib_kernel_funcs(Module &module);
+Variant utf8_validate(Parameters &args);
 } // anonymous namespace
 
 bool export_stdlib_kernel_module(Module &module)
 {
    register_stdlib_namespaces(module);
    export_stdlib_kernel_funcs(module);
+   export_stdlib_io_classes(module);
    return module.registerToVM();
 }
 
@@ -41,6 +52,15 @@ void export_stdlib_kernel_funcs(Module &module)
    php->registerFunction<decltype(php::kernel::retrieve_minor_version), php::kernel::retrieve_minor_version>("retrieve_minor_version");
    php->registerFunction<decltype(php::kernel::retrieve_patch_version), php::kernel::retrieve_patch_version>("retrieve_patch_version");
    php->registerFunction<decltype(php::kernel::retrieve_version_id), php::kernel::retrieve_version_id>("retrieve_version_id");
+   php->registerFunction<decltype(utf8_validate), utf8_validate>("utf8_validate", {
+                                                                    ValueArgument("str", Type::String)
+                                                                 });
+}
+
+Variant utf8_validate(Parameters &args)
+{
+   const StringVariant &str = args.at<StringVariant>(0);
+   return php::kernel::is_valid_utf8(str.getCStr(), str.getSize());
 }
 } // anonymous namespace
 
@@ -0,0 +1,229 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/ast/DiagnosticEngine.h"
+#include "polarphp/ast/DiagnosticConsumer.h"
+#include "polarphp/ast/DiagnosticsCommon.h"
+#include "polarphp/parser/SourceMgr.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <string>
+#include <vector>
+
+using polar::ast::DiagID;
+using polar::ast::Diagnostic;
+using polar::ast::DiagnosticArgument;
+using polar::ast::DiagnosticConsumer;
+using polar::ast::DiagnosticEngine;
+using polar::ast::DiagnosticInfo;
+using polar::ast::DiagnosticKind;
+using polar::basic::ArrayRef;
+using polar::basic::StringRef;
+using polar::parser::CharSourceRange;
+using polar::parser::SourceLoc;
+using polar::parser::SourceManager;
+using polar::utils::RawStringOutStream;
+
+namespace diag = polar::ast::diag;
+
+namespace {
+
+struct RecordedDiagnostic
+{
+   DiagID id;
+   DiagnosticKind kind;
+   SourceLoc loc;
+   std::string text;
+   /// what the engine rendered for a batched diagnostic, empty otherwise
+   std::string formattedText;
+   std::size_t ranges;
+   std::vector<std::string> fixIts;
+};
+
+class RecordingConsumer : public DiagnosticConsumer
+{
+public:
+   void handleDiagnostic(SourceManager &, SourceLoc loc, DiagnosticKind kind,
+                         StringRef formatString,
+                         ArrayRef<DiagnosticArgument> formatArgs,
+                         const DiagnosticInfo &info) override
+   {
+      RecordedDiagnostic diagnostic{info.id, kind, loc, std::string(),
+               info.formattedText.getStr(), info.ranges.size(), {}};
+      for (const DiagnosticInfo::FixIt &fixIt : info.fixIts) {
+         diagnostic.fixIts.push_back(fixIt.getText().getStr());
+      }
+      RawStringOutStream out(diagnostic.text);
+      DiagnosticEngine::formatDiagnosticText(out, formatString, formatArgs);
+      out.flush();
+      diagnostics.push_back(std::move(diagnostic));
+   }
+
+   std::vector<RecordedDiagnostic> diagnostics;
+};
+
+std::vector<std::string> get_texts(const RecordingConsumer &consumer)
+{
+   std::vector<std::string> texts;
+   for (const RecordedDiagnostic &diagnostic : consumer.diagnostics) {
+      texts.push_back(diagnostic.text);
+   }
+   return texts;
+}
+
+class DiagnosticEngineTest : public ::testing::Test
+{
+protected:
+   DiagnosticEngineTest()
+      : diags(sourceMgr)
+   {
+      bufferId = sourceMgr.addMemBufferCopy("<?php\necho $a;\necho $b;\n", "test.php");
+      diags.addConsumer(consumer);
+   }
+
+   SourceLoc getLoc(unsigned offset)
+   {
+      return sourceMgr.getLocForOffset(bufferId, offset);
+   }
+
+   SourceManager sourceMgr;
+   DiagnosticEngine diags;
+   RecordingConsumer consumer;
+   unsigned bufferId;
+};
+
+} // anonymous namespace
+
+TEST_F(DiagnosticEngineTest, testUnbatchedIsDeliveredAtOnce)
+{
+   diags.diagnose(getLoc(6), diag::not_implemented, "closures");
+   ASSERT_EQ(consumer.diagnostics.size(), 1u);
+   ASSERT_EQ(consumer.diagnostics[0].text, "INTERNAL ERROR: feature not implemented: closures");
+   ASSERT_EQ(consumer.diagnostics[0].kind, DiagnosticKind::Error);
+   ASSERT_TRUE(consumer.diagnostics[0].formattedText.empty());
+   ASSERT_EQ(diags.getNumStoredDiagnostics(), 0u);
+}
+
+TEST_F(DiagnosticEngineTest, testBatchKeepsEmissionOrder)
+{
+   diags.setBatchDiagnostics();
+   diags.diagnose(getLoc(15), diag::not_implemented, "b");
+   diags.diagnose(getLoc(6), diag::error_opening_output, "out.txt", "denied");
+   diags.diagnose(getLoc(6), diag::brace_stmt_suggest_do);
+   diags.diagnose(getLoc(0), diag::not_implemented, "a");
+   ASSERT_TRUE(consumer.diagnostics.empty());
+   ASSERT_EQ(diags.getNumStoredDiagnostics(), 4u);
+   diags.flushDiagnostics();
+   ASSERT_EQ(diags.getNumStoredDiagnostics(), 0u);
+   ASSERT_EQ(get_texts(consumer), std::vector<std::string>({
+                "INTERNAL ERROR: feature not implemented: b",
+                "error opening 'out.txt' for output: denied",
+                "did you mean to use a 'do' statement?",
+                "INTERNAL ERROR: feature not implemented: a"}));
+   ASSERT_EQ(consumer.diagnostics[2].kind, DiagnosticKind::Note);
+   ASSERT_EQ(consumer.diagnostics[0].loc, getLoc(15));
+   for (const RecordedDiagnostic &diagnostic : consumer.diagnostics) {
+      ASSERT_EQ(diagnostic.formattedText, diagnostic.text);
+   }
+   /// nothing is delivered twice
+   diags.flushDiagnostics();
+   ASSERT_EQ(consumer.diagnostics.size(), 4u);
+}
+
+TEST_F(DiagnosticEngineTest, testDuplicateDropsItsNotes)
+{
+   diags.setBatchDiagnostics();
+   diags.diagnose(getLoc(6), diag::not_implemented, "x");
+   diags.diagnose(getLoc(6), diag::brace_stmt_suggest_do);
+   /// the same error again, it goes away together with its note
+   diags.diagnose(getLoc(6), diag::not_implemented, "x");
+   diags.diagnose(getLoc(6), diag::while_parsing_as_left_angle_bracket);
+   /// another location or another argument is not a duplicate
+   diags.diagnose(getLoc(15), diag::not_implemented, "x");
+   diags.diagnose(getLoc(15), diag::while_parsing_as_left_angle_bracket);
+   diags.diagnose(getLoc(6), diag::not_implemented, "y");
+   ASSERT_EQ(diags.getNumStoredDiagnostics(), 5u);
+   ASSERT_EQ(diags.getNumDuplicateDiagnostics(), 2u);
+   diags.flushDiagnostics();
+   ASSERT_EQ(consumer.diagnostics.size(), 5u);
+   ASSERT_EQ(consumer.diagnostics[0].loc, getLoc(6));
+   ASSERT_EQ(consumer.diagnostics[1].id, diag::brace_stmt_suggest_do.id);
+   ASSERT_EQ(consumer.diagnostics[2].loc, getLoc(15));
+   ASSERT_EQ(consumer.diagnostics[3].id, diag::while_parsing_as_left_angle_bracket.id);
+   ASSERT_EQ(consumer.diagnostics[4].text, "INTERNAL ERROR: feature not implemented: y");
+   /// a flush forgets what was seen, the same error is reported again
+   diags.diagnose(getLoc(6), diag::not_implemented, "x");
+   ASSERT_EQ(diags.getNumStoredDiagnostics(), 1u);
+}
+
+TEST_F(DiagnosticEngineTest, testStringArgumentsAreCopied)
+{
+   diags.setBatchDiagnostics();
+   {
+      std::string name = "temporary";
+      diags.diagnose(getLoc(6), diag::not_implemented, StringRef(name));
+      name.assign(name.size(), '#');
+   }
+   diags.flushDiagnostics();
+   ASSERT_EQ(get_texts(consumer), std::vector<std::string>({
+                "INTERNAL ERROR: feature not implemented: temporary"}));
+}
+
+TEST_F(DiagnosticEngineTest, testFixItsSurviveTheBatch)
+{
+   diags.setBatchDiagnostics();
+   {
+      Diagnostic diagnostic(diag::not_implemented, StringRef("f"));
+      diagnostic.addRange(CharSourceRange(getLoc(11), 2));
+      diagnostic.addFixIt(Diagnostic::FixIt(CharSourceRange(getLoc(11), 2), "$c"));
+      diags.diagnose(getLoc(11), diagnostic);
+   }
+   diags.flushDiagnostics();
+   ASSERT_EQ(consumer.diagnostics.size(), 1u);
+   ASSERT_EQ(consumer.diagnostics[0].ranges, 1u);
+   ASSERT_EQ(consumer.diagnostics[0].fixIts, std::vector<std::string>({"$c"}));
+}
+
+TEST_F(DiagnosticEngineTest, testTurningBatchOffFlushes)
+{
+   diags.setBatchDiagnostics();
+   diags.diagnose(getLoc(6), diag::not_implemented, "a");
+   ASSERT_TRUE(consumer.diagnostics.empty());
+   diags.setBatchDiagnostics(false);
+   ASSERT_FALSE(diags.getBatchDiagnostics());
+   ASSERT_EQ(consumer.diagnostics.size(), 1u);
+   diags.diagnose(getLoc(6), diag::not_implemented, "a");
+   /// without batching there is no deduplication
+   ASSERT_EQ(consumer.diagnostics.size(), 2u);
+}
+
+TEST_F(DiagnosticEngineTest, testParallelRenderMatchesEmissionOrder)
+{
+   /// enough diagnostics for flushDiagnostics() to render on many threads
+   const unsigned count = 2000;
+   std::vector<std::string> expected;
+   diags.setBatchDiagnostics();
+   for (unsigned index = 0; index < count; ++index) {
+      std::string feature = "feature " + std::to_string(index);
+      diags.diagnose(getLoc(index % 20), diag::not_implemented, StringRef(feature));
+      expected.push_back("INTERNAL ERROR: feature not implemented: " + feature);
+      if (index % 7 == 0) {
+         diags.diagnose(getLoc(index % 20), diag::brace_stmt_suggest_do);
+         expected.push_back("did you mean to use a 'do' statement?");
+      }
+   }
+   ASSERT_TRUE(diags.finishProcessing() == false);
+   ASSERT_EQ(get_texts(consumer), expected);
+   for (const RecordedDiagnostic &diagnostic : consumer.diagnostics) {
+      ASSERT_EQ(diagnostic.formattedText, diagnostic.text);
+   }
+}
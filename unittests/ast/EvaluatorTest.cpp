@@ -0,0 +1,336 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/ast/Evaluator.h"
+#include "polarphp/ast/DiagnosticEngine.h"
+#include "polarphp/basic/LangStatistic.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/parser/SourceMgr.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using polar::ast::Evaluator;
+using polar::ast::DiagnosticEngine;
+using polar::ast::SourceFile;
+using polar::ast::CyclicalRequestError;
+using polar::ast::evaluate_or_default;
+using polar::basic::CycleDiagnosticKind;
+using polar::basic::HashCode;
+using polar::basic::SmallString;
+using polar::basic::StringRef;
+using polar::basic::UnifiedStatsReporter;
+using polar::parser::SourceManager;
+using polar::utils::RawOutStream;
+using polar::utils::Expected;
+
+namespace fs = polar::fs;
+
+namespace {
+
+/// a node of a small expression graph, the value of a node is its own
+/// value plus the values of its operands
+struct Node
+{
+   int value;
+   std::vector<Node *> operands;
+   /// the fake source file the node was "parsed" from, or null
+   const SourceFile *file = nullptr;
+};
+
+/// how often each node was really evaluated
+std::vector<const Node *> sg_evaluated;
+
+struct SumRequest
+{
+   using OutputType = int;
+   static const bool isEverCached = true;
+   static const bool hasExternalCache = false;
+
+   Node *node;
+
+   explicit SumRequest(Node *node)
+      : node(node)
+   {}
+
+   bool isCached() const
+   {
+      return true;
+   }
+
+   static Expected<int> evaluateRequest(const SumRequest &request, Evaluator &evaluator)
+   {
+      sg_evaluated.push_back(request.node);
+      if (request.node->file) {
+         evaluator.noteSourceFileDependency(request.node->file);
+      }
+      int sum = request.node->value;
+      for (Node *operand : request.node->operands) {
+         Expected<int> value = evaluator(SumRequest(operand));
+         if (!value) {
+            return value.takeError();
+         }
+         sum += *value;
+      }
+      return sum;
+   }
+
+   void diagnoseCycle(DiagnosticEngine &) const
+   {}
+
+   void noteCycleStep(DiagnosticEngine &) const
+   {}
+
+   friend bool operator==(const SumRequest &lhs, const SumRequest &rhs)
+   {
+      return lhs.node == rhs.node;
+   }
+
+   friend HashCode hash_value(const SumRequest &request)
+   {
+      return polar::basic::hash_value(request.node);
+   }
+
+   friend void simple_display(RawOutStream &out, const SumRequest &request)
+   {
+      out << "sum of node " << request.node->value;
+   }
+};
+
+/// how often the stats reporter was told a SumRequest was evaluated
+std::size_t sg_reported = 0;
+
+void report_evaluated_request(UnifiedStatsReporter &, const SumRequest &)
+{
+   ++sg_reported;
+}
+
+/// the stats file a reporter left in \p directory
+std::string read_stats_file(StringRef directory)
+{
+   std::error_code errorCode;
+   for (fs::DirectoryIterator iter(directory, errorCode), end;
+        !errorCode && iter != end; iter.increment(errorCode)) {
+      StringRef path = iter->getPath();
+      if (fs::path::filename(path).startsWith("stats-")) {
+         std::ifstream file(path.getStr());
+         return std::string(std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>());
+      }
+   }
+   return std::string();
+}
+
+/// fake source files, the evaluator only uses them as keys
+const SourceFile *get_file(int index)
+{
+   static int files[2];
+   return reinterpret_cast<const SourceFile *>(&files[index]);
+}
+
+std::size_t count_evaluations(const Node &node)
+{
+   return std::count(sg_evaluated.begin(), sg_evaluated.end(), &node);
+}
+
+class EvaluatorTest : public ::testing::Test
+{
+protected:
+   EvaluatorTest()
+      : m_diags(m_sourceMgr),
+        m_evaluator(m_diags, CycleDiagnosticKind::NoDiagnose)
+   {
+      sg_evaluated.clear();
+   }
+
+   int evaluate(Node &node)
+   {
+      return evaluate_or_default(m_evaluator, SumRequest(&node), -1);
+   }
+
+   SourceManager m_sourceMgr;
+   DiagnosticEngine m_diags;
+   Evaluator m_evaluator;
+};
+
+} // anonymous namespace
+
+namespace polar::basic {
+template<>
+struct TypeId<SumRequest>
+{
+   /// zone 255 is reserved for tests
+   static const uint64_t value = form_type_id(255, 0);
+
+   static StringRef getName()
+   {
+      return "SumRequest";
+   }
+};
+} // polar::basic
+
+TEST_F(EvaluatorTest, testCaching)
+{
+   Node leaf1{1, {}};
+   Node leaf2{2, {}};
+   Node shared{10, {&leaf1, &leaf2}};
+   Node root{100, {&shared, &shared, &leaf1}};
+   ASSERT_EQ(evaluate(root), 100 + 13 + 13 + 1);
+   ASSERT_EQ(count_evaluations(root), 1u);
+   ASSERT_EQ(count_evaluations(shared), 1u);
+   ASSERT_EQ(count_evaluations(leaf1), 1u);
+   ASSERT_TRUE(m_evaluator.hasCachedResult(SumRequest(&root)));
+   ASSERT_FALSE(m_evaluator.hasActiveRequest(SumRequest(&root)));
+   sg_evaluated.clear();
+   ASSERT_EQ(evaluate(root), 127);
+   ASSERT_EQ(evaluate(shared), 13);
+   ASSERT_TRUE(sg_evaluated.empty());
+   m_evaluator.clearCache();
+   ASSERT_EQ(evaluate(shared), 13);
+   ASSERT_EQ(count_evaluations(shared), 1u);
+}
+
+TEST_F(EvaluatorTest, testCycleDetection)
+{
+   Node first{1, {}};
+   Node second{2, {&first}};
+   Node third{3, {&second}};
+   first.operands.push_back(&third);
+   Node outside{4, {&second}};
+
+   Expected<int> result = m_evaluator(SumRequest(&outside));
+   ASSERT_FALSE(static_cast<bool>(result));
+   bool sawCycle = false;
+   polar::utils::handle_all_errors(result.takeError(),
+                                   [&](const CyclicalRequestError<SumRequest> &error) {
+      sawCycle = true;
+      ASSERT_TRUE(error.request == SumRequest(&second));
+   });
+   ASSERT_TRUE(sawCycle);
+   /// the requests on the failing path neither stay active nor get cached
+   for (Node *node : {&first, &second, &third, &outside}) {
+      ASSERT_FALSE(m_evaluator.hasActiveRequest(SumRequest(node)));
+      ASSERT_FALSE(m_evaluator.hasCachedResult(SumRequest(node)));
+   }
+   ASSERT_EQ(evaluate(first), -1);
+
+   /// breaking the cycle and invalidating makes the graph computable again
+   first.operands.clear();
+   m_evaluator.invalidate(SumRequest(&first));
+   ASSERT_EQ(evaluate(outside), 4 + 2 + 1);
+}
+
+TEST_F(EvaluatorTest, testInvalidation)
+{
+   Node leaf1{1, {}};
+   Node leaf2{2, {}};
+   Node left{10, {&leaf1}};
+   Node right{20, {&leaf2}};
+   Node root{100, {&left, &right}};
+   ASSERT_EQ(evaluate(root), 133);
+   sg_evaluated.clear();
+
+   leaf1.value = 5;
+   m_evaluator.invalidate(SumRequest(&leaf1));
+   /// the change reaches everything computed from leaf1 and nothing else
+   ASSERT_FALSE(m_evaluator.hasCachedResult(SumRequest(&leaf1)));
+   ASSERT_FALSE(m_evaluator.hasCachedResult(SumRequest(&left)));
+   ASSERT_FALSE(m_evaluator.hasCachedResult(SumRequest(&root)));
+   ASSERT_TRUE(m_evaluator.hasCachedResult(SumRequest(&right)));
+   ASSERT_TRUE(m_evaluator.hasCachedResult(SumRequest(&leaf2)));
+   ASSERT_EQ(evaluate(root), 137);
+   ASSERT_EQ(count_evaluations(leaf1), 1u);
+   ASSERT_EQ(count_evaluations(left), 1u);
+   ASSERT_EQ(count_evaluations(root), 1u);
+   ASSERT_EQ(count_evaluations(right), 0u);
+   ASSERT_EQ(count_evaluations(leaf2), 0u);
+
+   /// root no longer uses left, invalidating left must not reach root
+   root.operands = {&right};
+   m_evaluator.invalidate(SumRequest(&root));
+   ASSERT_EQ(evaluate(root), 122);
+   left.value = 50;
+   m_evaluator.invalidate(SumRequest(&left));
+   ASSERT_TRUE(m_evaluator.hasCachedResult(SumRequest(&root)));
+   ASSERT_EQ(evaluate(root), 122);
+}
+
+TEST_F(EvaluatorTest, testInvalidateSourceFile)
+{
+   Node fromFirst{1, {}, get_file(0)};
+   Node fromSecond{2, {}, get_file(1)};
+   Node user{10, {&fromFirst}};
+   Node other{20, {&fromSecond}};
+   ASSERT_EQ(evaluate(user), 11);
+   ASSERT_EQ(evaluate(other), 22);
+   ASSERT_EQ(m_evaluator.invalidateSourceFile(get_file(0)), 2u);
+   ASSERT_FALSE(m_evaluator.hasCachedResult(SumRequest(&fromFirst)));
+   ASSERT_FALSE(m_evaluator.hasCachedResult(SumRequest(&user)));
+   ASSERT_TRUE(m_evaluator.hasCachedResult(SumRequest(&other)));
+   ASSERT_TRUE(m_evaluator.hasCachedResult(SumRequest(&fromSecond)));
+   /// the file dependency was dropped with the results
+   ASSERT_EQ(m_evaluator.invalidateSourceFile(get_file(0)), 0u);
+   sg_evaluated.clear();
+   fromFirst.value = 3;
+   ASSERT_EQ(evaluate(user), 13);
+   ASSERT_EQ(sg_evaluated.size(), 2u);
+   /// and recorded again by the new evaluation
+   ASSERT_EQ(m_evaluator.invalidateSourceFile(get_file(0)), 2u);
+}
+
+TEST_F(EvaluatorTest, testStatistics)
+{
+   SmallString<128> directory;
+   ASSERT_FALSE(fs::create_unique_directory("EvaluatorTest", directory));
+   sg_reported = 0;
+   {
+      UnifiedStatsReporter stats("polarphp", "EvaluatorTest", "", "", "", "", directory);
+      m_evaluator.setStatsReporter(&stats);
+      Node leaf1{1, {}};
+      Node leaf2{2, {}};
+      Node shared{10, {&leaf1, &leaf2}};
+      Node root{100, {&shared, &shared, &leaf1}};
+      /// every request evaluated once, the second uses of shared and leaf1
+      /// are answered from the cache
+      ASSERT_EQ(evaluate(root), 127);
+      UnifiedStatsReporter::AlwaysOnFrontendCounters &counters = stats.getFrontendCounters();
+      ASSERT_EQ(counters.NumEvaluatorRequests, 4);
+      ASSERT_EQ(counters.NumEvaluatorCacheHits, 2);
+      ASSERT_EQ(sg_reported, 4u);
+      ASSERT_EQ(evaluate(root), 127);
+      ASSERT_EQ(counters.NumEvaluatorRequests, 4);
+      ASSERT_EQ(counters.NumEvaluatorCacheHits, 3);
+      /// leaf1 and everything computed from it
+      m_evaluator.invalidate(SumRequest(&leaf1));
+      ASSERT_EQ(counters.NumEvaluatorInvalidations, 3);
+      ASSERT_EQ(evaluate(root), 127);
+      ASSERT_EQ(counters.NumEvaluatorRequests, 7);
+      ASSERT_EQ(counters.NumEvaluatorCacheHits, 6);
+      ASSERT_EQ(sg_reported, 7u);
+      /// nothing is counted without a reporter
+      m_evaluator.setStatsReporter(nullptr);
+      ASSERT_EQ(evaluate(leaf2), 2);
+      ASSERT_EQ(counters.NumEvaluatorCacheHits, 6);
+      stats.noteCurrentProcessExitStatus(EXIT_SUCCESS);
+   }
+   /// the counters and the timer of the request kind are written out when
+   /// the reporter goes away
+   std::string written = read_stats_file(directory);
+   fs::remove_directories(directory);
+   ASSERT_NE(written.find("\"Sema.NumEvaluatorRequests\": 7"), std::string::npos) << written;
+   ASSERT_NE(written.find("\"Sema.NumEvaluatorInvalidations\": 3"), std::string::npos) << written;
+   ASSERT_NE(written.find(".SumRequest.wall\""), std::string::npos) << written;
+}
@@ -0,0 +1,112 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/ast/IdentifierTable.h"
+
+#include <string>
+#include <vector>
+
+using polar::ast::DeclBaseName;
+using polar::ast::Identifier;
+using polar::ast::IdentifierTable;
+using polar::basic::StringRef;
+
+TEST(IdentifierTableTest, testCaseFoldedLookup)
+{
+   IdentifierTable table;
+   ASSERT_TRUE(table.lookupCaseInsensitive("strlen").empty());
+   Identifier mixed = table.get("StrLen");
+   ASSERT_EQ(mixed.str(), "StrLen");
+   ASSERT_EQ(mixed.getLength(), 6u);
+   /// the lowercased spelling is interned along with it
+   ASSERT_EQ(table.size(), 2u);
+   Identifier lower = table.lookup("strlen");
+   ASSERT_FALSE(lower.empty());
+   ASSERT_EQ(mixed.getFolded(), lower);
+   ASSERT_EQ(lower.getFolded(), lower);
+   ASSERT_EQ(table.get("strlen"), lower);
+   ASSERT_EQ(table.size(), 2u);
+   ASSERT_EQ(table.lookupCaseInsensitive("STRLEN"), lower);
+   ASSERT_EQ(table.lookupCaseInsensitive("strLEN"), lower);
+   /// only spellings that were interned are found exactly
+   ASSERT_TRUE(table.lookup("STRLEN").empty());
+   ASSERT_TRUE(table.lookupCaseInsensitive("strlen2").empty());
+   ASSERT_TRUE(table.lookupCaseInsensitive("strle").empty());
+}
+
+TEST(IdentifierTableTest, testEqualsCaseInsensitive)
+{
+   IdentifierTable table;
+   Identifier first = table.get("ArrayObject");
+   Identifier second = table.get("ARRAYOBJECT");
+   Identifier third = table.get("arrayobject");
+   Identifier other = table.get("ArrayObjekt");
+   ASSERT_NE(first, second);
+   ASSERT_NE(first, third);
+   ASSERT_TRUE(first.equalsCaseInsensitive(second));
+   ASSERT_TRUE(second.equalsCaseInsensitive(third));
+   ASSERT_TRUE(third.equalsCaseInsensitive(first));
+   ASSERT_FALSE(first.equalsCaseInsensitive(other));
+   ASSERT_EQ(table.size(), 5u);
+   /// every spelling carries the hash of the lowercased one
+   ASSERT_EQ(first.getFoldedHash(), IdentifierTable::hash("arrayobject"));
+   ASSERT_EQ(second.getFoldedHash(), first.getFoldedHash());
+   ASSERT_EQ(third.getFoldedHash(), first.getFoldedHash());
+   ASSERT_EQ(IdentifierTable::hashCaseInsensitive("ArrayObject"), first.getFoldedHash());
+   ASSERT_NE(other.getFoldedHash(), first.getFoldedHash());
+   /// only ascii letters fold, like zend_str_tolower
+   Identifier high = table.get("\xC3\x84pfel");
+   ASSERT_FALSE(high.equalsCaseInsensitive(table.get("\xC3\xA4pfel")));
+   ASSERT_TRUE(high.equalsCaseInsensitive(table.get("\xC3\x84PFEL")));
+}
+
+TEST(IdentifierTableTest, testGrowth)
+{
+   IdentifierTable table;
+   const int count = 5000;
+   std::vector<Identifier> identifiers;
+   for (int i = 0; i < count; ++i) {
+      identifiers.push_back(table.get("Symbol_" + std::to_string(i)));
+   }
+   ASSERT_EQ(table.size(), static_cast<size_t>(count) * 2);
+   for (int i = 0; i < count; ++i) {
+      std::string name = "Symbol_" + std::to_string(i);
+      std::string lowered = "symbol_" + std::to_string(i);
+      Identifier identifier = identifiers[i];
+      /// the entries did not move while the buckets were rehashed
+      ASSERT_EQ(identifier.str(), name);
+      ASSERT_EQ(identifier.get()[name.size()], '\0');
+      ASSERT_EQ(table.get(name), identifier);
+      ASSERT_EQ(table.lookup(name), identifier);
+      ASSERT_EQ(table.lookupCaseInsensitive(name), identifier.getFolded());
+      ASSERT_EQ(identifier.getFolded().str(), lowered);
+   }
+   ASSERT_EQ(table.size(), static_cast<size_t>(count) * 2);
+}
+
+TEST(IdentifierTableTest, testDeclBaseNameOrdering)
+{
+   IdentifierTable table;
+   DeclBaseName name(table.get("Foo"));
+   DeclBaseName other(table.get("foo"));
+   DeclBaseName subscript = DeclBaseName::createSubscript();
+   DeclBaseName constructor = DeclBaseName::createConstructor();
+   /// special names have no text, ordering must not look at it
+   ASSERT_NE(name < subscript, subscript < name);
+   ASSERT_NE(constructor < subscript, subscript < constructor);
+   ASSERT_NE(name < other, other < name);
+   ASSERT_FALSE(constructor < constructor);
+   ASSERT_FALSE(name < name);
+   ASSERT_EQ(DeclBaseName::getFromOpaquePointer(const_cast<void *>(name.getAsOpaquePointer())), name);
+   ASSERT_EQ(DeclBaseName::getFromOpaquePointer(const_cast<void *>(subscript.getAsOpaquePointer())), subscript);
+   ASSERT_TRUE(DeclBaseName::getFromOpaquePointer(const_cast<void *>(constructor.getAsOpaquePointer())).isSpecial());
+}
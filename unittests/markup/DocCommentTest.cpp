@@ -0,0 +1,146 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/markup/DocComment.h"
+#include "polarphp/markup/Markup.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using polar::markup::AnnotationField;
+using polar::markup::Document;
+using polar::markup::DocCommentCache;
+using polar::markup::MarkupAstNode;
+using polar::markup::MarkupContext;
+using polar::markup::Paragraph;
+using polar::markup::SoftBreak;
+using polar::markup::Text;
+using polar::markup::doc_comment_has_tags;
+using polar::markup::parse_doc_comment;
+using polar::utils::dyn_cast;
+using polar::utils::isa;
+
+namespace {
+
+using TagList = std::vector<std::pair<std::string, std::string>>;
+
+TagList collect_tags(const Document *document)
+{
+   TagList tags;
+   for (const MarkupAstNode *node : document->getChildren()) {
+      if (const AnnotationField *annotation = dyn_cast<AnnotationField>(node)) {
+         tags.emplace_back(annotation->getName(), annotation->getValue());
+      }
+   }
+   return tags;
+}
+
+/// the text of a paragraph, a soft break written as a newline
+std::string paragraph_text(const MarkupAstNode *node)
+{
+   std::string text;
+   for (const MarkupAstNode *child : dyn_cast<Paragraph>(node)->getChildren()) {
+      if (const Text *literal = dyn_cast<Text>(child)) {
+         text += literal->getLiteralContent();
+      } else if (isa<SoftBreak>(child)) {
+         text += '\n';
+      }
+   }
+   return text;
+}
+
+const char *sg_fullComment =
+      "/**\n"
+      " * Summary line.\n"
+      " *\n"
+      " * Description that\n"
+      " * spans two lines.\n"
+      " *\n"
+      " * @param int $a the first\n"
+      " *        continued\n"
+      " * @return int\n"
+      " * @throws \\Foo\\Bar\n"
+      " */";
+
+} // anonymous namespace
+
+TEST(DocCommentTest, testHasTags)
+{
+   ASSERT_TRUE(doc_comment_has_tags("/** @var int */"));
+   ASSERT_TRUE(doc_comment_has_tags(sg_fullComment));
+   ASSERT_TRUE(doc_comment_has_tags("/**\n\t* @deprecated\n */"));
+   ASSERT_TRUE(doc_comment_has_tags("/**\r\n * @ns\\tag:x\r\n */"));
+   /// an @ inside a line, or one without a name, is prose
+   ASSERT_FALSE(doc_comment_has_tags("/** plain prose */"));
+   ASSERT_FALSE(doc_comment_has_tags("/** mail me at a@b.c */"));
+   ASSERT_FALSE(doc_comment_has_tags("/**\n * see @link\n */"));
+   ASSERT_FALSE(doc_comment_has_tags("/**\n * @ not a tag\n */"));
+   ASSERT_FALSE(doc_comment_has_tags(""));
+}
+
+TEST(DocCommentTest, testParse)
+{
+   MarkupContext context;
+   Document *document = parse_doc_comment(context, sg_fullComment);
+   ASSERT_EQ(document->getChildren().size(), 5u);
+   /// the summary and the description are paragraphs of their own, the
+   /// continuation line of a tag joins its value
+   ASSERT_EQ(paragraph_text(document->getChildren()[0]), "Summary line.");
+   ASSERT_EQ(paragraph_text(document->getChildren()[1]), "Description that\nspans two lines.");
+   ASSERT_EQ(collect_tags(document), (TagList{
+                                         {"param", "int $a the first continued"},
+                                         {"return", "int"},
+                                         {"throws", "\\Foo\\Bar"}}));
+   document = parse_doc_comment(context, "/** @var string */");
+   ASSERT_EQ(collect_tags(document), (TagList{{"var", "string"}}));
+   ASSERT_EQ(document->getChildren().size(), 1u);
+   /// a blank line ends a tag, what follows is a paragraph again
+   document = parse_doc_comment(context, "/**\n * @internal\n *\n * after\n */");
+   ASSERT_EQ(document->getChildren().size(), 2u);
+   ASSERT_EQ(collect_tags(document), (TagList{{"internal", ""}}));
+   ASSERT_EQ(paragraph_text(document->getChildren()[1]), "after");
+}
+
+TEST(DocCommentTest, testCache)
+{
+   DocCommentCache cache;
+   std::string comment = "/** @var int */";
+   const Document *document = cache.get(comment);
+   ASSERT_NE(document, nullptr);
+   ASSERT_EQ(cache.getNumParses(), 1u);
+   ASSERT_EQ(cache.get(comment), document);
+   ASSERT_EQ(cache.getNumHits(), 1u);
+   /// the same text from another string is the same entry
+   std::string copy = comment;
+   ASSERT_EQ(cache.get(copy), document);
+   ASSERT_EQ(cache.getNumHits(), 2u);
+   /// another text in the same memory, as after the string was freed and
+   /// its address reused, is parsed on its own
+   comment.replace(comment.find("int"), 3, "str");
+   const Document *other = cache.get(comment);
+   ASSERT_NE(other, document);
+   ASSERT_EQ(cache.getNumParses(), 2u);
+   ASSERT_EQ(collect_tags(other), (TagList{{"var", "str"}}));
+   ASSERT_EQ(collect_tags(document), (TagList{{"var", "int"}}));
+   /// a comment without tags is never parsed, and not scanned twice
+   ASSERT_EQ(cache.get("/** plain prose */"), nullptr);
+   ASSERT_EQ(cache.getNumSkipped(), 1u);
+   ASSERT_EQ(cache.get("/** plain prose */"), nullptr);
+   ASSERT_EQ(cache.getNumSkipped(), 1u);
+   ASSERT_EQ(cache.getNumHits(), 3u);
+   ASSERT_EQ(cache.getNumEntries(), 3u);
+   cache.clear();
+   ASSERT_EQ(cache.getNumEntries(), 0u);
+   ASSERT_NE(cache.get(copy), nullptr);
+   ASSERT_EQ(cache.getNumParses(), 3u);
+}
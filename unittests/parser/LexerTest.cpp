@@ -0,0 +1,193 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/parser/Lexer.h"
+
+#include <string>
+#include <vector>
+
+using polar::parser::Lexer;
+using polar::parser::LexerMode;
+using polar::parser::CommentRetentionMode;
+using polar::syntax::Token;
+using polar::syntax::TokenKindType;
+using polar::syntax::get_token_kind_name;
+using polar::basic::StringRef;
+
+namespace {
+
+std::vector<Token> lex_all(StringRef source, LexerMode mode = LexerMode::InlineHtml,
+                           CommentRetentionMode comments = CommentRetentionMode::None)
+{
+   Lexer lexer(source, mode, comments);
+   std::vector<Token> tokens;
+   Token token;
+   do {
+      lexer.lex(token);
+      tokens.push_back(token);
+   } while (token.isNot(TokenKindType::eof));
+   return tokens;
+}
+
+std::vector<TokenKindType> kinds_of(const std::vector<Token> &tokens)
+{
+   std::vector<TokenKindType> kinds;
+   for (const Token &token : tokens) {
+      kinds.push_back(token.getKind());
+   }
+   return kinds;
+}
+
+std::vector<std::string> texts_of(const std::vector<Token> &tokens)
+{
+   std::vector<std::string> texts;
+   for (const Token &token : tokens) {
+      texts.push_back(token.getText().getStr());
+   }
+   return texts;
+}
+
+} // anonymous namespace
+
+TEST(LexerTest, testTokenStream)
+{
+   StringRef source = "<html><?php\n$a = 1 + 2.5;\necho \"x\", 'y'; ?>tail";
+   std::vector<Token> tokens = lex_all(source);
+   std::vector<TokenKindType> expectedKinds = {
+      TokenKindType::inline_html, TokenKindType::open_tag,
+      TokenKindType::variable, TokenKindType::equal, TokenKindType::integer_literal,
+      TokenKindType::plus, TokenKindType::float_literal, TokenKindType::semi,
+      TokenKindType::kw_echo, TokenKindType::string_literal, TokenKindType::comma,
+      TokenKindType::string_literal, TokenKindType::semi, TokenKindType::close_tag,
+      TokenKindType::inline_html, TokenKindType::eof
+   };
+   ASSERT_EQ(kinds_of(tokens), expectedKinds);
+   std::vector<std::string> expectedTexts = {
+      "<html>", "<?php\n", "$a", "=", "1", "+", "2.5", ";", "echo", "\"x\"", ",",
+      "'y'", ";", "?>", "tail", ""
+   };
+   ASSERT_EQ(texts_of(tokens), expectedTexts);
+}
+
+TEST(LexerTest, testTriviaCoversBuffer)
+{
+   StringRef source = "<?php /** doc */ function f() { // line\n  return /* c */ 1;\n}\n";
+   std::vector<Token> tokens = lex_all(source);
+   std::string rebuilt;
+   for (const Token &token : tokens) {
+      rebuilt += token.getRangeWithTrivia().getStr();
+   }
+   ASSERT_EQ(rebuilt, source.getStr());
+   ASSERT_TRUE(tokens[1].hasDocComment());
+   ASSERT_EQ(tokens[1].getKind(), TokenKindType::kw_function);
+   /// the open tag takes the one whitespace after it like the zend scanner
+   ASSERT_EQ(tokens[0].getText(), "<?php ");
+   ASSERT_EQ(tokens[1].getLeadingTrivia(), "/** doc */ ");
+
+   std::vector<Token> withComments = lex_all(source, LexerMode::InlineHtml,
+                                             CommentRetentionMode::ReturnAsTokens);
+   ASSERT_EQ(withComments[1].getKind(), TokenKindType::doc_comment);
+   ASSERT_EQ(withComments[1].getText(), "/** doc */");
+   unsigned comments = 0;
+   for (const Token &token : withComments) {
+      if (token.is(TokenKindType::comment)) {
+         ++comments;
+      }
+   }
+   ASSERT_EQ(comments, 2u);
+}
+
+TEST(LexerTest, testKeywordHashing)
+{
+   /// every keyword has to come back from the perfect hash, in any case
+   std::vector<std::pair<std::string, TokenKindType>> keywords = {
+#define KEYWORD(kw) {#kw, TokenKindType::kw_##kw},
+#include "polarphp/syntax/TokenKinds.def"
+   };
+   ASSERT_FALSE(keywords.empty());
+   for (auto &item : keywords) {
+      ASSERT_EQ(Lexer::getKindOfIdentifier(item.first), item.second) << item.first;
+      std::string upper = StringRef(item.first).toUpper();
+      ASSERT_EQ(Lexer::getKindOfIdentifier(upper), item.second) << upper;
+      std::string longer = item.first + "x";
+      ASSERT_EQ(Lexer::getKindOfIdentifier(longer), TokenKindType::identifier) << longer;
+      std::string shorter = item.first.substr(0, item.first.size() - 1);
+      if (Lexer::getKindOfIdentifier(shorter) != TokenKindType::identifier) {
+         /// only another keyword may sit on a prefix, e.g. include_once
+         ASSERT_NE(Lexer::getKindOfIdentifier(shorter), item.second) << shorter;
+      }
+   }
+   ASSERT_EQ(Lexer::getKindOfIdentifier("Foo"), TokenKindType::identifier);
+   ASSERT_EQ(Lexer::getKindOfIdentifier("classes"), TokenKindType::identifier);
+   ASSERT_EQ(Lexer::getKindOfIdentifier(""), TokenKindType::identifier);
+}
+
+TEST(LexerTest, testKeywordsAsNames)
+{
+   std::vector<Token> tokens = lex_all("$a->class; A::CLASS; Function", LexerMode::Scripting);
+   std::vector<TokenKindType> expectedKinds = {
+      TokenKindType::variable, TokenKindType::arrow, TokenKindType::identifier,
+      TokenKindType::semi, TokenKindType::identifier, TokenKindType::colon_colon,
+      TokenKindType::kw_class, TokenKindType::semi, TokenKindType::kw_function,
+      TokenKindType::eof
+   };
+   ASSERT_EQ(kinds_of(tokens), expectedKinds);
+}
+
+TEST(LexerTest, testCastsAndStrings)
+{
+   StringRef source = "( int )$a; (Double)$b; ($c); \"v $x\"; `ls`; <<<EOT\n  a {$y}\n  EOT;\n"
+                      "<<<'N'\nraw $z\nN;\n'open";
+   std::vector<Token> tokens = lex_all(source, LexerMode::Scripting);
+   ASSERT_EQ(tokens[0].getKind(), TokenKindType::int_cast);
+   ASSERT_EQ(tokens[0].getText(), "( int )");
+   ASSERT_EQ(tokens[3].getKind(), TokenKindType::double_cast);
+   ASSERT_EQ(tokens[6].getKind(), TokenKindType::l_paren);
+   ASSERT_EQ(tokens[10].getKind(), TokenKindType::string_literal);
+   ASSERT_TRUE(tokens[10].isInterpolated());
+   ASSERT_EQ(tokens[12].getKind(), TokenKindType::backquote_literal);
+   ASSERT_FALSE(tokens[12].isInterpolated());
+   ASSERT_EQ(tokens[14].getKind(), TokenKindType::heredoc_literal);
+   ASSERT_TRUE(tokens[14].isInterpolated());
+   ASSERT_EQ(tokens[14].getText(), "<<<EOT\n  a {$y}\n  EOT");
+   ASSERT_EQ(tokens[16].getKind(), TokenKindType::nowdoc_literal);
+   ASSERT_FALSE(tokens[16].isInterpolated());
+   ASSERT_EQ(tokens[18].getKind(), TokenKindType::string_literal);
+   ASSERT_TRUE(tokens[18].isUnterminated());
+   ASSERT_EQ(tokens[19].getKind(), TokenKindType::eof);
+}
+
+TEST(LexerTest, testRestoreState)
+{
+   StringRef source = "<?php foo(1, 2); ?>x";
+   Lexer lexer(source);
+   Token token;
+   lexer.lex(token);
+   lexer.lex(token);
+   ASSERT_EQ(token.getText(), "foo");
+   Lexer::State state = lexer.getState();
+   std::vector<std::string> first;
+   do {
+      lexer.lex(token);
+      first.push_back(token.getText().getStr());
+   } while (token.isNot(TokenKindType::eof));
+   ASSERT_TRUE(lexer.isAtEndOfBuffer());
+   lexer.restoreState(state);
+   ASSERT_EQ(lexer.getMode(), LexerMode::Scripting);
+   std::vector<std::string> second;
+   do {
+      lexer.lex(token);
+      second.push_back(token.getText().getStr());
+   } while (token.isNot(TokenKindType::eof));
+   ASSERT_EQ(first, second);
+   ASSERT_EQ(first.size(), 9u);
+}
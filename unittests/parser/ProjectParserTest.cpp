@@ -0,0 +1,183 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/parser/ProjectParser.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <string>
+#include <vector>
+
+using polar::parser::ProjectParser;
+using polar::parser::ProjectParserOptions;
+using polar::parser::IndexedDecl;
+using polar::parser::IndexedDeclKind;
+using polar::parser::ProjectDiagnostic;
+using polar::parser::ProjectDiagnosticKind;
+using polar::utils::RawStringOutStream;
+
+namespace {
+
+const char *sg_library =
+      "<?php\n"
+      "namespace Lib\\Util;\n"
+      "/** helpers */\n"
+      "final class Helper extends Base implements \\Countable {\n"
+      "   public function count() { return 0; }\n"
+      "}\n"
+      "interface Shape {}\n"
+      "trait Named { function name() {} }\n"
+      "function format($value) { return (string) $value; }\n"
+      "const LIMIT = 10;\n";
+
+const char *sg_global =
+      "<?php\n"
+      "function format($value) {}\n"
+      "function strlen_ex() {}\n"
+      "const LIMIT = 20;\n";
+
+std::string print_diagnostics(const ProjectParser &parser)
+{
+   std::string result;
+   RawStringOutStream out(result);
+   parser.printDiagnostics(out);
+   out.flush();
+   return result;
+}
+
+/// a project big enough that every worker gets several files
+std::vector<std::string> make_project(unsigned fileCount)
+{
+   std::vector<std::string> files;
+   for (unsigned i = 0; i < fileCount; ++i) {
+      std::string text = "<?php\nnamespace Gen" + std::to_string(i % 7) + ";\n";
+      for (unsigned j = 0; j < i % 13 + 1; ++j) {
+         text += "class C" + std::to_string(i) + "_" + std::to_string(j) +
+               " { function f() { return [" + std::to_string(j) + "]; } }\n";
+      }
+      /// every seventh file redeclares a function of an earlier one, every
+      /// eleventh has an unbalanced brace
+      text += "function f" + std::to_string(i % 7 == 0 ? 0 : i) + "() {}\n";
+      if (i % 11 == 5) {
+         text += "function broken() { if (1) {\n";
+      }
+      files.push_back(std::move(text));
+   }
+   return files;
+}
+
+void parse_project(const std::vector<std::string> &files, unsigned threadCount,
+                   std::vector<IndexedDecl> &decls, std::string &diagnostics)
+{
+   ProjectParserOptions options;
+   options.threadCount = threadCount;
+   ProjectParser parser(options);
+   for (unsigned i = 0; i < files.size(); ++i) {
+      parser.addBuffer("gen" + std::to_string(i) + ".php", files[i]);
+   }
+   ASSERT_TRUE(parser.parseAll());
+   decls.assign(parser.getIndex().getDecls().begin(), parser.getIndex().getDecls().end());
+   diagnostics = print_diagnostics(parser);
+}
+
+} // anonymous namespace
+
+TEST(ProjectParserTest, testIndex)
+{
+   ProjectParser parser;
+   parser.addBuffer("lib.php", sg_library);
+   parser.addBuffer("global.php", sg_global);
+   ASSERT_TRUE(parser.parseAll());
+   ASSERT_EQ(parser.getNumErrors(), 0u);
+   const auto &index = parser.getIndex();
+   ASSERT_EQ(index.getDecls().size(), 8u);
+
+   const IndexedDecl *helper = index.lookupClassLike("\\lib\\UTIL\\helper");
+   ASSERT_NE(helper, nullptr);
+   ASSERT_EQ(helper->kind, IndexedDeclKind::Class);
+   ASSERT_EQ(helper->name, "Lib\\Util\\Helper");
+   ASSERT_EQ(helper->signature, "final class Helper extends Base implements \\Countable");
+   ASSERT_EQ(helper->docComment, "/** helpers */");
+   ASSERT_EQ(helper->fileIndex, 0u);
+   ASSERT_EQ(helper->line, 4u);
+   /// decls are located at their name
+   ASSERT_EQ(helper->column, 13u);
+   ASSERT_EQ(index.lookupClassLike("Lib\\Util\\Shape")->kind, IndexedDeclKind::Interface);
+   ASSERT_EQ(index.lookupClassLike("Lib\\Util\\Named")->kind, IndexedDeclKind::Trait);
+   /// methods are not top level declarations
+   ASSERT_EQ(index.lookupFunction("Lib\\Util\\count"), nullptr);
+   /// constants are case sensitive, functions are not
+   ASSERT_NE(index.lookupConstant("Lib\\Util\\LIMIT"), nullptr);
+   ASSERT_EQ(index.lookupConstant("Lib\\Util\\limit"), nullptr);
+   ASSERT_EQ(index.lookupConstant("Lib\\Util\\LIMIT")->signature, "const LIMIT = 10");
+   ASSERT_NE(index.lookupFunction("LIB\\util\\FORMAT"), nullptr);
+}
+
+TEST(ProjectParserTest, testResolve)
+{
+   ProjectParser parser;
+   parser.addBuffer("lib.php", sg_library);
+   parser.addBuffer("global.php", sg_global);
+   ASSERT_TRUE(parser.parseAll());
+   const auto &index = parser.getIndex();
+   /// the namespaced function wins over the global one
+   ASSERT_EQ(index.resolveFunction("format", "Lib\\Util")->fileIndex, 0u);
+   ASSERT_EQ(index.resolveFunction("\\format", "Lib\\Util")->fileIndex, 1u);
+   /// an unqualified name falls back to the global namespace
+   ASSERT_EQ(index.resolveFunction("strlen_ex", "Lib\\Util")->fileIndex, 1u);
+   /// a qualified one does not
+   ASSERT_EQ(index.resolveFunction("Util\\strlen_ex", "Lib"), nullptr);
+   ASSERT_EQ(index.resolveFunction("Util\\format", "Lib")->fileIndex, 0u);
+   ASSERT_EQ(index.resolveConstant("LIMIT", "Lib\\Util")->signature, "const LIMIT = 10");
+   ASSERT_EQ(index.resolveConstant("LIMIT", "")->signature, "const LIMIT = 20");
+   ASSERT_EQ(index.resolveConstant("LIMIT", "Other")->signature, "const LIMIT = 20");
+}
+
+TEST(ProjectParserTest, testDiagnostics)
+{
+   ProjectParser parser;
+   parser.addBuffer("a.php", "<?php\nclass Dup {}\nfunction f() { (\n}\n");
+   parser.addBuffer("b.php", "<?php\n\ninterface dup {}\n");
+   ASSERT_TRUE(parser.parseAll());
+   ASSERT_EQ(parser.getNumErrors(), 2u);
+   ASSERT_EQ(print_diagnostics(parser),
+             "a.php:3:16: error: bracket is never closed\n"
+             "b.php:3:11: error: cannot redeclare interface 'dup'\n"
+             "b.php:3:11: note: previously declared in a.php:2\n");
+
+   parser.addFile("/no/such/dir/missing.php");
+   ASSERT_FALSE(parser.parseAll());
+   ASSERT_EQ(parser.getDiagnostics().back().fileIndex, 2u);
+   ASSERT_EQ(parser.getDiagnostics().back().kind, ProjectDiagnosticKind::Error);
+   /// the files already parsed are kept
+   ASSERT_NE(parser.getIndex().lookupClassLike("Dup"), nullptr);
+}
+
+TEST(ProjectParserTest, testThreadCountDoesNotChangeResult)
+{
+   std::vector<std::string> files = make_project(120);
+   std::vector<IndexedDecl> sequentialDecls;
+   std::string sequentialDiagnostics;
+   parse_project(files, 1, sequentialDecls, sequentialDiagnostics);
+   ASSERT_FALSE(sequentialDiagnostics.empty());
+   for (unsigned threadCount : {2u, 8u}) {
+      std::vector<IndexedDecl> decls;
+      std::string diagnostics;
+      parse_project(files, threadCount, decls, diagnostics);
+      ASSERT_EQ(diagnostics, sequentialDiagnostics);
+      ASSERT_EQ(decls.size(), sequentialDecls.size());
+      for (std::size_t i = 0; i < decls.size(); ++i) {
+         ASSERT_EQ(decls[i].name, sequentialDecls[i].name);
+         ASSERT_EQ(decls[i].fileIndex, sequentialDecls[i].fileIndex);
+         ASSERT_EQ(decls[i].offset, sequentialDecls[i].offset);
+      }
+   }
+}
@@ -0,0 +1,281 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/parser/SourceTransformer.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/basic/adt/Twine.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using polar::parser::strip_source;
+using polar::parser::highlight_source;
+using polar::parser::transform_source_files;
+using polar::parser::HighlightColors;
+using polar::parser::SourceTransformKind;
+using polar::parser::SourceTransformOptions;
+using polar::basic::SmallString;
+using polar::basic::StringRef;
+using polar::basic::Twine;
+using polar::utils::RawStringOutStream;
+
+namespace fs = polar::fs;
+
+namespace {
+
+std::string strip(StringRef source)
+{
+   std::string result;
+   RawStringOutStream out(result);
+   strip_source(source, out);
+   out.flush();
+   return result;
+}
+
+std::string highlight(StringRef source)
+{
+   std::string result;
+   RawStringOutStream out(result);
+   highlight_source(source, out, HighlightColors());
+   out.flush();
+   return result;
+}
+
+const char *sg_heredocs =
+      "<html>\n"
+      "<?php\n"
+      "/** doc */\n"
+      "$a = <<<EOT\n"
+      "  x <b> & y\n"
+      "EOT;\n"
+      "$b = <<<'RAW'\n"
+      "raw\n"
+      "RAW\n"
+      "  ; // trailing\n"
+      "# hash comment\n"
+      "echo $a,   \"s&t\"; /* block */ ?>\n"
+      "<p>&</p>\n";
+
+const char *sg_escaping =
+      "<?php\n"
+      "echo \"<a href=\\\"x\\\">\" . $t;\t// tab & <tag>\n"
+      "/* multi\n"
+      "   line */ $u = 1 & 2 > 0;\n"
+      "?>\n"
+      "after & <b>\n";
+
+/// a directory of its own for the files of one test, gone with it
+class ScopedSourceDirectory
+{
+public:
+   ScopedSourceDirectory()
+   {
+      EXPECT_FALSE(fs::create_unique_directory("SourceTransformerTest", m_path));
+   }
+
+   ~ScopedSourceDirectory()
+   {
+      fs::remove_directories(m_path);
+   }
+
+   std::string write(StringRef name, StringRef source)
+   {
+      std::string path = (Twine(m_path) + "/" + name).getStr();
+      std::ofstream file(path, std::ios::binary);
+      file.write(source.getData(), source.getSize());
+      return path;
+   }
+
+   std::string getPath(StringRef name) const
+   {
+      return (Twine(m_path) + "/" + name).getStr();
+   }
+
+private:
+   SmallString<128> m_path;
+};
+
+} // anonymous namespace
+
+TEST(SourceTransformerTest, testStripHeredoc)
+{
+   /// the closing label ends its line, a ; glued to it stays on that line,
+   /// one behind whitespace starts the next
+   ASSERT_EQ(strip(sg_heredocs),
+             "<html>\n"
+             "<?php\n"
+             " $a = <<<EOT\n"
+             "  x <b> & y\n"
+             "EOT;\n"
+             "$b = <<<'RAW'\n"
+             "raw\n"
+             "RAW\n"
+             "; echo $a, \"s&t\"; ?>\n"
+             "<p>&</p>\n");
+   ASSERT_EQ(strip("<?php\n$x = <<<A\nq\nA;\n$y = 1;"), "<?php\n$x = <<<A\nq\nA;\n$y = 1;");
+   /// the end of the file right after the label still ends the line
+   ASSERT_EQ(strip("<?php $x = <<<A\nq\nA"), "<?php $x = <<<A\nq\nA\n");
+}
+
+TEST(SourceTransformerTest, testStripComments)
+{
+   /// comments go, the whitespace around them folds into one space, html
+   /// and strings are left as they are
+   ASSERT_EQ(strip(sg_escaping),
+             "<?php\n"
+             "echo \"<a href=\\\"x\\\">\" . $t; $u = 1 & 2 > 0; ?>\n"
+             "after & <b>\n");
+   ASSERT_EQ(strip("<?php\n// c\necho 1;\n"), "<?php\n echo 1; ");
+   ASSERT_EQ(strip("no php here\n"), "no php here\n");
+}
+
+TEST(SourceTransformerTest, testHighlightHeredoc)
+{
+   ASSERT_EQ(highlight(sg_heredocs),
+             "<code><span style=\"color: #000000\">\n"
+             "&lt;html&gt;<br />"
+             "<span style=\"color: #0000BB\">&lt;?php<br /></span>"
+             "<span style=\"color: #FF8000\">/**&nbsp;doc&nbsp;*/<br /></span>"
+             "<span style=\"color: #0000BB\">$a&nbsp;</span>"
+             "<span style=\"color: #007700\">=&nbsp;</span>"
+             "<span style=\"color: #DD0000\">&lt;&lt;&lt;EOT<br />&nbsp;&nbsp;x&nbsp;&lt;b&gt;&nbsp;&amp;&nbsp;y<br />EOT</span>"
+             "<span style=\"color: #007700\">;<br /></span>"
+             "<span style=\"color: #0000BB\">$b&nbsp;</span>"
+             "<span style=\"color: #007700\">=&nbsp;</span>"
+             "<span style=\"color: #DD0000\">&lt;&lt;&lt;'RAW'<br />raw<br />RAW<br />&nbsp;&nbsp;</span>"
+             "<span style=\"color: #007700\">;&nbsp;</span>"
+             "<span style=\"color: #FF8000\">//&nbsp;trailing<br />#&nbsp;hash&nbsp;comment<br /></span>"
+             "<span style=\"color: #007700\">echo&nbsp;</span>"
+             "<span style=\"color: #0000BB\">$a</span>"
+             "<span style=\"color: #007700\">,&nbsp;&nbsp;&nbsp;</span>"
+             "<span style=\"color: #DD0000\">\"s&amp;t\"</span>"
+             "<span style=\"color: #007700\">;&nbsp;</span>"
+             "<span style=\"color: #FF8000\">/*&nbsp;block&nbsp;*/&nbsp;</span>"
+             "<span style=\"color: #0000BB\">?&gt;<br /></span>"
+             "&lt;p&gt;&amp;&lt;/p&gt;<br /></span>\n"
+             "</code>");
+}
+
+TEST(SourceTransformerTest, testHighlightEscaping)
+{
+   /// tabs become four spaces, every <, >, & and newline is escaped in
+   /// html, strings and comments alike
+   ASSERT_EQ(highlight(sg_escaping),
+             "<code><span style=\"color: #000000\">\n"
+             "<span style=\"color: #0000BB\">&lt;?php<br /></span>"
+             "<span style=\"color: #007700\">echo&nbsp;</span>"
+             "<span style=\"color: #DD0000\">\"&lt;a&nbsp;href=\\\"x\\\"&gt;\"&nbsp;</span>"
+             "<span style=\"color: #007700\">.&nbsp;</span>"
+             "<span style=\"color: #0000BB\">$t</span>"
+             "<span style=\"color: #007700\">;&nbsp;&nbsp;&nbsp;&nbsp;</span>"
+             "<span style=\"color: #FF8000\">//&nbsp;tab&nbsp;&amp;&nbsp;&lt;tag&gt;<br />/*&nbsp;multi<br />&nbsp;&nbsp;&nbsp;line&nbsp;*/&nbsp;</span>"
+             "<span style=\"color: #0000BB\">$u&nbsp;</span>"
+             "<span style=\"color: #007700\">=&nbsp;</span>"
+             "<span style=\"color: #0000BB\">1&nbsp;</span>"
+             "<span style=\"color: #007700\">&amp;&nbsp;</span>"
+             "<span style=\"color: #0000BB\">2&nbsp;</span>"
+             "<span style=\"color: #007700\">&gt;&nbsp;</span>"
+             "<span style=\"color: #0000BB\">0</span>"
+             "<span style=\"color: #007700\">;<br /></span>"
+             "<span style=\"color: #0000BB\">?&gt;<br /></span>"
+             "after&nbsp;&amp;&nbsp;&lt;b&gt;<br /></span>\n"
+             "</code>");
+   /// the ini colors are used as they are
+   HighlightColors colors;
+   colors.html = "red";
+   colors.keyword = "blue";
+   std::string result;
+   RawStringOutStream out(result);
+   highlight_source("a<?php ;", out, colors);
+   out.flush();
+   ASSERT_EQ(result, "<code><span style=\"color: red\">\n"
+                     "a<span style=\"color: #0000BB\">&lt;?php&nbsp;</span>"
+                     "<span style=\"color: blue\">;</span>\n"
+                     "</span>\n"
+                     "</code>");
+}
+
+TEST(SourceTransformerTest, testMultipleFiles)
+{
+   ScopedSourceDirectory directory;
+   std::vector<std::string> paths;
+   std::string expected;
+   /// more files than the workers may have in flight, in an order that
+   /// is not the one of their names
+   for (int i = 40; i > 0; --i) {
+      std::string source = "<?php /* file " + std::to_string(i) + " */ echo " +
+            std::to_string(i) + ";\n";
+      if (i % 3 == 0) {
+         source += "$h = <<<EOT\n" + std::string(i * 100, 'x') + "\nEOT\n  ;\n";
+      }
+      paths.push_back(directory.write("file" + std::to_string(i) + ".php", source));
+      expected += strip(source);
+   }
+   for (unsigned threadCount : {1u, 2u, 4u}) {
+      SourceTransformOptions options;
+      options.threadCount = threadCount;
+      std::string result;
+      std::string errors;
+      RawStringOutStream out(result);
+      RawStringOutStream errorOut(errors);
+      ASSERT_TRUE(transform_source_files(paths, out, errorOut, options)) << threadCount << " threads";
+      out.flush();
+      errorOut.flush();
+      ASSERT_EQ(result, expected) << threadCount << " threads";
+      ASSERT_EQ(errors, "") << threadCount << " threads";
+   }
+   SourceTransformOptions options;
+   options.kind = SourceTransformKind::Highlight;
+   options.threadCount = 4;
+   std::string result;
+   std::string errors;
+   RawStringOutStream out(result);
+   RawStringOutStream errorOut(errors);
+   ASSERT_TRUE(transform_source_files(paths, out, errorOut, options));
+   out.flush();
+   std::string highlighted;
+   for (const std::string &path : paths) {
+      std::ifstream file(path, std::ios::binary);
+      highlighted += highlight(std::string(std::istreambuf_iterator<char>(file),
+                                           std::istreambuf_iterator<char>()));
+   }
+   ASSERT_EQ(result, highlighted);
+}
+
+TEST(SourceTransformerTest, testMissingFile)
+{
+   ScopedSourceDirectory directory;
+   std::string missing = directory.getPath("missing.php");
+   std::vector<std::string> paths = {
+      directory.write("first.php", "<?php echo 1; // one\n"),
+      missing,
+      directory.write("last.php", "<?php echo 2; // two\n")
+   };
+   for (unsigned threadCount : {1u, 3u}) {
+      SourceTransformOptions options;
+      options.threadCount = threadCount;
+      std::string result;
+      std::string errors;
+      RawStringOutStream out(result);
+      RawStringOutStream errorOut(errors);
+      /// the other files are still written, in their order
+      ASSERT_FALSE(transform_source_files(paths, out, errorOut, options)) << threadCount << " threads";
+      out.flush();
+      errorOut.flush();
+      ASSERT_EQ(result, "<?php echo 1; <?php echo 2; ") << threadCount << " threads";
+      ASSERT_EQ(errors, "Could not open input file: " + missing + "\n") << threadCount << " threads";
+   }
+}
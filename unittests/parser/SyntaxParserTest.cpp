@@ -0,0 +1,158 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/parser/SyntaxParser.h"
+#include "polarphp/syntax/RawSyntax.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <string>
+
+using polar::parser::SyntaxParser;
+using polar::parser::SourceEdit;
+using polar::parser::ReparseStats;
+using polar::parser::SyntaxIssue;
+using polar::parser::SyntaxIssueKind;
+using polar::syntax::Syntax;
+using polar::syntax::SyntaxKind;
+using polar::syntax::RawSyntax;
+using polar::utils::RawStringOutStream;
+
+namespace {
+
+const char *sg_source =
+      "<?php\n"
+      "namespace App;\n"
+      "function first($a) {\n"
+      "   $b = [1, 2, ($a + 3)];\n"
+      "   return $b;\n"
+      "}\n"
+      "class Second {\n"
+      "   public function run() {\n"
+      "      if ($this->ok) { echo 'yes'; } else { echo \"no\"; }\n"
+      "   }\n"
+      "}\n"
+      "echo first(1);\n"
+      "?>\n"
+      "<p>tail</p>\n";
+
+std::string dump_tree(const Syntax &tree)
+{
+   std::string result;
+   RawStringOutStream out(result);
+   tree.getRaw()->dump(out);
+   out.flush();
+   return result;
+}
+
+/// replaces text at offset and checks that reparsing the old tree gives the
+/// same tree as parsing the new text from scratch
+Syntax check_edit(const SyntaxParser &parser, const Syntax &oldTree, std::string &source,
+                  unsigned offset, unsigned removed, const std::string &inserted,
+                  ReparseStats &stats)
+{
+   source.replace(offset, removed, inserted);
+   SourceEdit edit{offset, removed, static_cast<unsigned>(inserted.size())};
+   Syntax reparsed = parser.reparse(oldTree, source, edit, &stats);
+   Syntax parsed = parser.parse(source);
+   EXPECT_EQ(reparsed.getSourceText(), source);
+   EXPECT_EQ(dump_tree(reparsed), dump_tree(parsed));
+   return reparsed;
+}
+
+bool shares_raw(const Syntax &left, const Syntax &right)
+{
+   return left.getRaw() == right.getRaw();
+}
+
+} // anonymous namespace
+
+TEST(SyntaxParserTest, testLossless)
+{
+   SyntaxParser parser;
+   std::vector<SyntaxIssue> issues;
+   Syntax tree = parser.parse(sg_source, &issues);
+   ASSERT_TRUE(tree.is(SyntaxKind::SourceFile));
+   ASSERT_EQ(tree.getSourceText(), sg_source);
+   ASSERT_TRUE(issues.empty());
+   ASSERT_EQ(tree.getEndOffset(), std::strlen(sg_source));
+
+   std::optional<Syntax> token = tree.findTokenAt(std::string(sg_source).find("Second"));
+   ASSERT_TRUE(token.has_value());
+   ASSERT_EQ(token->getTokenText(), "Second");
+}
+
+TEST(SyntaxParserTest, testIssues)
+{
+   SyntaxParser parser;
+   std::vector<SyntaxIssue> issues;
+   std::string source = "<?php\nfunction f() { echo 1; }}\nfunction g() { if (1 {\n";
+   Syntax tree = parser.parse(source, &issues);
+   ASSERT_EQ(tree.getSourceText(), source);
+   ASSERT_FALSE(issues.empty());
+   ASSERT_EQ(issues.front().kind, SyntaxIssueKind::UnmatchedCloser);
+   ASSERT_EQ(issues.front().offset, source.find("}}") + 1);
+   for (std::size_t i = 1; i < issues.size(); ++i) {
+      ASSERT_LE(issues[i - 1].offset, issues[i].offset);
+   }
+}
+
+TEST(SyntaxParserTest, testReparseInsideBlock)
+{
+   SyntaxParser parser;
+   std::string source = sg_source;
+   Syntax tree = parser.parse(source);
+   ReparseStats stats;
+   unsigned offset = source.find("return $b;");
+   Syntax reparsed = check_edit(parser, tree, source, offset, 0, "$b[] = 4;\n   ", stats);
+   ASSERT_FALSE(stats.fullParse);
+   ASSERT_LT(stats.reparsedBytes, source.size() / 2);
+   /// the statements in front of the edit and the class after it are reused
+   ASSERT_TRUE(shares_raw(reparsed.getChild(0), tree.getChild(0)));
+   ASSERT_TRUE(shares_raw(reparsed.getChild(1), tree.getChild(1)));
+   ASSERT_TRUE(shares_raw(reparsed.getChild(3), tree.getChild(3)));
+   ASSERT_FALSE(shares_raw(reparsed.getChild(2), tree.getChild(2)));
+}
+
+TEST(SyntaxParserTest, testReparseSequence)
+{
+   SyntaxParser parser;
+   std::string source = sg_source;
+   Syntax tree = parser.parse(source);
+   ReparseStats stats;
+   /// change a literal, rename a method, delete a whole statement, then
+   /// retype it, every step must match a parse from scratch
+   tree = check_edit(parser, tree, source, source.find("'yes'"), 5, "'yes please'", stats);
+   tree = check_edit(parser, tree, source, source.find("run"), 3, "execute", stats);
+   std::size_t echoStart = source.find("echo first(1);");
+   tree = check_edit(parser, tree, source, echoStart, 15, "", stats);
+   tree = check_edit(parser, tree, source, echoStart, 0, "echo first(2);\n", stats);
+   tree = check_edit(parser, tree, source, source.size(), 0, "<?php echo 3;", stats);
+   ASSERT_EQ(tree.getSourceText(), source);
+}
+
+TEST(SyntaxParserTest, testReparseUnbalancedEdit)
+{
+   SyntaxParser parser;
+   std::string source = sg_source;
+   Syntax tree = parser.parse(source);
+   ReparseStats stats;
+   /// an unterminated string swallows the rest of the block, the reparse
+   /// has to widen to the enclosing blocks and still agree with a full parse
+   tree = check_edit(parser, tree, source, source.find("return $b;"), 0, "$s = 'open;\n   ", stats);
+   tree = check_edit(parser, tree, source, source.find("'open;") + 5, 0, "'", stats);
+   /// an extra closing brace moves every following statement to the top level
+   tree = check_edit(parser, tree, source, source.find("echo 'yes';"), 0, "} ", stats);
+   tree = check_edit(parser, tree, source, source.find("} echo 'yes';"), 2, "", stats);
+   /// an unterminated comment reaches the end of file
+   tree = check_edit(parser, tree, source, source.find("class Second"), 0, "/* ", stats);
+   ASSERT_EQ(tree.getSourceText(), source);
+}
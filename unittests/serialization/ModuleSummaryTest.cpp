@@ -0,0 +1,287 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/serialization/ModuleSummary.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <string>
+#include <vector>
+
+using polar::basic::ArrayRef;
+using polar::basic::SmallString;
+using polar::basic::StringRef;
+using polar::parser::ProjectParser;
+using polar::parser::ProjectParserOptions;
+using polar::parser::ProjectDiagnosticKind;
+using polar::serialization::IndexedDecl;
+using polar::serialization::IndexedDeclKind;
+using polar::serialization::ProjectDiagnostic;
+using polar::serialization::ModuleSummaryWriter;
+using polar::serialization::ModuleSummaryReader;
+using polar::serialization::ModuleSummaryCache;
+using polar::utils::MemoryBuffer;
+using polar::utils::RawFdOutStream;
+using polar::utils::RawStringOutStream;
+
+namespace {
+
+std::vector<std::string> sg_sources = {
+   "<?php\nnamespace App;\n/** the entry point */\nfinal class Kernel extends Base {}\n"
+   "function boot() { (\n}\n",
+   "<?php\nnamespace App\\Model;\ninterface Entity {}\ntrait Timestamps {}\n"
+   "const TABLE = 'users';\n",
+   "<?php\nfunction helper() {}\nclass kernel {}\n",
+   "<html>no declarations here</html>\n"
+};
+
+void expect_same_decl(const IndexedDecl &left, const IndexedDecl &right)
+{
+   EXPECT_EQ(left.kind, right.kind);
+   EXPECT_EQ(left.fileIndex, right.fileIndex);
+   EXPECT_EQ(left.offset, right.offset);
+   EXPECT_EQ(left.line, right.line);
+   EXPECT_EQ(left.column, right.column);
+   EXPECT_EQ(left.name, right.name);
+   EXPECT_EQ(left.signature, right.signature);
+   EXPECT_EQ(left.docComment, right.docComment);
+}
+
+void expect_same_diagnostic(const ProjectDiagnostic &left, const ProjectDiagnostic &right)
+{
+   EXPECT_EQ(left.kind, right.kind);
+   EXPECT_EQ(left.fileIndex, right.fileIndex);
+   EXPECT_EQ(left.offset, right.offset);
+   EXPECT_EQ(left.line, right.line);
+   EXPECT_EQ(left.column, right.column);
+   EXPECT_EQ(left.message, right.message);
+}
+
+std::string print_diagnostics(const ProjectParser &parser)
+{
+   std::string result;
+   RawStringOutStream out(result);
+   parser.printDiagnostics(out);
+   out.flush();
+   return result;
+}
+
+/// the per file results of a parse, without the cross file diagnostics
+/// merge adds
+struct FileResults
+{
+   std::vector<IndexedDecl> decls;
+   std::vector<ProjectDiagnostic> diagnostics;
+};
+
+class RecordingCache : public polar::parser::ParseResultCache
+{
+public:
+   bool lookup(StringRef, uint64_t, unsigned, std::vector<IndexedDecl> &,
+               std::vector<ProjectDiagnostic> &) override
+   {
+      return false;
+   }
+
+   void store(StringRef path, uint64_t contentHash, ArrayRef<IndexedDecl> decls,
+              ArrayRef<ProjectDiagnostic> diagnostics) override
+   {
+      paths.push_back(path.getStr());
+      hashes.push_back(contentHash);
+      results.push_back({{decls.begin(), decls.end()}, {diagnostics.begin(), diagnostics.end()}});
+   }
+
+   std::vector<std::string> paths;
+   std::vector<uint64_t> hashes;
+   std::vector<FileResults> results;
+};
+
+class ModuleSummaryTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      ASSERT_FALSE(polar::fs::create_unique_directory("module-summary-test", m_directory));
+      m_summaryPath = (m_directory + "/project.summary").getStr();
+   }
+
+   void TearDown() override
+   {
+      polar::fs::remove_directories(m_directory);
+   }
+
+   std::string writeSource(unsigned index, const std::string &text)
+   {
+      std::string path = (m_directory + "/file" + std::to_string(index) + ".php").getStr();
+      std::error_code errorCode;
+      RawFdOutStream out(path, errorCode, polar::fs::F_None);
+      out << text;
+      return path;
+   }
+
+   SmallString<128> m_directory;
+   std::string m_summaryPath;
+};
+
+} // anonymous namespace
+
+TEST_F(ModuleSummaryTest, testRoundTrip)
+{
+   RecordingCache recorder;
+   ProjectParserOptions options;
+   options.cache = &recorder;
+   ProjectParser parser(options);
+   for (unsigned i = 0; i < sg_sources.size(); ++i) {
+      parser.addBuffer("src/file" + std::to_string(i) + ".php", sg_sources[i]);
+   }
+   ASSERT_TRUE(parser.parseAll());
+   ASSERT_EQ(recorder.results.size(), sg_sources.size());
+
+   ModuleSummaryWriter writer;
+   for (unsigned i = 0; i < recorder.results.size(); ++i) {
+      writer.addFile(recorder.paths[i], recorder.hashes[i], recorder.results[i].decls,
+                     recorder.results[i].diagnostics);
+   }
+   ASSERT_FALSE(static_cast<bool>(writer.writeToFile(m_summaryPath)));
+
+   auto readerOrError = ModuleSummaryReader::open(m_summaryPath);
+   ASSERT_TRUE(static_cast<bool>(readerOrError));
+   std::unique_ptr<ModuleSummaryReader> reader = std::move(*readerOrError);
+   ASSERT_EQ(reader->getNumFiles(), sg_sources.size());
+   ASSERT_EQ(reader->getNumDecls(), parser.getIndex().getDecls().size());
+   for (unsigned i = 0; i < recorder.paths.size(); ++i) {
+      std::optional<unsigned> summaryFile = reader->findFile(recorder.paths[i]);
+      ASSERT_TRUE(summaryFile.has_value());
+      ASSERT_EQ(reader->getFilePath(*summaryFile), recorder.paths[i]);
+      ASSERT_EQ(reader->getContentHash(*summaryFile), recorder.hashes[i]);
+      /// decoded under a different file index, the way a cache hit is
+      FileResults decoded;
+      reader->readFile(*summaryFile, i + 10, decoded.decls, decoded.diagnostics);
+      const FileResults &original = recorder.results[i];
+      ASSERT_EQ(decoded.decls.size(), original.decls.size());
+      ASSERT_EQ(decoded.diagnostics.size(), original.diagnostics.size());
+      for (std::size_t j = 0; j < decoded.decls.size(); ++j) {
+         IndexedDecl expected = original.decls[j];
+         expected.fileIndex = i + 10;
+         expect_same_decl(decoded.decls[j], expected);
+      }
+      for (std::size_t j = 0; j < decoded.diagnostics.size(); ++j) {
+         ProjectDiagnostic expected = original.diagnostics[j];
+         expected.fileIndex = i + 10;
+         expect_same_diagnostic(decoded.diagnostics[j], expected);
+      }
+   }
+   ASSERT_FALSE(reader->findFile("src/none.php").has_value());
+
+   std::optional<IndexedDecl> kernel = reader->lookupDecl("\\APP\\kernel", IndexedDeclKind::Class);
+   ASSERT_TRUE(kernel.has_value());
+   ASSERT_EQ(kernel->signature, "final class Kernel extends Base");
+   ASSERT_EQ(kernel->docComment, "/** the entry point */");
+   ASSERT_EQ(reader->getFilePath(kernel->fileIndex), "src/file0.php");
+   /// a class like kind matches interfaces and traits as well
+   ASSERT_EQ(reader->lookupDecl("App\\Model\\Entity", IndexedDeclKind::Class)->kind,
+             IndexedDeclKind::Interface);
+   ASSERT_TRUE(reader->lookupDecl("App\\Model\\TABLE", IndexedDeclKind::Constant).has_value());
+   ASSERT_FALSE(reader->lookupDecl("App\\Model\\table", IndexedDeclKind::Constant).has_value());
+   ASSERT_FALSE(reader->lookupDecl("App\\boot", IndexedDeclKind::Class).has_value());
+   for (unsigned i = 0; i < reader->getNumDecls(); ++i) {
+      IndexedDecl decl = reader->getDecl(i);
+      ASSERT_LT(decl.fileIndex, reader->getNumFiles());
+      ASSERT_FALSE(decl.name.empty());
+   }
+}
+
+TEST_F(ModuleSummaryTest, testCacheSkipsUnchangedFiles)
+{
+   std::vector<std::string> sources = sg_sources;
+   std::vector<std::string> paths;
+   for (unsigned i = 0; i < sources.size(); ++i) {
+      paths.push_back(writeSource(i, sources[i]));
+   }
+   std::string coldDiagnostics;
+   {
+      ModuleSummaryCache cache(m_summaryPath);
+      ASSERT_EQ(cache.getPreviousSummary(), nullptr);
+      ProjectParserOptions options;
+      options.cache = &cache;
+      ProjectParser parser(options);
+      for (const std::string &path : paths) {
+         parser.addFile(path);
+      }
+      ASSERT_TRUE(parser.parseAll());
+      ASSERT_EQ(parser.getNumCachedFiles(), 0u);
+      coldDiagnostics = print_diagnostics(parser);
+      ASSERT_FALSE(static_cast<bool>(cache.save()));
+   }
+
+   sources[2] = "<?php\nfunction helper() {}\nfunction helper2() {}\nclass kernel {}\n";
+   writeSource(2, sources[2]);
+   ModuleSummaryCache cache(m_summaryPath);
+   ASSERT_NE(cache.getPreviousSummary(), nullptr);
+   ProjectParserOptions options;
+   options.cache = &cache;
+   ProjectParser warm(options);
+   ProjectParser fresh;
+   for (const std::string &path : paths) {
+      warm.addFile(path);
+      fresh.addFile(path);
+   }
+   ASSERT_TRUE(warm.parseAll());
+   ASSERT_TRUE(fresh.parseAll());
+   ASSERT_EQ(warm.getNumCachedFiles(), sources.size() - 1);
+   ASSERT_EQ(cache.getNumHits(), sources.size() - 1);
+   /// a warm run must not be told apart from a parse from scratch
+   ASSERT_EQ(print_diagnostics(warm), print_diagnostics(fresh));
+   ASSERT_EQ(print_diagnostics(warm), coldDiagnostics);
+   ASSERT_EQ(warm.getIndex().getDecls().size(), fresh.getIndex().getDecls().size());
+   for (std::size_t i = 0; i < fresh.getIndex().getDecls().size(); ++i) {
+      expect_same_decl(warm.getIndex().getDecls()[i], fresh.getIndex().getDecls()[i]);
+   }
+   ASSERT_NE(warm.getIndex().lookupFunction("helper2"), nullptr);
+}
+
+TEST_F(ModuleSummaryTest, testDamagedSummary)
+{
+   {
+      std::error_code errorCode;
+      RawFdOutStream out(m_summaryPath, errorCode, polar::fs::F_None);
+      out << "definitely not a summary";
+   }
+   auto readerOrError = ModuleSummaryReader::open(m_summaryPath);
+   ASSERT_FALSE(static_cast<bool>(readerOrError));
+   polar::utils::consume_error(readerOrError.takeError());
+
+   ModuleSummaryWriter writer;
+   writer.addFile("a.php", 1, {}, {});
+   ASSERT_FALSE(static_cast<bool>(writer.writeToFile(m_summaryPath)));
+   std::unique_ptr<MemoryBuffer> buffer = std::move(*MemoryBuffer::getFile(m_summaryPath));
+   /// cut off in the middle of the tables
+   std::unique_ptr<MemoryBuffer> truncated = MemoryBuffer::getMemBufferCopy(
+            buffer->getBuffer().substr(0, buffer->getBufferSize() / 2));
+   readerOrError = ModuleSummaryReader::create(std::move(truncated));
+   ASSERT_FALSE(static_cast<bool>(readerOrError));
+   polar::utils::consume_error(readerOrError.takeError());
+
+   /// the cache treats it like no summary at all
+   {
+      std::error_code errorCode;
+      RawFdOutStream out(m_summaryPath, errorCode, polar::fs::F_None);
+      out << buffer->getBuffer().substr(0, buffer->getBufferSize() / 2);
+   }
+   ModuleSummaryCache cache(m_summaryPath);
+   ASSERT_EQ(cache.getPreviousSummary(), nullptr);
+   std::vector<IndexedDecl> decls;
+   std::vector<ProjectDiagnostic> diagnostics;
+   ASSERT_FALSE(cache.lookup("a.php", 1, 0, decls, diagnostics));
+}
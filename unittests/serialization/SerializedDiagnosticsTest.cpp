@@ -0,0 +1,232 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/serialization/SerializedDiagnosticConsumer.h"
+#include "polarphp/serialization/SerializedDiagnostics.h"
+#include "polarphp/ast/DiagnosticEngine.h"
+#include "polarphp/ast/DiagnosticsCommon.h"
+#include "polarphp/basic/adt/SmallString.h"
+#include "polarphp/parser/SourceMgr.h"
+#include "polarphp/utils/FileSystem.h"
+#include "polarphp/utils/MemoryBuffer.h"
+#include "polarphp/utils/RawOutStream.h"
+
+#include <string>
+#include <vector>
+
+using polar::ast::Diagnostic;
+using polar::ast::DiagnosticEngine;
+using polar::basic::SmallString;
+using polar::basic::StringRef;
+using polar::parser::CharSourceRange;
+using polar::parser::SourceManager;
+using polar::serialization::SerializedDiagnostic;
+using polar::serialization::SerializedDiagnosticConsumer;
+using polar::serialization::SerializedDiagnosticKind;
+using polar::serialization::SerializedDiagnosticsReader;
+using polar::serialization::SerializedDiagnosticsWriter;
+using polar::serialization::SerializedFixIt;
+using polar::serialization::SerializedSourceRange;
+using polar::utils::MemoryBuffer;
+using polar::utils::RawFdOutStream;
+
+namespace diag = polar::ast::diag;
+
+namespace {
+
+SerializedSourceRange make_range(unsigned startLine, unsigned startColumn,
+                                 unsigned endLine, unsigned endColumn)
+{
+   SerializedSourceRange range;
+   range.startLine = startLine;
+   range.startColumn = startColumn;
+   range.endLine = endLine;
+   range.endColumn = endColumn;
+   return range;
+}
+
+void expect_same_range(const SerializedSourceRange &left, const SerializedSourceRange &right)
+{
+   EXPECT_EQ(left.startLine, right.startLine);
+   EXPECT_EQ(left.startColumn, right.startColumn);
+   EXPECT_EQ(left.endLine, right.endLine);
+   EXPECT_EQ(left.endColumn, right.endColumn);
+}
+
+void expect_same_diagnostic(const SerializedDiagnostic &left, const SerializedDiagnostic &right)
+{
+   EXPECT_EQ(left.kind, right.kind);
+   EXPECT_EQ(left.id, right.id);
+   EXPECT_EQ(left.parent, right.parent);
+   EXPECT_EQ(left.file, right.file);
+   EXPECT_EQ(left.line, right.line);
+   EXPECT_EQ(left.column, right.column);
+   EXPECT_EQ(left.message, right.message);
+   ASSERT_EQ(left.ranges.size(), right.ranges.size());
+   for (std::size_t index = 0; index < left.ranges.size(); ++index) {
+      expect_same_range(left.ranges[index], right.ranges[index]);
+   }
+   ASSERT_EQ(left.fixIts.size(), right.fixIts.size());
+   for (std::size_t index = 0; index < left.fixIts.size(); ++index) {
+      expect_same_range(left.fixIts[index].range, right.fixIts[index].range);
+      EXPECT_EQ(left.fixIts[index].text, right.fixIts[index].text);
+   }
+}
+
+class SerializedDiagnosticsTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      ASSERT_FALSE(polar::fs::create_unique_directory("serialized-diagnostics-test", m_directory));
+      m_diagnosticsPath = (m_directory + "/project.dia").getStr();
+   }
+
+   void TearDown() override
+   {
+      polar::fs::remove_directories(m_directory);
+   }
+
+   std::unique_ptr<SerializedDiagnosticsReader> openDiagnostics()
+   {
+      auto readerOrError = SerializedDiagnosticsReader::open(m_diagnosticsPath);
+      if (!readerOrError) {
+         polar::utils::consume_error(readerOrError.takeError());
+         return nullptr;
+      }
+      return std::move(*readerOrError);
+   }
+
+   SmallString<128> m_directory;
+   std::string m_diagnosticsPath;
+};
+
+} // anonymous namespace
+
+TEST_F(SerializedDiagnosticsTest, testWriterRoundTrip)
+{
+   std::vector<SerializedDiagnostic> diagnostics(3);
+   diagnostics[0].kind = SerializedDiagnosticKind::Error;
+   diagnostics[0].id = 7;
+   diagnostics[0].file = "src/a.php";
+   diagnostics[0].line = 3;
+   diagnostics[0].column = 5;
+   diagnostics[0].message = "something went wrong";
+   diagnostics[0].ranges.push_back(make_range(3, 5, 3, 9));
+   diagnostics[0].fixIts.push_back({make_range(3, 5, 3, 9), "$fixed"});
+   diagnostics[1].kind = SerializedDiagnosticKind::Note;
+   diagnostics[1].id = 8;
+   diagnostics[1].parent = 0;
+   diagnostics[1].file = "src/a.php";
+   diagnostics[1].line = 1;
+   diagnostics[1].column = 1;
+   diagnostics[1].message = "declared here";
+   /// no location at all, and the same strings again from the pool
+   diagnostics[2].kind = SerializedDiagnosticKind::Warning;
+   diagnostics[2].id = 9;
+   diagnostics[2].message = "something went wrong";
+   diagnostics[2].fixIts.push_back({make_range(1, 1, 1, 1), ""});
+   diagnostics[2].fixIts.push_back({make_range(2, 1, 2, 4), "$fixed"});
+
+   SerializedDiagnosticsWriter writer;
+   for (unsigned index = 0; index < diagnostics.size(); ++index) {
+      ASSERT_EQ(writer.addDiagnostic(diagnostics[index]), index);
+   }
+   ASSERT_FALSE(static_cast<bool>(writer.writeToFile(m_diagnosticsPath)));
+
+   std::unique_ptr<SerializedDiagnosticsReader> reader = openDiagnostics();
+   ASSERT_NE(reader, nullptr);
+   ASSERT_EQ(reader->getNumDiagnostics(), diagnostics.size());
+   for (unsigned index = 0; index < diagnostics.size(); ++index) {
+      ASSERT_EQ(reader->getKind(index), diagnostics[index].kind);
+      expect_same_diagnostic(reader->getDiagnostic(index), diagnostics[index]);
+   }
+}
+
+TEST_F(SerializedDiagnosticsTest, testConsumerWritesBatchedDiagnostics)
+{
+   SourceManager sourceMgr;
+   unsigned bufferId = sourceMgr.addMemBufferCopy("<?php\necho $a;\necho $b;\n", "test.php");
+   DiagnosticEngine diags(sourceMgr);
+   SerializedDiagnosticConsumer consumer(m_diagnosticsPath);
+   diags.addConsumer(consumer);
+   diags.setBatchDiagnostics();
+
+   Diagnostic withFixIt(diag::not_implemented, StringRef("echo"));
+   withFixIt.addRange(CharSourceRange(sourceMgr.getLocForOffset(bufferId, 11), 2));
+   withFixIt.addFixIt(Diagnostic::FixIt(
+                         CharSourceRange(sourceMgr.getLocForOffset(bufferId, 11), 2), "$c"));
+   diags.diagnose(sourceMgr.getLocForOffset(bufferId, 11), withFixIt);
+   diags.diagnose(sourceMgr.getLocForOffset(bufferId, 6), diag::brace_stmt_suggest_do);
+   /// dropped as a duplicate together with its note
+   diags.diagnose(sourceMgr.getLocForOffset(bufferId, 11), withFixIt);
+   diags.diagnose(sourceMgr.getLocForOffset(bufferId, 6), diag::brace_stmt_suggest_do);
+   diags.diagnose(sourceMgr.getLocForOffset(bufferId, 20), diag::error_opening_output,
+                  "out.txt", "denied");
+   diags.diagnose(sourceMgr.getLocForOffset(bufferId, 20), diag::while_parsing_as_left_angle_bracket);
+   /// nothing is written before the engine finishes
+   ASSERT_FALSE(polar::fs::exists(m_diagnosticsPath));
+   ASSERT_FALSE(diags.finishProcessing());
+
+   std::unique_ptr<SerializedDiagnosticsReader> reader = openDiagnostics();
+   ASSERT_NE(reader, nullptr);
+   ASSERT_EQ(reader->getNumDiagnostics(), 4u);
+
+   SerializedDiagnostic first = reader->getDiagnostic(0);
+   ASSERT_EQ(first.kind, SerializedDiagnosticKind::Error);
+   ASSERT_EQ(first.id, static_cast<uint32_t>(diag::not_implemented.id));
+   ASSERT_FALSE(first.parent.has_value());
+   ASSERT_EQ(first.file, "test.php");
+   ASSERT_EQ(first.line, 2u);
+   ASSERT_EQ(first.column, 6u);
+   ASSERT_EQ(first.message, "INTERNAL ERROR: feature not implemented: echo");
+   ASSERT_EQ(first.ranges.size(), 1u);
+   expect_same_range(first.ranges[0], make_range(2, 6, 2, 8));
+   ASSERT_EQ(first.fixIts.size(), 1u);
+   expect_same_range(first.fixIts[0].range, make_range(2, 6, 2, 8));
+   ASSERT_EQ(first.fixIts[0].text, "$c");
+
+   SerializedDiagnostic note = reader->getDiagnostic(1);
+   ASSERT_EQ(note.kind, SerializedDiagnosticKind::Note);
+   ASSERT_EQ(note.parent, std::optional<unsigned>(0));
+   ASSERT_EQ(note.line, 2u);
+   ASSERT_EQ(note.column, 1u);
+   ASSERT_EQ(note.message, "did you mean to use a 'do' statement?");
+
+   SerializedDiagnostic second = reader->getDiagnostic(2);
+   ASSERT_EQ(second.message, "error opening 'out.txt' for output: denied");
+   ASSERT_EQ(second.line, 3u);
+   ASSERT_EQ(second.column, 6u);
+   ASSERT_EQ(reader->getDiagnostic(3).parent, std::optional<unsigned>(2));
+}
+
+TEST_F(SerializedDiagnosticsTest, testDamagedFile)
+{
+   {
+      std::error_code errorCode;
+      RawFdOutStream out(m_diagnosticsPath, errorCode, polar::fs::F_None);
+      out << "definitely not diagnostics";
+   }
+   ASSERT_EQ(openDiagnostics(), nullptr);
+
+   SerializedDiagnosticsWriter writer;
+   SerializedDiagnostic diagnostic;
+   diagnostic.message = "cut off";
+   writer.addDiagnostic(diagnostic);
+   ASSERT_FALSE(static_cast<bool>(writer.writeToFile(m_diagnosticsPath)));
+   std::unique_ptr<MemoryBuffer> buffer = std::move(*MemoryBuffer::getFile(m_diagnosticsPath));
+   /// cut off in the middle of the string table
+   auto readerOrError = SerializedDiagnosticsReader::create(MemoryBuffer::getMemBufferCopy(
+            buffer->getBuffer().substr(0, buffer->getBufferSize() - 3)));
+   ASSERT_FALSE(static_cast<bool>(readerOrError));
+   polar::utils::consume_error(readerOrError.takeError());
+}
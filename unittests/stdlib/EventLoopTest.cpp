@@ -0,0 +1,173 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "php/kernel/io/EventLoop.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using php::kernel::io::EventLoop;
+
+namespace {
+
+class EventLoopTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      char pathTemplate[] = "/tmp/polar-event-loop-XXXXXX";
+      int fd = ::mkstemp(pathTemplate);
+      ASSERT_GE(fd, 0);
+      ::close(fd);
+      m_path = pathTemplate;
+   }
+
+   void TearDown() override
+   {
+      std::remove(m_path.c_str());
+   }
+
+   std::string m_path;
+};
+
+/// stands in for a captured zval, counts the copies and destructions made
+/// on any other thread than the loop's
+struct ThreadProbe
+{
+   ThreadProbe(std::thread::id owner, std::atomic<int> &foreign)
+      : owner(owner),
+        foreign(foreign)
+   {}
+
+   ThreadProbe(const ThreadProbe &other)
+      : owner(other.owner),
+        foreign(other.foreign)
+   {
+      check();
+   }
+
+   ~ThreadProbe()
+   {
+      check();
+   }
+
+   void check() const
+   {
+      if (std::this_thread::get_id() != owner) {
+         ++foreign;
+      }
+   }
+
+   std::thread::id owner;
+   std::atomic<int> &foreign;
+};
+
+} // anonymous namespace
+
+TEST_F(EventLoopTest, testRunReturnsAfterFileRead)
+{
+   EventLoop loop;
+   if (!loop.isValid()) {
+      return;
+   }
+   FILE *file = std::fopen(m_path.c_str(), "wb");
+   ASSERT_NE(file, nullptr);
+   std::fputs("polarphp", file);
+   std::fclose(file);
+   /// the only thing keeping the loop alive is the file operation, run()
+   /// must notice the completion and return instead of waiting forever
+   for (int i = 0; i < 200; ++i) {
+      bool called = false;
+      std::string content;
+      loop.readFile(m_path, [&](bool ok, std::string &&data, int errorCode) {
+         called = true;
+         ASSERT_TRUE(ok);
+         ASSERT_EQ(errorCode, 0);
+         content = std::move(data);
+      });
+      ASSERT_TRUE(loop.isAlive());
+      loop.run();
+      ASSERT_TRUE(called);
+      ASSERT_EQ(content, "polarphp");
+      ASSERT_FALSE(loop.isAlive());
+   }
+}
+
+TEST_F(EventLoopTest, testWriteThenRead)
+{
+   EventLoop loop;
+   if (!loop.isValid()) {
+      return;
+   }
+   std::string content;
+   int completions = 0;
+   loop.writeFile(m_path, "abc", false, [&](bool ok, std::string &&, int) {
+      ASSERT_TRUE(ok);
+      ++completions;
+      loop.writeFile(m_path, "def", true, [&](bool ok, std::string &&, int) {
+         ASSERT_TRUE(ok);
+         ++completions;
+         loop.readFile(m_path, [&](bool ok, std::string &&data, int) {
+            ASSERT_TRUE(ok);
+            ++completions;
+            content = std::move(data);
+         });
+      });
+   });
+   loop.run();
+   ASSERT_EQ(completions, 3);
+   ASSERT_EQ(content, "abcdef");
+   ASSERT_FALSE(loop.isAlive());
+}
+
+TEST_F(EventLoopTest, testMissingFile)
+{
+   EventLoop loop;
+   if (!loop.isValid()) {
+      return;
+   }
+   bool failed = false;
+   loop.readFile(m_path + ".missing", [&](bool ok, std::string &&, int errorCode) {
+      failed = !ok && errorCode != 0;
+   });
+   loop.run();
+   ASSERT_TRUE(failed);
+}
+
+TEST_F(EventLoopTest, testCallbacksStayOnLoopThread)
+{
+   EventLoop loop;
+   if (!loop.isValid()) {
+      return;
+   }
+   std::atomic<int> foreign(0);
+   int completions = 0;
+   ThreadProbe probe(std::this_thread::get_id(), foreign);
+   for (int i = 0; i < 50; ++i) {
+      loop.readFile(m_path, [probe, &completions](bool, std::string &&, int) {
+         probe.check();
+         ++completions;
+      });
+      loop.writeFile(m_path, "x", true, [probe, &completions](bool, std::string &&, int) {
+         probe.check();
+         ++completions;
+      });
+   }
+   loop.run();
+   ASSERT_EQ(completions, 100);
+   ASSERT_EQ(foreign.load(), 0);
+}
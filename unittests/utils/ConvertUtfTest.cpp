@@ -136,6 +136,51 @@ TEST(ConvertUtfTest, testConvertWideToUTF8)
    EXPECT_EQ(expected, result);
 }
 
+TEST(ConvertUtfTest, testFindInvalidUTF8)
+{
+   // every ill-formed sequence at every offset around the block boundaries
+   static const char *const invalid[] = {
+      "\x80", "\xbf", "\xc0\xaf", "\xc1\xbf", "\xc3", "\xe0\x80\xaf",
+      "\xe2\x82", "\xed\xa0\x80", "\xf0\x8f\xbf\xbf", "\xf0\x9f\x98",
+      "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xfe", "\xff"
+   };
+   std::string valid;
+   while (valid.size() < 100) {
+      valid += "ascii \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\xf4\x8f\xbf\xbf";
+   }
+   const utils::Utf8 *begin = reinterpret_cast<const utils::Utf8 *>(valid.data());
+   EXPECT_TRUE(utils::is_valid_utf8(valid));
+   EXPECT_EQ(begin + valid.size(), utils::find_invalid_utf8(begin, begin + valid.size()));
+   for (const char *bad : invalid) {
+      for (size_t offset = 0; offset <= 70; ++offset) {
+         // the prefix is ASCII, the first error is where the bad bytes start
+         std::string prefix(offset, 'x');
+         std::string str = prefix + bad + valid;
+         const utils::Utf8 *source = reinterpret_cast<const utils::Utf8 *>(str.data());
+         const utils::Utf8 *sourceEnd = source + str.size();
+         EXPECT_FALSE(utils::is_valid_utf8(str));
+         EXPECT_EQ(source + offset, utils::find_invalid_utf8(source, sourceEnd));
+         const utils::Utf8 *pos = source;
+         EXPECT_FALSE(utils::is_legal_utf8_string(&pos, sourceEnd));
+         EXPECT_EQ(source + offset, pos);
+      }
+   }
+}
+
+TEST(ConvertUtfTest, testWidenASCIIPrefix)
+{
+   std::string str(100, 'a');
+   str += "\xc3\xa9tail";
+   const utils::Utf8 *source = reinterpret_cast<const utils::Utf8 *>(str.data());
+   std::vector<utils::Utf16> utf16(str.size());
+   std::vector<utils::Utf32> utf32(str.size());
+   EXPECT_EQ(100u, utils::widen_ascii_prefix(source, str.size(), utf16.data()));
+   EXPECT_EQ(100u, utils::widen_ascii_prefix(source, str.size(), utf32.data()));
+   EXPECT_EQ(40u, utils::widen_ascii_prefix(source, 40, utf16.data()));
+   EXPECT_EQ(u'a', utf16[99]);
+   EXPECT_EQ(U'a', utf32[99]);
+}
+
 namespace {
 
 
@@ -0,0 +1,96 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "polarphp/utils/LineTable.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace polar;
+using namespace polar::utils;
+using namespace polar::basic;
+
+namespace {
+
+std::pair<unsigned, unsigned> naive_line_and_column(StringRef text, size_t offset)
+{
+   unsigned line = 1;
+   size_t lineStart = 0;
+   for (size_t i = 0; i < offset; ++i) {
+      if (text[i] == '\n') {
+         ++line;
+         lineStart = i + 1;
+      }
+   }
+   return std::make_pair(line, static_cast<unsigned>(offset - lineStart + 1));
+}
+
+TEST(LineTableTest, testEmpty)
+{
+   LineTable table{StringRef()};
+   EXPECT_EQ(1U, table.getNumLines());
+   EXPECT_EQ(std::make_pair(1U, 1U), table.getLineAndColumn(0));
+}
+
+TEST(LineTableTest, testLineEndings)
+{
+   StringRef text("aaa\nbb\r\n\ncc\rdd\n");
+   LineTable table(text);
+   EXPECT_EQ(5U, table.getNumLines());
+   EXPECT_EQ(0U, table.getLineStart(1));
+   EXPECT_EQ(4U, table.getLineStart(2));
+   EXPECT_EQ(8U, table.getLineStart(3));
+   EXPECT_EQ(9U, table.getLineStart(4));
+   EXPECT_EQ(15U, table.getLineStart(5));
+   /// the newline belongs to the line it ends
+   EXPECT_EQ(std::make_pair(1U, 4U), table.getLineAndColumn(3));
+   /// a lone \r does not end a line
+   EXPECT_EQ(std::make_pair(4U, 4U), table.getLineAndColumn(12));
+   EXPECT_EQ(std::make_pair(5U, 1U), table.getLineAndColumn(text.size()));
+}
+
+TEST(LineTableTest, testMatchesNaiveScan)
+{
+   std::string text;
+   for (unsigned i = 0; i < 5000; ++i) {
+      text += (i * 7919) % 13 == 0 ? '\n' : static_cast<char>('a' + i % 26);
+      if (i % 997 == 0) {
+         text.append(300, 'x');
+      }
+   }
+   LineTable table{StringRef(text)};
+   for (size_t offset = 0; offset <= text.size(); ++offset) {
+      ASSERT_EQ(naive_line_and_column(text, offset), table.getLineAndColumn(offset));
+   }
+}
+
+TEST(LineTableTest, testPiecewiseScan)
+{
+   std::string text;
+   for (unsigned i = 0; i < 2000; ++i) {
+      text += i % 11 == 0 ? '\n' : 'z';
+   }
+   LineTable whole{StringRef(text)};
+   LineTable pieces;
+   for (size_t end = 0; end < text.size(); end += 37) {
+      pieces.scanTo(text.data(), end);
+      /// going back is a no-op
+      pieces.scanTo(text.data(), end / 2);
+   }
+   EXPECT_FALSE(pieces.isFinished());
+   pieces.finish(text);
+   ASSERT_EQ(whole.getNumLines(), pieces.getNumLines());
+   for (unsigned line = 1; line <= whole.getNumLines(); ++line) {
+      EXPECT_EQ(whole.getLineStart(line), pieces.getLineStart(line));
+   }
+}
+
+} // anonymous namespace
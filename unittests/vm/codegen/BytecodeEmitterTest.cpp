@@ -0,0 +1,258 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/codegen/BytecodeEmitter.h"
+
+#include <string>
+#include <vector>
+
+using polar::codegen::BytecodeEmitter;
+using polar::codegen::Label;
+using polar::codegen::Operand;
+using polar::codegen::OperandKind;
+
+namespace {
+
+/// what zend_compile.c makes of the same code, already through pass_two
+zend_op_array *compile_legacy(const char *code)
+{
+   zval source;
+   ZVAL_STRING(&source, code);
+   zend_op_array *opArray = zend_compile_string(&source, const_cast<char *>("emitter test"));
+   zval_ptr_dtor(&source);
+   return opArray;
+}
+
+/// runs and frees \p opArray, the returned value goes to \p result
+void execute_op_array(zend_op_array *opArray, zval *result)
+{
+   ZVAL_UNDEF(result);
+   zend_execute(opArray, result);
+   destroy_op_array(opArray);
+   efree(opArray);
+}
+
+std::vector<zend_uchar> get_opcodes(const zend_op_array *opArray)
+{
+   std::vector<zend_uchar> opcodes;
+   for (uint32_t opnum = 0; opnum < opArray->last; ++opnum) {
+      opcodes.push_back(opArray->opcodes[opnum].opcode);
+   }
+   return opcodes;
+}
+
+std::string get_string_result(zval *result)
+{
+   zend_string *text = zval_get_string(result);
+   std::string value(ZSTR_VAL(text), ZSTR_LEN(text));
+   zend_string_release(text);
+   zval_ptr_dtor(result);
+   return value;
+}
+
+/// $a = 5; $b = "x"; return ($a + 1) . strtoupper($b);
+zend_op_array *emit_concat_with_call()
+{
+   BytecodeEmitter emitter;
+   Operand a = emitter.getVariable("a");
+   Operand b = emitter.getVariable("b");
+   emitter.emitFree(emitter.emitAssign(a, emitter.emitLong(5)));
+   emitter.emitFree(emitter.emitAssign(b, emitter.emitString("x")));
+   Operand sum = emitter.emitBinaryOp(ZEND_ADD, a, emitter.emitLong(1));
+   emitter.beginFunctionCall("strtoupper", true);
+   emitter.emitSendArgument(b);
+   Operand upper = emitter.endFunctionCall();
+   emitter.emitReturn(emitter.emitBinaryOp(ZEND_CONCAT, sum, upper));
+   return emitter.finish();
+}
+
+const char *sg_concatWithCall = "$a = 5; $b = 'x'; return ($a + 1) . strtoupper($b);";
+
+} // anonymous namespace
+
+TEST(BytecodeEmitterTest, testSameOpcodesAsTheCompiler)
+{
+   zend_op_array *emitted = emit_concat_with_call();
+   zend_op_array *legacy = compile_legacy(sg_concatWithCall);
+   ASSERT_NE(legacy, nullptr);
+   ASSERT_EQ(get_opcodes(emitted), get_opcodes(legacy));
+   ASSERT_EQ(emitted->last_var, legacy->last_var);
+   for (uint32_t opnum = 0; opnum < emitted->last; ++opnum) {
+      const zend_op &left = emitted->opcodes[opnum];
+      const zend_op &right = legacy->opcodes[opnum];
+      EXPECT_EQ(left.op1_type, right.op1_type) << "opline " << opnum;
+      EXPECT_EQ(left.op2_type, right.op2_type) << "opline " << opnum;
+      EXPECT_EQ(left.result_type, right.result_type) << "opline " << opnum;
+      EXPECT_EQ(left.handler, right.handler) << "opline " << opnum;
+   }
+   zval emittedResult;
+   zval legacyResult;
+   execute_op_array(emitted, &emittedResult);
+   execute_op_array(legacy, &legacyResult);
+   ASSERT_EQ(get_string_result(&emittedResult), "6X");
+   ASSERT_EQ(get_string_result(&legacyResult), "6X");
+}
+
+TEST(BytecodeEmitterTest, testTemporariesAreReused)
+{
+   /// return ($a + 1) + ($a + 2) + ($a + 3) + ($a + 4);
+   BytecodeEmitter emitter;
+   Operand a = emitter.getVariable("a");
+   emitter.emitFree(emitter.emitAssign(a, emitter.emitLong(10)));
+   Operand sum = emitter.emitBinaryOp(ZEND_ADD, a, emitter.emitLong(1));
+   for (zend_long value = 2; value <= 4; ++value) {
+      Operand term = emitter.emitBinaryOp(ZEND_ADD, a, emitter.emitLong(value));
+      sum = emitter.emitBinaryOp(ZEND_ADD, sum, term);
+   }
+   emitter.emitReturn(sum);
+   zend_op_array *emitted = emitter.finish();
+   zend_op_array *legacy = compile_legacy(
+            "$a = 10; return ($a + 1) + ($a + 2) + ($a + 3) + ($a + 4);");
+   ASSERT_NE(legacy, nullptr);
+   ASSERT_EQ(get_opcodes(emitted), get_opcodes(legacy));
+   /// at most two partial sums and the new one are alive at a time, the
+   /// compiler gives every value a slot of its own
+   ASSERT_EQ(emitted->T, 3u);
+   ASSERT_EQ(emitter.getNumTemporaries(), 3u);
+   ASSERT_GT(legacy->T, emitted->T);
+   /// the result of an instruction never shares a slot with its inputs
+   for (uint32_t opnum = 0; opnum < emitted->last; ++opnum) {
+      const zend_op &opline = emitted->opcodes[opnum];
+      if (opline.result_type != IS_TMP_VAR) {
+         continue;
+      }
+      if (opline.op1_type & (IS_TMP_VAR | IS_VAR)) {
+         EXPECT_NE(opline.op1.var, opline.result.var) << "opline " << opnum;
+      }
+      if (opline.op2_type & (IS_TMP_VAR | IS_VAR)) {
+         EXPECT_NE(opline.op2.var, opline.result.var) << "opline " << opnum;
+      }
+   }
+   zval emittedResult;
+   zval legacyResult;
+   execute_op_array(emitted, &emittedResult);
+   execute_op_array(legacy, &legacyResult);
+   ASSERT_EQ(Z_TYPE(emittedResult), IS_LONG);
+   ASSERT_EQ(Z_LVAL(emittedResult), 50);
+   ASSERT_EQ(Z_LVAL(legacyResult), 50);
+}
+
+TEST(BytecodeEmitterTest, testConstantFolding)
+{
+   {
+      /// return 1 + 2 * 3;
+      BytecodeEmitter emitter;
+      Operand product = emitter.emitBinaryOp(ZEND_MUL, emitter.emitLong(2), emitter.emitLong(3));
+      ASSERT_TRUE(product.isConst());
+      Operand sum = emitter.emitBinaryOp(ZEND_ADD, emitter.emitLong(1), product);
+      ASSERT_TRUE(sum.isConst());
+      emitter.emitReturn(sum);
+      zend_op_array *emitted = emitter.finish();
+      zend_op_array *legacy = compile_legacy("return 1 + 2 * 3;");
+      ASSERT_EQ(get_opcodes(emitted), get_opcodes(legacy));
+      /// the folded operands leave no literal behind
+      ASSERT_EQ(emitted->last_literal, legacy->last_literal);
+      ASSERT_EQ(Z_LVAL_P(RT_CONSTANT(&emitted->opcodes[0], emitted->opcodes[0].op1)), 7);
+      ASSERT_EQ(emitted->T, 0u);
+      zval result;
+      execute_op_array(emitted, &result);
+      ASSERT_EQ(Z_LVAL(result), 7);
+      destroy_op_array(legacy);
+      efree(legacy);
+   }
+   {
+      /// return "a" . "b" . E_ALL;
+      BytecodeEmitter emitter;
+      Operand text = emitter.emitBinaryOp(ZEND_CONCAT, emitter.emitString("a"),
+                                          emitter.emitString("b"));
+      Operand all = emitter.emitFetchConstant("E_ALL", true);
+      ASSERT_TRUE(all.isConst());
+      emitter.emitReturn(emitter.emitBinaryOp(ZEND_CONCAT, text, all));
+      zend_op_array *emitted = emitter.finish();
+      zend_op_array *legacy = compile_legacy("return 'a' . 'b' . \\E_ALL;");
+      ASSERT_EQ(get_opcodes(emitted), get_opcodes(legacy));
+      ASSERT_EQ(emitted->last_literal, legacy->last_literal);
+      zval emittedResult;
+      zval legacyResult;
+      execute_op_array(emitted, &emittedResult);
+      execute_op_array(legacy, &legacyResult);
+      ASSERT_EQ(get_string_result(&emittedResult), get_string_result(&legacyResult));
+   }
+   {
+      /// the compiler leaves a division by zero to the runtime
+      BytecodeEmitter emitter;
+      Operand quotient = emitter.emitBinaryOp(ZEND_DIV, emitter.emitLong(1), emitter.emitLong(0));
+      ASSERT_EQ(quotient.kind, OperandKind::Tmp);
+      emitter.emitFree(quotient);
+      zend_op_array *emitted = emitter.finish();
+      zend_op_array *legacy = compile_legacy("1 / 0;");
+      ASSERT_EQ(get_opcodes(emitted), get_opcodes(legacy));
+      destroy_op_array(emitted);
+      efree(emitted);
+      destroy_op_array(legacy);
+      efree(legacy);
+   }
+}
+
+TEST(BytecodeEmitterTest, testConstantConditions)
+{
+   /// if (true) { return 1; } return 2;
+   BytecodeEmitter emitter;
+   Label otherwise = emitter.createLabel();
+   emitter.emitJumpIfFalse(emitter.emitBool(true), otherwise);
+   emitter.emitReturn(emitter.emitLong(1));
+   emitter.bindLabel(otherwise);
+   emitter.emitReturn(emitter.emitLong(2));
+   zend_op_array *emitted = emitter.finish();
+   /// no jump is left, and the literal of the condition is never used
+   ASSERT_EQ(get_opcodes(emitted), std::vector<zend_uchar>({ZEND_RETURN, ZEND_RETURN, ZEND_RETURN}));
+   ASSERT_EQ(emitted->last_literal, 3);
+   zval result;
+   execute_op_array(emitted, &result);
+   ASSERT_EQ(Z_LVAL(result), 1);
+}
+
+TEST(BytecodeEmitterTest, testLiveRangesMatchTheCompiler)
+{
+   zend_op_array *emitted = emit_concat_with_call();
+   zend_op_array *legacy = compile_legacy(sg_concatWithCall);
+   ASSERT_NE(legacy, nullptr);
+   /// the sum is alive across the call, which frees it when it throws
+   ASSERT_EQ(emitted->last_live_range, 1);
+   ASSERT_EQ(legacy->last_live_range, 1);
+   const zend_live_range &emittedRange = emitted->live_range[0];
+   const zend_live_range &legacyRange = legacy->live_range[0];
+   ASSERT_EQ(emittedRange.start, legacyRange.start);
+   ASSERT_EQ(emittedRange.end, legacyRange.end);
+   ASSERT_EQ(emittedRange.var & ZEND_LIVE_MASK, legacyRange.var & ZEND_LIVE_MASK);
+   /// pass_two turned both into frame offsets of the concat's first operand
+   const zend_op &emittedUse = emitted->opcodes[emittedRange.end];
+   const zend_op &legacyUse = legacy->opcodes[legacyRange.end];
+   ASSERT_EQ(emittedUse.opcode, ZEND_CONCAT);
+   ASSERT_EQ(emittedRange.var & ~ZEND_LIVE_MASK, emittedUse.op1.var);
+   ASSERT_EQ(legacyRange.var & ~ZEND_LIVE_MASK, legacyUse.op1.var);
+   destroy_op_array(emitted);
+   efree(emitted);
+   destroy_op_array(legacy);
+   efree(legacy);
+
+   /// a value read by the next instruction needs no range
+   BytecodeEmitter emitter;
+   Operand a = emitter.getVariable("a");
+   emitter.emitReturn(emitter.emitBinaryOp(ZEND_MUL,
+                                           emitter.emitBinaryOp(ZEND_ADD, a, emitter.emitLong(1)),
+                                           emitter.emitLong(2)));
+   zend_op_array *simple = emitter.finish();
+   ASSERT_EQ(simple->last_live_range, 0);
+   destroy_op_array(simple);
+   efree(simple);
+}
@@ -0,0 +1,297 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/vm/IteratorBridge.h"
+#include "polarphp/vm/protocol/AbstractIterator.h"
+#include "polarphp/vm/ds/Variant.h"
+#include "polarphp/vm/zend/zend_interfaces.h"
+
+#include <string>
+
+using polar::vmapi::AbstractIterator;
+using polar::vmapi::IteratorBatch;
+using polar::vmapi::IteratorBridge;
+using polar::vmapi::Variant;
+
+namespace {
+
+/// walks 0 .. size - 1, the value of n is "value n". fetch() hands out at
+/// most chunk entries at a time, or declines when batched is false
+class RangeIterator : public AbstractIterator
+{
+public:
+   RangeIterator(size_t size, size_t chunk, bool batched)
+      : AbstractIterator(nullptr),
+        m_size(size),
+        m_chunk(chunk),
+        m_batched(batched)
+   {}
+
+   bool valid() override
+   {
+      ++m_singleSteps;
+      return m_position < m_size;
+   }
+
+   Variant current() override
+   {
+      return "value " + std::to_string(m_position);
+   }
+
+   Variant key() override
+   {
+      return static_cast<std::int64_t>(m_position);
+   }
+
+   void next() override
+   {
+      ++m_position;
+   }
+
+   void rewind() override
+   {
+      ++m_rewinds;
+      m_position = 0;
+   }
+
+   bool fetch(IteratorBatch &batch) override
+   {
+      if (!m_batched) {
+         return AbstractIterator::fetch(batch);
+      }
+      ++m_fetches;
+      for (; !batch.isFull() && batch.getSize() < m_chunk && m_position < m_size; ++m_position) {
+         batch.append(static_cast<std::int64_t>(m_position), "value " + std::to_string(m_position));
+      }
+      return true;
+   }
+
+   size_t getFetches() const
+   {
+      return m_fetches;
+   }
+
+   size_t getRewinds() const
+   {
+      return m_rewinds;
+   }
+
+   size_t getSingleSteps() const
+   {
+      return m_singleSteps;
+   }
+
+private:
+   size_t m_size;
+   size_t m_chunk;
+   bool m_batched;
+   size_t m_position = 0;
+   size_t m_fetches = 0;
+   size_t m_rewinds = 0;
+   size_t m_singleSteps = 0;
+};
+
+RangeIterator *sg_iterator = nullptr;
+
+/// the same as AbstractClassPrivate::getIterator() without a bound native object
+zend_object_iterator *get_range_iterator(zend_class_entry *, zval *object, int)
+{
+   void *buffer = emalloc(sizeof(IteratorBridge));
+   IteratorBridge *iteratorBridge = new (buffer)IteratorBridge(object, sg_iterator);
+   return iteratorBridge->getZendIterator();
+}
+
+zend_class_entry *get_range_class()
+{
+   static zend_class_entry *rangeClass = nullptr;
+   if (!rangeClass) {
+      zend_class_entry entry;
+      INIT_CLASS_ENTRY(entry, "IteratorBridgeTestRange", nullptr);
+      rangeClass = zend_register_internal_class(&entry);
+      rangeClass->get_iterator = get_range_iterator;
+      zend_class_implements(rangeClass, 1, zend_ce_traversable);
+   }
+   return rangeClass;
+}
+
+/// runs \p code with $range bound to an object iterated by \p iterator and
+/// returns what it left in $log
+std::string run_foreach(RangeIterator &iterator, const char *code)
+{
+   sg_iterator = &iterator;
+   zval range;
+   object_init_ex(&range, get_range_class());
+   zend_hash_str_update(&EG(symbol_table), "range", sizeof("range") - 1, &range);
+   EXPECT_EQ(zend_eval_string(const_cast<char *>(code), nullptr,
+                              const_cast<char *>("iterator bridge test")), SUCCESS);
+   std::string log;
+   zval *value = zend_hash_str_find(&EG(symbol_table), "log", sizeof("log") - 1);
+   if (value) {
+      ZVAL_DEREF(value);
+      log.assign(Z_STRVAL_P(value), Z_STRLEN_P(value));
+   }
+   zend_hash_str_del(&EG(symbol_table), "range", sizeof("range") - 1);
+   zend_hash_str_del(&EG(symbol_table), "log", sizeof("log") - 1);
+   sg_iterator = nullptr;
+   return log;
+}
+
+std::string get_expected_log(size_t first, size_t last)
+{
+   std::string log;
+   for (size_t i = first; i <= last; ++i) {
+      log += std::to_string(i) + "=value " + std::to_string(i) + ",";
+   }
+   return log;
+}
+
+const char *sg_fullLoop = "$log = ''; foreach ($range as $k => $v) { $log .= \"$k=$v,\"; }";
+
+} // anonymous namespace
+
+TEST(IteratorBridgeTest, testBatchEndsMidway)
+{
+   /// 20 entries are a full batch of 16 and one that ends after 4
+   RangeIterator iterator(20, 16, true);
+   ASSERT_EQ(run_foreach(iterator, sg_fullLoop), get_expected_log(0, 19));
+   /// 16, 4 and the empty fetch that ends the loop
+   ASSERT_EQ(iterator.getFetches(), 3u);
+   ASSERT_EQ(iterator.getRewinds(), 1u);
+   ASSERT_EQ(iterator.getSingleSteps(), 0u);
+
+   /// an iterator handing out less than the capacity is asked again
+   RangeIterator smallChunks(7, 3, true);
+   ASSERT_EQ(run_foreach(smallChunks, sg_fullLoop), get_expected_log(0, 6));
+   ASSERT_EQ(smallChunks.getFetches(), 4u);
+
+   RangeIterator empty(0, 16, true);
+   ASSERT_EQ(run_foreach(empty, sg_fullLoop), "");
+   ASSERT_EQ(empty.getFetches(), 1u);
+}
+
+TEST(IteratorBridgeTest, testSameAsSingleSteps)
+{
+   RangeIterator batched(20, 16, true);
+   RangeIterator single(20, 16, false);
+   std::string batchedLog = run_foreach(batched, sg_fullLoop);
+   ASSERT_EQ(batchedLog, run_foreach(single, sg_fullLoop));
+   ASSERT_EQ(single.getFetches(), 0u);
+   ASSERT_EQ(single.getSingleSteps(), 21u);
+}
+
+TEST(IteratorBridgeTest, testEarlyBreak)
+{
+   RangeIterator iterator(20, 16, true);
+   /// the loop leaves in the middle of the first batch, the bridge is
+   /// destroyed with the rest of it still buffered
+   ASSERT_EQ(run_foreach(iterator, "$log = ''; foreach ($range as $k => $v) { $log .= \"$k=$v,\"; "
+                                   "if ($k == 5) { break; } }"), get_expected_log(0, 5));
+   ASSERT_EQ(iterator.getFetches(), 1u);
+   /// the next loop starts over
+   ASSERT_EQ(run_foreach(iterator, sg_fullLoop), get_expected_log(0, 19));
+   ASSERT_EQ(iterator.getRewinds(), 2u);
+}
+
+TEST(IteratorBridgeTest, testRewind)
+{
+   /// foreach rewinds every iterator once, rewinding one in the middle of
+   /// a batch has to drop what is left of it
+   RangeIterator native(20, 16, true);
+   sg_iterator = &native;
+   zval range;
+   object_init_ex(&range, get_range_class());
+   zend_object_iterator *iterator = get_range_iterator(Z_OBJCE(range), &range, 0);
+   const zend_object_iterator_funcs *funcs = iterator->funcs;
+   std::string log;
+   auto step = [&]() {
+      zval key;
+      funcs->get_current_key(iterator, &key);
+      zval *value = funcs->get_current_data(iterator);
+      log += std::to_string(Z_LVAL(key)) + "=" + Z_STRVAL_P(value) + ",";
+      zval_ptr_dtor(&key);
+      funcs->move_forward(iterator);
+   };
+   funcs->rewind(iterator);
+   for (int i = 0; i < 3; ++i) {
+      ASSERT_EQ(funcs->valid(iterator), SUCCESS);
+      step();
+   }
+   ASSERT_EQ(log, get_expected_log(0, 2));
+   funcs->rewind(iterator);
+   log.clear();
+   while (funcs->valid(iterator) == SUCCESS) {
+      step();
+   }
+   ASSERT_EQ(log, get_expected_log(0, 19));
+   ASSERT_EQ(native.getRewinds(), 2u);
+   /// 16 before the rewind, then 16, 4 and the empty one
+   ASSERT_EQ(native.getFetches(), 4u);
+   /// rewinding an exhausted iterator starts over as well
+   funcs->rewind(iterator);
+   ASSERT_EQ(funcs->valid(iterator), SUCCESS);
+   zend_iterator_dtor(iterator);
+   zval_ptr_dtor(&range);
+   sg_iterator = nullptr;
+}
+
+TEST(IteratorBridgeTest, testTakeCurrent)
+{
+   RangeIterator native(3, 16, true);
+   sg_iterator = &native;
+   zval range;
+   object_init_ex(&range, get_range_class());
+   zend_object_iterator *iterator = get_range_iterator(Z_OBJCE(range), &range, 0);
+   const zend_object_iterator_funcs *funcs = iterator->funcs;
+   ASSERT_NE(funcs->take_current, nullptr);
+   funcs->rewind(iterator);
+   ASSERT_EQ(funcs->valid(iterator), SUCCESS);
+   /// the value and the key leave the buffer, the caller holds the only
+   /// reference
+   zval value;
+   zval key;
+   ASSERT_EQ(funcs->take_current(iterator, &value, &key), SUCCESS);
+   ASSERT_EQ(Z_TYPE(value), IS_STRING);
+   ASSERT_EQ(std::string(Z_STRVAL(value)), "value 0");
+   ASSERT_EQ(Z_REFCOUNT(value), 1u);
+   ASSERT_EQ(Z_LVAL(key), 0);
+   zval_ptr_dtor(&value);
+   /// the slot is gone until the iterator moves on
+   ASSERT_EQ(Z_TYPE_P(funcs->get_current_data(iterator)), IS_UNDEF);
+   funcs->move_forward(iterator);
+   ASSERT_EQ(funcs->valid(iterator), SUCCESS);
+   ASSERT_EQ(funcs->take_current(iterator, &value, nullptr), SUCCESS);
+   ASSERT_EQ(std::string(Z_STRVAL(value)), "value 1");
+   zval_ptr_dtor(&value);
+   funcs->move_forward(iterator);
+   funcs->move_forward(iterator);
+   ASSERT_EQ(funcs->valid(iterator), FAILURE);
+   ASSERT_EQ(funcs->take_current(iterator, &value, &key), FAILURE);
+   zend_iterator_dtor(iterator);
+   zval_ptr_dtor(&range);
+   sg_iterator = nullptr;
+}
+
+TEST(IteratorBridgeTest, testForeachByReference)
+{
+   /// the moved value ends up in a new reference of its own, writing
+   /// through it reaches neither the buffer nor the next entry
+   const char *code = "$log = ''; foreach ($range as $k => &$v) { $v .= '!'; "
+                      "$log .= \"$k=$v,\"; } unset($v);";
+   std::string expected;
+   for (size_t i = 0; i < 20; ++i) {
+      expected += std::to_string(i) + "=value " + std::to_string(i) + "!,";
+   }
+   RangeIterator batched(20, 16, true);
+   ASSERT_EQ(run_foreach(batched, code), expected);
+   RangeIterator single(20, 16, false);
+   ASSERT_EQ(run_foreach(single, code), expected);
+}
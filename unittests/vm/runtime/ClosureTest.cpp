@@ -0,0 +1,176 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/ExecEnv.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <initializer_list>
+#include <string>
+
+using polar::runtime::retrieve_global_execenv;
+
+namespace {
+
+/// every test declares its classes in a fresh request
+class ClosureTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   }
+};
+
+/// runs \p code and returns what it returned as a string
+std::string run_code(const char *code)
+{
+   zval source;
+   ZVAL_STRING(&source, code);
+   zend_op_array *opArray = zend_compile_string(&source, const_cast<char *>("closure test"));
+   zval_ptr_dtor(&source);
+   EXPECT_NE(opArray, nullptr);
+   if (!opArray) {
+      return std::string();
+   }
+   zval result;
+   ZVAL_UNDEF(&result);
+   zend_execute(opArray, &result);
+   destroy_op_array(opArray);
+   efree(opArray);
+   zend_string *text = zval_get_string(&result);
+   std::string value(ZSTR_VAL(text), ZSTR_LEN(text));
+   zend_string_release(text);
+   zval_ptr_dtor(&result);
+   return value;
+}
+
+/// the function of the closure in global variable \p name
+const zend_op_array *closure_function(const char *name)
+{
+   zval *value = zend_hash_str_find_ind(&EG(symbol_table), name, strlen(name));
+   EXPECT_NE(value, nullptr);
+   if (!value) {
+      return nullptr;
+   }
+   ZVAL_DEREF(value);
+   EXPECT_EQ(Z_TYPE_P(value), IS_OBJECT);
+   EXPECT_EQ(Z_OBJCE_P(value), zend_ce_closure);
+   return &zend_get_closure_method_def(value)->op_array;
+}
+
+bool has_private_cache(const zend_op_array *func)
+{
+   return func->fn_flags & ZEND_ACC_NO_RT_ARENA;
+}
+
+} // anonymous namespace
+
+TEST_F(ClosureTest, testStaticsPerClosure)
+{
+   ASSERT_EQ(run_code("$make = function () {\n"
+                      "   return function () { static $n = 0; return ++$n; };\n"
+                      "};\n"
+                      "$a = $make();\n"
+                      "$b = $make();"), "");
+   /// closures of one declaration share its table until one writes
+   ASSERT_EQ(closure_function("a")->static_variables, closure_function("b")->static_variables);
+   ASSERT_EQ(run_code("$a(); $a(); $b();\n"
+                      "return $a() . ',' . $b() . ',' . $make()();"), "3,2,1");
+   ASSERT_NE(closure_function("a")->static_variables, closure_function("b")->static_variables);
+   /// a closure made from one that wrote starts from its values
+   ASSERT_EQ(run_code("$c = $a->bindTo(null);\n"
+                      "return $c() . ',' . $a() . ',' . $c();"), "4,4,5");
+}
+
+TEST_F(ClosureTest, testBoundClosuresWithPrivateCache)
+{
+   ASSERT_EQ(run_code("class ClosureTestBox {\n"
+                      "   private $value;\n"
+                      "   public function __construct($value) { $this->value = $value; }\n"
+                      "}\n"
+                      "$read = function () { static $calls = 0; return $this->value . ':' . ++$calls; };\n"
+                      "$first = Closure::bind($read, new ClosureTestBox(1), ClosureTestBox::class);\n"
+                      "$second = $read->bindTo(new ClosureTestBox(2), ClosureTestBox::class);\n"
+                      "$third = Closure::bind($read, new ClosureTestBox(3), ClosureTestBox::class);"), "");
+   const zend_op_array *read = closure_function("read");
+   const zend_op_array *first = closure_function("first");
+   const zend_op_array *second = closure_function("second");
+   const zend_op_array *third = closure_function("third");
+   /// bound to another scope than the declaration's, nothing is allocated
+   /// until the first call
+   for (const zend_op_array *bound : {first, second, third}) {
+      ASSERT_TRUE(has_private_cache(bound));
+      ASSERT_EQ(bound->run_time_cache, nullptr);
+      ASSERT_EQ(bound->static_variables, read->static_variables);
+   }
+   ASSERT_EQ(run_code("return $first() . ' ' . $second() . ' ' . $first() . ' '\n"
+                      "   . $read->call(new ClosureTestBox(4)) . ' ' . $read->call(new ClosureTestBox(5)) . ' '\n"
+                      "   . $third->call(new ClosureTestBox(6)) . ' ' . $third();"),
+             "1:1 2:1 1:2 4:1 5:2 6:1 3:2");
+   ASSERT_NE(first->run_time_cache, nullptr);
+   ASSERT_NE(second->run_time_cache, nullptr);
+   ASSERT_NE(first->run_time_cache, second->run_time_cache);
+   /// Closure::call() in the bound scope fills the closure's own cache
+   ASSERT_NE(third->run_time_cache, nullptr);
+   ASSERT_NE(third->run_time_cache, first->run_time_cache);
+   ASSERT_NE(first->static_variables, second->static_variables);
+   ASSERT_NE(read->static_variables, third->static_variables);
+   /// the caches are freed with their closures
+   ASSERT_EQ(run_code("unset($first, $second, $third);\n"
+                      "$again = Closure::bind($read, new ClosureTestBox(7), ClosureTestBox::class);\n"
+                      "return $again() . ' ' . $again();"), "7:3 7:4");
+}
+
+TEST_F(ClosureTest, testUseBindingsAfterSharing)
+{
+   ASSERT_EQ(run_code("$makeAdder = function ($step) {\n"
+                      "   return function ($value) use ($step) {\n"
+                      "      static $total = 0;\n"
+                      "      $total += $value + $step;\n"
+                      "      return $total;\n"
+                      "   };\n"
+                      "};\n"
+                      "$one = $makeAdder(1);\n"
+                      "$ten = $makeAdder(10);"), "");
+   /// binding the use variables separated the tables already
+   ASSERT_NE(closure_function("one")->static_variables, closure_function("ten")->static_variables);
+   ASSERT_EQ(run_code("return $one(1) . ',' . $ten(1) . ',' . $one(1) . ',' . $makeAdder(100)(0);"),
+             "2,11,4,100");
+   ASSERT_EQ(run_code("$counter = 1;\n"
+                      "$increments = [];\n"
+                      "for ($i = 0; $i < 3; $i++) {\n"
+                      "   $increments[] = function () use (&$counter, $i) { $counter += $i; return $counter; };\n"
+                      "}\n"
+                      "foreach ($increments as $increment) { $increment(); }\n"
+                      "return $counter . ',' . $increments[2]();"), "4,6");
+}
+
+TEST_F(ClosureTest, testCycleThroughSeparatedTable)
+{
+   /// the closure's table holds the probe and the probe holds the closure,
+   /// only the collector can free them once the table was separated
+   ASSERT_EQ(run_code("class ClosureTestProbe {\n"
+                      "   public $callback;\n"
+                      "   public function __destruct() { $GLOBALS['closureTestDestroyed']++; }\n"
+                      "}\n"
+                      "$closureTestDestroyed = 0;\n"
+                      "$link = function () {\n"
+                      "   $probe = new ClosureTestProbe();\n"
+                      "   $probe->callback = function () use ($probe) { static $seen = 0; return ++$seen; };\n"
+                      "   $self = function () use (&$self) { return $self; };\n"
+                      "};\n"
+                      "for ($i = 0; $i < 5; $i++) { $link(); }\n"
+                      "$before = $closureTestDestroyed;\n"
+                      "$collected = gc_collect_cycles();\n"
+                      "return $before . ',' . $closureTestDestroyed . ',' . ($collected >= 15 ? 'all' : $collected);"),
+             "0,5,all");
+}
@@ -0,0 +1,342 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/internal/CompiledZpp.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string sg_errors;
+
+void record_error(int type, const char *, const uint32_t, const char *format, va_list args)
+{
+   char *message;
+   zend_vspprintf(&message, 0, format, args);
+   sg_errors += std::to_string(type) + ": " + message + "\n";
+   efree(message);
+}
+
+/// the function the arguments are passed to, the errors are reported in its name
+zend_function *get_test_function()
+{
+   static zend_internal_function function = [] {
+      zend_internal_function function;
+      memset(&function, 0, sizeof(function));
+      function.type = ZEND_INTERNAL_FUNCTION;
+      function.function_name = zend_string_init_interned("zpp_test", sizeof("zpp_test") - 1, 1);
+      return function;
+   }();
+   return reinterpret_cast<zend_function *>(&function);
+}
+
+/// one value of every kind a specifier may accept or refuse
+class SampleArgs
+{
+public:
+   SampleArgs()
+   {
+      zval value;
+      ZVAL_NULL(&value);
+      m_values.push_back(value);
+      ZVAL_FALSE(&value);
+      m_values.push_back(value);
+      ZVAL_TRUE(&value);
+      m_values.push_back(value);
+      ZVAL_LONG(&value, 42);
+      m_values.push_back(value);
+      ZVAL_DOUBLE(&value, 4.5);
+      m_values.push_back(value);
+      ZVAL_DOUBLE(&value, 1e30);
+      m_values.push_back(value);
+      ZVAL_STRING(&value, "12");
+      m_values.push_back(value);
+      ZVAL_STRING(&value, "12abc");
+      m_values.push_back(value);
+      ZVAL_STRING(&value, "abc");
+      m_values.push_back(value);
+      ZVAL_STRINGL(&value, "a\0b", 3);
+      m_values.push_back(value);
+      array_init(&value);
+      add_next_index_long(&value, 1);
+      add_next_index_long(&value, 2);
+      m_values.push_back(value);
+      object_init(&value);
+      m_values.push_back(value);
+      int type = zend_register_list_destructors_ex(nullptr, nullptr, "compiled zpp test", 0);
+      ZVAL_RES(&value, zend_register_resource(this, type));
+      m_values.push_back(value);
+      /// references to a scalar, to null and to an array
+      zval inner;
+      ZVAL_LONG(&inner, 7);
+      ZVAL_NEW_REF(&value, &inner);
+      m_values.push_back(value);
+      ZVAL_NULL(&inner);
+      ZVAL_NEW_REF(&value, &inner);
+      m_values.push_back(value);
+      array_init(&inner);
+      add_next_index_string(&inner, "x");
+      ZVAL_NEW_REF(&value, &inner);
+      m_values.push_back(value);
+   }
+
+   ~SampleArgs()
+   {
+      for (zval &value : m_values) {
+         zval_ptr_dtor(&value);
+      }
+   }
+
+   const std::vector<zval> &getValues() const
+   {
+      return m_values;
+   }
+
+private:
+   std::vector<zval> m_values;
+};
+
+/// calls \p parser in a frame of its own holding copies of \p args, and
+/// describes its result together with the errors it reported
+template <typename Parser>
+std::string run_parser(const std::vector<zval> &args, Parser parser)
+{
+   uint32_t numArgs = static_cast<uint32_t>(args.size());
+   zend_execute_data *call = zend_vm_stack_push_call_frame(ZEND_CALL_TOP_FUNCTION, get_test_function(),
+                                                           numArgs, nullptr, nullptr);
+   for (uint32_t i = 0; i < numArgs; ++i) {
+      ZVAL_COPY(ZEND_CALL_ARG(call, i + 1), &args[i]);
+   }
+   call->prev_execute_data = EG(current_execute_data);
+   EG(current_execute_data) = call;
+   sg_errors.clear();
+   auto savedErrorCb = zend_error_cb;
+   zend_error_cb = record_error;
+   std::string outcome = parser(call);
+   zend_error_cb = savedErrorCb;
+   outcome += "\n" + sg_errors;
+   if (EG(exception)) {
+      zval exception;
+      zval rv;
+      ZVAL_OBJ(&exception, EG(exception));
+      zval *message = zend_read_property(zend_get_exception_base(&exception), &exception,
+                                         "message", sizeof("message") - 1, 1, &rv);
+      outcome += std::string(ZSTR_VAL(EG(exception)->ce->name)) + ": " + Z_STRVAL_P(message);
+      zend_clear_exception();
+   }
+   EG(current_execute_data) = call->prev_execute_data;
+   zend_vm_stack_free_args(call);
+   zend_vm_stack_free_call_frame(call);
+   return outcome;
+}
+
+std::string describe_result(int result, const std::string &value)
+{
+   return result == SUCCESS ? "SUCCESS " + value : "FAILURE";
+}
+
+/// where a zval destination points, the argument slot itself or the value
+/// of a reference in it
+std::string describe_zval(zval *value, zend_execute_data *call)
+{
+   if (!value) {
+      return "NULL";
+   }
+   for (uint32_t i = 0; i < ZEND_CALL_NUM_ARGS(call); ++i) {
+      zval *arg = ZEND_CALL_ARG(call, i + 1);
+      if (value == arg) {
+         return "arg " + std::to_string(i) + " " + zend_zval_type_name(value) +
+               (Z_ISREF_P(value) ? " reference" : "");
+      }
+      if (Z_ISREF_P(arg) && value == Z_REFVAL_P(arg)) {
+         return "value of arg " + std::to_string(i) + " " + zend_zval_type_name(value);
+      }
+   }
+   return std::string("other ") + zend_zval_type_name(value);
+}
+
+std::string describe_ht(HashTable *ht, zend_execute_data *call)
+{
+   if (!ht) {
+      return "NULL";
+   }
+   for (uint32_t i = 0; i < ZEND_CALL_NUM_ARGS(call); ++i) {
+      zval *arg = ZEND_CALL_ARG(call, i + 1);
+      ZVAL_DEREF(arg);
+      if (Z_TYPE_P(arg) == IS_ARRAY && Z_ARRVAL_P(arg) == ht) {
+         return "array of arg " + std::to_string(i);
+      }
+      if (Z_TYPE_P(arg) == IS_OBJECT && Z_OBJ_HT_P(arg)->get_properties(arg) == ht) {
+         return "properties of arg " + std::to_string(i);
+      }
+   }
+   return "other table";
+}
+
+std::string describe_str(zend_string *str)
+{
+   return str ? "'" + std::string(ZSTR_VAL(str), ZSTR_LEN(str)) + "'" : "NULL";
+}
+
+std::string describe_chars(const char *str, size_t length)
+{
+   return str ? "'" + std::string(str, length) + "'" : "NULL";
+}
+
+std::string describe_bool(zend_bool value)
+{
+   return value ? "true" : "false";
+}
+
+/// parses every argument list in \p argLists with \p format through the
+/// compiled decoder and through zend_parse_parameters_ex(), with and
+/// without ZEND_PARSE_PARAMS_THROW, the destinations are declared by
+/// \p declare and \p describe turns them into text
+#define EXPECT_SAME_AS_ZPP(argLists, format, declare, describe, ...) \
+   for (const std::vector<zval> &args : argLists) { \
+      for (int flags : {0, ZEND_PARSE_PARAMS_THROW}) { \
+         std::string compiled = run_parser(args, [&](zend_execute_data *execute_data) { \
+            declare \
+            int result = POLAR_PARSE_PARAMETERS_EX(flags, format, __VA_ARGS__); \
+            return describe_result(result, describe); \
+         }); \
+         std::string legacy = run_parser(args, [&](zend_execute_data *execute_data) { \
+            declare \
+            int result = zend_parse_parameters_ex(flags, ZEND_NUM_ARGS(), format, __VA_ARGS__); \
+            return describe_result(result, describe); \
+         }); \
+         EXPECT_EQ(compiled, legacy) << "format \"" << format << "\" flags " << flags; \
+      } \
+   }
+
+/// every sample as the only argument
+std::vector<std::vector<zval>> get_single_args(const SampleArgs &samples)
+{
+   std::vector<std::vector<zval>> argLists;
+   for (const zval &value : samples.getValues()) {
+      argLists.push_back({value});
+   }
+   return argLists;
+}
+
+} // anonymous namespace
+
+TEST(CompiledZppTest, testZval)
+{
+   SampleArgs samples;
+   std::vector<std::vector<zval>> argLists = get_single_args(samples);
+   EXPECT_SAME_AS_ZPP(argLists, "z", zval *value = nullptr;,
+                      describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "z!", zval *value = nullptr;,
+                      describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "z/", zval *value = nullptr;,
+                      describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "z/!", zval *value = nullptr;,
+                      describe_zval(value, execute_data), &value);
+}
+
+TEST(CompiledZppTest, testZvalKeepsReferences)
+{
+   zval inner;
+   zval ref;
+   ZVAL_LONG(&inner, 7);
+   ZVAL_NEW_REF(&ref, &inner);
+   std::string outcome = run_parser({ref}, [](zend_execute_data *execute_data) {
+      zval *value = nullptr;
+      zval *separated = nullptr;
+      POLAR_PARSE_PARAMETERS("z", &value);
+      EXPECT_TRUE(Z_ISREF_P(value));
+      EXPECT_EQ(value, ZEND_CALL_ARG(execute_data, 1));
+      POLAR_PARSE_PARAMETERS("z/", &separated);
+      EXPECT_EQ(Z_TYPE_P(separated), IS_LONG);
+      EXPECT_EQ(separated, Z_REFVAL_P(value));
+      return std::string();
+   });
+   EXPECT_EQ(outcome, "\n");
+   zval_ptr_dtor(&ref);
+}
+
+TEST(CompiledZppTest, testScalars)
+{
+   SampleArgs samples;
+   std::vector<std::vector<zval>> argLists = get_single_args(samples);
+   EXPECT_SAME_AS_ZPP(argLists, "b", zend_bool value = 0;, describe_bool(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "b!", zend_bool value = 0; zend_bool isNull = 0;,
+                      describe_bool(value) + " " + describe_bool(isNull), &value, &isNull);
+   EXPECT_SAME_AS_ZPP(argLists, "l", zend_long value = 0;, std::to_string(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "l!", zend_long value = 0; zend_bool isNull = 0;,
+                      std::to_string(value) + " " + describe_bool(isNull), &value, &isNull);
+   EXPECT_SAME_AS_ZPP(argLists, "L", zend_long value = 0;, std::to_string(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "L!", zend_long value = 0; zend_bool isNull = 0;,
+                      std::to_string(value) + " " + describe_bool(isNull), &value, &isNull);
+   EXPECT_SAME_AS_ZPP(argLists, "d", double value = 0;, std::to_string(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "d!", double value = 0; zend_bool isNull = 0;,
+                      std::to_string(value) + " " + describe_bool(isNull), &value, &isNull);
+}
+
+TEST(CompiledZppTest, testStrings)
+{
+   SampleArgs samples;
+   std::vector<std::vector<zval>> argLists = get_single_args(samples);
+   EXPECT_SAME_AS_ZPP(argLists, "S", zend_string *value = nullptr;, describe_str(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "S!", zend_string *value = nullptr;, describe_str(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "P", zend_string *value = nullptr;, describe_str(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "P!", zend_string *value = nullptr;, describe_str(value), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "s", char *value = nullptr; size_t length = 0;,
+                      describe_chars(value, length), &value, &length);
+   EXPECT_SAME_AS_ZPP(argLists, "s!", char *value = nullptr; size_t length = 0;,
+                      describe_chars(value, length), &value, &length);
+   EXPECT_SAME_AS_ZPP(argLists, "p", char *value = nullptr; size_t length = 0;,
+                      describe_chars(value, length), &value, &length);
+   EXPECT_SAME_AS_ZPP(argLists, "p!", char *value = nullptr; size_t length = 0;,
+                      describe_chars(value, length), &value, &length);
+}
+
+TEST(CompiledZppTest, testArraysObjectsAndResources)
+{
+   SampleArgs samples;
+   std::vector<std::vector<zval>> argLists = get_single_args(samples);
+   EXPECT_SAME_AS_ZPP(argLists, "a", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "a!", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "a/", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "A", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "A!", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "o", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "o!", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "r", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "r!", zval *value = nullptr;, describe_zval(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "h", HashTable *value = nullptr;, describe_ht(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "h!", HashTable *value = nullptr;, describe_ht(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "h/", HashTable *value = nullptr;, describe_ht(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "H", HashTable *value = nullptr;, describe_ht(value, execute_data), &value);
+   EXPECT_SAME_AS_ZPP(argLists, "H!", HashTable *value = nullptr;, describe_ht(value, execute_data), &value);
+}
+
+TEST(CompiledZppTest, testArgumentCount)
+{
+   SampleArgs samples;
+   const std::vector<zval> &values = samples.getValues();
+   /// none, one, two and three longs, then a string where the second long goes
+   std::vector<std::vector<zval>> argLists = {
+      {},
+      {values[3]},
+      {values[3], values[3]},
+      {values[3], values[3], values[3]},
+      {values[3], values[8]}
+   };
+   EXPECT_SAME_AS_ZPP(argLists, "l|l", zend_long first = -1; zend_long second = -1;,
+                      std::to_string(first) + " " + std::to_string(second), &first, &second);
+   EXPECT_SAME_AS_ZPP(argLists, "ll", zend_long first = -1; zend_long second = -1;,
+                      std::to_string(first) + " " + std::to_string(second), &first, &second);
+   EXPECT_SAME_AS_ZPP(argLists, "|S", zend_string *value = nullptr;, describe_str(value), &value);
+}
@@ -0,0 +1,93 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "php/kernel/io/EventLoop.h"
+#include "polarphp/vm/ds/CallableVariant.h"
+#include "polarphp/vm/ds/Variant.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using php::kernel::io::EventLoop;
+using polar::vmapi::CallableVariant;
+using polar::vmapi::Variant;
+
+namespace {
+
+/// a php closure appending what it is given to $log
+Variant make_logger()
+{
+   zval closure;
+   EXPECT_EQ(zend_eval_string(const_cast<char *>(
+                                 "$log = ''; return function ($data) { $GLOBALS['log'] .= $data . ','; };"),
+                              &closure, const_cast<char *>("event loop callback test")), SUCCESS);
+   Variant callback(closure);
+   zval_ptr_dtor(&closure);
+   return callback;
+}
+
+std::string get_log()
+{
+   zval *value = zend_hash_str_find(&EG(symbol_table), "log", sizeof("log") - 1);
+   if (!value) {
+      return std::string();
+   }
+   ZVAL_DEREF(value);
+   return std::string(Z_STRVAL_P(value), Z_STRLEN_P(value));
+}
+
+} // anonymous namespace
+
+TEST(EventLoopCallbackTest, testVariantCallback)
+{
+   EventLoop loop;
+   if (!loop.isValid()) {
+      return;
+   }
+   char pathTemplate[] = "/tmp/polar-event-loop-callback-XXXXXX";
+   int fd = ::mkstemp(pathTemplate);
+   ASSERT_GE(fd, 0);
+   ASSERT_EQ(::write(fd, "php", 3), 3);
+   ::close(fd);
+   std::string path = pathTemplate;
+   Variant callback = make_logger();
+   uint32_t refCount = callback.getRefCount();
+   /// wrapped the way IoEventLoop does, the zval is copied and released
+   /// on this thread only while the workers read and write
+   for (int i = 0; i < 20; ++i) {
+      loop.readFile(path, [callback](bool ok, std::string &&data, int) {
+         CallableVariant handler(callback);
+         handler(ok ? Variant(data) : Variant(false));
+      });
+      loop.writeFile(path, "", true, [callback](bool ok, std::string &&, int) {
+         CallableVariant handler(callback);
+         handler(Variant(ok ? "w" : "-"));
+      });
+      ASSERT_GT(callback.getRefCount(), refCount);
+   }
+   loop.run();
+   std::remove(path.c_str());
+   std::string log = get_log();
+   std::string expected;
+   for (int i = 0; i < 20; ++i) {
+      expected += "php,w,";
+   }
+   ASSERT_EQ(log.size(), expected.size());
+   ASSERT_EQ(std::count(log.begin(), log.end(), 'w'), 20);
+   /// every copy made for the operations is gone again
+   ASSERT_EQ(callback.getRefCount(), refCount);
+   zend_hash_str_del(&EG(symbol_table), "log", sizeof("log") - 1);
+}
@@ -0,0 +1,85 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/ast/IdentifierTable.h"
+#include "polarphp/runtime/IdentifierInterner.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <string>
+#include <vector>
+
+using polar::ast::Identifier;
+using polar::ast::IdentifierTable;
+using polar::runtime::install_identifier_interner;
+
+namespace {
+
+zend_ulong engine_hash(const std::string &text)
+{
+   return zend_inline_hash_func(text.data(), text.size());
+}
+
+zend_ulong engine_lowercase_hash(const std::string &text)
+{
+   zend_string *lowered = zend_string_init(text.data(), text.size(), 0);
+   zend_str_tolower(ZSTR_VAL(lowered), ZSTR_LEN(lowered));
+   zend_ulong hash = ZSTR_HASH(lowered);
+   zend_string_release(lowered);
+   return hash;
+}
+
+} // anonymous namespace
+
+TEST(IdentifierInternerTest, testHashParity)
+{
+   std::vector<std::string> texts = {
+      "", "a", "Z", "strlen", "StrLen", "ArrayObject", "__construct",
+      "Polar\\Lang\\Closure", "abcdefgh", "abcdefghi", "ABCDEFGHIJKLMNOP",
+      "\xC3\x84pfel", "\xFF\x80\x7F", std::string("nul\0byte", 8)
+   };
+   /// every length around the unrolled loop of zend_inline_hash_func
+   for (int length = 0; length < 20; ++length) {
+      texts.push_back(std::string(length, 'M') + "\xE9");
+   }
+   for (const std::string &text : texts) {
+      ASSERT_EQ(IdentifierTable::hash(text), engine_hash(text)) << text;
+      ASSERT_EQ(IdentifierTable::hashCaseInsensitive(text), engine_lowercase_hash(text)) << text;
+   }
+   IdentifierTable table;
+   Identifier identifier = table.get("StrLen");
+   ASSERT_EQ(identifier.getFoldedHash(), engine_lowercase_hash("StrLen"));
+   ASSERT_EQ(identifier.getFolded().getFoldedHash(), engine_hash("strlen"));
+}
+
+TEST(IdentifierInternerTest, testSharesPermanentInternedStrings)
+{
+   zend_string *engineName = zend_string_init_interned("strlen", sizeof("strlen") - 1, 1);
+   ASSERT_TRUE(ZSTR_IS_INTERNED(engineName));
+   ASSERT_TRUE(GC_FLAGS(engineName) & IS_STR_PERMANENT);
+   IdentifierTable table;
+   install_identifier_interner(table);
+   /// the spellings the engine knows take its bytes
+   Identifier lower = table.get("strlen");
+   ASSERT_EQ(lower.get(), ZSTR_VAL(engineName));
+   Identifier mixed = table.get("StrLen");
+   ASSERT_EQ(mixed.getFolded(), lower);
+   ASSERT_EQ(mixed.str(), "StrLen");
+   ASSERT_NE(mixed.get(), ZSTR_VAL(engineName));
+   /// the others are copied, nothing is added to the permanent strings
+   Identifier unknown = table.get("no_such_symbol_in_the_engine");
+   ASSERT_EQ(unknown.str(), "no_such_symbol_in_the_engine");
+   zend_string *key = zend_string_init("no_such_symbol_in_the_engine",
+                                       sizeof("no_such_symbol_in_the_engine") - 1, 0);
+   ASSERT_EQ(zend_interned_string_find_permanent(key), nullptr);
+   zend_string_release(key);
+   ASSERT_EQ(table.lookupCaseInsensitive("STRLEN"), lower);
+}
@@ -0,0 +1,122 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/ExecEnv.h"
+#include "polarphp/runtime/IncludePrefetch.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using polar::runtime::ExecEnvInfo;
+using polar::runtime::retrieve_global_execenv;
+using polar::runtime::is_include_prefetch_available;
+using polar::runtime::prefetch_include_files;
+
+namespace {
+
+/// runs \p code and returns what it returned as a string
+std::string run_code(const char *code)
+{
+   zval source;
+   ZVAL_STRING(&source, code);
+   zend_op_array *opArray = zend_compile_string(&source, const_cast<char *>("include prefetch test"));
+   zval_ptr_dtor(&source);
+   EXPECT_NE(opArray, nullptr);
+   if (!opArray) {
+      return std::string();
+   }
+   zval result;
+   ZVAL_UNDEF(&result);
+   zend_execute(opArray, &result);
+   destroy_op_array(opArray);
+   efree(opArray);
+   zend_string *text = zval_get_string(&result);
+   std::string value(ZSTR_VAL(text), ZSTR_LEN(text));
+   zend_string_release(text);
+   zval_ptr_dtor(&result);
+   return value;
+}
+
+/// a directory on the include_path, the CWD is left somewhere else so a
+/// relative name only resolves through include_path
+class ScopedIncludeDirectory
+{
+public:
+   ScopedIncludeDirectory()
+   {
+      char pathTemplate[] = "/tmp/polar-include-prefetch-XXXXXX";
+      EXPECT_NE(::mkdtemp(pathTemplate), nullptr);
+      char realPath[PATH_MAX];
+      EXPECT_NE(::realpath(pathTemplate, realPath), nullptr);
+      m_path = realPath;
+      ExecEnvInfo &execEnvInfo = retrieve_global_execenv().getRuntimeInfo();
+      m_includePath = execEnvInfo.includePath;
+      execEnvInfo.includePath = m_path;
+   }
+
+   ~ScopedIncludeDirectory()
+   {
+      retrieve_global_execenv().getRuntimeInfo().includePath = m_includePath;
+      for (const std::string &file : m_files) {
+         ::unlink(file.c_str());
+      }
+      ::rmdir(m_path.c_str());
+   }
+
+   std::string write(const std::string &name, const std::string &source)
+   {
+      std::string path = m_path + "/" + name;
+      std::ofstream file(path, std::ios::binary);
+      file << source;
+      m_files.push_back(path);
+      return path;
+   }
+
+private:
+   std::string m_path;
+   std::string m_includePath;
+   std::vector<std::string> m_files;
+};
+
+} // anonymous namespace
+
+TEST(IncludePrefetchTest, testRelativeRequireOnce)
+{
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   if (!is_include_prefetch_available()) {
+      return;
+   }
+   ScopedIncludeDirectory directory;
+   std::string once = directory.write("prefetch_once.php",
+                                      "<?php $GLOBALS['prefetchOnce'] .= 'x'; return __FILE__;");
+   std::string plain = directory.write("prefetch_plain.php", "<?php return __FILE__;");
+   ASSERT_EQ(prefetch_include_files({once, plain}), 2u);
+   /// the second require_once finds the first by the path the prefetched
+   /// handle reported, a relative name would be a file of its own
+   ASSERT_EQ(run_code("$GLOBALS['prefetchOnce'] = '';"
+                      "$first = require_once 'prefetch_once.php';"
+                      "$second = require_once 'prefetch_once.php';"
+                      "return $first . '|' . var_export($second, true) . '|' . $GLOBALS['prefetchOnce'];"),
+             once + "|true|x");
+   /// a plain require of a relative name is resolved against include_path,
+   /// not the CWD, and still takes the prefetched buffer
+   ASSERT_EQ(run_code("return require 'prefetch_plain.php';"), plain);
+   ASSERT_NE(zend_hash_str_find(&EG(included_files), once.data(), once.size()), nullptr);
+   ASSERT_NE(zend_hash_str_find(&EG(included_files), plain.data(), plain.size()), nullptr);
+   ASSERT_EQ(zend_hash_str_find(&EG(included_files), "prefetch_once.php", sizeof("prefetch_once.php") - 1), nullptr);
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+}
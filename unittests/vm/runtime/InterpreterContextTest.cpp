@@ -0,0 +1,168 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/LifeCycle.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <string>
+#include <thread>
+
+using polar::runtime::php_exec_env_startup;
+using polar::runtime::php_exec_env_shutdown;
+
+namespace {
+
+/// runs \p code and returns what it returned as a string
+std::string run_code(const char *code)
+{
+   zval source;
+   ZVAL_STRING(&source, code);
+   zend_op_array *opArray = zend_compile_string(&source, const_cast<char *>("interpreter context test"));
+   zval_ptr_dtor(&source);
+   EXPECT_NE(opArray, nullptr);
+   if (!opArray) {
+      return std::string();
+   }
+   zval result;
+   ZVAL_UNDEF(&result);
+   zend_execute(opArray, &result);
+   destroy_op_array(opArray);
+   efree(opArray);
+   zend_string *text = zval_get_string(&result);
+   std::string value(ZSTR_VAL(text), ZSTR_LEN(text));
+   zend_string_release(text);
+   zval_ptr_dtor(&result);
+   return value;
+}
+
+/// the TSRM storage of the executor globals of the current context
+void *executor_globals_storage()
+{
+   return ts_resource(executor_globals_id);
+}
+
+/// makes \p context current, the cached entry the module globals are
+/// read through has to follow by hand, the release build only fills it
+/// when it is empty
+void *switch_context(void *context)
+{
+   void *previous = tsrm_set_interpreter_context(context);
+   ZEND_TSRMLS_CACHE = tsrm_get_ls_cache();
+   return previous;
+}
+
+/// a request on the current context of this thread
+std::string run_request(const char *code)
+{
+   std::string result;
+   if (!php_exec_env_startup()) {
+      ADD_FAILURE() << "request did not start";
+      return result;
+   }
+   result = run_code(code);
+   php_exec_env_shutdown();
+   return result;
+}
+
+const std::size_t MARKER_SLOT = ZEND_MAX_RESERVED_RESOURCES - 1;
+
+} // anonymous namespace
+
+TEST(InterpreterContextTest, testStaticFastPath)
+{
+   /// EG() reads the initial-exec block of the thread, TSRM hands out the
+   /// same storage for the current context
+   void *mainBlock = &zend_static_globals_block.executor;
+   ASSERT_EQ(executor_globals_storage(), mainBlock);
+   ASSERT_EQ(ts_resource(compiler_globals_id), static_cast<void *>(&zend_static_globals_block.compiler));
+   ASSERT_EQ(&EG(symbol_table), &static_cast<zend_executor_globals *>(executor_globals_storage())->symbol_table);
+   void *threadBlock = nullptr;
+   void *threadStorage = nullptr;
+   bool constructed = false;
+   std::thread worker([&]() {
+      (void)ts_resource(0);
+      threadBlock = &zend_static_globals_block.executor;
+      threadStorage = executor_globals_storage();
+      /// the executor globals of the new thread were constructed in place
+      constructed = EG(zend_constants) != nullptr && EG(current_execute_data) == nullptr;
+      ts_free_thread();
+   });
+   worker.join();
+   ASSERT_NE(threadBlock, mainBlock);
+   ASSERT_EQ(threadStorage, threadBlock);
+   ASSERT_TRUE(constructed);
+   ASSERT_EQ(executor_globals_storage(), mainBlock);
+}
+
+TEST(InterpreterContextTest, testNoSwitchDuringRequest)
+{
+   /// the test entry keeps a request running on this thread
+   void *current = tsrm_get_ls_cache();
+   void *context = tsrm_new_interpreter_context();
+   ASSERT_NE(context, nullptr);
+   ASSERT_NE(context, current);
+   ASSERT_EQ(tsrm_get_ls_cache(), current);
+   /// the globals of the request stay where $GLOBALS points
+   ASSERT_EQ(run_code("$contextTest = 1;"), "");
+   ASSERT_EQ(tsrm_set_interpreter_context(context), nullptr);
+   ASSERT_EQ(tsrm_get_ls_cache(), current);
+   ASSERT_EQ(executor_globals_storage(), static_cast<void *>(&zend_static_globals_block.executor));
+   ASSERT_EQ(run_code("return $GLOBALS['contextTest'] + 1;"), "2");
+   tsrm_free_interpreter_context(context);
+}
+
+TEST(InterpreterContextTest, testSwitchBetweenThreads)
+{
+   void *context = nullptr;
+   int marker = 0;
+   std::string firstResult;
+   std::string secondResult;
+   bool markerFollowed = false;
+   bool refusedDuringRequest = false;
+   /// the context is made and used on one thread
+   std::thread first([&]() {
+      (void)ts_resource(0);
+      context = tsrm_new_interpreter_context();
+      void *own = switch_context(context);
+      EG(reserved)[MARKER_SLOT] = &marker;
+      firstResult = run_request("$GLOBALS['side'] = 'first'; return $side;");
+      switch_context(own);
+      ts_free_thread();
+   });
+   first.join();
+   ASSERT_EQ(firstResult, "first");
+   ASSERT_NE(context, nullptr);
+   /// then its globals move into the static block of another thread, and
+   /// a request there finds its symbol table through $GLOBALS again
+   std::thread second([&]() {
+      (void)ts_resource(0);
+      void *own = switch_context(context);
+      markerFollowed = EG(reserved)[MARKER_SLOT] == &marker &&
+            executor_globals_storage() == &zend_static_globals_block.executor;
+      if (!php_exec_env_startup()) {
+         ADD_FAILURE() << "request did not start";
+      } else {
+         refusedDuringRequest = tsrm_set_interpreter_context(own) == nullptr &&
+               tsrm_get_ls_cache() == context;
+         secondResult = run_code("$values = [1, 2]; $GLOBALS['side'] = 3;"
+                                 "return count($values) + $side + count($GLOBALS['values']);");
+         php_exec_env_shutdown();
+      }
+      switch_context(own);
+      ts_free_thread();
+   });
+   second.join();
+   ASSERT_TRUE(markerFollowed);
+   ASSERT_TRUE(refusedDuringRequest);
+   ASSERT_EQ(secondResult, "7");
+   tsrm_free_interpreter_context(context);
+}
@@ -0,0 +1,229 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+#include "polarphp/vm/zend/zend_rcu_hash.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t ENTRY_MAGIC = 0x5243554841534821;
+
+/// what the tables below hold, the destructor poisons it before freeing
+struct RcuEntry
+{
+   std::uint64_t magic;
+   std::uint64_t generation;
+};
+
+std::atomic<int> sg_removed(0);
+std::atomic<int> sg_freed(0);
+
+void remove_entry(zval *)
+{
+   ++sg_removed;
+}
+
+void free_entry(zval *zv)
+{
+   RcuEntry *entry = static_cast<RcuEntry *>(Z_PTR_P(zv));
+   entry->magic = 0;
+   free(entry);
+   ++sg_freed;
+}
+
+RcuEntry *make_entry(std::uint64_t generation)
+{
+   RcuEntry *entry = static_cast<RcuEntry *>(malloc(sizeof(RcuEntry)));
+   entry->magic = ENTRY_MAGIC;
+   entry->generation = generation;
+   return entry;
+}
+
+void update_entry(RcuHashTable *table, const std::string &key, std::uint64_t generation)
+{
+   zend_rcu_hash_str_update_ptr(table, key.data(), key.size(), make_entry(generation));
+}
+
+/// a thread of its own TSRM context, as a server thread would have
+template <typename Callback>
+std::thread start_reader(Callback callback)
+{
+   return std::thread([callback]() {
+      (void)ts_resource(0);
+      callback();
+      ts_free_thread();
+   });
+}
+
+class RcuHashTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      sg_removed = 0;
+      sg_freed = 0;
+      zend_rcu_hash_init(&m_table, 8, nullptr, free_entry, 1);
+      zend_rcu_hash_set_remove_handler(&m_table, remove_entry);
+   }
+
+   void TearDown() override
+   {
+      zend_rcu_hash_destroy(&m_table);
+   }
+
+   RcuHashTable m_table;
+};
+
+} // anonymous namespace
+
+TEST_F(RcuHashTest, testRemovedValueOutlivesReaders)
+{
+   update_entry(&m_table, "a", 1);
+   update_entry(&m_table, "b", 1);
+   ASSERT_EQ(zend_rcu_hash_num_elements(&m_table), 2);
+   zend_rcu_read_lock();
+   RcuEntry *entry = static_cast<RcuEntry *>(zend_rcu_hash_str_find_ptr(&m_table, "a", 1));
+   ASSERT_NE(entry, nullptr);
+   /// the remove handler runs with the write, the value stays readable
+   /// while a read section that may have seen it is open
+   zend_string *key = zend_string_init("a", 1, 0);
+   ASSERT_EQ(zend_rcu_hash_del(&m_table, key), SUCCESS);
+   zend_string_release(key);
+   ASSERT_EQ(sg_removed, 1);
+   ASSERT_EQ(zend_rcu_hash_str_find_ptr(&m_table, "a", 1), nullptr);
+   update_entry(&m_table, "c", 1);
+   ASSERT_EQ(sg_freed, 0);
+   ASSERT_EQ(entry->magic, ENTRY_MAGIC);
+   /// the old snapshot still has it
+   zend_rcu_read_unlock();
+   /// the next write reclaims what nobody can see anymore
+   update_entry(&m_table, "c", 2);
+   ASSERT_EQ(sg_removed, 2);
+   ASSERT_EQ(sg_freed, 2);
+   ASSERT_EQ(static_cast<RcuEntry *>(zend_rcu_hash_str_find_ptr(&m_table, "c", 1))->generation, 2u);
+   /// destroying runs both for what is left
+   zend_rcu_hash_clean(&m_table);
+   update_entry(&m_table, "d", 1);
+   ASSERT_EQ(sg_removed, 4);
+   ASSERT_EQ(sg_freed, 4);
+}
+
+TEST_F(RcuHashTest, testConcurrentReadersAndWriter)
+{
+   const int keyCount = 16;
+   const std::uint64_t generations = 2000;
+   for (int i = 0; i < keyCount; ++i) {
+      update_entry(&m_table, "key" + std::to_string(i), 0);
+   }
+   std::atomic<bool> done(false);
+   std::atomic<int> failures(0);
+   std::atomic<long> reads(0);
+   std::vector<std::thread> readers;
+   for (int r = 0; r < 4; ++r) {
+      readers.push_back(start_reader([&]() {
+         std::vector<std::uint64_t> seen(keyCount, 0);
+         while (!done) {
+            for (int i = 0; i < keyCount; ++i) {
+               std::string key = "key" + std::to_string(i);
+               zend_rcu_read_lock();
+               RcuEntry *entry = static_cast<RcuEntry *>(
+                        zend_rcu_hash_str_find_ptr(&m_table, key.data(), key.size()));
+               /// a value found in a read section is never freed under it,
+               /// and a later read never goes back to an older generation
+               if (!entry || entry->magic != ENTRY_MAGIC || entry->generation < seen[i]) {
+                  ++failures;
+               } else {
+                  seen[i] = entry->generation;
+               }
+               zend_rcu_read_unlock();
+               ++reads;
+            }
+            zend_rcu_read_lock();
+            if (zend_hash_num_elements(RCU_HASH(&m_table)) != static_cast<uint32_t>(keyCount)) {
+               ++failures;
+            }
+            zend_rcu_read_unlock();
+         }
+      }));
+   }
+   for (std::uint64_t generation = 1; generation <= generations; ++generation) {
+      update_entry(&m_table, "key" + std::to_string(generation % keyCount), generation);
+   }
+   done = true;
+   for (std::thread &reader : readers) {
+      reader.join();
+   }
+   ASSERT_EQ(failures, 0);
+   ASSERT_GT(reads, 0);
+   ASSERT_EQ(sg_removed, static_cast<int>(generations));
+   /// with every reader gone one more write reclaims the rest
+   update_entry(&m_table, "key0", generations + 1);
+   ASSERT_EQ(sg_freed, static_cast<int>(generations) + 1);
+}
+
+TEST(RcuModuleRegistryTest, testLookupsWhileModulesComeAndGo)
+{
+   int moduleCount = zend_rcu_hash_num_elements(&module_registry);
+   ASSERT_GT(moduleCount, 0);
+   ASSERT_EQ(zend_get_module_started("core"), SUCCESS);
+   std::atomic<bool> done(false);
+   std::atomic<int> failures(0);
+   std::vector<std::thread> readers;
+   for (int r = 0; r < 3; ++r) {
+      readers.push_back(start_reader([&]() {
+         while (!done) {
+            if (zend_get_module_started("core") != SUCCESS || !zend_get_module_version("core")) {
+               ++failures;
+            }
+            zend_rcu_read_lock();
+            void *ptr;
+            int count = 0;
+            ZEND_HASH_FOREACH_PTR(RCU_HASH(&module_registry), ptr) {
+               if (!static_cast<zend_module_entry *>(ptr)->name) {
+                  ++failures;
+               }
+               ++count;
+            } ZEND_HASH_FOREACH_END();
+            zend_rcu_read_unlock();
+            if (count < moduleCount || count > moduleCount + 1) {
+               ++failures;
+            }
+         }
+      }));
+   }
+   zend_string *name = zend_string_init("rcu_registry_test", sizeof("rcu_registry_test") - 1, 1);
+   for (int i = 0; i < 200; ++i) {
+      zend_module_entry entry = {
+         STANDARD_MODULE_HEADER,
+         "rcu_registry_test",
+         nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+         "1.0",
+         STANDARD_MODULE_PROPERTIES
+      };
+      entry.module_number = zend_next_free_module();
+      ASSERT_NE(zend_register_internal_module(&entry), nullptr);
+      ASSERT_EQ(zend_rcu_hash_del(&module_registry, name), SUCCESS);
+   }
+   zend_string_release(name);
+   done = true;
+   for (std::thread &reader : readers) {
+      reader.join();
+   }
+   ASSERT_EQ(failures, 0);
+   ASSERT_EQ(zend_rcu_hash_num_elements(&module_registry), moduleCount);
+   ASSERT_FALSE(zend_rcu_hash_str_find_ptr(&module_registry, "rcu_registry_test", sizeof("rcu_registry_test") - 1));
+}
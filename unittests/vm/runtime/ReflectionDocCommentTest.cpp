@@ -0,0 +1,133 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/markup/DocComment.h"
+#include "polarphp/runtime/ExecEnv.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+#include "polarphp/runtime/langsupport/Reflection.h"
+
+#include <string>
+
+using polar::markup::DocCommentCache;
+using polar::runtime::retrieve_global_execenv;
+using polar::runtime::retrieve_request_doc_comments;
+
+namespace {
+
+/// runs \p code and returns what it returned as a string
+std::string run_code(const char *code)
+{
+   zval source;
+   ZVAL_STRING(&source, code);
+   zend_op_array *opArray = zend_compile_string(&source, const_cast<char *>("reflection doc comment test"));
+   zval_ptr_dtor(&source);
+   EXPECT_NE(opArray, nullptr);
+   if (!opArray) {
+      return std::string();
+   }
+   zval result;
+   ZVAL_UNDEF(&result);
+   zend_execute(opArray, &result);
+   destroy_op_array(opArray);
+   efree(opArray);
+   zend_string *text = zval_get_string(&result);
+   std::string value(ZSTR_VAL(text), ZSTR_LEN(text));
+   zend_string_release(text);
+   zval_ptr_dtor(&result);
+   return value;
+}
+
+/// the tags of a reflector as name=value pairs joined by ;
+const char *sg_tagsHelper =
+      "function doc_comment_tags_of($reflector) {"
+      "   $tags = [];"
+      "   foreach ($reflector->getDocCommentTags() as $tag) {"
+      "      $tags[] = $tag['name'] . '=' . $tag['value'];"
+      "   }"
+      "   return implode(';', $tags);"
+      "}";
+
+std::string run_with_helper(const std::string &code)
+{
+   return run_code((std::string(sg_tagsHelper) + code).c_str());
+}
+
+} // anonymous namespace
+
+TEST(ReflectionDocCommentTest, testGetDocCommentTags)
+{
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_EQ(run_with_helper(
+                "/**\n"
+                " * Adds.\n"
+                " *\n"
+                " * @param int $a the first\n"
+                " *        operand\n"
+                " * @return int\n"
+                " */\n"
+                "function doc_comment_add($a) { return $a; }\n"
+                "/** @internal */\n"
+                "class DocCommentSubject {\n"
+                "   /** @var string */\n"
+                "   public $name;\n"
+                "   /** plain prose */\n"
+                "   const VERSION = 1;\n"
+                "   /** @deprecated use other() */\n"
+                "   public function old() {}\n"
+                "   public function undocumented() {}\n"
+                "}\n"
+                "return implode('|', ["
+                "   doc_comment_tags_of(new ReflectionFunction('doc_comment_add')),"
+                "   doc_comment_tags_of(new ReflectionClass('DocCommentSubject')),"
+                "   doc_comment_tags_of(new ReflectionProperty('DocCommentSubject', 'name')),"
+                "   doc_comment_tags_of(new ReflectionClassConstant('DocCommentSubject', 'VERSION')),"
+                "   doc_comment_tags_of(new ReflectionMethod('DocCommentSubject', 'old')),"
+                "   doc_comment_tags_of(new ReflectionMethod('DocCommentSubject', 'undocumented')),"
+                "   doc_comment_tags_of(new ReflectionFunction('strlen')),"
+                "]);"),
+             "param=int $a the first operand;return=int|internal=|var=string||deprecated=use other()||");
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+}
+
+TEST(ReflectionDocCommentTest, testWorkerKeepsParses)
+{
+   const DocCommentCache &cache = retrieve_request_doc_comments();
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   retrieve_global_execenv().setWorkerMode(true);
+   const char *code =
+         "/** @return int */ function doc_comment_worker() {}"
+         "$reflector = new ReflectionFunction('doc_comment_worker');"
+         "return doc_comment_tags_of($reflector) . doc_comment_tags_of($reflector);";
+   unsigned parses = cache.getNumParses();
+   unsigned hits = cache.getNumHits();
+   ASSERT_EQ(run_with_helper(code), "return=intreturn=int");
+   ASSERT_EQ(cache.getNumParses(), parses + 1);
+   ASSERT_EQ(cache.getNumHits(), hits + 1);
+   /// the next request compiles the comment again, into a new string, and
+   /// finds the parse of the last one
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_NE(cache.getNumEntries(), 0u);
+   ASSERT_EQ(run_with_helper(code), "return=intreturn=int");
+   ASSERT_EQ(cache.getNumParses(), parses + 1);
+   ASSERT_EQ(cache.getNumHits(), hits + 3);
+   /// a comment of the same size, possibly at the address of the freed
+   /// one, is a comment of its own
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_EQ(run_with_helper("/** @return str */ function doc_comment_worker() {}"
+                             "return doc_comment_tags_of(new ReflectionFunction('doc_comment_worker'));"),
+             "return=str");
+   ASSERT_EQ(cache.getNumParses(), parses + 2);
+   /// outside of a worker they go with the request
+   retrieve_global_execenv().setWorkerMode(false);
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_EQ(cache.getNumEntries(), 0u);
+}
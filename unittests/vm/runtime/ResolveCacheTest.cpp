@@ -0,0 +1,178 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/ExecEnv.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+#include "polarphp/vm/zend/zend_resolve_cache.h"
+
+#include <string>
+
+using polar::runtime::retrieve_global_execenv;
+
+namespace {
+
+/// every test runs in a fresh request with the cache on, as a worker does
+class ResolveCacheTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      retrieve_global_execenv().setWorkerMode(true);
+      ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+      ASSERT_TRUE(EG(resolve_cache));
+      zend_resolve_cache_flush();
+   }
+
+   void TearDown() override
+   {
+      retrieve_global_execenv().setWorkerMode(false);
+      ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+      ASSERT_FALSE(EG(resolve_cache));
+   }
+};
+
+/// runs \p code and returns what it returned as a string
+std::string run_code(const char *code)
+{
+   zval source;
+   ZVAL_STRING(&source, code);
+   zend_op_array *opArray = zend_compile_string(&source, const_cast<char *>("resolve cache test"));
+   zval_ptr_dtor(&source);
+   EXPECT_NE(opArray, nullptr);
+   if (!opArray) {
+      return std::string();
+   }
+   zval result;
+   ZVAL_UNDEF(&result);
+   zend_execute(opArray, &result);
+   destroy_op_array(opArray);
+   efree(opArray);
+   zend_string *text = zval_get_string(&result);
+   std::string value(ZSTR_VAL(text), ZSTR_LEN(text));
+   zend_string_release(text);
+   zval_ptr_dtor(&result);
+   return value;
+}
+
+zend_function *find_function(const char *key)
+{
+   zend_string *name = zend_string_init(key, strlen(key), 0);
+   zend_function *func = zend_resolve_cache_find_function(name);
+   zend_string_release(name);
+   return func;
+}
+
+zend_constant *find_constant(const char *key)
+{
+   return zend_resolve_cache_find_constant(key, strlen(key));
+}
+
+} // anonymous namespace
+
+TEST_F(ResolveCacheTest, testFunctionHit)
+{
+   ASSERT_EQ(find_function("resolvecachefunc\\strlen"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheFunc; return strlen('abc');"), "3");
+   /// keyed by the lowercased namespaced name the compiler emits
+   zend_function *strlenFunc = static_cast<zend_function *>(
+            zend_hash_str_find_ptr(EG(function_table), "strlen", sizeof("strlen") - 1));
+   ASSERT_NE(strlenFunc, nullptr);
+   ASSERT_EQ(find_function("resolvecachefunc\\strlen"), strlenFunc);
+   /// user functions are never remembered
+   ASSERT_EQ(run_code("function resolve_cache_user() { return 'user'; }"), "");
+   ASSERT_EQ(run_code("namespace ResolveCacheUser; return resolve_cache_user();"), "user");
+   ASSERT_EQ(find_function("resolvecacheuser\\resolve_cache_user"), nullptr);
+   /// the next request still has it, and goes by it without a lookup: an
+   /// entry planted under another name is what the call ends up in
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_EQ(find_function("resolvecachefunc\\strlen"), strlenFunc);
+   zend_function *upperFunc = static_cast<zend_function *>(
+            zend_hash_str_find_ptr(EG(function_table), "strtoupper", sizeof("strtoupper") - 1));
+   zend_string *key = zend_string_init("resolvecacheplant\\strlen", sizeof("resolvecacheplant\\strlen") - 1, 0);
+   zend_resolve_cache_add_function(key, upperFunc);
+   zend_string_release(key);
+   ASSERT_EQ(run_code("namespace ResolveCachePlant; return strlen('abc');"), "ABC");
+}
+
+TEST_F(ResolveCacheTest, testConstantHit)
+{
+   ASSERT_EQ(run_code("namespace ResolveCacheConst; return E_ALL;"), std::to_string(E_ALL));
+   zend_constant *all = static_cast<zend_constant *>(
+            zend_hash_str_find_ptr(EG(zend_constants), "E_ALL", sizeof("E_ALL") - 1));
+   ASSERT_NE(all, nullptr);
+   /// the namespace is lowercased, the constant name is not
+   ASSERT_EQ(find_constant("resolvecacheconst\\E_ALL"), all);
+   ASSERT_EQ(find_constant("resolvecacheconst\\e_all"), nullptr);
+   /// request constants are never remembered
+   ASSERT_EQ(run_code("define('RESOLVE_CACHE_REQUEST', 5);"), "");
+   ASSERT_EQ(run_code("namespace ResolveCacheRequest; return RESOLVE_CACHE_REQUEST;"), "5");
+   ASSERT_EQ(find_constant("resolvecacherequest\\RESOLVE_CACHE_REQUEST"), nullptr);
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_EQ(find_constant("resolvecacheconst\\E_ALL"), all);
+   ASSERT_EQ(run_code("namespace ResolveCacheConst; return E_ALL;"), std::to_string(E_ALL));
+}
+
+TEST_F(ResolveCacheTest, testDeclaredFunctionIsForgotten)
+{
+   ASSERT_EQ(run_code("namespace ResolveCacheBind; return strlen('abc');"), "3");
+   ASSERT_NE(find_function("resolvecachebind\\strlen"), nullptr);
+   /// do_bind_function() drops the entry once the namespace has a strlen()
+   /// of its own, a call site compiled afterwards has to find that one
+   ASSERT_EQ(run_code("namespace ResolveCacheBind; function strlen($s) { return -1; }"), "");
+   ASSERT_EQ(find_function("resolvecachebind\\strlen"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheBind; return strlen('abc');"), "-1");
+   ASSERT_EQ(find_function("resolvecachebind\\strlen"), nullptr);
+   /// the other names stay
+   ASSERT_EQ(run_code("namespace ResolveCacheOther; return strlen('abc');"), "3");
+   ASSERT_NE(find_function("resolvecacheother\\strlen"), nullptr);
+}
+
+TEST_F(ResolveCacheTest, testRegisteredConstantIsForgotten)
+{
+   ASSERT_EQ(run_code("namespace ResolveCacheDefine; return E_ALL;"), std::to_string(E_ALL));
+   ASSERT_NE(find_constant("resolvecachedefine\\E_ALL"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheDeclare; return E_ALL;"), std::to_string(E_ALL));
+   ASSERT_NE(find_constant("resolvecachedeclare\\E_ALL"), nullptr);
+   /// zend_register_constant() drops the entry of the name it registers,
+   /// through define() and through a namespaced const statement
+   ASSERT_EQ(run_code("define('ResolveCacheDefine\\E_ALL', 7);"), "");
+   ASSERT_EQ(find_constant("resolvecachedefine\\E_ALL"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheDefine; return E_ALL;"), "7");
+   ASSERT_NE(find_constant("resolvecachedeclare\\E_ALL"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheDeclare; const E_ALL = 8;"), "");
+   ASSERT_EQ(find_constant("resolvecachedeclare\\E_ALL"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheDeclare; return E_ALL;"), "8");
+   /// a case-insensitive one may match the name in any case, everything goes
+   ASSERT_EQ(run_code("namespace ResolveCacheOther; return E_ALL;"), std::to_string(E_ALL));
+   ASSERT_NE(find_constant("resolvecacheother\\E_ALL"), nullptr);
+   ASSERT_EQ(run_code("@define('ResolveCacheInsensitive\\E_ALL', 9, true);"), "");
+   ASSERT_EQ(find_constant("resolvecacheother\\E_ALL"), nullptr);
+}
+
+TEST_F(ResolveCacheTest, testEpoch)
+{
+   ASSERT_EQ(run_code("namespace ResolveCacheEpoch; return strlen('abc') . E_ALL;"),
+             "3" + std::to_string(E_ALL));
+   ASSERT_NE(find_function("resolvecacheepoch\\strlen"), nullptr);
+   ASSERT_NE(find_constant("resolvecacheepoch\\E_ALL"), nullptr);
+   /// a persistent constant or internal function moving anywhere drops all
+   zend_resolve_cache_invalidate();
+   ASSERT_EQ(find_function("resolvecacheepoch\\strlen"), nullptr);
+   ASSERT_EQ(find_constant("resolvecacheepoch\\E_ALL"), nullptr);
+   ASSERT_EQ(run_code("namespace ResolveCacheEpoch; return strlen('abc');"), "3");
+   ASSERT_NE(find_function("resolvecacheepoch\\strlen"), nullptr);
+   /// turning the cache off empties it
+   zend_resolve_cache_enable(0);
+   ASSERT_EQ(find_function("resolvecacheepoch\\strlen"), nullptr);
+   zend_resolve_cache_enable(1);
+   ASSERT_EQ(find_function("resolvecacheepoch\\strlen"), nullptr);
+}
@@ -0,0 +1,205 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/ExecEnv.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <vector>
+
+using polar::runtime::retrieve_global_execenv;
+
+namespace {
+
+/// the resources point at a counter their destructor bumps
+void count_close(zend_resource *res)
+{
+   ++*static_cast<int *>(res->ptr);
+}
+
+int get_first_type()
+{
+   static int type = zend_register_list_destructors_ex(count_close, nullptr, "resource list test a", 0);
+   return type;
+}
+
+int get_second_type()
+{
+   static int type = zend_register_list_destructors_ex(count_close, nullptr, "resource list test b", 0);
+   return type;
+}
+
+/// the handles of what get_resources() returns for \p type, in its order
+std::vector<zend_long> get_resource_handles(const char *type)
+{
+   std::string code = std::string("get_resources('") + type + "')";
+   zval result;
+   EXPECT_EQ(zend_eval_string(const_cast<char *>(code.c_str()), &result,
+                              const_cast<char *>("resource list test")), SUCCESS);
+   std::vector<zend_long> handles;
+   EXPECT_EQ(Z_TYPE(result), IS_ARRAY);
+   zend_ulong index;
+   zval *value;
+   ZEND_HASH_FOREACH_NUM_KEY_VAL(Z_ARRVAL(result), index, value) {
+      EXPECT_EQ(Z_RES_HANDLE_P(value), static_cast<zend_long>(index));
+      handles.push_back(static_cast<zend_long>(index));
+   } ZEND_HASH_FOREACH_END();
+   zval_ptr_dtor(&result);
+   return handles;
+}
+
+} // anonymous namespace
+
+TEST(ResourceListTest, testRegisterAndClose)
+{
+   int closed = 0;
+   uint32_t live = zend_list_count();
+   zend_resource *first = zend_register_resource(&closed, get_first_type());
+   zend_resource *second = zend_register_resource(&closed, get_first_type());
+   ASSERT_EQ(zend_list_count(), live + 2);
+   ASSERT_EQ(second->handle, first->handle + 1);
+   ASSERT_EQ(zend_fetch_resource(first, "resource list test a", get_first_type()), &closed);
+   /// closing runs the destructor once, the slot lives on until the last
+   /// reference is gone
+   GC_ADDREF(first);
+   ASSERT_EQ(zend_list_close(first), SUCCESS);
+   ASSERT_EQ(closed, 1);
+   ASSERT_EQ(first->type, -1);
+   ASSERT_EQ(zend_list_count(), live + 2);
+   ASSERT_EQ(zend_list_delete(first), SUCCESS);
+   ASSERT_EQ(zend_list_count(), live + 2);
+   ASSERT_EQ(zend_list_delete(first), SUCCESS);
+   ASSERT_EQ(closed, 1);
+   ASSERT_EQ(zend_list_count(), live + 1);
+   ASSERT_EQ(zend_list_delete(second), SUCCESS);
+   ASSERT_EQ(closed, 2);
+   ASSERT_EQ(zend_list_count(), live);
+
+   /// closing a type leaves the others alone, the closed ones stay in the
+   /// list until their last reference goes
+   int otherClosed = 0;
+   zend_resource *kept = zend_register_resource(&otherClosed, get_second_type());
+   zend_resource *third = zend_register_resource(&closed, get_first_type());
+   zend_resource *fourth = zend_register_resource(&closed, get_first_type());
+   zend_list_close_type(get_first_type());
+   ASSERT_EQ(closed, 4);
+   ASSERT_EQ(otherClosed, 0);
+   ASSERT_EQ(third->type, -1);
+   ASSERT_EQ(fourth->type, -1);
+   ASSERT_EQ(kept->type, get_second_type());
+   ASSERT_EQ(zend_list_count(), live + 3);
+   ASSERT_EQ(zend_list_delete(third), SUCCESS);
+   ASSERT_EQ(zend_list_delete(fourth), SUCCESS);
+   ASSERT_EQ(zend_list_delete(kept), SUCCESS);
+   ASSERT_EQ(closed, 4);
+   ASSERT_EQ(otherClosed, 1);
+   ASSERT_EQ(zend_list_count(), live);
+}
+
+TEST(ResourceListTest, testStandaloneResource)
+{
+   /// ZVAL_NEW_RES() makes a resource outside of the list, freeing it must
+   /// not be taken for a slot
+   int closed = 0;
+   uint32_t live = zend_list_count();
+   zval value;
+   ZVAL_NEW_RES(&value, 1000, &closed, get_first_type());
+   ASSERT_EQ(zend_list_count(), live);
+   zval_ptr_dtor(&value);
+   ASSERT_EQ(closed, 1);
+   ASSERT_EQ(zend_list_count(), live);
+}
+
+TEST(ResourceListTest, testFreeListReuse)
+{
+   int closed = 0;
+   zend_resource *first = zend_register_resource(&closed, get_first_type());
+   zend_long firstHandle = first->handle;
+   ASSERT_EQ(zend_list_delete(first), SUCCESS);
+   /// the slot goes to the next resource of the same type only
+   zend_resource *other = zend_register_resource(&closed, get_second_type());
+   ASSERT_NE(other, first);
+   zend_resource *reused = zend_register_resource(&closed, get_first_type());
+   ASSERT_EQ(reused, first);
+   /// the ids seen by scripts keep counting up
+   ASSERT_GT(reused->handle, firstHandle);
+   ASSERT_EQ(reused->type, get_first_type());
+   ASSERT_EQ(zend_list_delete(reused), SUCCESS);
+   ASSERT_EQ(zend_list_delete(other), SUCCESS);
+   ASSERT_EQ(closed, 3);
+}
+
+TEST(ResourceListTest, testHandleGeneration)
+{
+   int closed = 0;
+   int other = 0;
+   zend_resource *res = zend_register_resource(&closed, get_first_type());
+   zend_resource_handle handle = zend_list_handle(res);
+   ASSERT_EQ(zend_list_handle_fetch(handle), &closed);
+   zend_resource_handle wrongType = handle;
+   wrongType.type = get_second_type();
+   ASSERT_EQ(zend_list_handle_fetch(wrongType), nullptr);
+   ASSERT_EQ(zend_list_delete(res), SUCCESS);
+   ASSERT_EQ(zend_list_handle_fetch(handle), nullptr);
+   /// the slot holds a new resource, the old handle still does not resolve
+   zend_resource *reused = zend_register_resource(&other, get_first_type());
+   ASSERT_EQ(reused, res);
+   ASSERT_EQ(zend_list_handle_fetch(handle), nullptr);
+   ASSERT_EQ(zend_list_handle_fetch(zend_list_handle(reused)), &other);
+   ASSERT_EQ(zend_list_delete(reused), SUCCESS);
+}
+
+TEST(ResourceListTest, testHandleEpoch)
+{
+   int closed = 0;
+   int other = 0;
+   zend_resource_handle handle = zend_list_handle(zend_register_resource(&closed, get_first_type()));
+   ASSERT_EQ(zend_list_handle_fetch(handle), &closed);
+   /// the request shutdown closes the resource
+   ASSERT_TRUE(retrieve_global_execenv().restartRequest());
+   ASSERT_EQ(closed, 1);
+   zend_resource *res = zend_register_resource(&other, get_first_type());
+   zend_resource_handle fresh = zend_list_handle(res);
+   ASSERT_EQ(zend_list_handle_fetch(handle), nullptr);
+   ASSERT_EQ(zend_list_handle_fetch(fresh), &other);
+   /// slot, generation and type of a live resource, only the epoch is
+   /// the one of the last request
+   zend_resource_handle stale = fresh;
+   stale.epoch = handle.epoch;
+   ASSERT_NE(stale.epoch, fresh.epoch);
+   ASSERT_EQ(zend_list_handle_fetch(stale), nullptr);
+   ASSERT_EQ(zend_list_delete(res), SUCCESS);
+}
+
+TEST(ResourceListTest, testGetResources)
+{
+   int closed = 0;
+   zend_resource *first = zend_register_resource(&closed, get_first_type());
+   zend_resource *other = zend_register_resource(&closed, get_second_type());
+   zend_resource *second = zend_register_resource(&closed, get_first_type());
+   ASSERT_EQ(get_resource_handles("resource list test a"),
+             std::vector<zend_long>({first->handle, second->handle}));
+   ASSERT_EQ(get_resource_handles("resource list test b"), std::vector<zend_long>({other->handle}));
+   /// a freed slot drops out, a reused one shows up with its new id
+   ASSERT_EQ(zend_list_delete(first), SUCCESS);
+   zend_resource *third = zend_register_resource(&closed, get_first_type());
+   ASSERT_EQ(get_resource_handles("resource list test a"),
+             std::vector<zend_long>({second->handle, third->handle}));
+   zval all;
+   ASSERT_EQ(zend_eval_string(const_cast<char *>("get_resources()"), &all,
+                              const_cast<char *>("resource list test")), SUCCESS);
+   ASSERT_EQ(zend_hash_num_elements(Z_ARRVAL(all)), zend_list_count());
+   zval_ptr_dtor(&all);
+   ASSERT_EQ(zend_list_delete(other), SUCCESS);
+   ASSERT_EQ(zend_list_delete(second), SUCCESS);
+   ASSERT_EQ(zend_list_delete(third), SUCCESS);
+   ASSERT_EQ(closed, 4);
+}
@@ -0,0 +1,92 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/Ticks.h"
+
+#include <vector>
+
+using polar::runtime::add_tick_function;
+using polar::runtime::remove_tick_function;
+using polar::runtime::run_ticks;
+using polar::runtime::deactivate_ticks;
+
+namespace {
+
+std::vector<int> sg_calls;
+
+void record_tick(int, void *arg)
+{
+   sg_calls.push_back(static_cast<int>(reinterpret_cast<intptr_t>(arg)));
+}
+
+void remove_self_tick(int count, void *arg)
+{
+   record_tick(count, arg);
+   remove_tick_function(remove_self_tick, arg);
+}
+
+void remove_first_tick(int count, void *arg)
+{
+   record_tick(count, arg);
+   remove_tick_function(record_tick, reinterpret_cast<void *>(1));
+}
+
+void *tag(intptr_t value)
+{
+   return reinterpret_cast<void *>(value);
+}
+
+} // anonymous namespace
+
+TEST(TicksTest, testRemoveSelf)
+{
+   sg_calls.clear();
+   add_tick_function(remove_self_tick, tag(1));
+   add_tick_function(record_tick, tag(2));
+   add_tick_function(record_tick, tag(3));
+   run_ticks(1);
+   ASSERT_EQ(sg_calls, std::vector<int>({1, 2, 3}));
+   sg_calls.clear();
+   run_ticks(2);
+   ASSERT_EQ(sg_calls, std::vector<int>({2, 3}));
+   deactivate_ticks();
+}
+
+TEST(TicksTest, testRemoveEarlierEntry)
+{
+   sg_calls.clear();
+   add_tick_function(record_tick, tag(1));
+   add_tick_function(remove_first_tick, tag(2));
+   add_tick_function(record_tick, tag(3));
+   run_ticks(1);
+   ASSERT_EQ(sg_calls, std::vector<int>({1, 2, 3}));
+   sg_calls.clear();
+   run_ticks(2);
+   ASSERT_EQ(sg_calls, std::vector<int>({2, 3}));
+   deactivate_ticks();
+}
+
+TEST(TicksTest, testInterval)
+{
+   sg_calls.clear();
+   add_tick_function(record_tick, tag(1));
+   add_tick_function(record_tick, tag(2), 3);
+   for (int i = 0; i < 6; ++i) {
+      run_ticks(i);
+   }
+   ASSERT_EQ(sg_calls, std::vector<int>({1, 1, 1, 2, 1, 1, 1, 2}));
+   remove_tick_function(record_tick, tag(2));
+   sg_calls.clear();
+   run_ticks(7);
+   ASSERT_EQ(sg_calls, std::vector<int>({1}));
+   deactivate_ticks();
+}
@@ -0,0 +1,72 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/VmInterrupt.h"
+#include "polarphp/runtime/internal/DepsZendVmHeaders.h"
+
+#include <thread>
+
+using polar::runtime::add_vm_signal_handler;
+using polar::runtime::remove_vm_signal_handler;
+using polar::runtime::dispatch_vm_signals;
+using polar::runtime::is_vm_signal_thread;
+
+namespace {
+
+void count_signal(int, void *arg)
+{
+   ++*static_cast<int *>(arg);
+}
+
+} // anonymous namespace
+
+TEST(VmInterruptTest, testDispatchOnOwnerThread)
+{
+   int count = 0;
+   ASSERT_TRUE(is_vm_signal_thread());
+   ASSERT_TRUE(add_vm_signal_handler(SIGUSR1, count_signal, &count));
+   EG(vm_interrupt) = 0;
+   std::raise(SIGUSR1);
+   ASSERT_TRUE(EG(vm_interrupt));
+   ASSERT_EQ(count, 0);
+   ASSERT_TRUE(dispatch_vm_signals());
+   ASSERT_EQ(count, 1);
+   ASSERT_FALSE(dispatch_vm_signals());
+   EG(vm_interrupt) = 0;
+   ASSERT_TRUE(remove_vm_signal_handler(SIGUSR1));
+}
+
+TEST(VmInterruptTest, testOtherThreadIsRefused)
+{
+   int count = 0;
+   ASSERT_TRUE(add_vm_signal_handler(SIGUSR1, count_signal, &count));
+   EG(vm_interrupt) = 0;
+   std::raise(SIGUSR1);
+   bool added = true;
+   bool removed = true;
+   bool dispatched = true;
+   std::thread worker([&]() {
+      added = add_vm_signal_handler(SIGUSR2, count_signal, &count);
+      removed = remove_vm_signal_handler(SIGUSR1);
+      dispatched = dispatch_vm_signals();
+   });
+   worker.join();
+   ASSERT_FALSE(added);
+   ASSERT_FALSE(removed);
+   ASSERT_FALSE(dispatched);
+   /// the pending signal is still there for the owner thread
+   ASSERT_EQ(count, 0);
+   ASSERT_TRUE(dispatch_vm_signals());
+   ASSERT_EQ(count, 1);
+   EG(vm_interrupt) = 0;
+   ASSERT_TRUE(remove_vm_signal_handler(SIGUSR1));
+}
@@ -0,0 +1,91 @@
+// This source file is part of the polarphp.org open source project
+//
+// Copyright (c) 2017 - 2018 polarphp software foundation
+// Copyright (c) 2017 - 2018 zzu_softboy <zzu_softboy@163.com>
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See https://polarphp.org/LICENSE.txt for license information
+// See https://polarphp.org/CONTRIBUTORS.txt for the list of polarphp project authors
+//
+// Created by polarboy on 2019/05/10.
+
+#include "gtest/gtest.h"
+#include "polarphp/runtime/ExecEnv.h"
+
+using polar::runtime::ExecEnv;
+using polar::runtime::ExecEnvInfo;
+using polar::runtime::retrieve_global_execenv;
+
+namespace {
+
+int eval_code(const char *code)
+{
+   return zend_eval_string(const_cast<char *>(code), nullptr,
+                           const_cast<char *>("worker mode test"));
+}
+
+bool has_function(const char *name)
+{
+   return zend_hash_str_find_ptr(EG(function_table), name, strlen(name)) != nullptr;
+}
+
+} // anonymous namespace
+
+TEST(WorkerModeTest, testTwoRequests)
+{
+   ExecEnv &execEnv = retrieve_global_execenv();
+   ExecEnvInfo &execEnvInfo = execEnv.getRuntimeInfo();
+   execEnv.setWorkerMode(true);
+   ASSERT_TRUE(execEnv.restartRequest());
+   size_t fastResets = execEnvInfo.fastResetRequests;
+
+   const char *code = "function worker_mode_func() { return 1; }\n"
+                      "$workerObject = new stdClass;\n"
+                      "$workerObject->data = [1, 2, 3];\n";
+   ASSERT_EQ(eval_code(code), SUCCESS);
+   ASSERT_TRUE(has_function("worker_mode_func"));
+   ASSERT_NE(zend_hash_str_find(&EG(symbol_table), "workerObject", strlen("workerObject")), nullptr);
+
+   ASSERT_TRUE(execEnv.restartRequest());
+   ASSERT_EQ(execEnvInfo.fastResetRequests, fastResets + 1);
+   ASSERT_FALSE(has_function("worker_mode_func"));
+   ASSERT_EQ(zend_hash_str_find(&EG(symbol_table), "workerObject", strlen("workerObject")), nullptr);
+   /// the second request starts clean, it may declare the same function
+   ASSERT_EQ(eval_code(code), SUCCESS);
+   ASSERT_TRUE(has_function("worker_mode_func"));
+
+   ASSERT_TRUE(execEnv.restartRequest());
+   ASSERT_EQ(execEnvInfo.fastResetRequests, fastResets + 2);
+   execEnv.setWorkerMode(false);
+   ASSERT_TRUE(execEnv.restartRequest());
+}
+
+TEST(WorkerModeTest, testPendingDestructorTakesFullTeardown)
+{
+   ExecEnv &execEnv = retrieve_global_execenv();
+   ExecEnvInfo &execEnvInfo = execEnv.getRuntimeInfo();
+   execEnv.setWorkerMode(true);
+   ASSERT_TRUE(execEnv.restartRequest());
+   size_t fastResets = execEnvInfo.fastResetRequests;
+   ASSERT_EQ(eval_code("class WorkerModeDtor { function __destruct() {} }\n"
+                       "$workerKeep = new WorkerModeDtor;\n"), SUCCESS);
+   ASSERT_TRUE(execEnv.restartRequest());
+   ASSERT_EQ(execEnvInfo.fastResetRequests, fastResets);
+   /// a request without live destructors resets fast again
+   ASSERT_TRUE(execEnv.restartRequest());
+   ASSERT_EQ(execEnvInfo.fastResetRequests, fastResets + 1);
+   execEnv.setWorkerMode(false);
+   ASSERT_TRUE(execEnv.restartRequest());
+}
+
+TEST(WorkerModeTest, testWithoutWorkerMode)
+{
+   ExecEnv &execEnv = retrieve_global_execenv();
+   ExecEnvInfo &execEnvInfo = execEnv.getRuntimeInfo();
+   ASSERT_FALSE(execEnv.isWorkerMode());
+   size_t fastResets = execEnvInfo.fastResetRequests;
+   ASSERT_EQ(eval_code("function worker_mode_plain() {}"), SUCCESS);
+   ASSERT_TRUE(execEnv.restartRequest());
+   ASSERT_EQ(execEnvInfo.fastResetRequests, fastResets);
+   ASSERT_FALSE(has_function("worker_mode_plain"));
+}